@@ -0,0 +1,327 @@
+
+// expose clock_gettime() and fdatasync()
+#ifndef _GNU_SOURCE
+    #define _GNU_SOURCE
+#endif
+
+#include <pthread.h>
+#include <unistd.h> // fdatasync()
+#include <time.h> // clock_gettime()
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "light_io/lio_files.h"
+#include "light_io/lio_paths.h"
+#include "light_io/lio_utils.h"
+#include "light_io/lio_appender.h"
+
+
+
+enum
+{
+    BENCH_MAX_THREADS = 256,
+    BENCH_MAX_RECORD_SIZE = 64 * 1024
+};
+
+
+
+/*-------------------------------------
+ * Each method appends "numRecords" records from one thread
+-------------------------------------*/
+typedef struct BenchContext
+{
+    const char* pPath;
+    unsigned numRecords;
+    size_t recordSize;
+    bool durable; // Every record must be on storage before the next
+
+    FILE* pShared;
+    pthread_mutex_t sharedLock;
+    LioAppender* pAppender;
+} BenchContext;
+
+
+
+typedef struct BenchMethod
+{
+    const char* pName;
+    bool (*setup)(BenchContext* const pCtx);
+    bool (*run)(BenchContext* const pCtx, const char* const pRecord);
+    bool (*teardown)(BenchContext* const pCtx);
+} BenchMethod;
+
+
+
+typedef struct BenchThread
+{
+    BenchContext* pCtx;
+    const BenchMethod* pMethod;
+    char* pRecord;
+    bool valid;
+} BenchThread;
+
+
+
+/*-----------------------------------------------------------------------------
+ * Wall-clock time in seconds
+-----------------------------------------------------------------------------*/
+static double bench_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Baseline: reopen the file with "ab" for every record
+-----------------------------------------------------------------------------*/
+static bool bench_run_reopen(BenchContext* const pCtx, const char* const pRecord)
+{
+    bool ret = true;
+
+    for (unsigned i = 0; ret && i < pCtx->numRecords; ++i)
+    {
+        FILE* const pFile = fopen(pCtx->pPath, "ab");
+
+        ret = pFile && fwrite(pRecord, 1, pCtx->recordSize, pFile) == pCtx->recordSize;
+        ret = ret && (!pCtx->durable || (fflush(pFile) == 0 && fdatasync(fileno(pFile)) == 0));
+        ret = pFile && fclose(pFile) == 0 && ret;
+    }
+
+    return ret;
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Baseline: one FILE* opened with "ab", shared by every thread
+-----------------------------------------------------------------------------*/
+static bool bench_setup_shared(BenchContext* const pCtx)
+{
+    pCtx->pShared = fopen(pCtx->pPath, "ab");
+    return pCtx->pShared != NULL;
+}
+
+
+
+static bool bench_run_shared(BenchContext* const pCtx, const char* const pRecord)
+{
+    bool ret = true;
+
+    for (unsigned i = 0; ret && i < pCtx->numRecords; ++i)
+    {
+        // stdio locks the stream for each call, the flush needs its own lock
+        if (!pCtx->durable)
+        {
+            ret = fwrite(pRecord, 1, pCtx->recordSize, pCtx->pShared) == pCtx->recordSize;
+            continue;
+        }
+
+        pthread_mutex_lock(&pCtx->sharedLock);
+        ret = fwrite(pRecord, 1, pCtx->recordSize, pCtx->pShared) == pCtx->recordSize
+            && fflush(pCtx->pShared) == 0
+            && fdatasync(fileno(pCtx->pShared)) == 0;
+        pthread_mutex_unlock(&pCtx->sharedLock);
+    }
+
+    return ret;
+}
+
+
+
+static bool bench_teardown_shared(BenchContext* const pCtx)
+{
+    const bool ret = fflush(pCtx->pShared) == 0 && fdatasync(fileno(pCtx->pShared)) == 0;
+    return fclose(pCtx->pShared) == 0 && ret;
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * lio_appender, with a group commit for durable records
+-----------------------------------------------------------------------------*/
+static bool bench_setup_appender(BenchContext* const pCtx)
+{
+    pCtx->pAppender = lio_appender_create(pCtx->pPath, LIO_APPENDER_DEFAULT_EXTENT_SIZE, 0, 0, LIO_APPENDER_DEFAULT);
+    return pCtx->pAppender != NULL;
+}
+
+
+
+static bool bench_run_appender(BenchContext* const pCtx, const char* const pRecord)
+{
+    bool ret = true;
+
+    for (unsigned i = 0; ret && i < pCtx->numRecords; ++i)
+    {
+        ret = lio_appender_append(pCtx->pAppender, pRecord, pCtx->recordSize) >= 0
+            && (!pCtx->durable || lio_appender_sync(pCtx->pAppender));
+    }
+
+    return ret;
+}
+
+
+
+static bool bench_teardown_appender(BenchContext* const pCtx)
+{
+    printf("    (%llu flushes)\n", (unsigned long long)lio_appender_num_syncs(pCtx->pAppender));
+    return lio_appender_destroy(pCtx->pAppender);
+}
+
+
+
+static const BenchMethod BENCH_METHODS[] = {
+    {"fopen(\"ab\") per record", NULL, &bench_run_reopen, NULL},
+    {"shared fopen(\"ab\")", &bench_setup_shared, &bench_run_shared, &bench_teardown_shared},
+    {"lio_appender", &bench_setup_appender, &bench_run_appender, &bench_teardown_appender}
+};
+
+
+
+/*-----------------------------------------------------------------------------
+ * Run one method on every thread
+-----------------------------------------------------------------------------*/
+static void* bench_thread(void* pData)
+{
+    BenchThread* const pThread = (BenchThread*)pData;
+    pThread->valid = pThread->pMethod->run(pThread->pCtx, pThread->pRecord);
+    return NULL;
+}
+
+
+
+static bool bench_measure(BenchContext* const pCtx, const BenchMethod* const pMethod, BenchThread* const pThreads, const unsigned numThreads)
+{
+    pthread_t threads[BENCH_MAX_THREADS];
+    unsigned numStarted = 0;
+    bool valid = true;
+
+    lio_path_remove(pCtx->pPath, false, false);
+
+    printf("  %-26s", pMethod->pName);
+    fflush(stdout);
+
+    if (pMethod->setup && !pMethod->setup(pCtx))
+    {
+        printf("unable to set up\n");
+        return false;
+    }
+
+    const double t0 = bench_seconds();
+
+    for (; numStarted < numThreads; ++numStarted)
+    {
+        pThreads[numStarted].pCtx = pCtx;
+        pThreads[numStarted].pMethod = pMethod;
+
+        if (pthread_create(threads+numStarted, NULL, &bench_thread, pThreads+numStarted) != 0)
+        {
+            valid = false;
+            break;
+        }
+    }
+
+    for (unsigned i = 0; i < numStarted; ++i)
+    {
+        pthread_join(threads[i], NULL);
+        valid = valid && pThreads[i].valid;
+    }
+
+    const double seconds = bench_seconds() - t0;
+    const double numRecords = (double)numThreads * (double)pCtx->numRecords;
+
+    printf("%12.0f records/s %10.2f MB/s\n", numRecords / seconds, numRecords * (double)pCtx->recordSize / (seconds * 1024.0 * 1024.0));
+
+    // Teardown flushes whatever is left, outside of the timed region
+    valid = (!pMethod->teardown || pMethod->teardown(pCtx)) && valid;
+
+    const uint64_t expected = (uint64_t)numThreads * pCtx->numRecords * pCtx->recordSize;
+    LioFile file;
+    LioFileStat info;
+
+    info.size = 0;
+    if (lio_file_open(&file, pCtx->pPath, LIO_FILE_OPEN_READ))
+    {
+        lio_file_stat(&file, &info);
+        lio_file_close(&file);
+    }
+
+    if (!valid || info.size != expected)
+    {
+        fprintf(stderr, "%s wrote %llu bytes rather than %llu.\n", pMethod->pName, (unsigned long long)info.size, (unsigned long long)expected);
+        return false;
+    }
+
+    return true;
+}
+
+
+
+int main(int argc, char* argv[])
+{
+    const unsigned numThreads = (argc > 1) ? (unsigned)strtoul(argv[1], NULL, 10) : 8u;
+    const unsigned numRecords = (argc > 2) ? (unsigned)strtoul(argv[2], NULL, 10) : 20000u;
+    const size_t recordSize = (argc > 3) ? (size_t)strtoul(argv[3], NULL, 10) : 128u;
+    char* pPath = lio_utils_str_fmt("%s%clio_appender_bench.log", (argc > 4) ? argv[4] : "/tmp", LIO_PATH_SEP);
+    BenchThread threads[BENCH_MAX_THREADS];
+    BenchContext ctx;
+    int ret = 0;
+
+    if (!numThreads || numThreads > BENCH_MAX_THREADS || !numRecords || !recordSize || recordSize > BENCH_MAX_RECORD_SIZE || !pPath)
+    {
+        fprintf(stderr, "Usage: %s [numThreads] [recordsPerThread] [recordSize] [parentDir]\n", argv[0]);
+        return 1;
+    }
+
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.pPath = pPath;
+    ctx.recordSize = recordSize;
+    pthread_mutex_init(&ctx.sharedLock, NULL);
+
+    for (unsigned i = 0; i < numThreads; ++i)
+    {
+        threads[i].pRecord = (char*)malloc(recordSize);
+        if (!threads[i].pRecord)
+        {
+            return 1;
+        }
+
+        memset(threads[i].pRecord, 'a' + (int)(i % 26u), recordSize);
+        threads[i].pRecord[recordSize-1] = '\n';
+    }
+
+    // Durable appends are far slower, so fewer are made
+    for (unsigned durable = 0; durable < 2 && !ret; ++durable)
+    {
+        ctx.durable = durable != 0;
+        ctx.numRecords = durable ? (numRecords + 99u) / 100u : numRecords;
+
+        printf("%s: %u threads x %u records of %zu bytes\n",
+            durable ? "Synced after every record" : "Buffered",
+            numThreads,
+            ctx.numRecords,
+            recordSize);
+
+        for (size_t i = 0; i < sizeof(BENCH_METHODS) / sizeof(BENCH_METHODS[0]) && !ret; ++i)
+        {
+            ret = bench_measure(&ctx, BENCH_METHODS + i, threads, numThreads) ? 0 : 1;
+        }
+    }
+
+    lio_path_remove(pPath, false, false);
+
+    for (unsigned i = 0; i < numThreads; ++i)
+    {
+        free(threads[i].pRecord);
+    }
+
+    pthread_mutex_destroy(&ctx.sharedLock);
+    lio_utils_str_destroy(pPath);
+
+    return ret;
+}
@@ -0,0 +1,130 @@
+
+// expose clock_gettime()
+#ifndef _GNU_SOURCE
+    #define _GNU_SOURCE
+#endif
+
+#include <time.h> // clock_gettime()
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "light_io/lio_utils.h"
+
+
+
+/*-----------------------------------------------------------------------------
+ * Wall-clock time in seconds
+-----------------------------------------------------------------------------*/
+static double bench_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Element-by-element swaps using the scalar helpers
+-----------------------------------------------------------------------------*/
+static void bench_scalar_u16(uint16_t* pData, const size_t count)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        pData[i] = lio_utils_btol_u16(pData[i]);
+    }
+}
+
+
+
+static void bench_scalar_u32(uint32_t* pData, const size_t count)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        pData[i] = lio_utils_btol_u32(pData[i]);
+    }
+}
+
+
+
+static void bench_scalar_u64(uint64_t* pData, const size_t count)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        pData[i] = lio_utils_btol_u64(pData[i]);
+    }
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Main
+-----------------------------------------------------------------------------*/
+int main(int argc, char* argv[])
+{
+    const size_t numMB = (argc > 1) ? (size_t)strtoul(argv[1], NULL, 10) : 256u;
+    const size_t numBytes = numMB * 1024u * 1024u;
+    const unsigned numRounds = 4u;
+    unsigned char* const pData = (unsigned char*)malloc(numBytes);
+
+    if (!numBytes || !pData)
+    {
+        fprintf(stderr, "Usage: %s [sizeMB]\n", argv[0]);
+        free(pData);
+        return -1;
+    }
+
+    for (size_t i = 0; i < numBytes; ++i)
+    {
+        pData[i] = (unsigned char)(i * 31u);
+    }
+
+    printf("%-8s %12s %12s %8s\n", "width", "scalar GB/s", "array GB/s", "speedup");
+
+    for (unsigned width = 2u; width <= 8u; width *= 2u)
+    {
+        const size_t count = numBytes / width;
+        double scalarTime = 0.0;
+        double arrayTime = 0.0;
+
+        // Each round swaps twice so the data ends where it started
+        for (unsigned round = 0; round < numRounds; ++round)
+        {
+            double start = bench_seconds();
+            switch (width)
+            {
+                case 2u: bench_scalar_u16((uint16_t*)pData, count); bench_scalar_u16((uint16_t*)pData, count); break;
+                case 4u: bench_scalar_u32((uint32_t*)pData, count); bench_scalar_u32((uint32_t*)pData, count); break;
+                default: bench_scalar_u64((uint64_t*)pData, count); bench_scalar_u64((uint64_t*)pData, count); break;
+            }
+            scalarTime += bench_seconds() - start;
+
+            start = bench_seconds();
+            switch (width)
+            {
+                case 2u: lio_utils_btol_u16_array((uint16_t*)pData, (uint16_t*)pData, count); lio_utils_btol_u16_array((uint16_t*)pData, (uint16_t*)pData, count); break;
+                case 4u: lio_utils_btol_u32_array((uint32_t*)pData, (uint32_t*)pData, count); lio_utils_btol_u32_array((uint32_t*)pData, (uint32_t*)pData, count); break;
+                default: lio_utils_btol_u64_array((uint64_t*)pData, (uint64_t*)pData, count); lio_utils_btol_u64_array((uint64_t*)pData, (uint64_t*)pData, count); break;
+            }
+            arrayTime += bench_seconds() - start;
+        }
+
+        const double totalGB = (double)numBytes * 2.0 * numRounds / 1e9;
+        printf("u%-7u %12.2f %12.2f %7.2fx\n", width*8u, totalGB/scalarTime, totalGB/arrayTime, scalarTime/arrayTime);
+    }
+
+    for (size_t i = 0; i < numBytes; ++i)
+    {
+        if (pData[i] != (unsigned char)(i * 31u))
+        {
+            fprintf(stderr, "Byte-swapped data did not round-trip at offset %zu.\n", i);
+            free(pData);
+            return -1;
+        }
+    }
+
+    free(pData);
+    return 0;
+}
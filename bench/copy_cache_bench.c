@@ -0,0 +1,199 @@
+
+// expose posix_fadvise() and mincore()
+#ifndef _GNU_SOURCE
+    #define _GNU_SOURCE
+#endif
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h> // mmap(), mincore()
+#include <sys/stat.h>
+#include <time.h> // clock_gettime()
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "light_io/lio_utils.h"
+#include "light_io/lio_paths.h"
+#include "light_io/lio_files.h"
+
+
+
+/*-----------------------------------------------------------------------------
+ * Percentage of a file's pages which are currently in the page cache
+-----------------------------------------------------------------------------*/
+static double bench_cache_residency(const char* const path)
+{
+    const int fd = open(path, O_RDONLY);
+    struct stat info;
+
+    if (fd < 0 || fstat(fd, &info) != 0 || info.st_size == 0)
+    {
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+        return 0.0;
+    }
+
+    const size_t pageSize = (size_t)sysconf(_SC_PAGESIZE);
+    const size_t numPages = ((size_t)info.st_size + pageSize - 1) / pageSize;
+    unsigned char* const pages = (unsigned char*)malloc(numPages);
+    void* const pMap = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    size_t numResident = 0;
+
+    if (pages && pMap != MAP_FAILED && mincore(pMap, (size_t)info.st_size, pages) == 0)
+    {
+        for (size_t i = 0; i < numPages; ++i)
+        {
+            numResident += pages[i] & 1u;
+        }
+    }
+
+    if (pMap != MAP_FAILED)
+    {
+        munmap(pMap, (size_t)info.st_size);
+    }
+
+    free(pages);
+    close(fd);
+
+    return 100.0 * (double)numResident / (double)numPages;
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Flush a file to disk and drop it from the page cache
+-----------------------------------------------------------------------------*/
+static void bench_drop_file(const char* const path)
+{
+    const int fd = open(path, O_RDONLY);
+    if (fd >= 0)
+    {
+        fdatasync(fd);
+        posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+        close(fd);
+    }
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Generate a source file of a specific size
+-----------------------------------------------------------------------------*/
+static int bench_make_file(const char* const path, const size_t numMegabytes)
+{
+    const size_t chunkSize = 1024*1024;
+    char* const chunk = (char*)malloc(chunkSize);
+    FILE* const pFile = fopen(path, "wb");
+    int ret = 0;
+
+    if (!chunk || !pFile)
+    {
+        ret = -1;
+    }
+    else
+    {
+        for (size_t i = 0; i < chunkSize; ++i)
+        {
+            chunk[i] = (char)(i * 2654435761u >> 24);
+        }
+
+        for (size_t i = 0; i < numMegabytes && ret == 0; ++i)
+        {
+            ret = (fwrite(chunk, 1, chunkSize, pFile) == chunkSize) ? 0 : -1;
+        }
+    }
+
+    if (pFile)
+    {
+        fclose(pFile);
+    }
+
+    free(chunk);
+    return ret;
+}
+
+
+
+static double bench_time_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1000.0 + (double)ts.tv_nsec / 1000000.0;
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Copy a cold file and report how much of the page cache it left behind
+-----------------------------------------------------------------------------*/
+static int bench_run_copy(const char* const from, const char* const to, const unsigned flags, const char* const name)
+{
+    bench_drop_file(from);
+    lio_path_remove(to, false, false);
+
+    const double srcBefore = bench_cache_residency(from);
+    const double startTime = bench_time_ms();
+
+    if (!lio_file_copy_ex(from, to, flags | LIO_FILE_COPY_OVERWRITE))
+    {
+        fprintf(stderr, "Failed to copy \"%s\" to \"%s\".\n", from, to);
+        return -1;
+    }
+
+    const double endTime = bench_time_ms();
+    const double srcAfter = bench_cache_residency(from);
+    const double dstAfter = bench_cache_residency(to);
+
+    printf(
+        "%-12s %10.2f ms    source %6.2f%% -> %6.2f%%    destination %6.2f%%\n",
+        name, endTime-startTime, srcBefore, srcAfter, dstAfter);
+
+    return 0;
+}
+
+
+
+int main(int argc, char* argv[])
+{
+    int ret = 0;
+    const size_t numMegabytes = (argc > 1) ? (size_t)strtoul(argv[1], NULL, 10) : 256u;
+    char* const pDir = (argc > 2) ? lio_path_copy(argv[2]) : lio_path_dirname(argv[0]);
+    char* const pSrc = lio_path_join(pDir, "copy_cache_bench.src");
+    char* const pDst = lio_path_join(pDir, "copy_cache_bench.dst");
+
+    if (!pSrc || !pDst || bench_make_file(pSrc, numMegabytes) != 0)
+    {
+        fprintf(stderr, "Unable to create a %zu MB file for benchmarking.\n", numMegabytes);
+        ret = -1;
+        goto end;
+    }
+
+    printf("Page cache residency after copying a cold %zu MB file:\n", numMegabytes);
+
+    if (bench_run_copy(pSrc, pDst, LIO_FILE_COPY_DEFAULT, "buffered") != 0
+    || bench_run_copy(pSrc, pDst, LIO_FILE_COPY_BACKGROUND, "background") != 0)
+    {
+        ret = -2;
+    }
+
+    end:
+    if (pSrc)
+    {
+        lio_path_remove(pSrc, false, false);
+    }
+
+    if (pDst)
+    {
+        lio_path_remove(pDst, false, false);
+    }
+
+    lio_path_destroy(pDst);
+    lio_path_destroy(pSrc);
+    lio_path_destroy(pDir);
+
+    return ret;
+}
@@ -0,0 +1,180 @@
+
+// expose clock_gettime()
+#ifndef _GNU_SOURCE
+    #define _GNU_SOURCE
+#endif
+
+#include <time.h> // clock_gettime()
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "light_io/lio_files.h"
+#include "light_io/lio_paths.h"
+#include "light_io/lio_utils.h"
+#include "light_io/lio_dircache.h"
+
+
+
+/*-----------------------------------------------------------------------------
+ * Wall-clock time in seconds
+-----------------------------------------------------------------------------*/
+static double bench_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Baseline: walk a tree with lio_path_list(), as a cold start would
+-----------------------------------------------------------------------------*/
+static unsigned bench_walk(const char* pDir)
+{
+    unsigned numPaths = 0;
+    char** ppPaths = lio_path_list(pDir, true, NULL, &numPaths);
+    unsigned total = numPaths;
+
+    for (unsigned i = 0; i < numPaths; ++i)
+    {
+        if (lio_path_does_exist(ppPaths[i], LIO_PATH_TYPE_FOLDER))
+        {
+            total += bench_walk(ppPaths[i]);
+        }
+    }
+
+    lio_paths_destroy(ppPaths, numPaths);
+    return total;
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * List every folder in a cache, starting from the root
+-----------------------------------------------------------------------------*/
+static unsigned bench_list(LioDirCache* pCache, char* pPath, size_t length, size_t capacity)
+{
+    LioDirListing listing;
+    unsigned total;
+
+    if (!lio_dircache_list(pCache, pPath, &listing))
+    {
+        return 0;
+    }
+
+    total = (unsigned)listing.numEntries;
+    for (size_t i = 0; i < listing.numEntries; ++i)
+    {
+        const size_t nameLength = listing.pEntries[i].nameLength;
+
+        if (listing.pEntries[i].type != LIO_PATH_TYPE_FOLDER || length + nameLength + 2 > capacity)
+        {
+            continue;
+        }
+
+        pPath[length] = LIO_PATH_SEP;
+        memcpy(pPath + length + 1, lio_dirlisting_name(&listing, i), nameLength + 1);
+        total += bench_list(pCache, pPath, length + 1 + nameLength, capacity);
+        pPath[length] = '\0';
+    }
+
+    return total;
+}
+
+
+
+int main(int argc, char* argv[])
+{
+    const unsigned numFolders = (argc > 1) ? (unsigned)strtoul(argv[1], NULL, 10) : 200u;
+    const unsigned filesPerFolder = (argc > 2) ? (unsigned)strtoul(argv[2], NULL, 10) : 500u;
+    char* pRoot = lio_utils_str_fmt("%s%clio_dircache_bench", (argc > 3) ? argv[3] : "/tmp", LIO_PATH_SEP);
+    char* pSnapshot = lio_utils_str_fmt("%s.bin", pRoot);
+    char path[4096];
+    LioDirCache cache;
+    double t0, walkTime, buildTime, saveTime, openTime, listTime;
+    unsigned numWalked, numListed;
+
+    if (!numFolders || !filesPerFolder || !pRoot || !pSnapshot)
+    {
+        fprintf(stderr, "Usage: %s [numFolders] [filesPerFolder] [parentDir]\n", argv[0]);
+        return 1;
+    }
+
+    printf("Creating %u folders of %u files in \"%s\"...\n", numFolders, filesPerFolder, pRoot);
+    lio_path_remove(pRoot, true, false);
+    for (unsigned i = 0; i < numFolders; ++i)
+    {
+        snprintf(path, sizeof(path), "%s%cgroup%u%cfolder%u", pRoot, LIO_PATH_SEP, i % 16u, LIO_PATH_SEP, i);
+        if (!lio_path_mkdirs(path))
+        {
+            fprintf(stderr, "Unable to create \"%s.\"\n", path);
+            return 1;
+        }
+
+        const size_t length = strlen(path);
+        for (unsigned j = 0; j < filesPerFolder; ++j)
+        {
+            LioFile file;
+            snprintf(path + length, sizeof(path) - length, "%casset_%u.dat", LIO_PATH_SEP, j);
+            if (lio_file_open(&file, path, LIO_FILE_OPEN_WRITE | LIO_FILE_OPEN_CREATE))
+            {
+                lio_file_close(&file);
+            }
+        }
+    }
+
+    // Let folder timestamps age past the racy window so the snapshot is trusted
+    {
+        const struct timespec delay = {0, 200000000};
+        nanosleep(&delay, NULL);
+    }
+
+    t0 = bench_seconds();
+    numWalked = bench_walk(pRoot);
+    walkTime = bench_seconds() - t0;
+
+    t0 = bench_seconds();
+    if (!lio_dircache_build(&cache, pRoot))
+    {
+        return 1;
+    }
+    buildTime = bench_seconds() - t0;
+
+    t0 = bench_seconds();
+    if (!lio_dircache_save(&cache, pSnapshot))
+    {
+        return 1;
+    }
+    saveTime = bench_seconds() - t0;
+    lio_dircache_close(&cache);
+
+    t0 = bench_seconds();
+    if (!lio_dircache_open(&cache, pSnapshot))
+    {
+        return 1;
+    }
+    openTime = bench_seconds() - t0;
+
+    t0 = bench_seconds();
+    snprintf(path, sizeof(path), "%s", pRoot);
+    numListed = bench_list(&cache, path, strlen(path), sizeof(path));
+    listTime = bench_seconds() - t0;
+    lio_dircache_close(&cache);
+
+    printf("%u paths walked, %u paths listed from the snapshot\n", numWalked, numListed);
+    printf("    lio_path_list() walk:  %10.3f ms\n", walkTime * 1e3);
+    printf("    dircache build:        %10.3f ms\n", buildTime * 1e3);
+    printf("    dircache save:         %10.3f ms\n", saveTime * 1e3);
+    printf("    snapshot open:         %10.3f ms\n", openTime * 1e3);
+    printf("    snapshot list (all):   %10.3f ms (one stat() per folder)\n", listTime * 1e3);
+
+    lio_path_remove(pRoot, true, false);
+    lio_path_remove(pSnapshot, false, false);
+    lio_utils_str_destroy(pSnapshot);
+    lio_utils_str_destroy(pRoot);
+
+    return 0;
+}
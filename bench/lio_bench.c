@@ -0,0 +1,1136 @@
+
+// expose clock_gettime(), sync(), and posix_fadvise()
+#ifndef _GNU_SOURCE
+    #define _GNU_SOURCE
+#endif
+
+#include <fcntl.h> // open(), posix_fadvise()
+#include <unistd.h> // write(), close(), sync()
+#include <sys/stat.h> // mkdir()
+#include <time.h> // clock_gettime(), time()
+
+#include <limits.h> // UINT_MAX
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "light_io/lio_arena.h"
+#include "light_io/lio_error.h"
+#include "light_io/lio_files.h"
+#include "light_io/lio_paths.h"
+#include "light_io/lio_strbuf.h"
+#include "light_io/lio_trace.h"
+#include "light_io/lio_utils.h"
+
+
+
+/*-----------------------------------------------------------------------------
+ * Benchmark parameters
+-----------------------------------------------------------------------------*/
+enum
+{
+    BENCH_JSON_VERSION = 1,
+    BENCH_WRITE_CHUNK_SIZE = 64 * 1024,
+    BENCH_MAX_OPS = 16
+};
+
+
+
+enum BenchSizeDist
+{
+    BENCH_SIZE_FIXED, // Every file is "minSize" bytes
+    BENCH_SIZE_UNIFORM, // Sizes are spread evenly between "minSize" and "maxSize"
+    BENCH_SIZE_LOG // Each power of two between the limits is equally likely, so most files are small
+};
+
+
+
+enum BenchCacheState
+{
+    BENCH_CACHE_WARM,
+    BENCH_CACHE_FADVISE, // File data was dropped, but folder metadata may still be cached
+    BENCH_CACHE_DROPPED // The page, dentry, and inode caches were all dropped
+};
+
+
+
+typedef struct BenchConfig
+{
+    unsigned fanout;
+    unsigned depth;
+    unsigned filesPerFolder;
+    enum BenchSizeDist sizeDist;
+    uint64_t minSize;
+    uint64_t maxSize;
+    unsigned warmup;
+    unsigned reps;
+    bool cold;
+    uint64_t seed;
+    const char* pOps;
+    const char* pJsonPath;
+    const char* pTracePath;
+    const char* pDir;
+} BenchConfig;
+
+
+
+typedef struct BenchTree
+{
+    LioArena arena; // Holds every path
+    char** ppFolders; // In pre-order, so parents come before their children
+    size_t numFolders;
+    size_t folderCapacity;
+    char** ppFiles;
+    size_t numFiles;
+    size_t fileCapacity;
+    uint64_t numBytes;
+} BenchTree;
+
+
+
+typedef struct BenchContext
+{
+    const BenchConfig* pConfig;
+    BenchTree tree;
+    LioStrBuf root;
+    LioStrBuf scratch;
+    LioStrBuf path;
+    char* pChunk;
+} BenchContext;
+
+
+
+/*-------------------------------------
+ * Each operation reports how many items it processed, or SIZE_MAX on failure
+-------------------------------------*/
+typedef struct BenchOp
+{
+    const char* pName;
+    const char* pUnit;
+    bool (*setup)(BenchContext* const pCtx);
+    size_t (*run)(BenchContext* const pCtx);
+    void (*teardown)(BenchContext* const pCtx);
+} BenchOp;
+
+
+
+typedef struct BenchResult
+{
+    const BenchOp* pOp;
+    size_t numItems;
+    enum BenchCacheState cache;
+    unsigned numSamples;
+    double min;
+    double p50;
+    double p90;
+    double p99;
+    double max;
+    double mean;
+} BenchResult;
+
+
+
+/*-----------------------------------------------------------------------------
+ * Utilities
+-----------------------------------------------------------------------------*/
+static double bench_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+
+
+static uint64_t bench_random(uint64_t* const pState)
+{
+    uint64_t x = *pState;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    *pState = x;
+    return x * 2685821657736338717ull;
+}
+
+
+
+static uint64_t bench_file_size(const BenchConfig* const pConfig, uint64_t* const pState)
+{
+    const uint64_t minSize = pConfig->minSize;
+    const uint64_t maxSize = LIO_UTILS_MAX(pConfig->minSize, pConfig->maxSize);
+
+    switch (pConfig->sizeDist)
+    {
+        case BENCH_SIZE_UNIFORM:
+            return minSize + bench_random(pState) % (maxSize - minSize + 1);
+
+        case BENCH_SIZE_LOG:
+        {
+            unsigned lowBit = 0;
+            unsigned highBit = 0;
+
+            while (lowBit < 63 && (2ull << lowBit) <= minSize)
+            {
+                ++lowBit;
+            }
+
+            while (highBit < 63 && (2ull << highBit) <= maxSize)
+            {
+                ++highBit;
+            }
+
+            const unsigned bit = lowBit + (unsigned)(bench_random(pState) % (highBit - lowBit + 1));
+            const uint64_t size = (1ull << bit) + bench_random(pState) % (1ull << bit);
+
+            return LIO_UTILS_MIN(LIO_UTILS_MAX(size, minSize), maxSize);
+        }
+
+        case BENCH_SIZE_FIXED:
+        default:
+            break;
+    }
+
+    return minSize;
+}
+
+
+
+static bool bench_push(char*** const pppItems, size_t* const pNumItems, size_t* const pCapacity, char* const pItem)
+{
+    if (!pItem)
+    {
+        return false;
+    }
+
+    if (*pNumItems == *pCapacity)
+    {
+        const size_t newCapacity = *pCapacity ? *pCapacity * 2 : 1024;
+        char** const ppNewItems = (char**)realloc(*pppItems, newCapacity * sizeof(char*));
+
+        if (!ppNewItems)
+        {
+            return false;
+        }
+
+        *pppItems = ppNewItems;
+        *pCapacity = newCapacity;
+    }
+
+    (*pppItems)[(*pNumItems)++] = pItem;
+    return true;
+}
+
+
+
+/*-------------------------------------
+ * Build the path of a tree item beneath the scratch folder
+-------------------------------------*/
+static const char* bench_mirror(BenchContext* const pCtx, const char* const pPath, const char* const pSuffix)
+{
+    lio_strbuf_truncate(&pCtx->path, 0);
+
+    if (!lio_strbuf_append_n(&pCtx->path, pCtx->scratch.pData, pCtx->scratch.length)
+    || !lio_strbuf_append(&pCtx->path, pPath + pCtx->root.length)
+    || !lio_strbuf_append(&pCtx->path, pSuffix))
+    {
+        return NULL;
+    }
+
+    return pCtx->path.pData;
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Synthetic trees
+-----------------------------------------------------------------------------*/
+static bool bench_write_file(BenchContext* const pCtx, const char* const pPath, uint64_t numBytes)
+{
+    const int fd = open(pPath, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    bool ret = fd >= 0;
+
+    while (ret && numBytes)
+    {
+        const size_t chunkSize = (size_t)LIO_UTILS_MIN(numBytes, (uint64_t)BENCH_WRITE_CHUNK_SIZE);
+        ret = write(fd, pCtx->pChunk, chunkSize) == (ssize_t)chunkSize;
+        numBytes -= chunkSize;
+    }
+
+    return (fd >= 0) && (close(fd) == 0) && ret;
+}
+
+
+
+/*-------------------------------------
+ * Create a folder and everything beneath it. Paths are only recorded in
+ * "pTree" if it is not NULL, so the same tree can be recreated untimed.
+-------------------------------------*/
+static bool bench_generate(
+    BenchContext* const pCtx,
+    LioStrBuf* const pPath,
+    const unsigned level,
+    uint64_t* const pState,
+    BenchTree* const pTree)
+{
+    const BenchConfig* const pConfig = pCtx->pConfig;
+    const size_t baseLength = pPath->length;
+
+    if (mkdir(pPath->pData, 0755) != 0)
+    {
+        fprintf(stderr, "Unable to create the folder \"%s\".\n", pPath->pData);
+        return false;
+    }
+
+    if (pTree && !bench_push(&pTree->ppFolders, &pTree->numFolders, &pTree->folderCapacity, lio_arena_str_copy(&pTree->arena, pPath->pData, pPath->length)))
+    {
+        return false;
+    }
+
+    for (unsigned i = 0; i < pConfig->filesPerFolder; ++i)
+    {
+        const uint64_t numBytes = bench_file_size(pConfig, pState);
+
+        lio_strbuf_truncate(pPath, baseLength);
+        if (!lio_strbuf_appendf(pPath, "%cf%u", LIO_PATH_SEP, i) || !bench_write_file(pCtx, pPath->pData, numBytes))
+        {
+            fprintf(stderr, "Unable to create the file \"%s\".\n", pPath->pData);
+            return false;
+        }
+
+        if (pTree)
+        {
+            if (!bench_push(&pTree->ppFiles, &pTree->numFiles, &pTree->fileCapacity, lio_arena_str_copy(&pTree->arena, pPath->pData, pPath->length)))
+            {
+                return false;
+            }
+
+            pTree->numBytes += numBytes;
+        }
+    }
+
+    for (unsigned i = 0; level < pConfig->depth && i < pConfig->fanout; ++i)
+    {
+        lio_strbuf_truncate(pPath, baseLength);
+        if (!lio_strbuf_appendf(pPath, "%cd%u", LIO_PATH_SEP, i) || !bench_generate(pCtx, pPath, level+1, pState, pTree))
+        {
+            return false;
+        }
+    }
+
+    lio_strbuf_truncate(pPath, baseLength);
+    return true;
+}
+
+
+
+static bool bench_generate_at(BenchContext* const pCtx, const LioStrBuf* const pRoot, BenchTree* const pTree)
+{
+    LioStrBuf path;
+    uint64_t state = pCtx->pConfig->seed | 1u;
+    bool ret;
+
+    lio_strbuf_init(&path);
+    ret = lio_strbuf_append_n(&path, pRoot->pData, pRoot->length) && bench_generate(pCtx, &path, 0, &state, pTree);
+    lio_strbuf_terminate(&path);
+
+    return ret;
+}
+
+
+
+static void bench_remove(const LioStrBuf* const pPath)
+{
+    if (lio_path_does_exist(pPath->pData, LIO_PATH_TYPE_ANY))
+    {
+        lio_path_remove(pPath->pData, true, false);
+    }
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Caches
+-----------------------------------------------------------------------------*/
+static enum BenchCacheState bench_drop_caches(BenchContext* const pCtx)
+{
+    sync();
+
+    const int fd = open("/proc/sys/vm/drop_caches", O_WRONLY | O_CLOEXEC);
+    if (fd >= 0)
+    {
+        const bool dropped = write(fd, "3\n", 2) == 2;
+        close(fd);
+
+        if (dropped)
+        {
+            return BENCH_CACHE_DROPPED;
+        }
+    }
+
+    // Without privileges only file contents can be evicted
+    for (size_t i = 0; i < pCtx->tree.numFiles; ++i)
+    {
+        const int fileFd = open(pCtx->tree.ppFiles[i], O_RDONLY | O_CLOEXEC);
+        if (fileFd >= 0)
+        {
+            posix_fadvise(fileFd, 0, 0, POSIX_FADV_DONTNEED);
+            close(fileFd);
+        }
+    }
+
+    return BENCH_CACHE_FADVISE;
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Operations
+-----------------------------------------------------------------------------*/
+static size_t bench_run_list(BenchContext* const pCtx)
+{
+    size_t numItems = 0;
+
+    for (size_t i = 0; i < pCtx->tree.numFolders; ++i)
+    {
+        unsigned numEntries = 0;
+        char** const ppEntries = lio_path_list(pCtx->tree.ppFolders[i], true, NULL, &numEntries);
+
+        if (!ppEntries)
+        {
+            return SIZE_MAX;
+        }
+
+        numItems += numEntries;
+        lio_paths_destroy(ppEntries, numEntries);
+    }
+
+    return numItems;
+}
+
+
+
+static size_t bench_run_count(BenchContext* const pCtx)
+{
+    size_t numItems = 0;
+
+    for (size_t i = 0; i < pCtx->tree.numFolders; ++i)
+    {
+        const unsigned numEntries = lio_path_count_entries(pCtx->tree.ppFolders[i], true, NULL);
+
+        if (numEntries == UINT_MAX)
+        {
+            return SIZE_MAX;
+        }
+
+        numItems += numEntries;
+    }
+
+    return numItems;
+}
+
+
+
+static size_t bench_run_exists(BenchContext* const pCtx)
+{
+    for (size_t i = 0; i < pCtx->tree.numFolders; ++i)
+    {
+        if (!lio_path_does_exist(pCtx->tree.ppFolders[i], LIO_PATH_TYPE_FOLDER))
+        {
+            return SIZE_MAX;
+        }
+    }
+
+    for (size_t i = 0; i < pCtx->tree.numFiles; ++i)
+    {
+        if (!lio_path_does_exist(pCtx->tree.ppFiles[i], LIO_PATH_TYPE_FILE))
+        {
+            return SIZE_MAX;
+        }
+    }
+
+    return pCtx->tree.numFolders + pCtx->tree.numFiles;
+}
+
+
+
+static size_t bench_run_resolve(BenchContext* const pCtx)
+{
+    for (size_t i = 0; i < pCtx->tree.numFolders; ++i)
+    {
+        char* const pResolved = lio_path_resolve(pCtx->tree.ppFolders[i]);
+
+        if (!pResolved)
+        {
+            return SIZE_MAX;
+        }
+
+        lio_path_destroy(pResolved);
+    }
+
+    return pCtx->tree.numFolders;
+}
+
+
+
+static bool bench_setup_mkdirs(BenchContext* const pCtx)
+{
+    bench_remove(&pCtx->scratch);
+    return true;
+}
+
+
+
+static size_t bench_run_mkdirs(BenchContext* const pCtx)
+{
+    for (size_t i = 0; i < pCtx->tree.numFolders; ++i)
+    {
+        const char* const pMirror = bench_mirror(pCtx, pCtx->tree.ppFolders[i], "");
+
+        if (!pMirror || !lio_path_mkdirs(pMirror))
+        {
+            return SIZE_MAX;
+        }
+    }
+
+    return pCtx->tree.numFolders;
+}
+
+
+
+static void bench_teardown_scratch(BenchContext* const pCtx)
+{
+    bench_remove(&pCtx->scratch);
+}
+
+
+
+static bool bench_setup_copy(BenchContext* const pCtx)
+{
+    bench_remove(&pCtx->scratch);
+
+    for (size_t i = 0; i < pCtx->tree.numFolders; ++i)
+    {
+        const char* const pMirror = bench_mirror(pCtx, pCtx->tree.ppFolders[i], "");
+
+        if (!pMirror || mkdir(pMirror, 0755) != 0)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+
+static size_t bench_run_copy(BenchContext* const pCtx)
+{
+    for (size_t i = 0; i < pCtx->tree.numFiles; ++i)
+    {
+        const char* const pMirror = bench_mirror(pCtx, pCtx->tree.ppFiles[i], "");
+
+        if (!pMirror || !lio_file_copy(pCtx->tree.ppFiles[i], pMirror, false))
+        {
+            return SIZE_MAX;
+        }
+    }
+
+    return pCtx->tree.numFiles;
+}
+
+
+
+static size_t bench_run_move(BenchContext* const pCtx)
+{
+    for (size_t i = 0; i < pCtx->tree.numFiles; ++i)
+    {
+        const char* const pFile = pCtx->tree.ppFiles[i];
+
+        lio_strbuf_truncate(&pCtx->path, 0);
+        if (!lio_strbuf_append(&pCtx->path, pFile)
+        || !lio_strbuf_append(&pCtx->path, ".moved")
+        || lio_path_move(pFile, pCtx->path.pData, false) != 0)
+        {
+            return SIZE_MAX;
+        }
+    }
+
+    return pCtx->tree.numFiles;
+}
+
+
+
+static void bench_teardown_move(BenchContext* const pCtx)
+{
+    for (size_t i = 0; i < pCtx->tree.numFiles; ++i)
+    {
+        const char* const pFile = pCtx->tree.ppFiles[i];
+
+        lio_strbuf_truncate(&pCtx->path, 0);
+        if (lio_strbuf_append(&pCtx->path, pFile)
+        && lio_strbuf_append(&pCtx->path, ".moved")
+        && lio_path_does_exist(pCtx->path.pData, LIO_PATH_TYPE_FILE))
+        {
+            lio_path_move(pCtx->path.pData, pFile, false);
+        }
+    }
+}
+
+
+
+static bool bench_setup_remove(BenchContext* const pCtx)
+{
+    bench_remove(&pCtx->scratch);
+    return bench_generate_at(pCtx, &pCtx->scratch, NULL);
+}
+
+
+
+static size_t bench_run_remove(BenchContext* const pCtx)
+{
+    if (!lio_path_remove(pCtx->scratch.pData, true, false))
+    {
+        return SIZE_MAX;
+    }
+
+    return pCtx->tree.numFolders + pCtx->tree.numFiles;
+}
+
+
+
+static const BenchOp BENCH_OPS[] = {
+    {"list",    "entries", NULL,                &bench_run_list,    NULL},
+    {"count",   "entries", NULL,                &bench_run_count,   NULL},
+    {"exists",  "paths",   NULL,                &bench_run_exists,  NULL},
+    {"resolve", "folders", NULL,                &bench_run_resolve, NULL},
+    {"mkdirs",  "folders", &bench_setup_mkdirs, &bench_run_mkdirs,  &bench_teardown_scratch},
+    {"copy",    "files",   &bench_setup_copy,   &bench_run_copy,    &bench_teardown_scratch},
+    {"move",    "files",   NULL,                &bench_run_move,    &bench_teardown_move},
+    {"remove",  "paths",   &bench_setup_remove, &bench_run_remove,  &bench_teardown_scratch}
+};
+
+
+
+/*-----------------------------------------------------------------------------
+ * Measurement
+-----------------------------------------------------------------------------*/
+static int bench_compare_doubles(const void* pA, const void* pB)
+{
+    const double a = *(const double*)pA;
+    const double b = *(const double*)pB;
+    return (a > b) - (a < b);
+}
+
+
+
+static double bench_percentile(const double* const pSorted, const unsigned numSamples, const unsigned percent)
+{
+    // Nearest-rank, so every reported value was actually measured
+    unsigned rank = (percent * numSamples + 99) / 100;
+    rank = LIO_UTILS_MAX(rank, 1u);
+    return pSorted[rank-1];
+}
+
+
+
+static bool bench_measure(BenchContext* const pCtx, const BenchOp* const pOp, double* const pSamples, BenchResult* const pOutResult)
+{
+    const BenchConfig* const pConfig = pCtx->pConfig;
+    const unsigned numRuns = pConfig->warmup + pConfig->reps;
+    double total = 0.0;
+
+    memset(pOutResult, 0, sizeof(BenchResult));
+    pOutResult->pOp = pOp;
+    pOutResult->numSamples = pConfig->reps;
+    pOutResult->cache = BENCH_CACHE_WARM;
+
+    for (unsigned i = 0; i < numRuns; ++i)
+    {
+        if (pOp->setup && !pOp->setup(pCtx))
+        {
+            fprintf(stderr, "Unable to prepare the \"%s\" benchmark.\n", pOp->pName);
+            lio_error_print(lio_error_last(), stderr);
+            return false;
+        }
+
+        if (pConfig->cold)
+        {
+            pOutResult->cache = bench_drop_caches(pCtx);
+        }
+
+        const double startTime = bench_seconds();
+        const size_t numItems = pOp->run(pCtx);
+        const double endTime = bench_seconds();
+
+        if (pOp->teardown)
+        {
+            pOp->teardown(pCtx);
+        }
+
+        if (numItems == SIZE_MAX)
+        {
+            fprintf(stderr, "The \"%s\" benchmark failed.\n", pOp->pName);
+            lio_error_print(lio_error_last(), stderr);
+            return false;
+        }
+
+        if (i >= pConfig->warmup)
+        {
+            pSamples[i - pConfig->warmup] = endTime - startTime;
+            total += endTime - startTime;
+            pOutResult->numItems = numItems;
+        }
+    }
+
+    qsort(pSamples, pConfig->reps, sizeof(double), &bench_compare_doubles);
+    pOutResult->min = pSamples[0];
+    pOutResult->p50 = bench_percentile(pSamples, pConfig->reps, 50);
+    pOutResult->p90 = bench_percentile(pSamples, pConfig->reps, 90);
+    pOutResult->p99 = bench_percentile(pSamples, pConfig->reps, 99);
+    pOutResult->max = pSamples[pConfig->reps-1];
+    pOutResult->mean = total / (double)pConfig->reps;
+
+    return true;
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Reporting
+-----------------------------------------------------------------------------*/
+static const char* bench_cache_name(const enum BenchCacheState cache)
+{
+    switch (cache)
+    {
+        case BENCH_CACHE_DROPPED: return "dropped";
+        case BENCH_CACHE_FADVISE: return "fadvise";
+        case BENCH_CACHE_WARM:
+        default:
+            break;
+    }
+
+    return "warm";
+}
+
+
+
+static const char* bench_size_dist_name(const enum BenchSizeDist sizeDist)
+{
+    switch (sizeDist)
+    {
+        case BENCH_SIZE_UNIFORM: return "uniform";
+        case BENCH_SIZE_LOG:     return "log";
+        case BENCH_SIZE_FIXED:
+        default:
+            break;
+    }
+
+    return "fixed";
+}
+
+
+
+static void bench_print_table(FILE* const pOut, const BenchResult* const pResults, const unsigned numResults)
+{
+    fprintf(pOut, "%-8s %10s %8s %10s %10s %10s %10s %10s %14s\n",
+        "op", "items", "cache", "min ms", "p50 ms", "p90 ms", "p99 ms", "max ms", "items/s");
+
+    for (unsigned i = 0; i < numResults; ++i)
+    {
+        const BenchResult* const pResult = pResults + i;
+
+        fprintf(pOut, "%-8s %10zu %8s %10.3f %10.3f %10.3f %10.3f %10.3f %14.0f\n",
+            pResult->pOp->pName,
+            pResult->numItems,
+            bench_cache_name(pResult->cache),
+            pResult->min * 1e3,
+            pResult->p50 * 1e3,
+            pResult->p90 * 1e3,
+            pResult->p99 * 1e3,
+            pResult->max * 1e3,
+            pResult->p50 > 0.0 ? (double)pResult->numItems / pResult->p50 : 0.0);
+    }
+}
+
+
+
+static void bench_print_json_string(FILE* const pOut, const char* pStr)
+{
+    fputc('"', pOut);
+
+    for (; *pStr; ++pStr)
+    {
+        const unsigned char c = (unsigned char)*pStr;
+
+        if (c == '"' || c == '\\')
+        {
+            fprintf(pOut, "\\%c", c);
+        }
+        else if (c < 0x20)
+        {
+            fprintf(pOut, "\\u%04x", c);
+        }
+        else
+        {
+            fputc(c, pOut);
+        }
+    }
+
+    fputc('"', pOut);
+}
+
+
+
+static void bench_print_json(FILE* const pOut, const BenchContext* const pCtx, const BenchResult* const pResults, const unsigned numResults)
+{
+    const BenchConfig* const pConfig = pCtx->pConfig;
+
+    fprintf(pOut, "{\n  \"version\": %d,\n  \"timestamp\": %lld,\n  \"root\": ", BENCH_JSON_VERSION, (long long)time(NULL));
+    bench_print_json_string(pOut, pCtx->root.pData);
+
+    fprintf(pOut, ",\n  \"config\": {\"fanout\": %u, \"depth\": %u, \"files_per_folder\": %u, \"size_dist\": \"%s\", \"min_size\": %llu, \"max_size\": %llu, \"warmup\": %u, \"reps\": %u, \"cold\": %s, \"seed\": %llu},\n",
+        pConfig->fanout, pConfig->depth, pConfig->filesPerFolder,
+        bench_size_dist_name(pConfig->sizeDist),
+        (unsigned long long)pConfig->minSize, (unsigned long long)pConfig->maxSize,
+        pConfig->warmup, pConfig->reps,
+        pConfig->cold ? "true" : "false",
+        (unsigned long long)pConfig->seed);
+
+    fprintf(pOut, "  \"tree\": {\"folders\": %zu, \"files\": %zu, \"bytes\": %llu},\n  \"results\": [",
+        pCtx->tree.numFolders, pCtx->tree.numFiles, (unsigned long long)pCtx->tree.numBytes);
+
+    for (unsigned i = 0; i < numResults; ++i)
+    {
+        const BenchResult* const pResult = pResults + i;
+
+        fprintf(pOut, "%s\n    {\"op\": \"%s\", \"unit\": \"%s\", \"items\": %zu, \"cache\": \"%s\", \"samples\": %u, "
+            "\"seconds\": {\"min\": %.9f, \"p50\": %.9f, \"p90\": %.9f, \"p99\": %.9f, \"max\": %.9f, \"mean\": %.9f}, "
+            "\"items_per_second\": %.3f}",
+            i ? "," : "",
+            pResult->pOp->pName,
+            pResult->pOp->pUnit,
+            pResult->numItems,
+            bench_cache_name(pResult->cache),
+            pResult->numSamples,
+            pResult->min, pResult->p50, pResult->p90, pResult->p99, pResult->max, pResult->mean,
+            pResult->p50 > 0.0 ? (double)pResult->numItems / pResult->p50 : 0.0);
+    }
+
+    fprintf(pOut, "\n  ]\n}\n");
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Command line
+-----------------------------------------------------------------------------*/
+static void bench_usage(const char* const pExe)
+{
+    fprintf(stderr,
+        "Usage: %s [options]\n"
+        "  --dir PATH        Folder to build the synthetic tree in (default: next to this program)\n"
+        "  --fanout N        Subfolders in each folder (default: 4)\n"
+        "  --depth N         Levels of subfolders beneath the root (default: 3)\n"
+        "  --files N         Files in each folder (default: 16)\n"
+        "  --size-dist NAME  fixed, uniform, or log (default: fixed)\n"
+        "  --min-size N      Smallest file, in bytes (default: 4096)\n"
+        "  --max-size N      Largest file, in bytes (default: 1048576)\n"
+        "  --warmup N        Untimed runs of each operation (default: 1)\n"
+        "  --reps N          Timed runs of each operation (default: 5)\n"
+        "  --cold            Drop caches before each run, or evict file data if not permitted\n"
+        "  --seed N          Seed for file sizes (default: 1)\n"
+        "  --ops A,B,...     Operations to run (default: all)\n"
+        "  --json PATH       Write results as JSON, or to stdout if PATH is \"-\"\n"
+        "  --trace PATH      Write a Chrome trace of the timed runs, for Perfetto\n",
+        pExe);
+
+    fprintf(stderr, "Operations:");
+    for (size_t i = 0; i < LIO_UTILS_ARRAY_LENGTH(BENCH_OPS); ++i)
+    {
+        fprintf(stderr, " %s", BENCH_OPS[i].pName);
+    }
+    fprintf(stderr, "\n");
+}
+
+
+
+static bool bench_parse_args(const int argc, char* argv[], BenchConfig* const pConfig)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        const char* const pArg = argv[i];
+        const char* const pValue = (i+1 < argc) ? argv[i+1] : NULL;
+
+        if (strcmp(pArg, "--cold") == 0)
+        {
+            pConfig->cold = true;
+            continue;
+        }
+
+        if (!pValue)
+        {
+            return false;
+        }
+        ++i;
+
+        if (strcmp(pArg, "--dir") == 0)
+        {
+            pConfig->pDir = pValue;
+        }
+        else if (strcmp(pArg, "--fanout") == 0)
+        {
+            pConfig->fanout = (unsigned)strtoul(pValue, NULL, 10);
+        }
+        else if (strcmp(pArg, "--depth") == 0)
+        {
+            pConfig->depth = (unsigned)strtoul(pValue, NULL, 10);
+        }
+        else if (strcmp(pArg, "--files") == 0)
+        {
+            pConfig->filesPerFolder = (unsigned)strtoul(pValue, NULL, 10);
+        }
+        else if (strcmp(pArg, "--size-dist") == 0)
+        {
+            if (strcmp(pValue, "fixed") == 0)
+            {
+                pConfig->sizeDist = BENCH_SIZE_FIXED;
+            }
+            else if (strcmp(pValue, "uniform") == 0)
+            {
+                pConfig->sizeDist = BENCH_SIZE_UNIFORM;
+            }
+            else if (strcmp(pValue, "log") == 0)
+            {
+                pConfig->sizeDist = BENCH_SIZE_LOG;
+            }
+            else
+            {
+                return false;
+            }
+        }
+        else if (strcmp(pArg, "--min-size") == 0)
+        {
+            pConfig->minSize = strtoull(pValue, NULL, 10);
+        }
+        else if (strcmp(pArg, "--max-size") == 0)
+        {
+            pConfig->maxSize = strtoull(pValue, NULL, 10);
+        }
+        else if (strcmp(pArg, "--warmup") == 0)
+        {
+            pConfig->warmup = (unsigned)strtoul(pValue, NULL, 10);
+        }
+        else if (strcmp(pArg, "--reps") == 0)
+        {
+            pConfig->reps = (unsigned)strtoul(pValue, NULL, 10);
+        }
+        else if (strcmp(pArg, "--seed") == 0)
+        {
+            pConfig->seed = strtoull(pValue, NULL, 10);
+        }
+        else if (strcmp(pArg, "--ops") == 0)
+        {
+            pConfig->pOps = pValue;
+        }
+        else if (strcmp(pArg, "--json") == 0)
+        {
+            pConfig->pJsonPath = pValue;
+        }
+        else if (strcmp(pArg, "--trace") == 0)
+        {
+            pConfig->pTracePath = pValue;
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    return pConfig->reps > 0;
+}
+
+
+
+/*-------------------------------------
+ * Determine if an operation was named in a comma-separated list
+-------------------------------------*/
+static bool bench_is_selected(const char* pOps, const char* const pName)
+{
+    const size_t nameLength = strlen(pName);
+
+    if (!pOps)
+    {
+        return true;
+    }
+
+    while (*pOps)
+    {
+        const char* const pEnd = strchr(pOps, ',');
+        const size_t length = pEnd ? (size_t)(pEnd - pOps) : strlen(pOps);
+
+        if (length == nameLength && strncmp(pOps, pName, length) == 0)
+        {
+            return true;
+        }
+
+        pOps += length + (pEnd ? 1 : 0);
+    }
+
+    return false;
+}
+
+
+
+int main(int argc, char* argv[])
+{
+    int ret = 0;
+    BenchConfig config;
+    BenchContext ctx;
+    BenchResult results[BENCH_MAX_OPS];
+    unsigned numResults = 0;
+    double* pSamples = NULL;
+    char* pDir = NULL;
+
+    memset(&config, 0, sizeof(config));
+    config.fanout = 4;
+    config.depth = 3;
+    config.filesPerFolder = 16;
+    config.sizeDist = BENCH_SIZE_FIXED;
+    config.minSize = 4096;
+    config.maxSize = 1024 * 1024;
+    config.warmup = 1;
+    config.reps = 5;
+    config.seed = 1;
+
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.pConfig = &config;
+    lio_arena_init(&ctx.tree.arena, 0);
+    lio_strbuf_init(&ctx.root);
+    lio_strbuf_init(&ctx.scratch);
+    lio_strbuf_init(&ctx.path);
+
+    if (!bench_parse_args(argc, argv, &config))
+    {
+        bench_usage(argv[0]);
+        ret = -1;
+        goto end;
+    }
+
+    pDir = lio_path_resolve(config.pDir ? config.pDir : ".");
+    pSamples = (double*)malloc(sizeof(double) * config.reps);
+    ctx.pChunk = (char*)malloc(BENCH_WRITE_CHUNK_SIZE);
+
+    if (!pDir || !pSamples || !ctx.pChunk
+    || !lio_strbuf_appendf(&ctx.root, "%s%clio_bench_tree", pDir, LIO_PATH_SEP)
+    || !lio_strbuf_appendf(&ctx.scratch, "%s%clio_bench_scratch", pDir, LIO_PATH_SEP))
+    {
+        fprintf(stderr, "Unable to allocate the benchmark.\n");
+        ret = -2;
+        goto end;
+    }
+
+    for (size_t i = 0; i < BENCH_WRITE_CHUNK_SIZE; ++i)
+    {
+        ctx.pChunk[i] = (char)(i * 2654435761u >> 24);
+    }
+
+    bench_remove(&ctx.root);
+    bench_remove(&ctx.scratch);
+
+    {
+        const double startTime = bench_seconds();
+
+        if (!bench_generate_at(&ctx, &ctx.root, &ctx.tree))
+        {
+            fprintf(stderr, "Unable to generate a synthetic tree in \"%s\".\n", ctx.root.pData);
+            ret = -3;
+            goto end;
+        }
+
+        fprintf(stderr, "Generated %zu folders and %zu files (%llu bytes) in %.3f seconds.\n",
+            ctx.tree.numFolders,
+            ctx.tree.numFiles,
+            (unsigned long long)ctx.tree.numBytes,
+            bench_seconds() - startTime);
+    }
+
+    if (config.pTracePath && !lio_trace_start(0))
+    {
+        fprintf(stderr, "Tracing was compiled out of light_io, no trace will be written.\n");
+        config.pTracePath = NULL;
+    }
+
+    for (size_t i = 0; i < LIO_UTILS_ARRAY_LENGTH(BENCH_OPS) && numResults < BENCH_MAX_OPS; ++i)
+    {
+        if (!bench_is_selected(config.pOps, BENCH_OPS[i].pName))
+        {
+            continue;
+        }
+
+        if (!bench_measure(&ctx, BENCH_OPS + i, pSamples, results + numResults))
+        {
+            ret = -4;
+            goto end;
+        }
+
+        ++numResults;
+    }
+
+    if (config.pTracePath)
+    {
+        lio_trace_stop();
+        if (lio_trace_write(config.pTracePath) < 0)
+        {
+            fprintf(stderr, "Unable to write a trace to \"%s\".\n", config.pTracePath);
+        }
+    }
+
+    if (config.cold && numResults && results[0].cache != BENCH_CACHE_DROPPED)
+    {
+        fprintf(stderr, "Dropping caches is not permitted, only file data was evicted.\n");
+    }
+
+    if (!config.pJsonPath || strcmp(config.pJsonPath, "-") != 0)
+    {
+        bench_print_table(stdout, results, numResults);
+    }
+
+    if (config.pJsonPath)
+    {
+        FILE* const pJson = (strcmp(config.pJsonPath, "-") == 0) ? stdout : fopen(config.pJsonPath, "w");
+
+        if (!pJson)
+        {
+            fprintf(stderr, "Unable to write results to \"%s\".\n", config.pJsonPath);
+            ret = -5;
+            goto end;
+        }
+
+        bench_print_json(pJson, &ctx, results, numResults);
+
+        if (pJson != stdout)
+        {
+            fclose(pJson);
+        }
+    }
+
+    end:
+    if (ctx.root.length)
+    {
+        bench_remove(&ctx.root);
+        bench_remove(&ctx.scratch);
+    }
+
+    free(ctx.tree.ppFiles);
+    free(ctx.tree.ppFolders);
+    lio_arena_terminate(&ctx.tree.arena);
+    lio_strbuf_terminate(&ctx.path);
+    lio_strbuf_terminate(&ctx.scratch);
+    lio_strbuf_terminate(&ctx.root);
+    free(ctx.pChunk);
+    free(pSamples);
+    lio_path_destroy(pDir);
+
+    return ret;
+}
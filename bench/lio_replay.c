@@ -0,0 +1,1218 @@
+
+// expose clock_gettime() and clock_nanosleep()
+#ifndef _GNU_SOURCE
+    #define _GNU_SOURCE
+#endif
+
+#include <pthread.h>
+#include <time.h> // clock_gettime(), clock_nanosleep()
+
+#include <limits.h> // UINT_MAX
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "light_io/lio_arena.h"
+#include "light_io/lio_error.h"
+#include "light_io/lio_files.h"
+#include "light_io/lio_paths.h"
+#include "light_io/lio_record.h"
+#include "light_io/lio_strbuf.h"
+#include "light_io/lio_utils.h"
+
+
+
+/*-----------------------------------------------------------------------------
+ * Replay parameters
+-----------------------------------------------------------------------------*/
+enum
+{
+    REPLAY_MAX_THREADS = 256,
+    REPLAY_MAX_BUFFER = 16 * 1024 * 1024 // Larger reads and writes are issued in pieces
+};
+
+
+
+typedef struct ReplayConfig
+{
+    const char* pRecording;
+    const char* pRoot;
+    unsigned numThreads;
+    bool fast;
+    bool keep;
+} ReplayConfig;
+
+
+
+/*-------------------------------------
+ * A recorded call, with its paths moved beneath the replay root
+-------------------------------------*/
+typedef struct ReplayCall
+{
+    LioRecordEntry entry;
+    uint64_t replayNs;
+    size_t index; // Position in the recording, which is in the order calls finished
+    bool skipped; // The call could not be reproduced
+    bool mismatched; // The call succeeded during recording but not in the replay, or vice versa
+} ReplayCall;
+
+
+
+/*-------------------------------------
+ * A path which existed before the recording began
+-------------------------------------*/
+typedef struct ReplayNode
+{
+    const char* pPath;
+    uint64_t size;
+    uint64_t openBytes; // Bytes read through the current descriptor
+    unsigned numChildren;
+    bool isFolder;
+    bool existed;
+} ReplayNode;
+
+
+
+typedef struct ReplayContext
+{
+    const ReplayConfig* pConfig;
+    LioArena arena; // Holds every path
+    ReplayCall* pCalls;
+    size_t numCalls;
+    size_t callCapacity;
+
+    ReplayNode* pNodes;
+    size_t numNodes;
+    size_t nodeCapacity;
+    size_t* pSlots; // Open-addressed hash table of node indices + 1
+    size_t numSlots;
+
+    pthread_mutex_t fileLock;
+    LioFile* pFiles; // Replayed descriptors, indexed by recorded descriptor
+    size_t numFiles;
+
+    uint64_t startNs;
+} ReplayContext;
+
+
+
+typedef struct ReplayThread
+{
+    ReplayContext* pCtx;
+    unsigned index;
+    char* pBuffer;
+    size_t capacity;
+    LioStrBuf scratch;
+    const char** ppInputs;
+    size_t inputCapacity;
+} ReplayThread;
+
+
+
+/*-----------------------------------------------------------------------------
+ * Utilities
+-----------------------------------------------------------------------------*/
+static uint64_t replay_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+
+
+static void replay_sleep_until(const uint64_t ns)
+{
+    struct timespec ts;
+    ts.tv_sec = (time_t)(ns / 1000000000ull);
+    ts.tv_nsec = (long)(ns % 1000000000ull);
+
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) != 0)
+    {
+    }
+}
+
+
+
+static uint64_t replay_hash(const char* pStr)
+{
+    uint64_t hash = 14695981039346656037ull;
+
+    for (; *pStr; ++pStr)
+    {
+        hash = (hash ^ (unsigned char)*pStr) * 1099511628211ull;
+    }
+
+    return hash;
+}
+
+
+
+/*-------------------------------------
+ * Move a recorded path, or a '\n'-separated list of them, beneath the root
+-------------------------------------*/
+static const char* replay_map_paths(ReplayContext* const pCtx, LioStrBuf* const pBuf, const char* pPaths)
+{
+    if (!*pPaths)
+    {
+        return "";
+    }
+
+    lio_strbuf_truncate(pBuf, 0);
+
+    while (*pPaths)
+    {
+        const char* const pEnd = strchr(pPaths, '\n');
+        const size_t length = pEnd ? (size_t)(pEnd - pPaths) : strlen(pPaths);
+
+        if (pBuf->length && !lio_strbuf_append_char(pBuf, '\n'))
+        {
+            return NULL;
+        }
+
+        if (!lio_strbuf_append(pBuf, pCtx->pConfig->pRoot)
+        || (*pPaths != LIO_PATH_SEP && !lio_strbuf_append_char(pBuf, LIO_PATH_SEP))
+        || !lio_strbuf_append_n(pBuf, pPaths, length))
+        {
+            return NULL;
+        }
+
+        pPaths += length + (pEnd ? 1 : 0);
+    }
+
+    return lio_arena_str_copy(&pCtx->arena, pBuf->pData, pBuf->length);
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Loading
+-----------------------------------------------------------------------------*/
+static int replay_compare_calls(const void* pA, const void* pB)
+{
+    const ReplayCall* const a = (const ReplayCall*)pA;
+    const ReplayCall* const b = (const ReplayCall*)pB;
+
+    if (a->entry.startNs != b->entry.startNs)
+    {
+        return (a->entry.startNs > b->entry.startNs) - (a->entry.startNs < b->entry.startNs);
+    }
+
+    // Preserve the order calls finished in when they began together
+    return (a->index > b->index) - (a->index < b->index);
+}
+
+
+
+static bool replay_load(ReplayContext* const pCtx)
+{
+    LioRecordReader reader;
+    LioRecordEntry entry;
+    LioStrBuf buf;
+    bool ret = true;
+
+    if (!lio_record_reader_open(&reader, pCtx->pConfig->pRecording))
+    {
+        return false;
+    }
+
+    lio_strbuf_init(&buf);
+    lio_error_clear();
+
+    while (ret && lio_record_reader_next(&reader, &entry))
+    {
+        if (pCtx->numCalls == pCtx->callCapacity)
+        {
+            const size_t capacity = pCtx->callCapacity ? pCtx->callCapacity*2 : 1024;
+            ReplayCall* const pCalls = (ReplayCall*)realloc(pCtx->pCalls, sizeof(ReplayCall) * capacity);
+
+            if (!pCalls)
+            {
+                ret = false;
+                break;
+            }
+
+            pCtx->pCalls = pCalls;
+            pCtx->callCapacity = capacity;
+        }
+
+        ReplayCall* const pCall = pCtx->pCalls + pCtx->numCalls;
+        memset(pCall, 0, sizeof(ReplayCall));
+        pCall->entry = entry;
+        pCall->index = pCtx->numCalls;
+        pCall->entry.pPath = replay_map_paths(pCtx, &buf, entry.pPath);
+        pCall->entry.pOtherPath = replay_map_paths(pCtx, &buf, entry.pOtherPath);
+
+        ret = pCall->entry.pPath && pCall->entry.pOtherPath && entry.op < LIO_STATS_NUM_OPS;
+        pCtx->numCalls += ret;
+    }
+
+    // The reader stops at the end of the recording without reporting anything
+    ret = ret && lio_error_last()->code == LIO_ERROR_NONE;
+
+    if (pCtx->numCalls)
+    {
+        qsort(pCtx->pCalls, pCtx->numCalls, sizeof(ReplayCall), &replay_compare_calls);
+    }
+
+    lio_strbuf_terminate(&buf);
+    lio_record_reader_close(&reader);
+
+    return ret;
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Rebuilding the tree
+ *
+ * A path existed before the recording began if the first call to use it
+ * expected it to. Files are sized to the most data read from them, and
+ * listed folders are padded out to the number of entries they held.
+-----------------------------------------------------------------------------*/
+static ReplayNode* replay_node(ReplayContext* const pCtx, const char* const pPath, bool* const pOutIsNew)
+{
+    if (pCtx->numNodes*2 >= pCtx->numSlots)
+    {
+        const size_t numSlots = pCtx->numSlots ? pCtx->numSlots*2 : 1024;
+        size_t* const pSlots = (size_t*)calloc(numSlots, sizeof(size_t));
+
+        if (!pSlots)
+        {
+            return NULL;
+        }
+
+        for (size_t i = 0; i < pCtx->numNodes; ++i)
+        {
+            size_t slot = replay_hash(pCtx->pNodes[i].pPath) & (numSlots-1);
+            while (pSlots[slot])
+            {
+                slot = (slot+1) & (numSlots-1);
+            }
+            pSlots[slot] = i+1;
+        }
+
+        free(pCtx->pSlots);
+        pCtx->pSlots = pSlots;
+        pCtx->numSlots = numSlots;
+    }
+
+    size_t slot = replay_hash(pPath) & (pCtx->numSlots-1);
+    for (; pCtx->pSlots[slot]; slot = (slot+1) & (pCtx->numSlots-1))
+    {
+        ReplayNode* const pNode = pCtx->pNodes + pCtx->pSlots[slot] - 1;
+        if (strcmp(pNode->pPath, pPath) == 0)
+        {
+            *pOutIsNew = false;
+            return pNode;
+        }
+    }
+
+    if (pCtx->numNodes == pCtx->nodeCapacity)
+    {
+        const size_t capacity = pCtx->nodeCapacity ? pCtx->nodeCapacity*2 : 1024;
+        ReplayNode* const pNodes = (ReplayNode*)realloc(pCtx->pNodes, sizeof(ReplayNode) * capacity);
+
+        if (!pNodes)
+        {
+            return NULL;
+        }
+
+        pCtx->pNodes = pNodes;
+        pCtx->nodeCapacity = capacity;
+    }
+
+    ReplayNode* const pNode = pCtx->pNodes + pCtx->numNodes;
+    memset(pNode, 0, sizeof(ReplayNode));
+    pNode->pPath = pPath;
+
+    pCtx->pSlots[slot] = ++pCtx->numNodes;
+    *pOutIsNew = true;
+
+    return pNode;
+}
+
+
+
+/*-------------------------------------
+ * Note the first use of a path
+-------------------------------------*/
+static ReplayNode* replay_visit(ReplayContext* const pCtx, const char* const pPath, const bool existed, const bool isFolder)
+{
+    bool isNew = false;
+    ReplayNode* const pNode = *pPath ? replay_node(pCtx, pPath, &isNew) : NULL;
+
+    if (isNew)
+    {
+        pNode->existed = existed;
+        pNode->isFolder = isFolder;
+    }
+
+    return pNode;
+}
+
+
+
+static bool replay_scan(ReplayContext* const pCtx)
+{
+    const char** ppFdPaths = NULL; // Indexed by recorded descriptor
+    size_t numFdPaths = 0;
+    LioStrBuf inputs;
+    bool ret = true;
+
+    lio_strbuf_init(&inputs);
+
+    for (size_t i = 0; ret && i < pCtx->numCalls; ++i)
+    {
+        const LioRecordEntry* const pEntry = &pCtx->pCalls[i].entry;
+        const uint64_t* const args = pEntry->args;
+        const bool succeeded = pEntry->result > 0;
+        ReplayNode* pNode = NULL;
+
+        switch ((enum LioStatsOp)pEntry->op)
+        {
+            case LIO_STATS_OP_FILE_OPEN:
+                pNode = replay_visit(pCtx, pEntry->pPath, pEntry->result >= 0 && !(args[0] & LIO_FILE_OPEN_CREATE), false);
+                if (pNode && pEntry->result >= 0)
+                {
+                    const size_t fd = (size_t)pEntry->result;
+                    if (fd >= numFdPaths)
+                    {
+                        const size_t count = LIO_UTILS_MAX(fd+1, numFdPaths*2);
+                        const char** const ppPaths = (const char**)realloc((void*)ppFdPaths, sizeof(char*) * count);
+                        if (!ppPaths)
+                        {
+                            ret = false;
+                            break;
+                        }
+                        memset((void*)(ppPaths + numFdPaths), 0, sizeof(char*) * (count - numFdPaths));
+                        ppFdPaths = ppPaths;
+                        numFdPaths = count;
+                    }
+
+                    ppFdPaths[fd] = pNode->pPath;
+                    pNode->openBytes = 0;
+                }
+                break;
+
+            case LIO_STATS_OP_FILE_READ:
+            case LIO_STATS_OP_FILE_MAP:
+                if (args[0] < numFdPaths && ppFdPaths[args[0]])
+                {
+                    bool isNew = false;
+                    pNode = replay_node(pCtx, ppFdPaths[args[0]], &isNew);
+                    if (pNode)
+                    {
+                        pNode->openBytes += (pEntry->op == LIO_STATS_OP_FILE_MAP) ? (uint64_t)LIO_UTILS_MAX(pEntry->result, 0) : pEntry->bytesRead;
+                        pNode->size = LIO_UTILS_MAX(pNode->size, pNode->openBytes);
+                    }
+                }
+                break;
+
+            case LIO_STATS_OP_FILE_COPY:
+            case LIO_STATS_OP_FILE_SPLIT:
+                pNode = replay_visit(pCtx, pEntry->pPath, succeeded, false);
+                if (pNode)
+                {
+                    pNode->size = LIO_UTILS_MAX(pNode->size, pEntry->bytesRead);
+                }
+                if (pEntry->op == LIO_STATS_OP_FILE_COPY)
+                {
+                    replay_visit(pCtx, pEntry->pOtherPath, false, false);
+                }
+                break;
+
+            case LIO_STATS_OP_FILE_CONCAT:
+            {
+                unsigned numInputs = 0;
+                lio_strbuf_truncate(&inputs, 0);
+                ret = lio_strbuf_append(&inputs, pEntry->pOtherPath);
+
+                for (char* pIter = inputs.pData; ret && pIter && *pIter; ++numInputs)
+                {
+                    char* const pEnd = strchr(pIter, '\n');
+                    if (pEnd)
+                    {
+                        *pEnd = '\0';
+                    }
+
+                    pNode = replay_visit(pCtx, pIter, succeeded, false);
+                    pIter = pEnd ? pEnd+1 : NULL;
+                }
+
+                // Inputs share the bytes read between them
+                for (char* pIter = inputs.pData; ret && numInputs && pIter < inputs.pData + inputs.length; pIter += strlen(pIter)+1)
+                {
+                    bool isNew = false;
+                    pNode = replay_node(pCtx, pIter, &isNew);
+                    if (pNode)
+                    {
+                        pNode->size = LIO_UTILS_MAX(pNode->size, pEntry->bytesRead / numInputs);
+                    }
+                }
+
+                replay_visit(pCtx, pEntry->pPath, false, false);
+                break;
+            }
+
+            case LIO_STATS_OP_PATH_EXISTS:
+                replay_visit(pCtx, pEntry->pPath, succeeded, args[0] == LIO_PATH_TYPE_FOLDER);
+                break;
+
+            case LIO_STATS_OP_PATH_RESOLVE:
+                replay_visit(pCtx, pEntry->pPath, succeeded, false);
+                break;
+
+            case LIO_STATS_OP_PATH_LIST:
+                pNode = replay_visit(pCtx, pEntry->pPath, pEntry->result >= 0, true);
+                if (pNode && pNode->existed && pEntry->result > 0)
+                {
+                    pNode->numChildren = LIO_UTILS_MAX(pNode->numChildren, (unsigned)pEntry->result);
+                }
+                break;
+
+            case LIO_STATS_OP_PATH_REMOVE:
+                replay_visit(pCtx, pEntry->pPath, succeeded, args[0] != 0);
+                break;
+
+            case LIO_STATS_OP_PATH_MKDIRS:
+                replay_visit(pCtx, pEntry->pPath, false, true);
+                break;
+
+            case LIO_STATS_OP_PATH_MOVE:
+                replay_visit(pCtx, pEntry->pPath, pEntry->result == 0, false);
+                replay_visit(pCtx, pEntry->pOtherPath, false, false);
+                break;
+
+            default:
+                break;
+        }
+    }
+
+    free((void*)ppFdPaths);
+    lio_strbuf_terminate(&inputs);
+
+    return ret;
+}
+
+
+
+static bool replay_create_folder(const char* const pPath)
+{
+    return lio_path_does_exist(pPath, LIO_PATH_TYPE_FOLDER) || lio_path_mkdirs(pPath);
+}
+
+
+
+static bool replay_create_file(const char* const pPath, uint64_t size, const char* const pChunk)
+{
+    LioFile file;
+
+    if (!lio_file_open(&file, pPath, LIO_FILE_OPEN_WRITE | LIO_FILE_OPEN_CREATE | LIO_FILE_OPEN_TRUNCATE))
+    {
+        return false;
+    }
+
+    bool ret = true;
+    while (ret && size)
+    {
+        const size_t numBytes = (size_t)LIO_UTILS_MIN(size, (uint64_t)REPLAY_MAX_BUFFER);
+        ret = lio_file_write(&file, pChunk, numBytes);
+        size -= numBytes;
+    }
+
+    return lio_file_close(&file) && ret;
+}
+
+
+
+static bool replay_build(ReplayContext* const pCtx, uint64_t* const pOutNumPaths, uint64_t* const pOutNumBytes)
+{
+    char* const pChunk = (char*)calloc(1, REPLAY_MAX_BUFFER);
+    bool ret = pChunk != NULL;
+
+    *pOutNumPaths = 0;
+    *pOutNumBytes = 0;
+
+    // Every path used by the recording has a folder to live in
+    for (size_t i = 0; ret && i < pCtx->numNodes; ++i)
+    {
+        const ReplayNode* const pNode = pCtx->pNodes + i;
+        char* const pParent = lio_path_dirname(pNode->pPath);
+
+        ret = pParent && replay_create_folder(pParent);
+        lio_path_destroy(pParent);
+
+        if (!ret || !pNode->existed)
+        {
+            continue;
+        }
+
+        ret = pNode->isFolder ? replay_create_folder(pNode->pPath) : replay_create_file(pNode->pPath, pNode->size, pChunk);
+        *pOutNumPaths += 1;
+        *pOutNumBytes += pNode->isFolder ? 0 : pNode->size;
+    }
+
+    for (size_t i = 0; ret && i < pCtx->numNodes; ++i)
+    {
+        const ReplayNode* const pNode = pCtx->pNodes + i;
+        unsigned numEntries = pNode->numChildren ? lio_path_count_entries(pNode->pPath, true, NULL) : 0;
+
+        for (; ret && numEntries < pNode->numChildren; ++numEntries)
+        {
+            char* const pFill = lio_utils_str_fmt("%s%clio_replay_fill_%u", pNode->pPath, LIO_PATH_SEP, numEntries);
+            ret = pFill && replay_create_file(pFill, 0, pChunk);
+            lio_utils_str_destroy(pFill);
+            *pOutNumPaths += 1;
+        }
+    }
+
+    free(pChunk);
+
+    return ret;
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Replaying
+-----------------------------------------------------------------------------*/
+static bool replay_succeeded(const enum LioStatsOp op, const int64_t result)
+{
+    switch (op)
+    {
+        case LIO_STATS_OP_FILE_OPEN:
+        case LIO_STATS_OP_FILE_READ:
+        case LIO_STATS_OP_FILE_SPLIT:
+        case LIO_STATS_OP_PATH_LIST:
+            return result >= 0;
+
+        case LIO_STATS_OP_PATH_MOVE:
+            return result == 0;
+
+        default:
+            break;
+    }
+
+    return result != 0;
+}
+
+
+
+static LioFile replay_get_file(ReplayContext* const pCtx, const uint64_t fd)
+{
+    LioFile file = lio_file_wrap(-1);
+
+    pthread_mutex_lock(&pCtx->fileLock);
+    if (fd < pCtx->numFiles)
+    {
+        file = pCtx->pFiles[fd];
+    }
+    pthread_mutex_unlock(&pCtx->fileLock);
+
+    return file;
+}
+
+
+
+static bool replay_set_file(ReplayContext* const pCtx, const uint64_t fd, const LioFile* const pFile)
+{
+    bool ret = true;
+
+    pthread_mutex_lock(&pCtx->fileLock);
+
+    if (fd >= pCtx->numFiles)
+    {
+        const size_t count = LIO_UTILS_MAX((size_t)fd+1, pCtx->numFiles*2);
+        LioFile* const pFiles = (LioFile*)realloc(pCtx->pFiles, sizeof(LioFile) * count);
+
+        ret = pFiles != NULL;
+        for (size_t i = pCtx->numFiles; ret && i < count; ++i)
+        {
+            pFiles[i] = lio_file_wrap(-1);
+        }
+
+        if (ret)
+        {
+            pCtx->pFiles = pFiles;
+            pCtx->numFiles = count;
+        }
+    }
+
+    if (ret)
+    {
+        pCtx->pFiles[fd] = *pFile;
+    }
+
+    pthread_mutex_unlock(&pCtx->fileLock);
+
+    return ret;
+}
+
+
+
+static bool replay_reserve(ReplayThread* const pThread, const size_t numBytes)
+{
+    if (numBytes <= pThread->capacity)
+    {
+        return true;
+    }
+
+    char* const pBuffer = (char*)realloc(pThread->pBuffer, numBytes);
+    if (!pBuffer)
+    {
+        return false;
+    }
+
+    memset(pBuffer + pThread->capacity, 0, numBytes - pThread->capacity);
+    pThread->pBuffer = pBuffer;
+    pThread->capacity = numBytes;
+
+    return true;
+}
+
+
+
+/*-------------------------------------
+ * Issue one call, returning its result in the form it was recorded in
+-------------------------------------*/
+static int64_t replay_call(ReplayThread* const pThread, ReplayCall* const pCall)
+{
+    ReplayContext* const pCtx = pThread->pCtx;
+    const LioRecordEntry* const pEntry = &pCall->entry;
+    const uint64_t* const args = pEntry->args;
+
+    switch ((enum LioStatsOp)pEntry->op)
+    {
+        case LIO_STATS_OP_FILE_OPEN:
+        {
+            LioFile file;
+            if (!lio_file_open(&file, pEntry->pPath, (unsigned)args[0]))
+            {
+                return -1;
+            }
+            if (pEntry->result >= 0 && !replay_set_file(pCtx, (uint64_t)pEntry->result, &file))
+            {
+                lio_file_close(&file);
+                return -1;
+            }
+            return file.fd;
+        }
+
+        case LIO_STATS_OP_FILE_CLOSE:
+        {
+            const LioFile none = lio_file_wrap(-1);
+            LioFile file = replay_get_file(pCtx, args[0]);
+            replay_set_file(pCtx, args[0], &none);
+            return lio_file_close(&file);
+        }
+
+        case LIO_STATS_OP_FILE_READ:
+        {
+            const LioFile file = replay_get_file(pCtx, args[0]);
+
+            if (args[1] == UINT64_MAX)
+            {
+                size_t numBytes = 0;
+                char* const pData = lio_file_read_all(&file, &numBytes);
+                lio_utils_str_destroy(pData);
+                return pData ? (int64_t)numBytes : -1;
+            }
+
+            const size_t numBytes = (size_t)LIO_UTILS_MIN(args[1], (uint64_t)REPLAY_MAX_BUFFER);
+            if (!replay_reserve(pThread, numBytes))
+            {
+                return -1;
+            }
+            return lio_file_read(&file, pThread->pBuffer, numBytes);
+        }
+
+        case LIO_STATS_OP_FILE_WRITE:
+        {
+            const LioFile file = replay_get_file(pCtx, args[0]);
+            uint64_t numBytes = args[1];
+            bool ret = true;
+
+            if (!replay_reserve(pThread, (size_t)LIO_UTILS_MIN(numBytes, (uint64_t)REPLAY_MAX_BUFFER)))
+            {
+                return 0;
+            }
+
+            do
+            {
+                const size_t numChunk = (size_t)LIO_UTILS_MIN(numBytes, (uint64_t)REPLAY_MAX_BUFFER);
+                ret = lio_file_write(&file, pThread->pBuffer, numChunk);
+                numBytes -= numChunk;
+            }
+            while (ret && numBytes);
+
+            return ret;
+        }
+
+        case LIO_STATS_OP_FILE_MAP:
+        {
+            const LioFile file = replay_get_file(pCtx, args[0]);
+            size_t numBytes = 0;
+            const void* const pData = lio_file_map(&file, &numBytes);
+            if (pData)
+            {
+                lio_file_unmap(pData, numBytes);
+            }
+            return pData ? (int64_t)numBytes : 0;
+        }
+
+        case LIO_STATS_OP_FILE_COPY:
+            if (*pEntry->pPath)
+            {
+                return lio_file_copy_pooled(pEntry->pPath, pEntry->pOtherPath, (unsigned)args[0], NULL);
+            }
+            else
+            {
+                const LioFile from = replay_get_file(pCtx, args[1]);
+                const LioFile to = replay_get_file(pCtx, args[2]);
+                return lio_file_copy_fd(&from, &to, (unsigned)args[0], NULL);
+            }
+
+        case LIO_STATS_OP_FILE_CONCAT:
+        {
+            unsigned numInputs = 0;
+
+            // The descriptors of concatenated inputs are not recorded
+            if (!*pEntry->pPath)
+            {
+                pCall->skipped = true;
+                return pEntry->result;
+            }
+
+            lio_strbuf_truncate(&pThread->scratch, 0);
+            if (!lio_strbuf_append(&pThread->scratch, pEntry->pOtherPath))
+            {
+                return 0;
+            }
+
+            for (char* pIter = pThread->scratch.pData; pIter && *pIter; ++numInputs)
+            {
+                if (numInputs == pThread->inputCapacity)
+                {
+                    const size_t capacity = pThread->inputCapacity ? pThread->inputCapacity*2 : 16;
+                    const char** const ppInputs = (const char**)realloc((void*)pThread->ppInputs, sizeof(char*) * capacity);
+                    if (!ppInputs)
+                    {
+                        return 0;
+                    }
+                    pThread->ppInputs = ppInputs;
+                    pThread->inputCapacity = capacity;
+                }
+
+                char* const pEnd = strchr(pIter, '\n');
+                if (pEnd)
+                {
+                    *pEnd = '\0';
+                }
+
+                pThread->ppInputs[numInputs] = pIter;
+                pIter = pEnd ? pEnd+1 : NULL;
+            }
+
+            return lio_file_concat_ex(pThread->ppInputs, numInputs, pEntry->pPath, (unsigned)args[0]);
+        }
+
+        case LIO_STATS_OP_FILE_SPLIT:
+        {
+            unsigned numParts = 0;
+            char** const ppParts = lio_file_split(
+                pEntry->pPath,
+                pEntry->pOtherPath,
+                (enum LioFileSplitMode)args[0],
+                (size_t)args[1],
+                (int)(int64_t)args[2],
+                &numParts);
+
+            if (!ppParts)
+            {
+                return -1;
+            }
+
+            lio_paths_destroy(ppParts, numParts);
+            return numParts;
+        }
+
+        case LIO_STATS_OP_PATH_EXISTS:
+            return lio_path_does_exist(pEntry->pPath, (enum LioPathType)args[0]);
+
+        case LIO_STATS_OP_PATH_RESOLVE:
+        {
+            char* const pResolved = lio_path_resolve(pEntry->pPath);
+            lio_path_destroy(pResolved);
+            return pResolved != NULL;
+        }
+
+        case LIO_STATS_OP_PATH_LIST:
+        {
+            unsigned numEntries = 0;
+
+            // Filters are not recorded, so filtered listings return everything
+            if (args[2])
+            {
+                numEntries = lio_path_count_entries(pEntry->pPath, args[0] != 0, NULL);
+                return (numEntries == UINT_MAX) ? -1 : (int64_t)numEntries;
+            }
+
+            char** const ppEntries = lio_path_list(pEntry->pPath, args[0] != 0, NULL, &numEntries);
+            if (!ppEntries)
+            {
+                return -1;
+            }
+
+            lio_paths_destroy(ppEntries, numEntries);
+            return numEntries;
+        }
+
+        case LIO_STATS_OP_PATH_REMOVE:
+            return lio_path_remove(pEntry->pPath, args[0] != 0, args[1] != 0);
+
+        case LIO_STATS_OP_PATH_MKDIRS:
+            return lio_path_mkdirs(pEntry->pPath);
+
+        case LIO_STATS_OP_PATH_MOVE:
+            return lio_path_move(pEntry->pPath, pEntry->pOtherPath, args[0] != 0);
+
+        default:
+            break;
+    }
+
+    pCall->skipped = true;
+    return pEntry->result;
+}
+
+
+
+static void* replay_thread(void* pData)
+{
+    ReplayThread* const pThread = (ReplayThread*)pData;
+    ReplayContext* const pCtx = pThread->pCtx;
+    const ReplayConfig* const pConfig = pCtx->pConfig;
+
+    for (size_t i = 0; i < pCtx->numCalls; ++i)
+    {
+        ReplayCall* const pCall = pCtx->pCalls + i;
+
+        // Recorded threads are numbered from 1
+        if ((pCall->entry.threadId - 1u) % pConfig->numThreads != pThread->index)
+        {
+            continue;
+        }
+
+        if (!pConfig->fast)
+        {
+            replay_sleep_until(pCtx->startNs + pCall->entry.startNs);
+        }
+
+        const uint64_t startNs = replay_now();
+        const int64_t result = replay_call(pThread, pCall);
+        pCall->replayNs = replay_now() - startNs;
+
+        const enum LioStatsOp op = (enum LioStatsOp)pCall->entry.op;
+        pCall->mismatched = !pCall->skipped && replay_succeeded(op, result) != replay_succeeded(op, pCall->entry.result);
+    }
+
+    return NULL;
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Reporting
+-----------------------------------------------------------------------------*/
+static int replay_compare_u64(const void* pA, const void* pB)
+{
+    const uint64_t a = *(const uint64_t*)pA;
+    const uint64_t b = *(const uint64_t*)pB;
+    return (a > b) - (a < b);
+}
+
+
+
+static double replay_percentile_us(const uint64_t* const pSorted, const size_t numSamples, const unsigned percent)
+{
+    // Nearest-rank, so every reported value was actually measured
+    size_t rank = (percent * numSamples + 99) / 100;
+    rank = LIO_UTILS_MAX(rank, (size_t)1);
+    return (double)pSorted[rank-1] * 1e-3;
+}
+
+
+
+static bool replay_print_table(FILE* const pOut, const ReplayContext* const pCtx)
+{
+    uint64_t* const pRecorded = (uint64_t*)malloc(sizeof(uint64_t) * LIO_UTILS_MAX(pCtx->numCalls, (size_t)1));
+    uint64_t* const pReplayed = (uint64_t*)malloc(sizeof(uint64_t) * LIO_UTILS_MAX(pCtx->numCalls, (size_t)1));
+
+    if (!pRecorded || !pReplayed)
+    {
+        free(pReplayed);
+        free(pRecorded);
+        return false;
+    }
+
+    fprintf(pOut, "%-12s %8s %8s %8s %12s %12s %12s %12s %12s %12s\n",
+        "op", "calls", "skipped", "differ",
+        "rec mean us", "rec p50 us", "rec p99 us",
+        "mean us", "p50 us", "p99 us");
+
+    for (unsigned op = 0; op < LIO_STATS_NUM_OPS; ++op)
+    {
+        size_t numCalls = 0;
+        size_t numSkipped = 0;
+        size_t numMismatched = 0;
+        double recordedTotal = 0.0;
+        double replayedTotal = 0.0;
+
+        for (size_t i = 0; i < pCtx->numCalls; ++i)
+        {
+            const ReplayCall* const pCall = pCtx->pCalls + i;
+            if (pCall->entry.op != op)
+            {
+                continue;
+            }
+
+            pRecorded[numCalls] = pCall->entry.durationNs;
+            pReplayed[numCalls] = pCall->replayNs;
+            recordedTotal += (double)pCall->entry.durationNs;
+            replayedTotal += (double)pCall->replayNs;
+            numSkipped += pCall->skipped;
+            numMismatched += pCall->mismatched;
+            ++numCalls;
+        }
+
+        if (!numCalls)
+        {
+            continue;
+        }
+
+        qsort(pRecorded, numCalls, sizeof(uint64_t), &replay_compare_u64);
+        qsort(pReplayed, numCalls, sizeof(uint64_t), &replay_compare_u64);
+
+        fprintf(pOut, "%-12s %8zu %8zu %8zu %12.3f %12.3f %12.3f %12.3f %12.3f %12.3f\n",
+            lio_stats_op_name((enum LioStatsOp)op),
+            numCalls,
+            numSkipped,
+            numMismatched,
+            recordedTotal * 1e-3 / (double)numCalls,
+            replay_percentile_us(pRecorded, numCalls, 50),
+            replay_percentile_us(pRecorded, numCalls, 99),
+            replayedTotal * 1e-3 / (double)numCalls,
+            replay_percentile_us(pReplayed, numCalls, 50),
+            replay_percentile_us(pReplayed, numCalls, 99));
+    }
+
+    free(pReplayed);
+    free(pRecorded);
+
+    return true;
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Command line
+-----------------------------------------------------------------------------*/
+static void replay_usage(const char* const pExe)
+{
+    fprintf(stderr,
+        "Usage: %s [options] RECORDING\n"
+        "  --root PATH       Folder to rebuild the recorded tree in, which must not exist yet\n"
+        "  --timing MODE     original, to wait until each call's recorded start, or fast (default: original)\n"
+        "  --threads N       Threads to replay with; recorded threads are spread across them (default: 1)\n"
+        "  --keep            Leave the rebuilt tree in place afterwards\n"
+        "\n"
+        "Recordings are made with lio_record_start().\n",
+        pExe);
+}
+
+
+
+static bool replay_parse_args(const int argc, char* argv[], ReplayConfig* const pConfig)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        const char* const pArg = argv[i];
+        const char* const pValue = (i+1 < argc) ? argv[i+1] : NULL;
+
+        if (strcmp(pArg, "--keep") == 0)
+        {
+            pConfig->keep = true;
+            continue;
+        }
+
+        if (strncmp(pArg, "--", 2) != 0)
+        {
+            pConfig->pRecording = pArg;
+            continue;
+        }
+
+        if (!pValue)
+        {
+            return false;
+        }
+        ++i;
+
+        if (strcmp(pArg, "--root") == 0)
+        {
+            pConfig->pRoot = pValue;
+        }
+        else if (strcmp(pArg, "--timing") == 0)
+        {
+            if (strcmp(pValue, "original") == 0)
+            {
+                pConfig->fast = false;
+            }
+            else if (strcmp(pValue, "fast") == 0)
+            {
+                pConfig->fast = true;
+            }
+            else
+            {
+                return false;
+            }
+        }
+        else if (strcmp(pArg, "--threads") == 0)
+        {
+            pConfig->numThreads = (unsigned)strtoul(pValue, NULL, 10);
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    return pConfig->pRecording
+        && pConfig->pRoot
+        && pConfig->numThreads > 0
+        && pConfig->numThreads <= REPLAY_MAX_THREADS;
+}
+
+
+
+int main(int argc, char* argv[])
+{
+    int ret = 0;
+    ReplayConfig config;
+    ReplayContext ctx;
+    ReplayThread threads[REPLAY_MAX_THREADS];
+    pthread_t handles[REPLAY_MAX_THREADS];
+    unsigned numStarted = 0;
+    char* pRoot = NULL;
+    uint64_t numPaths = 0;
+    uint64_t numBytes = 0;
+
+    memset(&config, 0, sizeof(config));
+    config.numThreads = 1;
+
+    memset(&ctx, 0, sizeof(ctx));
+    memset(threads, 0, sizeof(threads));
+    ctx.pConfig = &config;
+    lio_arena_init(&ctx.arena, 0);
+    pthread_mutex_init(&ctx.fileLock, NULL);
+
+    if (!replay_parse_args(argc, argv, &config))
+    {
+        replay_usage(argv[0]);
+        ret = -1;
+        goto end;
+    }
+
+    // Refuse to replay over existing data, since the replay moves and removes paths
+    if (lio_path_does_exist(config.pRoot, LIO_PATH_TYPE_ANY)
+    || !lio_path_mkdirs(config.pRoot)
+    || (pRoot = lio_path_resolve(config.pRoot)) == NULL)
+    {
+        fprintf(stderr, "Unable to create a new folder at \"%s\".\n", config.pRoot);
+        ret = -2;
+        goto end;
+    }
+    config.pRoot = pRoot;
+
+    if (!replay_load(&ctx))
+    {
+        fprintf(stderr, "Unable to read the recording \"%s\".\n", config.pRecording);
+        lio_error_print(lio_error_last(), stderr);
+        ret = -3;
+        goto end;
+    }
+
+    {
+        const uint64_t startNs = replay_now();
+
+        if (!replay_scan(&ctx) || !replay_build(&ctx, &numPaths, &numBytes))
+        {
+            fprintf(stderr, "Unable to rebuild the recorded tree in \"%s\".\n", config.pRoot);
+            lio_error_print(lio_error_last(), stderr);
+            ret = -4;
+            goto end;
+        }
+
+        fprintf(stderr, "Rebuilt %llu paths (%llu bytes) for %zu calls in %.3f seconds.\n",
+            (unsigned long long)numPaths,
+            (unsigned long long)numBytes,
+            ctx.numCalls,
+            (double)(replay_now() - startNs) * 1e-9);
+    }
+
+    ctx.startNs = replay_now();
+
+    for (; numStarted < config.numThreads; ++numStarted)
+    {
+        threads[numStarted].pCtx = &ctx;
+        threads[numStarted].index = numStarted;
+        lio_strbuf_init(&threads[numStarted].scratch);
+
+        if (pthread_create(handles+numStarted, NULL, &replay_thread, threads+numStarted) != 0)
+        {
+            lio_strbuf_terminate(&threads[numStarted].scratch);
+            fprintf(stderr, "Unable to start replay thread %u.\n", numStarted);
+            ret = -5;
+            break;
+        }
+    }
+
+    for (unsigned i = 0; i < numStarted; ++i)
+    {
+        pthread_join(handles[i], NULL);
+        free((void*)threads[i].ppInputs);
+        free(threads[i].pBuffer);
+        lio_strbuf_terminate(&threads[i].scratch);
+    }
+
+    if (ret == 0)
+    {
+        fprintf(stderr, "Replayed %zu calls on %u threads in %.3f seconds.\n",
+            ctx.numCalls,
+            config.numThreads,
+            (double)(replay_now() - ctx.startNs) * 1e-9);
+
+        replay_print_table(stdout, &ctx);
+    }
+
+    end:
+    for (size_t i = 0; i < ctx.numFiles; ++i)
+    {
+        lio_file_close(ctx.pFiles + i);
+    }
+
+    if (pRoot && !config.keep)
+    {
+        lio_path_remove(pRoot, true, false);
+    }
+
+    free(ctx.pFiles);
+    free(ctx.pSlots);
+    free(ctx.pNodes);
+    free(ctx.pCalls);
+    pthread_mutex_destroy(&ctx.fileLock);
+    lio_arena_terminate(&ctx.arena);
+    lio_path_destroy(pRoot);
+
+    return ret;
+}
@@ -0,0 +1,220 @@
+
+// expose clock_gettime()
+#ifndef _GNU_SOURCE
+    #define _GNU_SOURCE
+#endif
+
+#include <time.h> // clock_gettime()
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "light_io/lio_pathset.h"
+
+
+
+/*-----------------------------------------------------------------------------
+ * Wall-clock time in seconds
+-----------------------------------------------------------------------------*/
+static double bench_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * A typical indexer layout: a few projects, many modules, many files
+-----------------------------------------------------------------------------*/
+static void bench_make_path(char* pPath, const size_t capacity, const unsigned i)
+{
+    snprintf(pPath, capacity, "/home/developer/workspace/project%u/source/module%u/component%u/file%u.cpp", i % 5u, (i / 7u) % 211u, (i / 3u) % 13u, i);
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Baseline: an open-addressed hash set of strings
+-----------------------------------------------------------------------------*/
+static uint64_t bench_hash(const char* pStr)
+{
+    uint64_t hash = 14695981039346656037ull;
+
+    while (*pStr)
+    {
+        hash = (hash ^ (unsigned char)*pStr++) * 1099511628211ull;
+    }
+
+    return hash;
+}
+
+
+
+static int bench_hashset_contains(char* const* pSlots, const size_t mask, const char* pPath)
+{
+    for (size_t i = bench_hash(pPath) & mask;; i = (i + 1) & mask)
+    {
+        if (!pSlots[i])
+        {
+            return 0;
+        }
+
+        if (strcmp(pSlots[i], pPath) == 0)
+        {
+            return 1;
+        }
+    }
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Time lookups of every query, keeping the best of a few rounds since a single
+ * round is easily disturbed on a busy machine
+-----------------------------------------------------------------------------*/
+enum
+{
+    BENCH_NUM_ROUNDS = 5
+};
+
+
+
+static double bench_time_hashset(char* const* pSlots, const size_t mask, char* const* pQueries, const unsigned numQueries, unsigned* pNumFound)
+{
+    double best = 0.0;
+
+    for (unsigned round = 0; round < BENCH_NUM_ROUNDS; ++round)
+    {
+        unsigned numFound = 0;
+        const double start = bench_seconds();
+
+        for (unsigned i = 0; i < numQueries; ++i)
+        {
+            numFound += (unsigned)bench_hashset_contains(pSlots, mask, pQueries[i]);
+        }
+
+        const double elapsed = bench_seconds() - start;
+        best = (round == 0 || elapsed < best) ? elapsed : best;
+        *pNumFound = numFound;
+    }
+
+    return best;
+}
+
+
+
+static double bench_time_pathset(const LioPathSet* pSet, char* const* pQueries, const unsigned numQueries, unsigned* pNumFound)
+{
+    double best = 0.0;
+
+    for (unsigned round = 0; round < BENCH_NUM_ROUNDS; ++round)
+    {
+        unsigned numFound = 0;
+        const double start = bench_seconds();
+
+        for (unsigned i = 0; i < numQueries; ++i)
+        {
+            numFound += lio_pathset_contains(pSet, pQueries[i]) ? 1u : 0u;
+        }
+
+        const double elapsed = bench_seconds() - start;
+        best = (round == 0 || elapsed < best) ? elapsed : best;
+        *pNumFound = numFound;
+    }
+
+    return best;
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Main
+-----------------------------------------------------------------------------*/
+int main(int argc, char* argv[])
+{
+    const unsigned numPaths = (argc > 1) ? (unsigned)strtoul(argv[1], NULL, 10) : 1000000u;
+    size_t numSlots = 1;
+    char path[256];
+
+    while (numSlots < (size_t)numPaths * 2u)
+    {
+        numSlots *= 2u;
+    }
+
+    char** const pPaths = (char**)malloc(sizeof(char*) * (numPaths ? numPaths : 1));
+    char** const pQueries = (char**)malloc(sizeof(char*) * (numPaths ? numPaths : 1));
+    char** const pSlots = (char**)calloc(numSlots, sizeof(char*));
+
+    if (!numPaths || !pPaths || !pQueries || !pSlots)
+    {
+        fprintf(stderr, "Usage: %s [numPaths]\n", argv[0]);
+        free(pPaths);
+        free(pQueries);
+        free(pSlots);
+        return -1;
+    }
+
+    // Array of strings, counting the bytes requested from malloc()
+    size_t listBytes = sizeof(char*) * numPaths;
+    for (unsigned i = 0; i < numPaths; ++i)
+    {
+        bench_make_path(path, sizeof(path), i);
+        pPaths[i] = strdup(path);
+        listBytes += strlen(path) + 1;
+
+        size_t j = bench_hash(path) & (numSlots - 1);
+        while (pSlots[j])
+        {
+            j = (j + 1) & (numSlots - 1);
+        }
+        pSlots[j] = pPaths[i];
+    }
+
+    LioPathSet set;
+    lio_pathset_init(&set);
+
+    double start = bench_seconds();
+    for (unsigned i = 0; i < numPaths; ++i)
+    {
+        lio_pathset_insert(&set, pPaths[i]);
+    }
+    const double insertTime = bench_seconds() - start;
+
+    // Look paths up in a different order than they were inserted, using
+    // copies so neither set compares a string against itself
+    for (unsigned i = 0; i < numPaths; ++i)
+    {
+        pQueries[i] = strdup(pPaths[(unsigned)(((uint64_t)i * 7919u) % numPaths)]);
+    }
+
+    unsigned numHashFound = 0;
+    unsigned numTrieFound = 0;
+    const double hashTime = bench_time_hashset(pSlots, numSlots - 1, pQueries, numPaths, &numHashFound);
+    const double trieTime = bench_time_pathset(&set, pQueries, numPaths, &numTrieFound);
+
+    printf("%u paths (%u and %u found)\n", numPaths, numHashFound, numTrieFound);
+    printf("    char** memory:       %10.2f MB (excluding allocator overhead)\n", (double)listBytes / (1024.0 * 1024.0));
+    printf("    hash set memory:     %10.2f MB (strings plus slots)\n", (double)(listBytes + numSlots * sizeof(char*)) / (1024.0 * 1024.0));
+    printf("    path set memory:     %10.2f MB\n", (double)lio_pathset_memory_usage(&set) / (1024.0 * 1024.0));
+    printf("    path set insert:     %10.2f ns/path\n", insertTime * 1e9 / numPaths);
+    printf("    hash set lookup:     %10.2f ns/path\n", hashTime * 1e9 / numPaths);
+    printf("    path set lookup:     %10.2f ns/path\n", trieTime * 1e9 / numPaths);
+
+    lio_pathset_terminate(&set);
+
+    for (unsigned i = 0; i < numPaths; ++i)
+    {
+        free(pPaths[i]);
+        free(pQueries[i]);
+    }
+
+    free(pPaths);
+    free(pQueries);
+    free(pSlots);
+
+    return 0;
+}
@@ -0,0 +1,106 @@
+
+// expose clock_gettime()
+#ifndef _GNU_SOURCE
+    #define _GNU_SOURCE
+#endif
+
+#include <time.h> // clock_gettime()
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "light_io/lio_paths.h"
+#include "light_io/lio_pathview.h"
+
+
+
+/*-----------------------------------------------------------------------------
+ * Wall-clock time in seconds
+-----------------------------------------------------------------------------*/
+static double bench_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Byte-by-byte reverse scan, as used by the original basename/dirname
+-----------------------------------------------------------------------------*/
+static size_t bench_scalar_rfind(const char* pPath, const size_t length)
+{
+    size_t iter = length;
+
+    while (iter --> 0)
+    {
+        if (pPath[iter] == LIO_PATH_SEP)
+        {
+            return iter;
+        }
+    }
+
+    return length;
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Main
+-----------------------------------------------------------------------------*/
+int main(int argc, char* argv[])
+{
+    const unsigned numPaths = (argc > 1) ? (unsigned)strtoul(argv[1], NULL, 10) : 1000000u;
+    const size_t componentLength = (argc > 2) ? (size_t)strtoul(argv[2], NULL, 10) : 24u;
+    char path[4096];
+    size_t length = 0;
+    size_t checksum = 0;
+
+    if (!numPaths || !componentLength || componentLength >= sizeof(path)/4)
+    {
+        fprintf(stderr, "Usage: %s [numPaths] [componentLength]\n", argv[0]);
+        return -1;
+    }
+
+    // A typical indexer path: a handful of directories and a long file name
+    for (unsigned c = 0; c < 4u; ++c)
+    {
+        path[length++] = LIO_PATH_SEP;
+        memset(path + length, 'a' + (char)c, componentLength);
+        length += componentLength;
+    }
+    memcpy(path + length, ".dat", 5);
+    length += 4;
+
+    double start = bench_seconds();
+    for (unsigned i = 0; i < numPaths; ++i)
+    {
+        checksum += bench_scalar_rfind(path, length - (i & 3u));
+    }
+    const double scalarTime = bench_seconds() - start;
+
+    start = bench_seconds();
+    for (unsigned i = 0; i < numPaths; ++i)
+    {
+        checksum += lio_pathview_basename(lio_pathview_make_n(path, length - (i & 3u))).length;
+    }
+    const double viewTime = bench_seconds() - start;
+
+    start = bench_seconds();
+    for (unsigned i = 0; i < numPaths; ++i)
+    {
+        char* const pBase = lio_path_basename(path);
+        checksum += pBase[0];
+        lio_path_destroy(pBase);
+    }
+    const double copyTime = bench_seconds() - start;
+
+    printf("%u paths of %zu characters (checksum %zu)\n", numPaths, length, checksum);
+    printf("    scalar scan:     %8.2f ns/path\n", scalarTime * 1e9 / numPaths);
+    printf("    basename view:   %8.2f ns/path\n", viewTime * 1e9 / numPaths);
+    printf("    basename copy:   %8.2f ns/path\n", copyTime * 1e9 / numPaths);
+
+    return 0;
+}
@@ -0,0 +1,117 @@
+
+#ifndef LIGHT_IO_ALLOC_H
+#define LIGHT_IO_ALLOC_H
+
+#include <stddef.h> // size_t
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+
+/**
+ * @brief A set of functions which the library uses for all heap memory.
+ *
+ * Every allocating function in the library, and every "*_destroy()" function
+ * which frees the memory returned from them, goes through the active
+ * allocator. Memory returned from the library must therefore be released by
+ * the same allocator which created it.
+ *
+ * The process-wide buffer pool from "lio_bufpool_shared()" is allocated once
+ * by whichever allocator is active when it is first used, and is never freed.
+ */
+typedef struct LioAllocator
+{
+    /**
+     * Allocate "numBytes" bytes of memory, suitably aligned for any type.
+     * Return NULL on failure.
+     */
+    void* (*allocate)(void* pUserData, size_t numBytes);
+
+    /**
+     * Resize an allocation, preserving its contents. "pMem" is never NULL
+     * and "oldSize" is the size which was last requested for it.
+     */
+    void* (*reallocate)(void* pUserData, void* pMem, size_t oldSize, size_t newSize);
+
+    /**
+     * Release an allocation. "pMem" is never NULL.
+     */
+    void (*deallocate)(void* pUserData, void* pMem);
+
+    void* pUserData;
+} LioAllocator;
+
+
+
+/**
+ * @brief Replace the allocator used by the library.
+ *
+ * This is not thread-safe. It should be called before any other library
+ * function, or while no memory from the previous allocator is outstanding.
+ *
+ * @param pAllocator
+ * A pointer to the allocator to copy, or NULL to restore the default
+ * malloc/realloc/free allocator.
+ */
+void lio_alloc_set_allocator(const LioAllocator* const pAllocator);
+
+
+
+/**
+ * @brief Retrieve the allocator used by the library.
+ *
+ * @param pOutAllocator
+ * A pointer to a structure which will contain a copy of the active allocator.
+ */
+void lio_alloc_get_allocator(LioAllocator* const pOutAllocator);
+
+
+
+/**
+ * @brief Allocate memory with the active allocator.
+ */
+void* lio_alloc_malloc(const size_t numBytes);
+
+
+
+/**
+ * @brief Allocate zero-initialized memory with the active allocator.
+ */
+void* lio_alloc_calloc(const size_t count, const size_t size);
+
+
+
+/**
+ * @brief Resize memory from the active allocator.
+ *
+ * @param pMem
+ * A pointer to memory from the active allocator, or NULL to allocate new
+ * memory.
+ *
+ * @param oldSize
+ * The number of bytes last requested for "pMem".
+ *
+ * @param newSize
+ * The number of bytes to resize "pMem" to.
+ *
+ * @return A pointer to the resized memory, or NULL if the memory could not be
+ * resized. "pMem" remains valid on failure.
+ */
+void* lio_alloc_realloc(void* const pMem, const size_t oldSize, const size_t newSize);
+
+
+
+/**
+ * @brief Release memory from the active allocator. NULL pointers are ignored.
+ */
+void lio_alloc_free(void* const pMem);
+
+
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* LIGHT_IO_ALLOC_H */
@@ -0,0 +1,167 @@
+
+#ifndef LIGHT_IO_APPENDER_H
+#define LIGHT_IO_APPENDER_H
+
+#include <stddef.h> // size_t
+#include <stdbool.h>
+#include <stdint.h> // int64_t, uint64_t
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+
+/**
+ * @brief Defaults used when creating appenders.
+ */
+enum LioAppenderLimits
+{
+    LIO_APPENDER_DEFAULT_EXTENT_SIZE = 64*1024*1024 // 64MB
+};
+
+
+
+/**
+ * @brief Flags which control how an appender opens its file.
+ */
+enum LioAppenderFlags
+{
+    LIO_APPENDER_DEFAULT  = 0x00, // Continue after any existing contents
+    LIO_APPENDER_TRUNCATE = 0x01  // Discard any existing contents
+};
+
+
+
+/**
+ * @brief A log file which many threads can append records to at once.
+ *
+ * The file is kept open for the life of the appender. Each record reserves
+ * its range of the file with a single atomic addition and is written with
+ * pwrite(), so appends from different threads never wait on each other. The
+ * file is preallocated in large extents to keep block allocation out of the
+ * write path.
+ *
+ * Records become durable with a group commit: a thread which needs its data
+ * on storage waits for the next fdatasync(), and every thread waiting at the
+ * same time shares it. Flushes happen on an explicit "lio_appender_sync()",
+ * and optionally from a background thread after a number of bytes or an
+ * interval of time.
+ *
+ * Durability:
+ * - A record is durable once a sync which began after its append returned
+ *   has completed. "lio_appender_sync()" provides exactly this for every
+ *   append which returned before it was called.
+ * - Without an explicit sync, at most "syncBytes" bytes or "syncIntervalMs"
+ *   milliseconds of records (roughly, as flushes are not instant) are lost
+ *   in a crash.
+ * - Records are not durable in the order they were reserved. After a crash,
+ *   a record whose append had not returned may be missing or read as zeros
+ *   while later records survive, so readers must be able to detect partial
+ *   records.
+ * - Only one appender (or process) may write to a file at once, as ranges
+ *   are reserved in memory rather than with O_APPEND.
+ *
+ * (*NIX only)
+ */
+typedef struct LioAppender LioAppender;
+
+
+
+/**
+ * @brief Open a file for appending.
+ *
+ * @param pPath
+ * The file to append to. It is created if it does not exist.
+ *
+ * @param extentSize
+ * The number of bytes to preallocate at once, or 0 to let the file grow with
+ * each write. Preallocation does not change the size of the file.
+ *
+ * @param syncBytes
+ * Flush once this many bytes were appended since the last flush, or 0 to
+ * only flush by time or explicitly.
+ *
+ * @param syncIntervalMs
+ * Flush any appended data this often, in milliseconds, or 0 to only flush by
+ * size or explicitly. A background thread is started if either this or
+ * "syncBytes" is not 0.
+ *
+ * @param flags
+ * A bitwise combination of values from the LioAppenderFlags enumeration.
+ *
+ * @return A pointer to a new appender, or NULL if an error occurred. The
+ * appender must be closed with "lio_appender_destroy()".
+ */
+LioAppender* lio_appender_create(
+    const char* const pPath,
+    const uint64_t extentSize,
+    const uint64_t syncBytes,
+    const unsigned syncIntervalMs,
+    const unsigned flags);
+
+
+
+/**
+ * @brief Flush and close an appender.
+ *
+ * No appends may be running, or be started, while an appender is destroyed.
+ *
+ * @return TRUE if all appended data is durable and the file was closed, FALSE
+ * if not.
+ */
+bool lio_appender_destroy(LioAppender* const pAppender);
+
+
+
+/**
+ * @brief Append a record to the end of the file.
+ *
+ * This is safe to call from any number of threads. Records are never
+ * interleaved with each other, though their order in the file is only the
+ * order in which their ranges were reserved.
+ *
+ * @return The offset at which the record was written, or -1 if it could not
+ * be. A failed record leaves a range of zeros (or a partial record) in the
+ * file.
+ */
+int64_t lio_appender_append(LioAppender* const pAppender, const void* const pData, const size_t numBytes);
+
+
+
+/**
+ * @brief Wait until every record appended before this call is durable.
+ *
+ * Concurrent callers share a single flush.
+ *
+ * @return TRUE if the records are durable, FALSE if a flush has failed. Once
+ * a flush fails, the durability of the file is unknown and every later call
+ * fails too.
+ */
+bool lio_appender_sync(LioAppender* const pAppender);
+
+
+
+/**
+ * @brief Retrieve the number of bytes in the file, including every range
+ * reserved so far.
+ */
+uint64_t lio_appender_size(const LioAppender* const pAppender);
+
+
+
+/**
+ * @brief Retrieve the number of flushes made by an appender.
+ *
+ * This is a measure of how well appends were grouped together: it is far
+ * lower than the number of calls to "lio_appender_sync()" under contention.
+ */
+uint64_t lio_appender_num_syncs(const LioAppender* const pAppender);
+
+
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* LIGHT_IO_APPENDER_H */
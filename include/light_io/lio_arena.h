@@ -0,0 +1,111 @@
+
+#ifndef LIGHT_IO_ARENA_H
+#define LIGHT_IO_ARENA_H
+
+#include <stddef.h> // size_t
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+
+enum LioArenaLimits
+{
+    LIO_ARENA_DEFAULT_BLOCK_SIZE = 64*1024, // 64KB
+    LIO_ARENA_ALIGNMENT = 16
+};
+
+
+
+/**
+ * @brief A bump allocator for many small, short-lived allocations.
+ *
+ * Allocations are carved sequentially from large blocks and are never freed
+ * individually. Everything allocated from an arena is released at once with
+ * "lio_arena_reset()" or "lio_arena_terminate()".
+ */
+typedef struct LioArena
+{
+    struct LioArenaBlock* pBlocks;
+    size_t blockSize;
+} LioArena;
+
+
+
+/**
+ * @brief Initialize an empty arena. No memory is allocated until the first
+ * allocation.
+ *
+ * @param pArena
+ * A pointer to the arena to initialize.
+ *
+ * @param blockSize
+ * The number of bytes to allocate at a time, or 0 to use
+ * LIO_ARENA_DEFAULT_BLOCK_SIZE.
+ */
+void lio_arena_init(LioArena* const pArena, const size_t blockSize);
+
+
+
+/**
+ * @brief Release all memory used by an arena.
+ *
+ * @param pArena
+ * A pointer to an initialized arena.
+ */
+void lio_arena_terminate(LioArena* const pArena);
+
+
+
+/**
+ * @brief Invalidate every allocation from an arena while keeping its most
+ * recent block for reuse.
+ *
+ * @param pArena
+ * A pointer to an initialized arena.
+ */
+void lio_arena_reset(LioArena* const pArena);
+
+
+
+/**
+ * @brief Allocate memory from an arena.
+ *
+ * @param pArena
+ * A pointer to an initialized arena.
+ *
+ * @param numBytes
+ * The number of bytes to allocate. Requests larger than the arena's block
+ * size receive a dedicated block.
+ *
+ * @return A pointer to uninitialized memory aligned to LIO_ARENA_ALIGNMENT
+ * bytes, or NULL if memory could not be allocated.
+ */
+void* lio_arena_alloc(LioArena* const pArena, const size_t numBytes);
+
+
+
+/**
+ * @brief Copy a string into an arena.
+ *
+ * @param pArena
+ * A pointer to an initialized arena.
+ *
+ * @param pStr
+ * The string to copy.
+ *
+ * @param numChars
+ * The number of characters to copy, or 0 to copy the entire string.
+ *
+ * @return A NULL-terminated copy of the string, or NULL if an error occurred.
+ */
+char* lio_arena_str_copy(LioArena* const pArena, const char* const pStr, size_t numChars);
+
+
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* LIGHT_IO_ARENA_H */
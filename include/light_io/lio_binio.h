@@ -0,0 +1,625 @@
+
+#ifndef LIGHT_IO_BINIO_H
+#define LIGHT_IO_BINIO_H
+
+#include <stdbool.h>
+#include <stddef.h> // size_t
+#include <stdint.h> // fixed-width integers
+#include <string.h> // memcpy()
+
+#include "light_io/lio_utils.h"
+#include "light_io/lio_files.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+
+/**
+ * @brief Byte orders which binary data can be read or written in.
+ */
+enum LioByteOrder
+{
+    LIO_BYTE_ORDER_LITTLE,
+    LIO_BYTE_ORDER_BIG
+};
+
+#if defined(__BYTE_ORDER__) && defined(__ORDER_BIG_ENDIAN__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+    #define LIO_BYTE_ORDER_NATIVE LIO_BYTE_ORDER_BIG
+#else
+    #define LIO_BYTE_ORDER_NATIVE LIO_BYTE_ORDER_LITTLE
+#endif
+
+
+
+enum LioBinIOLimits
+{
+    LIO_BINIO_DEFAULT_BUFFER_SIZE = 64*1024 // 64KB
+};
+
+
+
+/**
+ * @brief A cursor which reads binary data from memory, a mapped file, or a
+ * buffered file handle.
+ *
+ * Bounds are checked once per block with "lio_binreader_require()". The
+ * "lio_binreader_get_*()" functions which follow do not check bounds, which
+ * allows a fixed-size record to be decoded without a branch per field.
+ */
+typedef struct LioBinReader
+{
+    const unsigned char* pData; // Current window of readable data
+    size_t size; // Number of valid bytes in the window
+    size_t pos; // Cursor within the window
+    uint64_t windowOffset; // Stream offset of the window's first byte
+
+    LioFile file; // Refills the window in buffered mode
+    unsigned char* pBuffer;
+    size_t capacity;
+
+    const void* pMapping;
+    size_t mappingSize;
+
+    bool swap; // Values are in a byte order other than the native one
+    bool failed;
+} LioBinReader;
+
+
+
+/**
+ * @brief A cursor which writes binary data to a growable memory buffer or a
+ * buffered file handle.
+ *
+ * Space is reserved once per block with "lio_binwriter_reserve()". The
+ * "lio_binwriter_put_*()" functions which follow do not check bounds.
+ */
+typedef struct LioBinWriter
+{
+    unsigned char* pBuffer;
+    size_t capacity;
+    size_t pos;
+    uint64_t numFlushed; // Bytes already written to the file
+
+    LioFile file; // Receives flushed data in file mode
+
+    bool swap;
+    bool failed;
+} LioBinWriter;
+
+
+
+/*-----------------------------------------------------------------------------
+ * Binary Reader
+-----------------------------------------------------------------------------*/
+/**
+ * @brief Initialize a reader over a region of memory.
+ *
+ * @param pReader
+ * A pointer to the reader to initialize.
+ *
+ * @param pData
+ * A pointer to the data to read. It must remain valid for the lifetime of the
+ * reader.
+ *
+ * @param numBytes
+ * The number of readable bytes at "pData".
+ *
+ * @param order
+ * The byte order of the data.
+ *
+ * @return TRUE if the reader was initialized, FALSE if not.
+ */
+bool lio_binreader_init_memory(
+    LioBinReader* const pReader,
+    const void* const pData,
+    const size_t numBytes,
+    const enum LioByteOrder order);
+
+
+
+/**
+ * @brief Initialize a reader over the mapped contents of a regular file.
+ *
+ * @param pReader
+ * A pointer to the reader to initialize.
+ *
+ * @param pFile
+ * A handle to a regular file which is open for reading. The file may be
+ * closed once the reader has been initialized.
+ *
+ * @param order
+ * The byte order of the data.
+ *
+ * @return TRUE if the reader was initialized, FALSE if the file could not be
+ * mapped.
+ */
+bool lio_binreader_init_map(
+    LioBinReader* const pReader,
+    const LioFile* const pFile,
+    const enum LioByteOrder order);
+
+
+
+/**
+ * @brief Initialize a reader which refills a buffer from the current position
+ * of a file, pipe, or other stream.
+ *
+ * @param pReader
+ * A pointer to the reader to initialize.
+ *
+ * @param pFile
+ * A file handle which is open for reading. It must remain open for the
+ * lifetime of the reader.
+ *
+ * @param bufferSize
+ * The initial size of the read buffer, or 0 to use
+ * LIO_BINIO_DEFAULT_BUFFER_SIZE. The buffer grows if a larger block is
+ * required.
+ *
+ * @param order
+ * The byte order of the data.
+ *
+ * @return TRUE if the reader was initialized, FALSE if not.
+ */
+bool lio_binreader_init_file(
+    LioBinReader* const pReader,
+    const LioFile* const pFile,
+    const size_t bufferSize,
+    const enum LioByteOrder order);
+
+
+
+/**
+ * @brief Release all resources used by a reader.
+ *
+ * @param pReader
+ * A pointer to an initialized reader.
+ */
+void lio_binreader_terminate(LioBinReader* const pReader);
+
+
+
+/**
+ * @brief Make more data available to a reader. Most callers should use
+ * "lio_binreader_require()" instead.
+ *
+ * @return TRUE if at least "numBytes" contiguous bytes are available, FALSE
+ * if the end of the data was reached or an error occurred.
+ */
+bool lio_binreader_fill(LioBinReader* const pReader, const size_t numBytes);
+
+
+
+/**
+ * @brief Ensure a block of data can be read with the unchecked
+ * "lio_binreader_get_*()" functions.
+ *
+ * @param pReader
+ * A pointer to an initialized reader.
+ *
+ * @param numBytes
+ * The number of bytes which will be read.
+ *
+ * @return TRUE if "numBytes" bytes are available, FALSE if not. The reader is
+ * marked as failed if the bytes are unavailable.
+ */
+static inline bool lio_binreader_require(LioBinReader* const pReader, const size_t numBytes)
+{
+    return (pReader->size - pReader->pos >= numBytes) || lio_binreader_fill(pReader, numBytes);
+}
+
+
+
+/**
+ * @brief Retrieve a pointer to the next block of data and advance past it.
+ *
+ * Native-endian data in a mapped file can be used in-place with no copies.
+ *
+ * @return A pointer to "numBytes" contiguous bytes which remains valid until
+ * the next read from the reader, or NULL if the bytes are unavailable.
+ */
+const void* lio_binreader_view(LioBinReader* const pReader, const size_t numBytes);
+
+
+
+/**
+ * @brief Skip past data in a reader.
+ *
+ * @return TRUE if "numBytes" bytes were skipped, FALSE if the end of the data
+ * was reached first.
+ */
+bool lio_binreader_skip(LioBinReader* const pReader, size_t numBytes);
+
+
+
+/**
+ * @brief Read raw bytes, with no byte swapping.
+ *
+ * Large reads from a buffered file bypass the reader's buffer.
+ *
+ * @return TRUE if "numBytes" bytes were read, FALSE if not.
+ */
+bool lio_binreader_read_bytes(LioBinReader* const pReader, void* const pOut, size_t numBytes);
+
+
+
+/**
+ * @brief Read arrays of values, swapping them to native byte order in bulk.
+ *
+ * @return TRUE if "count" values were read, FALSE if not.
+ */
+bool lio_binreader_read_u16_array(LioBinReader* const pReader, uint16_t* const pOut, const size_t count);
+bool lio_binreader_read_u32_array(LioBinReader* const pReader, uint32_t* const pOut, const size_t count);
+bool lio_binreader_read_u64_array(LioBinReader* const pReader, uint64_t* const pOut, const size_t count);
+bool lio_binreader_read_f_array(LioBinReader* const pReader, float* const pOut, const size_t count);
+bool lio_binreader_read_d_array(LioBinReader* const pReader, double* const pOut, const size_t count);
+
+
+
+/**
+ * @brief Retrieve the number of bytes consumed from the start of the data.
+ */
+static inline uint64_t lio_binreader_tell(const LioBinReader* const pReader)
+{
+    return pReader->windowOffset + pReader->pos;
+}
+
+
+
+/**
+ * @brief Determine if any read from a reader has failed.
+ */
+static inline bool lio_binreader_failed(const LioBinReader* const pReader)
+{
+    return pReader->failed;
+}
+
+
+
+/**
+ * @brief Unchecked reads of single values. Each call must be covered by a
+ * prior call to "lio_binreader_require()".
+ */
+static inline uint8_t lio_binreader_get_u8(LioBinReader* const pReader)
+{
+    return pReader->pData[pReader->pos++];
+}
+
+
+
+static inline uint16_t lio_binreader_get_u16(LioBinReader* const pReader)
+{
+    uint16_t n;
+    memcpy(&n, pReader->pData + pReader->pos, sizeof(n));
+    pReader->pos += sizeof(n);
+    return pReader->swap ? lio_utils_btol_u16(n) : n;
+}
+
+
+
+static inline uint32_t lio_binreader_get_u32(LioBinReader* const pReader)
+{
+    uint32_t n;
+    memcpy(&n, pReader->pData + pReader->pos, sizeof(n));
+    pReader->pos += sizeof(n);
+    return pReader->swap ? lio_utils_btol_u32(n) : n;
+}
+
+
+
+static inline uint64_t lio_binreader_get_u64(LioBinReader* const pReader)
+{
+    uint64_t n;
+    memcpy(&n, pReader->pData + pReader->pos, sizeof(n));
+    pReader->pos += sizeof(n);
+    return pReader->swap ? lio_utils_btol_u64(n) : n;
+}
+
+
+
+static inline int8_t lio_binreader_get_s8(LioBinReader* const pReader)
+{
+    return (int8_t)lio_binreader_get_u8(pReader);
+}
+
+
+
+static inline int16_t lio_binreader_get_s16(LioBinReader* const pReader)
+{
+    return (int16_t)lio_binreader_get_u16(pReader);
+}
+
+
+
+static inline int32_t lio_binreader_get_s32(LioBinReader* const pReader)
+{
+    return (int32_t)lio_binreader_get_u32(pReader);
+}
+
+
+
+static inline int64_t lio_binreader_get_s64(LioBinReader* const pReader)
+{
+    return (int64_t)lio_binreader_get_u64(pReader);
+}
+
+
+
+static inline float lio_binreader_get_f(LioBinReader* const pReader)
+{
+    const uint32_t n = lio_binreader_get_u32(pReader);
+    float f;
+    memcpy(&f, &n, sizeof(f));
+    return f;
+}
+
+
+
+static inline double lio_binreader_get_d(LioBinReader* const pReader)
+{
+    const uint64_t n = lio_binreader_get_u64(pReader);
+    double d;
+    memcpy(&d, &n, sizeof(d));
+    return d;
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Binary Writer
+-----------------------------------------------------------------------------*/
+/**
+ * @brief Initialize a writer which accumulates data in a growable buffer.
+ *
+ * @param pWriter
+ * A pointer to the writer to initialize.
+ *
+ * @param initialCapacity
+ * The initial size of the buffer, or 0 to use LIO_BINIO_DEFAULT_BUFFER_SIZE.
+ *
+ * @param order
+ * The byte order which values will be written in.
+ *
+ * @return TRUE if the writer was initialized, FALSE if not.
+ */
+bool lio_binwriter_init_memory(
+    LioBinWriter* const pWriter,
+    const size_t initialCapacity,
+    const enum LioByteOrder order);
+
+
+
+/**
+ * @brief Initialize a writer which flushes a buffer to the current position
+ * of a file, pipe, or other stream.
+ *
+ * @param pWriter
+ * A pointer to the writer to initialize.
+ *
+ * @param pFile
+ * A file handle which is open for writing. It must remain open until the
+ * writer has been terminated.
+ *
+ * @param bufferSize
+ * The size of the write buffer, or 0 to use LIO_BINIO_DEFAULT_BUFFER_SIZE.
+ *
+ * @param order
+ * The byte order which values will be written in.
+ *
+ * @return TRUE if the writer was initialized, FALSE if not.
+ */
+bool lio_binwriter_init_file(
+    LioBinWriter* const pWriter,
+    const LioFile* const pFile,
+    const size_t bufferSize,
+    const enum LioByteOrder order);
+
+
+
+/**
+ * @brief Flush all buffered data and release the resources used by a writer.
+ *
+ * @param pWriter
+ * A pointer to an initialized writer.
+ *
+ * @return TRUE if every write succeeded, FALSE if any write failed.
+ */
+bool lio_binwriter_terminate(LioBinWriter* const pWriter);
+
+
+
+/**
+ * @brief Write all buffered data to the writer's file. Memory writers are
+ * not affected.
+ *
+ * @return TRUE if the data was written, FALSE if not.
+ */
+bool lio_binwriter_flush(LioBinWriter* const pWriter);
+
+
+
+/**
+ * @brief Make room in a writer's buffer. Most callers should use
+ * "lio_binwriter_reserve()" instead.
+ *
+ * @return TRUE if at least "numBytes" contiguous bytes are available, FALSE
+ * if not.
+ */
+bool lio_binwriter_make_room(LioBinWriter* const pWriter, const size_t numBytes);
+
+
+
+/**
+ * @brief Ensure a block of data can be written with the unchecked
+ * "lio_binwriter_put_*()" functions.
+ *
+ * @param pWriter
+ * A pointer to an initialized writer.
+ *
+ * @param numBytes
+ * The number of bytes which will be written.
+ *
+ * @return TRUE if space for "numBytes" bytes is available, FALSE if not. The
+ * writer is marked as failed if space could not be made.
+ */
+static inline bool lio_binwriter_reserve(LioBinWriter* const pWriter, const size_t numBytes)
+{
+    return (pWriter->capacity - pWriter->pos >= numBytes) || lio_binwriter_make_room(pWriter, numBytes);
+}
+
+
+
+/**
+ * @brief Write raw bytes, with no byte swapping.
+ *
+ * @return TRUE if the bytes were written, FALSE if not.
+ */
+bool lio_binwriter_write_bytes(LioBinWriter* const pWriter, const void* const pData, size_t numBytes);
+
+
+
+/**
+ * @brief Write arrays of values, swapping them from native byte order in
+ * bulk.
+ *
+ * @return TRUE if "count" values were written, FALSE if not.
+ */
+bool lio_binwriter_write_u16_array(LioBinWriter* const pWriter, const uint16_t* const pData, const size_t count);
+bool lio_binwriter_write_u32_array(LioBinWriter* const pWriter, const uint32_t* const pData, const size_t count);
+bool lio_binwriter_write_u64_array(LioBinWriter* const pWriter, const uint64_t* const pData, const size_t count);
+bool lio_binwriter_write_f_array(LioBinWriter* const pWriter, const float* const pData, const size_t count);
+bool lio_binwriter_write_d_array(LioBinWriter* const pWriter, const double* const pData, const size_t count);
+
+
+
+/**
+ * @brief Retrieve the data accumulated by a memory writer.
+ *
+ * @param pWriter
+ * A pointer to a writer initialized with "lio_binwriter_init_memory()".
+ *
+ * @param pOutNumBytes
+ * A pointer to a size_t which will contain the number of bytes written.
+ *
+ * @return A pointer to the written data, which remains valid until the next
+ * write to the writer.
+ */
+static inline const void* lio_binwriter_data(const LioBinWriter* const pWriter, size_t* const pOutNumBytes)
+{
+    *pOutNumBytes = pWriter->pos;
+    return pWriter->pBuffer;
+}
+
+
+
+/**
+ * @brief Retrieve the total number of bytes written.
+ */
+static inline uint64_t lio_binwriter_tell(const LioBinWriter* const pWriter)
+{
+    return pWriter->numFlushed + pWriter->pos;
+}
+
+
+
+/**
+ * @brief Determine if any write to a writer has failed.
+ */
+static inline bool lio_binwriter_failed(const LioBinWriter* const pWriter)
+{
+    return pWriter->failed;
+}
+
+
+
+/**
+ * @brief Unchecked writes of single values. Each call must be covered by a
+ * prior call to "lio_binwriter_reserve()".
+ */
+static inline void lio_binwriter_put_u8(LioBinWriter* const pWriter, const uint8_t n)
+{
+    pWriter->pBuffer[pWriter->pos++] = n;
+}
+
+
+
+static inline void lio_binwriter_put_u16(LioBinWriter* const pWriter, uint16_t n)
+{
+    n = pWriter->swap ? lio_utils_btol_u16(n) : n;
+    memcpy(pWriter->pBuffer + pWriter->pos, &n, sizeof(n));
+    pWriter->pos += sizeof(n);
+}
+
+
+
+static inline void lio_binwriter_put_u32(LioBinWriter* const pWriter, uint32_t n)
+{
+    n = pWriter->swap ? lio_utils_btol_u32(n) : n;
+    memcpy(pWriter->pBuffer + pWriter->pos, &n, sizeof(n));
+    pWriter->pos += sizeof(n);
+}
+
+
+
+static inline void lio_binwriter_put_u64(LioBinWriter* const pWriter, uint64_t n)
+{
+    n = pWriter->swap ? lio_utils_btol_u64(n) : n;
+    memcpy(pWriter->pBuffer + pWriter->pos, &n, sizeof(n));
+    pWriter->pos += sizeof(n);
+}
+
+
+
+static inline void lio_binwriter_put_s8(LioBinWriter* const pWriter, const int8_t n)
+{
+    lio_binwriter_put_u8(pWriter, (uint8_t)n);
+}
+
+
+
+static inline void lio_binwriter_put_s16(LioBinWriter* const pWriter, const int16_t n)
+{
+    lio_binwriter_put_u16(pWriter, (uint16_t)n);
+}
+
+
+
+static inline void lio_binwriter_put_s32(LioBinWriter* const pWriter, const int32_t n)
+{
+    lio_binwriter_put_u32(pWriter, (uint32_t)n);
+}
+
+
+
+static inline void lio_binwriter_put_s64(LioBinWriter* const pWriter, const int64_t n)
+{
+    lio_binwriter_put_u64(pWriter, (uint64_t)n);
+}
+
+
+
+static inline void lio_binwriter_put_f(LioBinWriter* const pWriter, const float f)
+{
+    uint32_t n;
+    memcpy(&n, &f, sizeof(n));
+    lio_binwriter_put_u32(pWriter, n);
+}
+
+
+
+static inline void lio_binwriter_put_d(LioBinWriter* const pWriter, const double d)
+{
+    uint64_t n;
+    memcpy(&n, &d, sizeof(n));
+    lio_binwriter_put_u64(pWriter, n);
+}
+
+
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* LIGHT_IO_BINIO_H */
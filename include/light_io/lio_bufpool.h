@@ -0,0 +1,171 @@
+
+#ifndef LIGHT_IO_BUFPOOL_H
+#define LIGHT_IO_BUFPOOL_H
+
+#include <stddef.h> // size_t
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+
+/**
+ * @brief Limits used when allocating buffer pools.
+ */
+enum LioBufferPoolLimits
+{
+    LIO_BUFFER_POOL_ALIGNMENT           = 4096,        // Satisfies O_DIRECT on common block devices
+    LIO_BUFFER_POOL_HUGE_PAGE_SIZE      = 2*1024*1024, // 2MB
+    LIO_BUFFER_POOL_DEFAULT_BUFFER_SIZE = 1024*1024,   // 1MB
+    LIO_BUFFER_POOL_DEFAULT_COUNT       = 16
+};
+
+
+
+/**
+ * @brief Flags which control how the memory of a buffer pool is allocated.
+ */
+enum LioBufferPoolFlags
+{
+    LIO_BUFFER_POOL_DEFAULT    = 0x00, // Page-aligned memory
+    LIO_BUFFER_POOL_HUGE_PAGES = 0x01  // Try MAP_HUGETLB, then transparent huge pages
+};
+
+
+
+/**
+ * @brief A thread-safe pool of fixed-size, aligned I/O buffers.
+ *
+ * All buffers live in a single contiguous mapping which is allocated once.
+ * Buffers can be acquired and released from any thread, allowing concurrent
+ * copies to share a bounded amount of memory without allocating per-call.
+ *
+ * (*NIX only)
+ */
+typedef struct LioBufferPool LioBufferPool;
+
+
+
+/**
+ * @brief Allocate a pool of aligned buffers.
+ *
+ * @param bufferSize
+ * The size, in bytes, of each buffer. This will be rounded up to a multiple
+ * of LIO_BUFFER_POOL_ALIGNMENT.
+ *
+ * @param numBuffers
+ * The number of buffers which can be acquired at once.
+ *
+ * @param flags
+ * A bitwise combination of values from the LioBufferPoolFlags enumeration.
+ * Huge pages are only a request, regular pages are used if none are
+ * available.
+ *
+ * @return A pointer to a new buffer pool, or NULL if an error occurred. The
+ * pool must be freed with "lio_bufpool_destroy()".
+ */
+LioBufferPool* lio_bufpool_create(
+    const size_t bufferSize,
+    const unsigned numBuffers,
+    const unsigned flags);
+
+
+
+/**
+ * @brief Release a buffer pool and all of its memory.
+ *
+ * All buffers must have been returned to the pool before it is destroyed.
+ *
+ * @param pPool
+ * A pointer to a buffer pool which was returned from "lio_bufpool_create()".
+ */
+void lio_bufpool_destroy(LioBufferPool* const pPool);
+
+
+
+/**
+ * @brief Retrieve the process-wide buffer pool used by the file functions.
+ *
+ * The shared pool is created on first use and lives until the process exits.
+ * It must not be passed to "lio_bufpool_destroy()".
+ *
+ * @return A pointer to the shared buffer pool, or NULL if it could not be
+ * allocated.
+ */
+LioBufferPool* lio_bufpool_shared(void);
+
+
+
+/**
+ * @brief Take a buffer from a pool, waiting until one becomes available.
+ *
+ * There is no timeout. A thread which already holds every buffer of a pool
+ * will wait forever, so callers which cannot wait for another thread to
+ * release a buffer should use "lio_bufpool_try_acquire()" instead.
+ *
+ * @param pPool
+ * A pointer to a valid buffer pool.
+ *
+ * @return A pointer to an aligned buffer of "lio_bufpool_buffer_size()" bytes.
+ */
+void* lio_bufpool_acquire(LioBufferPool* const pPool);
+
+
+
+/**
+ * @brief Take a buffer from a pool without waiting.
+ *
+ * @param pPool
+ * A pointer to a valid buffer pool.
+ *
+ * @return A pointer to an aligned buffer, or NULL if all buffers are in use.
+ */
+void* lio_bufpool_try_acquire(LioBufferPool* const pPool);
+
+
+
+/**
+ * @brief Return a buffer to the pool it was acquired from.
+ *
+ * @param pPool
+ * The pool which the buffer was acquired from.
+ *
+ * @param pBuffer
+ * A pointer to a buffer returned by one of the acquire functions.
+ */
+void lio_bufpool_release(LioBufferPool* const pPool, void* const pBuffer);
+
+
+
+/**
+ * @brief Retrieve the size of each buffer in a pool.
+ *
+ * @param pPool
+ * A pointer to a valid buffer pool.
+ *
+ * @return The number of bytes available in each buffer.
+ */
+size_t lio_bufpool_buffer_size(const LioBufferPool* const pPool);
+
+
+
+/**
+ * @brief Determine if a pool's memory is backed by huge pages.
+ *
+ * @param pPool
+ * A pointer to a valid buffer pool.
+ *
+ * @return TRUE if the pool was allocated with MAP_HUGETLB or was advised to
+ * use transparent huge pages, FALSE if not.
+ */
+bool lio_bufpool_is_huge(const LioBufferPool* const pPool);
+
+
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* LIGHT_IO_BUFPOOL_H */
@@ -0,0 +1,366 @@
+
+#ifndef LIGHT_IO_DIRCACHE_H
+#define LIGHT_IO_DIRCACHE_H
+
+#include <stdbool.h>
+#include <stddef.h> // size_t
+#include <stdint.h> // uint64_t, int64_t
+
+#include "light_io/lio_arena.h"
+#include "light_io/lio_paths.h"
+#include "light_io/lio_strbuf.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+
+enum LioDirCacheLimits
+{
+    LIO_DIRCACHE_RACY_NSEC = 100000000 // Folders modified this close to their scan are always rescanned
+};
+
+
+
+/**
+ * @brief A single entry within a cached folder. Entries are sorted by name.
+ *
+ * This is also the on-disk layout of a snapshot, which is used in place.
+ */
+typedef struct LioDirCacheEntry
+{
+    uint64_t nameOffset; // Offset of the NULL-terminated name in the listing's names
+    uint64_t size;
+    uint64_t inode;
+    int64_t modifiedTime; // Nanoseconds since the UNIX epoch
+    uint32_t nameLength;
+    uint32_t type; // An "enum LioPathType": REGULAR, FOLDER, LINK, or FILE for other types
+} LioDirCacheEntry;
+
+
+
+/**
+ * @brief A cached folder, and the state it was in when it was scanned.
+ *
+ * This is also the on-disk layout of a snapshot, which is used in place.
+ */
+typedef struct LioDirCacheFolder
+{
+    uint64_t pathOffset;
+    uint64_t pathLength;
+    uint64_t firstEntry;
+    uint64_t numEntries;
+    uint64_t inode;
+    int64_t modifiedTime; // Nanoseconds since the UNIX epoch
+    int64_t changedTime; // Nanoseconds since the UNIX epoch
+    int64_t scannedTime; // Nanoseconds since the UNIX epoch
+} LioDirCacheFolder;
+
+
+
+/**
+ * @brief The contents of a cached folder.
+ *
+ * Listings point directly into the cache and remain valid until the cache is
+ * closed.
+ */
+typedef struct LioDirListing
+{
+    const LioDirCacheEntry* pEntries;
+    size_t numEntries;
+    const char* pNames;
+} LioDirListing;
+
+
+
+/**
+ * @brief A cache of directory listings and file metadata, backed by a
+ * memory-mapped snapshot.
+ *
+ * Opening a snapshot only maps it, so startup costs the same regardless of
+ * the size of the tree. Each folder is checked against the disk the first
+ * time it is listed. Folders whose modification time, change time, or inode
+ * differ from the snapshot are rescanned into memory, and everything else is
+ * served straight from the mapping.
+ *
+ * Only folders are validated. The size and modification time of a file are
+ * those recorded when its folder was last scanned.
+ */
+typedef struct LioDirCache
+{
+    const void* pMapping;
+    size_t mappingSize;
+    const LioDirCacheFolder* pFolders; // Sorted by path
+    size_t numFolders;
+    const LioDirCacheEntry* pEntries;
+    const char* pNames;
+    size_t namesSize;
+
+    unsigned char* pStates; // Validation state of each mapped folder
+    struct LioDirCacheOverlay** ppOverlays; // Rescanned listings of mapped folders
+
+    struct LioDirCacheOverlay** ppExtras; // Folders which are not in the snapshot
+    size_t numExtras;
+    size_t extraCapacity;
+    uint32_t* pExtraSlots; // Hash table of indices into "ppExtras"
+    size_t extraSlotCapacity;
+
+    LioArena arena;
+    LioStrBuf root;
+} LioDirCache;
+
+
+
+/**
+ * @brief Initialize an empty cache for a folder. Folders are scanned as they
+ * are listed.
+ *
+ * @param pCache
+ * A pointer to the cache to initialize.
+ *
+ * @param rootDir
+ * The folder which the cache covers. It is resolved to an absolute path.
+ *
+ * @return TRUE if the cache was initialized, FALSE if not.
+ */
+bool lio_dircache_init(LioDirCache* const pCache, const char* const rootDir);
+
+
+
+/**
+ * @brief Initialize a cache and scan every folder beneath a root folder.
+ * Symbolic links are not followed.
+ *
+ * @param pCache
+ * A pointer to the cache to initialize.
+ *
+ * @param rootDir
+ * The folder to scan. It is resolved to an absolute path.
+ *
+ * @return TRUE if the cache was built, FALSE if not. The cache does not need
+ * to be closed if this function fails.
+ */
+bool lio_dircache_build(LioDirCache* const pCache, const char* const rootDir);
+
+
+
+/**
+ * @brief Open a snapshot written by "lio_dircache_save()".
+ *
+ * The snapshot is memory-mapped and its folders are not checked until they
+ * are used.
+ *
+ * @param pCache
+ * A pointer to the cache to initialize.
+ *
+ * @param snapshotPath
+ * The path to a snapshot file.
+ *
+ * @return TRUE if the snapshot was opened, FALSE if it could not be read or
+ * was written by an incompatible version or machine. The cache does not need
+ * to be closed if this function fails.
+ */
+bool lio_dircache_open(LioDirCache* const pCache, const char* const snapshotPath);
+
+
+
+/**
+ * @brief Release all resources used by a cache, invalidating all listings.
+ *
+ * @param pCache
+ * A pointer to an initialized cache.
+ */
+void lio_dircache_close(LioDirCache* const pCache);
+
+
+
+/**
+ * @brief Write every folder in a cache to a snapshot file.
+ *
+ * Folders which were rescanned are written with their new contents, so saving
+ * after a refresh only costs the scans of the folders which changed.
+ *
+ * @param pCache
+ * A pointer to an initialized cache.
+ *
+ * @param snapshotPath
+ * The file to write. It is replaced if it already exists, but must not be
+ * the snapshot which the cache is mapping.
+ *
+ * @return TRUE if the snapshot was saved, FALSE if not.
+ */
+bool lio_dircache_save(const LioDirCache* const pCache, const char* const snapshotPath);
+
+
+
+/**
+ * @brief List a folder, validating it against the disk the first time it is
+ * used.
+ *
+ * @param pCache
+ * A pointer to an initialized cache.
+ *
+ * @param dirPath
+ * The absolute path of a folder beneath the cache's root. Trailing separators
+ * are ignored.
+ *
+ * @param pOutListing
+ * Set to the folder's contents, sorted by name.
+ *
+ * @return TRUE if the folder was listed, FALSE if it is outside of the cache's
+ * root or does not exist.
+ */
+bool lio_dircache_list(LioDirCache* const pCache, const char* const dirPath, LioDirListing* const pOutListing);
+
+
+
+/**
+ * @brief Look up the metadata of a path from its folder's listing.
+ *
+ * @param pCache
+ * A pointer to an initialized cache.
+ *
+ * @param path
+ * The absolute path of a file or folder beneath the cache's root.
+ *
+ * @param pOutEntry
+ * Set to the path's entry. Its name offset is not meaningful.
+ *
+ * @return TRUE if the path was found, FALSE if not.
+ */
+bool lio_dircache_stat(LioDirCache* const pCache, const char* const path, LioDirCacheEntry* const pOutEntry);
+
+
+
+/**
+ * @brief Replace a folder's cached listing.
+ *
+ * @param pCache
+ * A pointer to an initialized cache.
+ *
+ * @param pFolder
+ * The folder's state. Its inode, times, and number of entries are used, and
+ * its offsets are ignored.
+ *
+ * @param pPath
+ * The folder's path, which must not end in a separator.
+ *
+ * @param pEntries
+ * The folder's entries, in any order. Names are located with each entry's
+ * "nameOffset" into "pNames."
+ *
+ * @param pNames
+ * The NULL-terminated names of each entry.
+ *
+ * @param pOutListing
+ * Optional. Set to the folder's new contents.
+ *
+ * @return TRUE if the listing was replaced, FALSE if memory could not be
+ * allocated.
+ */
+bool lio_dircache_insert(
+    LioDirCache* const pCache,
+    const LioDirCacheFolder* const pFolder,
+    const char* const pPath,
+    const LioDirCacheEntry* const pEntries,
+    const char* const pNames,
+    LioDirListing* const pOutListing);
+
+
+
+/**
+ * @brief Read a folder from the disk, replacing its cached listing.
+ *
+ * @param pCache
+ * A pointer to an initialized cache.
+ *
+ * @param dirPath
+ * The path of a folder beneath the cache's root, which must not end in a
+ * separator.
+ *
+ * @param pOutListing
+ * Optional. Set to the folder's new contents.
+ *
+ * @return TRUE if the folder was read, FALSE if not.
+ */
+bool lio_dircache_rescan(LioDirCache* const pCache, const char* const dirPath, LioDirListing* const pOutListing);
+
+
+
+/**
+ * @brief Read a folder's entries from the disk without caching them.
+ *
+ * @param dirPath
+ * The folder's path.
+ *
+ * @param pOutFolder
+ * Set to the folder's current state. Its offsets are zero.
+ *
+ * @param pOutListing
+ * Set to the folder's contents, sorted by name. It must be released with
+ * "lio_dirlisting_free()".
+ *
+ * @return TRUE if the folder was read, FALSE if not.
+ */
+bool lio_dircache_read_folder(const char* const dirPath, LioDirCacheFolder* const pOutFolder, LioDirListing* const pOutListing);
+
+
+
+/**
+ * @brief Determine if a folder on disk still matches a cached record.
+ *
+ * @param dirPath
+ * The folder's path.
+ *
+ * @param pFolder
+ * The cached state of the folder.
+ *
+ * @return TRUE if the folder is unchanged, FALSE if it changed, was removed,
+ * or was modified too close to its scan to be trusted.
+ */
+bool lio_dircache_is_current(const char* const dirPath, const LioDirCacheFolder* const pFolder);
+
+
+
+/**
+ * @brief Sort entries by name.
+ *
+ * @param pEntries
+ * The entries to sort.
+ *
+ * @param numEntries
+ * The number of entries in "pEntries".
+ *
+ * @param pNames
+ * The names which each entry's "nameOffset" refers to.
+ */
+void lio_dirlisting_sort(LioDirCacheEntry* const pEntries, const size_t numEntries, const char* const pNames);
+
+
+
+/**
+ * @brief Release a listing returned from "lio_dircache_read_folder()".
+ *
+ * @param pListing
+ * A pointer to the listing, which is left empty.
+ */
+void lio_dirlisting_free(LioDirListing* const pListing);
+
+
+
+/**
+ * @brief Retrieve the name of an entry in a listing.
+ */
+static inline const char* lio_dirlisting_name(const LioDirListing* const pListing, const size_t index)
+{
+    return pListing->pNames + pListing->pEntries[index].nameOffset;
+}
+
+
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* LIGHT_IO_DIRCACHE_H */
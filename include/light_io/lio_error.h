@@ -0,0 +1,207 @@
+
+#ifndef LIGHT_IO_ERROR_H
+#define LIGHT_IO_ERROR_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+
+/**
+ * @brief Categories of failures reported by light_io.
+ */
+enum LioErrorCode
+{
+    LIO_ERROR_NONE = 0,
+    LIO_ERROR_INVALID_ARGUMENT,  // A NULL, empty, or out-of-range parameter
+    LIO_ERROR_NOT_FOUND,         // A path does not exist
+    LIO_ERROR_ALREADY_EXISTS,    // A path exists and would not be replaced
+    LIO_ERROR_PERMISSION_DENIED,
+    LIO_ERROR_NOT_A_FOLDER,      // A folder was expected
+    LIO_ERROR_NOT_A_FILE,        // A file was expected
+    LIO_ERROR_FOLDER_NOT_EMPTY,
+    LIO_ERROR_NO_SPACE,          // The device is full
+    LIO_ERROR_OUT_OF_MEMORY,
+    LIO_ERROR_LIMIT_EXCEEDED,    // A path, count, or size is larger than supported
+    LIO_ERROR_CORRUPT,           // A file's contents are invalid or truncated
+    LIO_ERROR_IO                 // Any other failure from the operating system
+};
+
+
+
+/**
+ * @brief Limits of the error record.
+ */
+enum LioErrorLimits
+{
+    LIO_ERROR_MAX_PATH = 512 // Longer paths are truncated in the error record
+};
+
+
+
+/**
+ * @brief The most recent failure on a thread.
+ *
+ * Records live in thread-local storage, so reporting an error never
+ * allocates, locks, or prints anything.
+ */
+typedef struct LioError
+{
+    enum LioErrorCode code;
+    int sysError; // "errno", or 0 if the failure did not come from the system
+    const char* pMessage; // A static description of the operation which failed
+    char path[LIO_ERROR_MAX_PATH]; // Empty if no path was involved
+    char otherPath[LIO_ERROR_MAX_PATH]; // The second path of a copy or move, or empty
+} LioError;
+
+
+
+/**
+ * @brief Receives every error reported on any thread.
+ *
+ * @param pError
+ * The error, which is the calling thread's "lio_error_last()".
+ *
+ * @param pUserData
+ * The pointer passed to "lio_error_set_sink()".
+ */
+typedef void (*LioErrorSink)(const LioError* const pError, void* const pUserData);
+
+
+
+/**
+ * @brief Retrieve the last error reported on the calling thread.
+ *
+ * Errors are not cleared by successful calls. Use "lio_error_clear()" before
+ * a call to tell if it failed.
+ *
+ * @return A pointer to the calling thread's error record. Its code is
+ * LIO_ERROR_NONE if nothing has failed.
+ */
+const LioError* lio_error_last(void);
+
+
+
+/**
+ * @brief Reset the calling thread's error record to LIO_ERROR_NONE.
+ */
+void lio_error_clear(void);
+
+
+
+/**
+ * @brief Install a callback which is invoked each time an error is reported.
+ *
+ * Errors are silent by default. The sink is called on the thread where the
+ * error occurred, and must be installed before other threads use light_io.
+ *
+ * @param sink
+ * The callback, or NULL to remove it.
+ *
+ * @param pUserData
+ * Passed to the callback.
+ */
+void lio_error_set_sink(LioErrorSink sink, void* const pUserData);
+
+
+
+/**
+ * @brief A sink which prints each error on its own line.
+ *
+ * @param pError
+ * The error to print.
+ *
+ * @param pUserData
+ * A "FILE*" to print to, or NULL for stderr.
+ */
+void lio_error_print(const LioError* const pError, void* const pUserData);
+
+
+
+/**
+ * @brief Retrieve the name of an error code.
+ *
+ * @param code
+ * An error code.
+ *
+ * @return A static string such as "LIO_ERROR_NOT_FOUND".
+ */
+const char* lio_error_name(const enum LioErrorCode code);
+
+
+
+/**
+ * @brief Convert an "errno" value to an error code.
+ *
+ * @param sysError
+ * An "errno" value.
+ *
+ * @return The closest error code, or LIO_ERROR_IO.
+ */
+enum LioErrorCode lio_error_from_errno(const int sysError);
+
+
+
+/**
+ * @brief Record an error on the calling thread and pass it to the sink.
+ *
+ * This is used by every function in light_io which fails.
+ *
+ * @param code
+ * The category of the error.
+ *
+ * @param sysError
+ * The "errno" value of the failure, or 0.
+ *
+ * @param pMessage
+ * A description of the failure. This must be a string literal, or otherwise
+ * outlive the record.
+ *
+ * @param pPath
+ * Optional. The path involved.
+ *
+ * @param pOtherPath
+ * Optional. A second path involved.
+ */
+void lio_error_report(
+    const enum LioErrorCode code,
+    const int sysError,
+    const char* const pMessage,
+    const char* const pPath,
+    const char* const pOtherPath);
+
+
+
+/**
+ * @brief Record an error from the operating system, deriving its code from
+ * "errno".
+ *
+ * @param sysError
+ * The "errno" value of the failure.
+ *
+ * @param pMessage
+ * A description of the failure, which must outlive the record.
+ *
+ * @param pPath
+ * Optional. The path involved.
+ *
+ * @param pOtherPath
+ * Optional. A second path involved.
+ */
+static inline void lio_error_report_errno(
+    const int sysError,
+    const char* const pMessage,
+    const char* const pPath,
+    const char* const pOtherPath)
+{
+    lio_error_report(lio_error_from_errno(sysError), sysError, pMessage, pPath, pOtherPath);
+}
+
+
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* LIGHT_IO_ERROR_H */
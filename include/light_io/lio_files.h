@@ -3,6 +3,12 @@
 #define LIGHT_IO_FILE_IO_H
 
 #include <stdbool.h>
+#include <stddef.h> // size_t
+#include <stdint.h> // fixed-width integers
+
+#include "light_io/lio_paths.h"
+
+#include "light_io/lio_bufpool.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -12,11 +18,331 @@ extern "C" {
 
 enum LioFileLimitsType
 {
-    LIO_FILE_DEFAULT_CHUNK_SIZE = 4096 // KB
+    LIO_FILE_DEFAULT_CHUNK_SIZE = 4096, // KB
+    LIO_FILE_BACKGROUND_CHUNK_SIZE = 1024*1024, // 1MB
+    LIO_FILE_BACKGROUND_WINDOW_SIZE = 8*1024*1024, // 8MB
+    LIO_FILE_SPLICE_CHUNK_SIZE = 64*1024*1024, // 64MB per in-kernel transfer
+    LIO_FILE_SPLIT_MAX_THREADS = 16,
+    LIO_FILE_CONCAT_BATCH_SIZE = 64 // Input files held open at once by lio_file_concat_many()
+};
+
+
+
+/**
+ * @brief Flags which can be used to alter the behavior of file copies.
+ */
+enum LioFileCopyFlags
+{
+    LIO_FILE_COPY_DEFAULT    = 0x00, // Buffered copy, fail if the destination exists
+    LIO_FILE_COPY_OVERWRITE  = 0x01, // Replace existing files at the destination
+    LIO_FILE_COPY_BACKGROUND = 0x02, // Try to leave the page cache as it was found
+    LIO_FILE_COPY_DIRECT     = 0x04, // Bypass the page cache with O_DIRECT where supported
+    LIO_FILE_COPY_ATOMIC     = 0x08  // Replace the destination in one step, once its data is durable
 };
 
 
 
+/**
+ * @brief Flags which determine how a file handle is opened.
+ */
+enum LioFileOpenFlags
+{
+    LIO_FILE_OPEN_READ      = 0x01,
+    LIO_FILE_OPEN_WRITE     = 0x02,
+    LIO_FILE_OPEN_CREATE    = 0x04, // Create the file if it does not exist
+    LIO_FILE_OPEN_TRUNCATE  = 0x08, // Discard existing contents when writing
+    LIO_FILE_OPEN_APPEND    = 0x10, // All writes go to the end of the file
+    LIO_FILE_OPEN_EXCLUSIVE = 0x20  // Fail if the file already exists
+};
+
+
+
+/**
+ * @brief A handle to an open file.
+ *
+ * File handles wrap an operating system file descriptor so that files which
+ * are already open (temporary files, pipes, sockets) can be used with the
+ * library without being closed and reopened by path.
+ */
+typedef struct LioFile
+{
+    int fd;
+    bool owned; // Determines if "lio_file_close()" closes the descriptor
+} LioFile;
+
+
+
+/**
+ * @brief Metadata which describes an open file.
+ */
+typedef struct LioFileStat
+{
+    uint64_t size;
+    uint64_t inode;
+    int64_t modifiedTime; // Seconds since the UNIX epoch
+    uint32_t permissions;
+    enum LioPathType type; // REGULAR, FOLDER, LINK, or FILE for other file types
+} LioFileStat;
+
+
+
+/**
+ * @brief A file being written in place of another, see
+ * "lio_file_atomic_open()".
+ */
+typedef struct LioFileAtomic
+{
+    LioFile file; // Receives the new contents
+    char* pPath; // Where the contents will be published
+    char* pTempPath; // Hidden name of the new contents, or NULL while they have none
+    bool overwrite;
+} LioFileAtomic;
+
+
+
+/**
+ * @brief A group of atomic writes which are made durable together.
+ */
+typedef struct LioFileBatchEntry
+{
+    char* pTempPath;
+    char* pPath;
+    uint64_t device; // Filesystems are synchronized once each
+    bool overwrite;
+} LioFileBatchEntry;
+
+
+
+typedef struct LioFileBatch
+{
+    LioFileBatchEntry* pEntries;
+    size_t numEntries;
+    size_t capacity;
+} LioFileBatch;
+
+
+
+/**
+ * @brief Open a file.
+ *
+ * @param pFile
+ * A pointer to the file handle which will be initialized.
+ *
+ * @param path
+ * The path to a file on the local filesystem.
+ *
+ * @param flags
+ * A bitwise combination of values from the LioFileOpenFlags enumeration.
+ *
+ * @return TRUE if the file was opened, FALSE if not.
+ */
+bool lio_file_open(LioFile* const pFile, const char* const path, const unsigned flags);
+
+
+
+/**
+ * @brief Create a file handle for an existing file descriptor.
+ *
+ * @param fd
+ * An open file descriptor. The caller retains ownership of the descriptor and
+ * it will not be closed by "lio_file_close()".
+ *
+ * @return A file handle which refers to "fd".
+ */
+LioFile lio_file_wrap(const int fd);
+
+
+
+/**
+ * @brief Close a file handle.
+ *
+ * @param pFile
+ * A pointer to a file handle. The handle is invalidated regardless of whether
+ * or not its descriptor is owned.
+ *
+ * @return TRUE if the file was closed without error, FALSE if not.
+ */
+bool lio_file_close(LioFile* const pFile);
+
+
+
+/**
+ * @brief Retrieve metadata about an open file.
+ *
+ * @param pFile
+ * A pointer to an open file handle.
+ *
+ * @param pOutStat
+ * A pointer to a structure which will contain the file's metadata.
+ *
+ * @return TRUE if the metadata could be retrieved, FALSE if not.
+ */
+bool lio_file_stat(const LioFile* const pFile, LioFileStat* const pOutStat);
+
+
+
+/**
+ * @brief Reserve disk space for a file without changing its size.
+ *
+ * @param pFile
+ * A pointer to a file handle which is open for writing.
+ *
+ * @param offset
+ * The byte offset where the reservation begins.
+ *
+ * @param numBytes
+ * The number of bytes to reserve.
+ *
+ * @return TRUE if space was reserved, FALSE if not or if the filesystem does
+ * not support preallocation.
+ */
+bool lio_file_preallocate(const LioFile* const pFile, const uint64_t offset, const uint64_t numBytes);
+
+
+
+/**
+ * @brief Copy the remaining contents of one open file into another.
+ *
+ * Data is read from the source's current position until the end of the file
+ * and written at the destination's current position. Both positions are
+ * advanced by the number of bytes copied.
+ *
+ * @param pFrom
+ * A file handle which is open for reading.
+ *
+ * @param pTo
+ * A file handle which is open for writing.
+ *
+ * @param flags
+ * A bitwise combination of LIO_FILE_COPY_BACKGROUND and LIO_FILE_COPY_DIRECT.
+ * Other flags are ignored.
+ *
+ * @param pPool
+ * The buffer pool to transfer data with. The shared pool from
+ * "lio_bufpool_shared()" is used if this is NULL.
+ *
+ * @return TRUE if the data was copied, FALSE if not.
+ */
+bool lio_file_copy_fd(
+    const LioFile* const pFrom,
+    const LioFile* const pTo,
+    const unsigned flags,
+    LioBufferPool* const pPool);
+
+
+
+/**
+ * @brief Append the contents of several open files to another file.
+ *
+ * The destination is preallocated to the combined size of all inputs, then
+ * each input is copied in its entirety, in order, at the destination's
+ * current position.
+ *
+ * @param pInFiles
+ * An array of file handles which are open for reading.
+ *
+ * @param numInFiles
+ * The number of handles in "pInFiles".
+ *
+ * @param pOutFile
+ * A file handle which is open for writing.
+ *
+ * @return TRUE if all files were concatenated, FALSE if not.
+ */
+bool lio_file_concat_fd(
+    const LioFile* const pInFiles,
+    const unsigned numInFiles,
+    const LioFile* const pOutFile);
+
+
+
+/**
+ * @brief Read data from the current position of an open file.
+ *
+ * @param pFile
+ * A file handle which is open for reading.
+ *
+ * @param pData
+ * A pointer to a buffer which will contain the data read.
+ *
+ * @param numBytes
+ * The maximum number of bytes to read.
+ *
+ * @return The number of bytes read, which is less than "numBytes" only at the
+ * end of a file or stream. -1 is returned if an error occurred.
+ */
+long long lio_file_read(const LioFile* const pFile, void* const pData, const size_t numBytes);
+
+
+
+/**
+ * @brief Write an entire buffer to the current position of an open file.
+ *
+ * @param pFile
+ * A file handle which is open for writing.
+ *
+ * @param pData
+ * A pointer to the data to write.
+ *
+ * @param numBytes
+ * The number of bytes to write.
+ *
+ * @return TRUE if all bytes were written, FALSE if not.
+ */
+bool lio_file_write(const LioFile* const pFile, const void* const pData, const size_t numBytes);
+
+
+
+/**
+ * @brief Map the entire contents of a file into memory for reading.
+ *
+ * @param pFile
+ * A file handle which is open for reading.
+ *
+ * @param pOutNumBytes
+ * A pointer to a size_t which will contain the size of the mapping.
+ *
+ * @return A pointer to the read-only file contents, or NULL if an error
+ * occurred or the file is empty. The mapping must be released with
+ * "lio_file_unmap()". It remains valid after the file is closed.
+ */
+const void* lio_file_map(const LioFile* const pFile, size_t* const pOutNumBytes);
+
+
+
+/**
+ * @brief Release a mapping returned from "lio_file_map()".
+ *
+ * @param pData
+ * A pointer returned from "lio_file_map()".
+ *
+ * @param numBytes
+ * The size of the mapping.
+ */
+void lio_file_unmap(const void* const pData, const size_t numBytes);
+
+
+
+/**
+ * @brief Read the entire contents of a file into memory.
+ *
+ * Regular files are read from the beginning without moving the file
+ * position. Pipes and other streams are read until they are closed.
+ *
+ * @param pFile
+ * A file handle which is open for reading.
+ *
+ * @param pOutNumBytes
+ * A pointer to a size_t which will contain the number of bytes read.
+ *
+ * @return A dynamically allocated, NULL-terminated buffer which contains the
+ * file data, or NULL if an error occurred. The buffer must be freed with
+ * "lio_utils_str_destroy()".
+ */
+char* lio_file_read_all(const LioFile* const pFile, size_t* const pOutNumBytes);
+
+
+
 bool lio_file_copy(
     const char* const pFrom,
     const char* const pTo,
@@ -24,6 +350,73 @@ bool lio_file_copy(
 
 
 
+/**
+ * @brief Copy a file using a set of flags to control how data is transferred.
+ *
+ * When LIO_FILE_COPY_BACKGROUND is set, the source file is read sequentially,
+ * the destination is preallocated, and written regions are flushed and then
+ * evicted from the page cache as the copy progresses. This keeps large bulk
+ * copies from pushing the working set of other processes out of memory. The
+ * flag is only a hint on platforms which do not support cache advice.
+ *
+ * When LIO_FILE_COPY_DIRECT is set, data is transferred with O_DIRECT using
+ * aligned buffers from the shared buffer pool so it is only copied once, by
+ * the device. Copies fall back to buffered I/O if the filesystem rejects
+ * O_DIRECT. A direct copy waits, without a timeout, until a buffer of the
+ * shared pool is free. Buffers the caller holds from "lio_bufpool_shared()"
+ * count against the pool, so a thread holding all of them must not start a
+ * direct copy.
+ *
+ * When LIO_FILE_COPY_ATOMIC is set, the copy is written as described by
+ * "lio_file_atomic_open()" and only replaces "pTo" once it is durable.
+ *
+ * @param pFrom
+ * A path to the file which should be copied.
+ *
+ * @param pTo
+ * A path to the location where the file should be copied to.
+ *
+ * @param flags
+ * A bitwise combination of values from the LioFileCopyFlags enumeration.
+ *
+ * @return TRUE if the file was copied, FALSE if not.
+ */
+bool lio_file_copy_ex(
+    const char* const pFrom,
+    const char* const pTo,
+    const unsigned flags);
+
+
+
+/**
+ * @brief Copy a file using buffers from a specific buffer pool.
+ *
+ * This function behaves like "lio_file_copy_ex()" but allows callers to bound
+ * the memory used by concurrent copies with their own pool.
+ *
+ * @param pFrom
+ * A path to the file which should be copied.
+ *
+ * @param pTo
+ * A path to the location where the file should be copied to.
+ *
+ * @param flags
+ * A bitwise combination of values from the LioFileCopyFlags enumeration.
+ *
+ * @param pPool
+ * The buffer pool to transfer data with. The shared pool from
+ * "lio_bufpool_shared()" is used if this is NULL.
+ *
+ * @return TRUE if the file was copied, FALSE if not.
+ */
+bool lio_file_copy_pooled(
+    const char* const pFrom,
+    const char* const pTo,
+    const unsigned flags,
+    LioBufferPool* const pPool);
+
+
+
 bool lio_file_concat(
     const char* const fileA,
     const char* const fileB,
@@ -32,6 +425,248 @@ bool lio_file_concat(
 
 
 
+/**
+ * @brief Concatenate any number of files into a single output file.
+ *
+ * The output file is opened once and each input is opened exactly once, in
+ * batches of LIO_FILE_CONCAT_BATCH_SIZE. The output is preallocated to the
+ * combined size of each batch and, on Linux, each input is appended at an
+ * explicit offset with copy_file_range() (or splice() when that is
+ * unsupported), so file data never passes through user-space.
+ *
+ * @param pInFiles
+ * An array of paths to the files which should be concatenated, in order.
+ *
+ * @param numInFiles
+ * The number of paths in "pInFiles".
+ *
+ * @param outFile
+ * A path to the file which will contain the concatenated data.
+ *
+ * @param overwrite
+ * Replace the output file if it already exists.
+ *
+ * @return TRUE if all files were concatenated, FALSE if not. The output file
+ * is removed if an error occurs.
+ */
+bool lio_file_concat_many(
+    const char* const* const pInFiles,
+    const unsigned numInFiles,
+    const char* const outFile,
+    const bool overwrite);
+
+
+
+/**
+ * @brief Concatenate any number of files using a set of flags to control how
+ * the output is written.
+ *
+ * This function behaves like "lio_file_concat_many()". When
+ * LIO_FILE_COPY_ATOMIC is set, the output is built under a hidden name and
+ * only replaces "outFile" once all of its data is durable, so readers see
+ * either the old file or the complete new one.
+ *
+ * @param flags
+ * A bitwise combination of LIO_FILE_COPY_OVERWRITE and LIO_FILE_COPY_ATOMIC.
+ * Other flags are ignored.
+ *
+ * @return TRUE if all files were concatenated, FALSE if not.
+ */
+bool lio_file_concat_ex(
+    const char* const* const pInFiles,
+    const unsigned numInFiles,
+    const char* const outFile,
+    const unsigned flags);
+
+
+
+/*-----------------------------------------------------------------------------
+ * Atomic, durable writes
+ *
+ * New contents are written to a file with no name (O_TMPFILE on Linux) or a
+ * hidden name beside the destination, synchronized to storage, and then
+ * renamed or linked into place before the folder itself is synchronized. A
+ * crash leaves either the old file or the complete new one, never a torn
+ * mix of both.
+ *
+ * Each commit normally waits for two flushes of its own. Commits added to a
+ * LioFileBatch instead wait for "lio_file_batch_commit()", which flushes each
+ * filesystem once for the whole batch, so thousands of small files share a
+ * single barrier.
+-----------------------------------------------------------------------------*/
+/**
+ * @brief Begin writing new contents for a file.
+ *
+ * @param pAtomic
+ * A pointer to the state which will be initialized. Data should be written
+ * to "pAtomic->file", then published with "lio_file_atomic_commit()" or
+ * discarded with "lio_file_atomic_abort()".
+ *
+ * @param pPath
+ * The file which will be created or replaced.
+ *
+ * @param flags
+ * LIO_FILE_COPY_OVERWRITE to replace an existing file, otherwise the commit
+ * fails if "pPath" exists by then. Other flags are ignored. On *NIX, the new
+ * contents of a replaced file keep its permissions, and its owner if the
+ * process is allowed to set it.
+ *
+ * @return TRUE if the new contents can be written, FALSE if not.
+ */
+bool lio_file_atomic_open(LioFileAtomic* const pAtomic, const char* const pPath, const unsigned flags);
+
+
+
+/**
+ * @brief Publish the contents written since "lio_file_atomic_open()".
+ *
+ * @param pAtomic
+ * A pointer to an open atomic write. It is closed whether or not the commit
+ * succeeds.
+ *
+ * @param pBatch
+ * NULL to make the file durable before returning. Otherwise the file is
+ * closed and handed to the batch, and is only published by
+ * "lio_file_batch_commit()".
+ *
+ * @return TRUE if the file was published (or added to the batch), FALSE if
+ * not. Nothing is left behind on failure.
+ */
+bool lio_file_atomic_commit(LioFileAtomic* const pAtomic, LioFileBatch* const pBatch);
+
+
+
+/**
+ * @brief Discard an atomic write, leaving the destination untouched.
+ */
+void lio_file_atomic_abort(LioFileAtomic* const pAtomic);
+
+
+
+/**
+ * @brief Atomically create or replace a file with a buffer of data.
+ *
+ * @param pPath
+ * The file which will be created or replaced.
+ *
+ * @param pData
+ * A pointer to the new contents of the file.
+ *
+ * @param numBytes
+ * The number of bytes at "pData".
+ *
+ * @param flags
+ * LIO_FILE_COPY_OVERWRITE to replace an existing file. Other flags are
+ * ignored.
+ *
+ * @param pBatch
+ * NULL to make the file durable before returning, or a batch to publish the
+ * file with.
+ *
+ * @return TRUE if the file was written, FALSE if not.
+ */
+bool lio_file_write_atomic(
+    const char* const pPath,
+    const void* const pData,
+    const size_t numBytes,
+    const unsigned flags,
+    LioFileBatch* const pBatch);
+
+
+
+/**
+ * @brief Initialize an empty batch of atomic writes.
+ */
+void lio_file_batch_init(LioFileBatch* const pBatch);
+
+
+
+/**
+ * @brief Make every file in a batch durable and publish it.
+ *
+ * Each filesystem holding a batched file is flushed once, every file is then
+ * moved into place, and each filesystem is flushed once more so the new
+ * names are durable too. The batch is empty afterwards and can be reused.
+ *
+ * @return TRUE if every file was published, FALSE if any could not be. Files
+ * which could not be published are removed.
+ */
+bool lio_file_batch_commit(LioFileBatch* const pBatch);
+
+
+
+/**
+ * @brief Discard any uncommitted files and release the memory of a batch.
+ */
+void lio_file_batch_terminate(LioFileBatch* const pBatch);
+
+
+
+/**
+ * @brief Determines how "lio_file_split()" divides a file.
+ */
+enum LioFileSplitMode
+{
+    LIO_FILE_SPLIT_COUNT, // Split a file into N parts of (nearly) equal size
+    LIO_FILE_SPLIT_SIZE   // Split a file into parts of N bytes, the last part may be smaller
+};
+
+
+
+/**
+ * @brief Used with "lio_file_split()" to cut files at exact byte offsets.
+ */
+#define LIO_FILE_SPLIT_NO_DELIMITER (-1)
+
+
+
+/**
+ * @brief Split a file into several smaller files.
+ *
+ * Part boundaries are computed up-front and all parts are written
+ * concurrently, each with in-kernel copies from its own offset in the input.
+ * Concatenating the parts in order, such as with "lio_file_concat_many()",
+ * reproduces the input exactly.
+ *
+ * @param inFile
+ * A path to the file which should be split.
+ *
+ * @param outPrefix
+ * The path prefix of each output file. Parts are named "<outPrefix>.0000",
+ * "<outPrefix>.0001", and so on. Existing files are overwritten.
+ *
+ * @param mode
+ * Determines whether "param" is a number of parts or a size in bytes.
+ *
+ * @param param
+ * The number of parts (LIO_FILE_SPLIT_COUNT) or the size of each part
+ * (LIO_FILE_SPLIT_SIZE). Must be greater than 0. Fewer parts are written
+ * if a count is larger than the file's size, since parts are never empty.
+ *
+ * @param delimiter
+ * A byte value (0-255) which terminates records in the input file. Each part
+ * is extended to end just after the next delimiter so no record is divided
+ * between two parts, and empty parts are dropped. Use
+ * LIO_FILE_SPLIT_NO_DELIMITER to cut at exact offsets.
+ *
+ * @param pOutNumParts
+ * A pointer to an unsigned integer which will contain the number of parts
+ * which were written.
+ *
+ * @return An array of paths to each part, in order, which must be freed with
+ * "lio_paths_destroy()". NULL is returned if an error occurred, in which case
+ * no parts are left on the filesystem.
+ */
+char** lio_file_split(
+    const char* const inFile,
+    const char* const outPrefix,
+    const enum LioFileSplitMode mode,
+    const size_t param,
+    const int delimiter,
+    unsigned* const pOutNumParts);
+
+
+
 #ifdef __cplusplus
 } /* extern "C" */
 #endif
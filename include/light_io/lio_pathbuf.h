@@ -0,0 +1,205 @@
+
+#ifndef LIGHT_IO_PATHBUF_H
+#define LIGHT_IO_PATHBUF_H
+
+#include <stdbool.h>
+#include <stddef.h> // size_t
+
+#include "light_io/lio_paths.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+
+enum LioPathBufLimits
+{
+    LIO_PATHBUF_CAPACITY = 4096 // Bytes stored in-place, matching Linux PATH_MAX
+};
+
+
+
+/**
+ * @brief A path which is built in-place.
+ *
+ * Paths shorter than LIO_PATHBUF_CAPACITY live entirely within the structure,
+ * so a path buffer on the stack can be joined, trimmed, and passed to any
+ * function which accepts a path without touching the heap. Longer paths spill
+ * to memory from the library's allocator.
+ *
+ * A path buffer refers to its own storage and must not be copied by
+ * assignment. The contents are always NULL-terminated, so
+ * "lio_pathbuf_cstr()" can be passed to every function in lio_paths.h and
+ * lio_files.h.
+ */
+typedef struct LioPathBuf
+{
+    char* pData; // Points to "inlineData" unless the path has spilled
+    size_t length;
+    size_t capacity;
+    char inlineData[LIO_PATHBUF_CAPACITY];
+} LioPathBuf;
+
+
+
+/**
+ * @brief Initialize an empty path buffer.
+ *
+ * @param pBuf
+ * A pointer to the path buffer to initialize.
+ */
+void lio_pathbuf_init(LioPathBuf* const pBuf);
+
+
+
+/**
+ * @brief Release any heap memory used by a path buffer. The buffer is left
+ * empty and can be reused.
+ *
+ * @param pBuf
+ * A pointer to an initialized path buffer.
+ */
+void lio_pathbuf_terminate(LioPathBuf* const pBuf);
+
+
+
+/**
+ * @brief Replace the contents of a path buffer.
+ *
+ * @param pBuf
+ * A pointer to an initialized path buffer.
+ *
+ * @param pPath
+ * The new path.
+ *
+ * @return TRUE if the path was set, FALSE if memory could not be allocated.
+ */
+bool lio_pathbuf_set(LioPathBuf* const pBuf, const char* const pPath);
+
+
+
+/**
+ * @brief Append a path component, adding a separator if needed.
+ *
+ * @param pBuf
+ * A pointer to an initialized path buffer.
+ *
+ * @param pComponent
+ * A file or folder name, or a relative path, to append.
+ *
+ * @return TRUE if the component was appended, FALSE if memory could not be
+ * allocated.
+ */
+bool lio_pathbuf_push(LioPathBuf* const pBuf, const char* const pComponent);
+
+
+
+/**
+ * @brief Append several path components.
+ *
+ * @param pBuf
+ * A pointer to an initialized path buffer.
+ *
+ * @param pComponent
+ * The first of a NULL-terminated list of components to append.
+ *
+ * @return TRUE if all components were appended, FALSE if not.
+ *
+ * @see LIO_PATHBUF_JOIN()
+ */
+bool lio_pathbuf_join(LioPathBuf* const pBuf, const char* const pComponent, ...);
+
+/**
+ * @brief Append several path components without a trailing NULL argument.
+ */
+#define LIO_PATHBUF_JOIN( pBuf, ... ) lio_pathbuf_join((pBuf), __VA_ARGS__, (const char*)NULL)
+
+
+
+/**
+ * @brief Remove the last component of a path, leaving its parent directory.
+ *
+ * The root directory is preserved, so popping "/usr" results in "/".
+ *
+ * @param pBuf
+ * A pointer to an initialized path buffer.
+ *
+ * @return TRUE if a component was removed, FALSE if the path was empty or
+ * only contained the root directory.
+ */
+bool lio_pathbuf_pop(LioPathBuf* const pBuf);
+
+
+
+/**
+ * @brief Replace the last component of a path.
+ *
+ * @param pBuf
+ * A pointer to an initialized path buffer.
+ *
+ * @param pName
+ * The new file or folder name.
+ *
+ * @return TRUE if the name was replaced, FALSE if memory could not be
+ * allocated.
+ */
+bool lio_pathbuf_set_basename(LioPathBuf* const pBuf, const char* const pName);
+
+
+
+/**
+ * @brief Retrieve the last component of a path without copying it.
+ *
+ * @return A pointer into the path buffer, which is an empty string if the
+ * path ends with a separator.
+ */
+const char* lio_pathbuf_basename(const LioPathBuf* const pBuf);
+
+
+
+/**
+ * @brief Copy a path buffer into a dynamically allocated string.
+ *
+ * @return A string which must be freed with "lio_path_destroy()", or NULL if
+ * an error occurred.
+ */
+char* lio_pathbuf_copy(const LioPathBuf* const pBuf);
+
+
+
+/**
+ * @brief Retrieve the NULL-terminated path stored in a path buffer.
+ */
+static inline const char* lio_pathbuf_cstr(const LioPathBuf* const pBuf)
+{
+    return pBuf->pData;
+}
+
+
+
+/**
+ * @brief Retrieve the length of the path stored in a path buffer.
+ */
+static inline size_t lio_pathbuf_length(const LioPathBuf* const pBuf)
+{
+    return pBuf->length;
+}
+
+
+
+/**
+ * @brief Determine if a path buffer has spilled to the heap.
+ */
+static inline bool lio_pathbuf_is_spilled(const LioPathBuf* const pBuf)
+{
+    return pBuf->pData != pBuf->inlineData;
+}
+
+
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* LIGHT_IO_PATHBUF_H */
@@ -0,0 +1,388 @@
+
+#ifndef LIGHT_IO_PATHINDEX_H
+#define LIGHT_IO_PATHINDEX_H
+
+#include <stdbool.h>
+#include <stddef.h> // size_t
+#include <stdint.h> // uint64_t, int64_t
+
+#include "light_io/lio_paths.h"
+#include "light_io/lio_strbuf.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+
+enum LioPathIndexFlags
+{
+    LIO_PATHINDEX_DEFAULT = 0x00,
+    LIO_PATHINDEX_EXACT   = 0x01 // Keep a hash table which supports removal and exact answers
+};
+
+
+
+enum LioPathIndexLimits
+{
+    LIO_PATHINDEX_BITS_PER_PATH   = 12,   // ~0.3% false positives when at the expected size
+    LIO_PATHINDEX_MIN_PATHS       = 1024,
+    LIO_PATHINDEX_RACY_NSEC       = 100000000 // Modification times closer than this to a scan are not trusted
+};
+
+
+
+/**
+ * @brief Answers given by a path index.
+ */
+enum LioPathIndexResult
+{
+    LIO_PATHINDEX_ABSENT,  // The path did not exist when it was indexed
+    LIO_PATHINDEX_MAYBE,   // The path may exist and must be checked on disk
+    LIO_PATHINDEX_UNKNOWN  // The path is not covered by the index
+};
+
+
+
+/**
+ * @brief An open-addressing table of path hashes, used internally by
+ * LioPathIndex.
+ */
+typedef struct LioPathIndexTable
+{
+    uint64_t* pKeys;
+    uint32_t* pValues; // Optional, parallel to "pKeys"
+    size_t capacity;
+    size_t numUsed; // Live keys and tombstones
+} LioPathIndexTable;
+
+
+
+/**
+ * @brief A folder which has been scanned into a path index.
+ */
+typedef struct LioPathIndexFolder
+{
+    int64_t modifiedTime; // Nanoseconds since the epoch, or INT64_MIN if the folder is missing
+    int64_t scannedTime; // Nanoseconds since the epoch
+    size_t pathOffset; // Offset of the folder's path in "LioPathIndex::folderPaths"
+} LioPathIndexFolder;
+
+
+
+/**
+ * @brief An index of every path beneath a root folder which answers
+ * "definitely not present" without touching the file system.
+ *
+ * Paths are hashed into a blocked Bloom filter, where each lookup reads a
+ * single cache line. Optionally, the hashes are also kept in an exact table so
+ * that paths can be removed and the filter can be resized as it grows.
+ *
+ * Paths are hashed after removing repeated and trailing separators. Paths
+ * outside of the root, paths containing "." or ".." components, and paths
+ * beneath a symbolic link or an unreadable folder are never answered by the
+ * index.
+ *
+ * Each scanned folder's modification time is recorded so that a stale index
+ * can be detected and refreshed one folder at a time.
+ */
+typedef struct LioPathIndex
+{
+    uint64_t* pBlocks;
+    size_t numBlocks;
+    size_t numPaths; // Paths added, which may include repeats without an exact table
+    size_t expectedPaths; // Number of paths the filter is sized for
+    unsigned flags;
+
+    LioPathIndexTable exact;
+    LioPathIndexTable opaque; // Folders whose contents are not indexed
+    LioPathIndexTable folderTable; // Maps a folder's hash to its record
+
+    LioPathIndexFolder* pFolders;
+    size_t numFolders;
+    size_t folderCapacity;
+    LioStrBuf folderPaths; // NULL-separated paths of all scanned folders
+
+    LioStrBuf root;
+} LioPathIndex;
+
+
+
+/**
+ * @brief Initialize an empty path index.
+ *
+ * @param pIndex
+ * A pointer to the index to initialize.
+ *
+ * @param rootDir
+ * The folder which the index covers. Queries for paths outside of this folder
+ * return LIO_PATHINDEX_UNKNOWN.
+ *
+ * @param expectedPaths
+ * The number of paths the index should be sized for, or 0 for a default.
+ *
+ * @param flags
+ * A bitwise combination of values from "enum LioPathIndexFlags."
+ *
+ * @return TRUE if the index was initialized, FALSE if not.
+ */
+bool lio_pathindex_init(
+    LioPathIndex* const pIndex,
+    const char* const rootDir,
+    const size_t expectedPaths,
+    const unsigned flags);
+
+
+
+/**
+ * @brief Release all memory used by a path index.
+ *
+ * @param pIndex
+ * A pointer to an initialized index.
+ */
+void lio_pathindex_terminate(LioPathIndex* const pIndex);
+
+
+
+/**
+ * @brief Initialize an index and fill it with every path beneath a folder.
+ *
+ * The filter is sized for the number of paths found. Symbolic links are not
+ * followed.
+ *
+ * @param pIndex
+ * A pointer to an uninitialized index.
+ *
+ * @param rootDir
+ * The folder to scan. It is resolved to an absolute path.
+ *
+ * @param flags
+ * A bitwise combination of values from "enum LioPathIndexFlags."
+ *
+ * @return TRUE if the index was built, FALSE if not. The index does not need
+ * to be terminated if this function fails.
+ */
+bool lio_pathindex_build(
+    LioPathIndex* const pIndex,
+    const char* const rootDir,
+    const unsigned flags);
+
+
+
+/**
+ * @brief Add a path to an index.
+ *
+ * @param pIndex
+ * A pointer to an initialized index.
+ *
+ * @param pPath
+ * The path to add. It must be beneath the index's root.
+ *
+ * @return TRUE if the path was added, FALSE if it is not covered by the index
+ * or memory could not be allocated.
+ */
+bool lio_pathindex_add(LioPathIndex* const pIndex, const char* const pPath);
+
+
+
+/**
+ * @brief Remove a path from an index.
+ *
+ * Bloom filters cannot forget a path, so this requires LIO_PATHINDEX_EXACT.
+ * Without it, a removed path is reported as LIO_PATHINDEX_MAYBE until the
+ * index is rebuilt, which is still correct.
+ *
+ * @param pIndex
+ * A pointer to an initialized index.
+ *
+ * @param pPath
+ * The path to remove.
+ *
+ * @return TRUE if the path was removed from the exact table, FALSE if not.
+ */
+bool lio_pathindex_remove(LioPathIndex* const pIndex, const char* const pPath);
+
+
+
+/**
+ * @brief Mark a folder whose contents are not indexed, such as a symbolic
+ * link to a folder or a folder which could not be read. Queries for paths
+ * beneath it return LIO_PATHINDEX_UNKNOWN.
+ *
+ * @param pIndex
+ * A pointer to an initialized index.
+ *
+ * @param pPath
+ * The folder to mark.
+ *
+ * @return TRUE if the folder was marked, FALSE if not.
+ */
+bool lio_pathindex_add_opaque(LioPathIndex* const pIndex, const char* const pPath);
+
+
+
+/**
+ * @brief Record the modification time of a scanned folder, replacing any
+ * previous record.
+ *
+ * @param pIndex
+ * A pointer to an initialized index.
+ *
+ * @param pPath
+ * The folder's path.
+ *
+ * @param modifiedTime
+ * The folder's modification time in nanoseconds since the epoch.
+ *
+ * @param scannedTime
+ * The time at which the folder's contents were read, in nanoseconds since the
+ * epoch.
+ *
+ * @return TRUE if the folder was recorded, FALSE if not.
+ */
+bool lio_pathindex_set_folder(
+    LioPathIndex* const pIndex,
+    const char* const pPath,
+    const int64_t modifiedTime,
+    const int64_t scannedTime);
+
+
+
+/**
+ * @brief Determine if a folder has been scanned into an index.
+ *
+ * @param pIndex
+ * A pointer to an initialized index.
+ *
+ * @param pPath
+ * The folder's path.
+ *
+ * @return TRUE if the folder has a record in the index, FALSE if not.
+ */
+bool lio_pathindex_has_folder(const LioPathIndex* const pIndex, const char* const pPath);
+
+
+
+/**
+ * @brief Query an index without touching the file system.
+ *
+ * @param pIndex
+ * A pointer to an initialized index.
+ *
+ * @param pPath
+ * The path to look up.
+ *
+ * @return LIO_PATHINDEX_ABSENT if the path was not present when it was
+ * indexed, LIO_PATHINDEX_MAYBE if it may be, or LIO_PATHINDEX_UNKNOWN if the
+ * path is not covered by the index.
+ */
+enum LioPathIndexResult lio_pathindex_query(const LioPathIndex* const pIndex, const char* const pPath);
+
+
+
+/**
+ * @brief Determine if a path exists, skipping the file system for paths
+ * which the index knows are absent.
+ *
+ * @param pIndex
+ * A pointer to an initialized index.
+ *
+ * @param pPath
+ * The path to look up.
+ *
+ * @param pathType
+ * The type of file system object to look for.
+ *
+ * @return TRUE if the path exists, FALSE if not.
+ */
+bool lio_pathindex_does_exist(
+    const LioPathIndex* const pIndex,
+    const char* const pPath,
+    const enum LioPathType pathType);
+
+
+
+/**
+ * @brief Determine if any folder in an index has changed since it was
+ * scanned.
+ *
+ * Folders whose modification time is within LIO_PATHINDEX_RACY_NSEC of their
+ * scan are reported as stale, since a later change in the same timestamp tick
+ * would not be visible.
+ *
+ * @param pIndex
+ * A pointer to an initialized index.
+ *
+ * @return TRUE if the index should be refreshed, FALSE if not.
+ */
+bool lio_pathindex_is_stale(const LioPathIndex* const pIndex);
+
+
+
+/**
+ * @brief Rescan each folder in an index which has changed since it was
+ * scanned.
+ *
+ * New paths and folders are added. Removed paths are only forgotten by an
+ * index built with LIO_PATHINDEX_EXACT, or by rebuilding.
+ *
+ * @param pIndex
+ * A pointer to an initialized index.
+ *
+ * @return TRUE if every changed folder was rescanned, FALSE if not.
+ */
+bool lio_pathindex_refresh(LioPathIndex* const pIndex);
+
+
+
+/**
+ * @brief Add a folder and everything beneath it to an index.
+ *
+ * @param pIndex
+ * A pointer to an initialized index.
+ *
+ * @param pPath
+ * The folder to scan. It must be beneath the index's root.
+ *
+ * @return TRUE if the folder was scanned, FALSE if not.
+ */
+bool lio_pathindex_scan(LioPathIndex* const pIndex, const char* const pPath);
+
+
+
+/**
+ * @brief Write an index to a file.
+ *
+ * @param pIndex
+ * A pointer to an initialized index.
+ *
+ * @param filePath
+ * The file to write. It is replaced if it already exists.
+ *
+ * @return TRUE if the index was saved, FALSE if not.
+ */
+bool lio_pathindex_save(const LioPathIndex* const pIndex, const char* const filePath);
+
+
+
+/**
+ * @brief Load an index which was written by "lio_pathindex_save()".
+ *
+ * @param pIndex
+ * A pointer to an uninitialized index.
+ *
+ * @param filePath
+ * The file to read.
+ *
+ * @return TRUE if the index was loaded, FALSE if not. The index does not need
+ * to be terminated if this function fails.
+ */
+bool lio_pathindex_load(LioPathIndex* const pIndex, const char* const filePath);
+
+
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* LIGHT_IO_PATHINDEX_H */
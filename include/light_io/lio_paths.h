@@ -4,6 +4,8 @@
 
 #include <stdbool.h>
 
+#include "light_io/lio_arena.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -36,6 +38,9 @@ enum LioPathType
 /**
  * @brief Determine if a path exists on the local filesystem.
  *
+ * If "lio_statcache_enable()" has been called, the result may come from the
+ * metadata cache rather than the filesystem.
+ *
  * @param path
  * A pointer to a constant string which contains a full, relative, or linked
  * path to some entry on the local filesystem.
@@ -216,6 +221,42 @@ char** lio_path_list(
     unsigned* const pOutNumEntries);
 
 
+/**
+ * @brief Retrieve a list of files and/or folders in a directory, allocating
+ * the list and its paths from an arena.
+ *
+ * Callers which only need a listing briefly can release it, and any other
+ * listings made with the same arena, in one call to "lio_arena_reset()".
+ *
+ * @param baseDir
+ * The base folder to query for child entries.
+ *
+ * @param listHidden
+ * Determine if hidden files or folder should be placed into the returned path
+ * array.
+ *
+ * @param filter
+ * An optional entry filter, as used by "lio_path_list()".
+ *
+ * @param pArena
+ * A pointer to the arena which will own the returned array and its strings.
+ *
+ * @param pOutNumEntries
+ * A pointer to an unsigned integer which will provide the calling function
+ * with the number of entries which were returned from this function.
+ *
+ * @return
+ * An array of full paths which must NOT be freed with "lio_paths_destroy()",
+ * or NULL if an error occurred.
+ */
+char** lio_path_list_arena(
+    const char* const baseDir,
+    const bool listHidden,
+    bool (*filter)(const char* const),
+    LioArena* const pArena,
+    unsigned* const pOutNumEntries);
+
+
 /**
  * @brief Retrieve the number of child files/folders are contained within a
  * folder on the local filesystem.
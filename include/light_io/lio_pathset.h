@@ -0,0 +1,169 @@
+
+#ifndef LIGHT_IO_PATHSET_H
+#define LIGHT_IO_PATHSET_H
+
+#include <stdbool.h>
+#include <stddef.h> // size_t
+#include <stdint.h> // uint32_t
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+
+/**
+ * @brief A set of paths, stored as a compressed trie of path components.
+ *
+ * Paths which share leading directories only store those directories once.
+ * Chains of directories with a single child are merged into one node, and
+ * every node lives in a single hash table which also holds short component
+ * names, so millions of paths can be held in a fraction of the memory used by
+ * an array of strings, and most lookups never leave the table.
+ *
+ * Paths are compared component-by-component. Repeated and trailing
+ * separators are ignored, so "a//b/" and "a/b" are the same path, while a
+ * leading separator is significant.
+ */
+typedef struct LioPathSet
+{
+    struct LioPathSetSlot* pSlots;
+    char* pLabels;
+    uint32_t numNodes;
+    uint32_t slotCapacity;
+    uint32_t labelsLength;
+    uint32_t labelsCapacity;
+    uint32_t firstChild; // The first node below the root
+    size_t numPaths;
+} LioPathSet;
+
+
+
+/**
+ * @brief Callback used to visit each path in a set.
+ *
+ * @param pPath
+ * A NULL-terminated path, which is only valid until the callback returns.
+ *
+ * @param length
+ * The number of characters in "pPath".
+ *
+ * @param pUserData
+ * The user data passed to "lio_pathset_iterate()".
+ *
+ * @return TRUE to continue iterating, FALSE to stop.
+ */
+typedef bool (*LioPathSetVisitor)(const char* pPath, size_t length, void* pUserData);
+
+
+
+/**
+ * @brief Initialize an empty path set. No memory is allocated until a path is
+ * inserted.
+ *
+ * @param pSet
+ * A pointer to the path set to initialize.
+ */
+void lio_pathset_init(LioPathSet* const pSet);
+
+
+
+/**
+ * @brief Release all memory used by a path set. The set is left empty and can
+ * be reused.
+ *
+ * @param pSet
+ * A pointer to an initialized path set.
+ */
+void lio_pathset_terminate(LioPathSet* const pSet);
+
+
+
+/**
+ * @brief Add a path to a set.
+ *
+ * @param pSet
+ * A pointer to an initialized path set.
+ *
+ * @param pPath
+ * The path to add.
+ *
+ * @return TRUE if the path is in the set, whether or not it was already
+ * present, or FALSE if the path was empty or memory could not be allocated.
+ */
+bool lio_pathset_insert(LioPathSet* const pSet, const char* const pPath);
+
+
+
+/**
+ * @brief Determine if a path has been added to a set.
+ *
+ * Directories which only appear as the parent of another path are not
+ * members of the set.
+ *
+ * @param pSet
+ * A pointer to an initialized path set.
+ *
+ * @param pPath
+ * The path to search for.
+ *
+ * @return TRUE if the path was inserted into the set, FALSE if not.
+ */
+bool lio_pathset_contains(const LioPathSet* const pSet, const char* const pPath);
+
+
+
+/**
+ * @brief Visit every path which begins with a set of leading components.
+ *
+ * @param pSet
+ * A pointer to an initialized path set.
+ *
+ * @param pPrefix
+ * Leading path components to filter by. Components must match entirely, so
+ * "/usr/li" does not match "/usr/lib". A NULL or empty prefix visits the entire
+ * set. The prefix itself is visited if it is a member of the set.
+ *
+ * @param sorted
+ * Visit the paths sorted by component, rather than in an unspecified order.
+ *
+ * @param visitor
+ * The function to call for each path.
+ *
+ * @param pUserData
+ * A pointer which is passed to each call of "visitor".
+ *
+ * @return TRUE if every matching path was visited, FALSE if the visitor
+ * stopped early or memory could not be allocated.
+ */
+bool lio_pathset_iterate(
+    const LioPathSet* const pSet,
+    const char* const pPrefix,
+    const bool sorted,
+    LioPathSetVisitor visitor,
+    void* pUserData);
+
+
+
+/**
+ * @brief Retrieve the number of bytes allocated by a path set.
+ */
+size_t lio_pathset_memory_usage(const LioPathSet* const pSet);
+
+
+
+/**
+ * @brief Retrieve the number of paths in a set.
+ */
+static inline size_t lio_pathset_size(const LioPathSet* const pSet)
+{
+    return pSet->numPaths;
+}
+
+
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* LIGHT_IO_PATHSET_H */
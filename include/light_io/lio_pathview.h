@@ -0,0 +1,187 @@
+
+#ifndef LIGHT_IO_PATHVIEW_H
+#define LIGHT_IO_PATHVIEW_H
+
+#include <stdbool.h>
+#include <stddef.h> // size_t
+#include <string.h> // strlen()
+
+#include "light_io/lio_paths.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+
+/**
+ * @brief A non-owning slice of a path string.
+ *
+ * Views are not NULL-terminated. They remain valid only as long as the string
+ * they refer to.
+ */
+typedef struct LioPathView
+{
+    const char* pData;
+    size_t length;
+} LioPathView;
+
+
+
+/**
+ * @brief Iterator over the components of a path.
+ *
+ * Components may be consumed from either end. Empty components, created by
+ * repeated separators, are skipped.
+ */
+typedef struct LioPathIter
+{
+    const char* pData;
+    size_t front;
+    size_t back;
+} LioPathIter;
+
+
+
+/**
+ * @brief Create a view from a NULL-terminated string.
+ */
+static inline LioPathView lio_pathview_make(const char* const pPath)
+{
+    LioPathView view = {pPath, pPath ? strlen(pPath) : 0};
+    return view;
+}
+
+
+
+/**
+ * @brief Create a view from a string with a known length.
+ */
+static inline LioPathView lio_pathview_make_n(const char* const pPath, const size_t length)
+{
+    LioPathView view = {pPath, length};
+    return view;
+}
+
+
+
+/**
+ * @brief Locate the first path separator within a string.
+ *
+ * @param pPath
+ * A pointer to a string, which does not need to be NULL-terminated.
+ *
+ * @param length
+ * The number of characters to search.
+ *
+ * @return The index of the first separator, or "length" if there is none.
+ */
+size_t lio_pathview_find_sep(const char* const pPath, const size_t length);
+
+
+
+/**
+ * @brief Locate the last path separator within a string.
+ *
+ * @param pPath
+ * A pointer to a string, which does not need to be NULL-terminated.
+ *
+ * @param length
+ * The number of characters to search.
+ *
+ * @return The index of the last separator, or "length" if there is none.
+ */
+size_t lio_pathview_rfind_sep(const char* const pPath, const size_t length);
+
+
+
+/**
+ * @brief Retrieve everything after the last separator of a path.
+ *
+ * This matches "lio_path_basename()", so a path which ends with a separator
+ * has an empty basename.
+ */
+LioPathView lio_pathview_basename(const LioPathView path);
+
+
+
+/**
+ * @brief Retrieve everything before the last separator of a path.
+ *
+ * This matches "lio_path_dirname()", so a path without separators has an
+ * empty dirname.
+ */
+LioPathView lio_pathview_dirname(const LioPathView path);
+
+
+
+/**
+ * @brief Retrieve the extension of a path's basename, including its leading
+ * period.
+ *
+ * A leading period does not begin an extension, so hidden files such as
+ * ".profile" have no extension.
+ */
+LioPathView lio_pathview_extension(const LioPathView path);
+
+
+
+/**
+ * @brief Determine if a view is equal to a NULL-terminated string.
+ */
+static inline bool lio_pathview_equals(const LioPathView view, const char* const pStr)
+{
+    return strlen(pStr) == view.length && (!view.length || memcmp(view.pData, pStr, view.length) == 0);
+}
+
+
+
+/**
+ * @brief Begin iterating over the components of a path.
+ */
+static inline void lio_pathiter_init(LioPathIter* const pIter, const LioPathView path)
+{
+    pIter->pData = path.pData;
+    pIter->front = 0;
+    pIter->back = path.length;
+}
+
+
+
+/**
+ * @brief Retrieve the next component from the front of a path.
+ *
+ * @param pIter
+ * A pointer to an initialized path iterator.
+ *
+ * @param pOutComponent
+ * A pointer to a view which will refer to the next component.
+ *
+ * @return TRUE if a component was found, FALSE if all components have been
+ * consumed.
+ */
+bool lio_pathiter_next(LioPathIter* const pIter, LioPathView* const pOutComponent);
+
+
+
+/**
+ * @brief Retrieve the next component from the back of a path.
+ *
+ * @param pIter
+ * A pointer to an initialized path iterator.
+ *
+ * @param pOutComponent
+ * A pointer to a view which will refer to the next component.
+ *
+ * @return TRUE if a component was found, FALSE if all components have been
+ * consumed.
+ */
+bool lio_pathiter_prev(LioPathIter* const pIter, LioPathView* const pOutComponent);
+
+
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* LIGHT_IO_PATHVIEW_H */
@@ -0,0 +1,171 @@
+
+#ifndef LIGHT_IO_RECORD_H
+#define LIGHT_IO_RECORD_H
+
+#include <stdbool.h>
+#include <stdint.h> // uint64_t
+
+#include "light_io/lio_binio.h"
+#include "light_io/lio_stats.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+
+/**
+ * @brief Identification of a recording file.
+ */
+enum LioRecordFormat
+{
+    LIO_RECORD_VERSION = 1,
+    LIO_RECORD_HEADER_SIZE = 16, // "LIOREC\0\0", version, reserved
+    LIO_RECORD_ENTRY_SIZE = 80   // Fixed part of each entry, before its paths
+};
+
+
+
+/**
+ * @brief A single recorded call.
+ *
+ * The operation is one of LioStatsOp. Arguments which are not paths are kept
+ * in "args":
+ *
+ * LIO_STATS_OP_FILE_OPEN:    args = {flags}, result = descriptor or -1
+ * LIO_STATS_OP_FILE_CLOSE:   args = {descriptor}
+ * LIO_STATS_OP_FILE_READ:    args = {descriptor, bytes requested or UINT64_MAX to read everything}, result = bytes read or -1
+ * LIO_STATS_OP_FILE_WRITE:   args = {descriptor, bytes}
+ * LIO_STATS_OP_FILE_MAP:     args = {descriptor}, result = bytes mapped
+ * LIO_STATS_OP_FILE_COPY:    path -> other, args = {flags}; or between descriptors, args = {flags, source, destination}
+ * LIO_STATS_OP_FILE_CONCAT:  path = output, other = inputs separated by '\n', args = {flags}; or between descriptors, args = {inputs, destination}
+ * LIO_STATS_OP_FILE_SPLIT:   path = input, other = prefix, args = {mode, param, delimiter}, result = parts or -1
+ * LIO_STATS_OP_PATH_EXISTS:  args = {type}
+ * LIO_STATS_OP_PATH_RESOLVE: result = 1 if resolved
+ * LIO_STATS_OP_PATH_LIST:    args = {list hidden, filtered, 1 if only counting}, result = entries or -1
+ * LIO_STATS_OP_PATH_REMOVE:  args = {recurse, follow links, 1 if moved to the trash}
+ * LIO_STATS_OP_PATH_MKDIRS:  no arguments
+ * LIO_STATS_OP_PATH_MOVE:    path -> other, args = {overwrite}
+ * LIO_STATS_OP_FILE_COMMIT:  args = {1 if batched, overwrite}; or for a whole batch, args = {1, 0, files}
+ *
+ * Unless noted above, the result is 1 on success and 0 on failure, except
+ * for lio_path_move() which keeps its own return value.
+ */
+typedef struct LioRecordEntry
+{
+    uint64_t startNs; // Since recording began
+    uint64_t durationNs;
+    uint64_t args[3];
+    uint64_t bytesRead;
+    uint64_t bytesWritten;
+    int64_t result;
+    uint32_t threadId;
+    uint16_t op;
+    const char* pPath; // Never NULL, but may be empty
+    const char* pOtherPath;
+} LioRecordEntry;
+
+
+
+/**
+ * @brief Sequential access to a recording.
+ */
+typedef struct LioRecordReader
+{
+    LioFile file;
+    LioBinReader reader;
+    char* pStrings; // Paths of the current entry
+    size_t capacity;
+} LioRecordReader;
+
+
+
+/*-----------------------------------------------------------------------------
+ * Recording
+-----------------------------------------------------------------------------*/
+/**
+ * @brief Begin logging every public call made on any thread to a file.
+ *
+ * Only calls made directly by the application are logged; the calls a library
+ * function makes internally are part of the outer call. Entries are buffered
+ * and written in the order calls complete.
+ *
+ * Recording shares its instrumentation with lio_stats.h and is compiled out
+ * unless the library was built with LIGHT_IO_ENABLE_STATS.
+ *
+ * (*NIX only)
+ *
+ * @param pPath
+ * The file to log to. An existing file is overwritten.
+ *
+ * @return TRUE if calls are now being recorded, FALSE if recording was
+ * compiled out, already running, or the file could not be created.
+ */
+bool lio_record_start(const char* const pPath);
+
+
+
+/**
+ * @brief Stop recording and write any buffered entries.
+ *
+ * @return The number of entries recorded, or -1 if the recording could not
+ * be written completely.
+ */
+long long lio_record_stop(void);
+
+
+
+/**
+ * @brief Determine if calls made by the calling thread are being recorded.
+ */
+bool lio_record_is_enabled(void);
+
+
+
+/**
+ * @brief Log a completed call. This is used by the library's own functions,
+ * through lio_stats_end_call(), with "startNs" on the monotonic clock rather
+ * than relative to the recording.
+ */
+void lio_record_call(const LioRecordEntry* const pEntry);
+
+
+
+/*-----------------------------------------------------------------------------
+ * Playback
+-----------------------------------------------------------------------------*/
+/**
+ * @brief Open a recording for reading.
+ *
+ * @return TRUE if the file is a recording this version can read, FALSE if
+ * not.
+ */
+bool lio_record_reader_open(LioRecordReader* const pReader, const char* const pPath);
+
+
+
+/**
+ * @brief Read the next entry of a recording.
+ *
+ * @param pOutEntry
+ * Set to the next entry. Its paths remain valid until the next call.
+ *
+ * @return TRUE if an entry was read, FALSE at the end of the recording or if
+ * it is corrupt (see lio_error_last()).
+ */
+bool lio_record_reader_next(LioRecordReader* const pReader, LioRecordEntry* const pOutEntry);
+
+
+
+/**
+ * @brief Close a recording.
+ */
+void lio_record_reader_close(LioRecordReader* const pReader);
+
+
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* LIGHT_IO_RECORD_H */
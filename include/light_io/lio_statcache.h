@@ -0,0 +1,199 @@
+
+#ifndef LIGHT_IO_STATCACHE_H
+#define LIGHT_IO_STATCACHE_H
+
+#include <stdbool.h>
+#include <stddef.h> // size_t
+#include <stdint.h> // uint32_t, uint64_t
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+
+/**
+ * @brief Limits used by the metadata cache.
+ */
+enum LioStatCacheLimits
+{
+    LIO_STAT_CACHE_NUM_SHARDS        = 16,  // Each shard has its own lock
+    LIO_STAT_CACHE_WAYS              = 8,   // Slots searched for each path before one is evicted
+    LIO_STAT_CACHE_DEFAULT_CAPACITY  = 4096 // Paths cached across all shards
+};
+
+
+
+/**
+ * @brief The metadata cached for a single path.
+ */
+typedef struct LioStatCacheEntry
+{
+    bool exists;
+    uint32_t mode; // The "st_mode" from lstat(), or 0 if the path does not exist
+} LioStatCacheEntry;
+
+
+
+/**
+ * @brief Counters describing how effective the cache has been since it was
+ * enabled.
+ */
+typedef struct LioStatCacheStats
+{
+    uint64_t hits;
+    uint64_t misses; // Lookups which were absent, expired, or from an older generation
+    uint64_t invalidations; // Entries removed by mutating operations
+    uint64_t evictions; // Entries replaced to make room for others
+    uint64_t generation;
+} LioStatCacheStats;
+
+
+
+/**
+ * @brief Enable the process-wide metadata cache used by
+ * "lio_path_does_exist()".
+ *
+ * The cache is disabled by default. Once enabled, the results of lstat(),
+ * including missing paths, are reused until they expire, the generation is
+ * bumped, or the path is changed through this library. Changes made by other
+ * processes, or through other APIs, are not seen until then.
+ *
+ * Only absolute paths are cached. Repeated separators and "." components are
+ * ignored, so "/a//b/./c" and "/a/b/c" share an entry. Relative paths, paths
+ * containing "..", and paths ending in a separator are always stat'ed.
+ *
+ * This must not be called while other threads use the cache.
+ *
+ * (*NIX only)
+ *
+ * @param capacity
+ * The number of paths to cache, or 0 to use LIO_STAT_CACHE_DEFAULT_CAPACITY.
+ *
+ * @param ttlNs
+ * The number of nanoseconds before an entry expires, or 0 to keep entries
+ * until the generation is bumped.
+ *
+ * @return TRUE if the cache was enabled, FALSE if not.
+ */
+bool lio_statcache_enable(size_t capacity, const uint64_t ttlNs);
+
+
+
+/**
+ * @brief Disable the metadata cache and free all of its entries.
+ *
+ * This must not be called while other threads use the cache.
+ */
+void lio_statcache_disable(void);
+
+
+
+/**
+ * @brief Determine if the metadata cache has been enabled.
+ */
+bool lio_statcache_is_enabled(void);
+
+
+
+/**
+ * @brief Invalidate every cached entry at once.
+ *
+ * Entries are stamped with the generation they were stored in, so this costs
+ * the same regardless of how many paths are cached.
+ *
+ * @return The new generation.
+ */
+uint64_t lio_statcache_bump(void);
+
+
+
+/**
+ * @brief Look up a path in the metadata cache.
+ *
+ * @param path
+ * The path to look up.
+ *
+ * @param pOutEntry
+ * Set to the cached metadata if the path was found.
+ *
+ * @param pOutEpoch
+ * Set to the state of the cache before a miss. Pass this to
+ * "lio_statcache_store()" once the path has been stat'ed, so the result is
+ * dropped if the path was invalidated in the meantime. Set to 0 if the path
+ * cannot be cached.
+ *
+ * @return TRUE if a current entry was found, FALSE if the cache is disabled
+ * or the path must be stat'ed.
+ */
+bool lio_statcache_lookup(const char* const path, LioStatCacheEntry* const pOutEntry, uint64_t* const pOutEpoch);
+
+
+
+/**
+ * @brief Store the metadata of a path. Nothing is stored if the cache is
+ * disabled, or if the path, or the whole cache, was invalidated since the
+ * lookup which returned "epoch".
+ *
+ * @param path
+ * The path which was stat'ed.
+ *
+ * @param pEntry
+ * The metadata to cache.
+ *
+ * @param epoch
+ * The epoch from the "lio_statcache_lookup()" which missed, taken before the
+ * path was stat'ed.
+ */
+void lio_statcache_store(const char* const path, const LioStatCacheEntry* const pEntry, const uint64_t epoch);
+
+
+
+/**
+ * @brief Remove a path from the metadata cache. This is called by every
+ * function in this library which creates, removes, or renames paths.
+ *
+ * @param path
+ * The path which changed. Relative paths are resolved against the current
+ * working directory. If the path cannot be resolved without following links,
+ * such as one containing "..", the generation is bumped instead.
+ *
+ * @param recurse
+ * If TRUE, every cached path beneath "path" is also removed. This searches
+ * the entire cache.
+ */
+void lio_statcache_invalidate(const char* const path, const bool recurse);
+
+
+
+/**
+ * @brief Retrieve the cache's counters.
+ *
+ * @param pOutStats
+ * Set to the sum of every shard's counters.
+ */
+void lio_statcache_stats(LioStatCacheStats* const pOutStats);
+
+
+
+/**
+ * @brief Calculate the fraction of lookups which were served from the cache.
+ *
+ * @param pStats
+ * A pointer to counters from "lio_statcache_stats()".
+ *
+ * @return A value between 0 and 1.
+ */
+static inline double lio_statcache_hit_rate(const LioStatCacheStats* const pStats)
+{
+    const uint64_t total = pStats->hits + pStats->misses;
+    return total ? (double)pStats->hits / (double)total : 0.0;
+}
+
+
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* LIGHT_IO_STATCACHE_H */
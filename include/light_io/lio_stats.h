@@ -0,0 +1,277 @@
+
+#ifndef LIGHT_IO_STATS_H
+#define LIGHT_IO_STATS_H
+
+#include <stdbool.h>
+#include <stdint.h> // uint64_t
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+
+/**
+ * @brief Operations which are timed and counted.
+ */
+enum LioStatsOp
+{
+    LIO_STATS_OP_OTHER, // Work done outside of any timed operation
+    LIO_STATS_OP_FILE_OPEN,
+    LIO_STATS_OP_FILE_CLOSE,
+    LIO_STATS_OP_FILE_READ,
+    LIO_STATS_OP_FILE_WRITE,
+    LIO_STATS_OP_FILE_MAP,
+    LIO_STATS_OP_FILE_COPY,
+    LIO_STATS_OP_FILE_CONCAT,
+    LIO_STATS_OP_FILE_SPLIT,
+    LIO_STATS_OP_PATH_EXISTS,
+    LIO_STATS_OP_PATH_RESOLVE,
+    LIO_STATS_OP_PATH_LIST, // Listing or counting the entries of a folder
+    LIO_STATS_OP_PATH_REMOVE,
+    LIO_STATS_OP_PATH_MKDIRS,
+    LIO_STATS_OP_PATH_MOVE,
+    LIO_STATS_OP_FILE_COMMIT, // Publishing atomic writes, alone or as a batch
+
+    LIO_STATS_NUM_OPS
+};
+
+
+
+/**
+ * @brief Counters kept for each operation.
+ *
+ * Counters are attributed to the innermost operation running on the calling
+ * thread, so the bytes moved by a copy are counted against
+ * LIO_STATS_OP_FILE_COPY rather than the reads and writes it is built from.
+ * An operation which calls itself, such as lio_file_copy() calling
+ * lio_file_copy_fd(), is only counted once.
+ */
+enum LioStatsCounter
+{
+    LIO_STATS_CALLS,
+    LIO_STATS_SYSCALLS,
+    LIO_STATS_BYTES_READ,
+    LIO_STATS_BYTES_WRITTEN,
+    LIO_STATS_ENTRIES_SCANNED,
+    LIO_STATS_ALLOCATIONS,
+    LIO_STATS_ERRORS,
+
+    LIO_STATS_NUM_COUNTERS
+};
+
+
+
+/**
+ * @brief Layout of the latency histograms.
+ *
+ * Buckets are log-linear: each power of two is split into
+ * 2^LIO_STATS_SUB_BUCKET_BITS equal buckets, so a bucket's width is at most
+ * 25% of its lower bound. Latencies are in nanoseconds, and anything above
+ * 2^LIO_STATS_MAX_EXPONENT nanoseconds (about 18 minutes) falls into the last
+ * bucket.
+ */
+enum LioStatsLimits
+{
+    LIO_STATS_SUB_BUCKET_BITS = 2,
+    LIO_STATS_MAX_EXPONENT    = 40,
+    LIO_STATS_NUM_BUCKETS     = (LIO_STATS_MAX_EXPONENT - LIO_STATS_SUB_BUCKET_BITS + 2) << LIO_STATS_SUB_BUCKET_BITS
+};
+
+
+
+/**
+ * @brief Counters and latencies of a single operation.
+ */
+typedef struct LioStatsOpStats
+{
+    uint64_t counters[LIO_STATS_NUM_COUNTERS];
+    uint64_t totalNs;
+    uint64_t buckets[LIO_STATS_NUM_BUCKETS];
+} LioStatsOpStats;
+
+
+
+/**
+ * @brief Statistics of every operation, merged across all threads.
+ *
+ * This is several kilobytes in size.
+ */
+typedef struct LioStatsSnapshot
+{
+    LioStatsOpStats ops[LIO_STATS_NUM_OPS];
+} LioStatsSnapshot;
+
+
+
+/**
+ * @brief The start of a timed operation.
+ */
+typedef struct LioStatsTimer
+{
+    uint64_t startNs; // 0 if neither statistics nor tracing were enabled
+    uint64_t startBytesRead;
+    uint64_t startBytesWritten;
+    const char* pPath;
+    int op;
+    int parentOp;
+    bool counted;
+    bool traced;
+    bool recorded;
+} LioStatsTimer;
+
+
+
+/**
+ * @brief Enable or disable the collection of statistics.
+ *
+ * Statistics are disabled by default. Collection is compiled out entirely
+ * unless the library was built with LIGHT_IO_ENABLE_STATS.
+ *
+ * (*NIX only)
+ *
+ * @param enable
+ * TRUE to begin collecting, FALSE to stop. Collected statistics are kept.
+ *
+ * @return TRUE if statistics are now being collected, FALSE if not.
+ */
+bool lio_stats_enable(const bool enable);
+
+
+
+/**
+ * @brief Determine if statistics are being collected.
+ */
+bool lio_stats_is_enabled(void);
+
+
+
+/**
+ * @brief Merge the statistics of every thread.
+ *
+ * Each thread records into its own shard, so this is the only call which
+ * synchronizes. Operations still running on other threads may be partially
+ * counted.
+ *
+ * @param pOutSnapshot
+ * Set to everything collected since the last reset.
+ */
+void lio_stats_snapshot(LioStatsSnapshot* const pOutSnapshot);
+
+
+
+/**
+ * @brief Discard everything collected so far. Later snapshots only include
+ * operations which complete after this call.
+ */
+void lio_stats_reset(void);
+
+
+
+/**
+ * @brief Retrieve the name of an operation, such as "file_open".
+ */
+const char* lio_stats_op_name(const enum LioStatsOp op);
+
+
+
+/**
+ * @brief Retrieve the name of a counter, such as "bytes_read".
+ */
+const char* lio_stats_counter_name(const enum LioStatsCounter counter);
+
+
+
+/**
+ * @brief Retrieve the smallest latency, in nanoseconds, which falls into a
+ * histogram bucket.
+ */
+uint64_t lio_stats_bucket_lower_bound(const unsigned bucket);
+
+
+
+/**
+ * @brief Estimate a latency percentile from a histogram.
+ *
+ * @param pStats
+ * The statistics of an operation.
+ *
+ * @param fraction
+ * A value between 0 and 1, such as 0.99.
+ *
+ * @return The lower bound, in nanoseconds, of the bucket containing the
+ * percentile, or 0 if nothing was recorded.
+ */
+uint64_t lio_stats_percentile(const LioStatsOpStats* const pStats, const double fraction);
+
+
+
+/**
+ * @brief Begin timing an operation on the calling thread. This is used by the
+ * library's own functions.
+ *
+ * @param op
+ * The operation being started.
+ *
+ * @param pPath
+ * The path an operation works on, or NULL. This is only used for tracing and
+ * must remain valid until lio_stats_end() is called.
+ */
+LioStatsTimer lio_stats_begin(const enum LioStatsOp op, const char* const pPath);
+
+
+
+/**
+ * @brief Finish timing an operation.
+ */
+void lio_stats_end(const LioStatsTimer* const pTimer);
+
+
+
+/**
+ * @brief Finish timing an operation, passing along the arguments and result
+ * of the call for recording (see lio_record.h).
+ */
+void lio_stats_end_call(
+    const LioStatsTimer* const pTimer,
+    const char* const pOtherPath,
+    const uint64_t arg0,
+    const uint64_t arg1,
+    const uint64_t arg2,
+    const int64_t result);
+
+
+
+/**
+ * @brief Add to a counter of the operation running on the calling thread.
+ */
+void lio_stats_add(const enum LioStatsCounter counter, const uint64_t amount);
+
+
+
+/*-------------------------------------
+ * Instrumentation used within the library, which is removed unless the
+ * library is built with LIGHT_IO_ENABLE_STATS. Statistics, traces
+ * (see lio_trace.h) and recordings (see lio_record.h) are all taken through
+ * these.
+-------------------------------------*/
+#if defined(LIGHT_IO_ENABLE_STATS)
+    #define LIO_STATS_BEGIN(timer, op, pPath) const LioStatsTimer timer = lio_stats_begin((op), (pPath))
+    #define LIO_STATS_END(timer) lio_stats_end(&(timer))
+    #define LIO_STATS_END_CALL(timer, pOther, arg0, arg1, arg2, result) \
+        lio_stats_end_call(&(timer), (pOther), (uint64_t)(arg0), (uint64_t)(arg1), (uint64_t)(arg2), (int64_t)(result))
+    #define LIO_STATS_ADD(counter, amount) lio_stats_add((counter), (uint64_t)(amount))
+#else
+    #define LIO_STATS_BEGIN(timer, op, pPath) (void)0
+    #define LIO_STATS_END(timer) (void)0
+    #define LIO_STATS_END_CALL(timer, pOther, arg0, arg1, arg2, result) (void)0
+    #define LIO_STATS_ADD(counter, amount) (void)0
+#endif
+
+
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* LIGHT_IO_STATS_H */
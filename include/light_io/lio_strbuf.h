@@ -0,0 +1,157 @@
+
+#ifndef LIGHT_IO_STRBUF_H
+#define LIGHT_IO_STRBUF_H
+
+#include <stdbool.h>
+#include <stddef.h> // size_t
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+
+enum LioStrBufLimits
+{
+    LIO_STRBUF_MIN_CAPACITY = 64
+};
+
+
+
+/**
+ * @brief A growable, NULL-terminated string.
+ *
+ * Capacity grows geometrically so repeated appends amortize to a small number
+ * of allocations. A buffer can be truncated and reused to build many strings
+ * which share a common prefix, such as the paths within a directory.
+ */
+typedef struct LioStrBuf
+{
+    char* pData;
+    size_t length; // Number of characters, excluding the NULL terminator
+    size_t capacity; // Number of bytes allocated, including the NULL terminator
+} LioStrBuf;
+
+
+
+/**
+ * @brief Initialize an empty string buffer. No memory is allocated until the
+ * first append.
+ *
+ * @param pBuf
+ * A pointer to the string buffer to initialize.
+ */
+void lio_strbuf_init(LioStrBuf* const pBuf);
+
+
+
+/**
+ * @brief Release the memory used by a string buffer.
+ *
+ * @param pBuf
+ * A pointer to an initialized string buffer.
+ */
+void lio_strbuf_terminate(LioStrBuf* const pBuf);
+
+
+
+/**
+ * @brief Ensure a string buffer can hold a number of characters without
+ * reallocating.
+ *
+ * @param pBuf
+ * A pointer to an initialized string buffer.
+ *
+ * @param numChars
+ * The total number of characters, excluding the NULL terminator, which the
+ * buffer should be able to hold.
+ *
+ * @return TRUE if the buffer has enough capacity, FALSE if memory could not
+ * be allocated.
+ */
+bool lio_strbuf_reserve(LioStrBuf* const pBuf, const size_t numChars);
+
+
+
+/**
+ * @brief Append a NULL-terminated string.
+ *
+ * @return TRUE if the string was appended, FALSE if not.
+ */
+bool lio_strbuf_append(LioStrBuf* const pBuf, const char* const pStr);
+
+
+
+/**
+ * @brief Append a number of characters from a string.
+ *
+ * @return TRUE if the characters were appended, FALSE if not.
+ */
+bool lio_strbuf_append_n(LioStrBuf* const pBuf, const char* const pStr, const size_t numChars);
+
+
+
+/**
+ * @brief Append a single character.
+ *
+ * @return TRUE if the character was appended, FALSE if not.
+ */
+bool lio_strbuf_append_char(LioStrBuf* const pBuf, const char c);
+
+
+
+/**
+ * @brief Append a printf-style formatted string.
+ *
+ * The string is formatted directly into the buffer's spare capacity, so it is
+ * only formatted a second time when the buffer needs to grow.
+ *
+ * @return TRUE if the formatted string was appended, FALSE if not.
+ */
+bool lio_strbuf_appendf(LioStrBuf* const pBuf, const char* const fmt, ...);
+
+
+
+/**
+ * @brief Shorten a string buffer without releasing any memory.
+ *
+ * @param pBuf
+ * A pointer to an initialized string buffer.
+ *
+ * @param length
+ * The new length of the string. Nothing happens if this is not less than the
+ * current length.
+ */
+void lio_strbuf_truncate(LioStrBuf* const pBuf, const size_t length);
+
+
+
+/**
+ * @brief Transfer ownership of a buffer's string to the caller.
+ *
+ * @param pBuf
+ * A pointer to an initialized string buffer. It is left empty and can be
+ * reused.
+ *
+ * @return A dynamically allocated string which must be freed with
+ * "lio_utils_str_destroy()", or NULL if an error occurred.
+ */
+char* lio_strbuf_detach(LioStrBuf* const pBuf);
+
+
+
+/**
+ * @brief Retrieve the NULL-terminated contents of a string buffer.
+ */
+static inline const char* lio_strbuf_cstr(const LioStrBuf* const pBuf)
+{
+    return pBuf->pData ? pBuf->pData : "";
+}
+
+
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* LIGHT_IO_STRBUF_H */
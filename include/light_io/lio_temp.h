@@ -0,0 +1,123 @@
+
+#ifndef LIGHT_IO_TEMP_H
+#define LIGHT_IO_TEMP_H
+
+#include <stdbool.h>
+
+#include "light_io/lio_files.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+
+/*-----------------------------------------------------------------------------
+ * Scratch files and folders
+ *
+ * Each process keeps its scratch data under one root folder, created on
+ * first use inside $TMPDIR (or /tmp) and removed when the process exits.
+ * Scratch files have no name at all where the filesystem supports O_TMPFILE,
+ * so creating and discarding them never touches a folder; their space is
+ * released when they are closed.
+ *
+ * The root holds a lock for as long as its process is alive, which lets
+ * "lio_temp_recover()" find and remove the roots of processes which crashed
+ * without needing to trust process IDs. A child created with fork() shares
+ * its parent's root, but never removes it; only the process which created a
+ * root removes it.
+ *
+ * (*NIX only)
+-----------------------------------------------------------------------------*/
+/**
+ * @brief Retrieve the scratch folder of the calling process, creating it if
+ * necessary.
+ *
+ * @return The full path of the folder, which remains valid until
+ * "lio_temp_cleanup()" is called, or NULL if it could not be created.
+ */
+const char* lio_temp_root(void);
+
+
+
+/**
+ * @brief Create a scratch file with no name.
+ *
+ * @param pFile
+ * Set to a handle which is open for reading and writing. The file and its
+ * contents are discarded once the handle is closed, unless it was given a
+ * name with "lio_temp_keep()" first.
+ *
+ * @param pDir
+ * The folder whose filesystem the file should be stored on, or NULL to use
+ * the scratch root.
+ *
+ * @return TRUE if the file was created, FALSE if not.
+ */
+bool lio_temp_file(LioFile* const pFile, const char* const pDir);
+
+
+
+/**
+ * @brief Give a scratch file a permanent name.
+ *
+ * The file is linked in place without copying when it was created with
+ * O_TMPFILE on the same filesystem as "pPath". Otherwise its contents are
+ * copied, leaving the position of "pFile" unchanged.
+ *
+ * @param pFile
+ * A handle returned by "lio_temp_file()".
+ *
+ * @param pPath
+ * The name the file should have. This must not exist yet.
+ *
+ * @return TRUE if "pPath" now refers to the file's contents, FALSE if not.
+ */
+bool lio_temp_keep(const LioFile* const pFile, const char* const pPath);
+
+
+
+/**
+ * @brief Create a new, empty, uniquely named folder inside the scratch root.
+ *
+ * @return The full path of the folder, which must be freed with
+ * "lio_path_destroy()", or NULL if it could not be created. The folder is
+ * removed along with the root if it is not removed before then.
+ */
+char* lio_temp_dir(void);
+
+
+
+/**
+ * @brief Remove the scratch root of the calling process and all of its
+ * contents.
+ *
+ * This runs automatically when the process exits normally. A new root is
+ * created if scratch space is needed again afterwards. In a child created
+ * with fork(), the parent's root is only forgotten, not removed.
+ *
+ * @return TRUE if the root was removed or did not exist, FALSE if not.
+ */
+bool lio_temp_cleanup(void);
+
+
+
+/**
+ * @brief Remove the scratch roots left behind by processes which are no
+ * longer running.
+ *
+ * @param pBaseDir
+ * The folder which holds the scratch roots, or NULL for $TMPDIR (or /tmp).
+ *
+ * @return The number of scratch roots which were removed, or -1 if the folder
+ * could not be read.
+ */
+int lio_temp_recover(const char* const pBaseDir);
+
+
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* LIGHT_IO_TEMP_H */
@@ -0,0 +1,108 @@
+
+#ifndef LIGHT_IO_TRACE_H
+#define LIGHT_IO_TRACE_H
+
+#include <stdbool.h>
+#include <stdint.h> // uint64_t
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+
+/**
+ * @brief Limits of the trace buffers.
+ */
+enum LioTraceLimits
+{
+    LIO_TRACE_DEFAULT_NUM_EVENTS = 4096, // Spans kept per thread by default
+    LIO_TRACE_MAX_PATH           = 128   // Longer paths are truncated
+};
+
+
+
+/**
+ * @brief Begin recording a span for each library operation.
+ *
+ * Every span holds the operation, its path, the numbers of bytes it read and
+ * wrote, and the thread it ran on. Each thread records into its own ring
+ * buffer without taking any locks, so once a ring fills its oldest spans are
+ * overwritten.
+ *
+ * Tracing shares its instrumentation with lio_stats.h and is compiled out
+ * unless the library was built with LIGHT_IO_ENABLE_STATS. Tracing and
+ * statistics are enabled independently.
+ *
+ * (*NIX only)
+ *
+ * @param numEventsPerThread
+ * The number of spans kept by each thread, which is rounded up to a power of
+ * two. 0 selects LIO_TRACE_DEFAULT_NUM_EVENTS. This only applies to threads
+ * which record their first span after this call.
+ *
+ * @return TRUE if spans are now being recorded, FALSE if tracing was compiled
+ * out.
+ */
+bool lio_trace_start(const unsigned numEventsPerThread);
+
+
+
+/**
+ * @brief Stop recording spans. Recorded spans are kept until
+ * lio_trace_clear() is called.
+ */
+void lio_trace_stop(void);
+
+
+
+/**
+ * @brief Determine if spans are being recorded.
+ */
+bool lio_trace_is_enabled(void);
+
+
+
+/**
+ * @brief Discard every recorded span.
+ */
+void lio_trace_clear(void);
+
+
+
+/**
+ * @brief Write all recorded spans to a file in the Chrome trace event format,
+ * which can be opened offline in Perfetto or chrome://tracing.
+ *
+ * Spans being recorded by other threads while the file is written may be
+ * left out.
+ *
+ * @param pPath
+ * The file to write. An existing file is overwritten.
+ *
+ * @return The number of spans written, or -1 if the file could not be
+ * written.
+ */
+long long lio_trace_write(const char* const pPath);
+
+
+
+/**
+ * @brief Record a completed span on the calling thread. This is used by the
+ * library's own functions, through lio_stats_end().
+ */
+void lio_trace_record(
+    const int op,
+    const char* const pPath,
+    const uint64_t startNs,
+    const uint64_t endNs,
+    const uint64_t bytesRead,
+    const uint64_t bytesWritten);
+
+
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* LIGHT_IO_TRACE_H */
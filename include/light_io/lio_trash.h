@@ -0,0 +1,133 @@
+
+#ifndef LIGHT_IO_TRASH_H
+#define LIGHT_IO_TRASH_H
+
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+
+/**
+ * @brief Limits of the background removal workers.
+ */
+enum LioTrashLimits
+{
+    LIO_TRASH_NUM_THREADS = 4, // Folders deleted in parallel
+    LIO_TRASH_NICE        = 10 // Scheduling priority of the workers
+};
+
+
+
+/**
+ * @brief A pending removal, returned by "lio_trash_remove()".
+ */
+typedef struct LioTrashJob LioTrashJob;
+
+
+
+/**
+ * @brief Called once a removal has finished, from a background thread.
+ *
+ * @param pPath
+ * The path which was passed to "lio_trash_remove()", or the path of a trash
+ * entry for removals started by "lio_trash_recover()".
+ *
+ * @param removed
+ * TRUE if everything was deleted, FALSE if anything was left behind.
+ */
+typedef void (*LioTrashCallback)(const char* const pPath, const bool removed, void* const pUserData);
+
+
+
+/*-----------------------------------------------------------------------------
+ * Asynchronous removal
+ *
+ * A path is removed by renaming it into a hidden ".lio-trash" folder on the
+ * same filesystem, which takes a single system call no matter how large the
+ * tree is. Background workers then delete the trash, several folders at
+ * once, with a lowered CPU and I/O priority.
+ *
+ * Each filesystem's trash lives in the highest folder above the removed path
+ * which is on the same filesystem and writable by the process. Paths which
+ * cannot be renamed there, such as those under a bind mount, use a trash
+ * folder beside them instead. Anything left in a trash folder when a process
+ * exits is deleted by "lio_trash_recover()".
+ *
+ * (*NIX only)
+-----------------------------------------------------------------------------*/
+/**
+ * @brief Remove a file or folder tree without waiting for it to be deleted.
+ *
+ * @param pPath
+ * The path to remove. Symbolic links are removed rather than followed.
+ *
+ * @param callback
+ * An optional function to call once the removal has finished.
+ *
+ * @param pUserData
+ * Passed to "callback".
+ *
+ * @param ppOutJob
+ * If not NULL, set to a handle which must be passed to "lio_trash_wait()".
+ *
+ * @return TRUE if "pPath" no longer exists and is being deleted, FALSE if it
+ * could not be moved to the trash. The callback is only called when TRUE is
+ * returned.
+ */
+bool lio_trash_remove(
+    const char* const pPath,
+    LioTrashCallback callback,
+    void* const pUserData,
+    LioTrashJob** const ppOutJob);
+
+
+
+/**
+ * @brief Wait for a removal to finish and release its handle.
+ *
+ * @return TRUE if everything was deleted, FALSE if not.
+ */
+bool lio_trash_wait(LioTrashJob* const pJob);
+
+
+
+/**
+ * @brief Wait until every removal queued by this process has finished.
+ */
+void lio_trash_wait_all(void);
+
+
+
+/**
+ * @brief Delete anything left in the trash of a filesystem by a process
+ * which exited before its removals finished.
+ *
+ * This should be called on startup, with a path which the application
+ * removes files from. Removals which another process has not finished are
+ * safe to delete concurrently.
+ *
+ * @param pPath
+ * Any path on the filesystem whose trash should be emptied. A trash folder
+ * directly inside it, or beside it for files, is emptied as well.
+ *
+ * @param callback
+ * An optional function to call as each trash entry is deleted.
+ *
+ * @param pUserData
+ * Passed to "callback".
+ *
+ * @return The number of trash entries queued for deletion, or -1 if the trash
+ * could not be read.
+ */
+int lio_trash_recover(const char* const pPath, LioTrashCallback callback, void* const pUserData);
+
+
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* LIGHT_IO_TRASH_H */
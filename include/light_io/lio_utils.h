@@ -237,20 +237,151 @@ static inline float lio_utils_btol_f(float f)
  */
 static inline double lio_utils_btol_d(double d)
 {
-    float ret;
-    char* pF = (char*) & d;
+    double ret;
+    char* pD = (char*) & d;
     char* pR = (char*) & ret;
 
-    pR[0] = pF[3];
-    pR[1] = pF[2];
-    pR[2] = pF[1];
-    pR[3] = pF[0];
+    pR[0] = pD[7];
+    pR[1] = pD[6];
+    pR[2] = pD[5];
+    pR[3] = pD[4];
+    pR[4] = pD[3];
+    pR[5] = pD[2];
+    pR[6] = pD[1];
+    pR[7] = pD[0];
 
     return ret;
 }
 
 
 
+/**
+ * Swap the bytes of an array of unsigned 16-bit integers between big and
+ * little endian representation.
+ *
+ * SIMD kernels (SSSE3/AVX2 on x86, NEON on ARM) are selected at runtime when
+ * available. The source and destination arrays may be the same array for
+ * in-place swaps, but must not otherwise overlap.
+ *
+ * @param pDst
+ * A pointer to an array of at least "count" values which will contain the
+ * swapped values.
+ *
+ * @param pSrc
+ * A pointer to an array of "count" values to swap.
+ *
+ * @param count
+ * The number of values (not bytes) to swap.
+ */
+void lio_utils_btol_u16_array(uint16_t* pDst, const uint16_t* pSrc, size_t count);
+
+
+
+/**
+ * Swap the bytes of an array of signed 16-bit integers between big and
+ * little endian representation.
+ *
+ * @see lio_utils_btol_u16_array()
+ */
+static inline void lio_utils_btol_s16_array(int16_t* pDst, const int16_t* pSrc, size_t count)
+{
+    lio_utils_btol_u16_array((uint16_t*)pDst, (const uint16_t*)pSrc, count);
+}
+
+
+
+/**
+ * Swap the bytes of an array of unsigned 32-bit integers between big and
+ * little endian representation.
+ *
+ * @see lio_utils_btol_u16_array()
+ */
+void lio_utils_btol_u32_array(uint32_t* pDst, const uint32_t* pSrc, size_t count);
+
+
+
+/**
+ * Swap the bytes of an array of signed 32-bit integers between big and
+ * little endian representation.
+ *
+ * @see lio_utils_btol_u16_array()
+ */
+static inline void lio_utils_btol_s32_array(int32_t* pDst, const int32_t* pSrc, size_t count)
+{
+    lio_utils_btol_u32_array((uint32_t*)pDst, (const uint32_t*)pSrc, count);
+}
+
+
+
+/**
+ * Swap the bytes of an array of unsigned 64-bit integers between big and
+ * little endian representation.
+ *
+ * @see lio_utils_btol_u16_array()
+ */
+void lio_utils_btol_u64_array(uint64_t* pDst, const uint64_t* pSrc, size_t count);
+
+
+
+/**
+ * Swap the bytes of an array of signed 64-bit integers between big and
+ * little endian representation.
+ *
+ * @see lio_utils_btol_u16_array()
+ */
+static inline void lio_utils_btol_s64_array(int64_t* pDst, const int64_t* pSrc, size_t count)
+{
+    lio_utils_btol_u64_array((uint64_t*)pDst, (const uint64_t*)pSrc, count);
+}
+
+
+
+/**
+ * Swap the bytes of an array of 32-bit floats between big and little endian
+ * representation.
+ *
+ * @see lio_utils_btol_u16_array()
+ */
+void lio_utils_btol_f_array(float* pDst, const float* pSrc, size_t count);
+
+
+
+/**
+ * Swap the bytes of an array of 64-bit doubles between big and little endian
+ * representation.
+ *
+ * @see lio_utils_btol_u16_array()
+ */
+void lio_utils_btol_d_array(double* pDst, const double* pSrc, size_t count);
+
+
+
+/**
+ * Swap the bytes of an array of 2, 4, or 8-byte values between big and
+ * little endian representation.
+ *
+ * Unlike the typed functions, neither array needs to be aligned to its
+ * element size, which allows values to be swapped directly within packed
+ * binary buffers.
+ *
+ * @param pDst
+ * A pointer to a buffer of at least "count*elementSize" bytes which will
+ * contain the swapped values.
+ *
+ * @param pSrc
+ * A pointer to "count" values to swap. This may be the same as "pDst".
+ *
+ * @param count
+ * The number of values (not bytes) to swap.
+ *
+ * @param elementSize
+ * The size, in bytes, of each value. Single bytes are copied as-is. Sizes
+ * other than 2, 4, and 8 are supported, but are swapped without SIMD.
+ */
+void lio_utils_btol_array(void* pDst, const void* pSrc, size_t count, size_t elementSize);
+
+
+
 char* lio_utils_str_fmt(const char* fmt, ...);
 
 
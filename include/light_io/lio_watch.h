@@ -0,0 +1,199 @@
+
+#ifndef LIGHT_IO_WATCH_H
+#define LIGHT_IO_WATCH_H
+
+#include <stdbool.h>
+#include <stddef.h> // size_t
+#include <stdint.h> // uint32_t
+
+#include "light_io/lio_arena.h"
+#include "light_io/lio_dircache.h"
+#include "light_io/lio_strbuf.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+
+enum LioWatchLimits
+{
+    LIO_WATCH_POLL_MS = 100 // Longest wait between checks of folders which are polled
+};
+
+
+
+enum LioWatchChangeFlags
+{
+    LIO_WATCH_ADDED    = 0x01,
+    LIO_WATCH_REMOVED  = 0x02,
+    LIO_WATCH_MODIFIED = 0x04 // Size, modification time, or type changed
+};
+
+
+
+/**
+ * @brief A single change within a watched tree.
+ *
+ * Changes are coalesced, so each path is reported at most once per batch.
+ */
+typedef struct LioWatchChange
+{
+    const char* pPath; // Full path of the entry which changed
+    unsigned flags; // An "enum LioWatchChangeFlags"
+    uint32_t type; // An "enum LioPathType". Removed entries report their last type.
+} LioWatchChange;
+
+
+
+/**
+ * @brief Receives a batch of changes from "lio_watch_poll()".
+ *
+ * @param pChanges
+ * The changes, which remain valid until the callback returns.
+ *
+ * @param numChanges
+ * The number of changes in "pChanges". This is never zero.
+ *
+ * @param pUserData
+ * The pointer passed to "lio_watch_poll()".
+ */
+typedef void (*LioWatchCallback)(const LioWatchChange* pChanges, size_t numChanges, void* pUserData);
+
+
+
+/**
+ * @brief Watches a tree of folders and keeps their listings in memory.
+ *
+ * On Linux, every folder is watched through inotify. Events only mark the
+ * folders they occur in, and each batch rescans the marked folders once,
+ * compares them against their cached listings, and reports the differences.
+ * Writes to existing files only stat the files involved.
+ *
+ * If the event queue overflows, each folder's timestamps are compared against
+ * the disk and only those which changed are rescanned. Folders which could
+ * not be given a watch, or every folder on platforms without inotify, are
+ * checked the same way on each poll. As with "LioDirCache", only folders are
+ * validated this way, so writes to existing files are only seen through
+ * events.
+ */
+typedef struct LioWatch
+{
+    int fd; // inotify descriptor, or -1 if folders are polled
+
+    struct LioWatchFolder** ppPathSlots; // Hash table of folders by path
+    struct LioWatchFolder** ppWatchSlots; // Hash table of folders by watch descriptor
+    size_t slotCapacity;
+    size_t numFolders;
+    size_t numUnwatched; // Folders which are polled rather than watched
+
+    struct LioWatchFolder** ppDirty; // Folders to rescan in this batch
+    size_t numDirty;
+    size_t dirtyCapacity;
+
+    struct LioWatchFolder** ppRetired; // Folders removed in this batch
+    size_t numRetired;
+    size_t retiredCapacity;
+
+    struct LioWatchUpdate* pUpdates; // Files to stat in this batch
+    size_t numUpdates;
+    size_t updateCapacity;
+
+    LioWatchChange* pChanges;
+    size_t numChanges;
+    size_t changeCapacity;
+
+    LioArena batch; // Paths of the current batch
+    LioStrBuf path; // Scratch space for building paths
+    LioStrBuf root;
+} LioWatch;
+
+
+
+/**
+ * @brief Scan a tree and begin watching every folder within it. Symbolic
+ * links are not followed.
+ *
+ * @param pWatch
+ * A pointer to the watch to initialize.
+ *
+ * @param rootDir
+ * The folder to watch. It is resolved to an absolute path.
+ *
+ * @return TRUE if the tree was scanned, FALSE if not.
+ */
+bool lio_watch_init(LioWatch* const pWatch, const char* const rootDir);
+
+
+
+/**
+ * @brief Stop watching a tree and free all of its listings.
+ *
+ * @param pWatch
+ * A pointer to an initialized watch.
+ */
+void lio_watch_terminate(LioWatch* const pWatch);
+
+
+
+/**
+ * @brief Retrieve a descriptor which becomes readable when changes are
+ * pending, for use with poll() or epoll.
+ *
+ * @param pWatch
+ * A pointer to an initialized watch.
+ *
+ * @return A file descriptor, or -1 if the tree can only be polled.
+ */
+int lio_watch_fd(const LioWatch* const pWatch);
+
+
+
+/**
+ * @brief Bring all listings up to date and report what changed.
+ *
+ * @param pWatch
+ * A pointer to an initialized watch.
+ *
+ * @param timeoutMs
+ * The number of milliseconds to wait for changes if none are pending. Zero
+ * returns immediately and a negative value waits indefinitely. If any folders
+ * are polled, the wait is limited to LIO_WATCH_POLL_MS.
+ *
+ * @param callback
+ * Optional. Called once with every change in the batch, if there were any.
+ *
+ * @param pUserData
+ * Passed to the callback.
+ *
+ * @return The number of changes which were reported.
+ */
+size_t lio_watch_poll(LioWatch* const pWatch, const int timeoutMs, LioWatchCallback callback, void* const pUserData);
+
+
+
+/**
+ * @brief Retrieve the cached contents of a watched folder without touching
+ * the disk.
+ *
+ * @param pWatch
+ * A pointer to an initialized watch.
+ *
+ * @param dirPath
+ * The absolute path of a folder within the watched tree.
+ *
+ * @param pOutListing
+ * Set to the folder's contents, sorted by name. Listings remain valid until
+ * the next call to "lio_watch_poll()".
+ *
+ * @return TRUE if the folder is being watched, FALSE if not.
+ */
+bool lio_watch_list(const LioWatch* const pWatch, const char* const dirPath, LioDirListing* const pOutListing);
+
+
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* LIGHT_IO_WATCH_H */
@@ -0,0 +1,129 @@
+
+#include <stdint.h> // SIZE_MAX
+#include <stdlib.h> // malloc(), realloc(), free()
+#include <string.h> // memset()
+
+#include "light_io/lio_alloc.h"
+#include "light_io/lio_stats.h"
+
+
+
+/*-----------------------------------------------------------------------------
+ * Default allocator
+-----------------------------------------------------------------------------*/
+static void* _lio_alloc_default_allocate(void* pUserData, size_t numBytes)
+{
+    (void)pUserData;
+    return malloc(numBytes);
+}
+
+
+
+static void* _lio_alloc_default_reallocate(void* pUserData, void* pMem, size_t oldSize, size_t newSize)
+{
+    (void)pUserData;
+    (void)oldSize;
+    return realloc(pMem, newSize);
+}
+
+
+
+static void _lio_alloc_default_deallocate(void* pUserData, void* pMem)
+{
+    (void)pUserData;
+    free(pMem);
+}
+
+
+
+static const LioAllocator _LIO_DEFAULT_ALLOCATOR = {
+    &_lio_alloc_default_allocate,
+    &_lio_alloc_default_reallocate,
+    &_lio_alloc_default_deallocate,
+    NULL
+};
+
+static LioAllocator _lioAllocator = {
+    &_lio_alloc_default_allocate,
+    &_lio_alloc_default_reallocate,
+    &_lio_alloc_default_deallocate,
+    NULL
+};
+
+
+
+/*-----------------------------------------------------------------------------
+ * Allocator selection
+-----------------------------------------------------------------------------*/
+void lio_alloc_set_allocator(const LioAllocator* const pAllocator)
+{
+    if (pAllocator && pAllocator->allocate && pAllocator->reallocate && pAllocator->deallocate)
+    {
+        _lioAllocator = *pAllocator;
+    }
+    else
+    {
+        _lioAllocator = _LIO_DEFAULT_ALLOCATOR;
+    }
+}
+
+
+
+void lio_alloc_get_allocator(LioAllocator* const pOutAllocator)
+{
+    *pOutAllocator = _lioAllocator;
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Allocation
+-----------------------------------------------------------------------------*/
+void* lio_alloc_malloc(const size_t numBytes)
+{
+    LIO_STATS_ADD(LIO_STATS_ALLOCATIONS, 1);
+    return _lioAllocator.allocate(_lioAllocator.pUserData, numBytes ? numBytes : 1);
+}
+
+
+
+void* lio_alloc_calloc(const size_t count, const size_t size)
+{
+    if (size && count > SIZE_MAX / size)
+    {
+        return NULL;
+    }
+
+    const size_t numBytes = count * size;
+    void* const pMem = lio_alloc_malloc(numBytes);
+
+    if (pMem)
+    {
+        memset(pMem, 0, numBytes);
+    }
+
+    return pMem;
+}
+
+
+
+void* lio_alloc_realloc(void* const pMem, const size_t oldSize, const size_t newSize)
+{
+    if (!pMem)
+    {
+        return lio_alloc_malloc(newSize);
+    }
+
+    LIO_STATS_ADD(LIO_STATS_ALLOCATIONS, 1);
+    return _lioAllocator.reallocate(_lioAllocator.pUserData, pMem, oldSize, newSize ? newSize : 1);
+}
+
+
+
+void lio_alloc_free(void* const pMem)
+{
+    if (pMem)
+    {
+        _lioAllocator.deallocate(_lioAllocator.pUserData, pMem);
+    }
+}
@@ -0,0 +1,408 @@
+
+// expose fdatasync() and pthread_condattr_setclock()
+#ifndef _GNU_SOURCE
+    #define _GNU_SOURCE
+#endif
+
+#include <errno.h>
+#include <pthread.h>
+#include <fcntl.h> // open()
+#include <unistd.h> // pwrite(), fdatasync(), close()
+#include <sys/stat.h> // fstat()
+#include <time.h> // clock_gettime()
+
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "light_io/lio_alloc.h"
+#include "light_io/lio_error.h"
+#include "light_io/lio_files.h"
+#include "light_io/lio_stats.h"
+#include "light_io/lio_statcache.h"
+#include "light_io/lio_appender.h"
+
+
+
+/*-----------------------------------------------------------------------------
+ * Appender structure
+-----------------------------------------------------------------------------*/
+struct LioAppender
+{
+    LioFile file;
+
+    // Appends only touch these
+    atomic_uint_least64_t size;
+    atomic_uint_least64_t numUnsynced;
+    atomic_uint_least64_t allocatedSize;
+
+    pthread_mutex_t extentLock;
+    uint64_t extentSize;
+
+    // Group commit state, guarded by "lock"
+    pthread_mutex_t lock;
+    pthread_cond_t syncDone;
+    pthread_cond_t flushNeeded;
+    uint64_t numSyncsStarted;
+    uint64_t numSyncsDone;
+    int syncError;
+    bool isSyncing;
+    bool flushRequested;
+    bool isStopping;
+
+    // Background flushes
+    pthread_t flusher;
+    bool hasFlusher;
+    uint64_t syncBytes;
+    unsigned syncIntervalMs;
+};
+
+
+
+/*-----------------------------------------------------------------------------
+ * Group commit
+-----------------------------------------------------------------------------*/
+/*-------------------------------------
+ * Wait for a flush which starts after this call, leading it if no other
+ * thread is. "lock" must be held.
+------------------------------------*/
+static bool _lio_appender_sync_locked(LioAppender* const pAppender)
+{
+    // A flush already running may have started before the caller's data was
+    // written, so only the next one counts.
+    const uint64_t target = pAppender->numSyncsStarted + 1;
+
+    while (pAppender->numSyncsDone < target && !pAppender->syncError)
+    {
+        if (pAppender->isSyncing)
+        {
+            pthread_cond_wait(&pAppender->syncDone, &pAppender->lock);
+            continue;
+        }
+
+        const uint64_t syncId = ++pAppender->numSyncsStarted;
+        pAppender->isSyncing = true;
+        pthread_mutex_unlock(&pAppender->lock);
+
+        atomic_store_explicit(&pAppender->numUnsynced, 0, memory_order_relaxed);
+
+        int ret = 0;
+        do
+        {
+            ret = fdatasync(pAppender->file.fd);
+            LIO_STATS_ADD(LIO_STATS_SYSCALLS, 1);
+        }
+        while (ret != 0 && errno == EINTR);
+
+        const int err = ret != 0 ? errno : 0;
+
+        pthread_mutex_lock(&pAppender->lock);
+        pAppender->syncError = pAppender->syncError ? pAppender->syncError : err;
+        pAppender->numSyncsDone = syncId;
+        pAppender->isSyncing = false;
+        pthread_cond_broadcast(&pAppender->syncDone);
+    }
+
+    return pAppender->syncError == 0;
+}
+
+
+
+/*-------------------------------------
+ * Flush by size or time until the appender is destroyed
+------------------------------------*/
+static void* _lio_appender_flush_thread(void* pData)
+{
+    LioAppender* const pAppender = (LioAppender*)pData;
+
+    pthread_mutex_lock(&pAppender->lock);
+
+    while (!pAppender->isStopping)
+    {
+        if (!pAppender->flushRequested && pAppender->syncIntervalMs)
+        {
+            struct timespec deadline;
+            clock_gettime(CLOCK_MONOTONIC, &deadline);
+
+            const uint64_t ns = (uint64_t)deadline.tv_nsec + (uint64_t)pAppender->syncIntervalMs * 1000000ull;
+            deadline.tv_sec += (time_t)(ns / 1000000000ull);
+            deadline.tv_nsec = (long)(ns % 1000000000ull);
+
+            pthread_cond_timedwait(&pAppender->flushNeeded, &pAppender->lock, &deadline);
+        }
+        else if (!pAppender->flushRequested)
+        {
+            pthread_cond_wait(&pAppender->flushNeeded, &pAppender->lock);
+        }
+
+        pAppender->flushRequested = false;
+
+        if (!pAppender->isStopping && atomic_load_explicit(&pAppender->numUnsynced, memory_order_relaxed))
+        {
+            _lio_appender_sync_locked(pAppender);
+        }
+    }
+
+    pthread_mutex_unlock(&pAppender->lock);
+
+    return NULL;
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Creation & Destruction
+-----------------------------------------------------------------------------*/
+LioAppender* lio_appender_create(
+    const char* const restrict pPath,
+    const uint64_t extentSize,
+    const uint64_t syncBytes,
+    const unsigned syncIntervalMs,
+    const unsigned flags)
+{
+    if (!pPath)
+    {
+        lio_error_report(LIO_ERROR_INVALID_ARGUMENT, 0, "Unable to append to a file without a path", NULL, NULL);
+        return NULL;
+    }
+
+    LioAppender* const pAppender = (LioAppender*)lio_alloc_calloc(1, sizeof(LioAppender));
+    if (!pAppender)
+    {
+        lio_error_report(LIO_ERROR_OUT_OF_MEMORY, 0, "Unable to allocate an appender", pPath, NULL);
+        return NULL;
+    }
+
+    // Ranges are reserved in memory, O_APPEND would make pwrite() ignore them
+    int openFlags = O_WRONLY | O_CREAT | O_CLOEXEC;
+    openFlags |= (flags & LIO_APPENDER_TRUNCATE) ? O_TRUNC : 0;
+
+    int fd = -1;
+    do
+    {
+        fd = open(pPath, openFlags, 0666);
+        LIO_STATS_ADD(LIO_STATS_SYSCALLS, 1);
+    }
+    while (fd < 0 && errno == EINTR);
+
+    struct stat info;
+    if (fd < 0 || fstat(fd, &info) != 0)
+    {
+        lio_error_report_errno(errno, "Unable to open a file for appending", pPath, NULL);
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+        lio_alloc_free(pAppender);
+        return NULL;
+    }
+
+    lio_statcache_invalidate(pPath, false);
+
+    pAppender->file.fd = fd;
+    pAppender->file.owned = true;
+    atomic_init(&pAppender->size, (uint64_t)info.st_size);
+    atomic_init(&pAppender->numUnsynced, 0);
+    atomic_init(&pAppender->allocatedSize, (uint64_t)info.st_size);
+    pAppender->extentSize = extentSize;
+    pAppender->syncBytes = syncBytes;
+    pAppender->syncIntervalMs = syncIntervalMs;
+
+    pthread_condattr_t condAttribs;
+    pthread_condattr_init(&condAttribs);
+    pthread_condattr_setclock(&condAttribs, CLOCK_MONOTONIC);
+
+    pthread_mutex_init(&pAppender->extentLock, NULL);
+    pthread_mutex_init(&pAppender->lock, NULL);
+    pthread_cond_init(&pAppender->syncDone, NULL);
+    pthread_cond_init(&pAppender->flushNeeded, &condAttribs);
+    pthread_condattr_destroy(&condAttribs);
+
+    if (syncBytes || syncIntervalMs)
+    {
+        const int err = pthread_create(&pAppender->flusher, NULL, &_lio_appender_flush_thread, pAppender);
+        if (err != 0)
+        {
+            lio_error_report_errno(err, "Unable to start flushing an appender", pPath, NULL);
+            lio_appender_destroy(pAppender);
+            return NULL;
+        }
+
+        pAppender->hasFlusher = true;
+    }
+
+    return pAppender;
+}
+
+
+
+bool lio_appender_destroy(LioAppender* const pAppender)
+{
+    if (!pAppender)
+    {
+        return true;
+    }
+
+    if (pAppender->hasFlusher)
+    {
+        pthread_mutex_lock(&pAppender->lock);
+        pAppender->isStopping = true;
+        pthread_cond_signal(&pAppender->flushNeeded);
+        pthread_mutex_unlock(&pAppender->lock);
+
+        pthread_join(pAppender->flusher, NULL);
+    }
+
+    bool ret = lio_appender_sync(pAppender);
+    if (!lio_file_close(&pAppender->file))
+    {
+        lio_error_report_errno(errno, "Unable to close an appender", NULL, NULL);
+        ret = false;
+    }
+
+    pthread_cond_destroy(&pAppender->flushNeeded);
+    pthread_cond_destroy(&pAppender->syncDone);
+    pthread_mutex_destroy(&pAppender->lock);
+    pthread_mutex_destroy(&pAppender->extentLock);
+    lio_alloc_free(pAppender);
+
+    return ret;
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Appending
+-----------------------------------------------------------------------------*/
+/*-------------------------------------
+ * Preallocate whole extents past the end of a reserved range
+------------------------------------*/
+static void _lio_appender_extend(LioAppender* const pAppender, const uint64_t end)
+{
+    pthread_mutex_lock(&pAppender->extentLock);
+
+    const uint64_t allocated = atomic_load_explicit(&pAppender->allocatedSize, memory_order_relaxed);
+
+    if (end > allocated)
+    {
+        const uint64_t extent = pAppender->extentSize;
+        const uint64_t newSize = ((end + extent - 1) / extent) * extent;
+
+        // Writes allocate their own blocks if the filesystem cannot do this,
+        // so there is no point in asking again.
+        const bool ret = lio_file_preallocate(&pAppender->file, allocated, newSize - allocated);
+        LIO_STATS_ADD(LIO_STATS_SYSCALLS, 1);
+
+        atomic_store_explicit(&pAppender->allocatedSize, ret ? newSize : UINT64_MAX, memory_order_relaxed);
+    }
+
+    pthread_mutex_unlock(&pAppender->extentLock);
+}
+
+
+
+int64_t lio_appender_append(LioAppender* const pAppender, const void* const pData, const size_t numBytes)
+{
+    if (!pAppender || (!pData && numBytes))
+    {
+        lio_error_report(LIO_ERROR_INVALID_ARGUMENT, 0, "Unable to append without data", NULL, NULL);
+        return -1;
+    }
+
+    const uint64_t offset = atomic_fetch_add_explicit(&pAppender->size, numBytes, memory_order_relaxed);
+    const uint64_t end = offset + numBytes;
+
+    if (pAppender->extentSize && end > atomic_load_explicit(&pAppender->allocatedSize, memory_order_relaxed))
+    {
+        _lio_appender_extend(pAppender, end);
+    }
+
+    const char* pBytes = (const char*)pData;
+    size_t numWritten = 0;
+
+    while (numWritten < numBytes)
+    {
+        const ssize_t ret = pwrite(pAppender->file.fd, pBytes + numWritten, numBytes - numWritten, (off_t)(offset + numWritten));
+        LIO_STATS_ADD(LIO_STATS_SYSCALLS, 1);
+
+        if (ret < 0 && errno == EINTR)
+        {
+            continue;
+        }
+
+        if (ret <= 0)
+        {
+            lio_error_report_errno(ret < 0 ? errno : EIO, "Unable to append to a file", NULL, NULL);
+            return -1;
+        }
+
+        numWritten += (size_t)ret;
+    }
+
+    LIO_STATS_ADD(LIO_STATS_BYTES_WRITTEN, numBytes);
+
+    // Only the append which crosses the threshold wakes the flusher
+    const uint64_t numUnsynced = atomic_fetch_add_explicit(&pAppender->numUnsynced, numBytes, memory_order_relaxed);
+    const uint64_t syncBytes = pAppender->syncBytes;
+
+    if (syncBytes && numUnsynced < syncBytes && numUnsynced + numBytes >= syncBytes)
+    {
+        pthread_mutex_lock(&pAppender->lock);
+        pAppender->flushRequested = true;
+        pthread_cond_signal(&pAppender->flushNeeded);
+        pthread_mutex_unlock(&pAppender->lock);
+    }
+
+    return (int64_t)offset;
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Durability
+-----------------------------------------------------------------------------*/
+bool lio_appender_sync(LioAppender* const pAppender)
+{
+    if (!pAppender)
+    {
+        lio_error_report(LIO_ERROR_INVALID_ARGUMENT, 0, "Unable to synchronize an appender which does not exist", NULL, NULL);
+        return false;
+    }
+
+    pthread_mutex_lock(&pAppender->lock);
+    const bool ret = _lio_appender_sync_locked(pAppender);
+    const int err = pAppender->syncError;
+    pthread_mutex_unlock(&pAppender->lock);
+
+    if (!ret)
+    {
+        lio_error_report_errno(err, "Unable to synchronize an appender", NULL, NULL);
+    }
+
+    return ret;
+}
+
+
+
+uint64_t lio_appender_size(const LioAppender* const pAppender)
+{
+    return pAppender ? atomic_load_explicit(&((LioAppender*)pAppender)->size, memory_order_relaxed) : 0;
+}
+
+
+
+uint64_t lio_appender_num_syncs(const LioAppender* const pAppender)
+{
+    if (!pAppender)
+    {
+        return 0;
+    }
+
+    LioAppender* const pMutable = (LioAppender*)pAppender;
+
+    pthread_mutex_lock(&pMutable->lock);
+    const uint64_t ret = pMutable->numSyncsDone;
+    pthread_mutex_unlock(&pMutable->lock);
+
+    return ret;
+}
@@ -0,0 +1,182 @@
+
+#include <stdint.h> // SIZE_MAX
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h> // memcpy(), strlen()
+
+#include "light_io/lio_alloc.h"
+#include "light_io/lio_error.h"
+#include "light_io/lio_utils.h"
+#include "light_io/lio_arena.h"
+
+
+
+/*-----------------------------------------------------------------------------
+ * Arena block
+-----------------------------------------------------------------------------*/
+struct LioArenaBlock
+{
+    struct LioArenaBlock* pNext;
+    size_t capacity;
+    size_t used;
+};
+
+// Allocations begin on an aligned boundary after each block header
+#define LIO_ARENA_ALIGN( n ) (((n) + (LIO_ARENA_ALIGNMENT-1)) & ~(size_t)(LIO_ARENA_ALIGNMENT-1))
+#define LIO_ARENA_HEADER_SIZE LIO_ARENA_ALIGN(sizeof(struct LioArenaBlock))
+
+
+
+static struct LioArenaBlock* _lio_arena_block_create(const size_t capacity)
+{
+    if (capacity > SIZE_MAX - LIO_ARENA_HEADER_SIZE)
+    {
+        return NULL;
+    }
+
+    struct LioArenaBlock* const pBlock = (struct LioArenaBlock*)lio_alloc_malloc(LIO_ARENA_HEADER_SIZE + capacity);
+    if (!pBlock)
+    {
+        lio_error_report(LIO_ERROR_OUT_OF_MEMORY, 0, "Unable to allocate an arena block", NULL, NULL);
+        return NULL;
+    }
+
+    pBlock->pNext = NULL;
+    pBlock->capacity = capacity;
+    pBlock->used = 0;
+
+    return pBlock;
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Initialize an arena
+-----------------------------------------------------------------------------*/
+void lio_arena_init(LioArena* const pArena, const size_t blockSize)
+{
+    pArena->pBlocks = NULL;
+    pArena->blockSize = LIO_ARENA_ALIGN(blockSize ? blockSize : (size_t)LIO_ARENA_DEFAULT_BLOCK_SIZE);
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Release an arena
+-----------------------------------------------------------------------------*/
+void lio_arena_terminate(LioArena* const pArena)
+{
+    if (!pArena)
+    {
+        return;
+    }
+
+    struct LioArenaBlock* pBlock = pArena->pBlocks;
+
+    while (pBlock)
+    {
+        struct LioArenaBlock* const pNext = pBlock->pNext;
+        lio_alloc_free(pBlock);
+        pBlock = pNext;
+    }
+
+    pArena->pBlocks = NULL;
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Reset an arena
+-----------------------------------------------------------------------------*/
+void lio_arena_reset(LioArena* const pArena)
+{
+    struct LioArenaBlock* const pHead = pArena->pBlocks;
+
+    if (!pHead)
+    {
+        return;
+    }
+
+    pArena->pBlocks = pHead->pNext;
+    lio_arena_terminate(pArena);
+
+    pHead->pNext = NULL;
+    pHead->used = 0;
+    pArena->pBlocks = pHead;
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Allocate from an arena
+-----------------------------------------------------------------------------*/
+void* lio_arena_alloc(LioArena* const pArena, const size_t numBytes)
+{
+    if (numBytes > SIZE_MAX - LIO_ARENA_ALIGNMENT)
+    {
+        return NULL;
+    }
+
+    const size_t alignedSize = LIO_ARENA_ALIGN(numBytes ? numBytes : 1);
+    struct LioArenaBlock* pBlock = pArena->pBlocks;
+
+    if (pBlock && pBlock->capacity - pBlock->used >= alignedSize)
+    {
+        void* const pMem = (char*)pBlock + LIO_ARENA_HEADER_SIZE + pBlock->used;
+        pBlock->used += alignedSize;
+        return pMem;
+    }
+
+    // Oversized requests get their own block, placed behind the current one
+    // so it can continue to serve small allocations.
+    if (alignedSize > pArena->blockSize / 2 && pBlock)
+    {
+        struct LioArenaBlock* const pLarge = _lio_arena_block_create(alignedSize);
+        if (!pLarge)
+        {
+            return NULL;
+        }
+
+        pLarge->used = alignedSize;
+        pLarge->pNext = pBlock->pNext;
+        pBlock->pNext = pLarge;
+
+        return (char*)pLarge + LIO_ARENA_HEADER_SIZE;
+    }
+
+    pBlock = _lio_arena_block_create(LIO_UTILS_MAX(alignedSize, pArena->blockSize));
+    if (!pBlock)
+    {
+        return NULL;
+    }
+
+    pBlock->used = alignedSize;
+    pBlock->pNext = pArena->pBlocks;
+    pArena->pBlocks = pBlock;
+
+    return (char*)pBlock + LIO_ARENA_HEADER_SIZE;
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Copy a string into an arena
+-----------------------------------------------------------------------------*/
+char* lio_arena_str_copy(LioArena* const pArena, const char* const pStr, size_t numChars)
+{
+    if (!pStr)
+    {
+        return NULL;
+    }
+
+    numChars = numChars ? numChars : strlen(pStr);
+
+    char* const pCopy = (char*)lio_arena_alloc(pArena, numChars + 1);
+    if (pCopy)
+    {
+        memcpy(pCopy, pStr, numChars);
+        pCopy[numChars] = '\0';
+    }
+
+    return pCopy;
+}
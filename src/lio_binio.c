@@ -0,0 +1,681 @@
+
+#include <stdint.h> // SIZE_MAX
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h> // memcpy(), memmove(), memset()
+
+#include "light_io/lio_alloc.h"
+#include "light_io/lio_error.h"
+#include "light_io/lio_utils.h"
+#include "light_io/lio_files.h"
+#include "light_io/lio_binio.h"
+
+// Thanks Windows
+#ifndef restrict
+    #ifdef __restrict
+        #define restrict __restrict
+    #else
+        #define restrict
+    #endif
+#endif
+
+
+
+/*-----------------------------------------------------------------------------
+ * Binary Reader
+-----------------------------------------------------------------------------*/
+/*-------------------------------------
+ * Reset a reader to an empty state
+------------------------------------*/
+static void _lio_binreader_reset(LioBinReader* const pReader, const enum LioByteOrder order)
+{
+    memset(pReader, 0, sizeof(LioBinReader));
+    pReader->file = lio_file_wrap(-1);
+    pReader->swap = order != LIO_BYTE_ORDER_NATIVE;
+}
+
+
+
+/*-------------------------------------
+ * Read from memory
+------------------------------------*/
+bool lio_binreader_init_memory(
+    LioBinReader* const pReader,
+    const void* const pData,
+    const size_t numBytes,
+    const enum LioByteOrder order)
+{
+    if (!pReader || (!pData && numBytes))
+    {
+        lio_error_report(LIO_ERROR_INVALID_ARGUMENT, 0, "Unable to initialize a binary reader without data", NULL, NULL);
+        return false;
+    }
+
+    _lio_binreader_reset(pReader, order);
+    pReader->pData = (const unsigned char*)pData;
+    pReader->size = numBytes;
+
+    return true;
+}
+
+
+
+/*-------------------------------------
+ * Read from a mapped file
+------------------------------------*/
+bool lio_binreader_init_map(
+    LioBinReader* const pReader,
+    const LioFile* const pFile,
+    const enum LioByteOrder order)
+{
+    LioFileStat info;
+
+    if (!pReader)
+    {
+        lio_error_report(LIO_ERROR_INVALID_ARGUMENT, 0, "Unable to initialize a binary reader without a reader", NULL, NULL);
+        return false;
+    }
+
+    if (!lio_file_stat(pFile, &info))
+    {
+        return false;
+    }
+
+    if (info.type != LIO_PATH_TYPE_REGULAR)
+    {
+        lio_error_report(LIO_ERROR_NOT_A_FILE, 0, "Only regular files can be mapped by a binary reader", NULL, NULL);
+        return false;
+    }
+
+    _lio_binreader_reset(pReader, order);
+
+    // Empty files cannot be mapped but are still valid input.
+    if (!info.size)
+    {
+        return true;
+    }
+
+    pReader->pMapping = lio_file_map(pFile, &pReader->mappingSize);
+    if (!pReader->pMapping)
+    {
+        return false;
+    }
+
+    pReader->pData = (const unsigned char*)pReader->pMapping;
+    pReader->size = pReader->mappingSize;
+
+    return true;
+}
+
+
+
+/*-------------------------------------
+ * Read from a buffered file
+------------------------------------*/
+bool lio_binreader_init_file(
+    LioBinReader* const pReader,
+    const LioFile* const pFile,
+    const size_t bufferSize,
+    const enum LioByteOrder order)
+{
+    if (!pReader || !pFile || pFile->fd < 0)
+    {
+        lio_error_report(LIO_ERROR_INVALID_ARGUMENT, 0, "Unable to initialize a binary reader with an invalid file handle", NULL, NULL);
+        return false;
+    }
+
+    _lio_binreader_reset(pReader, order);
+
+    pReader->capacity = bufferSize ? bufferSize : LIO_BINIO_DEFAULT_BUFFER_SIZE;
+    pReader->pBuffer = (unsigned char*)lio_alloc_malloc(pReader->capacity);
+    if (!pReader->pBuffer)
+    {
+        lio_error_report(LIO_ERROR_OUT_OF_MEMORY, 0, "Unable to allocate a read buffer", NULL, NULL);
+        return false;
+    }
+
+    pReader->file = lio_file_wrap(pFile->fd);
+    pReader->pData = pReader->pBuffer;
+
+    return true;
+}
+
+
+
+/*-------------------------------------
+ * Release a reader
+------------------------------------*/
+void lio_binreader_terminate(LioBinReader* const pReader)
+{
+    if (!pReader)
+    {
+        return;
+    }
+
+    lio_file_unmap(pReader->pMapping, pReader->mappingSize);
+    lio_alloc_free(pReader->pBuffer);
+
+    _lio_binreader_reset(pReader, LIO_BYTE_ORDER_NATIVE);
+}
+
+
+
+/*-------------------------------------
+ * Refill the read buffer
+------------------------------------*/
+bool lio_binreader_fill(LioBinReader* const pReader, const size_t numBytes)
+{
+    const size_t numRemaining = pReader->size - pReader->pos;
+
+    if (numRemaining >= numBytes)
+    {
+        return true;
+    }
+
+    // Memory and mapped readers have no more data to give.
+    if (pReader->failed || !pReader->pBuffer)
+    {
+        pReader->failed = true;
+        return false;
+    }
+
+    if (numBytes > pReader->capacity)
+    {
+        const size_t newCapacity = LIO_UTILS_MAX(numBytes, pReader->capacity*2);
+        unsigned char* const pNewBuffer = (unsigned char*)lio_alloc_realloc(pReader->pBuffer, pReader->capacity, newCapacity);
+
+        if (!pNewBuffer)
+        {
+            lio_error_report(LIO_ERROR_OUT_OF_MEMORY, 0, "Unable to grow a read buffer", NULL, NULL);
+            pReader->failed = true;
+            return false;
+        }
+
+        pReader->pBuffer = pNewBuffer;
+        pReader->capacity = newCapacity;
+    }
+
+    memmove(pReader->pBuffer, pReader->pBuffer + pReader->pos, numRemaining);
+    pReader->windowOffset += pReader->pos;
+    pReader->pData = pReader->pBuffer;
+    pReader->pos = 0;
+    pReader->size = numRemaining;
+
+    const long long numRead = lio_file_read(&pReader->file, pReader->pBuffer + numRemaining, pReader->capacity - numRemaining);
+    if (numRead > 0)
+    {
+        pReader->size += (size_t)numRead;
+    }
+
+    if (pReader->size < numBytes)
+    {
+        pReader->failed = true;
+        return false;
+    }
+
+    return true;
+}
+
+
+
+/*-------------------------------------
+ * Zero-copy access to a block
+------------------------------------*/
+const void* lio_binreader_view(LioBinReader* const pReader, const size_t numBytes)
+{
+    if (!lio_binreader_require(pReader, numBytes))
+    {
+        return NULL;
+    }
+
+    const void* const pView = pReader->pData + pReader->pos;
+    pReader->pos += numBytes;
+
+    return pView;
+}
+
+
+
+/*-------------------------------------
+ * Skip data
+------------------------------------*/
+bool lio_binreader_skip(LioBinReader* const pReader, size_t numBytes)
+{
+    while (numBytes)
+    {
+        const size_t numAvailable = pReader->size - pReader->pos;
+
+        if (numAvailable >= numBytes)
+        {
+            pReader->pos += numBytes;
+            return true;
+        }
+
+        pReader->pos = pReader->size;
+        numBytes -= numAvailable;
+
+        if (!lio_binreader_fill(pReader, LIO_UTILS_MIN(numBytes, pReader->capacity)))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+
+/*-------------------------------------
+ * Read raw bytes
+------------------------------------*/
+bool lio_binreader_read_bytes(LioBinReader* const pReader, void* const pOut, size_t numBytes)
+{
+    unsigned char* pDst = (unsigned char*)pOut;
+    const size_t numAvailable = LIO_UTILS_MIN(pReader->size - pReader->pos, numBytes);
+
+    if (numAvailable)
+    {
+        memcpy(pDst, pReader->pData + pReader->pos, numAvailable);
+        pReader->pos += numAvailable;
+        pDst += numAvailable;
+        numBytes -= numAvailable;
+    }
+
+    if (!numBytes)
+    {
+        return true;
+    }
+
+    // Large blocks are read straight from the file rather than through the
+    // buffer, which would only add a copy.
+    if (pReader->pBuffer && !pReader->failed && numBytes >= pReader->capacity)
+    {
+        pReader->windowOffset += pReader->size;
+        pReader->pos = 0;
+        pReader->size = 0;
+
+        const long long numRead = lio_file_read(&pReader->file, pDst, numBytes);
+        if (numRead < 0 || (size_t)numRead != numBytes)
+        {
+            pReader->failed = true;
+            return false;
+        }
+
+        pReader->windowOffset += numBytes;
+        return true;
+    }
+
+    if (!lio_binreader_fill(pReader, numBytes))
+    {
+        return false;
+    }
+
+    memcpy(pDst, pReader->pData + pReader->pos, numBytes);
+    pReader->pos += numBytes;
+
+    return true;
+}
+
+
+
+/*-------------------------------------
+ * Read an array of values
+------------------------------------*/
+static bool _lio_binreader_read_array(
+    LioBinReader* const pReader,
+    void* const pOut,
+    const size_t count,
+    const size_t elementSize)
+{
+    if (count > SIZE_MAX / elementSize)
+    {
+        pReader->failed = true;
+        return false;
+    }
+
+    const size_t numBytes = count * elementSize;
+
+    if (!pReader->swap)
+    {
+        return lio_binreader_read_bytes(pReader, pOut, numBytes);
+    }
+
+    // Swap directly out of the window when possible to avoid a second pass
+    if (pReader->size - pReader->pos >= numBytes)
+    {
+        lio_utils_btol_array(pOut, pReader->pData + pReader->pos, count, elementSize);
+        pReader->pos += numBytes;
+        return true;
+    }
+
+    if (!lio_binreader_read_bytes(pReader, pOut, numBytes))
+    {
+        return false;
+    }
+
+    lio_utils_btol_array(pOut, pOut, count, elementSize);
+    return true;
+}
+
+
+
+bool lio_binreader_read_u16_array(LioBinReader* const pReader, uint16_t* const pOut, const size_t count)
+{
+    return _lio_binreader_read_array(pReader, pOut, count, sizeof(uint16_t));
+}
+
+
+
+bool lio_binreader_read_u32_array(LioBinReader* const pReader, uint32_t* const pOut, const size_t count)
+{
+    return _lio_binreader_read_array(pReader, pOut, count, sizeof(uint32_t));
+}
+
+
+
+bool lio_binreader_read_u64_array(LioBinReader* const pReader, uint64_t* const pOut, const size_t count)
+{
+    return _lio_binreader_read_array(pReader, pOut, count, sizeof(uint64_t));
+}
+
+
+
+bool lio_binreader_read_f_array(LioBinReader* const pReader, float* const pOut, const size_t count)
+{
+    return _lio_binreader_read_array(pReader, pOut, count, sizeof(float));
+}
+
+
+
+bool lio_binreader_read_d_array(LioBinReader* const pReader, double* const pOut, const size_t count)
+{
+    return _lio_binreader_read_array(pReader, pOut, count, sizeof(double));
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Binary Writer
+-----------------------------------------------------------------------------*/
+/*-------------------------------------
+ * Common initialization
+------------------------------------*/
+static bool _lio_binwriter_init(
+    LioBinWriter* const pWriter,
+    const int fd,
+    const size_t bufferSize,
+    const enum LioByteOrder order)
+{
+    memset(pWriter, 0, sizeof(LioBinWriter));
+
+    pWriter->capacity = bufferSize ? bufferSize : LIO_BINIO_DEFAULT_BUFFER_SIZE;
+    pWriter->pBuffer = (unsigned char*)lio_alloc_malloc(pWriter->capacity);
+    pWriter->file = lio_file_wrap(fd);
+    pWriter->swap = order != LIO_BYTE_ORDER_NATIVE;
+
+    if (!pWriter->pBuffer)
+    {
+        lio_error_report(LIO_ERROR_OUT_OF_MEMORY, 0, "Unable to allocate a write buffer", NULL, NULL);
+        pWriter->capacity = 0;
+        return false;
+    }
+
+    return true;
+}
+
+
+
+/*-------------------------------------
+ * Write to memory
+------------------------------------*/
+bool lio_binwriter_init_memory(
+    LioBinWriter* const pWriter,
+    const size_t initialCapacity,
+    const enum LioByteOrder order)
+{
+    if (!pWriter)
+    {
+        return false;
+    }
+
+    return _lio_binwriter_init(pWriter, -1, initialCapacity, order);
+}
+
+
+
+/*-------------------------------------
+ * Write to a buffered file
+------------------------------------*/
+bool lio_binwriter_init_file(
+    LioBinWriter* const pWriter,
+    const LioFile* const pFile,
+    const size_t bufferSize,
+    const enum LioByteOrder order)
+{
+    if (!pWriter || !pFile || pFile->fd < 0)
+    {
+        lio_error_report(LIO_ERROR_INVALID_ARGUMENT, 0, "Unable to initialize a binary writer with an invalid file handle", NULL, NULL);
+        return false;
+    }
+
+    return _lio_binwriter_init(pWriter, pFile->fd, bufferSize, order);
+}
+
+
+
+/*-------------------------------------
+ * Release a writer
+------------------------------------*/
+bool lio_binwriter_terminate(LioBinWriter* const pWriter)
+{
+    if (!pWriter)
+    {
+        return false;
+    }
+
+    const bool ret = lio_binwriter_flush(pWriter) && !pWriter->failed;
+
+    lio_alloc_free(pWriter->pBuffer);
+    memset(pWriter, 0, sizeof(LioBinWriter));
+    pWriter->file = lio_file_wrap(-1);
+
+    return ret;
+}
+
+
+
+/*-------------------------------------
+ * Flush buffered data
+------------------------------------*/
+bool lio_binwriter_flush(LioBinWriter* const pWriter)
+{
+    if (pWriter->failed)
+    {
+        return false;
+    }
+
+    if (pWriter->file.fd < 0 || !pWriter->pos)
+    {
+        return true;
+    }
+
+    if (!lio_file_write(&pWriter->file, pWriter->pBuffer, pWriter->pos))
+    {
+        pWriter->failed = true;
+        return false;
+    }
+
+    pWriter->numFlushed += pWriter->pos;
+    pWriter->pos = 0;
+
+    return true;
+}
+
+
+
+/*-------------------------------------
+ * Make room for more data
+------------------------------------*/
+bool lio_binwriter_make_room(LioBinWriter* const pWriter, const size_t numBytes)
+{
+    if (pWriter->capacity - pWriter->pos >= numBytes)
+    {
+        return true;
+    }
+
+    if (pWriter->file.fd >= 0)
+    {
+        if (!lio_binwriter_flush(pWriter))
+        {
+            return false;
+        }
+
+        if (pWriter->capacity >= numBytes)
+        {
+            return true;
+        }
+    }
+
+    if (pWriter->failed || numBytes > SIZE_MAX/2 - pWriter->pos)
+    {
+        pWriter->failed = true;
+        return false;
+    }
+
+    size_t newCapacity = LIO_UTILS_MAX(pWriter->capacity, (size_t)LIO_BINIO_DEFAULT_BUFFER_SIZE);
+    while (newCapacity - pWriter->pos < numBytes)
+    {
+        newCapacity *= 2;
+    }
+
+    unsigned char* const pNewBuffer = (unsigned char*)lio_alloc_realloc(pWriter->pBuffer, pWriter->capacity, newCapacity);
+    if (!pNewBuffer)
+    {
+        lio_error_report(LIO_ERROR_OUT_OF_MEMORY, 0, "Unable to grow a write buffer", NULL, NULL);
+        pWriter->failed = true;
+        return false;
+    }
+
+    pWriter->pBuffer = pNewBuffer;
+    pWriter->capacity = newCapacity;
+
+    return true;
+}
+
+
+
+/*-------------------------------------
+ * Write raw bytes
+------------------------------------*/
+bool lio_binwriter_write_bytes(LioBinWriter* const pWriter, const void* const pData, size_t numBytes)
+{
+    // Large blocks are written straight to the file rather than through the
+    // buffer, which would only add a copy.
+    if (pWriter->file.fd >= 0 && numBytes >= pWriter->capacity)
+    {
+        if (!lio_binwriter_flush(pWriter))
+        {
+            return false;
+        }
+
+        if (!lio_file_write(&pWriter->file, pData, numBytes))
+        {
+            pWriter->failed = true;
+            return false;
+        }
+
+        pWriter->numFlushed += numBytes;
+        return true;
+    }
+
+    if (!lio_binwriter_reserve(pWriter, numBytes))
+    {
+        return false;
+    }
+
+    memcpy(pWriter->pBuffer + pWriter->pos, pData, numBytes);
+    pWriter->pos += numBytes;
+
+    return true;
+}
+
+
+
+/*-------------------------------------
+ * Write an array of values
+------------------------------------*/
+static bool _lio_binwriter_write_array(
+    LioBinWriter* const pWriter,
+    const void* const pData,
+    size_t count,
+    const size_t elementSize)
+{
+    if (count > SIZE_MAX / elementSize)
+    {
+        pWriter->failed = true;
+        return false;
+    }
+
+    if (!pWriter->swap)
+    {
+        return lio_binwriter_write_bytes(pWriter, pData, count * elementSize);
+    }
+
+    // Values are swapped directly into the buffer, one buffer-full at a time
+    // for files.
+    const unsigned char* pSrc = (const unsigned char*)pData;
+    const size_t maxPerBlock = (pWriter->file.fd >= 0) ? LIO_UTILS_MAX(pWriter->capacity / elementSize, (size_t)1) : count;
+
+    while (count)
+    {
+        const size_t numValues = LIO_UTILS_MIN(count, maxPerBlock);
+        const size_t numBytes = numValues * elementSize;
+
+        if (!lio_binwriter_reserve(pWriter, numBytes))
+        {
+            return false;
+        }
+
+        lio_utils_btol_array(pWriter->pBuffer + pWriter->pos, pSrc, numValues, elementSize);
+        pWriter->pos += numBytes;
+        pSrc += numBytes;
+        count -= numValues;
+    }
+
+    return true;
+}
+
+
+
+bool lio_binwriter_write_u16_array(LioBinWriter* const pWriter, const uint16_t* const pData, const size_t count)
+{
+    return _lio_binwriter_write_array(pWriter, pData, count, sizeof(uint16_t));
+}
+
+
+
+bool lio_binwriter_write_u32_array(LioBinWriter* const pWriter, const uint32_t* const pData, const size_t count)
+{
+    return _lio_binwriter_write_array(pWriter, pData, count, sizeof(uint32_t));
+}
+
+
+
+bool lio_binwriter_write_u64_array(LioBinWriter* const pWriter, const uint64_t* const pData, const size_t count)
+{
+    return _lio_binwriter_write_array(pWriter, pData, count, sizeof(uint64_t));
+}
+
+
+
+bool lio_binwriter_write_f_array(LioBinWriter* const pWriter, const float* const pData, const size_t count)
+{
+    return _lio_binwriter_write_array(pWriter, pData, count, sizeof(float));
+}
+
+
+
+bool lio_binwriter_write_d_array(LioBinWriter* const pWriter, const double* const pData, const size_t count)
+{
+    return _lio_binwriter_write_array(pWriter, pData, count, sizeof(double));
+}
@@ -0,0 +1,260 @@
+
+// expose MAP_ANONYMOUS, MAP_HUGETLB, and MADV_HUGEPAGE
+#ifndef _GNU_SOURCE
+    #define _GNU_SOURCE
+#endif
+
+#include <errno.h>
+#include <pthread.h>
+#include <sys/mman.h> // mmap(), munmap(), madvise()
+
+#include <stdint.h> // uintptr_t
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "light_io/lio_alloc.h"
+#include "light_io/lio_error.h"
+#include "light_io/lio_bufpool.h"
+
+
+
+/*-----------------------------------------------------------------------------
+ * Buffer pool structure
+-----------------------------------------------------------------------------*/
+struct LioBufferPool
+{
+    pthread_mutex_t lock;
+    pthread_cond_t available;
+
+    char* pMemory;
+    size_t numMappedBytes;
+    size_t bufferSize;
+
+    unsigned* pFreeList;
+    unsigned numFree;
+    unsigned numBuffers;
+
+    bool hugePages;
+};
+
+
+
+/*-----------------------------------------------------------------------------
+ * Map memory for all buffers in a pool
+-----------------------------------------------------------------------------*/
+static char* _lio_bufpool_map(const size_t numBytes, const unsigned flags, bool* const pOutHuge)
+{
+    void* pMem = MAP_FAILED;
+    *pOutHuge = false;
+
+    #if defined(MAP_HUGETLB)
+        if (flags & LIO_BUFFER_POOL_HUGE_PAGES)
+        {
+            pMem = mmap(NULL, numBytes, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS|MAP_HUGETLB, -1, 0);
+            *pOutHuge = pMem != MAP_FAILED;
+        }
+    #endif
+
+    // Most systems do not reserve any explicit huge pages.
+    if (pMem == MAP_FAILED)
+    {
+        pMem = mmap(NULL, numBytes, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+
+        #if defined(MADV_HUGEPAGE)
+            if (pMem != MAP_FAILED && (flags & LIO_BUFFER_POOL_HUGE_PAGES))
+            {
+                *pOutHuge = madvise(pMem, numBytes, MADV_HUGEPAGE) == 0;
+            }
+        #endif
+    }
+
+    return (pMem != MAP_FAILED) ? (char*)pMem : NULL;
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Create a buffer pool
+-----------------------------------------------------------------------------*/
+LioBufferPool* lio_bufpool_create(
+    const size_t bufferSize,
+    const unsigned numBuffers,
+    const unsigned flags)
+{
+    if (!bufferSize || !numBuffers)
+    {
+        lio_error_report(LIO_ERROR_INVALID_ARGUMENT, 0, "Unable to create a buffer pool with no buffers", NULL, NULL);
+        return NULL;
+    }
+
+    const size_t alignedSize = (bufferSize + LIO_BUFFER_POOL_ALIGNMENT - 1) & ~(size_t)(LIO_BUFFER_POOL_ALIGNMENT - 1);
+    size_t numBytes = alignedSize * numBuffers;
+
+    if (flags & LIO_BUFFER_POOL_HUGE_PAGES)
+    {
+        numBytes = (numBytes + LIO_BUFFER_POOL_HUGE_PAGE_SIZE - 1) & ~(size_t)(LIO_BUFFER_POOL_HUGE_PAGE_SIZE - 1);
+    }
+
+    LioBufferPool* const pPool = (LioBufferPool*)lio_alloc_calloc(1, sizeof(LioBufferPool));
+    unsigned* const pFreeList = (unsigned*)lio_alloc_calloc(numBuffers, sizeof(unsigned));
+
+    if (!pPool || !pFreeList)
+    {
+        lio_error_report(LIO_ERROR_OUT_OF_MEMORY, 0, "Unable to allocate a buffer pool", NULL, NULL);
+        lio_alloc_free(pFreeList);
+        lio_alloc_free(pPool);
+        return NULL;
+    }
+
+    pPool->pMemory = _lio_bufpool_map(numBytes, flags, &pPool->hugePages);
+    if (!pPool->pMemory)
+    {
+        lio_error_report_errno(errno, "Unable to map memory for a buffer pool", NULL, NULL);
+        lio_alloc_free(pFreeList);
+        lio_alloc_free(pPool);
+        return NULL;
+    }
+
+    pthread_mutex_init(&pPool->lock, NULL);
+    pthread_cond_init(&pPool->available, NULL);
+
+    pPool->numMappedBytes = numBytes;
+    pPool->bufferSize = alignedSize;
+    pPool->pFreeList = pFreeList;
+    pPool->numFree = numBuffers;
+    pPool->numBuffers = numBuffers;
+
+    // Hand out buffers from the front of the mapping first
+    for (unsigned i = 0; i < numBuffers; ++i)
+    {
+        pFreeList[i] = numBuffers - i - 1;
+    }
+
+    return pPool;
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Destroy a buffer pool
+-----------------------------------------------------------------------------*/
+void lio_bufpool_destroy(LioBufferPool* const pPool)
+{
+    if (!pPool)
+    {
+        return;
+    }
+
+    if (pPool->numFree != pPool->numBuffers)
+    {
+        lio_error_report(LIO_ERROR_INVALID_ARGUMENT, 0, "Destroying a buffer pool with buffers in use", NULL, NULL);
+    }
+
+    munmap(pPool->pMemory, pPool->numMappedBytes);
+    pthread_cond_destroy(&pPool->available);
+    pthread_mutex_destroy(&pPool->lock);
+    lio_alloc_free(pPool->pFreeList);
+    lio_alloc_free(pPool);
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Process-wide pool
+-----------------------------------------------------------------------------*/
+static pthread_once_t _lioSharedPoolOnce = PTHREAD_ONCE_INIT;
+static LioBufferPool* _pLioSharedPool = NULL;
+
+static void _lio_bufpool_create_shared(void)
+{
+    _pLioSharedPool = lio_bufpool_create(
+        LIO_BUFFER_POOL_DEFAULT_BUFFER_SIZE,
+        LIO_BUFFER_POOL_DEFAULT_COUNT,
+        LIO_BUFFER_POOL_HUGE_PAGES);
+}
+
+LioBufferPool* lio_bufpool_shared(void)
+{
+    pthread_once(&_lioSharedPoolOnce, &_lio_bufpool_create_shared);
+    return _pLioSharedPool;
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Acquire a buffer
+-----------------------------------------------------------------------------*/
+void* lio_bufpool_acquire(LioBufferPool* const pPool)
+{
+    pthread_mutex_lock(&pPool->lock);
+
+    while (!pPool->numFree)
+    {
+        pthread_cond_wait(&pPool->available, &pPool->lock);
+    }
+
+    const unsigned index = pPool->pFreeList[--pPool->numFree];
+
+    pthread_mutex_unlock(&pPool->lock);
+
+    return pPool->pMemory + (pPool->bufferSize * index);
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Acquire a buffer without blocking
+-----------------------------------------------------------------------------*/
+void* lio_bufpool_try_acquire(LioBufferPool* const pPool)
+{
+    void* pBuffer = NULL;
+
+    pthread_mutex_lock(&pPool->lock);
+
+    if (pPool->numFree)
+    {
+        const unsigned index = pPool->pFreeList[--pPool->numFree];
+        pBuffer = pPool->pMemory + (pPool->bufferSize * index);
+    }
+
+    pthread_mutex_unlock(&pPool->lock);
+
+    return pBuffer;
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Release a buffer
+-----------------------------------------------------------------------------*/
+void lio_bufpool_release(LioBufferPool* const pPool, void* const pBuffer)
+{
+    if (!pBuffer)
+    {
+        return;
+    }
+
+    const uintptr_t offset = (uintptr_t)pBuffer - (uintptr_t)pPool->pMemory;
+
+    pthread_mutex_lock(&pPool->lock);
+    pPool->pFreeList[pPool->numFree++] = (unsigned)(offset / pPool->bufferSize);
+    pthread_cond_signal(&pPool->available);
+    pthread_mutex_unlock(&pPool->lock);
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Pool properties
+-----------------------------------------------------------------------------*/
+size_t lio_bufpool_buffer_size(const LioBufferPool* const pPool)
+{
+    return pPool->bufferSize;
+}
+
+
+
+bool lio_bufpool_is_huge(const LioBufferPool* const pPool)
+{
+    return pPool->hugePages;
+}
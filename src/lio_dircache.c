@@ -0,0 +1,996 @@
+
+#include <stdio.h>
+#include <stdlib.h> // qsort()
+#include <string.h> // memcmp(), memcpy(), memset(), strlen()
+
+#include "light_io/lio_alloc.h"
+#include "light_io/lio_arena.h"
+#include "light_io/lio_binio.h"
+#include "light_io/lio_error.h"
+#include "light_io/lio_files.h"
+#include "light_io/lio_paths.h"
+#include "light_io/lio_pathview.h"
+#include "light_io/lio_strbuf.h"
+#include "light_io/lio_dircache.h"
+
+
+
+/*-----------------------------------------------------------------------------
+ * Internal Structures
+ *
+ * A snapshot is a header followed by the folder records sorted by path, then
+ * all entry records, then a pool of NULL-terminated strings holding the root,
+ * each folder's path, and each entry's name. Every section is a multiple of
+ * 8 bytes so the records can be used directly from the mapping. Snapshots are
+ * written in native byte order and rejected on machines which differ.
+ *
+ * Folders which have been rescanned since the snapshot was written, or which
+ * are not in it, live in the cache's arena as overlays. Overlays are never
+ * freed before the cache is closed, so listings remain valid.
+-----------------------------------------------------------------------------*/
+#define LIO_DIRCACHE_MAGIC 0x44494F4Cu // "LIOD"
+#define LIO_DIRCACHE_VERSION 1u
+#define LIO_DIRCACHE_BYTE_ORDER_MARK 0x01020304u
+
+enum LioDirCacheState
+{
+    LIO_DIRCACHE_UNCHECKED,
+    LIO_DIRCACHE_CURRENT,
+    LIO_DIRCACHE_REPLACED,
+    LIO_DIRCACHE_REMOVED
+};
+
+enum LioDirCacheInternalLimits
+{
+    LIO_DIRCACHE_MIN_EXTRAS = 64
+};
+
+typedef struct LioDirCacheHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t byteOrder;
+    uint32_t reserved;
+    uint64_t numFolders;
+    uint64_t numEntries;
+    uint64_t namesSize;
+    uint64_t rootOffset;
+    uint64_t rootLength;
+    uint64_t reserved2;
+} LioDirCacheHeader;
+
+typedef struct LioDirCacheOverlay
+{
+    LioDirCacheFolder folder;
+    const char* pPath;
+    LioDirListing listing;
+    bool isRemoved;
+} LioDirCacheOverlay;
+
+typedef struct LioDirCacheSaveItem
+{
+    const char* pPath;
+    size_t pathLength;
+    const LioDirCacheFolder* pFolder;
+    LioDirListing listing;
+} LioDirCacheSaveItem;
+
+
+
+/*-----------------------------------------------------------------------------
+ * Path Helpers
+-----------------------------------------------------------------------------*/
+static inline int _lio_dircache_compare_n(const char* const pA, const size_t lengthA, const char* const pB, const size_t lengthB)
+{
+    const int cmp = memcmp(pA, pB, (lengthA < lengthB) ? lengthA : lengthB);
+    return cmp ? cmp : ((lengthA > lengthB) - (lengthA < lengthB));
+}
+
+
+
+static inline size_t _lio_dircache_trim(const char* const pPath, size_t length)
+{
+    while (length > 1 && pPath[length-1] == LIO_PATH_SEP)
+    {
+        --length;
+    }
+
+    return length;
+}
+
+
+
+static inline bool _lio_dircache_is_beneath_root(const LioDirCache* const pCache, const char* const pPath, const size_t length)
+{
+    const char* const pRoot = lio_strbuf_cstr(&pCache->root);
+    const size_t rootLength = pCache->root.length;
+
+    return length >= rootLength
+        && memcmp(pPath, pRoot, rootLength) == 0
+        && (length == rootLength || pPath[rootLength] == LIO_PATH_SEP || pRoot[rootLength-1] == LIO_PATH_SEP);
+}
+
+
+
+static inline uint64_t _lio_dircache_hash(const char* const pPath, const size_t length)
+{
+    uint64_t hash = 0xCBF29CE484222325ull;
+
+    for (size_t i = 0; i < length; ++i)
+    {
+        hash = (hash ^ (unsigned char)pPath[i]) * 0x100000001B3ull;
+    }
+
+    return hash;
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Folder Lookups
+-----------------------------------------------------------------------------*/
+/*-------------------------------------
+ * Binary search the mapped folders. Returns "numFolders" if not found.
+-------------------------------------*/
+static size_t _lio_dircache_find_mapped(const LioDirCache* const pCache, const char* const pPath, const size_t length)
+{
+    size_t lo = 0;
+    size_t hi = pCache->numFolders;
+
+    while (lo < hi)
+    {
+        const size_t mid = lo + (hi - lo) / 2;
+        const LioDirCacheFolder* const pFolder = pCache->pFolders + mid;
+        const int cmp = _lio_dircache_compare_n(pCache->pNames + pFolder->pathOffset, (size_t)pFolder->pathLength, pPath, length);
+
+        if (cmp == 0)
+        {
+            return mid;
+        }
+
+        if (cmp < 0)
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+
+    return pCache->numFolders;
+}
+
+
+
+/*-------------------------------------
+ * Find the hash slot of a folder which is not in the snapshot. Empty slots
+ * hold 0, and occupied slots hold an index into "ppExtras" plus 1.
+-------------------------------------*/
+static size_t _lio_dircache_find_extra_slot(const LioDirCache* const pCache, const char* const pPath, const size_t length)
+{
+    const size_t mask = pCache->extraSlotCapacity - 1;
+    size_t slot = (size_t)_lio_dircache_hash(pPath, length) & mask;
+
+    while (pCache->pExtraSlots[slot])
+    {
+        const LioDirCacheOverlay* const pOverlay = pCache->ppExtras[pCache->pExtraSlots[slot] - 1];
+        if (pOverlay->folder.pathLength == length && memcmp(pOverlay->pPath, pPath, length) == 0)
+        {
+            break;
+        }
+        slot = (slot + 1) & mask;
+    }
+
+    return slot;
+}
+
+
+
+static LioDirCacheOverlay* _lio_dircache_find_extra(const LioDirCache* const pCache, const char* const pPath, const size_t length)
+{
+    if (!pCache->extraSlotCapacity)
+    {
+        return NULL;
+    }
+
+    const uint32_t index = pCache->pExtraSlots[_lio_dircache_find_extra_slot(pCache, pPath, length)];
+    return index ? pCache->ppExtras[index - 1] : NULL;
+}
+
+
+
+static bool _lio_dircache_add_extra(LioDirCache* const pCache, LioDirCacheOverlay* const pOverlay)
+{
+    if (pCache->numExtras == pCache->extraCapacity)
+    {
+        const size_t capacity = pCache->extraCapacity ? pCache->extraCapacity * 2 : (size_t)LIO_DIRCACHE_MIN_EXTRAS;
+        LioDirCacheOverlay** const ppExtras = (LioDirCacheOverlay**)lio_alloc_realloc(
+            pCache->ppExtras,
+            pCache->extraCapacity * sizeof(LioDirCacheOverlay*),
+            capacity * sizeof(LioDirCacheOverlay*));
+        uint32_t* const pSlots = (uint32_t*)lio_alloc_calloc(capacity * 2, sizeof(uint32_t));
+
+        if (!ppExtras || !pSlots)
+        {
+            if (ppExtras)
+            {
+                pCache->ppExtras = ppExtras;
+                pCache->extraCapacity = capacity;
+            }
+            lio_alloc_free(pSlots);
+            return false;
+        }
+
+        // The table is kept at most half full
+        lio_alloc_free(pCache->pExtraSlots);
+        pCache->ppExtras = ppExtras;
+        pCache->extraCapacity = capacity;
+        pCache->pExtraSlots = pSlots;
+        pCache->extraSlotCapacity = capacity * 2;
+
+        for (size_t i = 0; i < pCache->numExtras; ++i)
+        {
+            const LioDirCacheOverlay* const pExtra = pCache->ppExtras[i];
+            pSlots[_lio_dircache_find_extra_slot(pCache, pExtra->pPath, (size_t)pExtra->folder.pathLength)] = (uint32_t)(i + 1);
+        }
+    }
+
+    pCache->ppExtras[pCache->numExtras++] = pOverlay;
+    pCache->pExtraSlots[_lio_dircache_find_extra_slot(pCache, pOverlay->pPath, (size_t)pOverlay->folder.pathLength)] = (uint32_t)pCache->numExtras;
+
+    return true;
+}
+
+
+
+/*-------------------------------------
+ * Check that a mapped folder's entries lie within the snapshot
+-------------------------------------*/
+static bool _lio_dircache_check_entries(const LioDirCache* const pCache, const LioDirCacheFolder* const pFolder)
+{
+    const LioDirCacheEntry* const pEntries = pCache->pEntries + pFolder->firstEntry;
+
+    for (uint64_t i = 0; i < pFolder->numEntries; ++i)
+    {
+        if (pEntries[i].nameOffset >= pCache->namesSize
+        || pEntries[i].nameLength >= pCache->namesSize - pEntries[i].nameOffset
+        || pCache->pNames[pEntries[i].nameOffset + pEntries[i].nameLength] != '\0')
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+
+static inline LioDirListing _lio_dircache_mapped_listing(const LioDirCache* const pCache, const LioDirCacheFolder* const pFolder)
+{
+    LioDirListing listing;
+    listing.pEntries = pCache->pEntries + pFolder->firstEntry;
+    listing.numEntries = (size_t)pFolder->numEntries;
+    listing.pNames = pCache->pNames;
+    return listing;
+}
+
+
+
+/*-------------------------------------
+ * Rescan a folder into a NULL-terminated copy of its path, marking it as
+ * removed if it can no longer be read.
+-------------------------------------*/
+static bool _lio_dircache_rescan_n(LioDirCache* const pCache, const char* const pPath, const size_t length, const size_t mappedIndex, LioDirListing* const pOutListing)
+{
+    LioStrBuf path;
+    bool ret;
+
+    lio_strbuf_init(&path);
+    if (!lio_strbuf_append_n(&path, pPath, length))
+    {
+        return false;
+    }
+
+    ret = lio_dircache_rescan(pCache, path.pData, pOutListing);
+    lio_strbuf_terminate(&path);
+
+    if (!ret && mappedIndex < pCache->numFolders)
+    {
+        pCache->pStates[mappedIndex] = LIO_DIRCACHE_REMOVED;
+    }
+    else if (!ret)
+    {
+        LioDirCacheOverlay* const pExtra = _lio_dircache_find_extra(pCache, pPath, length);
+        if (pExtra)
+        {
+            pExtra->isRemoved = true;
+        }
+    }
+
+    return ret;
+}
+
+
+
+static bool _lio_dircache_list_n(LioDirCache* const pCache, const char* const pPath, size_t length, LioDirListing* const pOutListing)
+{
+    length = _lio_dircache_trim(pPath, length);
+    if (!_lio_dircache_is_beneath_root(pCache, pPath, length))
+    {
+        return false;
+    }
+
+    const size_t index = _lio_dircache_find_mapped(pCache, pPath, length);
+    if (index < pCache->numFolders)
+    {
+        const LioDirCacheFolder* const pFolder = pCache->pFolders + index;
+
+        switch (pCache->pStates[index])
+        {
+            case LIO_DIRCACHE_CURRENT:
+                *pOutListing = _lio_dircache_mapped_listing(pCache, pFolder);
+                return true;
+
+            case LIO_DIRCACHE_REPLACED:
+                *pOutListing = pCache->ppOverlays[index]->listing;
+                return true;
+
+            case LIO_DIRCACHE_REMOVED:
+                return false;
+
+            default:
+                break;
+        }
+
+        if (lio_dircache_is_current(pCache->pNames + pFolder->pathOffset, pFolder) && _lio_dircache_check_entries(pCache, pFolder))
+        {
+            pCache->pStates[index] = LIO_DIRCACHE_CURRENT;
+            *pOutListing = _lio_dircache_mapped_listing(pCache, pFolder);
+            return true;
+        }
+
+        return _lio_dircache_rescan_n(pCache, pPath, length, index, pOutListing);
+    }
+
+    const LioDirCacheOverlay* const pExtra = _lio_dircache_find_extra(pCache, pPath, length);
+    if (pExtra)
+    {
+        *pOutListing = pExtra->listing;
+        return !pExtra->isRemoved;
+    }
+
+    // Folders created after the snapshot are scanned on first use
+    return _lio_dircache_rescan_n(pCache, pPath, length, pCache->numFolders, pOutListing);
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Construction
+-----------------------------------------------------------------------------*/
+/*-------------------------------------
+ * Initialize an empty cache
+-------------------------------------*/
+bool lio_dircache_init(LioDirCache* const pCache, const char* const rootDir)
+{
+    char* pRoot;
+
+    memset(pCache, 0, sizeof(LioDirCache));
+    lio_arena_init(&pCache->arena, 0);
+    lio_strbuf_init(&pCache->root);
+
+    pRoot = lio_path_resolve(rootDir);
+    if (!pRoot || !lio_strbuf_append_n(&pCache->root, pRoot, _lio_dircache_trim(pRoot, strlen(pRoot))))
+    {
+        lio_path_destroy(pRoot);
+        lio_dircache_close(pCache);
+        return false;
+    }
+
+    lio_path_destroy(pRoot);
+    return true;
+}
+
+
+
+/*-------------------------------------
+ * Recursively scan a folder
+-------------------------------------*/
+static bool _lio_dircache_build_folder(LioDirCache* const pCache, LioStrBuf* const pPath)
+{
+    const size_t baseLength = pPath->length;
+    LioDirListing listing;
+
+    if (!lio_dircache_rescan(pCache, pPath->pData, &listing))
+    {
+        return false;
+    }
+
+    for (size_t i = 0; i < listing.numEntries; ++i)
+    {
+        if (listing.pEntries[i].type != LIO_PATH_TYPE_FOLDER)
+        {
+            continue;
+        }
+
+        lio_strbuf_truncate(pPath, baseLength);
+        if (((!baseLength || pPath->pData[baseLength-1] != LIO_PATH_SEP) && !lio_strbuf_append_char(pPath, LIO_PATH_SEP))
+        || !lio_strbuf_append_n(pPath, lio_dirlisting_name(&listing, i), listing.pEntries[i].nameLength))
+        {
+            return false;
+        }
+
+        // Folders may vanish while they are being scanned
+        if (!_lio_dircache_build_folder(pCache, pPath) && lio_path_does_exist(pPath->pData, LIO_PATH_TYPE_FOLDER))
+        {
+            return false;
+        }
+    }
+
+    lio_strbuf_truncate(pPath, baseLength);
+    return true;
+}
+
+
+
+/*-------------------------------------
+ * Build from the file system
+-------------------------------------*/
+bool lio_dircache_build(LioDirCache* const pCache, const char* const rootDir)
+{
+    LioStrBuf path;
+    bool ret;
+
+    if (!lio_dircache_init(pCache, rootDir))
+    {
+        return false;
+    }
+
+    lio_strbuf_init(&path);
+    ret = lio_strbuf_append(&path, lio_strbuf_cstr(&pCache->root)) && _lio_dircache_build_folder(pCache, &path);
+    lio_strbuf_terminate(&path);
+
+    if (!ret)
+    {
+        lio_error_report(LIO_ERROR_IO, 0, "Unable to scan a folder", rootDir, NULL);
+        lio_dircache_close(pCache);
+    }
+
+    return ret;
+}
+
+
+
+/*-------------------------------------
+ * Open a snapshot
+-------------------------------------*/
+bool lio_dircache_open(LioDirCache* const pCache, const char* const snapshotPath)
+{
+    LioFile file;
+    const LioDirCacheHeader* pHeader;
+    const unsigned char* pData;
+    size_t numBytes = 0;
+    uint64_t foldersSize;
+    uint64_t entriesSize;
+
+    memset(pCache, 0, sizeof(LioDirCache));
+    lio_arena_init(&pCache->arena, 0);
+    lio_strbuf_init(&pCache->root);
+
+    if (!lio_file_open(&file, snapshotPath, LIO_FILE_OPEN_READ))
+    {
+        return false;
+    }
+
+    // The mapping outlives the file handle
+    pData = (const unsigned char*)lio_file_map(&file, &numBytes);
+    lio_file_close(&file);
+
+    pCache->pMapping = pData;
+    pCache->mappingSize = numBytes;
+    pHeader = (const LioDirCacheHeader*)pData;
+
+    if (!pData
+    || numBytes < sizeof(LioDirCacheHeader)
+    || pHeader->magic != LIO_DIRCACHE_MAGIC
+    || pHeader->version != LIO_DIRCACHE_VERSION
+    || pHeader->byteOrder != LIO_DIRCACHE_BYTE_ORDER_MARK
+    || pHeader->numFolders > (numBytes / sizeof(LioDirCacheFolder))
+    || pHeader->numEntries > (numBytes / sizeof(LioDirCacheEntry)))
+    {
+        lio_error_report(LIO_ERROR_CORRUPT, 0, "Not a compatible directory snapshot", snapshotPath, NULL);
+        lio_dircache_close(pCache);
+        return false;
+    }
+
+    foldersSize = pHeader->numFolders * sizeof(LioDirCacheFolder);
+    entriesSize = pHeader->numEntries * sizeof(LioDirCacheEntry);
+
+    if (sizeof(LioDirCacheHeader) + foldersSize + entriesSize > numBytes
+    || pHeader->namesSize != numBytes - sizeof(LioDirCacheHeader) - foldersSize - entriesSize
+    || pHeader->rootOffset >= pHeader->namesSize
+    || pHeader->rootLength == 0
+    || pHeader->rootLength >= pHeader->namesSize - pHeader->rootOffset)
+    {
+        lio_error_report(LIO_ERROR_CORRUPT, 0, "A directory snapshot is truncated", snapshotPath, NULL);
+        lio_dircache_close(pCache);
+        return false;
+    }
+
+    pCache->pFolders = (const LioDirCacheFolder*)(pData + sizeof(LioDirCacheHeader));
+    pCache->numFolders = (size_t)pHeader->numFolders;
+    pCache->pEntries = (const LioDirCacheEntry*)(pData + sizeof(LioDirCacheHeader) + foldersSize);
+    pCache->pNames = (const char*)(pData + sizeof(LioDirCacheHeader) + foldersSize + entriesSize);
+    pCache->namesSize = (size_t)pHeader->namesSize;
+
+    // Folder records are checked up-front since lookups search all of them.
+    // Entry names are only checked when their folder is first used.
+    for (size_t i = 0; i < pCache->numFolders; ++i)
+    {
+        const LioDirCacheFolder* const pFolder = pCache->pFolders + i;
+
+        if (pFolder->pathOffset >= pCache->namesSize
+        || pFolder->pathLength >= pCache->namesSize - pFolder->pathOffset
+        || pCache->pNames[pFolder->pathOffset + pFolder->pathLength] != '\0'
+        || pFolder->firstEntry > pHeader->numEntries
+        || pFolder->numEntries > pHeader->numEntries - pFolder->firstEntry)
+        {
+            lio_error_report(LIO_ERROR_CORRUPT, 0, "A directory snapshot is corrupt", snapshotPath, NULL);
+            lio_dircache_close(pCache);
+            return false;
+        }
+    }
+
+    pCache->pStates = (unsigned char*)lio_alloc_calloc(pCache->numFolders + 1, sizeof(unsigned char));
+    pCache->ppOverlays = (LioDirCacheOverlay**)lio_alloc_calloc(pCache->numFolders + 1, sizeof(LioDirCacheOverlay*));
+
+    if (!pCache->pStates
+    || !pCache->ppOverlays
+    || !lio_strbuf_append_n(&pCache->root, pCache->pNames + pHeader->rootOffset, (size_t)pHeader->rootLength))
+    {
+        lio_dircache_close(pCache);
+        return false;
+    }
+
+    return true;
+}
+
+
+
+/*-------------------------------------
+ * Close
+-------------------------------------*/
+void lio_dircache_close(LioDirCache* const pCache)
+{
+    if (pCache->pMapping)
+    {
+        lio_file_unmap(pCache->pMapping, pCache->mappingSize);
+    }
+
+    lio_alloc_free(pCache->pStates);
+    lio_alloc_free(pCache->ppOverlays);
+    lio_alloc_free(pCache->ppExtras);
+    lio_alloc_free(pCache->pExtraSlots);
+    lio_arena_terminate(&pCache->arena);
+    lio_strbuf_terminate(&pCache->root);
+
+    memset(pCache, 0, sizeof(LioDirCache));
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Queries
+-----------------------------------------------------------------------------*/
+/*-------------------------------------
+ * List a folder
+-------------------------------------*/
+bool lio_dircache_list(LioDirCache* const pCache, const char* const dirPath, LioDirListing* const pOutListing)
+{
+    return _lio_dircache_list_n(pCache, dirPath, strlen(dirPath), pOutListing);
+}
+
+
+
+/*-------------------------------------
+ * Look up a single entry
+-------------------------------------*/
+bool lio_dircache_stat(LioDirCache* const pCache, const char* const path, LioDirCacheEntry* const pOutEntry)
+{
+    const size_t length = _lio_dircache_trim(path, strlen(path));
+    const size_t sep = lio_pathview_rfind_sep(path, length);
+    LioDirListing listing;
+    size_t lo = 0;
+    size_t hi;
+
+    if (sep == length || sep == length - 1)
+    {
+        return false;
+    }
+
+    // The parent of a top-level path is the root of the file system
+    if (!_lio_dircache_list_n(pCache, path, sep ? sep : 1, &listing))
+    {
+        return false;
+    }
+
+    const char* const pName = path + sep + 1;
+    const size_t nameLength = length - sep - 1;
+
+    for (hi = listing.numEntries; lo < hi;)
+    {
+        const size_t mid = lo + (hi - lo) / 2;
+        const int cmp = _lio_dircache_compare_n(lio_dirlisting_name(&listing, mid), listing.pEntries[mid].nameLength, pName, nameLength);
+
+        if (cmp == 0)
+        {
+            *pOutEntry = listing.pEntries[mid];
+            return true;
+        }
+
+        if (cmp < 0)
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+
+    return false;
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Updates
+-----------------------------------------------------------------------------*/
+/*-------------------------------------
+ * Entries are sorted while their name offsets hold pointers to the names
+-------------------------------------*/
+static int _lio_dircache_compare_entries(const void* pA, const void* pB)
+{
+    const LioDirCacheEntry* const pEntryA = (const LioDirCacheEntry*)pA;
+    const LioDirCacheEntry* const pEntryB = (const LioDirCacheEntry*)pB;
+
+    return _lio_dircache_compare_n(
+        (const char*)(uintptr_t)pEntryA->nameOffset, pEntryA->nameLength,
+        (const char*)(uintptr_t)pEntryB->nameOffset, pEntryB->nameLength);
+}
+
+
+
+/*-------------------------------------
+ * Sort a listing
+-------------------------------------*/
+void lio_dirlisting_sort(LioDirCacheEntry* const pEntries, const size_t numEntries, const char* const pNames)
+{
+    if (!numEntries)
+    {
+        return;
+    }
+
+    for (size_t i = 0; i < numEntries; ++i)
+    {
+        pEntries[i].nameOffset = (uint64_t)(uintptr_t)(pNames + pEntries[i].nameOffset);
+    }
+
+    qsort(pEntries, numEntries, sizeof(LioDirCacheEntry), &_lio_dircache_compare_entries);
+
+    for (size_t i = 0; i < numEntries; ++i)
+    {
+        pEntries[i].nameOffset = (uint64_t)((const char*)(uintptr_t)pEntries[i].nameOffset - pNames);
+    }
+}
+
+
+
+/*-------------------------------------
+ * Free a listing read from disk
+-------------------------------------*/
+void lio_dirlisting_free(LioDirListing* const pListing)
+{
+    lio_alloc_free((void*)pListing->pEntries);
+    lio_alloc_free((void*)pListing->pNames);
+
+    pListing->pEntries = NULL;
+    pListing->numEntries = 0;
+    pListing->pNames = NULL;
+}
+
+
+
+/*-------------------------------------
+ * Replace a folder's listing
+-------------------------------------*/
+bool lio_dircache_insert(
+    LioDirCache* const pCache,
+    const LioDirCacheFolder* const pFolder,
+    const char* const pPath,
+    const LioDirCacheEntry* const pEntries,
+    const char* const pNames,
+    LioDirListing* const pOutListing)
+{
+    const size_t numEntries = (size_t)pFolder->numEntries;
+    const size_t pathLength = strlen(pPath);
+    size_t namesSize = pathLength + 1;
+    LioDirCacheOverlay* pOverlay;
+    LioDirCacheEntry* pNewEntries;
+    char* pNewNames;
+
+    for (size_t i = 0; i < numEntries; ++i)
+    {
+        namesSize += pEntries[i].nameLength + 1;
+    }
+
+    pOverlay = (LioDirCacheOverlay*)lio_arena_alloc(&pCache->arena, sizeof(LioDirCacheOverlay) + numEntries * sizeof(LioDirCacheEntry) + namesSize);
+    if (!pOverlay)
+    {
+        return false;
+    }
+
+    pNewEntries = (LioDirCacheEntry*)(pOverlay + 1);
+    pNewNames = (char*)(pNewEntries + numEntries);
+    memcpy(pNewNames, pPath, pathLength + 1);
+    namesSize = pathLength + 1;
+
+    for (size_t i = 0; i < numEntries; ++i)
+    {
+        pNewEntries[i] = pEntries[i];
+        pNewEntries[i].nameOffset = namesSize;
+        memcpy(pNewNames + namesSize, pNames + pEntries[i].nameOffset, pEntries[i].nameLength);
+        pNewNames[namesSize + pEntries[i].nameLength] = '\0';
+        namesSize += pEntries[i].nameLength + 1;
+    }
+
+    lio_dirlisting_sort(pNewEntries, numEntries, pNewNames);
+
+    pOverlay->folder = *pFolder;
+    pOverlay->folder.pathOffset = 0;
+    pOverlay->folder.pathLength = pathLength;
+    pOverlay->folder.firstEntry = 0;
+    pOverlay->pPath = pNewNames;
+    pOverlay->listing.pEntries = pNewEntries;
+    pOverlay->listing.numEntries = numEntries;
+    pOverlay->listing.pNames = pNewNames;
+    pOverlay->isRemoved = false;
+
+    const size_t index = _lio_dircache_find_mapped(pCache, pPath, pathLength);
+    if (index < pCache->numFolders)
+    {
+        pCache->ppOverlays[index] = pOverlay;
+        pCache->pStates[index] = LIO_DIRCACHE_REPLACED;
+    }
+    else if (pCache->extraSlotCapacity && pCache->pExtraSlots[_lio_dircache_find_extra_slot(pCache, pPath, pathLength)])
+    {
+        pCache->ppExtras[pCache->pExtraSlots[_lio_dircache_find_extra_slot(pCache, pPath, pathLength)] - 1] = pOverlay;
+    }
+    else if (!_lio_dircache_add_extra(pCache, pOverlay))
+    {
+        return false;
+    }
+
+    if (pOutListing)
+    {
+        *pOutListing = pOverlay->listing;
+    }
+
+    return true;
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Serialization
+-----------------------------------------------------------------------------*/
+static int _lio_dircache_compare_items(const void* pA, const void* pB)
+{
+    const LioDirCacheSaveItem* const pItemA = (const LioDirCacheSaveItem*)pA;
+    const LioDirCacheSaveItem* const pItemB = (const LioDirCacheSaveItem*)pB;
+
+    return _lio_dircache_compare_n(pItemA->pPath, pItemA->pathLength, pItemB->pPath, pItemB->pathLength);
+}
+
+
+
+/*-------------------------------------
+ * Collect the current version of every folder, sorted by path
+-------------------------------------*/
+static LioDirCacheSaveItem* _lio_dircache_collect(const LioDirCache* const pCache, size_t* const pOutNumItems)
+{
+    LioDirCacheSaveItem* const pItems = (LioDirCacheSaveItem*)lio_alloc_malloc((pCache->numFolders + pCache->numExtras + 1) * sizeof(LioDirCacheSaveItem));
+    size_t numItems = 0;
+
+    if (!pItems)
+    {
+        return NULL;
+    }
+
+    for (size_t i = 0; i < pCache->numFolders; ++i)
+    {
+        const LioDirCacheFolder* const pFolder = pCache->pFolders + i;
+        LioDirCacheSaveItem* const pItem = pItems + numItems;
+
+        if (pCache->pStates[i] == LIO_DIRCACHE_REPLACED)
+        {
+            const LioDirCacheOverlay* const pOverlay = pCache->ppOverlays[i];
+            pItem->pFolder = &pOverlay->folder;
+            pItem->listing = pOverlay->listing;
+        }
+        else if (pCache->pStates[i] == LIO_DIRCACHE_CURRENT
+        || (pCache->pStates[i] == LIO_DIRCACHE_UNCHECKED && _lio_dircache_check_entries(pCache, pFolder)))
+        {
+            pItem->pFolder = pFolder;
+            pItem->listing = _lio_dircache_mapped_listing(pCache, pFolder);
+        }
+        else
+        {
+            continue;
+        }
+
+        pItem->pPath = pCache->pNames + pFolder->pathOffset;
+        pItem->pathLength = (size_t)pFolder->pathLength;
+        ++numItems;
+    }
+
+    for (size_t i = 0; i < pCache->numExtras; ++i)
+    {
+        const LioDirCacheOverlay* const pOverlay = pCache->ppExtras[i];
+        LioDirCacheSaveItem* const pItem = pItems + numItems;
+
+        if (!pOverlay->isRemoved)
+        {
+            pItem->pPath = pOverlay->pPath;
+            pItem->pathLength = (size_t)pOverlay->folder.pathLength;
+            pItem->pFolder = &pOverlay->folder;
+            pItem->listing = pOverlay->listing;
+            ++numItems;
+        }
+    }
+
+    qsort(pItems, numItems, sizeof(LioDirCacheSaveItem), &_lio_dircache_compare_items);
+
+    *pOutNumItems = numItems;
+    return pItems;
+}
+
+
+
+/*-------------------------------------
+ * Save a snapshot
+-------------------------------------*/
+bool lio_dircache_save(const LioDirCache* const pCache, const char* const snapshotPath)
+{
+    static const char padding[8] = {0};
+    LioDirCacheHeader header;
+    LioDirCacheSaveItem* pItems;
+    size_t numItems = 0;
+    uint64_t nameOffset;
+    uint64_t entryOffset;
+    LioFile file;
+    LioBinWriter writer;
+    bool ret;
+
+    pItems = _lio_dircache_collect(pCache, &numItems);
+    if (!pItems)
+    {
+        return false;
+    }
+
+    // Names begin with the root, then each folder's path followed by the
+    // names of its entries
+    memset(&header, 0, sizeof(header));
+    header.magic = LIO_DIRCACHE_MAGIC;
+    header.version = LIO_DIRCACHE_VERSION;
+    header.byteOrder = LIO_DIRCACHE_BYTE_ORDER_MARK;
+    header.numFolders = numItems;
+    header.rootOffset = 0;
+    header.rootLength = pCache->root.length;
+    header.namesSize = pCache->root.length + 1;
+
+    for (size_t i = 0; i < numItems; ++i)
+    {
+        header.namesSize += pItems[i].pathLength + 1;
+        header.numEntries += pItems[i].listing.numEntries;
+
+        for (size_t j = 0; j < pItems[i].listing.numEntries; ++j)
+        {
+            header.namesSize += pItems[i].listing.pEntries[j].nameLength + 1;
+        }
+    }
+
+    // Pad so the size of the file is a multiple of 8 bytes
+    const size_t paddingSize = (size_t)((8 - (header.namesSize & 7u)) & 7u);
+    header.namesSize += paddingSize;
+
+    if (!lio_file_open(&file, snapshotPath, LIO_FILE_OPEN_WRITE | LIO_FILE_OPEN_CREATE | LIO_FILE_OPEN_TRUNCATE))
+    {
+        lio_alloc_free(pItems);
+        return false;
+    }
+
+    if (!lio_binwriter_init_file(&writer, &file, 0, LIO_BYTE_ORDER_NATIVE))
+    {
+        lio_file_close(&file);
+        lio_alloc_free(pItems);
+        return false;
+    }
+
+    lio_binwriter_write_bytes(&writer, &header, sizeof(header));
+
+    nameOffset = pCache->root.length + 1;
+    entryOffset = 0;
+    for (size_t i = 0; i < numItems; ++i)
+    {
+        LioDirCacheFolder folder = *pItems[i].pFolder;
+        folder.pathOffset = nameOffset;
+        folder.pathLength = pItems[i].pathLength;
+        folder.firstEntry = entryOffset;
+        folder.numEntries = pItems[i].listing.numEntries;
+        lio_binwriter_write_bytes(&writer, &folder, sizeof(folder));
+
+        nameOffset += pItems[i].pathLength + 1;
+        entryOffset += pItems[i].listing.numEntries;
+        for (size_t j = 0; j < pItems[i].listing.numEntries; ++j)
+        {
+            nameOffset += pItems[i].listing.pEntries[j].nameLength + 1;
+        }
+    }
+
+    nameOffset = pCache->root.length + 1;
+    for (size_t i = 0; i < numItems; ++i)
+    {
+        nameOffset += pItems[i].pathLength + 1;
+        for (size_t j = 0; j < pItems[i].listing.numEntries; ++j)
+        {
+            LioDirCacheEntry entry = pItems[i].listing.pEntries[j];
+            entry.nameOffset = nameOffset;
+            lio_binwriter_write_bytes(&writer, &entry, sizeof(entry));
+            nameOffset += entry.nameLength + 1;
+        }
+    }
+
+    lio_binwriter_write_bytes(&writer, lio_strbuf_cstr(&pCache->root), pCache->root.length + 1);
+    for (size_t i = 0; i < numItems; ++i)
+    {
+        const LioDirListing* const pListing = &pItems[i].listing;
+
+        lio_binwriter_write_bytes(&writer, pItems[i].pPath, pItems[i].pathLength);
+        lio_binwriter_write_bytes(&writer, padding, 1);
+        for (size_t j = 0; j < pListing->numEntries; ++j)
+        {
+            lio_binwriter_write_bytes(&writer, lio_dirlisting_name(pListing, j), pListing->pEntries[j].nameLength + 1);
+        }
+    }
+    lio_binwriter_write_bytes(&writer, padding, paddingSize);
+
+    ret = lio_binwriter_terminate(&writer);
+    ret = lio_file_close(&file) && ret;
+    lio_alloc_free(pItems);
+
+    return ret;
+}
+
+
+
+/*-------------------------------------
+ * Rescan a folder
+-------------------------------------*/
+bool lio_dircache_rescan(LioDirCache* const pCache, const char* const dirPath, LioDirListing* const pOutListing)
+{
+    LioDirCacheFolder folder;
+    LioDirListing listing;
+    bool ret;
+
+    if (!lio_dircache_read_folder(dirPath, &folder, &listing))
+    {
+        return false;
+    }
+
+    ret = lio_dircache_insert(pCache, &folder, dirPath, listing.pEntries, listing.pNames, pOutListing);
+    lio_dirlisting_free(&listing);
+
+    return ret;
+}
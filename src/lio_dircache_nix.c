@@ -0,0 +1,188 @@
+
+// expose dirfd(), fstatat(), st_mtim, and st_ctim
+#ifndef _GNU_SOURCE
+    #define _GNU_SOURCE
+#endif
+
+#include <dirent.h> // DIR, opendir(), readdir(), dirfd(), closedir()
+#include <fcntl.h> // AT_SYMLINK_NOFOLLOW
+#include <sys/stat.h> // fstat(), fstatat(), stat()
+#include <time.h> // clock_gettime()
+
+#include <stdio.h>
+#include <string.h> // strcmp(), strlen()
+
+#include "light_io/lio_alloc.h"
+#include "light_io/lio_paths.h"
+#include "light_io/lio_strbuf.h"
+#include "light_io/lio_dircache.h"
+
+
+
+/*-----------------------------------------------------------------------------
+ * Timestamps
+-----------------------------------------------------------------------------*/
+#define LIO_DIRCACHE_NSEC(ts) ((int64_t)(ts).tv_sec * 1000000000 + (int64_t)(ts).tv_nsec)
+
+#ifdef __APPLE__
+    #define LIO_DIRCACHE_MTIME(pStat) LIO_DIRCACHE_NSEC((pStat)->st_mtimespec)
+    #define LIO_DIRCACHE_CTIME(pStat) LIO_DIRCACHE_NSEC((pStat)->st_ctimespec)
+#else
+    #define LIO_DIRCACHE_MTIME(pStat) LIO_DIRCACHE_NSEC((pStat)->st_mtim)
+    #define LIO_DIRCACHE_CTIME(pStat) LIO_DIRCACHE_NSEC((pStat)->st_ctim)
+#endif
+
+
+
+static inline uint32_t _lio_dircache_type(const mode_t mode)
+{
+    if (S_ISREG(mode))
+    {
+        return LIO_PATH_TYPE_REGULAR;
+    }
+    else if (S_ISDIR(mode))
+    {
+        return LIO_PATH_TYPE_FOLDER;
+    }
+    else if (S_ISLNK(mode))
+    {
+        return LIO_PATH_TYPE_LINK;
+    }
+
+    return LIO_PATH_TYPE_FILE;
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Scanning
+-----------------------------------------------------------------------------*/
+/*-------------------------------------
+ * Read a folder. Entries are stat'ed relative to the open folder so no paths
+ * need to be built.
+-------------------------------------*/
+bool lio_dircache_read_folder(const char* const dirPath, LioDirCacheFolder* const pOutFolder, LioDirListing* const pOutListing)
+{
+    struct timespec now;
+    struct stat info;
+    struct dirent* pEntry;
+    LioDirCacheFolder folder;
+    LioDirCacheEntry* pEntries = NULL;
+    size_t capacity = 0;
+    LioStrBuf names;
+    DIR* pDir;
+    bool ret = true;
+
+    clock_gettime(CLOCK_REALTIME, &now);
+
+    pDir = opendir(dirPath);
+    if (!pDir)
+    {
+        return false;
+    }
+
+    // The folder is stat'ed before reading so concurrent changes are caught
+    // by the next validation
+    if (fstat(dirfd(pDir), &info) != 0)
+    {
+        closedir(pDir);
+        return false;
+    }
+
+    memset(&folder, 0, sizeof(folder));
+    folder.inode = (uint64_t)info.st_ino;
+    folder.modifiedTime = LIO_DIRCACHE_MTIME(&info);
+    folder.changedTime = LIO_DIRCACHE_CTIME(&info);
+    folder.scannedTime = LIO_DIRCACHE_NSEC(now);
+
+    lio_strbuf_init(&names);
+
+    while ((pEntry = readdir(pDir)) != NULL)
+    {
+        const char* const entry = pEntry->d_name;
+        const size_t nameLength = strlen(entry);
+
+        if (strcmp(entry, ".") == 0 || strcmp(entry, "..") == 0)
+        {
+            continue;
+        }
+
+        // Entries may be removed while the folder is read
+        if (fstatat(dirfd(pDir), entry, &info, AT_SYMLINK_NOFOLLOW) != 0)
+        {
+            continue;
+        }
+
+        if (folder.numEntries == capacity)
+        {
+            const size_t newCapacity = capacity ? capacity * 2 : 64;
+            LioDirCacheEntry* const pNewEntries = (LioDirCacheEntry*)lio_alloc_realloc(pEntries, capacity * sizeof(LioDirCacheEntry), newCapacity * sizeof(LioDirCacheEntry));
+
+            if (!pNewEntries)
+            {
+                ret = false;
+                break;
+            }
+
+            pEntries = pNewEntries;
+            capacity = newCapacity;
+        }
+
+        LioDirCacheEntry* const pOut = pEntries + folder.numEntries;
+        pOut->nameOffset = names.length;
+        pOut->nameLength = (uint32_t)nameLength;
+        pOut->size = (uint64_t)info.st_size;
+        pOut->inode = (uint64_t)info.st_ino;
+        pOut->modifiedTime = LIO_DIRCACHE_MTIME(&info);
+        pOut->type = _lio_dircache_type(info.st_mode);
+
+        if (!lio_strbuf_append_n(&names, entry, nameLength) || !lio_strbuf_append_char(&names, '\0'))
+        {
+            ret = false;
+            break;
+        }
+
+        ++folder.numEntries;
+    }
+
+    closedir(pDir);
+
+    pOutListing->pNames = ret ? lio_strbuf_detach(&names) : NULL;
+    if (!pOutListing->pNames)
+    {
+        lio_alloc_free(pEntries);
+        lio_strbuf_terminate(&names);
+        return false;
+    }
+
+    lio_dirlisting_sort(pEntries, (size_t)folder.numEntries, pOutListing->pNames);
+    pOutListing->pEntries = pEntries;
+    pOutListing->numEntries = (size_t)folder.numEntries;
+    *pOutFolder = folder;
+
+    return true;
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Validation
+-----------------------------------------------------------------------------*/
+bool lio_dircache_is_current(const char* const dirPath, const LioDirCacheFolder* const pFolder)
+{
+    struct stat info;
+    int64_t lastChange;
+
+    if (stat(dirPath, &info) != 0
+    || !S_ISDIR(info.st_mode)
+    || (uint64_t)info.st_ino != pFolder->inode
+    || LIO_DIRCACHE_MTIME(&info) != pFolder->modifiedTime
+    || LIO_DIRCACHE_CTIME(&info) != pFolder->changedTime)
+    {
+        return false;
+    }
+
+    // A change in the same timestamp tick as the scan would be invisible
+    lastChange = (pFolder->modifiedTime > pFolder->changedTime) ? pFolder->modifiedTime : pFolder->changedTime;
+    return pFolder->scannedTime - lastChange >= LIO_DIRCACHE_RACY_NSEC;
+}
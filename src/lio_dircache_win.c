@@ -0,0 +1,171 @@
+
+#ifndef WIN32_LEAN_AND_MEAN
+    #define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+
+#include <stdio.h>
+#include <string.h> // strcmp(), strlen()
+
+#include "light_io/lio_alloc.h"
+#include "light_io/lio_paths.h"
+#include "light_io/lio_strbuf.h"
+#include "light_io/lio_dircache.h"
+
+
+
+/*-----------------------------------------------------------------------------
+ * Timestamps
+-----------------------------------------------------------------------------*/
+static inline int64_t _lio_dircache_filetime_to_ns(const FILETIME* const pTime)
+{
+    // FILETIME counts 100ns intervals since 1601-01-01
+    const int64_t ticks = (int64_t)(((uint64_t)pTime->dwHighDateTime << 32) | (uint64_t)pTime->dwLowDateTime);
+    return (ticks - 116444736000000000ll) * 100;
+}
+
+
+
+static inline uint32_t _lio_dircache_type(const DWORD attributes)
+{
+    if (attributes & FILE_ATTRIBUTE_REPARSE_POINT)
+    {
+        return LIO_PATH_TYPE_LINK;
+    }
+    else if (attributes & FILE_ATTRIBUTE_DIRECTORY)
+    {
+        return LIO_PATH_TYPE_FOLDER;
+    }
+
+    return LIO_PATH_TYPE_REGULAR;
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Scanning
+ *
+ * Windows has no inode numbers or change times in its directory listings, so
+ * folders are only compared by their last write time.
+-----------------------------------------------------------------------------*/
+bool lio_dircache_read_folder(const char* const dirPath, LioDirCacheFolder* const pOutFolder, LioDirListing* const pOutListing)
+{
+    FILETIME now;
+    WIN32_FILE_ATTRIBUTE_DATA folderInfo;
+    WIN32_FIND_DATAA data;
+    HANDLE hFind;
+    LioDirCacheFolder folder;
+    LioDirCacheEntry* pEntries = NULL;
+    size_t capacity = 0;
+    LioStrBuf names;
+    LioStrBuf pattern;
+    bool ret = true;
+
+    GetSystemTimeAsFileTime(&now);
+
+    if (!GetFileAttributesExA(dirPath, GetFileExInfoStandard, &folderInfo) || !(folderInfo.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY))
+    {
+        return false;
+    }
+
+    lio_strbuf_init(&pattern);
+    if (!lio_strbuf_append(&pattern, dirPath) || !lio_strbuf_append_char(&pattern, LIO_PATH_SEP) || !lio_strbuf_append_char(&pattern, '*'))
+    {
+        lio_strbuf_terminate(&pattern);
+        return false;
+    }
+
+    hFind = FindFirstFileA(pattern.pData, &data);
+    lio_strbuf_terminate(&pattern);
+
+    if (hFind == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+
+    memset(&folder, 0, sizeof(folder));
+    folder.modifiedTime = _lio_dircache_filetime_to_ns(&folderInfo.ftLastWriteTime);
+    folder.changedTime = folder.modifiedTime;
+    folder.scannedTime = _lio_dircache_filetime_to_ns(&now);
+
+    lio_strbuf_init(&names);
+
+    do
+    {
+        const size_t nameLength = strlen(data.cFileName);
+
+        if (strcmp(data.cFileName, ".") == 0 || strcmp(data.cFileName, "..") == 0)
+        {
+            continue;
+        }
+
+        if (folder.numEntries == capacity)
+        {
+            const size_t newCapacity = capacity ? capacity * 2 : 64;
+            LioDirCacheEntry* const pNewEntries = (LioDirCacheEntry*)lio_alloc_realloc(pEntries, capacity * sizeof(LioDirCacheEntry), newCapacity * sizeof(LioDirCacheEntry));
+
+            if (!pNewEntries)
+            {
+                ret = false;
+                break;
+            }
+
+            pEntries = pNewEntries;
+            capacity = newCapacity;
+        }
+
+        LioDirCacheEntry* const pOut = pEntries + folder.numEntries;
+        pOut->nameOffset = names.length;
+        pOut->nameLength = (uint32_t)nameLength;
+        pOut->size = ((uint64_t)data.nFileSizeHigh << 32) | (uint64_t)data.nFileSizeLow;
+        pOut->inode = 0;
+        pOut->modifiedTime = _lio_dircache_filetime_to_ns(&data.ftLastWriteTime);
+        pOut->type = _lio_dircache_type(data.dwFileAttributes);
+
+        if (!lio_strbuf_append_n(&names, data.cFileName, nameLength) || !lio_strbuf_append_char(&names, '\0'))
+        {
+            ret = false;
+            break;
+        }
+
+        ++folder.numEntries;
+    }
+    while (FindNextFileA(hFind, &data));
+
+    FindClose(hFind);
+
+    pOutListing->pNames = ret ? lio_strbuf_detach(&names) : NULL;
+    if (!pOutListing->pNames)
+    {
+        lio_alloc_free(pEntries);
+        lio_strbuf_terminate(&names);
+        return false;
+    }
+
+    lio_dirlisting_sort(pEntries, (size_t)folder.numEntries, pOutListing->pNames);
+    pOutListing->pEntries = pEntries;
+    pOutListing->numEntries = (size_t)folder.numEntries;
+    *pOutFolder = folder;
+
+    return true;
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Validation
+-----------------------------------------------------------------------------*/
+bool lio_dircache_is_current(const char* const dirPath, const LioDirCacheFolder* const pFolder)
+{
+    WIN32_FILE_ATTRIBUTE_DATA info;
+
+    if (!GetFileAttributesExA(dirPath, GetFileExInfoStandard, &info)
+    || !(info.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+    || _lio_dircache_filetime_to_ns(&info.ftLastWriteTime) != pFolder->modifiedTime)
+    {
+        return false;
+    }
+
+    // A change in the same timestamp tick as the scan would be invisible
+    return pFolder->scannedTime - pFolder->modifiedTime >= LIO_DIRCACHE_RACY_NSEC;
+}
@@ -0,0 +1,184 @@
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h> // memcpy(), strerror()
+
+#include "light_io/lio_error.h"
+#include "light_io/lio_stats.h"
+
+
+
+/*-----------------------------------------------------------------------------
+ * Per-thread state
+-----------------------------------------------------------------------------*/
+#if defined(_MSC_VER) && !defined(__clang__)
+    #define LIO_THREAD_LOCAL __declspec(thread)
+#else
+    #define LIO_THREAD_LOCAL _Thread_local
+#endif
+
+static LIO_THREAD_LOCAL LioError _lioLastError;
+
+static LioErrorSink _lioErrorSink = NULL;
+static void* _pLioErrorSinkData = NULL;
+
+
+
+/*-----------------------------------------------------------------------------
+ * Copy a path into a record, truncating it if necessary
+-----------------------------------------------------------------------------*/
+static inline void _lio_error_copy_path(char* const pOut, const char* const pPath)
+{
+    size_t length = 0;
+
+    if (pPath)
+    {
+        while (length < LIO_ERROR_MAX_PATH-1 && pPath[length])
+        {
+            ++length;
+        }
+        memcpy(pOut, pPath, length);
+    }
+
+    pOut[length] = '\0';
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Error records
+-----------------------------------------------------------------------------*/
+const LioError* lio_error_last(void)
+{
+    return &_lioLastError;
+}
+
+
+
+void lio_error_clear(void)
+{
+    _lioLastError.code = LIO_ERROR_NONE;
+    _lioLastError.sysError = 0;
+    _lioLastError.pMessage = "";
+    _lioLastError.path[0] = '\0';
+    _lioLastError.otherPath[0] = '\0';
+}
+
+
+
+void lio_error_report(
+    const enum LioErrorCode code,
+    const int sysError,
+    const char* const pMessage,
+    const char* const pPath,
+    const char* const pOtherPath)
+{
+    LioError* const pError = &_lioLastError;
+
+    LIO_STATS_ADD(LIO_STATS_ERRORS, 1);
+
+    pError->code = code;
+    pError->sysError = sysError;
+    pError->pMessage = pMessage ? pMessage : "";
+    _lio_error_copy_path(pError->path, pPath);
+    _lio_error_copy_path(pError->otherPath, pOtherPath);
+
+    if (_lioErrorSink)
+    {
+        _lioErrorSink(pError, _pLioErrorSinkData);
+    }
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Sinks
+-----------------------------------------------------------------------------*/
+void lio_error_set_sink(LioErrorSink sink, void* const pUserData)
+{
+    _lioErrorSink = sink;
+    _pLioErrorSinkData = pUserData;
+}
+
+
+
+void lio_error_print(const LioError* const pError, void* const pUserData)
+{
+    FILE* const pFile = pUserData ? (FILE*)pUserData : stderr;
+
+    fprintf(pFile, "%s: %s", lio_error_name(pError->code), pError->pMessage ? pError->pMessage : "");
+
+    if (pError->path[0])
+    {
+        fprintf(pFile, " \"%s\"", pError->path);
+    }
+
+    if (pError->otherPath[0])
+    {
+        fprintf(pFile, " -> \"%s\"", pError->otherPath);
+    }
+
+    if (pError->sysError)
+    {
+        fprintf(pFile, ": %s", strerror(pError->sysError));
+    }
+
+    fputc('\n', pFile);
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Error codes
+-----------------------------------------------------------------------------*/
+const char* lio_error_name(const enum LioErrorCode code)
+{
+    switch (code)
+    {
+        case LIO_ERROR_NONE:              return "LIO_ERROR_NONE";
+        case LIO_ERROR_INVALID_ARGUMENT:  return "LIO_ERROR_INVALID_ARGUMENT";
+        case LIO_ERROR_NOT_FOUND:         return "LIO_ERROR_NOT_FOUND";
+        case LIO_ERROR_ALREADY_EXISTS:    return "LIO_ERROR_ALREADY_EXISTS";
+        case LIO_ERROR_PERMISSION_DENIED: return "LIO_ERROR_PERMISSION_DENIED";
+        case LIO_ERROR_NOT_A_FOLDER:      return "LIO_ERROR_NOT_A_FOLDER";
+        case LIO_ERROR_NOT_A_FILE:        return "LIO_ERROR_NOT_A_FILE";
+        case LIO_ERROR_FOLDER_NOT_EMPTY:  return "LIO_ERROR_FOLDER_NOT_EMPTY";
+        case LIO_ERROR_NO_SPACE:          return "LIO_ERROR_NO_SPACE";
+        case LIO_ERROR_OUT_OF_MEMORY:     return "LIO_ERROR_OUT_OF_MEMORY";
+        case LIO_ERROR_LIMIT_EXCEEDED:    return "LIO_ERROR_LIMIT_EXCEEDED";
+        case LIO_ERROR_CORRUPT:           return "LIO_ERROR_CORRUPT";
+        case LIO_ERROR_IO:                return "LIO_ERROR_IO";
+        default:
+            break;
+    }
+
+    return "LIO_ERROR_UNKNOWN";
+}
+
+
+
+enum LioErrorCode lio_error_from_errno(const int sysError)
+{
+    switch (sysError)
+    {
+        case 0:            return LIO_ERROR_NONE;
+        case EINVAL:       return LIO_ERROR_INVALID_ARGUMENT;
+        case EBADF:        return LIO_ERROR_INVALID_ARGUMENT;
+        case ENOENT:       return LIO_ERROR_NOT_FOUND;
+        case EEXIST:       return LIO_ERROR_ALREADY_EXISTS;
+        case EACCES:       return LIO_ERROR_PERMISSION_DENIED;
+        case EPERM:        return LIO_ERROR_PERMISSION_DENIED;
+        case ENOTDIR:      return LIO_ERROR_NOT_A_FOLDER;
+        case EISDIR:       return LIO_ERROR_NOT_A_FILE;
+        case ENOTEMPTY:    return LIO_ERROR_FOLDER_NOT_EMPTY;
+        case ENOSPC:       return LIO_ERROR_NO_SPACE;
+        case ENOMEM:       return LIO_ERROR_OUT_OF_MEMORY;
+        case ENAMETOOLONG: return LIO_ERROR_LIMIT_EXCEEDED;
+        case EFBIG:        return LIO_ERROR_LIMIT_EXCEEDED;
+        case EMFILE:       return LIO_ERROR_LIMIT_EXCEEDED;
+        default:
+            break;
+    }
+
+    return LIO_ERROR_IO;
+}
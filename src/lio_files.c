@@ -1,9 +1,13 @@
 
-#include <stdlib.h>
+#include <errno.h>
 #include <stdio.h>
 
+#include "light_io/lio_error.h"
 #include "light_io/lio_paths.h"
 #include "light_io/lio_files.h"
+#include "light_io/lio_record.h"
+#include "light_io/lio_stats.h"
+#include "light_io/lio_strbuf.h"
 
 // Thanks Windows
 #ifndef restrict
@@ -17,91 +21,129 @@
 
 
 /*-----------------------------------------------------------------------------
- * Stream data into a file
+ * Copy data from one file to another
+-----------------------------------------------------------------------------*/
+bool lio_file_copy(
+    const char* const restrict from,
+    const char* const restrict to,
+    const bool overwrite)
+{
+    return lio_file_copy_ex(from, to, overwrite ? LIO_FILE_COPY_OVERWRITE : LIO_FILE_COPY_DEFAULT);
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Copy data using the shared buffer pool
+-----------------------------------------------------------------------------*/
+bool lio_file_copy_ex(
+    const char* const restrict from,
+    const char* const restrict to,
+    const unsigned flags)
+{
+    return lio_file_copy_pooled(from, to, flags, NULL);
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Copy data from one file to another using a buffer pool
 -----------------------------------------------------------------------------*/
-static bool _lio_file_stream_into_file(
-    const char* const from,
-    const char* const to,
-    const size_t chunkSize,
-    const bool append
-)
+static bool _lio_file_copy_pooled(
+    const char* const restrict from,
+    const char* const restrict to,
+    const unsigned flags,
+    LioBufferPool* const pPool)
 {
-    const char writeMode[3] = {(char)(append ? 'a' : 'w'), 'b', '\0'};
-    char* const buffer = (char*) malloc(sizeof(char) * chunkSize);
+    if (!from || !to)
+    {
+        lio_error_report(LIO_ERROR_INVALID_ARGUMENT, 0, "Unable to copy a file without a path", from, to);
+        return false;
+    }
+
+    LioFile src;
+    LioFile dst;
+    LioFileStat srcInfo;
 
-    if (!buffer)
+    // The open calls themselves validate both paths, there is no need to
+    // check for existence beforehand.
+    if (!lio_file_open(&src, from, LIO_FILE_OPEN_READ))
     {
         return false;
     }
 
-    FILE* const pFrom = fopen(from, "rb");
-    if (!pFrom)
+    if (!lio_file_stat(&src, &srcInfo))
     {
-        fprintf(stderr, "Unable to open the file \"%s\" for reading.\n", from);
-        free(buffer);
+        lio_file_close(&src);
         return false;
     }
 
-    FILE* const pTo = fopen(to, writeMode);
-    if (!pTo)
+    if (srcInfo.type == LIO_PATH_TYPE_FOLDER)
     {
-        fprintf(stderr, "Unable to open the file \"%s\" for writing.\n", to);
-        free(buffer);
-        fclose(pFrom);
+        lio_error_report(LIO_ERROR_NOT_A_FILE, 0, "Unable to copy a folder as a file", from, to);
+        lio_file_close(&src);
         return false;
     }
 
-    size_t chunksRead = 0;
-    do
+    if (flags & LIO_FILE_COPY_ATOMIC)
     {
-        chunksRead = fread(buffer, 1, chunkSize, pFrom);
+        LioFileAtomic atomic;
 
-        if (chunksRead != fwrite(buffer, 1, chunksRead, pTo))
+        if (!lio_file_atomic_open(&atomic, to, flags))
         {
-            fprintf(stderr, "Failed to stream %zu bytes into \"%s\"\n.", chunksRead, to);
-            free(buffer);
-            fclose(pFrom);
-            fclose(pTo);
+            lio_file_close(&src);
             return false;
         }
-    }
-    while (chunksRead == chunkSize);
-
-    free(buffer);
-    fclose(pFrom);
-    fclose(pTo);
-    return true;
-}
 
+        bool ret = lio_file_copy_fd(&src, &atomic.file, flags, pPool);
+        lio_file_close(&src);
 
+        if (ret)
+        {
+            ret = lio_file_atomic_commit(&atomic, NULL);
+        }
+        else
+        {
+            lio_file_atomic_abort(&atomic);
+        }
 
-/*-----------------------------------------------------------------------------
- * Copy data from one file to another
------------------------------------------------------------------------------*/
-bool lio_file_copy(
-    const char* const restrict from,
-    const char* const restrict to,
-    const bool overwrite)
-{
-    if (!from || !to)
-    {
-        fprintf(stderr, "Unable to copy paths. Invalid file names.\n");
-        return false;
+        return ret;
     }
 
-    if (!lio_path_does_exist(from, LIO_PATH_TYPE_FILE))
+    unsigned openFlags = LIO_FILE_OPEN_WRITE | LIO_FILE_OPEN_CREATE | LIO_FILE_OPEN_TRUNCATE;
+    if ((flags & LIO_FILE_COPY_OVERWRITE) == 0)
     {
-        fprintf(stderr, "Unable to copy file \"%s\". File does not exist.\n", from);
-        return false;
+        openFlags |= LIO_FILE_OPEN_EXCLUSIVE;
     }
 
-    if (lio_path_does_exist(to, LIO_PATH_TYPE_FILE) && !overwrite)
+    // A failed open has already reported the error
+    if (!lio_file_open(&dst, to, openFlags))
     {
-        fprintf(stderr, "Cannot copy \"%s\" to \"%s\". File exists at destination.\n", from, to);
+        lio_file_close(&src);
         return false;
     }
 
-    return _lio_file_stream_into_file(from, to, LIO_FILE_DEFAULT_CHUNK_SIZE, false);
+    bool ret = lio_file_copy_fd(&src, &dst, flags, pPool);
+
+    ret = lio_file_close(&dst) && ret;
+    lio_file_close(&src);
+
+    return ret;
+}
+
+
+
+bool lio_file_copy_pooled(
+    const char* const restrict from,
+    const char* const restrict to,
+    const unsigned flags,
+    LioBufferPool* const pPool)
+{
+    LIO_STATS_BEGIN(timer, LIO_STATS_OP_FILE_COPY, from);
+    const bool ret = _lio_file_copy_pooled(from, to, flags, pPool);
+    LIO_STATS_END_CALL(timer, to, flags, 0, 0, ret);
+
+    return ret;
 }
 
 
@@ -115,32 +157,191 @@ bool lio_file_concat(
     const char* const restrict outFile,
     const bool overwrite)
 {
-    if (!fileA || !fileB)
+    const char* const inFiles[2] = {fileA, fileB};
+    return lio_file_concat_many(inFiles, 2, outFile, overwrite);
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Concatenate several files
+-----------------------------------------------------------------------------*/
+bool lio_file_concat_many(
+    const char* const* const restrict pInFiles,
+    const unsigned numInFiles,
+    const char* const restrict outFile,
+    const bool overwrite)
+{
+    return lio_file_concat_ex(pInFiles, numInFiles, outFile, overwrite ? LIO_FILE_COPY_OVERWRITE : LIO_FILE_COPY_DEFAULT);
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Concatenate several files, optionally as an atomic write
+-----------------------------------------------------------------------------*/
+static bool _lio_file_concat_ex(
+    const char* const* const restrict pInFiles,
+    const unsigned numInFiles,
+    const char* const restrict outFile,
+    const unsigned flags)
+{
+    if ((!pInFiles && numInFiles) || !outFile)
+    {
+        lio_error_report(LIO_ERROR_INVALID_ARGUMENT, 0, "Unable to concatenate files without paths", outFile, NULL);
+        return false;
+    }
+
+    LioFile inFiles[LIO_FILE_CONCAT_BATCH_SIZE];
+    LioFile outHandle = lio_file_wrap(-1);
+    LioFileAtomic atomicOut;
+    const bool isAtomic = (flags & LIO_FILE_COPY_ATOMIC) != 0;
+    LioFile* const pOut = isAtomic ? &atomicOut.file : &outHandle;
+    bool ret = true;
+
+    atomicOut.file = lio_file_wrap(-1);
+    atomicOut.pPath = NULL;
+    atomicOut.pTempPath = NULL;
+
+    // Inputs are opened in batches to bound the number of open descriptors.
+    // The output is only created once the first batch has been validated.
+    for (unsigned i = 0; ret && (i < numInFiles || pOut->fd < 0);)
+    {
+        unsigned numOpened = 0;
+
+        while (ret && numOpened < LIO_FILE_CONCAT_BATCH_SIZE && i < numInFiles)
+        {
+            const char* const pPath = pInFiles[i++];
+
+            if (!pPath)
+            {
+                lio_error_report(LIO_ERROR_INVALID_ARGUMENT, 0, "Unable to concatenate a file without a path", outFile, NULL);
+            }
+
+            ret = pPath && lio_file_open(inFiles+numOpened, pPath, LIO_FILE_OPEN_READ);
+            if (!ret)
+            {
+                break;
+            }
+
+            ++numOpened;
+        }
+
+        if (ret && pOut->fd < 0)
+        {
+            unsigned openFlags = LIO_FILE_OPEN_WRITE | LIO_FILE_OPEN_CREATE | LIO_FILE_OPEN_TRUNCATE;
+            if ((flags & LIO_FILE_COPY_OVERWRITE) == 0)
+            {
+                openFlags |= LIO_FILE_OPEN_EXCLUSIVE;
+            }
+
+            const bool opened = isAtomic
+                ? lio_file_atomic_open(&atomicOut, outFile, flags)
+                : lio_file_open(&outHandle, outFile, openFlags);
+
+            if (!opened)
+            {
+                while (numOpened --> 0)
+                {
+                    lio_file_close(inFiles+numOpened);
+                }
+
+                return false;
+            }
+        }
+
+        ret = ret && lio_file_concat_fd(inFiles, numOpened, pOut);
+
+        while (numOpened --> 0)
+        {
+            lio_file_close(inFiles+numOpened);
+        }
+    }
+
+    // An atomic write leaves the destination alone until it is complete
+    if (isAtomic)
     {
-        fprintf(stderr, "Unable to concatenate files. Invalid file names.\n");
+        if (ret)
+        {
+            return lio_file_atomic_commit(&atomicOut, NULL);
+        }
+
+        lio_file_atomic_abort(&atomicOut);
         return false;
     }
 
-    if (!lio_path_does_exist(fileA, LIO_PATH_TYPE_FILE))
+    // Only remove the output if it was created (or truncated) here.
+    const bool outOpened = outHandle.fd >= 0;
+    ret = lio_file_close(&outHandle) && ret;
+
+    if (!ret && outOpened)
+    {
+        lio_path_remove(outFile, false, false);
+    }
+
+    return ret;
+}
+
+
+
+bool lio_file_concat_ex(
+    const char* const* const restrict pInFiles,
+    const unsigned numInFiles,
+    const char* const restrict outFile,
+    const unsigned flags)
+{
+    #if defined(LIGHT_IO_ENABLE_STATS)
+        // Recordings keep every input, one per line
+        LioStrBuf inputs;
+        lio_strbuf_init(&inputs);
+
+        for (unsigned i = 0; pInFiles && i < numInFiles && lio_record_is_enabled(); ++i)
+        {
+            lio_strbuf_appendf(&inputs, "%s%s", i ? "\n" : "", pInFiles[i] ? pInFiles[i] : "");
+        }
+    #endif
+
+    LIO_STATS_BEGIN(timer, LIO_STATS_OP_FILE_CONCAT, outFile);
+    const bool ret = _lio_file_concat_ex(pInFiles, numInFiles, outFile, flags);
+    LIO_STATS_END_CALL(timer, lio_strbuf_cstr(&inputs), flags, 0, 0, ret);
+
+    #if defined(LIGHT_IO_ENABLE_STATS)
+        lio_strbuf_terminate(&inputs);
+    #endif
+
+    return ret;
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Atomically replace a file with a buffer
+-----------------------------------------------------------------------------*/
+bool lio_file_write_atomic(
+    const char* const restrict pPath,
+    const void* const restrict pData,
+    const size_t numBytes,
+    const unsigned flags,
+    LioFileBatch* const pBatch)
+{
+    if (!pData && numBytes)
     {
-        fprintf(stderr, "Unable to read file for concatenation \"%s\". File does not exist.\n", fileA);
+        lio_error_report(LIO_ERROR_INVALID_ARGUMENT, 0, "Unable to write a file without data", pPath, NULL);
         return false;
     }
 
-    if (!lio_path_does_exist(fileB, LIO_PATH_TYPE_FILE))
+    LioFileAtomic atomic;
+
+    if (!lio_file_atomic_open(&atomic, pPath, flags))
     {
-        fprintf(stderr, "Unable to read file for concatenation \"%s\". File does not exist.\n", fileB);
         return false;
     }
 
-    if (lio_path_does_exist(outFile, LIO_PATH_TYPE_FILE) && !overwrite)
+    if (numBytes && !lio_file_write(&atomic.file, pData, numBytes))
     {
-        fprintf(stderr, "Unable to write concatenated files to \"%s\". File already exists.\n", outFile);
+        lio_file_atomic_abort(&atomic);
         return false;
     }
 
-    return
-        (_lio_file_stream_into_file(fileA, outFile, LIO_FILE_DEFAULT_CHUNK_SIZE, false) &&
-        _lio_file_stream_into_file(fileB, outFile, LIO_FILE_DEFAULT_CHUNK_SIZE, true))
-        || lio_path_remove(outFile, false, false);
+    return lio_file_atomic_commit(&atomic, pBatch);
 }
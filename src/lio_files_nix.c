@@ -0,0 +1,2064 @@
+
+// expose fallocate(), sync_file_range(), posix_fadvise(), O_TMPFILE, and syncfs()
+#ifndef _GNU_SOURCE
+    #define _GNU_SOURCE
+#endif
+
+#include <errno.h>
+#include <pthread.h>
+#include <fcntl.h> // open(), posix_fadvise(), fallocate(), sync_file_range(), linkat()
+#include <unistd.h> // read(), write(), close()
+#include <sys/mman.h> // mmap(), munmap()
+#include <sys/stat.h> // fstat()
+#include <sys/types.h> // off_t, ssize_t
+
+#include <limits.h> // UINT_MAX, UCHAR_MAX
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h> // memchr()
+
+#include "light_io/lio_alloc.h"
+#include "light_io/lio_error.h"
+#include "light_io/lio_utils.h"
+#include "light_io/lio_bufpool.h"
+#include "light_io/lio_paths.h"
+#include "light_io/lio_files.h"
+#include "light_io/lio_stats.h"
+#include "light_io/lio_statcache.h"
+
+// Thanks Windows
+#ifndef restrict
+    #ifdef __restrict
+        #define restrict __restrict
+    #else
+        #define restrict
+    #endif
+#endif
+
+
+
+/*-----------------------------------------------------------------------------
+ * Page-cache management for background copies
+-----------------------------------------------------------------------------*/
+/*-------------------------------------
+ * Prepare both files for a large, sequential transfer
+------------------------------------*/
+static void _lio_file_background_begin(
+    const int srcFd,
+    const int dstFd,
+    const off_t dstOffset,
+    const off_t numBytes)
+{
+    #if defined(POSIX_FADV_SEQUENTIAL)
+        (void)posix_fadvise(srcFd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    #else
+        (void)srcFd;
+    #endif
+
+    #if defined(__linux__)
+        // Reserve all blocks up-front so the filesystem can lay out the
+        // destination contiguously. Not every filesystem supports this.
+        if (numBytes > 0)
+        {
+            (void)fallocate(dstFd, FALLOC_FL_KEEP_SIZE, dstOffset, numBytes);
+        }
+    #else
+        (void)dstFd;
+        (void)dstOffset;
+        (void)numBytes;
+    #endif
+}
+
+
+
+/*-------------------------------------
+ * Start writeback of a region which was just written
+------------------------------------*/
+static void _lio_file_background_flush(const int dstFd, const off_t dstOffset, const off_t numBytes)
+{
+    #if defined(__linux__)
+        (void)sync_file_range(dstFd, dstOffset, numBytes, SYNC_FILE_RANGE_WRITE);
+    #else
+        (void)dstFd;
+        (void)dstOffset;
+        (void)numBytes;
+    #endif
+}
+
+
+
+/*-------------------------------------
+ * Wait for a flushed region, then drop it from the page cache
+------------------------------------*/
+static void _lio_file_background_evict(
+    const int srcFd,
+    const off_t srcOffset,
+    const int dstFd,
+    const off_t dstOffset,
+    const off_t numBytes)
+{
+    if (numBytes <= 0)
+    {
+        return;
+    }
+
+    #if defined(__linux__)
+        // Dirty pages cannot be dropped, they must reach the disk first.
+        (void)sync_file_range(dstFd, dstOffset, numBytes, SYNC_FILE_RANGE_WAIT_BEFORE|SYNC_FILE_RANGE_WRITE|SYNC_FILE_RANGE_WAIT_AFTER);
+    #endif
+
+    #if defined(POSIX_FADV_DONTNEED)
+        (void)posix_fadvise(dstFd, dstOffset, numBytes, POSIX_FADV_DONTNEED);
+        (void)posix_fadvise(srcFd, srcOffset, numBytes, POSIX_FADV_DONTNEED);
+    #else
+        (void)srcFd;
+        (void)srcOffset;
+        (void)dstFd;
+        (void)dstOffset;
+    #endif
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Write an entire buffer to a file descriptor
+-----------------------------------------------------------------------------*/
+static size_t _lio_file_write_all(const int fd, const char* restrict pData, const size_t numBytes)
+{
+    size_t totalWritten = 0;
+
+    while (totalWritten < numBytes)
+    {
+        const ssize_t bytesWritten = write(fd, pData+totalWritten, numBytes-totalWritten);
+        LIO_STATS_ADD(LIO_STATS_SYSCALLS, 1);
+
+        if (bytesWritten < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+
+            break;
+        }
+
+        LIO_STATS_ADD(LIO_STATS_BYTES_WRITTEN, bytesWritten);
+        totalWritten += (size_t)bytesWritten;
+    }
+
+    return totalWritten;
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Toggle direct I/O on an open file
+-----------------------------------------------------------------------------*/
+static bool _lio_file_set_direct(const int fd, const bool direct)
+{
+    #if defined(O_DIRECT)
+        const int fileFlags = fcntl(fd, F_GETFL);
+        if (fileFlags < 0)
+        {
+            return false;
+        }
+
+        return fcntl(fd, F_SETFL, direct ? (fileFlags | O_DIRECT) : (fileFlags & ~O_DIRECT)) == 0;
+    #else
+        (void)fd;
+        return !direct;
+    #endif
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Return a transfer buffer to wherever it came from
+-----------------------------------------------------------------------------*/
+static void _lio_file_release_buffer(LioBufferPool* const pPool, char* const buffer)
+{
+    if (pPool)
+    {
+        lio_bufpool_release(pPool, buffer);
+    }
+    else
+    {
+        lio_alloc_free(buffer);
+    }
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Stream data between files through a user-space buffer
+-----------------------------------------------------------------------------*/
+static bool _lio_file_stream_fd(
+    const int srcFd,
+    const int dstFd,
+    const unsigned flags,
+    LioBufferPool* const pPool
+)
+{
+    const bool background = (flags & LIO_FILE_COPY_BACKGROUND) != 0;
+    bool direct = (flags & LIO_FILE_COPY_DIRECT) != 0;
+    size_t chunkSize = 0;
+    char* buffer = NULL;
+
+    // Direct I/O requires an aligned buffer so we wait for one from the pool.
+    // Buffered copies only borrow from the pool if a buffer is free.
+    if (pPool)
+    {
+        buffer = (char*)(direct ? lio_bufpool_acquire(pPool) : lio_bufpool_try_acquire(pPool));
+    }
+
+    const bool pooled = buffer != NULL;
+
+    if (pooled)
+    {
+        chunkSize = lio_bufpool_buffer_size(pPool);
+    }
+    else
+    {
+        direct = false;
+        chunkSize = background ? LIO_FILE_BACKGROUND_CHUNK_SIZE : LIO_FILE_DEFAULT_CHUNK_SIZE;
+        buffer = (char*) lio_alloc_malloc(sizeof(char) * chunkSize);
+
+        if (!buffer)
+        {
+            return false;
+        }
+    }
+
+    // Filesystems such as tmpfs reject O_DIRECT outright.
+    if (direct && !(_lio_file_set_direct(srcFd, true) && _lio_file_set_direct(dstFd, true)))
+    {
+        direct = false;
+        _lio_file_set_direct(srcFd, false);
+    }
+
+    const bool wasDirect = direct;
+    const off_t srcBase = LIO_UTILS_MAX(lseek(srcFd, 0, SEEK_CUR), (off_t)0);
+    const off_t dstBase = LIO_UTILS_MAX(lseek(dstFd, 0, SEEK_CUR), (off_t)0);
+    off_t totalBytes = 0;
+    off_t windowStart = 0;
+    off_t prevWindowStart = 0;
+    off_t prevWindowSize = 0;
+    struct stat srcInfo;
+
+    if (background && fstat(srcFd, &srcInfo) == 0)
+    {
+        _lio_file_background_begin(srcFd, dstFd, dstBase, srcInfo.st_size-srcBase);
+    }
+
+    bool ret = true;
+    ssize_t bytesRead = 0;
+
+    do
+    {
+        bytesRead = read(srcFd, buffer, chunkSize);
+        LIO_STATS_ADD(LIO_STATS_SYSCALLS, 1);
+
+        if (bytesRead < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+
+            if (direct && errno == EINVAL)
+            {
+                direct = false;
+                _lio_file_set_direct(srcFd, false);
+                _lio_file_set_direct(dstFd, false);
+                continue;
+            }
+
+            lio_error_report_errno(errno, "Failed to read data from a file descriptor", NULL, NULL);
+            ret = false;
+            break;
+        }
+
+        // O_DIRECT transfers must be a multiple of the block size. A short
+        // read means the unaligned tail of the file was reached, which gets
+        // written through the page cache instead.
+        if (direct && ((size_t)bytesRead & (LIO_BUFFER_POOL_ALIGNMENT-1)) != 0)
+        {
+            direct = false;
+            _lio_file_set_direct(srcFd, false);
+            _lio_file_set_direct(dstFd, false);
+        }
+
+        LIO_STATS_ADD(LIO_STATS_BYTES_READ, bytesRead);
+        size_t bytesWritten = _lio_file_write_all(dstFd, buffer, (size_t)bytesRead);
+
+        // Some filesystems accept O_DIRECT when opening a file but reject
+        // the transfers themselves.
+        if (bytesWritten != (size_t)bytesRead && direct && errno == EINVAL)
+        {
+            direct = false;
+            _lio_file_set_direct(srcFd, false);
+            _lio_file_set_direct(dstFd, false);
+            bytesWritten += _lio_file_write_all(dstFd, buffer+bytesWritten, (size_t)bytesRead-bytesWritten);
+        }
+
+        if (bytesWritten != (size_t)bytesRead)
+        {
+            lio_error_report_errno(errno, "Failed to stream data into a file descriptor", NULL, NULL);
+            ret = false;
+            break;
+        }
+
+        totalBytes += bytesRead;
+
+        // Writeback of each window is started as soon as it fills. The
+        // previous window should be on its way to disk by then, so waiting
+        // on it (and evicting it) rarely stalls the copy.
+        if (background && totalBytes-windowStart >= LIO_FILE_BACKGROUND_WINDOW_SIZE)
+        {
+            _lio_file_background_flush(dstFd, dstBase+windowStart, totalBytes-windowStart);
+            _lio_file_background_evict(srcFd, srcBase+prevWindowStart, dstFd, dstBase+prevWindowStart, prevWindowSize);
+
+            prevWindowStart = windowStart;
+            prevWindowSize = totalBytes-windowStart;
+            windowStart = totalBytes;
+        }
+    }
+    while (bytesRead != 0);
+
+    if (background)
+    {
+        _lio_file_background_evict(srcFd, srcBase+prevWindowStart, dstFd, dstBase+prevWindowStart, prevWindowSize);
+        _lio_file_background_evict(srcFd, srcBase+windowStart, dstFd, dstBase+windowStart, totalBytes-windowStart);
+    }
+
+    // Descriptors belong to the caller, leave them as they were found.
+    if (wasDirect)
+    {
+        _lio_file_set_direct(srcFd, false);
+        _lio_file_set_direct(dstFd, false);
+    }
+
+    _lio_file_release_buffer(pooled ? pPool : NULL, buffer);
+
+    return ret;
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Copy a range of one file into another, in-kernel where possible
+ *
+ * A negative "srcLength" copies everything up to the end of the source. The
+ * destination is written at its current position if "pDstOffset" is NULL.
+-----------------------------------------------------------------------------*/
+static bool _lio_file_transfer_range(
+    const int srcFd,
+    const off_t srcStart,
+    const off_t srcLength,
+    const int dstFd,
+    off_t* const pDstOffset,
+    int* const pPipe,
+    LioBufferPool* const pPool)
+{
+    const off_t srcEnd = (srcLength < 0) ? -1 : (srcStart + srcLength);
+    off_t srcOffset = srcStart;
+    ssize_t numBytes = 0;
+    size_t numPending = 0; // Bytes left in the pipe when splicing gave up
+    struct stat srcInfo;
+
+    // Pipes and character devices can only be consumed from their current
+    // position.
+    off_t* const pSrcOffset = (fstat(srcFd, &srcInfo) == 0 && S_ISREG(srcInfo.st_mode)) ? &srcOffset : NULL;
+
+    #define _LIO_FILE_NEXT_CHUNK( maxBytes ) \
+        ((srcEnd < 0) ? (size_t)(maxBytes) : (size_t)LIO_UTILS_MIN((off_t)(maxBytes), srcEnd-srcOffset))
+
+    #if defined(__linux__)
+        // Neither copy_file_range() nor splice() can write to a file opened
+        // with O_APPEND, so those go straight to user-space.
+        const int dstFlags = fcntl(dstFd, F_GETFL);
+
+        if (dstFlags >= 0 && (dstFlags & O_APPEND) == 0)
+        {
+            // Preferred: let the filesystem copy (or reflink) the data
+            // directly.
+            do
+            {
+                if (srcEnd >= 0 && srcOffset >= srcEnd)
+                {
+                    return true;
+                }
+
+                numBytes = copy_file_range(srcFd, pSrcOffset, dstFd, pDstOffset, _LIO_FILE_NEXT_CHUNK(LIO_FILE_SPLICE_CHUNK_SIZE), 0);
+                LIO_STATS_ADD(LIO_STATS_SYSCALLS, 1);
+
+                if (numBytes > 0)
+                {
+                    LIO_STATS_ADD(LIO_STATS_BYTES_READ, numBytes);
+                    LIO_STATS_ADD(LIO_STATS_BYTES_WRITTEN, numBytes);
+                    srcOffset += pSrcOffset ? 0 : numBytes;
+                }
+            }
+            while (numBytes > 0 || (numBytes < 0 && errno == EINTR));
+
+            if (numBytes == 0)
+            {
+                return true;
+            }
+
+            // EBADF is returned for destinations opened with O_APPEND.
+            if (errno != EXDEV && errno != ENOSYS && errno != EINVAL && errno != EOPNOTSUPP && errno != EBADF)
+            {
+                return false;
+            }
+
+            // Cross-device copies and older kernels can still move pages
+            // between files through a pipe without a round-trip to user-space.
+            if (pPipe[0] < 0 && pipe2(pPipe, O_CLOEXEC) != 0)
+            {
+                pPipe[0] = pPipe[1] = -1;
+            }
+
+            const off_t spliceStart = srcOffset;
+
+            while (pPipe[0] >= 0)
+            {
+                if (srcEnd >= 0 && srcOffset >= srcEnd)
+                {
+                    return true;
+                }
+
+                numBytes = splice(srcFd, pSrcOffset, pPipe[1], NULL, _LIO_FILE_NEXT_CHUNK(LIO_FILE_SPLICE_CHUNK_SIZE), SPLICE_F_MOVE);
+                LIO_STATS_ADD(LIO_STATS_SYSCALLS, 1);
+
+                if (numBytes > 0)
+                {
+                    LIO_STATS_ADD(LIO_STATS_BYTES_READ, numBytes);
+                    srcOffset += pSrcOffset ? 0 : numBytes;
+                }
+
+                if (numBytes == 0)
+                {
+                    return true;
+                }
+
+                if (numBytes < 0)
+                {
+                    if (errno == EINTR)
+                    {
+                        continue;
+                    }
+
+                    // Only fall back if nothing was moved through the pipe yet.
+                    if (errno == EINVAL && srcOffset == spliceStart)
+                    {
+                        break;
+                    }
+
+                    return false;
+                }
+
+                while (numBytes > 0)
+                {
+                    const ssize_t numMoved = splice(pPipe[0], NULL, dstFd, pDstOffset, (size_t)numBytes, SPLICE_F_MOVE);
+                    LIO_STATS_ADD(LIO_STATS_SYSCALLS, 1);
+
+                    if (numMoved < 0 && errno == EINTR)
+                    {
+                        continue;
+                    }
+
+                    // Some destinations accept write() but not splice(). Data
+                    // already in the pipe is copied out below before falling
+                    // back, and real write errors will surface there.
+                    if (numMoved <= 0)
+                    {
+                        numPending = (size_t)numBytes;
+                        break;
+                    }
+
+                    LIO_STATS_ADD(LIO_STATS_BYTES_WRITTEN, numMoved);
+                    numBytes -= numMoved;
+                }
+
+                if (numPending)
+                {
+                    break;
+                }
+            }
+        }
+    #else
+        (void)pPipe;
+    #endif
+
+    // Last resort, copy through user-space. Any buffer will do, so this
+    // never waits for the pool.
+    char* const pooledBuffer = pPool ? (char*)lio_bufpool_try_acquire(pPool) : NULL;
+    char* const buffer = pooledBuffer ? pooledBuffer : (char*)lio_alloc_malloc(LIO_FILE_DEFAULT_CHUNK_SIZE);
+    const size_t chunkSize = pooledBuffer ? lio_bufpool_buffer_size(pPool) : LIO_FILE_DEFAULT_CHUNK_SIZE;
+    bool ret = buffer != NULL;
+
+    while (ret && (numPending || srcEnd < 0 || srcOffset < srcEnd))
+    {
+        const size_t numToRead = numPending ? LIO_UTILS_MIN(numPending, chunkSize) : _LIO_FILE_NEXT_CHUNK(chunkSize);
+
+        if (numPending)
+        {
+            numBytes = read(pPipe[0], buffer, numToRead);
+        }
+        else
+        {
+            numBytes = pSrcOffset ? pread(srcFd, buffer, numToRead, srcOffset) : read(srcFd, buffer, numToRead);
+        }
+        LIO_STATS_ADD(LIO_STATS_SYSCALLS, 1);
+
+        if (numBytes == 0)
+        {
+            break;
+        }
+
+        if (numBytes < 0)
+        {
+            ret = (errno == EINTR);
+            continue;
+        }
+
+        for (ssize_t numWritten = 0; ret && numWritten < numBytes;)
+        {
+            const size_t numToWrite = (size_t)(numBytes-numWritten);
+            const ssize_t n = pDstOffset
+                ? pwrite(dstFd, buffer+numWritten, numToWrite, *pDstOffset)
+                : write(dstFd, buffer+numWritten, numToWrite);
+            LIO_STATS_ADD(LIO_STATS_SYSCALLS, 1);
+
+            if (n < 0)
+            {
+                ret = (errno == EINTR);
+                continue;
+            }
+
+            numWritten += n;
+            if (pDstOffset)
+            {
+                *pDstOffset += n;
+            }
+        }
+
+        // Bytes drained from the pipe were counted as read when spliced in
+        LIO_STATS_ADD(LIO_STATS_BYTES_WRITTEN, numBytes);
+        if (numPending)
+        {
+            numPending -= (size_t)numBytes;
+        }
+        else
+        {
+            LIO_STATS_ADD(LIO_STATS_BYTES_READ, numBytes);
+            srcOffset += numBytes;
+        }
+    }
+
+    #undef _LIO_FILE_NEXT_CHUNK
+
+    if (buffer)
+    {
+        _lio_file_release_buffer(pooledBuffer ? pPool : NULL, buffer);
+    }
+
+    return ret;
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * File Handles
+-----------------------------------------------------------------------------*/
+/*-------------------------------------
+ * Open a file
+------------------------------------*/
+bool lio_file_open(LioFile* const pFile, const char* const restrict path, const unsigned flags)
+{
+    if (!pFile || !path)
+    {
+        lio_error_report(LIO_ERROR_INVALID_ARGUMENT, 0, "Unable to open a file without a path", NULL, NULL);
+        return false;
+    }
+
+    const bool canRead = (flags & LIO_FILE_OPEN_READ) != 0;
+    const bool canWrite = (flags & (LIO_FILE_OPEN_WRITE | LIO_FILE_OPEN_APPEND)) != 0;
+    int openFlags = O_CLOEXEC | ((canRead && canWrite) ? O_RDWR : (canWrite ? O_WRONLY : O_RDONLY));
+
+    openFlags |= (flags & LIO_FILE_OPEN_CREATE) ? O_CREAT : 0;
+    openFlags |= (flags & LIO_FILE_OPEN_TRUNCATE) ? O_TRUNC : 0;
+    openFlags |= (flags & LIO_FILE_OPEN_APPEND) ? O_APPEND : 0;
+    openFlags |= (flags & LIO_FILE_OPEN_EXCLUSIVE) ? (O_CREAT | O_EXCL) : 0;
+
+    LIO_STATS_BEGIN(timer, LIO_STATS_OP_FILE_OPEN, path);
+
+    int fd = -1;
+    do
+    {
+        fd = open(path, openFlags, 0666);
+        LIO_STATS_ADD(LIO_STATS_SYSCALLS, 1);
+    }
+    while (fd < 0 && errno == EINTR);
+
+    if (fd < 0)
+    {
+        lio_error_report_errno(errno, "Unable to open a file", path, NULL);
+    }
+    else if (openFlags & O_CREAT)
+    {
+        lio_statcache_invalidate(path, false);
+    }
+
+    pFile->fd = fd;
+    pFile->owned = fd >= 0;
+
+    LIO_STATS_END_CALL(timer, NULL, flags, 0, 0, fd);
+
+    return fd >= 0;
+}
+
+
+
+/*-------------------------------------
+ * Wrap a file descriptor
+------------------------------------*/
+LioFile lio_file_wrap(const int fd)
+{
+    LioFile file;
+    file.fd = fd;
+    file.owned = false;
+    return file;
+}
+
+
+
+/*-------------------------------------
+ * Close a file
+------------------------------------*/
+bool lio_file_close(LioFile* const pFile)
+{
+    if (!pFile || pFile->fd < 0)
+    {
+        return true;
+    }
+
+    LIO_STATS_BEGIN(timer, LIO_STATS_OP_FILE_CLOSE, NULL);
+    LIO_STATS_ADD(LIO_STATS_SYSCALLS, pFile->owned ? 1 : 0);
+
+    const bool ret = !pFile->owned || close(pFile->fd) == 0;
+
+    if (!ret)
+    {
+        lio_error_report_errno(errno, "Unable to close a file descriptor", NULL, NULL);
+    }
+
+    LIO_STATS_END_CALL(timer, NULL, pFile->fd, 0, 0, ret);
+
+    pFile->fd = -1;
+    pFile->owned = false;
+
+    return ret;
+}
+
+
+
+/*-------------------------------------
+ * File metadata
+------------------------------------*/
+bool lio_file_stat(const LioFile* const pFile, LioFileStat* const pOutStat)
+{
+    struct stat info;
+
+    if (!pFile || !pOutStat)
+    {
+        lio_error_report(LIO_ERROR_INVALID_ARGUMENT, 0, "Unable to query a file without a handle", NULL, NULL);
+        return false;
+    }
+
+    if (fstat(pFile->fd, &info) != 0)
+    {
+        lio_error_report_errno(errno, "Unable to query a file descriptor", NULL, NULL);
+        return false;
+    }
+
+    pOutStat->size = S_ISREG(info.st_mode) ? (uint64_t)info.st_size : 0;
+    pOutStat->inode = (uint64_t)info.st_ino;
+    pOutStat->modifiedTime = (int64_t)info.st_mtime;
+    pOutStat->permissions = (uint32_t)(info.st_mode & 07777);
+
+    if (S_ISREG(info.st_mode))
+    {
+        pOutStat->type = LIO_PATH_TYPE_REGULAR;
+    }
+    else if (S_ISDIR(info.st_mode))
+    {
+        pOutStat->type = LIO_PATH_TYPE_FOLDER;
+    }
+    else if (S_ISLNK(info.st_mode))
+    {
+        pOutStat->type = LIO_PATH_TYPE_LINK;
+    }
+    else
+    {
+        pOutStat->type = LIO_PATH_TYPE_FILE;
+    }
+
+    return true;
+}
+
+
+
+/*-------------------------------------
+ * Reserve disk space
+------------------------------------*/
+bool lio_file_preallocate(const LioFile* const pFile, const uint64_t offset, const uint64_t numBytes)
+{
+    if (!pFile || pFile->fd < 0)
+    {
+        return false;
+    }
+
+    #if defined(__linux__)
+        return !numBytes || fallocate(pFile->fd, FALLOC_FL_KEEP_SIZE, (off_t)offset, (off_t)numBytes) == 0;
+    #else
+        (void)offset;
+        (void)numBytes;
+        return false;
+    #endif
+}
+
+
+
+/*-------------------------------------
+ * Append a range of a file at a destination's current position
+------------------------------------*/
+static bool _lio_file_append_fd(
+    const int srcFd,
+    const off_t srcStart,
+    const int dstFd,
+    int* const pPipe,
+    LioBufferPool* const pPool)
+{
+    const int dstFlags = fcntl(dstFd, F_GETFL);
+    const off_t dstStart = lseek(dstFd, 0, SEEK_CUR);
+    off_t dstOffset = dstStart;
+
+    // Explicit offsets cannot be used with pipes, sockets, or files opened
+    // for appending.
+    const bool dstSeekable = dstStart >= 0 && dstFlags >= 0 && (dstFlags & O_APPEND) == 0;
+
+    if (!_lio_file_transfer_range(srcFd, srcStart, -1, dstFd, dstSeekable ? &dstOffset : NULL, pPipe, pPool))
+    {
+        return false;
+    }
+
+    if (dstSeekable)
+    {
+        lseek(dstFd, dstOffset, SEEK_SET);
+    }
+
+    return true;
+}
+
+
+
+/*-------------------------------------
+ * Copy between open files
+------------------------------------*/
+static bool _lio_file_copy_fd(
+    const LioFile* const pFrom,
+    const LioFile* const pTo,
+    const unsigned flags,
+    LioBufferPool* const pPool)
+{
+    if (!pFrom || !pTo || pFrom->fd < 0 || pTo->fd < 0)
+    {
+        lio_error_report(LIO_ERROR_INVALID_ARGUMENT, 0, "Unable to copy between invalid file handles", NULL, NULL);
+        return false;
+    }
+
+    LioBufferPool* const pBufPool = pPool ? pPool : lio_bufpool_shared();
+
+    // Cache management and direct I/O need to see the data as it passes
+    // through user-space.
+    if (flags & (LIO_FILE_COPY_BACKGROUND | LIO_FILE_COPY_DIRECT))
+    {
+        return _lio_file_stream_fd(pFrom->fd, pTo->fd, flags, pBufPool);
+    }
+
+    int splicePipe[2] = {-1, -1};
+    const off_t srcStart = lseek(pFrom->fd, 0, SEEK_CUR);
+    const bool ret = _lio_file_append_fd(pFrom->fd, LIO_UTILS_MAX(srcStart, (off_t)0), pTo->fd, splicePipe, pBufPool);
+
+    if (splicePipe[0] >= 0)
+    {
+        close(splicePipe[0]);
+        close(splicePipe[1]);
+    }
+
+    // Explicit offsets do not move the source's position.
+    if (ret && srcStart >= 0)
+    {
+        lseek(pFrom->fd, 0, SEEK_END);
+    }
+
+    if (!ret)
+    {
+        lio_error_report_errno(errno, "Failed to copy between file descriptors", NULL, NULL);
+    }
+
+    return ret;
+}
+
+
+
+bool lio_file_copy_fd(
+    const LioFile* const pFrom,
+    const LioFile* const pTo,
+    const unsigned flags,
+    LioBufferPool* const pPool)
+{
+    LIO_STATS_BEGIN(timer, LIO_STATS_OP_FILE_COPY, NULL);
+    const bool ret = _lio_file_copy_fd(pFrom, pTo, flags, pPool);
+    LIO_STATS_END_CALL(timer, NULL, flags, pFrom ? pFrom->fd : -1, pTo ? pTo->fd : -1, ret);
+
+    return ret;
+}
+
+
+
+/*-------------------------------------
+ * Concatenate open files
+------------------------------------*/
+static bool _lio_file_concat_fd(
+    const LioFile* const pInFiles,
+    const unsigned numInFiles,
+    const LioFile* const pOutFile)
+{
+    if ((!pInFiles && numInFiles) || !pOutFile || pOutFile->fd < 0)
+    {
+        lio_error_report(LIO_ERROR_INVALID_ARGUMENT, 0, "Unable to concatenate invalid file handles", NULL, NULL);
+        return false;
+    }
+
+    uint64_t totalBytes = 0;
+    LioFileStat info;
+
+    for (unsigned i = 0; i < numInFiles; ++i)
+    {
+        if (!lio_file_stat(pInFiles+i, &info))
+        {
+            return false;
+        }
+
+        if (info.type == LIO_PATH_TYPE_FOLDER)
+        {
+            lio_error_report(LIO_ERROR_NOT_A_FILE, 0, "Unable to concatenate a folder", NULL, NULL);
+            return false;
+        }
+
+        totalBytes += info.size;
+    }
+
+    // Files opened for appending are written at their end, wherever their
+    // position happens to be.
+    const int dstFlags = fcntl(pOutFile->fd, F_GETFL);
+    struct stat dstInfo;
+    const off_t dstStart = (dstFlags >= 0 && (dstFlags & O_APPEND))
+        ? ((fstat(pOutFile->fd, &dstInfo) == 0) ? dstInfo.st_size : -1)
+        : lseek(pOutFile->fd, 0, SEEK_CUR);
+
+    if (dstStart >= 0)
+    {
+        (void)lio_file_preallocate(pOutFile, (uint64_t)dstStart, totalBytes);
+    }
+
+    LioBufferPool* const pPool = lio_bufpool_shared();
+    int splicePipe[2] = {-1, -1};
+    bool ret = true;
+
+    for (unsigned i = 0; ret && i < numInFiles; ++i)
+    {
+        ret = _lio_file_append_fd(pInFiles[i].fd, 0, pOutFile->fd, splicePipe, pPool);
+
+        if (!ret)
+        {
+            lio_error_report_errno(errno, "Failed to append between file descriptors", NULL, NULL);
+        }
+    }
+
+    if (splicePipe[0] >= 0)
+    {
+        close(splicePipe[0]);
+        close(splicePipe[1]);
+    }
+
+    return ret;
+}
+
+
+
+bool lio_file_concat_fd(
+    const LioFile* const pInFiles,
+    const unsigned numInFiles,
+    const LioFile* const pOutFile)
+{
+    LIO_STATS_BEGIN(timer, LIO_STATS_OP_FILE_CONCAT, NULL);
+    const bool ret = _lio_file_concat_fd(pInFiles, numInFiles, pOutFile);
+    LIO_STATS_END_CALL(timer, NULL, numInFiles, pOutFile ? pOutFile->fd : -1, 0, ret);
+
+    return ret;
+}
+
+
+
+/*-------------------------------------
+ * Read from a file
+------------------------------------*/
+static long long _lio_file_read(const LioFile* const pFile, void* const pData, const size_t numBytes)
+{
+    if (!pFile || !pData)
+    {
+        return -1;
+    }
+
+    size_t totalRead = 0;
+
+    while (totalRead < numBytes)
+    {
+        const ssize_t bytesRead = read(pFile->fd, (char*)pData+totalRead, numBytes-totalRead);
+        LIO_STATS_ADD(LIO_STATS_SYSCALLS, 1);
+
+        if (bytesRead < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+
+            lio_error_report_errno(errno, "Unable to read from a file descriptor", NULL, NULL);
+            return -1;
+        }
+
+        if (bytesRead == 0)
+        {
+            break;
+        }
+
+        LIO_STATS_ADD(LIO_STATS_BYTES_READ, bytesRead);
+        totalRead += (size_t)bytesRead;
+    }
+
+    return (long long)totalRead;
+}
+
+
+
+long long lio_file_read(const LioFile* const pFile, void* const pData, const size_t numBytes)
+{
+    LIO_STATS_BEGIN(timer, LIO_STATS_OP_FILE_READ, NULL);
+    const long long ret = _lio_file_read(pFile, pData, numBytes);
+    LIO_STATS_END_CALL(timer, NULL, pFile ? pFile->fd : -1, numBytes, 0, ret);
+
+    return ret;
+}
+
+
+
+/*-------------------------------------
+ * Write to a file
+------------------------------------*/
+bool lio_file_write(const LioFile* const pFile, const void* const pData, const size_t numBytes)
+{
+    if (!pFile || (!pData && numBytes))
+    {
+        return false;
+    }
+
+    LIO_STATS_BEGIN(timer, LIO_STATS_OP_FILE_WRITE, NULL);
+
+    const bool ret = _lio_file_write_all(pFile->fd, (const char*)pData, numBytes) == numBytes;
+    if (!ret)
+    {
+        lio_error_report_errno(errno, "Unable to write to a file descriptor", NULL, NULL);
+    }
+
+    LIO_STATS_END_CALL(timer, NULL, pFile->fd, numBytes, 0, ret);
+
+    return ret;
+}
+
+
+
+/*-------------------------------------
+ * Map a file into memory
+------------------------------------*/
+static const void* _lio_file_map(const LioFile* const pFile, size_t* const pOutNumBytes)
+{
+    struct stat info;
+
+    if (pOutNumBytes)
+    {
+        *pOutNumBytes = 0;
+    }
+
+    if (!pFile || !pOutNumBytes || fstat(pFile->fd, &info) != 0 || !S_ISREG(info.st_mode) || info.st_size == 0)
+    {
+        return NULL;
+    }
+
+    void* const pData = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, pFile->fd, 0);
+    LIO_STATS_ADD(LIO_STATS_SYSCALLS, 2);
+
+    if (pData == MAP_FAILED)
+    {
+        lio_error_report_errno(errno, "Unable to map a file descriptor", NULL, NULL);
+        return NULL;
+    }
+
+    *pOutNumBytes = (size_t)info.st_size;
+    return pData;
+}
+
+
+
+const void* lio_file_map(const LioFile* const pFile, size_t* const pOutNumBytes)
+{
+    LIO_STATS_BEGIN(timer, LIO_STATS_OP_FILE_MAP, NULL);
+    const void* const ret = _lio_file_map(pFile, pOutNumBytes);
+    LIO_STATS_END_CALL(timer, NULL, pFile ? pFile->fd : -1, 0, 0, ret ? *pOutNumBytes : 0);
+
+    return ret;
+}
+
+
+
+/*-------------------------------------
+ * Unmap a file
+------------------------------------*/
+void lio_file_unmap(const void* const pData, const size_t numBytes)
+{
+    if (pData)
+    {
+        munmap((void*)pData, numBytes);
+    }
+}
+
+
+
+/*-------------------------------------
+ * Read an entire file
+------------------------------------*/
+static char* _lio_file_read_all(const LioFile* const pFile, size_t* const pOutNumBytes)
+{
+    struct stat info;
+
+    if (!pFile || !pOutNumBytes || fstat(pFile->fd, &info) != 0 || S_ISDIR(info.st_mode))
+    {
+        return NULL;
+    }
+
+    const bool seekable = S_ISREG(info.st_mode);
+    size_t capacity = seekable ? (size_t)info.st_size : LIO_FILE_DEFAULT_CHUNK_SIZE;
+    size_t numBytes = 0;
+    char* pData = (char*)lio_alloc_malloc(capacity+1);
+
+    while (pData)
+    {
+        if (numBytes == capacity)
+        {
+            // Regular files are read up to the size they had when opened.
+            if (seekable)
+            {
+                break;
+            }
+
+            char* const pNewData = (char*)lio_alloc_realloc(pData, capacity+1, capacity*2 + 1);
+            if (!pNewData)
+            {
+                lio_alloc_free(pData);
+                pData = NULL;
+                break;
+            }
+
+            pData = pNewData;
+            capacity *= 2;
+        }
+
+        const ssize_t numRead = seekable
+            ? pread(pFile->fd, pData+numBytes, capacity-numBytes, (off_t)numBytes)
+            : read(pFile->fd, pData+numBytes, capacity-numBytes);
+        LIO_STATS_ADD(LIO_STATS_SYSCALLS, 1);
+
+        if (numRead == 0)
+        {
+            break;
+        }
+
+        if (numRead < 0)
+        {
+            if (errno != EINTR)
+            {
+                lio_error_report_errno(errno, "Unable to read a file descriptor", NULL, NULL);
+                lio_alloc_free(pData);
+                pData = NULL;
+            }
+            continue;
+        }
+
+        LIO_STATS_ADD(LIO_STATS_BYTES_READ, numRead);
+        numBytes += (size_t)numRead;
+    }
+
+    if (pData)
+    {
+        pData[numBytes] = '\0';
+        *pOutNumBytes = numBytes;
+    }
+
+    return pData;
+}
+
+
+
+char* lio_file_read_all(const LioFile* const pFile, size_t* const pOutNumBytes)
+{
+    LIO_STATS_BEGIN(timer, LIO_STATS_OP_FILE_READ, NULL);
+    char* const ret = _lio_file_read_all(pFile, pOutNumBytes);
+    LIO_STATS_END_CALL(timer, NULL, pFile ? pFile->fd : -1, UINT64_MAX, 0, ret ? (int64_t)*pOutNumBytes : -1);
+
+    return ret;
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * File Splitting
+-----------------------------------------------------------------------------*/
+/*-------------------------------------
+ * Shared state between split threads
+------------------------------------*/
+typedef struct _LioFileSplitJob
+{
+    int srcFd;
+    const off_t* pPartEnds;
+    char* const* ppPartPaths;
+    unsigned numParts;
+    atomic_uint nextPart;
+    atomic_bool failed;
+    int sysError; // Set by the first part which fails
+    unsigned failedPart;
+    LioBufferPool* pPool;
+} _LioFileSplitJob;
+
+
+
+/*-------------------------------------
+ * Find the offset just past the next delimiter
+------------------------------------*/
+static off_t _lio_file_find_delimiter(
+    const int fd,
+    off_t offset,
+    const off_t fileSize,
+    const char delimiter)
+{
+    char buffer[LIO_FILE_DEFAULT_CHUNK_SIZE];
+
+    while (offset < fileSize)
+    {
+        const ssize_t numBytes = pread(fd, buffer, sizeof(buffer), offset);
+        if (numBytes <= 0)
+        {
+            if (numBytes < 0 && errno == EINTR)
+            {
+                continue;
+            }
+
+            break;
+        }
+
+        const char* const pDelim = (const char*)memchr(buffer, delimiter, (size_t)numBytes);
+        if (pDelim)
+        {
+            return offset + (off_t)(pDelim - buffer) + 1;
+        }
+
+        offset += numBytes;
+    }
+
+    return fileSize;
+}
+
+
+
+/*-------------------------------------
+ * Compute where each part ends
+------------------------------------*/
+static unsigned _lio_file_split_plan(
+    const int fd,
+    const off_t fileSize,
+    const enum LioFileSplitMode mode,
+    const size_t param,
+    const int delimiter,
+    off_t* const pPartEnds,
+    const unsigned maxParts)
+{
+    const off_t quotient = fileSize / (off_t)param;
+    const off_t remainder = fileSize % (off_t)param;
+    unsigned numParts = 0;
+    off_t start = 0;
+
+    for (unsigned i = 0; i < maxParts; ++i)
+    {
+        off_t end = (mode == LIO_FILE_SPLIT_COUNT)
+            ? (quotient * (off_t)(i+1)) + ((remainder * (off_t)(i+1)) / (off_t)param)
+            : start + (off_t)param;
+
+        if (end > fileSize || (mode == LIO_FILE_SPLIT_COUNT && i == maxParts-1))
+        {
+            end = fileSize;
+        }
+
+        if (delimiter != LIO_FILE_SPLIT_NO_DELIMITER && end > start && end < fileSize)
+        {
+            end = _lio_file_find_delimiter(fd, end-1, fileSize, (char)delimiter);
+        }
+
+        // Either the previous record ran past this part's nominal end, or
+        // more parts were requested than the file has bytes.
+        if (end <= start)
+        {
+            continue;
+        }
+
+        pPartEnds[numParts++] = end;
+        start = end;
+
+        if (mode == LIO_FILE_SPLIT_SIZE && start >= fileSize)
+        {
+            break;
+        }
+    }
+
+    return numParts;
+}
+
+
+
+/*-------------------------------------
+ * Thread to write split parts
+------------------------------------*/
+static void* _lio_file_split_worker(void* pData)
+{
+    _LioFileSplitJob* const pJob = (_LioFileSplitJob*)pData;
+    int splicePipe[2] = {-1, -1};
+
+    while (!atomic_load_explicit(&pJob->failed, memory_order_relaxed))
+    {
+        const unsigned index = atomic_fetch_add_explicit(&pJob->nextPart, 1u, memory_order_relaxed);
+        if (index >= pJob->numParts)
+        {
+            break;
+        }
+
+        const off_t start = index ? pJob->pPartEnds[index-1] : 0;
+        const off_t length = pJob->pPartEnds[index] - start;
+        const char* const pPath = pJob->ppPartPaths[index];
+        // Workers are not inside the caller's timed operation, so their
+        // transfers are counted against LIO_STATS_OP_OTHER.
+        const int dstFd = open(pPath, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+        lio_statcache_invalidate(pPath, false);
+        LIO_STATS_ADD(LIO_STATS_SYSCALLS, 1);
+        off_t dstOffset = 0;
+        bool ret = dstFd >= 0;
+
+        if (ret)
+        {
+            #if defined(__linux__)
+                if (length > 0)
+                {
+                    (void)fallocate(dstFd, FALLOC_FL_KEEP_SIZE, 0, length);
+                }
+            #endif
+
+            ret = _lio_file_transfer_range(pJob->srcFd, start, length, dstFd, &dstOffset, splicePipe, pJob->pPool)
+                && dstOffset == length;
+            ret = (close(dstFd) == 0) && ret;
+        }
+
+        if (!ret)
+        {
+            // Errors are reported by the calling thread once all workers join
+            const int sysError = errno;
+            bool expected = false;
+
+            if (atomic_compare_exchange_strong(&pJob->failed, &expected, true))
+            {
+                pJob->sysError = sysError;
+                pJob->failedPart = index;
+            }
+        }
+    }
+
+    if (splicePipe[0] >= 0)
+    {
+        close(splicePipe[0]);
+        close(splicePipe[1]);
+    }
+
+    return NULL;
+}
+
+
+
+/*-------------------------------------
+ * Split a file into parts
+------------------------------------*/
+static char** _lio_file_split(
+    const char* const restrict inFile,
+    const char* const restrict outPrefix,
+    const enum LioFileSplitMode mode,
+    const size_t param,
+    const int delimiter,
+    unsigned* const pOutNumParts)
+{
+    if (!inFile || !outPrefix || !param || !pOutNumParts)
+    {
+        lio_error_report(LIO_ERROR_INVALID_ARGUMENT, 0, "Unable to split a file with invalid parameters", inFile, NULL);
+        return NULL;
+    }
+
+    if (delimiter != LIO_FILE_SPLIT_NO_DELIMITER && (delimiter < 0 || delimiter > UCHAR_MAX))
+    {
+        lio_error_report(LIO_ERROR_INVALID_ARGUMENT, 0, "Unable to split a file with an invalid delimiter", inFile, NULL);
+        return NULL;
+    }
+
+    const int srcFd = open(inFile, O_RDONLY | O_CLOEXEC);
+    struct stat info;
+
+    LIO_STATS_ADD(LIO_STATS_SYSCALLS, 2);
+
+    if (srcFd < 0 || fstat(srcFd, &info) != 0)
+    {
+        lio_error_report_errno(errno, "Unable to open a file for splitting", inFile, NULL);
+        if (srcFd >= 0)
+        {
+            close(srcFd);
+        }
+        return NULL;
+    }
+
+    if (!S_ISREG(info.st_mode))
+    {
+        lio_error_report(LIO_ERROR_NOT_A_FILE, 0, "Unable to split a file which is not a regular file", inFile, NULL);
+        close(srcFd);
+        return NULL;
+    }
+
+    const off_t fileSize = info.st_size;
+    const size_t maxParts = (mode == LIO_FILE_SPLIT_COUNT) ? param : (size_t)((fileSize + (off_t)param - 1) / (off_t)param);
+
+    if (maxParts > UINT_MAX)
+    {
+        lio_error_report(LIO_ERROR_LIMIT_EXCEEDED, 0, "Unable to split a file into so many parts", inFile, NULL);
+        close(srcFd);
+        return NULL;
+    }
+
+    off_t* const pPartEnds = (off_t*)lio_alloc_malloc(sizeof(off_t) * (maxParts ? maxParts : 1));
+    char** const ppPartPaths = (char**)lio_alloc_calloc(maxParts ? maxParts : 1, sizeof(char*));
+
+    if (!pPartEnds || !ppPartPaths)
+    {
+        lio_error_report(LIO_ERROR_OUT_OF_MEMORY, 0, "Unable to allocate memory to split a file", inFile, NULL);
+        lio_alloc_free(ppPartPaths);
+        lio_alloc_free(pPartEnds);
+        close(srcFd);
+        return NULL;
+    }
+
+    const unsigned numParts = _lio_file_split_plan(srcFd, fileSize, mode, param, delimiter, pPartEnds, (unsigned)maxParts);
+    int numDigits = 4;
+
+    for (unsigned n = numParts ? numParts-1 : 0; n >= 10000; n /= 10)
+    {
+        ++numDigits;
+    }
+
+    bool ret = true;
+
+    for (unsigned i = 0; ret && i < numParts; ++i)
+    {
+        ppPartPaths[i] = lio_utils_str_fmt("%s.%0*u", outPrefix, numDigits, i);
+        ret = ppPartPaths[i] != NULL;
+    }
+
+    if (ret && numParts)
+    {
+        _LioFileSplitJob job;
+        job.srcFd = srcFd;
+        job.pPartEnds = pPartEnds;
+        job.ppPartPaths = ppPartPaths;
+        job.numParts = numParts;
+        job.pPool = lio_bufpool_shared();
+        atomic_init(&job.nextPart, 0u);
+        atomic_init(&job.failed, false);
+
+        const long numCpus = sysconf(_SC_NPROCESSORS_ONLN);
+        unsigned numThreads = (unsigned)LIO_UTILS_MIN(numCpus > 0 ? (unsigned long)numCpus : 1ul, (unsigned long)LIO_FILE_SPLIT_MAX_THREADS);
+        numThreads = LIO_UTILS_MIN(numThreads, numParts);
+
+        pthread_t threads[LIO_FILE_SPLIT_MAX_THREADS];
+        unsigned numStarted = 0;
+
+        // The calling thread is always one of the workers.
+        while (numStarted+1 < numThreads && pthread_create(&threads[numStarted], NULL, &_lio_file_split_worker, &job) == 0)
+        {
+            ++numStarted;
+        }
+
+        _lio_file_split_worker(&job);
+
+        while (numStarted --> 0)
+        {
+            pthread_join(threads[numStarted], NULL);
+        }
+
+        ret = !atomic_load(&job.failed);
+        if (!ret)
+        {
+            lio_error_report_errno(job.sysError, "Unable to write a file part", ppPartPaths[job.failedPart], inFile);
+        }
+    }
+
+    close(srcFd);
+    lio_alloc_free(pPartEnds);
+
+    if (!ret)
+    {
+        for (unsigned i = 0; i < numParts && ppPartPaths[i]; ++i)
+        {
+            if (lio_path_does_exist(ppPartPaths[i], LIO_PATH_TYPE_FILE))
+            {
+                lio_path_remove(ppPartPaths[i], false, false);
+            }
+        }
+
+        lio_paths_destroy(ppPartPaths, numParts);
+        return NULL;
+    }
+
+    *pOutNumParts = numParts;
+    return ppPartPaths;
+}
+
+
+
+char** lio_file_split(
+    const char* const restrict inFile,
+    const char* const restrict outPrefix,
+    const enum LioFileSplitMode mode,
+    const size_t param,
+    const int delimiter,
+    unsigned* const pOutNumParts)
+{
+    LIO_STATS_BEGIN(timer, LIO_STATS_OP_FILE_SPLIT, inFile);
+    char** const ret = _lio_file_split(inFile, outPrefix, mode, param, delimiter, pOutNumParts);
+    LIO_STATS_END_CALL(timer, outPrefix, mode, param, delimiter, ret ? (int64_t)*pOutNumParts : -1);
+
+    return ret;
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Atomic, durable writes
+-----------------------------------------------------------------------------*/
+enum
+{
+    LIO_FILE_TEMP_ATTEMPTS = 16 // Names tried before giving up on a hidden file
+};
+
+static atomic_uint _lioFileTempCounter = 0;
+
+
+
+/*-------------------------------------
+ * Retrieve the folder a path lives in
+------------------------------------*/
+static char* _lio_file_parent(const char* const pPath)
+{
+    const char* const pSep = strrchr(pPath, '/');
+
+    if (!pSep)
+    {
+        return lio_utils_str_fmt(".");
+    }
+
+    return lio_utils_str_fmt("%.*s", (pSep == pPath) ? 1 : (int)(pSep - pPath), pPath);
+}
+
+
+
+/*-------------------------------------
+ * Generate a hidden name beside a path, unique within this process
+------------------------------------*/
+static char* _lio_file_temp_path(const char* const pPath)
+{
+    const char* const pSep = strrchr(pPath, '/');
+    const int dirLength = pSep ? (int)(pSep - pPath) + 1 : 0;
+    const unsigned id = atomic_fetch_add_explicit(&_lioFileTempCounter, 1, memory_order_relaxed);
+
+    return lio_utils_str_fmt("%.*s.%s.%ld-%u.tmp", dirLength, pPath, pPath + dirLength, (long)getpid(), id);
+}
+
+
+
+/*-------------------------------------
+ * Link an anonymous file to a path
+------------------------------------*/
+static int _lio_file_link_fd(const int fd, const char* const pPath)
+{
+    char procPath[32];
+    snprintf(procPath, sizeof(procPath), "/proc/self/fd/%d", fd);
+
+    LIO_STATS_ADD(LIO_STATS_SYSCALLS, 1);
+    return linkat(AT_FDCWD, procPath, AT_FDCWD, pPath, AT_SYMLINK_FOLLOW);
+}
+
+
+
+/*-------------------------------------
+ * Give the contents of an atomic write a hidden name
+------------------------------------*/
+static bool _lio_file_atomic_name(LioFileAtomic* const pAtomic)
+{
+    for (unsigned attempt = 0; !pAtomic->pTempPath && attempt < LIO_FILE_TEMP_ATTEMPTS; ++attempt)
+    {
+        char* const pTempPath = _lio_file_temp_path(pAtomic->pPath);
+
+        if (!pTempPath)
+        {
+            lio_error_report(LIO_ERROR_OUT_OF_MEMORY, 0, "Unable to name a temporary file", pAtomic->pPath, NULL);
+            return false;
+        }
+
+        if (_lio_file_link_fd(pAtomic->file.fd, pTempPath) == 0)
+        {
+            pAtomic->pTempPath = pTempPath;
+            return true;
+        }
+
+        const int err = errno;
+        lio_utils_str_destroy(pTempPath);
+
+        if (err != EEXIST)
+        {
+            lio_error_report_errno(err, "Unable to name a temporary file", pAtomic->pPath, NULL);
+            return false;
+        }
+    }
+
+    return pAtomic->pTempPath != NULL;
+}
+
+
+
+/*-------------------------------------
+ * Move finished contents into place. link() refuses to replace an existing
+ * file, which rename() cannot be told to do portably.
+------------------------------------*/
+static bool _lio_file_publish(const char* const pTempPath, const char* const pPath, const bool overwrite)
+{
+    int ret = 0;
+
+    if (overwrite)
+    {
+        ret = rename(pTempPath, pPath);
+        LIO_STATS_ADD(LIO_STATS_SYSCALLS, 1);
+    }
+    else
+    {
+        ret = link(pTempPath, pPath);
+        LIO_STATS_ADD(LIO_STATS_SYSCALLS, 1);
+
+        if (ret == 0)
+        {
+            unlink(pTempPath);
+            LIO_STATS_ADD(LIO_STATS_SYSCALLS, 1);
+        }
+    }
+
+    if (ret != 0)
+    {
+        lio_error_report_errno(errno, "Unable to move a file into place", pTempPath, pPath);
+        return false;
+    }
+
+    lio_statcache_invalidate(pPath, false);
+    return true;
+}
+
+
+
+/*-------------------------------------
+ * Flush a folder, or with "wholeFs" the filesystem it is on, to storage
+------------------------------------*/
+static bool _lio_file_sync_folder(const char* const pFolder, const bool wholeFs)
+{
+    int fd = -1;
+    int ret = -1;
+
+    do
+    {
+        fd = open(pFolder, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        LIO_STATS_ADD(LIO_STATS_SYSCALLS, 1);
+    }
+    while (fd < 0 && errno == EINTR);
+
+    if (fd >= 0)
+    {
+        #if defined(__linux__)
+            ret = wholeFs ? syncfs(fd) : fsync(fd);
+        #else
+            // Without syncfs(), the whole system is the smallest unit to flush
+            if (wholeFs)
+            {
+                sync();
+            }
+            ret = fsync(fd);
+        #endif
+
+        LIO_STATS_ADD(LIO_STATS_SYSCALLS, 2);
+        if (ret != 0)
+        {
+            const int err = errno;
+            close(fd);
+            errno = err;
+        }
+        else
+        {
+            close(fd);
+        }
+    }
+
+    if (ret != 0)
+    {
+        lio_error_report_errno(errno, "Unable to synchronize a folder", pFolder, NULL);
+        return false;
+    }
+
+    return true;
+}
+
+
+
+static bool _lio_file_sync_parent(const char* const pPath, const bool wholeFs)
+{
+    char* const pParent = _lio_file_parent(pPath);
+
+    if (!pParent)
+    {
+        lio_error_report(LIO_ERROR_OUT_OF_MEMORY, 0, "Unable to synchronize a folder", pPath, NULL);
+        return false;
+    }
+
+    const bool ret = _lio_file_sync_folder(pParent, wholeFs);
+    lio_utils_str_destroy(pParent);
+
+    return ret;
+}
+
+
+
+/*-------------------------------------
+ * Begin an atomic write
+------------------------------------*/
+bool lio_file_atomic_open(LioFileAtomic* const pAtomic, const char* const restrict pPath, const unsigned flags)
+{
+    if (!pAtomic || !pPath || !*pPath)
+    {
+        lio_error_report(LIO_ERROR_INVALID_ARGUMENT, 0, "Unable to write a file atomically without a path", NULL, NULL);
+        return false;
+    }
+
+    pAtomic->file = lio_file_wrap(-1);
+    pAtomic->pTempPath = NULL;
+    pAtomic->overwrite = (flags & LIO_FILE_COPY_OVERWRITE) != 0;
+    pAtomic->pPath = lio_utils_str_copy(pPath, 0);
+
+    if (!pAtomic->pPath)
+    {
+        lio_error_report(LIO_ERROR_OUT_OF_MEMORY, 0, "Unable to write a file atomically", pPath, NULL);
+        return false;
+    }
+
+    // Fail before any data is written rather than when it is published
+    if (!pAtomic->overwrite && lio_path_does_exist(pPath, LIO_PATH_TYPE_ANY))
+    {
+        lio_error_report(LIO_ERROR_ALREADY_EXISTS, EEXIST, "Unable to replace an existing file", pPath, NULL);
+        lio_file_atomic_abort(pAtomic);
+        return false;
+    }
+
+    int fd = -1;
+
+    #if defined(O_TMPFILE)
+    {
+        // Anonymous files need no cleanup if the process dies mid-write
+        char* const pParent = _lio_file_parent(pPath);
+
+        do
+        {
+            fd = pParent ? open(pParent, O_TMPFILE | O_WRONLY | O_CLOEXEC, 0666) : -1;
+            LIO_STATS_ADD(LIO_STATS_SYSCALLS, 1);
+        }
+        while (fd < 0 && errno == EINTR);
+
+        lio_utils_str_destroy(pParent);
+    }
+    #endif
+
+    // Filesystems without anonymous files get a hidden one instead
+    for (unsigned attempt = 0; fd < 0 && attempt < LIO_FILE_TEMP_ATTEMPTS; ++attempt)
+    {
+        char* const pTempPath = _lio_file_temp_path(pPath);
+        if (!pTempPath)
+        {
+            errno = ENOMEM;
+            break;
+        }
+
+        do
+        {
+            fd = open(pTempPath, O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0666);
+            LIO_STATS_ADD(LIO_STATS_SYSCALLS, 1);
+        }
+        while (fd < 0 && errno == EINTR);
+
+        if (fd >= 0)
+        {
+            pAtomic->pTempPath = pTempPath;
+            break;
+        }
+
+        const int err = errno;
+        lio_utils_str_destroy(pTempPath);
+
+        if (err != EEXIST)
+        {
+            errno = err;
+            break;
+        }
+    }
+
+    if (fd < 0)
+    {
+        lio_error_report_errno(errno, "Unable to create a temporary file", pPath, NULL);
+        lio_file_atomic_abort(pAtomic);
+        return false;
+    }
+
+    pAtomic->file.fd = fd;
+    pAtomic->file.owned = true;
+
+    // A replaced file keeps its permissions and, where the process may give
+    // files away, its owner. Only set-ID bits depend on the owner being kept.
+    struct stat info;
+    LIO_STATS_ADD(LIO_STATS_SYSCALLS, pAtomic->overwrite ? 1 : 0);
+    if (pAtomic->overwrite && stat(pPath, &info) == 0 && S_ISREG(info.st_mode))
+    {
+        mode_t mode = info.st_mode & 07777;
+
+        if (info.st_uid != geteuid() || info.st_gid != getegid())
+        {
+            LIO_STATS_ADD(LIO_STATS_SYSCALLS, 1);
+            if (fchown(fd, info.st_uid, info.st_gid) != 0)
+            {
+                if (errno != EPERM)
+                {
+                    lio_error_report_errno(errno, "Unable to keep the owner of a replaced file", pPath, NULL);
+                    lio_file_atomic_abort(pAtomic);
+                    return false;
+                }
+
+                mode &= ~(mode_t)(S_ISUID | S_ISGID);
+            }
+        }
+
+        LIO_STATS_ADD(LIO_STATS_SYSCALLS, 1);
+        if (fchmod(fd, mode) != 0)
+        {
+            lio_error_report_errno(errno, "Unable to keep the permissions of a replaced file", pPath, NULL);
+            lio_file_atomic_abort(pAtomic);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+
+/*-------------------------------------
+ * Add an atomic write to a batch
+------------------------------------*/
+static bool _lio_file_batch_push(LioFileBatch* const pBatch, LioFileAtomic* const pAtomic, const uint64_t device)
+{
+    if (pBatch->numEntries == pBatch->capacity)
+    {
+        const size_t capacity = pBatch->capacity ? pBatch->capacity*2 : 64;
+        LioFileBatchEntry* const pEntries = (LioFileBatchEntry*)lio_alloc_realloc(
+            pBatch->pEntries,
+            sizeof(LioFileBatchEntry) * pBatch->capacity,
+            sizeof(LioFileBatchEntry) * capacity);
+
+        if (!pEntries)
+        {
+            lio_error_report(LIO_ERROR_OUT_OF_MEMORY, 0, "Unable to grow a batch of atomic writes", pAtomic->pPath, NULL);
+            return false;
+        }
+
+        pBatch->pEntries = pEntries;
+        pBatch->capacity = capacity;
+    }
+
+    LioFileBatchEntry* const pEntry = pBatch->pEntries + pBatch->numEntries++;
+    pEntry->pTempPath = pAtomic->pTempPath;
+    pEntry->pPath = pAtomic->pPath;
+    pEntry->device = device;
+    pEntry->overwrite = pAtomic->overwrite;
+
+    // The batch owns both paths now
+    pAtomic->pTempPath = NULL;
+    pAtomic->pPath = NULL;
+
+    return true;
+}
+
+
+
+/*-------------------------------------
+ * Publish an atomic write
+------------------------------------*/
+static bool _lio_file_atomic_commit(LioFileAtomic* const pAtomic, LioFileBatch* const pBatch)
+{
+    if (pBatch)
+    {
+        // Batched files are closed and named until the batch is committed,
+        // so a large batch does not hold a descriptor per file.
+        struct stat info;
+        bool ret = fstat(pAtomic->file.fd, &info) == 0;
+        LIO_STATS_ADD(LIO_STATS_SYSCALLS, 1);
+
+        if (!ret)
+        {
+            lio_error_report_errno(errno, "Unable to query a temporary file", pAtomic->pPath, NULL);
+        }
+
+        ret = ret && _lio_file_atomic_name(pAtomic);
+        ret = lio_file_close(&pAtomic->file) && ret;
+
+        return ret && _lio_file_batch_push(pBatch, pAtomic, (uint64_t)info.st_dev);
+    }
+
+    int ret = 0;
+    do
+    {
+        ret = fdatasync(pAtomic->file.fd);
+        LIO_STATS_ADD(LIO_STATS_SYSCALLS, 1);
+    }
+    while (ret != 0 && errno == EINTR);
+
+    if (ret != 0)
+    {
+        lio_error_report_errno(errno, "Unable to synchronize a file", pAtomic->pPath, NULL);
+        return false;
+    }
+
+    // An anonymous file can be linked straight to a path which is free
+    if (!pAtomic->pTempPath && !pAtomic->overwrite)
+    {
+        if (_lio_file_link_fd(pAtomic->file.fd, pAtomic->pPath) != 0)
+        {
+            lio_error_report_errno(errno, "Unable to move a file into place", pAtomic->pPath, NULL);
+            return false;
+        }
+
+        lio_statcache_invalidate(pAtomic->pPath, false);
+    }
+    else if (!_lio_file_atomic_name(pAtomic) || !_lio_file_publish(pAtomic->pTempPath, pAtomic->pPath, pAtomic->overwrite))
+    {
+        return false;
+    }
+    else
+    {
+        // Nothing is left to clean up under the hidden name
+        lio_utils_str_destroy(pAtomic->pTempPath);
+        pAtomic->pTempPath = NULL;
+    }
+
+    return _lio_file_sync_parent(pAtomic->pPath, false);
+}
+
+
+
+bool lio_file_atomic_commit(LioFileAtomic* const pAtomic, LioFileBatch* const pBatch)
+{
+    if (!pAtomic || !pAtomic->pPath || pAtomic->file.fd < 0)
+    {
+        lio_error_report(LIO_ERROR_INVALID_ARGUMENT, 0, "Unable to commit an atomic write which is not open", NULL, NULL);
+        return false;
+    }
+
+    LIO_STATS_BEGIN(timer, LIO_STATS_OP_FILE_COMMIT, pAtomic->pPath);
+    const bool ret = _lio_file_atomic_commit(pAtomic, pBatch);
+    LIO_STATS_END_CALL(timer, NULL, pBatch != NULL, pAtomic->overwrite, 0, ret);
+
+    lio_file_atomic_abort(pAtomic);
+
+    return ret;
+}
+
+
+
+/*-------------------------------------
+ * Discard an atomic write
+------------------------------------*/
+void lio_file_atomic_abort(LioFileAtomic* const pAtomic)
+{
+    if (!pAtomic)
+    {
+        return;
+    }
+
+    lio_file_close(&pAtomic->file);
+
+    if (pAtomic->pTempPath)
+    {
+        unlink(pAtomic->pTempPath);
+        LIO_STATS_ADD(LIO_STATS_SYSCALLS, 1);
+    }
+
+    lio_utils_str_destroy(pAtomic->pTempPath);
+    lio_utils_str_destroy(pAtomic->pPath);
+    pAtomic->pTempPath = NULL;
+    pAtomic->pPath = NULL;
+}
+
+
+
+/*-------------------------------------
+ * Batches of atomic writes
+------------------------------------*/
+void lio_file_batch_init(LioFileBatch* const pBatch)
+{
+    pBatch->pEntries = NULL;
+    pBatch->numEntries = 0;
+    pBatch->capacity = 0;
+}
+
+
+
+/*-------------------------------------
+ * Flush each filesystem holding a batched file once
+------------------------------------*/
+static bool _lio_file_batch_sync(const LioFileBatch* const pBatch)
+{
+    bool ret = true;
+
+    for (size_t i = 0; i < pBatch->numEntries; ++i)
+    {
+        bool isSynced = false;
+
+        for (size_t j = 0; j < i && !isSynced; ++j)
+        {
+            isSynced = pBatch->pEntries[j].device == pBatch->pEntries[i].device;
+        }
+
+        if (!isSynced)
+        {
+            ret = _lio_file_sync_parent(pBatch->pEntries[i].pPath, true) && ret;
+        }
+    }
+
+    return ret;
+}
+
+
+
+static bool _lio_file_batch_commit(LioFileBatch* const pBatch)
+{
+    // Data must be durable before any name refers to it
+    bool ret = _lio_file_batch_sync(pBatch);
+    size_t numPublished = 0;
+
+    for (size_t i = 0; ret && i < pBatch->numEntries; ++i)
+    {
+        LioFileBatchEntry* const pEntry = pBatch->pEntries + i;
+
+        if (_lio_file_publish(pEntry->pTempPath, pEntry->pPath, pEntry->overwrite))
+        {
+            lio_utils_str_destroy(pEntry->pTempPath);
+            pEntry->pTempPath = NULL;
+            ++numPublished;
+        }
+    }
+
+    // Then the new names themselves
+    ret = (numPublished == 0 || _lio_file_batch_sync(pBatch)) && ret && numPublished == pBatch->numEntries;
+
+    lio_file_batch_terminate(pBatch);
+
+    return ret;
+}
+
+
+
+bool lio_file_batch_commit(LioFileBatch* const pBatch)
+{
+    if (!pBatch)
+    {
+        lio_error_report(LIO_ERROR_INVALID_ARGUMENT, 0, "Unable to commit a batch which does not exist", NULL, NULL);
+        return false;
+    }
+
+    LIO_STATS_BEGIN(timer, LIO_STATS_OP_FILE_COMMIT, NULL);
+    const size_t numEntries = pBatch->numEntries;
+    const bool ret = _lio_file_batch_commit(pBatch);
+    LIO_STATS_END_CALL(timer, NULL, 1, 0, numEntries, ret);
+    (void)numEntries; // Only recorded with stats enabled
+
+    return ret;
+}
+
+
+
+void lio_file_batch_terminate(LioFileBatch* const pBatch)
+{
+    if (!pBatch)
+    {
+        return;
+    }
+
+    for (size_t i = 0; i < pBatch->numEntries; ++i)
+    {
+        LioFileBatchEntry* const pEntry = pBatch->pEntries + i;
+
+        if (pEntry->pTempPath)
+        {
+            unlink(pEntry->pTempPath);
+            LIO_STATS_ADD(LIO_STATS_SYSCALLS, 1);
+        }
+
+        lio_utils_str_destroy(pEntry->pTempPath);
+        lio_utils_str_destroy(pEntry->pPath);
+    }
+
+    lio_alloc_free(pBatch->pEntries);
+    lio_file_batch_init(pBatch);
+}
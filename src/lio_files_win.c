@@ -0,0 +1,901 @@
+
+#ifndef WIN32_LEAN_AND_MEAN
+    #define WIN32_LEAN_AND_MEAN
+#endif /* WIN32_LEAN_AND_MEAN */
+#include <windows.h> // CreateFileMapping(), MapViewOfFile()
+#include <io.h> // _open(), _read(), _write(), _close(), _get_osfhandle()
+#include <fcntl.h> // _O_* flags
+#include <sys/stat.h> // _fstat64()
+
+#include <errno.h>
+#include <limits.h> // UINT_MAX, UCHAR_MAX
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h> // memchr()
+
+#include "light_io/lio_alloc.h"
+#include "light_io/lio_error.h"
+#include "light_io/lio_utils.h"
+#include "light_io/lio_paths.h"
+#include "light_io/lio_files.h"
+
+// Thanks Windows
+#ifndef restrict
+    #ifdef __restrict
+        #define restrict __restrict
+    #else
+        #define restrict
+    #endif
+#endif
+
+
+
+/*-----------------------------------------------------------------------------
+ * File Handles
+-----------------------------------------------------------------------------*/
+/*-------------------------------------
+ * Open a file
+------------------------------------*/
+bool lio_file_open(LioFile* const pFile, const char* const restrict path, const unsigned flags)
+{
+    if (!pFile || !path)
+    {
+        lio_error_report(LIO_ERROR_INVALID_ARGUMENT, 0, "Unable to open a file without a path", NULL, NULL);
+        return false;
+    }
+
+    const bool canRead = (flags & LIO_FILE_OPEN_READ) != 0;
+    const bool canWrite = (flags & (LIO_FILE_OPEN_WRITE | LIO_FILE_OPEN_APPEND)) != 0;
+    int openFlags = _O_BINARY | _O_NOINHERIT | ((canRead && canWrite) ? _O_RDWR : (canWrite ? _O_WRONLY : _O_RDONLY));
+
+    openFlags |= (flags & LIO_FILE_OPEN_CREATE) ? _O_CREAT : 0;
+    openFlags |= (flags & LIO_FILE_OPEN_TRUNCATE) ? _O_TRUNC : 0;
+    openFlags |= (flags & LIO_FILE_OPEN_APPEND) ? _O_APPEND : 0;
+    openFlags |= (flags & LIO_FILE_OPEN_EXCLUSIVE) ? (_O_CREAT | _O_EXCL) : 0;
+
+    const int fd = _open(path, openFlags, _S_IREAD | _S_IWRITE);
+    if (fd < 0)
+    {
+        lio_error_report_errno(errno, "Unable to open a file", path, NULL);
+    }
+
+    pFile->fd = fd;
+    pFile->owned = fd >= 0;
+
+    return fd >= 0;
+}
+
+
+
+/*-------------------------------------
+ * Wrap a file descriptor
+------------------------------------*/
+LioFile lio_file_wrap(const int fd)
+{
+    LioFile file;
+    file.fd = fd;
+    file.owned = false;
+    return file;
+}
+
+
+
+/*-------------------------------------
+ * Close a file
+------------------------------------*/
+bool lio_file_close(LioFile* const pFile)
+{
+    if (!pFile || pFile->fd < 0)
+    {
+        return true;
+    }
+
+    const bool ret = !pFile->owned || _close(pFile->fd) == 0;
+
+    pFile->fd = -1;
+    pFile->owned = false;
+
+    return ret;
+}
+
+
+
+/*-------------------------------------
+ * File metadata
+------------------------------------*/
+bool lio_file_stat(const LioFile* const pFile, LioFileStat* const pOutStat)
+{
+    struct _stat64 info;
+
+    if (!pFile || !pOutStat || _fstat64(pFile->fd, &info) != 0)
+    {
+        return false;
+    }
+
+    const bool isRegular = (info.st_mode & _S_IFMT) == _S_IFREG;
+    const bool isFolder = (info.st_mode & _S_IFMT) == _S_IFDIR;
+
+    pOutStat->size = isRegular ? (uint64_t)info.st_size : 0;
+    pOutStat->inode = (uint64_t)info.st_ino;
+    pOutStat->modifiedTime = (int64_t)info.st_mtime;
+    pOutStat->permissions = (uint32_t)(info.st_mode & 0777);
+    pOutStat->type = isRegular ? LIO_PATH_TYPE_REGULAR : (isFolder ? LIO_PATH_TYPE_FOLDER : LIO_PATH_TYPE_FILE);
+
+    return true;
+}
+
+
+
+/*-------------------------------------
+ * Reserve disk space
+ *
+ * Windows cannot reserve space without changing the size of a file.
+------------------------------------*/
+bool lio_file_preallocate(const LioFile* const pFile, const uint64_t offset, const uint64_t numBytes)
+{
+    (void)pFile;
+    (void)offset;
+    (void)numBytes;
+    return false;
+}
+
+
+
+/*-------------------------------------
+ * Stream a file into another through a buffer
+------------------------------------*/
+static bool _lio_file_stream_fd(const int srcFd, const int dstFd, char* const buffer)
+{
+    int numRead = 0;
+
+    while ((numRead = _read(srcFd, buffer, LIO_FILE_DEFAULT_CHUNK_SIZE)) > 0)
+    {
+        if (_write(dstFd, buffer, (unsigned)numRead) != numRead)
+        {
+            return false;
+        }
+    }
+
+    return numRead == 0;
+}
+
+
+
+/*-------------------------------------
+ * Copy between open files
+ *
+ * Page-cache hints and buffer pools are not available on Windows.
+------------------------------------*/
+bool lio_file_copy_fd(
+    const LioFile* const pFrom,
+    const LioFile* const pTo,
+    const unsigned flags,
+    LioBufferPool* const pPool)
+{
+    (void)flags;
+    (void)pPool;
+
+    if (!pFrom || !pTo || pFrom->fd < 0 || pTo->fd < 0)
+    {
+        lio_error_report(LIO_ERROR_INVALID_ARGUMENT, 0, "Unable to copy between invalid file handles", NULL, NULL);
+        return false;
+    }
+
+    char* const buffer = (char*)lio_alloc_malloc(LIO_FILE_DEFAULT_CHUNK_SIZE);
+    const bool ret = buffer && _lio_file_stream_fd(pFrom->fd, pTo->fd, buffer);
+
+    if (!ret)
+    {
+        lio_error_report_errno(errno, "Failed to copy between file descriptors", NULL, NULL);
+    }
+
+    lio_alloc_free(buffer);
+    return ret;
+}
+
+
+
+/*-------------------------------------
+ * Concatenate open files
+------------------------------------*/
+bool lio_file_concat_fd(
+    const LioFile* const pInFiles,
+    const unsigned numInFiles,
+    const LioFile* const pOutFile)
+{
+    if ((!pInFiles && numInFiles) || !pOutFile || pOutFile->fd < 0)
+    {
+        lio_error_report(LIO_ERROR_INVALID_ARGUMENT, 0, "Unable to concatenate invalid file handles", NULL, NULL);
+        return false;
+    }
+
+    char* const buffer = (char*)lio_alloc_malloc(LIO_FILE_DEFAULT_CHUNK_SIZE);
+    bool ret = buffer != NULL;
+
+    for (unsigned i = 0; ret && i < numInFiles; ++i)
+    {
+        // Regular files are concatenated in their entirety.
+        const __int64 srcStart = _lseeki64(pInFiles[i].fd, 0, SEEK_CUR);
+        if (srcStart >= 0)
+        {
+            _lseeki64(pInFiles[i].fd, 0, SEEK_SET);
+        }
+
+        ret = _lio_file_stream_fd(pInFiles[i].fd, pOutFile->fd, buffer);
+
+        if (srcStart >= 0)
+        {
+            _lseeki64(pInFiles[i].fd, srcStart, SEEK_SET);
+        }
+
+        if (!ret)
+        {
+            lio_error_report_errno(errno, "Failed to append between file descriptors", NULL, NULL);
+        }
+    }
+
+    lio_alloc_free(buffer);
+    return ret;
+}
+
+
+
+/*-------------------------------------
+ * Read from a file
+------------------------------------*/
+long long lio_file_read(const LioFile* const pFile, void* const pData, const size_t numBytes)
+{
+    if (!pFile || !pData)
+    {
+        return -1;
+    }
+
+    size_t totalRead = 0;
+
+    while (totalRead < numBytes)
+    {
+        const size_t numToRead = LIO_UTILS_MIN(numBytes-totalRead, (size_t)INT_MAX);
+        const int bytesRead = _read(pFile->fd, (char*)pData+totalRead, (unsigned)numToRead);
+
+        if (bytesRead < 0)
+        {
+            lio_error_report_errno(errno, "Unable to read from a file descriptor", NULL, NULL);
+            return -1;
+        }
+
+        if (bytesRead == 0)
+        {
+            break;
+        }
+
+        totalRead += (size_t)bytesRead;
+    }
+
+    return (long long)totalRead;
+}
+
+
+
+/*-------------------------------------
+ * Write to a file
+------------------------------------*/
+bool lio_file_write(const LioFile* const pFile, const void* const pData, const size_t numBytes)
+{
+    if (!pFile || (!pData && numBytes))
+    {
+        return false;
+    }
+
+    size_t totalWritten = 0;
+
+    while (totalWritten < numBytes)
+    {
+        const size_t numToWrite = LIO_UTILS_MIN(numBytes-totalWritten, (size_t)INT_MAX);
+        const int bytesWritten = _write(pFile->fd, (const char*)pData+totalWritten, (unsigned)numToWrite);
+
+        if (bytesWritten <= 0)
+        {
+            lio_error_report_errno(errno, "Unable to write to a file descriptor", NULL, NULL);
+            return false;
+        }
+
+        totalWritten += (size_t)bytesWritten;
+    }
+
+    return true;
+}
+
+
+
+/*-------------------------------------
+ * Map a file into memory
+------------------------------------*/
+const void* lio_file_map(const LioFile* const pFile, size_t* const pOutNumBytes)
+{
+    LioFileStat info;
+
+    if (pOutNumBytes)
+    {
+        *pOutNumBytes = 0;
+    }
+
+    if (!pOutNumBytes || !lio_file_stat(pFile, &info) || info.type != LIO_PATH_TYPE_REGULAR || !info.size)
+    {
+        return NULL;
+    }
+
+    HANDLE hFile = (HANDLE)_get_osfhandle(pFile->fd);
+    HANDLE hMapping = CreateFileMappingA(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (!hMapping)
+    {
+        lio_error_report(LIO_ERROR_IO, 0, "Unable to map a file descriptor", NULL, NULL);
+        return NULL;
+    }
+
+    // The view keeps the mapping alive after its handle is closed.
+    const void* const pData = MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(hMapping);
+
+    if (pData)
+    {
+        *pOutNumBytes = (size_t)info.size;
+    }
+
+    return pData;
+}
+
+
+
+/*-------------------------------------
+ * Unmap a file
+------------------------------------*/
+void lio_file_unmap(const void* const pData, const size_t numBytes)
+{
+    (void)numBytes;
+
+    if (pData)
+    {
+        UnmapViewOfFile(pData);
+    }
+}
+
+
+
+/*-------------------------------------
+ * Read an entire file
+------------------------------------*/
+char* lio_file_read_all(const LioFile* const pFile, size_t* const pOutNumBytes)
+{
+    LioFileStat info;
+
+    if (!pOutNumBytes || !lio_file_stat(pFile, &info) || info.type == LIO_PATH_TYPE_FOLDER)
+    {
+        return NULL;
+    }
+
+    const bool seekable = info.type == LIO_PATH_TYPE_REGULAR;
+    const __int64 position = seekable ? _lseeki64(pFile->fd, 0, SEEK_CUR) : -1;
+    size_t capacity = seekable ? (size_t)info.size : LIO_FILE_DEFAULT_CHUNK_SIZE;
+    size_t numBytes = 0;
+    char* pData = (char*)lio_alloc_malloc(capacity+1);
+
+    if (seekable)
+    {
+        _lseeki64(pFile->fd, 0, SEEK_SET);
+    }
+
+    while (pData)
+    {
+        if (numBytes == capacity)
+        {
+            if (seekable)
+            {
+                break;
+            }
+
+            char* const pNewData = (char*)lio_alloc_realloc(pData, capacity+1, capacity*2 + 1);
+            if (!pNewData)
+            {
+                lio_alloc_free(pData);
+                pData = NULL;
+                break;
+            }
+
+            pData = pNewData;
+            capacity *= 2;
+        }
+
+        const size_t numToRead = LIO_UTILS_MIN(capacity-numBytes, (size_t)INT_MAX);
+        const int numRead = _read(pFile->fd, pData+numBytes, (unsigned)numToRead);
+
+        if (numRead <= 0)
+        {
+            if (numRead < 0)
+            {
+                lio_alloc_free(pData);
+                pData = NULL;
+            }
+            break;
+        }
+
+        numBytes += (size_t)numRead;
+    }
+
+    if (seekable)
+    {
+        _lseeki64(pFile->fd, position, SEEK_SET);
+    }
+
+    if (pData)
+    {
+        pData[numBytes] = '\0';
+        *pOutNumBytes = numBytes;
+    }
+
+    return pData;
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * File Splitting
+-----------------------------------------------------------------------------*/
+/*-------------------------------------
+ * Find the offset just past the next delimiter
+------------------------------------*/
+static long long _lio_file_find_delimiter(
+    FILE* const pFile,
+    long long offset,
+    const long long fileSize,
+    const char delimiter)
+{
+    char buffer[LIO_FILE_DEFAULT_CHUNK_SIZE];
+
+    if (_fseeki64(pFile, offset, SEEK_SET) != 0)
+    {
+        return fileSize;
+    }
+
+    while (offset < fileSize)
+    {
+        const size_t numBytes = fread(buffer, 1, sizeof(buffer), pFile);
+        if (!numBytes)
+        {
+            break;
+        }
+
+        const char* const pDelim = (const char*)memchr(buffer, delimiter, numBytes);
+        if (pDelim)
+        {
+            return offset + (long long)(pDelim - buffer) + 1;
+        }
+
+        offset += (long long)numBytes;
+    }
+
+    return fileSize;
+}
+
+
+
+/*-------------------------------------
+ * Split a file into parts
+ *
+ * Parts are written sequentially on Windows.
+------------------------------------*/
+char** lio_file_split(
+    const char* const restrict inFile,
+    const char* const restrict outPrefix,
+    const enum LioFileSplitMode mode,
+    const size_t param,
+    const int delimiter,
+    unsigned* const pOutNumParts)
+{
+    if (!inFile || !outPrefix || !param || !pOutNumParts)
+    {
+        lio_error_report(LIO_ERROR_INVALID_ARGUMENT, 0, "Unable to split a file with invalid parameters", inFile, NULL);
+        return NULL;
+    }
+
+    if (delimiter != LIO_FILE_SPLIT_NO_DELIMITER && (delimiter < 0 || delimiter > UCHAR_MAX))
+    {
+        lio_error_report(LIO_ERROR_INVALID_ARGUMENT, 0, "Unable to split a file with an invalid delimiter", inFile, NULL);
+        return NULL;
+    }
+
+    FILE* const pFrom = fopen(inFile, "rb");
+    if (!pFrom || _fseeki64(pFrom, 0, SEEK_END) != 0)
+    {
+        lio_error_report_errno(errno, "Unable to open a file for splitting", inFile, NULL);
+        if (pFrom)
+        {
+            fclose(pFrom);
+        }
+        return NULL;
+    }
+
+    const long long fileSize = _ftelli64(pFrom);
+    const long long quotient = fileSize / (long long)param;
+    const long long remainder = fileSize % (long long)param;
+    const size_t maxParts = (mode == LIO_FILE_SPLIT_COUNT) ? param : (size_t)((fileSize + (long long)param - 1) / (long long)param);
+    char** const ppPartPaths = (maxParts <= UINT_MAX) ? (char**)lio_alloc_calloc(maxParts ? maxParts : 1, sizeof(char*)) : NULL;
+    char* const buffer = (char*)lio_alloc_malloc(LIO_FILE_DEFAULT_CHUNK_SIZE);
+    unsigned numParts = 0;
+    long long start = 0;
+    bool ret = ppPartPaths && buffer;
+
+    for (unsigned i = 0; ret && i < (unsigned)maxParts; ++i)
+    {
+        long long end = (mode == LIO_FILE_SPLIT_COUNT)
+            ? (quotient * (long long)(i+1)) + ((remainder * (long long)(i+1)) / (long long)param)
+            : start + (long long)param;
+
+        if (end > fileSize || (mode == LIO_FILE_SPLIT_COUNT && i == maxParts-1))
+        {
+            end = fileSize;
+        }
+
+        if (delimiter != LIO_FILE_SPLIT_NO_DELIMITER)
+        {
+            if (end > start && end < fileSize)
+            {
+                end = _lio_file_find_delimiter(pFrom, end-1, fileSize, (char)delimiter);
+            }
+
+            if (end <= start)
+            {
+                continue;
+            }
+        }
+
+        ppPartPaths[numParts] = lio_utils_str_fmt("%s.%04u", outPrefix, numParts);
+        FILE* const pTo = ppPartPaths[numParts] ? fopen(ppPartPaths[numParts], "wb") : NULL;
+        ++numParts;
+
+        if (!pTo || _fseeki64(pFrom, start, SEEK_SET) != 0)
+        {
+            ret = false;
+        }
+
+        for (long long remaining = end-start; ret && remaining > 0;)
+        {
+            const size_t numToRead = (size_t)LIO_UTILS_MIN(remaining, (long long)LIO_FILE_DEFAULT_CHUNK_SIZE);
+            const size_t numRead = fread(buffer, 1, numToRead, pFrom);
+
+            ret = numRead == numToRead && fwrite(buffer, 1, numRead, pTo) == numRead;
+            remaining -= (long long)numRead;
+        }
+
+        if (pTo)
+        {
+            fclose(pTo);
+        }
+
+        start = end;
+
+        if (mode == LIO_FILE_SPLIT_SIZE && start >= fileSize)
+        {
+            break;
+        }
+    }
+
+    lio_alloc_free(buffer);
+    fclose(pFrom);
+
+    if (!ret)
+    {
+        lio_error_report_errno(errno, "Unable to split a file", inFile, NULL);
+
+        for (unsigned i = 0; ppPartPaths && i < numParts && ppPartPaths[i]; ++i)
+        {
+            if (lio_path_does_exist(ppPartPaths[i], LIO_PATH_TYPE_FILE))
+            {
+                lio_path_remove(ppPartPaths[i], false, false);
+            }
+        }
+
+        if (ppPartPaths)
+        {
+            lio_paths_destroy(ppPartPaths, numParts);
+        }
+
+        return NULL;
+    }
+
+    *pOutNumParts = numParts;
+    return ppPartPaths;
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Atomic, durable writes
+-----------------------------------------------------------------------------*/
+enum
+{
+    LIO_FILE_TEMP_ATTEMPTS = 16 // Names tried before giving up on a hidden file
+};
+
+static volatile LONG _lioFileTempCounter = 0;
+
+
+
+/*-------------------------------------
+ * Generate a hidden name beside a path, unique within this process
+------------------------------------*/
+static char* _lio_file_temp_path(const char* const pPath)
+{
+    const char* const pBackslash = strrchr(pPath, '\\');
+    const char* const pSlash = strrchr(pPath, '/');
+    const char* const pSep = (pBackslash > pSlash) ? pBackslash : pSlash;
+    const int dirLength = pSep ? (int)(pSep - pPath) + 1 : 0;
+    const unsigned id = (unsigned)InterlockedIncrement(&_lioFileTempCounter);
+
+    return lio_utils_str_fmt("%.*s.%s.%lu-%u.tmp", dirLength, pPath, pPath + dirLength, (unsigned long)GetCurrentProcessId(), id);
+}
+
+
+
+/*-------------------------------------
+ * Move finished contents into place
+------------------------------------*/
+static bool _lio_file_publish(const char* const pTempPath, const char* const pPath, const bool overwrite)
+{
+    const DWORD moveFlags = MOVEFILE_WRITE_THROUGH | (overwrite ? MOVEFILE_REPLACE_EXISTING : 0);
+
+    if (!MoveFileEx(pTempPath, pPath, moveFlags))
+    {
+        const DWORD err = GetLastError();
+        const enum LioErrorCode code = (err == ERROR_ALREADY_EXISTS || err == ERROR_FILE_EXISTS) ? LIO_ERROR_ALREADY_EXISTS : LIO_ERROR_IO;
+        lio_error_report(code, (int)err, "Unable to move a file into place", pTempPath, pPath);
+        return false;
+    }
+
+    return true;
+}
+
+
+
+/*-------------------------------------
+ * Begin an atomic write
+------------------------------------*/
+bool lio_file_atomic_open(LioFileAtomic* const pAtomic, const char* const restrict pPath, const unsigned flags)
+{
+    if (!pAtomic || !pPath || !*pPath)
+    {
+        lio_error_report(LIO_ERROR_INVALID_ARGUMENT, 0, "Unable to write a file atomically without a path", NULL, NULL);
+        return false;
+    }
+
+    pAtomic->file = lio_file_wrap(-1);
+    pAtomic->pTempPath = NULL;
+    pAtomic->overwrite = (flags & LIO_FILE_COPY_OVERWRITE) != 0;
+    pAtomic->pPath = lio_utils_str_copy(pPath, 0);
+
+    if (!pAtomic->pPath)
+    {
+        lio_error_report(LIO_ERROR_OUT_OF_MEMORY, 0, "Unable to write a file atomically", pPath, NULL);
+        return false;
+    }
+
+    if (!pAtomic->overwrite && lio_path_does_exist(pPath, LIO_PATH_TYPE_ANY))
+    {
+        lio_error_report(LIO_ERROR_ALREADY_EXISTS, EEXIST, "Unable to replace an existing file", pPath, NULL);
+        lio_file_atomic_abort(pAtomic);
+        return false;
+    }
+
+    // Windows has no anonymous files, so a hidden one is always used
+    int fd = -1;
+    int err = 0;
+
+    for (unsigned attempt = 0; fd < 0 && attempt < LIO_FILE_TEMP_ATTEMPTS; ++attempt)
+    {
+        char* const pTempPath = _lio_file_temp_path(pPath);
+        if (!pTempPath)
+        {
+            err = ENOMEM;
+            break;
+        }
+
+        fd = _open(pTempPath, _O_BINARY | _O_NOINHERIT | _O_WRONLY | _O_CREAT | _O_EXCL, _S_IREAD | _S_IWRITE);
+        if (fd >= 0)
+        {
+            pAtomic->pTempPath = pTempPath;
+            break;
+        }
+
+        err = errno;
+        lio_utils_str_destroy(pTempPath);
+
+        if (err != EEXIST)
+        {
+            break;
+        }
+    }
+
+    if (fd < 0)
+    {
+        lio_error_report_errno(err, "Unable to create a temporary file", pPath, NULL);
+        lio_file_atomic_abort(pAtomic);
+        return false;
+    }
+
+    pAtomic->file.fd = fd;
+    pAtomic->file.owned = true;
+
+    return true;
+}
+
+
+
+/*-------------------------------------
+ * Add an atomic write to a batch
+------------------------------------*/
+static bool _lio_file_batch_push(LioFileBatch* const pBatch, LioFileAtomic* const pAtomic)
+{
+    if (pBatch->numEntries == pBatch->capacity)
+    {
+        const size_t capacity = pBatch->capacity ? pBatch->capacity*2 : 64;
+        LioFileBatchEntry* const pEntries = (LioFileBatchEntry*)lio_alloc_realloc(
+            pBatch->pEntries,
+            sizeof(LioFileBatchEntry) * pBatch->capacity,
+            sizeof(LioFileBatchEntry) * capacity);
+
+        if (!pEntries)
+        {
+            lio_error_report(LIO_ERROR_OUT_OF_MEMORY, 0, "Unable to grow a batch of atomic writes", pAtomic->pPath, NULL);
+            return false;
+        }
+
+        pBatch->pEntries = pEntries;
+        pBatch->capacity = capacity;
+    }
+
+    LioFileBatchEntry* const pEntry = pBatch->pEntries + pBatch->numEntries++;
+    pEntry->pTempPath = pAtomic->pTempPath;
+    pEntry->pPath = pAtomic->pPath;
+    pEntry->device = 0;
+    pEntry->overwrite = pAtomic->overwrite;
+
+    pAtomic->pTempPath = NULL;
+    pAtomic->pPath = NULL;
+
+    return true;
+}
+
+
+
+/*-------------------------------------
+ * Publish an atomic write
+------------------------------------*/
+bool lio_file_atomic_commit(LioFileAtomic* const pAtomic, LioFileBatch* const pBatch)
+{
+    if (!pAtomic || !pAtomic->pPath || pAtomic->file.fd < 0)
+    {
+        lio_error_report(LIO_ERROR_INVALID_ARGUMENT, 0, "Unable to commit an atomic write which is not open", NULL, NULL);
+        return false;
+    }
+
+    // There is no filesystem-wide flush without administrator rights, so each
+    // file is flushed here and a batch only defers the renames.
+    bool ret = FlushFileBuffers((HANDLE)_get_osfhandle(pAtomic->file.fd)) != 0;
+    if (!ret)
+    {
+        lio_error_report(LIO_ERROR_IO, (int)GetLastError(), "Unable to synchronize a file", pAtomic->pPath, NULL);
+    }
+
+    ret = lio_file_close(&pAtomic->file) && ret;
+
+    if (ret)
+    {
+        if (pBatch)
+        {
+            ret = _lio_file_batch_push(pBatch, pAtomic);
+        }
+        else if ((ret = _lio_file_publish(pAtomic->pTempPath, pAtomic->pPath, pAtomic->overwrite)))
+        {
+            lio_utils_str_destroy(pAtomic->pTempPath);
+            pAtomic->pTempPath = NULL;
+        }
+    }
+
+    lio_file_atomic_abort(pAtomic);
+
+    return ret;
+}
+
+
+
+/*-------------------------------------
+ * Discard an atomic write
+------------------------------------*/
+void lio_file_atomic_abort(LioFileAtomic* const pAtomic)
+{
+    if (!pAtomic)
+    {
+        return;
+    }
+
+    lio_file_close(&pAtomic->file);
+
+    if (pAtomic->pTempPath)
+    {
+        DeleteFile(pAtomic->pTempPath);
+    }
+
+    lio_utils_str_destroy(pAtomic->pTempPath);
+    lio_utils_str_destroy(pAtomic->pPath);
+    pAtomic->pTempPath = NULL;
+    pAtomic->pPath = NULL;
+}
+
+
+
+/*-------------------------------------
+ * Batches of atomic writes
+------------------------------------*/
+void lio_file_batch_init(LioFileBatch* const pBatch)
+{
+    pBatch->pEntries = NULL;
+    pBatch->numEntries = 0;
+    pBatch->capacity = 0;
+}
+
+
+
+bool lio_file_batch_commit(LioFileBatch* const pBatch)
+{
+    if (!pBatch)
+    {
+        lio_error_report(LIO_ERROR_INVALID_ARGUMENT, 0, "Unable to commit a batch which does not exist", NULL, NULL);
+        return false;
+    }
+
+    bool ret = true;
+
+    for (size_t i = 0; i < pBatch->numEntries; ++i)
+    {
+        LioFileBatchEntry* const pEntry = pBatch->pEntries + i;
+
+        if (_lio_file_publish(pEntry->pTempPath, pEntry->pPath, pEntry->overwrite))
+        {
+            lio_utils_str_destroy(pEntry->pTempPath);
+            pEntry->pTempPath = NULL;
+        }
+        else
+        {
+            ret = false;
+        }
+    }
+
+    lio_file_batch_terminate(pBatch);
+
+    return ret;
+}
+
+
+
+void lio_file_batch_terminate(LioFileBatch* const pBatch)
+{
+    if (!pBatch)
+    {
+        return;
+    }
+
+    for (size_t i = 0; i < pBatch->numEntries; ++i)
+    {
+        LioFileBatchEntry* const pEntry = pBatch->pEntries + i;
+
+        if (pEntry->pTempPath)
+        {
+            DeleteFile(pEntry->pTempPath);
+        }
+
+        lio_utils_str_destroy(pEntry->pTempPath);
+        lio_utils_str_destroy(pEntry->pPath);
+    }
+
+    lio_alloc_free(pBatch->pEntries);
+    lio_file_batch_init(pBatch);
+}
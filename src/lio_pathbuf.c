@@ -0,0 +1,262 @@
+
+#include <stdarg.h> // va_list
+#include <stdio.h>
+#include <string.h> // memcpy(), strlen()
+
+#include "light_io/lio_alloc.h"
+#include "light_io/lio_error.h"
+#include "light_io/lio_utils.h"
+#include "light_io/lio_paths.h"
+#include "light_io/lio_pathbuf.h"
+#include "light_io/lio_pathview.h"
+
+
+
+/*-----------------------------------------------------------------------------
+ * Ensure a path buffer can hold a number of characters
+-----------------------------------------------------------------------------*/
+static bool _lio_pathbuf_reserve(LioPathBuf* const pBuf, const size_t numChars)
+{
+    if (numChars < pBuf->capacity)
+    {
+        return true;
+    }
+
+    const size_t newCapacity = LIO_UTILS_MAX(numChars+1, pBuf->capacity*2);
+    char* pNewData = NULL;
+
+    if (lio_pathbuf_is_spilled(pBuf))
+    {
+        pNewData = (char*)lio_alloc_realloc(pBuf->pData, pBuf->capacity, newCapacity);
+    }
+    else
+    {
+        pNewData = (char*)lio_alloc_malloc(newCapacity);
+        if (pNewData)
+        {
+            memcpy(pNewData, pBuf->pData, pBuf->length+1);
+        }
+    }
+
+    if (!pNewData)
+    {
+        lio_error_report(LIO_ERROR_OUT_OF_MEMORY, 0, "Unable to grow a path buffer", NULL, NULL);
+        return false;
+    }
+
+    pBuf->pData = pNewData;
+    pBuf->capacity = newCapacity;
+
+    return true;
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Length of a path's root directory, if it has one
+-----------------------------------------------------------------------------*/
+static size_t _lio_pathbuf_root_length(const LioPathBuf* const pBuf)
+{
+    #ifdef _WIN32
+        // Drive roots, such as "C:\"
+        if (pBuf->length >= 3 && pBuf->pData[1] == ':' && pBuf->pData[2] == LIO_PATH_SEP)
+        {
+            return 3;
+        }
+    #endif
+
+    return (pBuf->length && pBuf->pData[0] == LIO_PATH_SEP) ? 1 : 0;
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Lifecycle
+-----------------------------------------------------------------------------*/
+void lio_pathbuf_init(LioPathBuf* const pBuf)
+{
+    pBuf->pData = pBuf->inlineData;
+    pBuf->length = 0;
+    pBuf->capacity = LIO_PATHBUF_CAPACITY;
+    pBuf->inlineData[0] = '\0';
+}
+
+
+
+void lio_pathbuf_terminate(LioPathBuf* const pBuf)
+{
+    if (pBuf && lio_pathbuf_is_spilled(pBuf))
+    {
+        lio_alloc_free(pBuf->pData);
+    }
+
+    if (pBuf)
+    {
+        lio_pathbuf_init(pBuf);
+    }
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Set a path
+-----------------------------------------------------------------------------*/
+bool lio_pathbuf_set(LioPathBuf* const pBuf, const char* const pPath)
+{
+    const size_t numChars = pPath ? strlen(pPath) : 0;
+
+    pBuf->length = 0;
+    pBuf->pData[0] = '\0';
+
+    if (!_lio_pathbuf_reserve(pBuf, numChars))
+    {
+        return false;
+    }
+
+    memcpy(pBuf->pData, pPath, numChars);
+    pBuf->length = numChars;
+    pBuf->pData[numChars] = '\0';
+
+    return true;
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Append path components
+-----------------------------------------------------------------------------*/
+bool lio_pathbuf_push(LioPathBuf* const pBuf, const char* pComponent)
+{
+    if (!pComponent)
+    {
+        return false;
+    }
+
+    const bool needSep = pBuf->length && pBuf->pData[pBuf->length-1] != LIO_PATH_SEP;
+
+    // Avoid doubled separators between components
+    while (pBuf->length && *pComponent == LIO_PATH_SEP)
+    {
+        ++pComponent;
+    }
+
+    const size_t numChars = strlen(pComponent);
+    if (!numChars)
+    {
+        return true;
+    }
+
+    if (!_lio_pathbuf_reserve(pBuf, pBuf->length + numChars + (needSep ? 1 : 0)))
+    {
+        return false;
+    }
+
+    if (needSep)
+    {
+        pBuf->pData[pBuf->length++] = LIO_PATH_SEP;
+    }
+
+    memcpy(pBuf->pData + pBuf->length, pComponent, numChars+1);
+    pBuf->length += numChars;
+
+    return true;
+}
+
+
+
+bool lio_pathbuf_join(LioPathBuf* const pBuf, const char* const pComponent, ...)
+{
+    va_list args;
+    bool ret = true;
+
+    va_start(args, pComponent);
+
+    for (const char* pNext = pComponent; ret && pNext; pNext = va_arg(args, const char*))
+    {
+        ret = lio_pathbuf_push(pBuf, pNext);
+    }
+
+    va_end(args);
+
+    return ret;
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Remove the last path component
+-----------------------------------------------------------------------------*/
+bool lio_pathbuf_pop(LioPathBuf* const pBuf)
+{
+    const size_t rootLength = _lio_pathbuf_root_length(pBuf);
+    size_t length = pBuf->length;
+
+    // Trailing separators do not begin a new component
+    while (length > rootLength && pBuf->pData[length-1] == LIO_PATH_SEP)
+    {
+        --length;
+    }
+
+    if (length <= rootLength)
+    {
+        return false;
+    }
+
+    while (length > rootLength && pBuf->pData[length-1] != LIO_PATH_SEP)
+    {
+        --length;
+    }
+
+    while (length > rootLength && pBuf->pData[length-1] == LIO_PATH_SEP)
+    {
+        --length;
+    }
+
+    pBuf->length = length;
+    pBuf->pData[length] = '\0';
+
+    return true;
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Replace the last path component
+-----------------------------------------------------------------------------*/
+bool lio_pathbuf_set_basename(LioPathBuf* const pBuf, const char* const pName)
+{
+    if (!lio_pathbuf_pop(pBuf) && !_lio_pathbuf_root_length(pBuf))
+    {
+        pBuf->length = 0;
+        pBuf->pData[0] = '\0';
+    }
+
+    return lio_pathbuf_push(pBuf, pName);
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Retrieve the last path component
+-----------------------------------------------------------------------------*/
+const char* lio_pathbuf_basename(const LioPathBuf* const pBuf)
+{
+    return lio_pathview_basename(lio_pathview_make_n(pBuf->pData, pBuf->length)).pData;
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Copy a path buffer to the heap
+-----------------------------------------------------------------------------*/
+char* lio_pathbuf_copy(const LioPathBuf* const pBuf)
+{
+    char* const pPath = (char*)lio_alloc_malloc(pBuf->length+1);
+
+    if (pPath)
+    {
+        memcpy(pPath, pBuf->pData, pBuf->length+1);
+    }
+
+    return pPath;
+}
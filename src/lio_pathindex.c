@@ -0,0 +1,1114 @@
+
+#include <stdio.h>
+#include <string.h> // memset(), memcpy(), strlen()
+
+#include "light_io/lio_alloc.h"
+#include "light_io/lio_binio.h"
+#include "light_io/lio_error.h"
+#include "light_io/lio_files.h"
+#include "light_io/lio_paths.h"
+#include "light_io/lio_strbuf.h"
+#include "light_io/lio_pathindex.h"
+
+
+
+/*-----------------------------------------------------------------------------
+ * Internal Structures
+ *
+ * Paths are reduced to a 64-bit hash of their canonical form, in which runs
+ * of separators become one and trailing separators are dropped. Hashes of 0
+ * and 1 mark empty and deleted slots in the hash tables, so real hashes are
+ * moved above them before they are used anywhere, including the filter.
+ *
+ * The filter is split into 512-bit blocks, which is one cache line on most
+ * machines. The upper half of a hash selects a block and the lower bits pick
+ * LIO_PATHINDEX_NUM_PROBES bits within it.
+-----------------------------------------------------------------------------*/
+#define LIO_PATHINDEX_EMPTY_KEY 0u
+#define LIO_PATHINDEX_DELETED_KEY 1u
+#define LIO_PATHINDEX_MAGIC 0x49494F4Cu // "LIOI"
+#define LIO_PATHINDEX_VERSION 1u
+
+#if defined(_WIN32) || defined(__APPLE__)
+    #define LIO_PATHINDEX_FOLD_CASE 1
+#else
+    #define LIO_PATHINDEX_FOLD_CASE 0
+#endif
+
+enum LioPathIndexInternalLimits
+{
+    LIO_PATHINDEX_BLOCK_WORDS = 8,
+    LIO_PATHINDEX_BLOCK_BITS = LIO_PATHINDEX_BLOCK_WORDS * 64,
+    LIO_PATHINDEX_NUM_PROBES = 6,
+    LIO_PATHINDEX_MIN_SLOTS = 64
+};
+
+
+
+/*-----------------------------------------------------------------------------
+ * Hashing
+-----------------------------------------------------------------------------*/
+static inline bool _lio_pathindex_is_sep(const char c)
+{
+    #ifdef _WIN32
+        return c == '\\' || c == '/';
+    #else
+        return c == LIO_PATH_SEP;
+    #endif
+}
+
+
+
+static inline char _lio_pathindex_fold(const char c)
+{
+    #if LIO_PATHINDEX_FOLD_CASE
+        return (c >= 'A' && c <= 'Z') ? (char)(c - 'A' + 'a') : c;
+    #else
+        return c;
+    #endif
+}
+
+
+
+static inline uint64_t _lio_pathindex_hash_char(const uint64_t hash, const char c)
+{
+    return (hash ^ (uint64_t)(unsigned char)c) * 0x100000001B3ull;
+}
+
+
+
+static inline uint64_t _lio_pathindex_finish(uint64_t hash)
+{
+    hash ^= hash >> 33;
+    hash *= 0xFF51AFD7ED558CCDull;
+    hash ^= hash >> 33;
+    hash *= 0xC4CEB9FE1A85EC53ull;
+    hash ^= hash >> 33;
+
+    return (hash <= LIO_PATHINDEX_DELETED_KEY) ? (hash + 2u) : hash;
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Hash Tables
+-----------------------------------------------------------------------------*/
+static size_t _lio_pathindex_table_find(const LioPathIndexTable* const pTable, const uint64_t key)
+{
+    const size_t mask = pTable->capacity - 1;
+    size_t slot = (size_t)key & mask;
+
+    while (pTable->pKeys[slot] != LIO_PATHINDEX_EMPTY_KEY)
+    {
+        if (pTable->pKeys[slot] == key)
+        {
+            return slot;
+        }
+        slot = (slot + 1) & mask;
+    }
+
+    return pTable->capacity;
+}
+
+
+
+static inline bool _lio_pathindex_table_contains(const LioPathIndexTable* const pTable, const uint64_t key)
+{
+    return pTable->capacity && _lio_pathindex_table_find(pTable, key) != pTable->capacity;
+}
+
+
+
+static bool _lio_pathindex_table_rehash(LioPathIndexTable* const pTable, const size_t capacity, const bool hasValues)
+{
+    uint64_t* const pKeys = (uint64_t*)lio_alloc_calloc(capacity, sizeof(uint64_t));
+    uint32_t* const pValues = hasValues ? (uint32_t*)lio_alloc_calloc(capacity, sizeof(uint32_t)) : NULL;
+    size_t numUsed = 0;
+
+    if (!pKeys || (hasValues && !pValues))
+    {
+        lio_alloc_free(pKeys);
+        lio_alloc_free(pValues);
+        return false;
+    }
+
+    for (size_t i = 0; i < pTable->capacity; ++i)
+    {
+        const uint64_t key = pTable->pKeys[i];
+        size_t slot;
+
+        if (key <= LIO_PATHINDEX_DELETED_KEY)
+        {
+            continue;
+        }
+
+        for (slot = (size_t)key & (capacity - 1); pKeys[slot] != LIO_PATHINDEX_EMPTY_KEY; slot = (slot + 1) & (capacity - 1))
+        {
+        }
+
+        pKeys[slot] = key;
+        if (hasValues)
+        {
+            pValues[slot] = pTable->pValues[i];
+        }
+        ++numUsed;
+    }
+
+    lio_alloc_free(pTable->pKeys);
+    lio_alloc_free(pTable->pValues);
+    pTable->pKeys = pKeys;
+    pTable->pValues = pValues;
+    pTable->capacity = capacity;
+    pTable->numUsed = numUsed;
+
+    return true;
+}
+
+
+
+/*-------------------------------------
+ * Insert a key, returning its slot. "*pOutIsNew" is set if the key was not
+ * already present. Returns the table's capacity on failure.
+-------------------------------------*/
+static size_t _lio_pathindex_table_insert(LioPathIndexTable* const pTable, const uint64_t key, const bool hasValues, bool* const pOutIsNew)
+{
+    size_t mask;
+    size_t slot;
+    size_t deleted;
+
+    if ((pTable->numUsed + 1) * 2 > pTable->capacity)
+    {
+        size_t capacity = pTable->capacity ? pTable->capacity : (size_t)LIO_PATHINDEX_MIN_SLOTS;
+        while ((pTable->numUsed + 1) * 2 > capacity)
+        {
+            capacity *= 2;
+        }
+
+        if (!_lio_pathindex_table_rehash(pTable, capacity, hasValues))
+        {
+            return pTable->capacity;
+        }
+    }
+
+    mask = pTable->capacity - 1;
+    deleted = pTable->capacity;
+
+    for (slot = (size_t)key & mask; pTable->pKeys[slot] != LIO_PATHINDEX_EMPTY_KEY; slot = (slot + 1) & mask)
+    {
+        if (pTable->pKeys[slot] == key)
+        {
+            *pOutIsNew = false;
+            return slot;
+        }
+
+        if (pTable->pKeys[slot] == LIO_PATHINDEX_DELETED_KEY && deleted == pTable->capacity)
+        {
+            deleted = slot;
+        }
+    }
+
+    if (deleted != pTable->capacity)
+    {
+        slot = deleted;
+    }
+    else
+    {
+        ++pTable->numUsed;
+    }
+
+    pTable->pKeys[slot] = key;
+    *pOutIsNew = true;
+    return slot;
+}
+
+
+
+static void _lio_pathindex_table_terminate(LioPathIndexTable* const pTable)
+{
+    lio_alloc_free(pTable->pKeys);
+    lio_alloc_free(pTable->pValues);
+    memset(pTable, 0, sizeof(LioPathIndexTable));
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Blocked Bloom Filter
+-----------------------------------------------------------------------------*/
+static inline size_t _lio_pathindex_num_blocks(const size_t expectedPaths)
+{
+    const size_t numBits = expectedPaths * LIO_PATHINDEX_BITS_PER_PATH;
+    return (numBits + LIO_PATHINDEX_BLOCK_BITS - 1) / LIO_PATHINDEX_BLOCK_BITS;
+}
+
+
+
+static inline uint64_t* _lio_pathindex_block(uint64_t* const pBlocks, const size_t numBlocks, const uint64_t key)
+{
+    const size_t block = (size_t)(((key >> 32) * (uint64_t)numBlocks) >> 32);
+    return pBlocks + block * LIO_PATHINDEX_BLOCK_WORDS;
+}
+
+
+
+static inline void _lio_pathindex_filter_add(uint64_t* const pBlocks, const size_t numBlocks, const uint64_t key)
+{
+    uint64_t* const pBlock = _lio_pathindex_block(pBlocks, numBlocks, key);
+    uint64_t bits = (key * 0x9E3779B97F4A7C15ull) >> 10;
+
+    for (unsigned i = 0; i < LIO_PATHINDEX_NUM_PROBES; ++i, bits >>= 9)
+    {
+        const unsigned bit = (unsigned)bits & (LIO_PATHINDEX_BLOCK_BITS - 1);
+        pBlock[bit >> 6] |= 1ull << (bit & 63u);
+    }
+}
+
+
+
+static inline bool _lio_pathindex_filter_test(const uint64_t* const pBlocks, const size_t numBlocks, const uint64_t key)
+{
+    const uint64_t* const pBlock = _lio_pathindex_block((uint64_t*)pBlocks, numBlocks, key);
+    uint64_t bits = (key * 0x9E3779B97F4A7C15ull) >> 10;
+    uint64_t missing = 0;
+
+    for (unsigned i = 0; i < LIO_PATHINDEX_NUM_PROBES; ++i, bits >>= 9)
+    {
+        const unsigned bit = (unsigned)bits & (LIO_PATHINDEX_BLOCK_BITS - 1);
+        missing |= ~pBlock[bit >> 6] & (1ull << (bit & 63u));
+    }
+
+    return missing == 0;
+}
+
+
+
+/*-------------------------------------
+ * Size the filter for a number of paths and refill it from the exact table.
+-------------------------------------*/
+static bool _lio_pathindex_resize_filter(LioPathIndex* const pIndex, size_t expectedPaths)
+{
+    size_t numBlocks;
+    uint64_t* pBlocks;
+
+    if (expectedPaths < LIO_PATHINDEX_MIN_PATHS)
+    {
+        expectedPaths = LIO_PATHINDEX_MIN_PATHS;
+    }
+
+    numBlocks = _lio_pathindex_num_blocks(expectedPaths);
+    pBlocks = (uint64_t*)lio_alloc_calloc(numBlocks * LIO_PATHINDEX_BLOCK_WORDS, sizeof(uint64_t));
+    if (!pBlocks)
+    {
+        return false;
+    }
+
+    for (size_t i = 0; i < pIndex->exact.capacity; ++i)
+    {
+        if (pIndex->exact.pKeys[i] > LIO_PATHINDEX_DELETED_KEY)
+        {
+            _lio_pathindex_filter_add(pBlocks, numBlocks, pIndex->exact.pKeys[i]);
+        }
+    }
+
+    lio_alloc_free(pIndex->pBlocks);
+    pIndex->pBlocks = pBlocks;
+    pIndex->numBlocks = numBlocks;
+    pIndex->expectedPaths = expectedPaths;
+
+    return true;
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Path Canonicalization
+-----------------------------------------------------------------------------*/
+static bool _lio_pathindex_canonicalize(LioStrBuf* const pOut, const char* const pPath)
+{
+    const char* pIter = pPath;
+    bool needSep = false;
+
+    lio_strbuf_truncate(pOut, 0);
+
+    if (_lio_pathindex_is_sep(*pIter))
+    {
+        if (!lio_strbuf_append_char(pOut, LIO_PATH_SEP))
+        {
+            return false;
+        }
+
+        while (_lio_pathindex_is_sep(*pIter))
+        {
+            ++pIter;
+        }
+    }
+
+    while (*pIter)
+    {
+        const char* pEnd = pIter;
+        while (*pEnd && !_lio_pathindex_is_sep(*pEnd))
+        {
+            ++pEnd;
+        }
+
+        if (pIter[0] == '.' && (pEnd - pIter == 1 || (pEnd - pIter == 2 && pIter[1] == '.')))
+        {
+            return false;
+        }
+
+        if ((needSep && !lio_strbuf_append_char(pOut, LIO_PATH_SEP)) || !lio_strbuf_append_n(pOut, pIter, (size_t)(pEnd - pIter)))
+        {
+            return false;
+        }
+
+        needSep = true;
+        for (pIter = pEnd; _lio_pathindex_is_sep(*pIter); ++pIter)
+        {
+        }
+    }
+
+    return pOut->length > 0;
+}
+
+
+
+/*-------------------------------------
+ * Hash the canonical form of a path while checking that it lies within the
+ * index's root, which is stored in canonical form. If "checkOpaque" is set,
+ * each folder between the root and the path is checked against the opaque
+ * table.
+-------------------------------------*/
+static enum LioPathIndexResult _lio_pathindex_hash_path(
+    const LioPathIndex* const pIndex,
+    const char* const pPath,
+    const bool checkOpaque,
+    uint64_t* const pOutKey)
+{
+    const char* const pRoot = lio_strbuf_cstr(&pIndex->root);
+    const size_t rootLength = pIndex->root.length;
+    const bool hasOpaque = checkOpaque && pIndex->opaque.numUsed > 0;
+    uint64_t hash = 0xCBF29CE484222325ull;
+    size_t matched = 0;
+    bool pastRoot = false;
+    bool needSep = false;
+    const char* pIter = pPath;
+
+    if (!pPath || !rootLength)
+    {
+        return LIO_PATHINDEX_UNKNOWN;
+    }
+
+    if (_lio_pathindex_is_sep(*pIter))
+    {
+        if (!_lio_pathindex_is_sep(pRoot[0]))
+        {
+            return LIO_PATHINDEX_UNKNOWN;
+        }
+
+        hash = _lio_pathindex_hash_char(hash, LIO_PATH_SEP);
+        matched = 1;
+        pastRoot = rootLength == 1; // The root is the top of the file system
+
+        while (_lio_pathindex_is_sep(*pIter))
+        {
+            ++pIter;
+        }
+    }
+
+    while (*pIter)
+    {
+        const char* pEnd = pIter;
+        while (*pEnd && !_lio_pathindex_is_sep(*pEnd))
+        {
+            ++pEnd;
+        }
+
+        if (pIter[0] == '.' && (pEnd - pIter == 1 || (pEnd - pIter == 2 && pIter[1] == '.')))
+        {
+            return LIO_PATHINDEX_UNKNOWN;
+        }
+
+        if (needSep)
+        {
+            if (matched < rootLength)
+            {
+                if (!_lio_pathindex_is_sep(pRoot[matched]))
+                {
+                    return LIO_PATHINDEX_UNKNOWN;
+                }
+                ++matched;
+            }
+            else
+            {
+                // Everything from here on is beneath the folder hashed so far
+                if (hasOpaque && _lio_pathindex_table_contains(&pIndex->opaque, _lio_pathindex_finish(hash)))
+                {
+                    return LIO_PATHINDEX_UNKNOWN;
+                }
+                pastRoot = true;
+            }
+
+            hash = _lio_pathindex_hash_char(hash, LIO_PATH_SEP);
+        }
+
+        for (; pIter != pEnd; ++pIter)
+        {
+            const char c = _lio_pathindex_fold(*pIter);
+
+            if (matched < rootLength)
+            {
+                if (c != _lio_pathindex_fold(pRoot[matched]))
+                {
+                    return LIO_PATHINDEX_UNKNOWN;
+                }
+                ++matched;
+            }
+            else if (!pastRoot)
+            {
+                return LIO_PATHINDEX_UNKNOWN;
+            }
+
+            hash = _lio_pathindex_hash_char(hash, c);
+        }
+
+        needSep = true;
+        while (_lio_pathindex_is_sep(*pIter))
+        {
+            ++pIter;
+        }
+    }
+
+    if (matched < rootLength)
+    {
+        return LIO_PATHINDEX_UNKNOWN;
+    }
+
+    *pOutKey = _lio_pathindex_finish(hash);
+    return LIO_PATHINDEX_MAYBE;
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Construction
+-----------------------------------------------------------------------------*/
+/*-------------------------------------
+ * Initialize
+-------------------------------------*/
+bool lio_pathindex_init(
+    LioPathIndex* const pIndex,
+    const char* const rootDir,
+    const size_t expectedPaths,
+    const unsigned flags)
+{
+    memset(pIndex, 0, sizeof(LioPathIndex));
+    pIndex->flags = flags;
+    lio_strbuf_init(&pIndex->folderPaths);
+    lio_strbuf_init(&pIndex->root);
+
+    if (!rootDir || !_lio_pathindex_canonicalize(&pIndex->root, rootDir))
+    {
+        if (!rootDir)
+        {
+            lio_error_report(LIO_ERROR_INVALID_ARGUMENT, 0, "Unable to index a folder without a path", NULL, NULL);
+        }
+        lio_pathindex_terminate(pIndex);
+        return false;
+    }
+
+    if (!_lio_pathindex_resize_filter(pIndex, expectedPaths))
+    {
+        lio_error_report(LIO_ERROR_OUT_OF_MEMORY, 0, "Unable to allocate a path index filter", rootDir, NULL);
+        lio_pathindex_terminate(pIndex);
+        return false;
+    }
+
+    return true;
+}
+
+
+
+/*-------------------------------------
+ * Terminate
+-------------------------------------*/
+void lio_pathindex_terminate(LioPathIndex* const pIndex)
+{
+    lio_alloc_free(pIndex->pBlocks);
+    _lio_pathindex_table_terminate(&pIndex->exact);
+    _lio_pathindex_table_terminate(&pIndex->opaque);
+    _lio_pathindex_table_terminate(&pIndex->folderTable);
+    lio_alloc_free(pIndex->pFolders);
+    lio_strbuf_terminate(&pIndex->folderPaths);
+    lio_strbuf_terminate(&pIndex->root);
+
+    pIndex->pBlocks = NULL;
+    pIndex->numBlocks = 0;
+    pIndex->numPaths = 0;
+    pIndex->expectedPaths = 0;
+    pIndex->pFolders = NULL;
+    pIndex->numFolders = 0;
+    pIndex->folderCapacity = 0;
+}
+
+
+
+/*-------------------------------------
+ * Build from the file system
+-------------------------------------*/
+bool lio_pathindex_build(
+    LioPathIndex* const pIndex,
+    const char* const rootDir,
+    const unsigned flags)
+{
+    char* const pRoot = lio_path_resolve(rootDir);
+    bool ret;
+
+    if (!pRoot)
+    {
+        return false;
+    }
+
+    // Hashes are kept while scanning so the filter can be sized afterwards
+    ret = lio_pathindex_init(pIndex, pRoot, 0, flags | LIO_PATHINDEX_EXACT);
+    if (ret)
+    {
+        ret = lio_pathindex_add(pIndex, pRoot)
+            && lio_pathindex_scan(pIndex, pRoot)
+            && _lio_pathindex_resize_filter(pIndex, pIndex->numPaths);
+
+        if (ret && !(flags & LIO_PATHINDEX_EXACT))
+        {
+            _lio_pathindex_table_terminate(&pIndex->exact);
+            pIndex->flags = flags;
+        }
+
+        if (!ret)
+        {
+            lio_pathindex_terminate(pIndex);
+        }
+    }
+
+    lio_path_destroy(pRoot);
+    return ret;
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Updates
+-----------------------------------------------------------------------------*/
+/*-------------------------------------
+ * Add a path
+-------------------------------------*/
+bool lio_pathindex_add(LioPathIndex* const pIndex, const char* const pPath)
+{
+    uint64_t key;
+    bool isNew = true;
+
+    if (_lio_pathindex_hash_path(pIndex, pPath, false, &key) != LIO_PATHINDEX_MAYBE)
+    {
+        return false;
+    }
+
+    if (pIndex->flags & LIO_PATHINDEX_EXACT)
+    {
+        if (_lio_pathindex_table_insert(&pIndex->exact, key, false, &isNew) == pIndex->exact.capacity)
+        {
+            return false;
+        }
+
+        // The exact table allows the filter to be rebuilt once it fills up
+        if (isNew && pIndex->numPaths + 1 > pIndex->expectedPaths && !_lio_pathindex_resize_filter(pIndex, pIndex->expectedPaths * 2))
+        {
+            return false;
+        }
+    }
+
+    if (isNew)
+    {
+        _lio_pathindex_filter_add(pIndex->pBlocks, pIndex->numBlocks, key);
+        ++pIndex->numPaths;
+    }
+
+    return true;
+}
+
+
+
+/*-------------------------------------
+ * Remove a path
+-------------------------------------*/
+bool lio_pathindex_remove(LioPathIndex* const pIndex, const char* const pPath)
+{
+    uint64_t key;
+    size_t slot;
+
+    if (!(pIndex->flags & LIO_PATHINDEX_EXACT) || !pIndex->exact.capacity)
+    {
+        return false;
+    }
+
+    if (_lio_pathindex_hash_path(pIndex, pPath, false, &key) != LIO_PATHINDEX_MAYBE)
+    {
+        return false;
+    }
+
+    slot = _lio_pathindex_table_find(&pIndex->exact, key);
+    if (slot == pIndex->exact.capacity)
+    {
+        return false;
+    }
+
+    pIndex->exact.pKeys[slot] = LIO_PATHINDEX_DELETED_KEY;
+    --pIndex->numPaths;
+
+    return true;
+}
+
+
+
+/*-------------------------------------
+ * Mark a folder as not indexed
+-------------------------------------*/
+bool lio_pathindex_add_opaque(LioPathIndex* const pIndex, const char* const pPath)
+{
+    uint64_t key;
+    bool isNew;
+
+    if (_lio_pathindex_hash_path(pIndex, pPath, false, &key) != LIO_PATHINDEX_MAYBE)
+    {
+        return false;
+    }
+
+    return _lio_pathindex_table_insert(&pIndex->opaque, key, false, &isNew) != pIndex->opaque.capacity;
+}
+
+
+
+/*-------------------------------------
+ * Find or append the record for a folder's hash. New records are left for the
+ * caller to fill in.
+-------------------------------------*/
+static LioPathIndexFolder* _lio_pathindex_folder_record(LioPathIndex* const pIndex, const uint64_t key, bool* const pOutIsNew)
+{
+    const size_t slot = _lio_pathindex_table_insert(&pIndex->folderTable, key, true, pOutIsNew);
+
+    if (slot == pIndex->folderTable.capacity)
+    {
+        return NULL;
+    }
+
+    if (!*pOutIsNew)
+    {
+        return pIndex->pFolders + pIndex->folderTable.pValues[slot];
+    }
+
+    if (pIndex->numFolders == pIndex->folderCapacity)
+    {
+        const size_t capacity = pIndex->folderCapacity ? pIndex->folderCapacity * 2 : 64;
+        LioPathIndexFolder* const pFolders = (LioPathIndexFolder*)lio_alloc_realloc(
+            pIndex->pFolders,
+            pIndex->folderCapacity * sizeof(LioPathIndexFolder),
+            capacity * sizeof(LioPathIndexFolder));
+
+        if (!pFolders)
+        {
+            pIndex->folderTable.pKeys[slot] = LIO_PATHINDEX_DELETED_KEY;
+            return NULL;
+        }
+
+        pIndex->pFolders = pFolders;
+        pIndex->folderCapacity = capacity;
+    }
+
+    pIndex->folderTable.pValues[slot] = (uint32_t)pIndex->numFolders;
+    return pIndex->pFolders + pIndex->numFolders++;
+}
+
+
+
+/*-------------------------------------
+ * Record a scanned folder
+-------------------------------------*/
+bool lio_pathindex_set_folder(
+    LioPathIndex* const pIndex,
+    const char* const pPath,
+    const int64_t modifiedTime,
+    const int64_t scannedTime)
+{
+    uint64_t key;
+    bool isNew;
+    LioPathIndexFolder* pFolder;
+
+    if (_lio_pathindex_hash_path(pIndex, pPath, false, &key) != LIO_PATHINDEX_MAYBE)
+    {
+        return false;
+    }
+
+    pFolder = _lio_pathindex_folder_record(pIndex, key, &isNew);
+    if (!pFolder)
+    {
+        return false;
+    }
+
+    if (isNew)
+    {
+        pFolder->pathOffset = pIndex->folderPaths.length;
+
+        if (!lio_strbuf_append(&pIndex->folderPaths, pPath) || !lio_strbuf_append_char(&pIndex->folderPaths, '\0'))
+        {
+            lio_strbuf_truncate(&pIndex->folderPaths, pFolder->pathOffset);
+            pIndex->folderTable.pKeys[_lio_pathindex_table_find(&pIndex->folderTable, key)] = LIO_PATHINDEX_DELETED_KEY;
+            --pIndex->numFolders;
+            return false;
+        }
+    }
+
+    pFolder->modifiedTime = modifiedTime;
+    pFolder->scannedTime = scannedTime;
+
+    return true;
+}
+
+
+
+/*-------------------------------------
+ * Check for a scanned folder
+-------------------------------------*/
+bool lio_pathindex_has_folder(const LioPathIndex* const pIndex, const char* const pPath)
+{
+    uint64_t key;
+
+    return _lio_pathindex_hash_path(pIndex, pPath, false, &key) == LIO_PATHINDEX_MAYBE
+        && _lio_pathindex_table_contains(&pIndex->folderTable, key);
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Queries
+-----------------------------------------------------------------------------*/
+/*-------------------------------------
+ * Query without touching the file system
+-------------------------------------*/
+enum LioPathIndexResult lio_pathindex_query(const LioPathIndex* const pIndex, const char* const pPath)
+{
+    uint64_t key;
+
+    if (_lio_pathindex_hash_path(pIndex, pPath, true, &key) != LIO_PATHINDEX_MAYBE)
+    {
+        return LIO_PATHINDEX_UNKNOWN;
+    }
+
+    if (!_lio_pathindex_filter_test(pIndex->pBlocks, pIndex->numBlocks, key))
+    {
+        return LIO_PATHINDEX_ABSENT;
+    }
+
+    if (pIndex->exact.capacity && !_lio_pathindex_table_contains(&pIndex->exact, key))
+    {
+        return LIO_PATHINDEX_ABSENT;
+    }
+
+    return LIO_PATHINDEX_MAYBE;
+}
+
+
+
+/*-------------------------------------
+ * Existence check which skips known-absent paths
+-------------------------------------*/
+bool lio_pathindex_does_exist(
+    const LioPathIndex* const pIndex,
+    const char* const pPath,
+    const enum LioPathType pathType)
+{
+    if (lio_pathindex_query(pIndex, pPath) == LIO_PATHINDEX_ABSENT)
+    {
+        return false;
+    }
+
+    return lio_path_does_exist(pPath, pathType);
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Serialization
+ *
+ * All values are little-endian. The folder table is not stored since it can
+ * be rebuilt from the folder paths.
+-----------------------------------------------------------------------------*/
+static void _lio_pathindex_write_table(LioBinWriter* const pWriter, const LioPathIndexTable* const pTable)
+{
+    if (lio_binwriter_reserve(pWriter, 2 * sizeof(uint64_t)))
+    {
+        lio_binwriter_put_u64(pWriter, pTable->capacity);
+        lio_binwriter_put_u64(pWriter, pTable->numUsed);
+    }
+
+    if (pTable->capacity)
+    {
+        lio_binwriter_write_u64_array(pWriter, pTable->pKeys, pTable->capacity);
+    }
+}
+
+
+
+static bool _lio_pathindex_read_table(LioBinReader* const pReader, LioPathIndexTable* const pTable)
+{
+    uint64_t capacity;
+    uint64_t numUsed;
+
+    if (!lio_binreader_require(pReader, 2 * sizeof(uint64_t)))
+    {
+        return false;
+    }
+
+    capacity = lio_binreader_get_u64(pReader);
+    numUsed = lio_binreader_get_u64(pReader);
+
+    if (!capacity)
+    {
+        return numUsed == 0;
+    }
+
+    if ((capacity & (capacity - 1)) != 0 || capacity > SIZE_MAX / sizeof(uint64_t) || numUsed * 2 > capacity)
+    {
+        return false;
+    }
+
+    pTable->pKeys = (uint64_t*)lio_alloc_malloc((size_t)capacity * sizeof(uint64_t));
+    if (!pTable->pKeys)
+    {
+        return false;
+    }
+
+    pTable->capacity = (size_t)capacity;
+    pTable->numUsed = (size_t)numUsed;
+
+    if (!lio_binreader_read_u64_array(pReader, pTable->pKeys, pTable->capacity))
+    {
+        return false;
+    }
+
+    // Lookups stop at the first empty slot, so a table which disagrees with
+    // its header could have none and never finish.
+    size_t numFilled = 0;
+    for (size_t i = 0; i < pTable->capacity; ++i)
+    {
+        numFilled += pTable->pKeys[i] != LIO_PATHINDEX_EMPTY_KEY;
+    }
+
+    return numFilled == pTable->numUsed;
+}
+
+
+
+/*-------------------------------------
+ * Save
+-------------------------------------*/
+bool lio_pathindex_save(const LioPathIndex* const pIndex, const char* const filePath)
+{
+    LioFile file;
+    LioBinWriter writer;
+    bool ret;
+
+    if (!lio_file_open(&file, filePath, LIO_FILE_OPEN_WRITE | LIO_FILE_OPEN_CREATE | LIO_FILE_OPEN_TRUNCATE))
+    {
+        return false;
+    }
+
+    if (!lio_binwriter_init_file(&writer, &file, 0, LIO_BYTE_ORDER_LITTLE))
+    {
+        lio_file_close(&file);
+        return false;
+    }
+
+    if (lio_binwriter_reserve(&writer, 4 * sizeof(uint32_t) + 4 * sizeof(uint64_t)))
+    {
+        lio_binwriter_put_u32(&writer, LIO_PATHINDEX_MAGIC);
+        lio_binwriter_put_u32(&writer, LIO_PATHINDEX_VERSION);
+        lio_binwriter_put_u32(&writer, pIndex->flags);
+        lio_binwriter_put_u32(&writer, 0); // reserved
+        lio_binwriter_put_u64(&writer, pIndex->numPaths);
+        lio_binwriter_put_u64(&writer, pIndex->expectedPaths);
+        lio_binwriter_put_u64(&writer, pIndex->root.length);
+        lio_binwriter_put_u64(&writer, pIndex->folderPaths.length);
+    }
+
+    lio_binwriter_write_bytes(&writer, lio_strbuf_cstr(&pIndex->root), pIndex->root.length);
+    lio_binwriter_write_bytes(&writer, lio_strbuf_cstr(&pIndex->folderPaths), pIndex->folderPaths.length);
+    lio_binwriter_write_u64_array(&writer, pIndex->pBlocks, pIndex->numBlocks * LIO_PATHINDEX_BLOCK_WORDS);
+    _lio_pathindex_write_table(&writer, &pIndex->exact);
+    _lio_pathindex_write_table(&writer, &pIndex->opaque);
+
+    if (lio_binwriter_reserve(&writer, sizeof(uint64_t)))
+    {
+        lio_binwriter_put_u64(&writer, pIndex->numFolders);
+    }
+
+    for (size_t i = 0; i < pIndex->numFolders; ++i)
+    {
+        if (!lio_binwriter_reserve(&writer, 3 * sizeof(uint64_t)))
+        {
+            break;
+        }
+
+        lio_binwriter_put_s64(&writer, pIndex->pFolders[i].modifiedTime);
+        lio_binwriter_put_s64(&writer, pIndex->pFolders[i].scannedTime);
+        lio_binwriter_put_u64(&writer, pIndex->pFolders[i].pathOffset);
+    }
+
+    ret = lio_binwriter_terminate(&writer);
+    ret = lio_file_close(&file) && ret;
+
+    return ret;
+}
+
+
+
+/*-------------------------------------
+ * Load
+-------------------------------------*/
+static bool _lio_pathindex_read(LioPathIndex* const pIndex, LioBinReader* const pReader)
+{
+    unsigned flags;
+    uint64_t numPaths;
+    uint64_t expectedPaths;
+    uint64_t rootLength;
+    uint64_t folderPathsLength;
+    uint64_t numFolders;
+    char* pRoot;
+    bool ret;
+
+    if (!lio_binreader_require(pReader, 4 * sizeof(uint32_t) + 4 * sizeof(uint64_t))
+        || lio_binreader_get_u32(pReader) != LIO_PATHINDEX_MAGIC
+        || lio_binreader_get_u32(pReader) != LIO_PATHINDEX_VERSION)
+    {
+        return false;
+    }
+
+    flags = lio_binreader_get_u32(pReader);
+    (void)lio_binreader_get_u32(pReader);
+    numPaths = lio_binreader_get_u64(pReader);
+    expectedPaths = lio_binreader_get_u64(pReader);
+    rootLength = lio_binreader_get_u64(pReader);
+    folderPathsLength = lio_binreader_get_u64(pReader);
+
+    if (!rootLength || rootLength > SIZE_MAX - 1 || expectedPaths > SIZE_MAX / LIO_PATHINDEX_BITS_PER_PATH)
+    {
+        return false;
+    }
+
+    pRoot = (char*)lio_alloc_malloc((size_t)rootLength + 1);
+    if (!pRoot)
+    {
+        return false;
+    }
+
+    ret = lio_binreader_read_bytes(pReader, pRoot, (size_t)rootLength);
+    pRoot[rootLength] = '\0';
+    ret = ret && lio_pathindex_init(pIndex, pRoot, (size_t)expectedPaths, flags);
+    lio_alloc_free(pRoot);
+
+    if (!ret)
+    {
+        return false;
+    }
+
+    pIndex->numPaths = (size_t)numPaths;
+
+    if (!lio_strbuf_reserve(&pIndex->folderPaths, (size_t)folderPathsLength)
+        || !lio_binreader_read_bytes(pReader, pIndex->folderPaths.pData, (size_t)folderPathsLength))
+    {
+        return false;
+    }
+    pIndex->folderPaths.length = (size_t)folderPathsLength;
+    pIndex->folderPaths.pData[folderPathsLength] = '\0';
+
+    if (!lio_binreader_read_u64_array(pReader, pIndex->pBlocks, pIndex->numBlocks * LIO_PATHINDEX_BLOCK_WORDS)
+        || !_lio_pathindex_read_table(pReader, &pIndex->exact)
+        || !_lio_pathindex_read_table(pReader, &pIndex->opaque)
+        || !lio_binreader_require(pReader, sizeof(uint64_t)))
+    {
+        return false;
+    }
+
+    numFolders = lio_binreader_get_u64(pReader);
+    for (uint64_t i = 0; i < numFolders; ++i)
+    {
+        int64_t modifiedTime;
+        int64_t scannedTime;
+        uint64_t pathOffset;
+
+        if (!lio_binreader_require(pReader, 3 * sizeof(uint64_t)))
+        {
+            return false;
+        }
+
+        modifiedTime = lio_binreader_get_s64(pReader);
+        scannedTime = lio_binreader_get_s64(pReader);
+        pathOffset = lio_binreader_get_u64(pReader);
+
+        if (pathOffset >= folderPathsLength)
+        {
+            return false;
+        }
+
+        {
+            uint64_t key;
+            bool isNew;
+            LioPathIndexFolder* pFolder = NULL;
+
+            if (_lio_pathindex_hash_path(pIndex, pIndex->folderPaths.pData + pathOffset, false, &key) == LIO_PATHINDEX_MAYBE)
+            {
+                pFolder = _lio_pathindex_folder_record(pIndex, key, &isNew);
+            }
+
+            if (!pFolder || !isNew)
+            {
+                return false;
+            }
+
+            pFolder->modifiedTime = modifiedTime;
+            pFolder->scannedTime = scannedTime;
+            pFolder->pathOffset = (size_t)pathOffset;
+        }
+    }
+
+    return true;
+}
+
+
+
+bool lio_pathindex_load(LioPathIndex* const pIndex, const char* const filePath)
+{
+    LioFile file;
+    LioBinReader reader;
+    bool ret;
+
+    memset(pIndex, 0, sizeof(LioPathIndex));
+
+    if (!lio_file_open(&file, filePath, LIO_FILE_OPEN_READ))
+    {
+        return false;
+    }
+
+    ret = lio_binreader_init_file(&reader, &file, 0, LIO_BYTE_ORDER_LITTLE);
+    if (ret)
+    {
+        ret = _lio_pathindex_read(pIndex, &reader);
+        lio_binreader_terminate(&reader);
+    }
+
+    lio_file_close(&file);
+
+    if (!ret)
+    {
+        lio_error_report(LIO_ERROR_CORRUPT, 0, "Unable to load a path index", filePath, NULL);
+        lio_pathindex_terminate(pIndex);
+    }
+
+    return ret;
+}
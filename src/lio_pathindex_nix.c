@@ -0,0 +1,227 @@
+
+// expose dirfd(), d_type, and st_mtim
+#ifndef _GNU_SOURCE
+    #define _GNU_SOURCE
+#endif
+
+#include <dirent.h> // DIR, opendir(), readdir(), dirfd(), closedir()
+#include <sys/stat.h> // fstat(), lstat(), stat()
+#include <time.h> // clock_gettime()
+
+#include <stdio.h>
+#include <string.h> // strcmp()
+
+#include "light_io/lio_error.h"
+#include "light_io/lio_paths.h"
+#include "light_io/lio_strbuf.h"
+#include "light_io/lio_pathindex.h"
+
+
+
+/*-----------------------------------------------------------------------------
+ * Timestamps
+-----------------------------------------------------------------------------*/
+static inline int64_t _lio_pathindex_mtime(const struct stat* const pStat)
+{
+    #ifdef __APPLE__
+        return (int64_t)pStat->st_mtimespec.tv_sec * 1000000000 + (int64_t)pStat->st_mtimespec.tv_nsec;
+    #else
+        return (int64_t)pStat->st_mtim.tv_sec * 1000000000 + (int64_t)pStat->st_mtim.tv_nsec;
+    #endif
+}
+
+
+
+static inline int64_t _lio_pathindex_now(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    return (int64_t)now.tv_sec * 1000000000 + (int64_t)now.tv_nsec;
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Scanning
+-----------------------------------------------------------------------------*/
+/*-------------------------------------
+ * Recursively add the contents of the folder in "pPath". The folder's
+ * modification time is read before its entries so a concurrent change is
+ * never missed, only picked up by the next refresh.
+-------------------------------------*/
+static bool _lio_pathindex_scan_folder(LioPathIndex* const pIndex, LioStrBuf* const pPath)
+{
+    const int64_t scannedTime = _lio_pathindex_now();
+    const size_t baseLength = pPath->length;
+    struct stat folderStat;
+    struct dirent* pEntry;
+    DIR* const pDir = opendir(pPath->pData);
+    bool ret = true;
+
+    if (!pDir)
+    {
+        // Nothing can be said about the contents of an unreadable folder
+        return lio_pathindex_add_opaque(pIndex, pPath->pData);
+    }
+
+    if (fstat(dirfd(pDir), &folderStat) != 0
+    || !lio_pathindex_set_folder(pIndex, pPath->pData, _lio_pathindex_mtime(&folderStat), scannedTime)
+    || ((!baseLength || pPath->pData[baseLength-1] != LIO_PATH_SEP) && !lio_strbuf_append_char(pPath, LIO_PATH_SEP)))
+    {
+        lio_error_report(LIO_ERROR_IO, 0, "Unable to index a folder", pPath->pData, NULL);
+        closedir(pDir);
+        return false;
+    }
+
+    const size_t entryOffset = pPath->length;
+
+    while (ret && (pEntry = readdir(pDir)) != NULL)
+    {
+        const char* const entry = pEntry->d_name;
+        unsigned char type = DT_UNKNOWN;
+        struct stat entryStat;
+
+        if (strcmp(entry, ".") == 0 || strcmp(entry, "..") == 0)
+        {
+            continue;
+        }
+
+        lio_strbuf_truncate(pPath, entryOffset);
+        if (!lio_strbuf_append(pPath, entry) || !lio_pathindex_add(pIndex, pPath->pData))
+        {
+            ret = false;
+            break;
+        }
+
+        #ifdef _DIRENT_HAVE_D_TYPE
+            type = pEntry->d_type;
+        #endif
+
+        if (type == DT_UNKNOWN && lstat(pPath->pData, &entryStat) == 0)
+        {
+            type = S_ISDIR(entryStat.st_mode) ? DT_DIR : (S_ISLNK(entryStat.st_mode) ? DT_LNK : DT_REG);
+        }
+
+        if (type == DT_DIR)
+        {
+            if (!lio_pathindex_has_folder(pIndex, pPath->pData))
+            {
+                ret = _lio_pathindex_scan_folder(pIndex, pPath);
+            }
+        }
+        else if (type == DT_LNK)
+        {
+            // Links are not followed, so anything beneath them is unknown
+            if (stat(pPath->pData, &entryStat) == 0 && S_ISDIR(entryStat.st_mode))
+            {
+                ret = lio_pathindex_add_opaque(pIndex, pPath->pData);
+            }
+        }
+    }
+
+    closedir(pDir);
+    lio_strbuf_truncate(pPath, baseLength);
+
+    return ret;
+}
+
+
+
+/*-------------------------------------
+ * Scan a folder
+-------------------------------------*/
+bool lio_pathindex_scan(LioPathIndex* const pIndex, const char* const pPath)
+{
+    LioStrBuf path;
+    bool ret;
+
+    lio_strbuf_init(&path);
+    ret = lio_strbuf_append(&path, pPath) && _lio_pathindex_scan_folder(pIndex, &path);
+    lio_strbuf_terminate(&path);
+
+    return ret;
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Staleness
+-----------------------------------------------------------------------------*/
+/*-------------------------------------
+ * Check if a folder record no longer matches the file system
+-------------------------------------*/
+static bool _lio_pathindex_folder_changed(const LioPathIndexFolder* const pFolder, const char* const pPath, int64_t* const pOutModifiedTime)
+{
+    struct stat folderStat;
+
+    if (stat(pPath, &folderStat) != 0 || !S_ISDIR(folderStat.st_mode))
+    {
+        *pOutModifiedTime = INT64_MIN;
+        return pFolder->modifiedTime != INT64_MIN;
+    }
+
+    *pOutModifiedTime = _lio_pathindex_mtime(&folderStat);
+
+    return *pOutModifiedTime != pFolder->modifiedTime
+        || pFolder->scannedTime - pFolder->modifiedTime < LIO_PATHINDEX_RACY_NSEC;
+}
+
+
+
+/*-------------------------------------
+ * Detect changes
+-------------------------------------*/
+bool lio_pathindex_is_stale(const LioPathIndex* const pIndex)
+{
+    for (size_t i = 0; i < pIndex->numFolders; ++i)
+    {
+        const LioPathIndexFolder* const pFolder = pIndex->pFolders + i;
+        int64_t modifiedTime;
+
+        if (_lio_pathindex_folder_changed(pFolder, pIndex->folderPaths.pData + pFolder->pathOffset, &modifiedTime))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+
+/*-------------------------------------
+ * Rescan changed folders
+-------------------------------------*/
+bool lio_pathindex_refresh(LioPathIndex* const pIndex)
+{
+    LioStrBuf path;
+    bool ret = true;
+
+    lio_strbuf_init(&path);
+
+    // Folders found while rescanning are appended and scanned immediately
+    for (size_t i = 0, numFolders = pIndex->numFolders; ret && i < numFolders; ++i)
+    {
+        int64_t modifiedTime;
+
+        lio_strbuf_truncate(&path, 0);
+        if (!lio_strbuf_append(&path, pIndex->folderPaths.pData + pIndex->pFolders[i].pathOffset))
+        {
+            ret = false;
+        }
+        else if (_lio_pathindex_folder_changed(pIndex->pFolders + i, path.pData, &modifiedTime))
+        {
+            if (modifiedTime == INT64_MIN)
+            {
+                pIndex->pFolders[i].modifiedTime = INT64_MIN;
+            }
+            else
+            {
+                ret = _lio_pathindex_scan_folder(pIndex, &path);
+            }
+        }
+    }
+
+    lio_strbuf_terminate(&path);
+    return ret;
+}
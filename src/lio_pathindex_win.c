@@ -0,0 +1,231 @@
+
+#ifndef WIN32_LEAN_AND_MEAN
+    #define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+
+#include <stdio.h>
+#include <string.h> // strcmp()
+
+#include "light_io/lio_error.h"
+#include "light_io/lio_paths.h"
+#include "light_io/lio_strbuf.h"
+#include "light_io/lio_pathindex.h"
+
+
+
+/*-----------------------------------------------------------------------------
+ * Timestamps
+-----------------------------------------------------------------------------*/
+static inline int64_t _lio_pathindex_filetime_to_ns(const FILETIME* const pTime)
+{
+    // FILETIME counts 100ns intervals since 1601-01-01
+    const int64_t ticks = (int64_t)(((uint64_t)pTime->dwHighDateTime << 32) | (uint64_t)pTime->dwLowDateTime);
+    return (ticks - 116444736000000000ll) * 100;
+}
+
+
+
+static inline int64_t _lio_pathindex_now(void)
+{
+    FILETIME now;
+    GetSystemTimeAsFileTime(&now);
+    return _lio_pathindex_filetime_to_ns(&now);
+}
+
+
+
+static bool _lio_pathindex_folder_mtime(const char* const pPath, int64_t* const pOutModifiedTime)
+{
+    WIN32_FILE_ATTRIBUTE_DATA data;
+
+    if (!GetFileAttributesExA(pPath, GetFileExInfoStandard, &data) || !(data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY))
+    {
+        return false;
+    }
+
+    *pOutModifiedTime = _lio_pathindex_filetime_to_ns(&data.ftLastWriteTime);
+    return true;
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Scanning
+-----------------------------------------------------------------------------*/
+/*-------------------------------------
+ * Recursively add the contents of the folder in "pPath". The folder's
+ * modification time is read before its entries so a concurrent change is
+ * never missed, only picked up by the next refresh.
+-------------------------------------*/
+static bool _lio_pathindex_scan_folder(LioPathIndex* const pIndex, LioStrBuf* const pPath)
+{
+    const int64_t scannedTime = _lio_pathindex_now();
+    const size_t baseLength = pPath->length;
+    int64_t modifiedTime;
+    WIN32_FIND_DATAA data;
+    HANDLE hFind;
+    bool ret = true;
+
+    if (!_lio_pathindex_folder_mtime(pPath->pData, &modifiedTime))
+    {
+        // Nothing can be said about the contents of an unreadable folder
+        return lio_pathindex_add_opaque(pIndex, pPath->pData);
+    }
+
+    if (!lio_pathindex_set_folder(pIndex, pPath->pData, modifiedTime, scannedTime)
+    || ((!baseLength || (pPath->pData[baseLength-1] != '\\' && pPath->pData[baseLength-1] != '/')) && !lio_strbuf_append_char(pPath, LIO_PATH_SEP)))
+    {
+        lio_error_report(LIO_ERROR_IO, 0, "Unable to index a folder", pPath->pData, NULL);
+        return false;
+    }
+
+    const size_t entryOffset = pPath->length;
+
+    // The search pattern and each entry share the same directory prefix
+    if (!lio_strbuf_append_char(pPath, '*'))
+    {
+        lio_strbuf_truncate(pPath, baseLength);
+        return false;
+    }
+
+    hFind = FindFirstFileA(pPath->pData, &data);
+    if (hFind == INVALID_HANDLE_VALUE)
+    {
+        lio_strbuf_truncate(pPath, baseLength);
+        return lio_pathindex_add_opaque(pIndex, pPath->pData);
+    }
+
+    do
+    {
+        if (strcmp(data.cFileName, ".") == 0 || strcmp(data.cFileName, "..") == 0)
+        {
+            continue;
+        }
+
+        lio_strbuf_truncate(pPath, entryOffset);
+        if (!lio_strbuf_append(pPath, data.cFileName) || !lio_pathindex_add(pIndex, pPath->pData))
+        {
+            ret = false;
+            break;
+        }
+
+        if (!(data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY))
+        {
+            continue;
+        }
+
+        // Junctions and symbolic links are not followed
+        if (data.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT)
+        {
+            ret = lio_pathindex_add_opaque(pIndex, pPath->pData);
+        }
+        else if (!lio_pathindex_has_folder(pIndex, pPath->pData))
+        {
+            ret = _lio_pathindex_scan_folder(pIndex, pPath);
+        }
+    }
+    while (ret && FindNextFileA(hFind, &data));
+
+    FindClose(hFind);
+    lio_strbuf_truncate(pPath, baseLength);
+
+    return ret;
+}
+
+
+
+/*-------------------------------------
+ * Scan a folder
+-------------------------------------*/
+bool lio_pathindex_scan(LioPathIndex* const pIndex, const char* const pPath)
+{
+    LioStrBuf path;
+    bool ret;
+
+    lio_strbuf_init(&path);
+    ret = lio_strbuf_append(&path, pPath) && _lio_pathindex_scan_folder(pIndex, &path);
+    lio_strbuf_terminate(&path);
+
+    return ret;
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Staleness
+-----------------------------------------------------------------------------*/
+/*-------------------------------------
+ * Check if a folder record no longer matches the file system
+-------------------------------------*/
+static bool _lio_pathindex_folder_changed(const LioPathIndexFolder* const pFolder, const char* const pPath, int64_t* const pOutModifiedTime)
+{
+    if (!_lio_pathindex_folder_mtime(pPath, pOutModifiedTime))
+    {
+        *pOutModifiedTime = INT64_MIN;
+        return pFolder->modifiedTime != INT64_MIN;
+    }
+
+    return *pOutModifiedTime != pFolder->modifiedTime
+        || pFolder->scannedTime - pFolder->modifiedTime < LIO_PATHINDEX_RACY_NSEC;
+}
+
+
+
+/*-------------------------------------
+ * Detect changes
+-------------------------------------*/
+bool lio_pathindex_is_stale(const LioPathIndex* const pIndex)
+{
+    for (size_t i = 0; i < pIndex->numFolders; ++i)
+    {
+        const LioPathIndexFolder* const pFolder = pIndex->pFolders + i;
+        int64_t modifiedTime;
+
+        if (_lio_pathindex_folder_changed(pFolder, pIndex->folderPaths.pData + pFolder->pathOffset, &modifiedTime))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+
+/*-------------------------------------
+ * Rescan changed folders
+-------------------------------------*/
+bool lio_pathindex_refresh(LioPathIndex* const pIndex)
+{
+    LioStrBuf path;
+    bool ret = true;
+
+    lio_strbuf_init(&path);
+
+    // Folders found while rescanning are appended and scanned immediately
+    for (size_t i = 0, numFolders = pIndex->numFolders; ret && i < numFolders; ++i)
+    {
+        int64_t modifiedTime;
+
+        lio_strbuf_truncate(&path, 0);
+        if (!lio_strbuf_append(&path, pIndex->folderPaths.pData + pIndex->pFolders[i].pathOffset))
+        {
+            ret = false;
+        }
+        else if (_lio_pathindex_folder_changed(pIndex->pFolders + i, path.pData, &modifiedTime))
+        {
+            if (modifiedTime == INT64_MIN)
+            {
+                pIndex->pFolders[i].modifiedTime = INT64_MIN;
+            }
+            else
+            {
+                ret = _lio_pathindex_scan_folder(pIndex, &path);
+            }
+        }
+    }
+
+    lio_strbuf_terminate(&path);
+    return ret;
+}
@@ -3,9 +3,13 @@
 #include <string.h> // strlen, memset()
 #include <stdlib.h> // size_t, realpath(...) (POSIX)
 
+#include "light_io/lio_alloc.h"
 #include "light_io/lio_config.h"
+#include "light_io/lio_error.h"
 #include "light_io/lio_utils.h"
+#include "light_io/lio_strbuf.h"
 #include "light_io/lio_paths.h"
+#include "light_io/lio_pathview.h"
 
 
 
@@ -47,45 +51,51 @@ void lio_paths_destroy(char** const restrict pPaths, unsigned numPaths)
 {
     while (numPaths --> 0)
     {
-        free(pPaths[numPaths]);
+        lio_alloc_free(pPaths[numPaths]);
     }
 
-    free(pPaths);
+    lio_alloc_free(pPaths);
 }
 
 
 
 /*-----------------------------------------------------------------------------
- * Basename
+ * Copy a path view into a new string
 -----------------------------------------------------------------------------*/
-char* lio_path_basename(const char* const restrict pPath)
+static char* _lio_path_copy_view(const LioPathView view)
 {
-    if (!pPath)
+    char* const ret = (char*) lio_alloc_malloc(view.length+1);
+    if (!ret)
     {
         return NULL;
     }
 
-    const size_t numChars = strlen(pPath);
-    size_t iter = numChars;
+    memcpy(ret, view.pData, view.length);
+    ret[view.length] = '\0';
+
+    return ret;
+}
 
-    while (iter --> 0)
-    {
-        const char c = pPath[iter];
 
-        if (c == LIO_PATH_SEP)
-        {
-            break;
-        }
+
+/*-----------------------------------------------------------------------------
+ * Basename
+-----------------------------------------------------------------------------*/
+char* lio_path_basename(const char* const restrict pPath)
+{
+    if (!pPath)
+    {
+        return NULL;
     }
 
-    ++iter;
+    const LioPathView base = lio_pathview_basename(lio_pathview_make(pPath));
 
-    if (iter == numChars)
+    if (!base.length)
     {
         return lio_utils_str_fmt("\0");
     }
 
-    return lio_utils_str_copy(pPath+iter, 0);
+    return _lio_path_copy_view(base);
 }
 
 
@@ -100,33 +110,14 @@ char* lio_path_dirname(const char* const restrict pPath)
         return NULL;
     }
 
-    const size_t numChars = strlen(pPath);
-    size_t iter = numChars;
+    const LioPathView path = lio_pathview_make(pPath);
 
-    while (iter --> 0)
-    {
-        const char c = pPath[iter];
-
-        if (c == LIO_PATH_SEP)
-        {
-            break;
-        }
-    }
-
-    if (iter == numChars)
+    if (lio_pathview_rfind_sep(path.pData, path.length) == path.length)
     {
         return lio_utils_str_fmt("\0");
     }
 
-    char* const ret = (char*) malloc(iter+1);
-    if (!ret)
-    {
-        return NULL;
-    }
-
-    ret[iter] = '\0';
-
-    return strncpy(ret, pPath, iter);
+    return _lio_path_copy_view(lio_pathview_dirname(path));
 }
 
 
@@ -149,12 +140,21 @@ char* lio_path_join(
         return lio_utils_str_copy("", 0);
     }
 
-    char* const pTemp = lio_utils_str_fmt("%s%c%s", pDirName, LIO_PATH_SEP, pBaseName);
-    if (!pTemp)
+    LioStrBuf temp;
+    lio_strbuf_init(&temp);
+
+    const size_t dirLength = strlen(pDirName);
+    const size_t baseLength = strlen(pBaseName);
+
+    if (!lio_strbuf_reserve(&temp, dirLength + 1 + baseLength)
+    || !lio_strbuf_append_n(&temp, pDirName, dirLength)
+    || !lio_strbuf_append_char(&temp, LIO_PATH_SEP)
+    || !lio_strbuf_append_n(&temp, pBaseName, baseLength))
     {
-        fprintf(stderr, "Unable to join the paths \"%s\" and \"%s\".\n", pDirName, pBaseName);
+        lio_error_report(LIO_ERROR_OUT_OF_MEMORY, 0, "Unable to join two paths", pDirName, pBaseName);
+        lio_strbuf_terminate(&temp);
         return NULL;
     }
 
-    return pTemp;
+    return lio_strbuf_detach(&temp);
 }
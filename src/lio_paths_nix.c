@@ -7,14 +7,22 @@
 #include <unistd.h> // rmdir(...)
 #include <dirent.h> // DIR, dirent(), readdir(), closedir()
 #include <sys/types.h> // mode_t
+#include <limits.h> // PATH_MAX
 
 #include <stdio.h>
 #include <string.h> // strlen
 #include <stdlib.h> // size_t, realpath(...) (POSIX)
 
+#include "light_io/lio_alloc.h"
 #include "light_io/lio_config.h"
+#include "light_io/lio_error.h"
 #include "light_io/lio_utils.h"
+#include "light_io/lio_strbuf.h"
+#include "light_io/lio_arena.h"
 #include "light_io/lio_paths.h"
+#include "light_io/lio_pathview.h"
+#include "light_io/lio_statcache.h"
+#include "light_io/lio_stats.h"
 
 
 /*-----------------------------------------------------------------------------
@@ -35,37 +43,49 @@
 /*-----------------------------------------------------------------------------
  * Check for a path on the filesystem
 -----------------------------------------------------------------------------*/
-bool lio_path_does_exist(
+static bool _lio_path_does_exist(
     const char *const restrict path,
     const enum LioPathType pathType)
 {
-    const size_t numChars = strlen(path);
-    
-    if (!path || !numChars)
+    if (!path || !path[0])
     {
-        fprintf(stderr, "Unable to locate a file at a non-existent directory.\n");
+        lio_error_report(LIO_ERROR_INVALID_ARGUMENT, 0, "Unable to locate a file at a non-existent directory", NULL, NULL);
         return false;
     }
     
-    struct STAT info;
-    const int result = LSTAT(path, &info);
+    LioStatCacheEntry cached;
+    uint64_t epoch;
+
+    if (!lio_statcache_lookup(path, &cached, &epoch))
+    {
+        struct STAT info;
+        const int result = LSTAT(path, &info);
+        LIO_STATS_ADD(LIO_STATS_SYSCALLS, 1);
+
+        cached.exists = result == 0;
+        cached.mode = cached.exists ? (uint32_t)info.st_mode : 0u;
+
+        // Missing paths are remembered too, but other errors may be transient
+        if (cached.exists || errno == ENOENT || errno == ENOTDIR)
+        {
+            lio_statcache_store(path, &cached, epoch);
+        }
+    }
 
-    // The path doesn't exist.
-    if (result != 0)
+    // The path doesn't exist. This is an answer rather than an error, so
+    // nothing is reported.
+    if (!cached.exists)
     {
-        //const int errVal = errno;
-        //const char* const errStr = strerror(errVal);
-        //fprintf(stderr, "Unable to read the file \"%s\": %s.\n", path, errStr);
         return false;
     }
     
-    if ((info.st_mode & S_IRUSR) == 0)
+    if ((cached.mode & S_IRUSR) == 0)
     {
-        fprintf(stderr, "Unable to read the file \"%s\". Permission Denied.\n", path);
+        lio_error_report(LIO_ERROR_PERMISSION_DENIED, 0, "Unable to read a file", path, NULL);
         return -1;
     }
     
-    const mode_t fileMode = info.st_mode;
+    const mode_t fileMode = (mode_t)cached.mode;
     
     switch (pathType)
     {
@@ -91,41 +111,50 @@ bool lio_path_does_exist(
 
 
 
+bool lio_path_does_exist(
+    const char *const restrict path,
+    const enum LioPathType pathType)
+{
+    LIO_STATS_BEGIN(timer, LIO_STATS_OP_PATH_EXISTS, path);
+    const bool ret = _lio_path_does_exist(path, pathType);
+    LIO_STATS_END_CALL(timer, NULL, pathType, 0, 0, ret);
+
+    return ret;
+}
+
+
+
 /*-----------------------------------------------------------------------------
  * Error handler for expanding a path
 -----------------------------------------------------------------------------*/
 static void _lio_path_expand_error(const char* const restrict path, const int errCode)
 {
-    const char* errStr = NULL;
-    
     switch (errCode)
     {
         case WRDE_BADCHAR:
-            errStr = "ERROR: Illegal character located in path expansion: \"%s\"\n";
+            lio_error_report(LIO_ERROR_INVALID_ARGUMENT, 0, "Illegal character located in path expansion", path, NULL);
             break;
     
         case WRDE_BADVAL:
-            errStr = "ERROR: Failed expansion of a shell variable in: \"%s\"\n";
+            lio_error_report(LIO_ERROR_INVALID_ARGUMENT, 0, "Failed expansion of a shell variable", path, NULL);
             break;
             
         case WRDE_CMDSUB:
-            errStr = "ERROR: Failed command substitution in path expansion: \"%s\"\n";
+            lio_error_report(LIO_ERROR_INVALID_ARGUMENT, 0, "Failed command substitution in path expansion", path, NULL);
             break;
             
         case WRDE_NOSPACE:
-            errStr = "ERROR: Ran out of memory while expanding path: \"%s\"\n";
+            lio_error_report(LIO_ERROR_OUT_OF_MEMORY, 0, "Ran out of memory while expanding a path", path, NULL);
             break;
             
         case WRDE_SYNTAX:
-            errStr = "ERROR: Bad syntax encountered while expanding path: \"%s\"\n";
+            lio_error_report(LIO_ERROR_INVALID_ARGUMENT, 0, "Bad syntax encountered while expanding a path", path, NULL);
             break;
             
         default:
-            errStr = "ERROR: Unknown error occurred while expanding the path: \"%s\"\n";
+            lio_error_report(LIO_ERROR_IO, 0, "Unknown error occurred while expanding a path", path, NULL);
             break;
     }
-    
-    fprintf(stderr, errStr, path);
 }
 
 
@@ -133,7 +162,7 @@ static void _lio_path_expand_error(const char* const restrict path, const int er
 /*-----------------------------------------------------------------------------
  * Function to expand paths (symlinks, environment vars, relative paths).
 -----------------------------------------------------------------------------*/
-char* lio_path_resolve(const char *const restrict pInPath)
+static char* _lio_path_resolve(const char *const restrict pInPath)
 {
     // Expand all variables in the input path
     wordexp_t wxp;
@@ -155,10 +184,10 @@ char* lio_path_resolve(const char *const restrict pInPath)
     }
     
     // create a temporary string to hold the expanded path
-    char* const tempPath = (char*)malloc(bytesToAlloc+1);
+    char* const tempPath = (char*)lio_alloc_malloc(bytesToAlloc+1);
     if (!tempPath)
     {
-        fprintf(stderr, "Failed to allocate memory while expanding the file path \"%s\".\n", pInPath);
+        lio_error_report(LIO_ERROR_OUT_OF_MEMORY, 0, "Failed to allocate memory while expanding a path", pInPath, NULL);
         wordfree(&wxp);
         return NULL;
     }
@@ -183,21 +212,39 @@ char* lio_path_resolve(const char *const restrict pInPath)
         lastCharIndex += numCurrChars;
     }
 
-    char* const pOutPath = realpath(tempPath, NULL);
-    
-    wordfree(&wxp);
-    free(tempPath);
-    
-    if (!pOutPath)
+    // realpath() is given a buffer so the result can be returned through the
+    // library's allocator rather than the system's.
+    char resolvedPath[PATH_MAX];
+    char* pOutPath = NULL;
+
+    if (!realpath(tempPath, resolvedPath))
+    {
+        lio_error_report_errno(errno, "Unable to resolve a path", tempPath, NULL);
+    }
+    else if ((pOutPath = lio_utils_str_copy(resolvedPath, 0)) == NULL)
     {
-        perror("Unable to resolve a file path");
+        lio_error_report(LIO_ERROR_OUT_OF_MEMORY, 0, "Failed to allocate memory while resolving a path", tempPath, NULL);
     }
     
+    wordfree(&wxp);
+    lio_alloc_free(tempPath);
+    
     return pOutPath;
 }
 
 
 
+char* lio_path_resolve(const char *const restrict pInPath)
+{
+    LIO_STATS_BEGIN(timer, LIO_STATS_OP_PATH_RESOLVE, pInPath);
+    char* const ret = _lio_path_resolve(pInPath);
+    LIO_STATS_END_CALL(timer, NULL, 0, 0, 0, ret != NULL);
+
+    return ret;
+}
+
+
+
 /*-----------------------------------------------------------------------------
  * File Removal
 -----------------------------------------------------------------------------*/
@@ -211,6 +258,9 @@ static int _lio_path_recursive_remove(
 {
     (void)pUnusedStat;
     (void)pUnusedFtw;
+
+    LIO_STATS_ADD(LIO_STATS_ENTRIES_SCANNED, 1);
+    LIO_STATS_ADD(LIO_STATS_SYSCALLS, 1);
     
     // non-recursive call
     if (fileType == FTW_D)
@@ -219,7 +269,7 @@ static int _lio_path_recursive_remove(
 
         if (ret != 0)
         {
-            fprintf(stderr, "Cannot recursively remove non-empty directory: %s\n", inPath);
+            lio_error_report_errno(errno, "Cannot recursively remove a directory", inPath, NULL);
         }
         
         return ret;
@@ -228,14 +278,14 @@ static int _lio_path_recursive_remove(
     // bad permissions
     if (fileType == FTW_DNR || fileType == FTW_NS)
     {
-        fprintf(stderr, "Cannot remove path due to bad permissions: %s\n", inPath);
+        lio_error_report(LIO_ERROR_PERMISSION_DENIED, 0, "Cannot remove a path due to bad permissions", inPath, NULL);
         return -1;
     }
     
     const int ret = remove(inPath);
     if (ret != 0)
     {
-        fprintf(stderr, "Cannot remove path: %s\n", inPath);
+        lio_error_report_errno(errno, "Cannot remove a path", inPath, NULL);
     }
     
     return ret;
@@ -247,16 +297,21 @@ static int _lio_path_recursive_remove(
 /*-------------------------------------
  * Recursively remove a path
 ------------------------------------*/
-bool lio_path_remove(
+static bool _lio_path_remove(
     const char* const restrict path,
     const bool recurse,
     bool followLinks)
 {
     if (lio_path_does_exist(path, LIO_PATH_TYPE_FILE))
     {
-        if (!remove(path))
+        const int ret = remove(path);
+        const int sysError = errno;
+        LIO_STATS_ADD(LIO_STATS_SYSCALLS, 1);
+        lio_statcache_invalidate(path, false);
+
+        if (ret != 0)
         {
-            fprintf(stderr, "Cannot remove single file: %s\n", path);
+            lio_error_report_errno(sysError, "Cannot remove a file", path, NULL);
             return false;
         }
         return true;
@@ -264,16 +319,38 @@ bool lio_path_remove(
     
     if (!recurse && lio_path_does_exist(path, LIO_PATH_TYPE_FOLDER))
     {
-        if (rmdir(path) != 0)
+        const int ret = rmdir(path);
+        const int sysError = errno;
+        LIO_STATS_ADD(LIO_STATS_SYSCALLS, 1);
+        lio_statcache_invalidate(path, false);
+
+        if (ret != 0)
         {
-            fprintf(stderr, "Cannot recursively remove directory: %s\n", path);
+            lio_error_report_errno(sysError, "Cannot remove a directory", path, NULL);
             return false;
         }
     }
     
     const int walkFlags = FTW_DEPTH | (followLinks ? 0 : FTW_PHYS);
+    const int ret = nftw(path, &_lio_path_recursive_remove, 1, walkFlags);
+
+    lio_statcache_invalidate(path, true);
     
-    return nftw(path, &_lio_path_recursive_remove, 1, walkFlags) == 0;
+    return ret == 0;
+}
+
+
+
+bool lio_path_remove(
+    const char* const restrict path,
+    const bool recurse,
+    bool followLinks)
+{
+    LIO_STATS_BEGIN(timer, LIO_STATS_OP_PATH_REMOVE, path);
+    const bool ret = _lio_path_remove(path, recurse, followLinks);
+    LIO_STATS_END_CALL(timer, NULL, recurse, followLinks, 0, ret);
+
+    return ret;
 }
 
 
@@ -281,7 +358,7 @@ bool lio_path_remove(
 /*-----------------------------------------------------------------------------
     MKDIR
 -----------------------------------------------------------------------------*/
-bool lio_path_mkdirs(const char* const restrict pPath)
+static bool _lio_path_mkdirs(const char* const restrict pPath)
 {
     static const mode_t permissions = 0 \
         | S_IRGRP | S_IWGRP | S_IXGRP \
@@ -290,6 +367,7 @@ bool lio_path_mkdirs(const char* const restrict pPath)
 
     if (!pPath)
     {
+        lio_error_report(LIO_ERROR_INVALID_ARGUMENT, 0, "Cannot create a directory without a path", NULL, NULL);
         return false;
     }
 
@@ -297,45 +375,51 @@ bool lio_path_mkdirs(const char* const restrict pPath)
     /*
     if (!pTmpPath)
     {
-        fprintf(stderr, "Unable to allocate memory before recursively creating directories: %s\n", pPath);
+        lio_error_report(LIO_ERROR_OUT_OF_MEMORY, 0, "Unable to allocate memory before recursively creating directories", pPath, NULL);
         return false;
     }
     */
     
     char* const pDir = pTmpPath;
     
-    for(char* p = pDir+1; *p; p++)
+    const size_t numChars = strlen(pDir);
+    size_t iter = numChars ? 1 : 0;
+
+    // Skip from one separator to the next rather than testing every character
+    while ((iter += lio_pathview_find_sep(pDir+iter, numChars-iter)) < numChars)
     {
-        // Detect if a path needs to be made by checking for a trailing slash
-        if(*p != LIO_PATH_SEP)
-        {
-            continue;
-        }
-        
         // replace the current char with a '\0' so mkdir will think that's
         // a null-termination and only create a path up to that point.
-        *p = '\0';
+        pDir[iter] = '\0';
         
         if (!lio_path_does_exist(pDir, LIO_PATH_TYPE_FOLDER))
         {
-            if (mkdir(pDir, permissions) != 0)
+            const int ret = mkdir(pDir, permissions);
+            const int sysError = errno;
+            LIO_STATS_ADD(LIO_STATS_SYSCALLS, 1);
+            lio_statcache_invalidate(pDir, false);
+
+            if (ret != 0)
             {
-                fprintf(stderr, "Cannot create parent directory: %s\n", pDir);
+                lio_error_report_errno(sysError, "Cannot create a parent directory", pDir, NULL);
                 lio_path_destroy(pTmpPath);
                 return false;
             }
         }
         
         // return the trailing slash to its normal state.
-        *p = LIO_PATH_SEP;
+        pDir[iter++] = LIO_PATH_SEP;
     }
     
     // create the final directory in a path
     const int ret = mkdir(pDir, permissions);
+    const int sysError = errno;
+    LIO_STATS_ADD(LIO_STATS_SYSCALLS, 1);
+    lio_statcache_invalidate(pDir, false);
     
     if (ret != 0)
     {
-        fprintf(stderr, "Cannot create directory: %s\n", pDir);
+        lio_error_report_errno(sysError, "Cannot create a directory", pDir, NULL);
     }
     
     //lio_path_destroy(pTmpPath);
@@ -346,49 +430,89 @@ bool lio_path_mkdirs(const char* const restrict pPath)
 
 
 
+bool lio_path_mkdirs(const char* const restrict pPath)
+{
+    LIO_STATS_BEGIN(timer, LIO_STATS_OP_PATH_MKDIRS, pPath);
+    const bool ret = _lio_path_mkdirs(pPath);
+    LIO_STATS_END_CALL(timer, NULL, 0, 0, 0, ret);
+
+    return ret;
+}
+
+
+
 /*-----------------------------------------------------------------------------
- * get a path listing
+ * Enumerate the entries of a directory
+ *
+ * Entries are counted when "ppOutEntries" is NULL. Otherwise each accepted
+ * path is copied into the arena, or into its own allocation if no arena is
+ * given. Full paths are built in a single reusable buffer, so rejected
+ * entries cost no allocations.
 -----------------------------------------------------------------------------*/
-char** lio_path_list(
+static unsigned _lio_path_enumerate_impl(
     const char* const baseDir,
     const bool listHidden,
     bool (*filter)(const char* const),
-    unsigned* const pOutNumEntries)
+    LioArena* const pArena,
+    char*** const ppOutEntries)
 {
     char* baseDirectory;
     struct dirent* pEntry;
     DIR* pDir = NULL;
-    unsigned iter = 0;
-    const unsigned numEntries = lio_path_count_entries(baseDir, listHidden, filter);
-    char** const ret = (char**)calloc(numEntries, sizeof(char*));
+    LioStrBuf fullPath;
+    char** pEntries = NULL;
+    unsigned numEntries = 0;
+    unsigned capacity = 0;
+    bool failed = false;
 
     // make sure we have the full path to avoid errors in enumeration
-    if (ret == NULL
-    || (baseDirectory = lio_path_resolve(baseDir)) == NULL
+    if ((baseDirectory = lio_path_resolve(baseDir)) == NULL
     || lio_path_does_exist(baseDirectory, LIO_PATH_TYPE_FOLDER) == false)
     {
-        fprintf(stderr, "Unable to resolve the directory \"%s\" for reading.\n", baseDir);
-        closedir(pDir);
-        return false;
+        if (baseDirectory)
+        {
+            lio_error_report(LIO_ERROR_NOT_A_FOLDER, 0, "Unable to read a directory", baseDir, NULL);
+        }
+        lio_path_destroy(baseDirectory);
+        return UINT_MAX;
     }
 
-    if ((pDir = opendir(baseDirectory)) == NULL)
+    pDir = opendir(baseDirectory);
+    LIO_STATS_ADD(LIO_STATS_SYSCALLS, 1);
+
+    if (pDir == NULL)
     {
-        fprintf(stderr, "Failed to open the directory \"%s\" for reading.\n", baseDir);
-        closedir(pDir);
+        lio_error_report_errno(errno, "Failed to open a directory for reading", baseDir, NULL);
         lio_path_destroy(baseDirectory);
-        return false;
+        return UINT_MAX;
     }
 
-    while ((pEntry = readdir(pDir)) != NULL)
+    // Paths are only needed for filtering or listing
+    const bool needPaths = filter || ppOutEntries;
+    size_t baseLength = 0;
+
+    lio_strbuf_init(&fullPath);
+    if (needPaths)
     {
-        const char* const entry = pEntry->d_name;
-        if (entry == NULL)
+        baseLength = strlen(baseDirectory);
+        if (!lio_strbuf_append_n(&fullPath, baseDirectory, baseLength)
+        || ((!baseLength || baseDirectory[baseLength-1] != LIO_PATH_SEP) && !lio_strbuf_append_char(&fullPath, LIO_PATH_SEP)))
         {
-            fprintf(stderr, "Unable to enumerate a path within \"%s\".\n", baseDir);
-            continue;
+            lio_error_report(LIO_ERROR_OUT_OF_MEMORY, 0, "Failed to allocate a path while reading a directory", baseDir, NULL);
+            closedir(pDir);
+            lio_path_destroy(baseDirectory);
+            lio_strbuf_terminate(&fullPath);
+            return UINT_MAX;
         }
 
+        baseLength = fullPath.length;
+    }
+
+    while ((pEntry = readdir(pDir)) != NULL)
+    {
+        const char* const entry = pEntry->d_name;
+        LIO_STATS_ADD(LIO_STATS_ENTRIES_SCANNED, 1);
+
         // Portability: "dotfiles" are *NIX only
         if ((!listHidden && entry[0] == '.')
         || strcmp(entry, ".") == 0
@@ -397,25 +521,120 @@ char** lio_path_list(
             continue;
         }
 
-        // concatenate full paths to avoid read errors
-        char* const fullPath = lio_utils_str_fmt("%s%c%s", baseDirectory, LIO_PATH_SEP, entry);
-        if (!fullPath)
+        if (!needPaths)
         {
-            fprintf(stderr, "Failed to concatenate the paths \"%s\" and \"%s\".\n", baseDirectory, entry);
+            ++numEntries;
             continue;
         }
 
+        // concatenate full paths to avoid read errors
+        lio_strbuf_truncate(&fullPath, baseLength);
+        if (!lio_strbuf_append(&fullPath, entry))
+        {
+            lio_error_report(LIO_ERROR_OUT_OF_MEMORY, 0, "Failed to concatenate a directory entry", baseDirectory, entry);
+            failed = true;
+            break;
+        }
+
         // user-defined entry filters
-        if (!filter || filter(fullPath))
+        if (filter && !filter(fullPath.pData))
+        {
+            continue;
+        }
+
+        if (!ppOutEntries)
         {
-            ret[iter++] = fullPath;
+            ++numEntries;
+            continue;
+        }
+
+        if (numEntries == capacity)
+        {
+            const unsigned newCapacity = capacity ? capacity*2 : 16;
+            char** const pNewEntries = (char**)lio_alloc_realloc(pEntries, capacity * sizeof(char*), newCapacity * sizeof(char*));
+            if (!pNewEntries)
+            {
+                lio_error_report(LIO_ERROR_OUT_OF_MEMORY, 0, "Unable to list every entry in a directory", baseDir, NULL);
+                failed = true;
+                break;
+            }
+
+            pEntries = pNewEntries;
+            capacity = newCapacity;
         }
+
+        char* const pCopy = pArena
+            ? lio_arena_str_copy(pArena, fullPath.pData, fullPath.length)
+            : lio_utils_str_copy(fullPath.pData, fullPath.length);
+
+        if (!pCopy)
+        {
+            lio_error_report(LIO_ERROR_OUT_OF_MEMORY, 0, "Unable to list every entry in a directory", baseDir, NULL);
+            failed = true;
+            break;
+        }
+
+        pEntries[numEntries++] = pCopy;
     }
 
     closedir(pDir);
     lio_path_destroy(baseDirectory);
+    lio_strbuf_terminate(&fullPath);
+
+    // A partial listing would look complete to the caller
+    if (failed)
+    {
+        for (unsigned i = 0; !pArena && i < numEntries; ++i)
+        {
+            lio_utils_str_destroy(pEntries[i]);
+        }
+        lio_alloc_free(pEntries);
+        return UINT_MAX;
+    }
+
+    if (ppOutEntries)
+    {
+        // The returned array lives wherever its strings do
+        char** pRet = pEntries;
+
+        if (pArena)
+        {
+            pRet = (char**)lio_arena_alloc(pArena, LIO_UTILS_MAX(numEntries, 1u) * sizeof(char*));
+            if (pRet && numEntries)
+            {
+                memcpy(pRet, pEntries, numEntries * sizeof(char*));
+            }
+            lio_alloc_free(pEntries);
+        }
+        else if (!pRet)
+        {
+            pRet = (char**)lio_alloc_calloc(1, sizeof(char*));
+        }
+
+        if (!pRet)
+        {
+            lio_error_report(LIO_ERROR_OUT_OF_MEMORY, 0, "Unable to allocate a directory listing", baseDir, NULL);
+            return UINT_MAX;
+        }
+
+        *ppOutEntries = pRet;
+    }
+
+    return numEntries;
+}
+
 
-    *pOutNumEntries = iter;
+
+static unsigned _lio_path_enumerate(
+    const char* const baseDir,
+    const bool listHidden,
+    bool (*filter)(const char* const),
+    LioArena* const pArena,
+    char*** const ppOutEntries)
+{
+    LIO_STATS_BEGIN(timer, LIO_STATS_OP_PATH_LIST, baseDir);
+    const unsigned ret = _lio_path_enumerate_impl(baseDir, listHidden, filter, pArena, ppOutEntries);
+    LIO_STATS_END_CALL(timer, NULL, listHidden, filter != NULL, ppOutEntries == NULL, (ret == UINT_MAX) ? -1 : (int64_t)ret);
 
     return ret;
 }
@@ -423,73 +642,89 @@ char** lio_path_list(
 
 
 /*-----------------------------------------------------------------------------
- * Count the number of entries in a directory
+ * get a path listing
 -----------------------------------------------------------------------------*/
-unsigned lio_path_count_entries(
+char** lio_path_list(
     const char* const baseDir,
     const bool listHidden,
-    bool (*filter)(const char* const))
+    bool (*filter)(const char* const),
+    unsigned* const pOutNumEntries)
 {
-    char* baseDirectory;
-    struct dirent* pEntry;
-    DIR* pDir = NULL;
-    unsigned numEntries = 0;
+    char** ret = NULL;
+    const unsigned numEntries = _lio_path_enumerate(baseDir, listHidden, filter, NULL, &ret);
 
-    // make sure we have the full path to avoid errors in enumeration
-    if ((baseDirectory = lio_path_resolve(baseDir)) == NULL
-    || lio_path_does_exist(baseDirectory, LIO_PATH_TYPE_FOLDER) == false)
+    if (numEntries == UINT_MAX)
     {
-        fprintf(stderr, "Unable to resolve the directory \"%s\" for reading.\n", baseDir);
-        closedir(pDir);
-        return UINT_MAX;
+        return NULL;
     }
 
-    if ((pDir = opendir(baseDirectory)) == NULL)
+    *pOutNumEntries = numEntries;
+
+    return ret;
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * get a path listing in an arena
+-----------------------------------------------------------------------------*/
+char** lio_path_list_arena(
+    const char* const baseDir,
+    const bool listHidden,
+    bool (*filter)(const char* const),
+    LioArena* const pArena,
+    unsigned* const pOutNumEntries)
+{
+    char** ret = NULL;
+
+    if (!pArena)
     {
-        fprintf(stderr, "Failed to open the directory \"%s\" for reading.\n", baseDir);
-        closedir(pDir);
-        lio_path_destroy(baseDirectory);
-        return UINT_MAX;
+        return NULL;
     }
 
-    while ((pEntry = readdir(pDir)) != NULL)
+    const unsigned numEntries = _lio_path_enumerate(baseDir, listHidden, filter, pArena, &ret);
+    if (numEntries == UINT_MAX)
     {
-        const char* const entry = pEntry->d_name;
-        if (entry == NULL)
-        {
-            fprintf(stderr, "Unable to enumerate a path within \"%s\".\n", baseDir);
-            continue;
-        }
+        return NULL;
+    }
 
-        // Portability: "dotfiles" are *NIX only
-        if ((!listHidden && entry[0] == '.')
-        || strcmp(entry, ".") == 0
-        || strcmp(entry, "..") == 0)
-        {
-            continue;
-        }
+    *pOutNumEntries = numEntries;
+
+    return ret;
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Count the number of entries in a directory
+-----------------------------------------------------------------------------*/
+unsigned lio_path_count_entries(
+    const char* const baseDir,
+    const bool listHidden,
+    bool (*filter)(const char* const))
+{
+    return _lio_path_enumerate(baseDir, listHidden, filter, NULL, NULL);
+}
 
-        // concatenate full paths to avoid read errors
-        char* const fullPath = lio_utils_str_fmt("%s%c%s", baseDirectory, LIO_PATH_SEP, entry);
-        if (!fullPath)
-        {
-            fprintf(stderr, "Failed to concatenate the paths \"%s\" and \"%s\".\n", baseDirectory, entry);
-            continue;
-        }
 
-        // user-defined entry filters
-        if (!filter || filter(fullPath))
-        {
-            ++numEntries;
-        }
 
-        lio_path_destroy(fullPath);
+/*-----------------------------------------------------------------------------
+ * Rename a path, forgetting the cached state of both sides
+-----------------------------------------------------------------------------*/
+static int _lio_path_rename(const char* const restrict pFrom, const char* const restrict pTo)
+{
+    const int ret = rename(pFrom, pTo);
+    LIO_STATS_ADD(LIO_STATS_SYSCALLS, 1);
+
+    if (ret != 0)
+    {
+        lio_error_report_errno(errno, "Cannot rename a path", pFrom, pTo);
     }
 
-    closedir(pDir);
-    lio_path_destroy(baseDirectory);
+    lio_statcache_invalidate(pFrom, true);
+    lio_statcache_invalidate(pTo, true);
 
-    return numEntries;
+    return ret;
 }
 
 
@@ -497,7 +732,7 @@ unsigned lio_path_count_entries(
 /*-----------------------------------------------------------------------------
  * Move a file or folder
 -----------------------------------------------------------------------------*/
-int lio_path_move(
+static int _lio_path_move(
     const char* const restrict pFrom,
     const char* const restrict pTo,
     const bool overwrite)
@@ -513,11 +748,12 @@ int lio_path_move(
             }
             else
             {
+                lio_error_report(LIO_ERROR_ALREADY_EXISTS, 0, "Cannot move a folder over an existing folder", pFrom, pTo);
                 return -1;
             }
         }
 
-        return rename(pFrom, pTo);
+        return _lio_path_rename(pFrom, pTo);
     }
     else if (lio_path_does_exist(pFrom, LIO_PATH_TYPE_FILE))
     {
@@ -529,13 +765,28 @@ int lio_path_move(
             }
             else
             {
+                lio_error_report(LIO_ERROR_ALREADY_EXISTS, 0, "Cannot move a file over an existing file", pFrom, pTo);
                 return -2;
             }
         }
 
-        return rename(pFrom, pTo);
+        return _lio_path_rename(pFrom, pTo);
     }
 
-    fprintf(stderr, "Error: cannot move \"%s\" to \"%s\"", pFrom, pTo);
+    lio_error_report(LIO_ERROR_NOT_FOUND, 0, "Cannot move a path which does not exist", pFrom, pTo);
     return -3;
 }
+
+
+
+int lio_path_move(
+    const char* const restrict pFrom,
+    const char* const restrict pTo,
+    const bool overwrite)
+{
+    LIO_STATS_BEGIN(timer, LIO_STATS_OP_PATH_MOVE, pFrom);
+    const int ret = _lio_path_move(pFrom, pTo, overwrite);
+    LIO_STATS_END_CALL(timer, pTo, overwrite, 0, 0, ret);
+
+    return ret;
+}
@@ -14,9 +14,14 @@
 #include <string.h> // strlen, memset()
 #include <stdlib.h> // size_t, realpath(...) (POSIX)
 
+#include "light_io/lio_alloc.h"
 #include "light_io/lio_config.h"
+#include "light_io/lio_error.h"
 #include "light_io/lio_utils.h"
+#include "light_io/lio_strbuf.h"
+#include "light_io/lio_arena.h"
 #include "light_io/lio_paths.h"
+#include "light_io/lio_pathview.h"
 
 
 
@@ -38,11 +43,9 @@ bool lio_path_does_exist(
     const char *const restrict path,
     const enum LioPathType pathType)
 {
-    const size_t numChars = strlen(path);
-    
-    if (!path || !numChars)
+    if (!path || !path[0])
     {
-        fprintf(stderr, "Unable to locate a file at a non-existent directory.\n");
+        lio_error_report(LIO_ERROR_INVALID_ARGUMENT, 0, "Unable to locate a file at a non-existent directory", NULL, NULL);
         return false;
     }
 
@@ -87,15 +90,15 @@ char* lio_path_resolve(const char *const restrict pInPath)
 
     if (!pInPath || pInPath[0] == '\0')
     {
-        fprintf(stderr, "Cannot expand a NULL file path.\n");
+        lio_error_report(LIO_ERROR_INVALID_ARGUMENT, 0, "Cannot expand an empty path", NULL, NULL);
         return NULL;
     }
     
     // create a temporary string to hold the expanded path
-    char* pOutPath = (char*)malloc(bytesToAlloc);
+    char* pOutPath = (char*)lio_alloc_malloc(bytesToAlloc);
     if (!pOutPath)
     {
-        fprintf(stderr, "Failed to allocate memory while expanding the file path \"%s\".\n", pInPath);
+        lio_error_report(LIO_ERROR_OUT_OF_MEMORY, 0, "Failed to allocate memory while expanding a path", pInPath, NULL);
         return NULL;
     }
     else
@@ -107,8 +110,8 @@ char* lio_path_resolve(const char *const restrict pInPath)
         
     if (ret == FALSE)
     {
-        fprintf(stderr, "Unable to resolve the file path \"%s\".", pInPath);
-        free(pOutPath);
+        lio_error_report(LIO_ERROR_INVALID_ARGUMENT, 0, "Unable to resolve a path", pInPath, NULL);
+        lio_alloc_free(pOutPath);
         pOutPath = NULL;
     }
     
@@ -132,16 +135,16 @@ bool lio_path_remove(
 
     if (lio_path_does_exist(path, LIO_PATH_TYPE_FILE))
     {
-        if (!remove(path))
+        if (remove(path) != 0)
         {
-            fprintf(stderr, "Cannot remove single file: %s\n", path);
+            lio_error_report_errno(errno, "Cannot remove a file", path, NULL);
             return false;
         }
         return true;
     }
 
     size_t dirLen = strlen(path); // +2 NULL characters are required for SHFileOperation.
-    char* tmpDir = (char*)malloc(dirLen + 2);
+    char* tmpDir = (char*)lio_alloc_malloc(dirLen + 2);
     
     memcpy(tmpDir, path, dirLen);
     tmpDir[dirLen+0] = '\0';
@@ -165,11 +168,11 @@ bool lio_path_remove(
     };
   
     int ret = SHFileOperation(&pathOp);
-    free(tmpDir);
+    lio_alloc_free(tmpDir);
 
     if (ret != 0)
     {
-        fprintf(stderr, "Encountered error %X while removing the directory \"%s\".\n", ret, path);
+        lio_error_report(LIO_ERROR_IO, 0, "Cannot remove a directory", path, NULL);
         return false;
     }
   
@@ -191,36 +194,34 @@ bool lio_path_mkdirs(const char* const restrict pPath)
     char* const pTmpPath = lio_utils_str_copy(pPath, 0); //lio_path_resolve(pPath);
     if (!pTmpPath)
     {
-        fprintf(stderr, "Unable to allocate memory before recursively creating directories: %s\n", pPath);
+        lio_error_report(LIO_ERROR_OUT_OF_MEMORY, 0, "Unable to allocate memory before recursively creating directories", pPath, NULL);
         return false;
     }
     
     char* const pDir = pTmpPath;
     
-    for(char* p = pDir+1; *p; p++)
+    const size_t numChars = strlen(pDir);
+    size_t iter = numChars ? 1 : 0;
+
+    // Skip from one separator to the next rather than testing every character
+    while ((iter += lio_pathview_find_sep(pDir+iter, numChars-iter)) < numChars)
     {
-        // Detect if a path needs to be made by checking for a trailing slash
-        if(*p != LIO_PATH_SEP)
-        {
-            continue;
-        }
-        
         // replace the current char with a '\0' so mkdir will think that's
         // a null-termination and only create a path up to that point.
-        *p = '\0';
+        pDir[iter] = '\0';
         
         if (!lio_path_does_exist(pDir, LIO_PATH_TYPE_FOLDER))
         {
             if (_mkdir(pDir) != 0)
             {
-                fprintf(stderr, "Encountered error %X while creating a directory: %s\n", errno, pDir);
+                lio_error_report_errno(errno, "Cannot create a parent directory", pDir, NULL);
                 lio_path_destroy(pTmpPath);
                 return false;
             }
         }
         
         // return the trailing slash to its normal state.
-        *p = LIO_PATH_SEP;
+        pDir[iter++] = LIO_PATH_SEP;
     }
     
     // create the final directory in a path
@@ -228,7 +229,7 @@ bool lio_path_mkdirs(const char* const restrict pPath)
     
     if (ret != 0)
     {
-        fprintf(stderr, "Encountered error %X while creating a directory: %s\n", errno, pDir);
+        lio_error_report_errno(errno, "Cannot create a directory", pDir, NULL);
     }
     
     //lio_path_destroy(pTmpPath);
@@ -240,138 +241,233 @@ bool lio_path_mkdirs(const char* const restrict pPath)
 
 
 /*-----------------------------------------------------------------------------
- * get a path listing
+ * Enumerate the entries of a directory
+ *
+ * Entries are counted when "ppOutEntries" is NULL. Otherwise each accepted
+ * path is copied into the arena, or into its own allocation if no arena is
+ * given. Full paths are built in a single reusable buffer, so rejected
+ * entries cost no allocations.
 -----------------------------------------------------------------------------*/
-char** lio_path_list(
+static unsigned _lio_path_enumerate(
     const char* const baseDir,
     const bool listHidden,
     bool (*filter)(const char* const),
-    unsigned* const pOutNumEntries)
+    LioArena* const pArena,
+    char*** const ppOutEntries)
 {
     char* baseDirectory = NULL;
-    char* searchDirectory = NULL;
     WIN32_FIND_DATA pData;
     HANDLE pEntry = INVALID_HANDLE_VALUE;
-    unsigned iter = 0;
-    const unsigned numEntries = lio_path_count_entries(baseDir, listHidden, filter);
-    char** const ret = (char**)calloc(numEntries, sizeof(char*));
+    LioStrBuf fullPath;
+    char** pEntries = NULL;
+    unsigned numEntries = 0;
+    unsigned capacity = 0;
+    bool failed = false;
+    size_t baseLength = 0;
+
+    lio_strbuf_init(&fullPath);
 
     // make sure we have the full path to avoid errors in enumeration
-    if (ret == NULL
-    || (baseDirectory = lio_path_resolve(baseDir)) == NULL
+    if ((baseDirectory = lio_path_resolve(baseDir)) == NULL
     || lio_path_does_exist(baseDirectory, LIO_PATH_TYPE_FOLDER) == false
-    || (searchDirectory = lio_utils_str_fmt("%s%c*", baseDirectory, LIO_PATH_SEP)) == NULL)
+    || !lio_strbuf_append(&fullPath, baseDirectory)
+    || !lio_strbuf_append_char(&fullPath, LIO_PATH_SEP))
     {
-        fprintf(stderr, "Unable to resolve the directory \"%s\" for reading.\n", baseDir);
+        lio_error_report(LIO_ERROR_NOT_A_FOLDER, 0, "Unable to read a directory", baseDir, NULL);
+        lio_strbuf_terminate(&fullPath);
         lio_path_destroy(baseDirectory);
-        return false;
+        return UINT_MAX;
     }
 
-    if ((pEntry = FindFirstFile(searchDirectory, &pData)) == INVALID_HANDLE_VALUE)
+    // The search pattern and each entry share the same directory prefix
+    baseLength = fullPath.length;
+    lio_strbuf_append_char(&fullPath, '*');
+
+    if ((pEntry = FindFirstFile(fullPath.pData, &pData)) == INVALID_HANDLE_VALUE)
     {
-        fprintf(stderr, "Failed to open the directory \"%s\" for reading.\n", baseDir);
-        lio_utils_str_destroy(searchDirectory);
+        lio_error_report(LIO_ERROR_IO, 0, "Failed to open a directory for reading", baseDir, NULL);
+        lio_strbuf_terminate(&fullPath);
         lio_path_destroy(baseDirectory);
-        return false;
+        return UINT_MAX;
     }
 
-    while (FindNextFile(pEntry, &pData) != 0)
+    do
     {
         // Portability: "dotfiles" are *NIX only, but we'll block them in Windows
-        if ((!listHidden && (pData.cFileName[0] == '.' || (GetFileAttributesA(pData.cFileName) & FILE_ATTRIBUTE_HIDDEN)))
+        if ((!listHidden && (pData.cFileName[0] == '.' || (pData.dwFileAttributes & FILE_ATTRIBUTE_HIDDEN)))
         || strcmp(pData.cFileName, ".") == 0
         || strcmp(pData.cFileName, "..") == 0)
         {
             continue;
         }
 
-        // concatenate full paths to avoid read errors
-        char* const fullPath = lio_utils_str_fmt("%s%c%s", baseDirectory, LIO_PATH_SEP, pData.cFileName);
-        if (!fullPath)
+        if (!filter && !ppOutEntries)
         {
-            fprintf(stderr, "Failed to concatenate the paths \"%s\" and \"%s\".\n", baseDirectory, pData.cFileName);
+            ++numEntries;
             continue;
         }
 
+        // concatenate full paths to avoid read errors
+        lio_strbuf_truncate(&fullPath, baseLength);
+        if (!lio_strbuf_append(&fullPath, pData.cFileName))
+        {
+            lio_error_report(LIO_ERROR_OUT_OF_MEMORY, 0, "Failed to concatenate a directory entry", baseDirectory, pData.cFileName);
+            failed = true;
+            break;
+        }
+
         // user-defined entry filters
-        if (!filter || filter(fullPath))
+        if (filter && !filter(fullPath.pData))
+        {
+            continue;
+        }
+
+        if (!ppOutEntries)
         {
-            ret[iter++] = fullPath;
+            ++numEntries;
+            continue;
         }
+
+        if (numEntries == capacity)
+        {
+            const unsigned newCapacity = capacity ? capacity*2 : 16;
+            char** const pNewEntries = (char**)lio_alloc_realloc(pEntries, capacity * sizeof(char*), newCapacity * sizeof(char*));
+            if (!pNewEntries)
+            {
+                lio_error_report(LIO_ERROR_OUT_OF_MEMORY, 0, "Unable to list every entry in a directory", baseDir, NULL);
+                failed = true;
+                break;
+            }
+
+            pEntries = pNewEntries;
+            capacity = newCapacity;
+        }
+
+        char* const pCopy = pArena
+            ? lio_arena_str_copy(pArena, fullPath.pData, fullPath.length)
+            : lio_utils_str_copy(fullPath.pData, fullPath.length);
+
+        if (!pCopy)
+        {
+            lio_error_report(LIO_ERROR_OUT_OF_MEMORY, 0, "Unable to list every entry in a directory", baseDir, NULL);
+            failed = true;
+            break;
+        }
+
+        pEntries[numEntries++] = pCopy;
     }
-    FindClose(pEntry);
+    while (FindNextFile(pEntry, &pData) != 0);
 
-    lio_utils_str_destroy(searchDirectory);
+    FindClose(pEntry);
+    lio_strbuf_terminate(&fullPath);
     lio_path_destroy(baseDirectory);
 
-    *pOutNumEntries = iter;
+    // A partial listing would look complete to the caller
+    if (failed)
+    {
+        for (unsigned i = 0; !pArena && i < numEntries; ++i)
+        {
+            lio_utils_str_destroy(pEntries[i]);
+        }
+        lio_alloc_free(pEntries);
+        return UINT_MAX;
+    }
 
-    return ret;
+    if (ppOutEntries)
+    {
+        // The returned array lives wherever its strings do
+        char** pRet = pEntries;
+
+        if (pArena)
+        {
+            pRet = (char**)lio_arena_alloc(pArena, LIO_UTILS_MAX(numEntries, 1u) * sizeof(char*));
+            if (pRet && numEntries)
+            {
+                memcpy(pRet, pEntries, numEntries * sizeof(char*));
+            }
+            lio_alloc_free(pEntries);
+        }
+        else if (!pRet)
+        {
+            pRet = (char**)lio_alloc_calloc(1, sizeof(char*));
+        }
+
+        if (!pRet)
+        {
+            return UINT_MAX;
+        }
+
+        *ppOutEntries = pRet;
+    }
+
+    return numEntries;
 }
 
 
 
 /*-----------------------------------------------------------------------------
- * Count the number of entries in a directory
+ * get a path listing
 -----------------------------------------------------------------------------*/
-unsigned lio_path_count_entries(
+char** lio_path_list(
     const char* const baseDir,
     const bool listHidden,
-    bool (*filter)(const char* const))
+    bool (*filter)(const char* const),
+    unsigned* const pOutNumEntries)
 {
-    char* baseDirectory = NULL;
-    char* searchDirectory = NULL;
-    WIN32_FIND_DATA pData;
-    HANDLE pEntry = INVALID_HANDLE_VALUE;
-    unsigned numEntries = 0;
+    char** ret = NULL;
+    const unsigned numEntries = _lio_path_enumerate(baseDir, listHidden, filter, NULL, &ret);
 
-    // make sure we have the full path to avoid errors in enumeration
-    if ((baseDirectory = lio_path_resolve(baseDir)) == NULL
-    || lio_path_does_exist(baseDirectory, LIO_PATH_TYPE_FOLDER) == false
-    || (searchDirectory = lio_utils_str_fmt("%s%c*", baseDirectory, LIO_PATH_SEP)) == NULL)
+    if (numEntries == UINT_MAX)
     {
-        fprintf(stderr, "Unable to resolve the directory \"%s\" for reading.\n", baseDir);
-        return false;
+        return NULL;
     }
 
-    if ((pEntry = FindFirstFile(searchDirectory, &pData)) == INVALID_HANDLE_VALUE)
+    *pOutNumEntries = numEntries;
+
+    return ret;
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * get a path listing in an arena
+-----------------------------------------------------------------------------*/
+char** lio_path_list_arena(
+    const char* const baseDir,
+    const bool listHidden,
+    bool (*filter)(const char* const),
+    LioArena* const pArena,
+    unsigned* const pOutNumEntries)
+{
+    char** ret = NULL;
+
+    if (!pArena)
     {
-        fprintf(stderr, "Failed to open the directory \"%s\" for reading.\n", baseDir);
-        lio_utils_str_destroy(searchDirectory);
-        lio_path_destroy(baseDirectory);
-        return false;
+        return NULL;
     }
 
-    while (FindNextFile(pEntry, &pData) != 0)
+    const unsigned numEntries = _lio_path_enumerate(baseDir, listHidden, filter, pArena, &ret);
+    if (numEntries == UINT_MAX)
     {
-        // Portability: "dotfiles" are *NIX only, but we'll block them in Windows
-        if ((!listHidden && (pData.cFileName[0] == '.' || (GetFileAttributesA(pData.cFileName) & FILE_ATTRIBUTE_HIDDEN)))
-        || strcmp(pData.cFileName, ".") == 0
-        || strcmp(pData.cFileName, "..") == 0)
-        {
-            continue;
-        }
+        return NULL;
+    }
 
-        // concatenate full paths to avoid read errors
-        char* const fullPath = lio_utils_str_fmt("%s%c%s", baseDirectory, LIO_PATH_SEP, pData.cFileName);
-        if (!fullPath)
-        {
-            fprintf(stderr, "Failed to concatenate the paths \"%s\" and \"%s\".\n", baseDirectory, pData.cFileName);
-            continue;
-        }
+    *pOutNumEntries = numEntries;
 
-        // user-defined entry filters
-        if (!filter || filter(fullPath))
-        {
-            ++numEntries;
-        }
-    }
-    FindClose(pEntry);
+    return ret;
+}
 
-    lio_utils_str_destroy(searchDirectory);
-    lio_path_destroy(baseDirectory);
 
-    return numEntries;
+
+/*-----------------------------------------------------------------------------
+ * Count the number of entries in a directory
+-----------------------------------------------------------------------------*/
+unsigned lio_path_count_entries(
+    const char* const baseDir,
+    const bool listHidden,
+    bool (*filter)(const char* const))
+{
+    return _lio_path_enumerate(baseDir, listHidden, filter, NULL, NULL);
 }
 
 
@@ -422,6 +518,6 @@ int lio_path_move(
         return ret ? 0 : -4;
     }
 
-    fprintf(stderr, "Error: cannot move \"%s\" to \"%s\"\n", pFrom, pTo);
+    lio_error_report(LIO_ERROR_NOT_FOUND, 0, "Cannot move a path which does not exist", pFrom, pTo);
     return -5;
 }
@@ -0,0 +1,983 @@
+
+#include <stdio.h>
+#include <stdlib.h> // qsort()
+#include <string.h> // memcmp(), memcpy(), strlen()
+
+#include "light_io/lio_alloc.h"
+#include "light_io/lio_error.h"
+#include "light_io/lio_paths.h"
+#include "light_io/lio_pathview.h"
+#include "light_io/lio_strbuf.h"
+#include "light_io/lio_pathset.h"
+
+
+
+/*-----------------------------------------------------------------------------
+ * Internal Structures
+ *
+ * Every node lives in a single open-addressed hash table and is identified by
+ * its slot. A node is keyed by a hash of each component leading up to it,
+ * through the first component of its own label, and its slot also holds its
+ * parent, the links used to enumerate its children, and its label: one or
+ * more components separated by single separators. Short labels are kept in
+ * the slot itself so most lookups never leave the table, longer ones in the
+ * shared label pool.
+ *
+ * The root has no slot; the set links to its children directly.
+-----------------------------------------------------------------------------*/
+#define LIO_PATHSET_NONE UINT32_MAX
+#define LIO_PATHSET_ROOT (UINT32_MAX - 1u)
+
+enum LioPathSetLimits
+{
+    LIO_PATHSET_MIN_ENTRIES = 64,
+    LIO_PATHSET_MIN_SLOTS = 128,
+    LIO_PATHSET_MIN_LABELS = 1024,
+    LIO_PATHSET_INLINE_CHARS = 14, // Labels kept in their slot
+    LIO_PATHSET_MAX_LABEL = 0x3FFF // Longer chains are split across nodes
+};
+
+enum LioPathSetSlotFlags
+{
+    LIO_PATHSET_IS_MEMBER = 0x4000,
+    LIO_PATHSET_IS_USED = 0x8000
+};
+
+typedef struct LioPathSetSlot
+{
+    uint32_t hash;
+    uint32_t parent;
+    uint32_t firstChild;
+    uint32_t nextSibling;
+    uint16_t info; // Label length and flags
+    char label[LIO_PATHSET_INLINE_CHARS]; // The label, or its offset in the pool
+} LioPathSetSlot;
+
+
+
+/*-----------------------------------------------------------------------------
+ * Component scanning
+ *
+ * Components are read a word at a time, and each word is searched for a
+ * separator and added to the hash in the same pass. A component hashes the
+ * same wherever it appears since words are counted from its first character,
+ * and the last is padded with zeros.
+-----------------------------------------------------------------------------*/
+#if defined(__BYTE_ORDER__) && defined(__ORDER_BIG_ENDIAN__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+    #define LIO_PATHSET_BIG_ENDIAN
+#endif
+
+#define LIO_PATHSET_LOW_BITS 0x7F7F7F7F7F7F7F7Full
+#define LIO_PATHSET_SEPS (0x0101010101010101ull * (unsigned char)LIO_PATH_SEP)
+
+
+
+static inline uint64_t _lio_pathset_mix(uint64_t hash, const uint64_t word)
+{
+    hash = (hash ^ word) * 0xFF51AFD7ED558CCDull;
+    return hash ^ (hash >> 32);
+}
+
+
+
+static inline uint64_t _lio_pathset_finish(uint64_t hash, const size_t length)
+{
+    hash = (hash ^ (0x9E3779B97F4A7C15ull + length)) * 0xC4CEB9FE1A85EC53ull;
+    return hash ^ (hash >> 32);
+}
+
+
+
+// Mark the high bit of every separator in a word, without false positives
+static inline uint64_t _lio_pathset_find_seps(const uint64_t word)
+{
+    const uint64_t x = word ^ LIO_PATHSET_SEPS;
+    return ~(((x & LIO_PATHSET_LOW_BITS) + LIO_PATHSET_LOW_BITS) | x | LIO_PATHSET_LOW_BITS);
+}
+
+
+
+static inline size_t _lio_pathset_first_marked(const uint64_t marks)
+{
+#if defined(__GNUC__) && defined(LIO_PATHSET_BIG_ENDIAN)
+    return (size_t)__builtin_clzll(marks) >> 3;
+#elif defined(__GNUC__)
+    return (size_t)__builtin_ctzll(marks) >> 3;
+#else
+    size_t i = 0;
+    while (!((marks >> (i * 8u)) & 0x80u))
+    {
+        ++i;
+    }
+    return i;
+#endif
+}
+
+
+
+// Clear every character in a word after the first "numChars"
+static inline uint64_t _lio_pathset_keep(const uint64_t word, const size_t numChars)
+{
+#if defined(LIO_PATHSET_BIG_ENDIAN)
+    return word & ~(~0ull >> (numChars * 8u));
+#else
+    return (numChars < 8) ? (word & ((1ull << (numChars * 8u)) - 1u)) : word;
+#endif
+}
+
+
+
+// Return the length of the component which starts a string, and add it to
+// "pHash". The string may be empty or start with a separator.
+static inline size_t _lio_pathset_scan(const char* const pData, const size_t maxChars, uint64_t* const pHash)
+{
+    uint64_t hash = *pHash;
+    size_t numChars = 0;
+
+    for (;;)
+    {
+        const size_t numLeft = maxChars - numChars;
+        uint64_t word = 0;
+
+        if (numLeft >= sizeof(word))
+        {
+            memcpy(&word, pData + numChars, sizeof(word));
+        }
+        else
+        {
+            memcpy(&word, pData + numChars, numLeft);
+        }
+
+        const uint64_t marks = _lio_pathset_find_seps(word);
+        if (marks || numLeft <= sizeof(word))
+        {
+            const size_t numFound = marks ? _lio_pathset_first_marked(marks) : numLeft;
+
+            if (numFound)
+            {
+                hash = _lio_pathset_mix(hash, _lio_pathset_keep(word, numFound));
+            }
+
+            numChars += numFound;
+            *pHash = _lio_pathset_finish(hash, numChars);
+            return numChars;
+        }
+
+        hash = _lio_pathset_mix(hash, word);
+        numChars += sizeof(word);
+    }
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Slot accessors
+-----------------------------------------------------------------------------*/
+static inline bool _lio_pathset_is_used(const LioPathSetSlot* const pSlot)
+{
+    return (pSlot->info & LIO_PATHSET_IS_USED) != 0;
+}
+
+
+
+static inline bool _lio_pathset_is_member(const LioPathSetSlot* const pSlot)
+{
+    return (pSlot->info & LIO_PATHSET_IS_MEMBER) != 0;
+}
+
+
+
+// Table sizes are not powers of two, so a hash is scaled into range
+static inline uint32_t _lio_pathset_home(const LioPathSet* const pSet, const uint32_t hash)
+{
+    return (uint32_t)(((uint64_t)hash * pSet->slotCapacity) >> 32);
+}
+
+
+
+static inline uint32_t _lio_pathset_next_slot(const LioPathSet* const pSet, const uint32_t slot)
+{
+    return (slot + 1u == pSet->slotCapacity) ? 0u : slot + 1u;
+}
+
+
+
+static inline uint32_t* _lio_pathset_first_child(LioPathSet* const pSet, const uint32_t node)
+{
+    return (node == LIO_PATHSET_ROOT) ? &pSet->firstChild : &pSet->pSlots[node].firstChild;
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Label accessors
+-----------------------------------------------------------------------------*/
+static inline LioPathView _lio_pathset_label(const LioPathSet* const pSet, const LioPathSetSlot* const pSlot)
+{
+    const size_t length = pSlot->info & LIO_PATHSET_MAX_LABEL;
+    uint32_t offset;
+
+    if (length <= LIO_PATHSET_INLINE_CHARS)
+    {
+        return lio_pathview_make_n(pSlot->label, length);
+    }
+
+    memcpy(&offset, pSlot->label, sizeof(offset));
+    return lio_pathview_make_n(pSet->pLabels + offset, length);
+}
+
+
+
+// Labels which are too long to keep in the slot must already be in the pool
+static inline void _lio_pathset_set_label(LioPathSet* const pSet, LioPathSetSlot* const pSlot, const char* const pChars, const uint32_t length)
+{
+    pSlot->info = (uint16_t)((pSlot->info & ~LIO_PATHSET_MAX_LABEL) | length);
+
+    if (length <= LIO_PATHSET_INLINE_CHARS)
+    {
+        memmove(pSlot->label, pChars, length);
+    }
+    else
+    {
+        const uint32_t offset = (uint32_t)(pChars - pSet->pLabels);
+        memcpy(pSlot->label, &offset, sizeof(offset));
+    }
+}
+
+
+
+// Components are short, so comparing them inline beats a call to memcmp()
+static inline bool _lio_pathset_chars_equal(const char* pA, const char* pB, size_t numChars)
+{
+    for (; numChars >= 8; numChars -= 8, pA += 8, pB += 8)
+    {
+        uint64_t a, b;
+        memcpy(&a, pA, sizeof(a));
+        memcpy(&b, pB, sizeof(b));
+
+        if (a != b)
+        {
+            return false;
+        }
+    }
+
+    while (numChars --> 0)
+    {
+        if (*pA++ != *pB++)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+
+// Determine if a component appears at an offset within a label
+static inline bool _lio_pathset_label_matches(const LioPathView label, const size_t offset, const LioPathView component)
+{
+    const size_t numChars = label.length - offset;
+
+    return numChars >= component.length
+        && (numChars == component.length || label.pData[offset + component.length] == LIO_PATH_SEP)
+        && _lio_pathset_chars_equal(label.pData + offset, component.pData, component.length);
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Retrieve the next component of a path being searched for, and add it to
+ * "pHash"
+ *
+ * A leading separator is returned as an empty component so absolute and
+ * relative paths remain distinct. Any other empty components are skipped.
+-----------------------------------------------------------------------------*/
+static inline bool _lio_pathset_next_component(const LioPathView path, size_t* const pOffset, LioPathView* const pOutComponent, uint64_t* const pHash)
+{
+    size_t offset = *pOffset;
+
+    if (offset == 0 && path.length && path.pData[0] == LIO_PATH_SEP)
+    {
+        *pOutComponent = lio_pathview_make_n(path.pData, 0);
+        *pOffset = 1;
+        *pHash = _lio_pathset_finish(*pHash, 0);
+        return true;
+    }
+
+    while (offset < path.length && path.pData[offset] == LIO_PATH_SEP)
+    {
+        ++offset;
+    }
+
+    if (offset >= path.length)
+    {
+        *pOffset = path.length;
+        return false;
+    }
+
+    *pOutComponent = lio_pathview_make_n(path.pData + offset, _lio_pathset_scan(path.pData + offset, path.length - offset, pHash));
+    *pOffset = offset + pOutComponent->length;
+
+    return true;
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Locate a child node by the first component of its label
+ *
+ * The index of the slot which holds the child, or the empty slot where it
+ * would be inserted, is returned in "pOutSlot".
+-----------------------------------------------------------------------------*/
+static bool _lio_pathset_find_child(
+    const LioPathSet* const pSet,
+    const uint32_t parent,
+    const LioPathView component,
+    const uint32_t hash,
+    uint32_t* const pOutSlot)
+{
+    for (uint32_t i = _lio_pathset_home(pSet, hash);; i = _lio_pathset_next_slot(pSet, i))
+    {
+        const LioPathSetSlot* const pSlot = pSet->pSlots + i;
+
+        if (!_lio_pathset_is_used(pSlot))
+        {
+            *pOutSlot = i;
+            return false;
+        }
+
+        if (pSlot->hash == hash && pSlot->parent == parent && _lio_pathset_label_matches(_lio_pathset_label(pSet, pSlot), 0, component))
+        {
+            *pOutSlot = i;
+            return true;
+        }
+    }
+}
+
+
+
+// Locate the slot for a node which cannot exist yet
+static uint32_t _lio_pathset_find_empty(const LioPathSet* const pSet, const uint32_t hash)
+{
+    uint32_t i = _lio_pathset_home(pSet, hash);
+
+    while (_lio_pathset_is_used(pSet->pSlots + i))
+    {
+        i = _lio_pathset_next_slot(pSet, i);
+    }
+
+    return i;
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Memory management
+-----------------------------------------------------------------------------*/
+static bool _lio_pathset_grow(void** ppData, uint32_t* const pCapacity, const size_t numRequired, const size_t elementSize, const size_t minCapacity)
+{
+    if (numRequired <= *pCapacity)
+    {
+        return true;
+    }
+
+    size_t newCapacity = *pCapacity ? *pCapacity : minCapacity;
+    while (newCapacity < numRequired)
+    {
+        newCapacity *= 2u;
+    }
+
+    if (newCapacity > UINT32_MAX)
+    {
+        newCapacity = UINT32_MAX;
+        if (newCapacity < numRequired)
+        {
+            return false;
+        }
+    }
+
+    void* const pNewData = lio_alloc_realloc(*ppData, *pCapacity * elementSize, newCapacity * elementSize);
+    if (!pNewData)
+    {
+        return false;
+    }
+
+    *ppData = pNewData;
+    *pCapacity = (uint32_t)newCapacity;
+
+    return true;
+}
+
+
+
+// Nodes are identified by their slots, so links are translated through the
+// old table, whose hashes are overwritten with each node's new slot.
+static inline uint32_t _lio_pathset_moved(const LioPathSetSlot* const pOldSlots, const uint32_t node)
+{
+    return (node >= LIO_PATHSET_ROOT) ? node : pOldSlots[node].hash;
+}
+
+
+
+static bool _lio_pathset_rehash(LioPathSet* const pSet, const uint32_t newCapacity)
+{
+    LioPathSetSlot* const pOldSlots = pSet->pSlots;
+    const uint32_t oldCapacity = pSet->slotCapacity;
+
+    pSet->pSlots = (LioPathSetSlot*)lio_alloc_calloc(newCapacity, sizeof(LioPathSetSlot));
+    if (!pSet->pSlots)
+    {
+        pSet->pSlots = pOldSlots;
+        return false;
+    }
+
+    pSet->slotCapacity = newCapacity;
+
+    for (uint32_t i = 0; i < oldCapacity; ++i)
+    {
+        LioPathSetSlot* const pOld = pOldSlots + i;
+
+        if (_lio_pathset_is_used(pOld))
+        {
+            const uint32_t j = _lio_pathset_find_empty(pSet, pOld->hash);
+            pSet->pSlots[j] = *pOld;
+            pOld->hash = j;
+        }
+    }
+
+    for (uint32_t i = 0; i < newCapacity; ++i)
+    {
+        LioPathSetSlot* const pSlot = pSet->pSlots + i;
+
+        if (_lio_pathset_is_used(pSlot))
+        {
+            pSlot->parent = _lio_pathset_moved(pOldSlots, pSlot->parent);
+            pSlot->firstChild = _lio_pathset_moved(pOldSlots, pSlot->firstChild);
+            pSlot->nextSibling = _lio_pathset_moved(pOldSlots, pSlot->nextSibling);
+        }
+    }
+
+    pSet->firstChild = _lio_pathset_moved(pOldSlots, pSet->firstChild);
+    lio_alloc_free(pOldSlots);
+
+    return true;
+}
+
+
+
+// An insertion adds at most a split node and a chain of new nodes. Reserving
+// space up front means an insertion can never fail halfway through.
+static bool _lio_pathset_reserve(LioPathSet* const pSet, const size_t numChars)
+{
+    if (!_lio_pathset_grow((void**)&pSet->pLabels, &pSet->labelsCapacity, (size_t)pSet->labelsLength + numChars + 1u, sizeof(char), LIO_PATHSET_MIN_LABELS))
+    {
+        return false;
+    }
+
+    // Keep the table under 80% full. It grows by half rather than doubling
+    // since every node is a slot.
+    const size_t numRequired = (size_t)pSet->numNodes + 2u + numChars / LIO_PATHSET_MAX_LABEL;
+    if (numRequired * 5u > (size_t)pSet->slotCapacity * 4u)
+    {
+        size_t newCapacity = pSet->slotCapacity ? pSet->slotCapacity : LIO_PATHSET_MIN_SLOTS;
+        while (numRequired * 5u > newCapacity * 4u)
+        {
+            newCapacity += newCapacity / 2u;
+        }
+
+        if (newCapacity >= LIO_PATHSET_ROOT || !_lio_pathset_rehash(pSet, (uint32_t)newCapacity))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Tree modification
+-----------------------------------------------------------------------------*/
+static void _lio_pathset_add_child(
+    LioPathSet* const pSet,
+    const uint32_t parent,
+    const uint32_t slot,
+    const uint32_t hash,
+    const char* const pLabel,
+    const uint32_t labelLength)
+{
+    uint32_t* const pFirstChild = _lio_pathset_first_child(pSet, parent);
+    LioPathSetSlot* const pSlot = pSet->pSlots + slot;
+
+    pSlot->hash = hash;
+    pSlot->parent = parent;
+    pSlot->firstChild = LIO_PATHSET_NONE;
+    pSlot->nextSibling = *pFirstChild;
+    pSlot->info = LIO_PATHSET_IS_USED;
+    _lio_pathset_set_label(pSet, pSlot, pLabel, labelLength);
+
+    *pFirstChild = slot;
+    ++pSet->numNodes;
+}
+
+
+
+// Split a node's label after "numChars" characters. The leading components
+// keep the node's slot, and its place among its siblings, since both share
+// the same key. The remainder moves to a new slot, keyed by "prefixHash", the
+// hash of every component up to the split, and takes the node's children.
+static void _lio_pathset_split(LioPathSet* const pSet, const uint32_t slot, const uint32_t numChars, const uint64_t prefixHash)
+{
+    LioPathSetSlot* const pSlot = pSet->pSlots + slot;
+    const LioPathView label = _lio_pathset_label(pSet, pSlot);
+    const LioPathView rest = lio_pathview_make_n(label.pData + numChars + 1u, label.length - numChars - 1u);
+    uint64_t restHash = prefixHash;
+    (void)_lio_pathset_scan(rest.pData, rest.length, &restHash);
+
+    const uint32_t hash = (uint32_t)restHash;
+    const uint32_t restSlot = _lio_pathset_find_empty(pSet, hash);
+    LioPathSetSlot* const pRest = pSet->pSlots + restSlot;
+
+    *pRest = *pSlot;
+    pRest->hash = hash;
+    pRest->parent = slot;
+    pRest->nextSibling = LIO_PATHSET_NONE;
+    _lio_pathset_set_label(pSet, pRest, rest.pData, (uint32_t)rest.length);
+
+    for (uint32_t child = pRest->firstChild; child != LIO_PATHSET_NONE; child = pSet->pSlots[child].nextSibling)
+    {
+        pSet->pSlots[child].parent = restSlot;
+    }
+
+    pSlot->firstChild = restSlot;
+    pSlot->info = LIO_PATHSET_IS_USED;
+    _lio_pathset_set_label(pSet, pSlot, label.pData, numChars);
+
+    ++pSet->numNodes;
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Find the node which matches a path
+ *
+ * When "allowPartial" is set, the path may end partway through a node's label
+ * and that node is returned.
+-----------------------------------------------------------------------------*/
+static uint32_t _lio_pathset_find(const LioPathSet* const pSet, const LioPathView path, const bool allowPartial)
+{
+    size_t offset = 0;
+    uint32_t node = LIO_PATHSET_ROOT;
+    uint64_t hash = 0;
+    LioPathView component;
+
+    if (!pSet->numNodes)
+    {
+        return LIO_PATHSET_NONE;
+    }
+
+    if (!_lio_pathset_next_component(path, &offset, &component, &hash))
+    {
+        return allowPartial ? LIO_PATHSET_ROOT : LIO_PATHSET_NONE;
+    }
+
+    for (;;)
+    {
+        uint32_t slot = 0;
+
+        if (!_lio_pathset_find_child(pSet, node, component, (uint32_t)hash, &slot))
+        {
+            return LIO_PATHSET_NONE;
+        }
+
+        const LioPathSetSlot* const pSlot = pSet->pSlots + slot;
+        const LioPathView label = _lio_pathset_label(pSet, pSlot);
+        size_t labelOffset = component.length;
+        bool hasMore = _lio_pathset_next_component(path, &offset, &component, &hash);
+
+        while (labelOffset < label.length && hasMore)
+        {
+            if (!_lio_pathset_label_matches(label, labelOffset + 1, component))
+            {
+                return LIO_PATHSET_NONE;
+            }
+
+            labelOffset += 1 + component.length;
+            hasMore = _lio_pathset_next_component(path, &offset, &component, &hash);
+        }
+
+        if (!hasMore)
+        {
+            if (labelOffset == label.length)
+            {
+                return (allowPartial || _lio_pathset_is_member(pSlot)) ? slot : LIO_PATHSET_NONE;
+            }
+
+            return allowPartial ? slot : LIO_PATHSET_NONE;
+        }
+
+        node = slot;
+    }
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Lifecycle
+-----------------------------------------------------------------------------*/
+void lio_pathset_init(LioPathSet* const pSet)
+{
+    memset(pSet, 0, sizeof(LioPathSet));
+    pSet->firstChild = LIO_PATHSET_NONE;
+}
+
+
+
+void lio_pathset_terminate(LioPathSet* const pSet)
+{
+    if (pSet)
+    {
+        lio_alloc_free(pSet->pSlots);
+        lio_alloc_free(pSet->pLabels);
+        lio_pathset_init(pSet);
+    }
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Insertion
+-----------------------------------------------------------------------------*/
+/*-------------------------------------
+ * Add the remaining components of a path below "parent", starting with
+ * "component", which belongs in "slot". Components are merged into as few
+ * labels as their length allows.
+------------------------------------*/
+static bool _lio_pathset_add_path(
+    LioPathSet* const pSet,
+    uint32_t parent,
+    uint32_t slot,
+    uint64_t hash,
+    const LioPathView path,
+    size_t offset,
+    LioPathView component)
+{
+    // Check every component fits in a label before adding any of them
+    {
+        size_t nextOffset = offset;
+        uint64_t nextHash = hash;
+        LioPathView next = component;
+
+        do
+        {
+            if (next.length > LIO_PATHSET_MAX_LABEL)
+            {
+                lio_error_report(LIO_ERROR_INVALID_ARGUMENT, 0, "Unable to store a path component this long", path.pData, NULL);
+                return false;
+            }
+        }
+        while (_lio_pathset_next_component(path, &nextOffset, &next, &nextHash));
+    }
+
+    for (;;)
+    {
+        // Labels are built in the pool, and only kept there if they are too
+        // long to fit in their slot.
+        char* const pLabel = pSet->pLabels + pSet->labelsLength;
+        const uint32_t key = (uint32_t)hash;
+        size_t labelLength = component.length;
+        bool hasMore;
+
+        memcpy(pLabel, component.pData, component.length);
+
+        while ((hasMore = _lio_pathset_next_component(path, &offset, &component, &hash))
+        && labelLength + 1u + component.length <= LIO_PATHSET_MAX_LABEL)
+        {
+            pLabel[labelLength++] = LIO_PATH_SEP;
+            memcpy(pLabel + labelLength, component.pData, component.length);
+            labelLength += component.length;
+        }
+
+        _lio_pathset_add_child(pSet, parent, slot, key, pLabel, (uint32_t)labelLength);
+        pSet->labelsLength += (labelLength > LIO_PATHSET_INLINE_CHARS) ? (uint32_t)labelLength : 0u;
+
+        if (!hasMore)
+        {
+            pSet->pSlots[slot].info |= LIO_PATHSET_IS_MEMBER;
+            ++pSet->numPaths;
+            return true;
+        }
+
+        parent = slot;
+        slot = _lio_pathset_find_empty(pSet, (uint32_t)hash);
+    }
+}
+
+
+
+bool lio_pathset_insert(LioPathSet* const pSet, const char* const pPath)
+{
+    const LioPathView path = lio_pathview_make(pPath);
+    size_t offset = 0;
+    uint32_t node = LIO_PATHSET_ROOT;
+    uint64_t hash = 0;
+    LioPathView component;
+
+    if (!_lio_pathset_next_component(path, &offset, &component, &hash))
+    {
+        return false;
+    }
+
+    if (!_lio_pathset_reserve(pSet, path.length))
+    {
+        lio_error_report(LIO_ERROR_OUT_OF_MEMORY, 0, "Unable to allocate memory for a path", pPath, NULL);
+        return false;
+    }
+
+    for (;;)
+    {
+        uint32_t slot = 0;
+
+        if (!_lio_pathset_find_child(pSet, node, component, (uint32_t)hash, &slot))
+        {
+            return _lio_pathset_add_path(pSet, node, slot, hash, path, offset, component);
+        }
+
+        // Components are hashed as they are read, so the hash up to the last
+        // matching one is kept in case the label needs to be split there
+        const LioPathView label = _lio_pathset_label(pSet, pSet->pSlots + slot);
+        size_t labelOffset = component.length;
+        uint64_t prefixHash = hash;
+        bool hasMore = _lio_pathset_next_component(path, &offset, &component, &hash);
+
+        while (labelOffset < label.length && hasMore)
+        {
+            if (!_lio_pathset_label_matches(label, labelOffset + 1, component))
+            {
+                break;
+            }
+
+            labelOffset += 1 + component.length;
+            prefixHash = hash;
+            hasMore = _lio_pathset_next_component(path, &offset, &component, &hash);
+        }
+
+        // A split node keeps the slot, so "slot" refers to it either way
+        if (labelOffset < label.length)
+        {
+            _lio_pathset_split(pSet, slot, (uint32_t)labelOffset, prefixHash);
+        }
+
+        if (!hasMore)
+        {
+            LioPathSetSlot* const pSlot = pSet->pSlots + slot;
+            pSet->numPaths += _lio_pathset_is_member(pSlot) ? 0 : 1;
+            pSlot->info |= LIO_PATHSET_IS_MEMBER;
+            return true;
+        }
+
+        node = slot;
+    }
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Membership
+-----------------------------------------------------------------------------*/
+bool lio_pathset_contains(const LioPathSet* const pSet, const char* const pPath)
+{
+    return _lio_pathset_find(pSet, lio_pathview_make(pPath), false) != LIO_PATHSET_NONE;
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Iteration
+-----------------------------------------------------------------------------*/
+typedef struct LioPathSetSortEntry
+{
+    const char* pLabel;
+    uint32_t length;
+    uint32_t node;
+} LioPathSetSortEntry;
+
+typedef struct LioPathSetVisit
+{
+    const LioPathSet* pSet;
+    LioStrBuf path;
+    LioPathSetSortEntry* pEntries;
+    uint32_t numEntries;
+    uint32_t entryCapacity;
+    bool sorted;
+    LioPathSetVisitor visitor;
+    void* pUserData;
+} LioPathSetVisit;
+
+
+
+static int _lio_pathset_compare(const void* pA, const void* pB)
+{
+    const LioPathSetSortEntry* const a = (const LioPathSetSortEntry*)pA;
+    const LioPathSetSortEntry* const b = (const LioPathSetSortEntry*)pB;
+    const int cmp = memcmp(a->pLabel, b->pLabel, (a->length < b->length) ? a->length : b->length);
+
+    return cmp ? cmp : ((a->length > b->length) - (a->length < b->length));
+}
+
+
+
+static bool _lio_pathset_append_path(LioPathSetVisit* const pVisit, const uint32_t node)
+{
+    if (node == LIO_PATHSET_ROOT)
+    {
+        return true;
+    }
+
+    const LioPathSetSlot* const pSlot = pVisit->pSet->pSlots + node;
+    const LioPathView label = _lio_pathset_label(pVisit->pSet, pSlot);
+
+    if (!_lio_pathset_append_path(pVisit, pSlot->parent))
+    {
+        return false;
+    }
+
+    if (pSlot->parent != LIO_PATHSET_ROOT && !lio_strbuf_append_char(&pVisit->path, LIO_PATH_SEP))
+    {
+        return false;
+    }
+
+    return lio_strbuf_append_n(&pVisit->path, label.pData, label.length);
+}
+
+
+
+static bool _lio_pathset_visit(LioPathSetVisit* const pVisit, const uint32_t node)
+{
+    const LioPathSetSlot* const pSlots = pVisit->pSet->pSlots;
+    const size_t pathLength = pVisit->path.length;
+
+    if (node != LIO_PATHSET_ROOT && _lio_pathset_is_member(pSlots + node))
+    {
+        // Only the root directory has an empty path
+        static const char rootPath[2] = {LIO_PATH_SEP, '\0'};
+        const bool isRoot = pathLength == 0;
+
+        if (!pVisit->visitor(isRoot ? rootPath : lio_strbuf_cstr(&pVisit->path), isRoot ? 1 : pathLength, pVisit->pUserData))
+        {
+            return false;
+        }
+    }
+
+    const uint32_t firstEntry = pVisit->numEntries;
+    uint32_t numChildren = 0;
+
+    const uint32_t firstChild = (node == LIO_PATHSET_ROOT) ? pVisit->pSet->firstChild : pSlots[node].firstChild;
+
+    for (uint32_t child = firstChild; child != LIO_PATHSET_NONE; child = pSlots[child].nextSibling)
+    {
+        const LioPathView label = _lio_pathset_label(pVisit->pSet, pSlots + child);
+
+        if (!pVisit->sorted)
+        {
+            if ((node != LIO_PATHSET_ROOT && !lio_strbuf_append_char(&pVisit->path, LIO_PATH_SEP))
+            || !lio_strbuf_append_n(&pVisit->path, label.pData, label.length)
+            || !_lio_pathset_visit(pVisit, child))
+            {
+                return false;
+            }
+
+            lio_strbuf_truncate(&pVisit->path, pathLength);
+            continue;
+        }
+
+        if (!_lio_pathset_grow((void**)&pVisit->pEntries, &pVisit->entryCapacity, (size_t)pVisit->numEntries + 1u, sizeof(LioPathSetSortEntry), LIO_PATHSET_MIN_ENTRIES))
+        {
+            return false;
+        }
+
+        LioPathSetSortEntry* const pEntry = pVisit->pEntries + pVisit->numEntries++;
+        pEntry->pLabel = label.pData;
+        pEntry->length = (uint32_t)label.length;
+        pEntry->node = child;
+        ++numChildren;
+    }
+
+    if (!numChildren)
+    {
+        return true;
+    }
+
+    qsort(pVisit->pEntries + firstEntry, numChildren, sizeof(LioPathSetSortEntry), &_lio_pathset_compare);
+
+    // Entries are re-read by index since deeper levels may move the array
+    for (uint32_t i = 0; i < numChildren; ++i)
+    {
+        const LioPathSetSortEntry entry = pVisit->pEntries[firstEntry + i];
+
+        if ((node != LIO_PATHSET_ROOT && !lio_strbuf_append_char(&pVisit->path, LIO_PATH_SEP))
+        || !lio_strbuf_append_n(&pVisit->path, entry.pLabel, entry.length)
+        || !_lio_pathset_visit(pVisit, entry.node))
+        {
+            return false;
+        }
+
+        lio_strbuf_truncate(&pVisit->path, pathLength);
+    }
+
+    pVisit->numEntries = firstEntry;
+
+    return true;
+}
+
+
+
+bool lio_pathset_iterate(
+    const LioPathSet* const pSet,
+    const char* const pPrefix,
+    const bool sorted,
+    LioPathSetVisitor visitor,
+    void* pUserData)
+{
+    if (!visitor)
+    {
+        return false;
+    }
+
+    const uint32_t node = _lio_pathset_find(pSet, lio_pathview_make(pPrefix), true);
+    if (node == LIO_PATHSET_NONE)
+    {
+        return true;
+    }
+
+    LioPathSetVisit visit;
+    visit.pSet = pSet;
+    visit.pEntries = NULL;
+    visit.numEntries = 0;
+    visit.entryCapacity = 0;
+    visit.sorted = sorted;
+    visit.visitor = visitor;
+    visit.pUserData = pUserData;
+    lio_strbuf_init(&visit.path);
+
+    const bool ret = _lio_pathset_append_path(&visit, node) && _lio_pathset_visit(&visit, node);
+
+    lio_alloc_free(visit.pEntries);
+    lio_strbuf_terminate(&visit.path);
+
+    return ret;
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Memory usage
+-----------------------------------------------------------------------------*/
+size_t lio_pathset_memory_usage(const LioPathSet* const pSet)
+{
+    return sizeof(LioPathSet)
+        + (size_t)pSet->slotCapacity * sizeof(LioPathSetSlot)
+        + (size_t)pSet->labelsCapacity;
+}
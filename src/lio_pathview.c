@@ -0,0 +1,364 @@
+
+#include "light_io/lio_pathview.h"
+
+#if defined(__GNUC__) && defined(__SSE2__)
+    #define LIO_PATHVIEW_X86
+    #include <immintrin.h> // _mm_cmpeq_epi8(...), _mm256_cmpeq_epi8(...)
+#elif defined(__GNUC__) && defined(__aarch64__) && defined(__ARM_NEON)
+    #define LIO_PATHVIEW_NEON
+    #include <arm_neon.h> // vceqq_u8(...), vmaxvq_u8(...)
+#endif
+
+
+
+/*-----------------------------------------------------------------------------
+ * Vectorized separator scanning
+ *
+ * Each kernel returns the index of the first (or last) separator it found, or
+ * the number of characters it has ruled out so the scalar loop can finish the
+ * remainder.
+-----------------------------------------------------------------------------*/
+#if defined(LIO_PATHVIEW_X86)
+
+__attribute__((target("avx2")))
+static size_t _lio_pathview_find_avx2(const char* pPath, const size_t length, bool* pFound)
+{
+    const __m256i sep = _mm256_set1_epi8(LIO_PATH_SEP);
+    size_t i = 0;
+
+    for (; i + 32 <= length; i += 32)
+    {
+        const __m256i v = _mm256_loadu_si256((const __m256i*)(pPath + i));
+        const unsigned mask = (unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, sep));
+
+        if (mask)
+        {
+            *pFound = true;
+            return i + (size_t)__builtin_ctz(mask);
+        }
+    }
+
+    return i;
+}
+
+
+
+__attribute__((target("avx2")))
+static size_t _lio_pathview_rfind_avx2(const char* pPath, size_t length, bool* pFound)
+{
+    const __m256i sep = _mm256_set1_epi8(LIO_PATH_SEP);
+
+    for (; length >= 32; length -= 32)
+    {
+        const __m256i v = _mm256_loadu_si256((const __m256i*)(pPath + length - 32));
+        const unsigned mask = (unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, sep));
+
+        if (mask)
+        {
+            *pFound = true;
+            return length - 1 - (size_t)__builtin_clz(mask);
+        }
+    }
+
+    return length;
+}
+
+
+
+static size_t _lio_pathview_find_simd(const char* pPath, const size_t length, bool* pFound)
+{
+    const __m128i sep = _mm_set1_epi8(LIO_PATH_SEP);
+    size_t i = 0;
+
+    // Most components are short, so the first block is checked before
+    // paying for dispatch to the wider kernel
+    if (length >= 16)
+    {
+        const unsigned mask = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)pPath), sep));
+
+        if (mask)
+        {
+            *pFound = true;
+            return (size_t)__builtin_ctz(mask);
+        }
+
+        i = 16;
+    }
+
+    if (length - i >= 64 && __builtin_cpu_supports("avx2"))
+    {
+        i += _lio_pathview_find_avx2(pPath + i, length - i, pFound);
+        if (*pFound)
+        {
+            return i;
+        }
+    }
+
+    for (; i + 16 <= length; i += 16)
+    {
+        const __m128i v = _mm_loadu_si128((const __m128i*)(pPath + i));
+        const unsigned mask = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(v, sep));
+
+        if (mask)
+        {
+            *pFound = true;
+            return i + (size_t)__builtin_ctz(mask);
+        }
+    }
+
+    return i;
+}
+
+
+
+static size_t _lio_pathview_rfind_simd(const char* pPath, size_t length, bool* pFound)
+{
+    const __m128i sep = _mm_set1_epi8(LIO_PATH_SEP);
+
+    if (length >= 16)
+    {
+        const unsigned mask = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(pPath + length - 16)), sep));
+
+        if (mask)
+        {
+            *pFound = true;
+            return length - 1 - (size_t)(__builtin_clz(mask) - 16);
+        }
+
+        length -= 16;
+    }
+
+    if (length >= 64 && __builtin_cpu_supports("avx2"))
+    {
+        length = _lio_pathview_rfind_avx2(pPath, length, pFound);
+        if (*pFound)
+        {
+            return length;
+        }
+    }
+
+    for (; length >= 16; length -= 16)
+    {
+        const __m128i v = _mm_loadu_si128((const __m128i*)(pPath + length - 16));
+        const unsigned mask = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(v, sep));
+
+        if (mask)
+        {
+            *pFound = true;
+            return length - 1 - (size_t)(__builtin_clz(mask) - 16);
+        }
+    }
+
+    return length;
+}
+
+#elif defined(LIO_PATHVIEW_NEON)
+
+// NEON lacks a movemask, so matching blocks are handed to the scalar loop
+static size_t _lio_pathview_find_simd(const char* pPath, const size_t length, bool* pFound)
+{
+    const uint8x16_t sep = vdupq_n_u8((uint8_t)LIO_PATH_SEP);
+    size_t i = 0;
+
+    (void)pFound;
+
+    for (; i + 16 <= length; i += 16)
+    {
+        if (vmaxvq_u8(vceqq_u8(vld1q_u8((const uint8_t*)(pPath + i)), sep)))
+        {
+            break;
+        }
+    }
+
+    return i;
+}
+
+
+
+static size_t _lio_pathview_rfind_simd(const char* pPath, size_t length, bool* pFound)
+{
+    const uint8x16_t sep = vdupq_n_u8((uint8_t)LIO_PATH_SEP);
+
+    (void)pFound;
+
+    for (; length >= 16; length -= 16)
+    {
+        if (vmaxvq_u8(vceqq_u8(vld1q_u8((const uint8_t*)(pPath + length - 16)), sep)))
+        {
+            break;
+        }
+    }
+
+    return length;
+}
+
+#else
+
+static size_t _lio_pathview_find_simd(const char* pPath, const size_t length, bool* pFound)
+{
+    (void)pPath;
+    (void)length;
+    (void)pFound;
+    return 0;
+}
+
+
+
+static size_t _lio_pathview_rfind_simd(const char* pPath, size_t length, bool* pFound)
+{
+    (void)pPath;
+    (void)pFound;
+    return length;
+}
+
+#endif
+
+
+
+/*-----------------------------------------------------------------------------
+ * Separator scanning
+-----------------------------------------------------------------------------*/
+size_t lio_pathview_find_sep(const char* const pPath, const size_t length)
+{
+    bool found = false;
+    size_t i = _lio_pathview_find_simd(pPath, length, &found);
+
+    if (found)
+    {
+        return i;
+    }
+
+    for (; i < length; ++i)
+    {
+        if (pPath[i] == LIO_PATH_SEP)
+        {
+            return i;
+        }
+    }
+
+    return length;
+}
+
+
+
+size_t lio_pathview_rfind_sep(const char* const pPath, const size_t length)
+{
+    bool found = false;
+    size_t iter = _lio_pathview_rfind_simd(pPath, length, &found);
+
+    if (found)
+    {
+        return iter;
+    }
+
+    while (iter --> 0)
+    {
+        if (pPath[iter] == LIO_PATH_SEP)
+        {
+            return iter;
+        }
+    }
+
+    return length;
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Path components
+-----------------------------------------------------------------------------*/
+LioPathView lio_pathview_basename(const LioPathView path)
+{
+    const size_t sepIndex = lio_pathview_rfind_sep(path.pData, path.length);
+
+    if (sepIndex == path.length)
+    {
+        return path;
+    }
+
+    return lio_pathview_make_n(path.pData + sepIndex + 1, path.length - sepIndex - 1);
+}
+
+
+
+LioPathView lio_pathview_dirname(const LioPathView path)
+{
+    const size_t sepIndex = lio_pathview_rfind_sep(path.pData, path.length);
+
+    return lio_pathview_make_n(path.pData, (sepIndex == path.length) ? 0 : sepIndex);
+}
+
+
+
+LioPathView lio_pathview_extension(const LioPathView path)
+{
+    const LioPathView base = lio_pathview_basename(path);
+    size_t iter = base.length;
+
+    while (iter --> 1)
+    {
+        if (base.pData[iter] == '.')
+        {
+            return lio_pathview_make_n(base.pData + iter, base.length - iter);
+        }
+    }
+
+    return lio_pathview_make_n(base.pData + base.length, 0);
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Component iteration
+-----------------------------------------------------------------------------*/
+bool lio_pathiter_next(LioPathIter* const pIter, LioPathView* const pOutComponent)
+{
+    const char* const pData = pIter->pData;
+    size_t front = pIter->front;
+
+    while (front < pIter->back && pData[front] == LIO_PATH_SEP)
+    {
+        ++front;
+    }
+
+    if (front >= pIter->back)
+    {
+        pIter->front = pIter->back;
+        return false;
+    }
+
+    const size_t end = front + lio_pathview_find_sep(pData + front, pIter->back - front);
+
+    *pOutComponent = lio_pathview_make_n(pData + front, end - front);
+    pIter->front = end;
+
+    return true;
+}
+
+
+
+bool lio_pathiter_prev(LioPathIter* const pIter, LioPathView* const pOutComponent)
+{
+    const char* const pData = pIter->pData;
+    size_t back = pIter->back;
+
+    while (back > pIter->front && pData[back-1] == LIO_PATH_SEP)
+    {
+        --back;
+    }
+
+    if (back <= pIter->front)
+    {
+        pIter->back = pIter->front;
+        return false;
+    }
+
+    const size_t numChars = back - pIter->front;
+    const size_t sepIndex = lio_pathview_rfind_sep(pData + pIter->front, numChars);
+    const size_t start = (sepIndex == numChars) ? pIter->front : (pIter->front + sepIndex + 1);
+
+    *pOutComponent = lio_pathview_make_n(pData + start, back - start);
+    pIter->back = start;
+
+    return true;
+}
@@ -0,0 +1,134 @@
+
+#include <string.h> // memcmp()
+
+#include "light_io/lio_alloc.h"
+#include "light_io/lio_error.h"
+#include "light_io/lio_files.h"
+#include "light_io/lio_record.h"
+
+
+
+/*-----------------------------------------------------------------------------
+ * Playback
+-----------------------------------------------------------------------------*/
+bool lio_record_reader_open(LioRecordReader* const pReader, const char* const pPath)
+{
+    static const char magic[8] = {'L', 'I', 'O', 'R', 'E', 'C', '\0', '\0'};
+
+    if (!pReader || !pPath)
+    {
+        lio_error_report(LIO_ERROR_INVALID_ARGUMENT, 0, "Unable to open a recording without a path", NULL, NULL);
+        return false;
+    }
+
+    memset(pReader, 0, sizeof(LioRecordReader));
+
+    if (!lio_file_open(&pReader->file, pPath, LIO_FILE_OPEN_READ))
+    {
+        return false;
+    }
+
+    if (!lio_binreader_init_file(&pReader->reader, &pReader->file, 0, LIO_BYTE_ORDER_LITTLE))
+    {
+        lio_file_close(&pReader->file);
+        return false;
+    }
+
+    LioBinReader* const pBin = &pReader->reader;
+
+    if (!lio_binreader_require(pBin, LIO_RECORD_HEADER_SIZE)
+    || memcmp(pBin->pData + pBin->pos, magic, sizeof(magic)) != 0
+    || !lio_binreader_skip(pBin, sizeof(magic))
+    || lio_binreader_get_u32(pBin) != LIO_RECORD_VERSION)
+    {
+        lio_error_report(LIO_ERROR_CORRUPT, 0, "Unable to read a recording header", pPath, NULL);
+        lio_record_reader_close(pReader);
+        return false;
+    }
+
+    lio_binreader_get_u32(pBin); // reserved
+
+    return true;
+}
+
+
+
+bool lio_record_reader_next(LioRecordReader* const pReader, LioRecordEntry* const pOutEntry)
+{
+    LioBinReader* const pBin = &pReader->reader;
+
+    if (!lio_binreader_require(pBin, LIO_RECORD_ENTRY_SIZE))
+    {
+        // A partial entry means the recording was cut short
+        if (pBin->size != pBin->pos)
+        {
+            lio_error_report(LIO_ERROR_CORRUPT, 0, "A recording ends with a partial entry", NULL, NULL);
+        }
+        return false;
+    }
+
+    pOutEntry->op = lio_binreader_get_u16(pBin);
+    lio_binreader_get_u16(pBin);
+    pOutEntry->threadId = lio_binreader_get_u32(pBin);
+
+    const size_t pathLength = lio_binreader_get_u32(pBin);
+    const size_t otherLength = lio_binreader_get_u32(pBin);
+
+    pOutEntry->startNs = lio_binreader_get_u64(pBin);
+    pOutEntry->durationNs = lio_binreader_get_u64(pBin);
+    pOutEntry->args[0] = lio_binreader_get_u64(pBin);
+    pOutEntry->args[1] = lio_binreader_get_u64(pBin);
+    pOutEntry->args[2] = lio_binreader_get_u64(pBin);
+    pOutEntry->bytesRead = lio_binreader_get_u64(pBin);
+    pOutEntry->bytesWritten = lio_binreader_get_u64(pBin);
+    pOutEntry->result = lio_binreader_get_s64(pBin);
+
+    // Both paths share one buffer, each with its own terminator
+    const size_t numBytes = pathLength + otherLength + 2;
+    if (numBytes > pReader->capacity)
+    {
+        char* const pStrings = (char*)lio_alloc_realloc(pReader->pStrings, pReader->capacity, numBytes);
+        if (!pStrings)
+        {
+            lio_error_report(LIO_ERROR_OUT_OF_MEMORY, 0, "Unable to allocate the paths of a recorded call", NULL, NULL);
+            return false;
+        }
+
+        pReader->pStrings = pStrings;
+        pReader->capacity = numBytes;
+    }
+
+    char* const pPath = pReader->pStrings;
+    char* const pOther = pPath + pathLength + 1;
+
+    if (!lio_binreader_read_bytes(pBin, pPath, pathLength)
+    || !lio_binreader_read_bytes(pBin, pOther, otherLength))
+    {
+        lio_error_report(LIO_ERROR_CORRUPT, 0, "A recording ends with a partial entry", NULL, NULL);
+        return false;
+    }
+
+    pPath[pathLength] = '\0';
+    pOther[otherLength] = '\0';
+    pOutEntry->pPath = pPath;
+    pOutEntry->pOtherPath = pOther;
+
+    return true;
+}
+
+
+
+void lio_record_reader_close(LioRecordReader* const pReader)
+{
+    if (!pReader)
+    {
+        return;
+    }
+
+    lio_binreader_terminate(&pReader->reader);
+    lio_file_close(&pReader->file);
+    lio_alloc_free(pReader->pStrings);
+
+    pReader->pStrings = NULL;
+    pReader->capacity = 0;
+}
@@ -0,0 +1,198 @@
+
+// expose clock_gettime()
+#ifndef _GNU_SOURCE
+    #define _GNU_SOURCE
+#endif
+
+#include <pthread.h>
+#include <time.h> // clock_gettime()
+
+#include <stdatomic.h>
+#include <string.h> // strlen()
+
+#include "light_io/lio_error.h"
+#include "light_io/lio_files.h"
+#include "light_io/lio_record.h"
+
+
+
+/*-----------------------------------------------------------------------------
+ * Recorder state
+ *
+ * Every thread appends to the same writer under a lock. The lock is only
+ * taken once a call has completed, so the calls themselves still overlap.
+-----------------------------------------------------------------------------*/
+static atomic_bool _lioRecordEnabled = false;
+
+static pthread_mutex_t _lioRecordLock = PTHREAD_MUTEX_INITIALIZER;
+static LioFile _lioRecordFile;
+static LioBinWriter _lioRecordWriter;
+static uint64_t _lioRecordStartNs = 0;
+static long long _lioRecordNumEntries = 0;
+static atomic_uint _lioRecordNumThreads = 0;
+
+static _Thread_local uint32_t _lioRecordThreadId = 0;
+
+// Set while a thread writes an entry, so the writes made by the recorder are
+// not recorded themselves.
+static _Thread_local bool _lioRecordBusy = false;
+
+
+
+#if defined(LIGHT_IO_ENABLE_STATS)
+/*-------------------------------------
+ * Monotonic time, matching lio_stats_begin()
+-------------------------------------*/
+static uint64_t _lio_record_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+#endif
+
+
+
+/*-----------------------------------------------------------------------------
+ * Control
+-----------------------------------------------------------------------------*/
+bool lio_record_start(const char* const pPath)
+{
+    #if defined(LIGHT_IO_ENABLE_STATS)
+        static const char magic[8] = {'L', 'I', 'O', 'R', 'E', 'C', '\0', '\0'};
+        bool ret = false;
+
+        if (!pPath)
+        {
+            lio_error_report(LIO_ERROR_INVALID_ARGUMENT, 0, "Unable to record without a path", NULL, NULL);
+            return false;
+        }
+
+        pthread_mutex_lock(&_lioRecordLock);
+
+        if (atomic_load(&_lioRecordEnabled))
+        {
+            lio_error_report(LIO_ERROR_INVALID_ARGUMENT, 0, "A recording is already running", pPath, NULL);
+        }
+        else if (lio_file_open(&_lioRecordFile, pPath, LIO_FILE_OPEN_WRITE | LIO_FILE_OPEN_CREATE | LIO_FILE_OPEN_TRUNCATE))
+        {
+            if (lio_binwriter_init_file(&_lioRecordWriter, &_lioRecordFile, 0, LIO_BYTE_ORDER_LITTLE))
+            {
+                lio_binwriter_write_bytes(&_lioRecordWriter, magic, sizeof(magic));
+                lio_binwriter_reserve(&_lioRecordWriter, 8);
+                lio_binwriter_put_u32(&_lioRecordWriter, LIO_RECORD_VERSION);
+                lio_binwriter_put_u32(&_lioRecordWriter, 0);
+
+                _lioRecordStartNs = _lio_record_now();
+                _lioRecordNumEntries = 0;
+                atomic_store(&_lioRecordEnabled, true);
+                ret = true;
+            }
+            else
+            {
+                lio_file_close(&_lioRecordFile);
+            }
+        }
+
+        pthread_mutex_unlock(&_lioRecordLock);
+
+        return ret;
+    #else
+        (void)pPath;
+        return false;
+    #endif
+}
+
+
+
+long long lio_record_stop(void)
+{
+    long long ret = -1;
+
+    pthread_mutex_lock(&_lioRecordLock);
+
+    if (atomic_load(&_lioRecordEnabled))
+    {
+        atomic_store(&_lioRecordEnabled, false);
+
+        _lioRecordBusy = true;
+        const bool written = lio_binwriter_terminate(&_lioRecordWriter);
+        const bool closed = lio_file_close(&_lioRecordFile);
+        _lioRecordBusy = false;
+
+        if (written && closed)
+        {
+            ret = _lioRecordNumEntries;
+        }
+        else
+        {
+            lio_error_report(LIO_ERROR_IO, 0, "Unable to write a recording", NULL, NULL);
+        }
+    }
+
+    pthread_mutex_unlock(&_lioRecordLock);
+
+    return ret;
+}
+
+
+
+bool lio_record_is_enabled(void)
+{
+    return !_lioRecordBusy && atomic_load_explicit(&_lioRecordEnabled, memory_order_relaxed);
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Recording
+-----------------------------------------------------------------------------*/
+void lio_record_call(const LioRecordEntry* const pEntry)
+{
+    const size_t pathLength = strlen(pEntry->pPath);
+    const size_t otherLength = strlen(pEntry->pOtherPath);
+
+    if (!_lioRecordThreadId)
+    {
+        _lioRecordThreadId = atomic_fetch_add(&_lioRecordNumThreads, 1) + 1;
+    }
+
+    pthread_mutex_lock(&_lioRecordLock);
+
+    // Recording may have stopped while the call ran
+    if (!atomic_load_explicit(&_lioRecordEnabled, memory_order_relaxed))
+    {
+        pthread_mutex_unlock(&_lioRecordLock);
+        return;
+    }
+
+    LioBinWriter* const pWriter = &_lioRecordWriter;
+    const uint64_t startNs = pEntry->startNs > _lioRecordStartNs ? (pEntry->startNs - _lioRecordStartNs) : 0;
+
+    _lioRecordBusy = true;
+
+    if (lio_binwriter_reserve(pWriter, LIO_RECORD_ENTRY_SIZE))
+    {
+        lio_binwriter_put_u16(pWriter, pEntry->op);
+        lio_binwriter_put_u16(pWriter, 0);
+        lio_binwriter_put_u32(pWriter, _lioRecordThreadId);
+        lio_binwriter_put_u32(pWriter, (uint32_t)pathLength);
+        lio_binwriter_put_u32(pWriter, (uint32_t)otherLength);
+        lio_binwriter_put_u64(pWriter, startNs);
+        lio_binwriter_put_u64(pWriter, pEntry->durationNs);
+        lio_binwriter_put_u64(pWriter, pEntry->args[0]);
+        lio_binwriter_put_u64(pWriter, pEntry->args[1]);
+        lio_binwriter_put_u64(pWriter, pEntry->args[2]);
+        lio_binwriter_put_u64(pWriter, pEntry->bytesRead);
+        lio_binwriter_put_u64(pWriter, pEntry->bytesWritten);
+        lio_binwriter_put_s64(pWriter, pEntry->result);
+
+        lio_binwriter_write_bytes(pWriter, pEntry->pPath, pathLength);
+        lio_binwriter_write_bytes(pWriter, pEntry->pOtherPath, otherLength);
+        ++_lioRecordNumEntries;
+    }
+
+    _lioRecordBusy = false;
+
+    pthread_mutex_unlock(&_lioRecordLock);
+}
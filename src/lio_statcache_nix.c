@@ -0,0 +1,579 @@
+
+// expose clock_gettime()
+#ifndef _GNU_SOURCE
+    #define _GNU_SOURCE
+#endif
+
+#include <limits.h> // PATH_MAX
+#include <pthread.h>
+#include <time.h> // clock_gettime()
+#include <unistd.h> // getcwd()
+
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h> // memcmp(), memcpy(), memset(), strcpy(), strlen()
+
+#include "light_io/lio_alloc.h"
+#include "light_io/lio_error.h"
+#include "light_io/lio_paths.h"
+#include "light_io/lio_statcache.h"
+
+
+
+/*-----------------------------------------------------------------------------
+ * Cache structures
+ *
+ * Paths are hashed to a shard, then to a slot within it. Each path may live
+ * in any of the LIO_STAT_CACHE_WAYS slots following its own, so lookups never
+ * search further than that and slots can be emptied without tombstones.
+-----------------------------------------------------------------------------*/
+typedef struct LioStatCacheSlot
+{
+    char* pPath; // NULL if the slot is empty
+    size_t pathLength;
+    uint64_t hash;
+    uint64_t generation;
+    uint64_t storedTime;
+    uint64_t lastUsed;
+    LioStatCacheEntry entry;
+} LioStatCacheSlot;
+
+typedef struct LioStatCacheShard
+{
+    pthread_mutex_t lock;
+    LioStatCacheSlot* pSlots;
+    size_t numSlots;
+    uint64_t tick;
+    uint64_t epoch; // Advanced by every invalidation which may touch the shard
+
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t invalidations;
+    uint64_t evictions;
+} LioStatCacheShard;
+
+static LioStatCacheShard* _pLioStatCache = NULL;
+static atomic_bool _lioStatCacheEnabled = false;
+static atomic_uint_fast64_t _lioStatCacheGeneration = 1;
+static uint64_t _lioStatCacheTtl = 0;
+
+
+
+/*-----------------------------------------------------------------------------
+ * Helpers
+-----------------------------------------------------------------------------*/
+static inline uint64_t _lio_statcache_hash(const char* const pPath, const size_t length)
+{
+    uint64_t hash = 0xCBF29CE484222325ull;
+
+    for (size_t i = 0; i < length; ++i)
+    {
+        hash = (hash ^ (unsigned char)pPath[i]) * 0x100000001B3ull;
+    }
+
+    return hash ^ (hash >> 29);
+}
+
+
+
+static inline uint64_t _lio_statcache_now(void)
+{
+    struct timespec ts;
+
+    if (!_lioStatCacheTtl)
+    {
+        return 0;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+
+
+static inline LioStatCacheShard* _lio_statcache_shard(const uint64_t hash)
+{
+    // The low bits select a slot, so the high bits select the shard
+    return _pLioStatCache + (size_t)((hash >> 56) % LIO_STAT_CACHE_NUM_SHARDS);
+}
+
+
+
+static inline LioStatCacheSlot* _lio_statcache_way(const LioStatCacheShard* const pShard, const uint64_t hash, const unsigned way)
+{
+    return pShard->pSlots + (((size_t)hash + way) & (pShard->numSlots - 1));
+}
+
+
+
+static inline bool _lio_statcache_matches(const LioStatCacheSlot* const pSlot, const uint64_t hash, const char* const pPath, const size_t length)
+{
+    return pSlot->pPath
+        && pSlot->hash == hash
+        && pSlot->pathLength == length
+        && memcmp(pSlot->pPath, pPath, length) == 0;
+}
+
+
+
+static inline bool _lio_statcache_is_current(const LioStatCacheSlot* const pSlot, const uint64_t generation, const uint64_t now)
+{
+    return pSlot->generation == generation && (!_lioStatCacheTtl || now - pSlot->storedTime < _lioStatCacheTtl);
+}
+
+
+
+static inline void _lio_statcache_clear(LioStatCacheSlot* const pSlot)
+{
+    lio_alloc_free(pSlot->pPath);
+    memset(pSlot, 0, sizeof(LioStatCacheSlot));
+}
+
+
+
+/*-------------------------------------
+ * Spell an absolute path one way, so that "/a//b/./c" and "/a/b/c" share an
+ * entry. Relative paths depend on the working directory and ".." depends on
+ * symbolic links, so neither has a key. A trailing separator only has one if
+ * "isTrailingIgnored" is set: lstat("file/") fails where lstat("file") does
+ * not, but both name the same thing when invalidating.
+ *
+ * Returns the length of the key, or 0 if the path has none.
+------------------------------------*/
+static size_t _lio_statcache_key(const char* const pPath, char* const pKey, const bool isTrailingIgnored)
+{
+    const char* pIter = pPath;
+    size_t length = 0;
+
+    if (pPath[0] != LIO_PATH_SEP)
+    {
+        return 0;
+    }
+
+    while (*pIter)
+    {
+        while (*pIter == LIO_PATH_SEP)
+        {
+            ++pIter;
+        }
+
+        const char* const pName = pIter;
+        while (*pIter && *pIter != LIO_PATH_SEP)
+        {
+            ++pIter;
+        }
+
+        // Both "/a/" and "/a/." require "a" to be a folder
+        const size_t nameLength = (size_t)(pIter - pName);
+        const bool isDot = nameLength == 1 && pName[0] == '.';
+        if (!nameLength || (isDot && !*pIter))
+        {
+            if (length && !isTrailingIgnored)
+            {
+                return 0;
+            }
+            break;
+        }
+
+        if (isDot)
+        {
+            continue;
+        }
+
+        if (nameLength == 2 && pName[0] == '.' && pName[1] == '.')
+        {
+            return 0;
+        }
+
+        if (length + nameLength + 2 > PATH_MAX)
+        {
+            return 0;
+        }
+
+        pKey[length++] = LIO_PATH_SEP;
+        memcpy(pKey + length, pName, nameLength);
+        length += nameLength;
+    }
+
+    if (!length)
+    {
+        pKey[length++] = LIO_PATH_SEP;
+    }
+
+    pKey[length] = '\0';
+    return length;
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Enabling & Disabling
+-----------------------------------------------------------------------------*/
+bool lio_statcache_enable(size_t capacity, const uint64_t ttlNs)
+{
+    size_t numSlots = LIO_STAT_CACHE_WAYS;
+
+    lio_statcache_disable();
+
+    capacity = capacity ? capacity : (size_t)LIO_STAT_CACHE_DEFAULT_CAPACITY;
+    while (numSlots * LIO_STAT_CACHE_NUM_SHARDS < capacity)
+    {
+        numSlots *= 2;
+    }
+
+    _pLioStatCache = (LioStatCacheShard*)lio_alloc_calloc(LIO_STAT_CACHE_NUM_SHARDS, sizeof(LioStatCacheShard));
+    if (!_pLioStatCache)
+    {
+        lio_error_report(LIO_ERROR_OUT_OF_MEMORY, 0, "Unable to allocate a metadata cache", NULL, NULL);
+        return false;
+    }
+
+    for (unsigned i = 0; i < LIO_STAT_CACHE_NUM_SHARDS; ++i)
+    {
+        LioStatCacheShard* const pShard = _pLioStatCache + i;
+
+        pthread_mutex_init(&pShard->lock, NULL);
+        pShard->numSlots = numSlots;
+        pShard->pSlots = (LioStatCacheSlot*)lio_alloc_calloc(numSlots, sizeof(LioStatCacheSlot));
+
+        if (!pShard->pSlots)
+        {
+            lio_error_report(LIO_ERROR_OUT_OF_MEMORY, 0, "Unable to allocate a metadata cache", NULL, NULL);
+            lio_statcache_disable();
+            return false;
+        }
+    }
+
+    _lioStatCacheTtl = ttlNs;
+    atomic_store(&_lioStatCacheEnabled, true);
+
+    return true;
+}
+
+
+
+void lio_statcache_disable(void)
+{
+    atomic_store(&_lioStatCacheEnabled, false);
+
+    if (!_pLioStatCache)
+    {
+        return;
+    }
+
+    for (unsigned i = 0; i < LIO_STAT_CACHE_NUM_SHARDS; ++i)
+    {
+        LioStatCacheShard* const pShard = _pLioStatCache + i;
+
+        for (size_t j = 0; pShard->pSlots && j < pShard->numSlots; ++j)
+        {
+            lio_alloc_free(pShard->pSlots[j].pPath);
+        }
+
+        lio_alloc_free(pShard->pSlots);
+        pthread_mutex_destroy(&pShard->lock);
+    }
+
+    lio_alloc_free(_pLioStatCache);
+    _pLioStatCache = NULL;
+    _lioStatCacheTtl = 0;
+}
+
+
+
+bool lio_statcache_is_enabled(void)
+{
+    return atomic_load_explicit(&_lioStatCacheEnabled, memory_order_relaxed);
+}
+
+
+
+uint64_t lio_statcache_bump(void)
+{
+    return atomic_fetch_add(&_lioStatCacheGeneration, 1) + 1;
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Lookups
+-----------------------------------------------------------------------------*/
+bool lio_statcache_lookup(const char* const path, LioStatCacheEntry* const pOutEntry, uint64_t* const pOutEpoch)
+{
+    char key[PATH_MAX];
+
+    *pOutEpoch = 0;
+
+    if (!lio_statcache_is_enabled())
+    {
+        return false;
+    }
+
+    const size_t length = _lio_statcache_key(path, key, false);
+    if (!length)
+    {
+        return false;
+    }
+
+    const uint64_t hash = _lio_statcache_hash(key, length);
+    const uint64_t generation = atomic_load(&_lioStatCacheGeneration);
+    const uint64_t now = _lio_statcache_now();
+    LioStatCacheShard* const pShard = _lio_statcache_shard(hash);
+    bool found = false;
+
+    pthread_mutex_lock(&pShard->lock);
+
+    // Both counters only grow, so their sum changes if either does
+    *pOutEpoch = generation + pShard->epoch;
+
+    for (unsigned i = 0; i < LIO_STAT_CACHE_WAYS; ++i)
+    {
+        LioStatCacheSlot* const pSlot = _lio_statcache_way(pShard, hash, i);
+
+        if (_lio_statcache_matches(pSlot, hash, key, length))
+        {
+            found = _lio_statcache_is_current(pSlot, generation, now);
+            if (found)
+            {
+                *pOutEntry = pSlot->entry;
+                pSlot->lastUsed = ++pShard->tick;
+            }
+            break;
+        }
+    }
+
+    pShard->hits += found;
+    pShard->misses += !found;
+
+    pthread_mutex_unlock(&pShard->lock);
+
+    return found;
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Insertion
+-----------------------------------------------------------------------------*/
+void lio_statcache_store(const char* const path, const LioStatCacheEntry* const pEntry, const uint64_t epoch)
+{
+    char key[PATH_MAX];
+
+    if (!epoch || !lio_statcache_is_enabled())
+    {
+        return;
+    }
+
+    const size_t length = _lio_statcache_key(path, key, false);
+    if (!length)
+    {
+        return;
+    }
+
+    const uint64_t hash = _lio_statcache_hash(key, length);
+    const uint64_t now = _lio_statcache_now();
+    LioStatCacheShard* const pShard = _lio_statcache_shard(hash);
+    LioStatCacheSlot* pVictim = NULL;
+    unsigned victimRank = 0;
+    bool isMatch = false;
+
+    // Copy the path before locking so the lock is never held across malloc()
+    char* pCopy = (char*)lio_alloc_malloc(length + 1);
+    if (!pCopy)
+    {
+        return;
+    }
+    memcpy(pCopy, key, length + 1);
+
+    pthread_mutex_lock(&pShard->lock);
+
+    // The path was stat'ed before something invalidated it, or the whole cache
+    const uint64_t generation = atomic_load(&_lioStatCacheGeneration);
+    if (generation + pShard->epoch != epoch)
+    {
+        pthread_mutex_unlock(&pShard->lock);
+        lio_alloc_free(pCopy);
+        return;
+    }
+
+    // Prefer the path's own slot, then an empty slot, then an outdated one,
+    // then the least recently used
+    for (unsigned i = 0; i < LIO_STAT_CACHE_WAYS; ++i)
+    {
+        LioStatCacheSlot* const pSlot = _lio_statcache_way(pShard, hash, i);
+        const unsigned rank = !pSlot->pPath ? 0u : !_lio_statcache_is_current(pSlot, generation, now) ? 1u : 2u;
+
+        if (_lio_statcache_matches(pSlot, hash, key, length))
+        {
+            pVictim = pSlot;
+            isMatch = true;
+            break;
+        }
+
+        if (!pVictim || rank < victimRank || (rank == victimRank && pSlot->lastUsed < pVictim->lastUsed))
+        {
+            pVictim = pSlot;
+            victimRank = rank;
+        }
+    }
+
+    if (!isMatch)
+    {
+        pShard->evictions += victimRank == 2u;
+        lio_alloc_free(pVictim->pPath);
+        pVictim->pPath = pCopy;
+        pVictim->pathLength = length;
+        pVictim->hash = hash;
+        pCopy = NULL;
+    }
+
+    pVictim->generation = generation;
+    pVictim->storedTime = now;
+    pVictim->lastUsed = ++pShard->tick;
+    pVictim->entry = *pEntry;
+
+    pthread_mutex_unlock(&pShard->lock);
+
+    lio_alloc_free(pCopy);
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Invalidation
+-----------------------------------------------------------------------------*/
+static inline bool _lio_statcache_is_beneath(const LioStatCacheSlot* const pSlot, const char* const pPath, const size_t length)
+{
+    return pSlot->pPath
+        && pSlot->pathLength > length
+        && memcmp(pSlot->pPath, pPath, length) == 0
+        && (pSlot->pPath[length] == LIO_PATH_SEP || (length && pPath[length-1] == LIO_PATH_SEP));
+}
+
+
+
+/*-------------------------------------
+ * Find the key of a changed path. Relative paths are joined to the current
+ * working directory, which is what the change was made against.
+------------------------------------*/
+static size_t _lio_statcache_changed_key(const char* const pPath, char* const pKey)
+{
+    char absolute[PATH_MAX];
+    size_t cwdLength;
+
+    if (pPath[0] == LIO_PATH_SEP)
+    {
+        return _lio_statcache_key(pPath, pKey, true);
+    }
+
+    if (!getcwd(absolute, sizeof(absolute)))
+    {
+        return 0;
+    }
+
+    cwdLength = strlen(absolute);
+    if (cwdLength + strlen(pPath) + 2 > sizeof(absolute))
+    {
+        return 0;
+    }
+
+    absolute[cwdLength] = LIO_PATH_SEP;
+    strcpy(absolute + cwdLength + 1, pPath);
+
+    return _lio_statcache_key(absolute, pKey, true);
+}
+
+
+
+void lio_statcache_invalidate(const char* const path, const bool recurse)
+{
+    char key[PATH_MAX];
+
+    if (!path || !lio_statcache_is_enabled())
+    {
+        return;
+    }
+
+    // Without a key there is no telling which entries the path aliases
+    const size_t length = _lio_statcache_changed_key(path, key);
+    if (!length)
+    {
+        lio_statcache_bump();
+        return;
+    }
+
+    const uint64_t hash = _lio_statcache_hash(key, length);
+    LioStatCacheShard* const pShard = _lio_statcache_shard(hash);
+
+    pthread_mutex_lock(&pShard->lock);
+
+    // Lookups which missed before now must not store what they found
+    ++pShard->epoch;
+
+    for (unsigned i = 0; i < LIO_STAT_CACHE_WAYS; ++i)
+    {
+        LioStatCacheSlot* const pSlot = _lio_statcache_way(pShard, hash, i);
+
+        if (_lio_statcache_matches(pSlot, hash, key, length))
+        {
+            _lio_statcache_clear(pSlot);
+            ++pShard->invalidations;
+            break;
+        }
+    }
+
+    pthread_mutex_unlock(&pShard->lock);
+
+    if (!recurse)
+    {
+        return;
+    }
+
+    for (unsigned i = 0; i < LIO_STAT_CACHE_NUM_SHARDS; ++i)
+    {
+        LioStatCacheShard* const pIter = _pLioStatCache + i;
+
+        pthread_mutex_lock(&pIter->lock);
+
+        ++pIter->epoch;
+
+        for (size_t j = 0; j < pIter->numSlots; ++j)
+        {
+            if (_lio_statcache_is_beneath(pIter->pSlots + j, key, length))
+            {
+                _lio_statcache_clear(pIter->pSlots + j);
+                ++pIter->invalidations;
+            }
+        }
+
+        pthread_mutex_unlock(&pIter->lock);
+    }
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Statistics
+-----------------------------------------------------------------------------*/
+void lio_statcache_stats(LioStatCacheStats* const pOutStats)
+{
+    memset(pOutStats, 0, sizeof(LioStatCacheStats));
+    pOutStats->generation = atomic_load(&_lioStatCacheGeneration);
+
+    if (!lio_statcache_is_enabled())
+    {
+        return;
+    }
+
+    for (unsigned i = 0; i < LIO_STAT_CACHE_NUM_SHARDS; ++i)
+    {
+        LioStatCacheShard* const pShard = _pLioStatCache + i;
+
+        pthread_mutex_lock(&pShard->lock);
+        pOutStats->hits += pShard->hits;
+        pOutStats->misses += pShard->misses;
+        pOutStats->invalidations += pShard->invalidations;
+        pOutStats->evictions += pShard->evictions;
+        pthread_mutex_unlock(&pShard->lock);
+    }
+}
@@ -0,0 +1,474 @@
+
+// expose clock_gettime()
+#ifndef _GNU_SOURCE
+    #define _GNU_SOURCE
+#endif
+
+#include <pthread.h>
+#include <time.h> // clock_gettime()
+
+#include <stdatomic.h>
+#include <stdlib.h> // calloc()
+#include <string.h> // memset()
+
+#include "light_io/lio_stats.h"
+#include "light_io/lio_record.h"
+#include "light_io/lio_trace.h"
+
+
+
+/*-----------------------------------------------------------------------------
+ * Per-thread shards
+ *
+ * Each thread only writes to its own shard, using relaxed loads and stores
+ * rather than read-modify-write instructions. Shards are never freed: when a
+ * thread exits its shard is handed to the next new thread, so totals survive.
+-----------------------------------------------------------------------------*/
+typedef struct LioStatsShardOp
+{
+    atomic_uint_fast64_t counters[LIO_STATS_NUM_COUNTERS];
+    atomic_uint_fast64_t totalNs;
+    atomic_uint_fast64_t buckets[LIO_STATS_NUM_BUCKETS];
+} LioStatsShardOp;
+
+
+
+typedef struct LioStatsShard
+{
+    LioStatsShardOp ops[LIO_STATS_NUM_OPS];
+    struct LioStatsShard* pNext;
+    bool inUse;
+} LioStatsShard;
+
+
+
+static atomic_bool _lioStatsEnabled = false;
+
+static pthread_mutex_t _lioStatsLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t _lioStatsKeyOnce = PTHREAD_ONCE_INIT;
+static pthread_key_t _lioStatsKey;
+static LioStatsShard* _pLioStatsShards = NULL;
+static LioStatsSnapshot _lioStatsBaseline; // Totals at the last reset
+
+static _Thread_local LioStatsShard* _pLioStatsShard = NULL;
+static _Thread_local int _lioStatsCurrentOp = LIO_STATS_OP_OTHER;
+static _Thread_local uint64_t _lioStatsThreadBytes[2] = {0, 0}; // Bytes read and written, for spans
+
+
+
+/*-------------------------------------
+ * Release a thread's shard when it exits
+-------------------------------------*/
+static void _lio_stats_release_shard(void* pData)
+{
+    LioStatsShard* const pShard = (LioStatsShard*)pData;
+
+    pthread_mutex_lock(&_lioStatsLock);
+    pShard->inUse = false;
+    pthread_mutex_unlock(&_lioStatsLock);
+}
+
+
+
+static void _lio_stats_create_key(void)
+{
+    pthread_key_create(&_lioStatsKey, &_lio_stats_release_shard);
+}
+
+
+
+/*-------------------------------------
+ * Find or create the calling thread's shard. Shards use the system allocator
+ * since allocations through lio_alloc are themselves counted.
+-------------------------------------*/
+static LioStatsShard* _lio_stats_shard(void)
+{
+    LioStatsShard* pShard = _pLioStatsShard;
+
+    if (pShard)
+    {
+        return pShard;
+    }
+
+    pthread_once(&_lioStatsKeyOnce, &_lio_stats_create_key);
+    pthread_mutex_lock(&_lioStatsLock);
+
+    for (pShard = _pLioStatsShards; pShard && pShard->inUse; pShard = pShard->pNext)
+    {
+    }
+
+    if (!pShard)
+    {
+        pShard = (LioStatsShard*)calloc(1, sizeof(LioStatsShard));
+        if (pShard)
+        {
+            pShard->pNext = _pLioStatsShards;
+            _pLioStatsShards = pShard;
+        }
+    }
+
+    if (pShard)
+    {
+        pShard->inUse = true;
+    }
+
+    pthread_mutex_unlock(&_lioStatsLock);
+
+    if (pShard)
+    {
+        pthread_setspecific(_lioStatsKey, pShard);
+        _pLioStatsShard = pShard;
+    }
+
+    return pShard;
+}
+
+
+
+static inline void _lio_stats_increment(atomic_uint_fast64_t* const pValue, const uint64_t amount)
+{
+    atomic_store_explicit(pValue, atomic_load_explicit(pValue, memory_order_relaxed) + amount, memory_order_relaxed);
+}
+
+
+
+static inline uint64_t _lio_stats_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+
+
+/*-------------------------------------
+ * Map a latency to its histogram bucket
+-------------------------------------*/
+static inline unsigned _lio_stats_bucket(const uint64_t ns)
+{
+    const unsigned numSubBuckets = 1u << LIO_STATS_SUB_BUCKET_BITS;
+
+    if (ns < numSubBuckets)
+    {
+        return (unsigned)ns;
+    }
+
+    const unsigned exponent = 63u - (unsigned)__builtin_clzll(ns);
+    if (exponent > LIO_STATS_MAX_EXPONENT)
+    {
+        return LIO_STATS_NUM_BUCKETS - 1;
+    }
+
+    const unsigned subBucket = (unsigned)(ns >> (exponent - LIO_STATS_SUB_BUCKET_BITS)) - numSubBuckets;
+    return ((exponent - LIO_STATS_SUB_BUCKET_BITS + 1) << LIO_STATS_SUB_BUCKET_BITS) + subBucket;
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Recording
+-----------------------------------------------------------------------------*/
+LioStatsTimer lio_stats_begin(const enum LioStatsOp op, const char* const pPath)
+{
+    LioStatsTimer timer;
+
+    timer.op = (int)op;
+    timer.parentOp = _lioStatsCurrentOp;
+    timer.startNs = 0;
+    timer.startBytesRead = _lioStatsThreadBytes[0];
+    timer.startBytesWritten = _lioStatsThreadBytes[1];
+    timer.pPath = pPath;
+    timer.counted = atomic_load_explicit(&_lioStatsEnabled, memory_order_relaxed);
+    timer.traced = lio_trace_is_enabled();
+
+    // Only calls made by the application are recorded, not those a library
+    // function makes on its behalf.
+    timer.recorded = timer.parentOp == LIO_STATS_OP_OTHER && lio_record_is_enabled();
+
+    // Calls made by an operation into its own public entry point are part of
+    // the outer call.
+    if ((timer.counted || timer.traced || timer.recorded) && (int)op != _lioStatsCurrentOp)
+    {
+        timer.startNs = _lio_stats_now();
+        _lioStatsCurrentOp = (int)op;
+    }
+
+    return timer;
+}
+
+
+
+void lio_stats_end(const LioStatsTimer* const pTimer)
+{
+    lio_stats_end_call(pTimer, NULL, 0, 0, 0, 0);
+}
+
+
+
+void lio_stats_end_call(
+    const LioStatsTimer* const pTimer,
+    const char* const pOtherPath,
+    const uint64_t arg0,
+    const uint64_t arg1,
+    const uint64_t arg2,
+    const int64_t result)
+{
+    if (!pTimer->startNs)
+    {
+        return;
+    }
+
+    _lioStatsCurrentOp = pTimer->parentOp;
+
+    const uint64_t endNs = _lio_stats_now();
+    const uint64_t elapsed = endNs - pTimer->startNs;
+
+    if (pTimer->traced)
+    {
+        lio_trace_record(
+            pTimer->op,
+            pTimer->pPath,
+            pTimer->startNs,
+            endNs,
+            _lioStatsThreadBytes[0] - pTimer->startBytesRead,
+            _lioStatsThreadBytes[1] - pTimer->startBytesWritten);
+    }
+
+    if (pTimer->recorded)
+    {
+        LioRecordEntry entry;
+
+        entry.startNs = pTimer->startNs;
+        entry.durationNs = elapsed;
+        entry.args[0] = arg0;
+        entry.args[1] = arg1;
+        entry.args[2] = arg2;
+        entry.bytesRead = _lioStatsThreadBytes[0] - pTimer->startBytesRead;
+        entry.bytesWritten = _lioStatsThreadBytes[1] - pTimer->startBytesWritten;
+        entry.result = result;
+        entry.threadId = 0;
+        entry.op = (uint16_t)pTimer->op;
+        entry.pPath = pTimer->pPath ? pTimer->pPath : "";
+        entry.pOtherPath = pOtherPath ? pOtherPath : "";
+
+        lio_record_call(&entry);
+    }
+
+    LioStatsShard* const pShard = pTimer->counted ? _lio_stats_shard() : NULL;
+    if (!pShard)
+    {
+        return;
+    }
+
+    LioStatsShardOp* const pOp = pShard->ops + pTimer->op;
+
+    _lio_stats_increment(&pOp->counters[LIO_STATS_CALLS], 1);
+    _lio_stats_increment(&pOp->totalNs, elapsed);
+    _lio_stats_increment(&pOp->buckets[_lio_stats_bucket(elapsed)], 1);
+}
+
+
+
+void lio_stats_add(const enum LioStatsCounter counter, const uint64_t amount)
+{
+    if (counter == LIO_STATS_BYTES_READ || counter == LIO_STATS_BYTES_WRITTEN)
+    {
+        _lioStatsThreadBytes[counter == LIO_STATS_BYTES_WRITTEN] += amount;
+    }
+
+    if (!atomic_load_explicit(&_lioStatsEnabled, memory_order_relaxed))
+    {
+        return;
+    }
+
+    LioStatsShard* const pShard = _lio_stats_shard();
+    if (pShard)
+    {
+        _lio_stats_increment(&pShard->ops[_lioStatsCurrentOp].counters[counter], amount);
+    }
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Control
+-----------------------------------------------------------------------------*/
+bool lio_stats_enable(const bool enable)
+{
+    #if defined(LIGHT_IO_ENABLE_STATS)
+        atomic_store(&_lioStatsEnabled, enable);
+        return enable;
+    #else
+        (void)enable;
+        return false;
+    #endif
+}
+
+
+
+bool lio_stats_is_enabled(void)
+{
+    return atomic_load(&_lioStatsEnabled);
+}
+
+
+
+/*-------------------------------------
+ * Sum every shard. The lock must be held.
+-------------------------------------*/
+static void _lio_stats_sum(LioStatsSnapshot* const pOut)
+{
+    memset(pOut, 0, sizeof(LioStatsSnapshot));
+
+    for (const LioStatsShard* pShard = _pLioStatsShards; pShard; pShard = pShard->pNext)
+    {
+        for (unsigned i = 0; i < LIO_STATS_NUM_OPS; ++i)
+        {
+            const LioStatsShardOp* const pIn = pShard->ops + i;
+            LioStatsOpStats* const pOp = pOut->ops + i;
+
+            for (unsigned j = 0; j < LIO_STATS_NUM_COUNTERS; ++j)
+            {
+                pOp->counters[j] += atomic_load_explicit(&pIn->counters[j], memory_order_relaxed);
+            }
+
+            pOp->totalNs += atomic_load_explicit(&pIn->totalNs, memory_order_relaxed);
+
+            for (unsigned j = 0; j < LIO_STATS_NUM_BUCKETS; ++j)
+            {
+                pOp->buckets[j] += atomic_load_explicit(&pIn->buckets[j], memory_order_relaxed);
+            }
+        }
+    }
+}
+
+
+
+void lio_stats_snapshot(LioStatsSnapshot* const pOutSnapshot)
+{
+    pthread_mutex_lock(&_lioStatsLock);
+    _lio_stats_sum(pOutSnapshot);
+
+    for (unsigned i = 0; i < LIO_STATS_NUM_OPS; ++i)
+    {
+        LioStatsOpStats* const pOp = pOutSnapshot->ops + i;
+        const LioStatsOpStats* const pBase = _lioStatsBaseline.ops + i;
+
+        for (unsigned j = 0; j < LIO_STATS_NUM_COUNTERS; ++j)
+        {
+            pOp->counters[j] -= pBase->counters[j];
+        }
+
+        pOp->totalNs -= pBase->totalNs;
+
+        for (unsigned j = 0; j < LIO_STATS_NUM_BUCKETS; ++j)
+        {
+            pOp->buckets[j] -= pBase->buckets[j];
+        }
+    }
+
+    pthread_mutex_unlock(&_lioStatsLock);
+}
+
+
+
+void lio_stats_reset(void)
+{
+    // Shards are only written by their own threads, so the totals at this
+    // point are remembered and subtracted from later snapshots instead.
+    pthread_mutex_lock(&_lioStatsLock);
+    _lio_stats_sum(&_lioStatsBaseline);
+    pthread_mutex_unlock(&_lioStatsLock);
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Reporting
+-----------------------------------------------------------------------------*/
+const char* lio_stats_op_name(const enum LioStatsOp op)
+{
+    static const char* const OP_NAMES[LIO_STATS_NUM_OPS] = {
+        "other",
+        "file_open",
+        "file_close",
+        "file_read",
+        "file_write",
+        "file_map",
+        "file_copy",
+        "file_concat",
+        "file_split",
+        "path_exists",
+        "path_resolve",
+        "path_list",
+        "path_remove",
+        "path_mkdirs",
+        "path_move",
+        "file_commit"
+    };
+
+    return ((unsigned)op < LIO_STATS_NUM_OPS) ? OP_NAMES[op] : "unknown";
+}
+
+
+
+const char* lio_stats_counter_name(const enum LioStatsCounter counter)
+{
+    static const char* const COUNTER_NAMES[LIO_STATS_NUM_COUNTERS] = {
+        "calls",
+        "syscalls",
+        "bytes_read",
+        "bytes_written",
+        "entries_scanned",
+        "allocations",
+        "errors"
+    };
+
+    return ((unsigned)counter < LIO_STATS_NUM_COUNTERS) ? COUNTER_NAMES[counter] : "unknown";
+}
+
+
+
+uint64_t lio_stats_bucket_lower_bound(const unsigned bucket)
+{
+    const unsigned numSubBuckets = 1u << LIO_STATS_SUB_BUCKET_BITS;
+
+    if (bucket < numSubBuckets)
+    {
+        return bucket;
+    }
+
+    const unsigned block = bucket >> LIO_STATS_SUB_BUCKET_BITS;
+    const uint64_t subBucket = bucket & (numSubBuckets - 1u);
+
+    return (numSubBuckets + subBucket) << (block - 1u);
+}
+
+
+
+uint64_t lio_stats_percentile(const LioStatsOpStats* const pStats, const double fraction)
+{
+    const uint64_t numCalls = pStats->counters[LIO_STATS_CALLS];
+    uint64_t rank;
+    uint64_t seen = 0;
+
+    if (!numCalls)
+    {
+        return 0;
+    }
+
+    rank = (uint64_t)(fraction * (double)numCalls + 0.5);
+    rank = rank ? rank : 1;
+    rank = rank < numCalls ? rank : numCalls;
+
+    for (unsigned i = 0; i < LIO_STATS_NUM_BUCKETS; ++i)
+    {
+        seen += pStats->buckets[i];
+        if (seen >= rank)
+        {
+            return lio_stats_bucket_lower_bound(i);
+        }
+    }
+
+    return lio_stats_bucket_lower_bound(LIO_STATS_NUM_BUCKETS - 1);
+}
@@ -0,0 +1,197 @@
+
+#include <stdarg.h> // va_list, va_copy()
+#include <stdint.h> // SIZE_MAX
+#include <stdio.h> // vsnprintf()
+#include <stdlib.h>
+#include <string.h> // memcpy(), strlen()
+
+#include "light_io/lio_alloc.h"
+#include "light_io/lio_error.h"
+#include "light_io/lio_utils.h"
+#include "light_io/lio_strbuf.h"
+
+
+
+/*-----------------------------------------------------------------------------
+ * Initialize a string buffer
+-----------------------------------------------------------------------------*/
+void lio_strbuf_init(LioStrBuf* const pBuf)
+{
+    pBuf->pData = NULL;
+    pBuf->length = 0;
+    pBuf->capacity = 0;
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Release a string buffer
+-----------------------------------------------------------------------------*/
+void lio_strbuf_terminate(LioStrBuf* const pBuf)
+{
+    if (pBuf)
+    {
+        lio_alloc_free(pBuf->pData);
+        lio_strbuf_init(pBuf);
+    }
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Reserve space for characters
+-----------------------------------------------------------------------------*/
+bool lio_strbuf_reserve(LioStrBuf* const pBuf, const size_t numChars)
+{
+    if (numChars < pBuf->capacity)
+    {
+        return true;
+    }
+
+    if (numChars >= SIZE_MAX/2)
+    {
+        return false;
+    }
+
+    size_t newCapacity = LIO_UTILS_MAX(pBuf->capacity, (size_t)LIO_STRBUF_MIN_CAPACITY);
+    while (newCapacity <= numChars)
+    {
+        newCapacity *= 2;
+    }
+
+    char* const pNewData = (char*)lio_alloc_realloc(pBuf->pData, pBuf->capacity, newCapacity);
+    if (!pNewData)
+    {
+        lio_error_report(LIO_ERROR_OUT_OF_MEMORY, 0, "Unable to grow a string buffer", NULL, NULL);
+        return false;
+    }
+
+    if (!pBuf->pData)
+    {
+        pNewData[0] = '\0';
+    }
+
+    pBuf->pData = pNewData;
+    pBuf->capacity = newCapacity;
+
+    return true;
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Append strings
+-----------------------------------------------------------------------------*/
+bool lio_strbuf_append(LioStrBuf* const pBuf, const char* const pStr)
+{
+    return pStr && lio_strbuf_append_n(pBuf, pStr, strlen(pStr));
+}
+
+
+
+bool lio_strbuf_append_n(LioStrBuf* const pBuf, const char* const pStr, const size_t numChars)
+{
+    if (!pStr || !lio_strbuf_reserve(pBuf, pBuf->length + numChars))
+    {
+        return false;
+    }
+
+    memcpy(pBuf->pData + pBuf->length, pStr, numChars);
+    pBuf->length += numChars;
+    pBuf->pData[pBuf->length] = '\0';
+
+    return true;
+}
+
+
+
+bool lio_strbuf_append_char(LioStrBuf* const pBuf, const char c)
+{
+    if (!lio_strbuf_reserve(pBuf, pBuf->length + 1))
+    {
+        return false;
+    }
+
+    pBuf->pData[pBuf->length++] = c;
+    pBuf->pData[pBuf->length] = '\0';
+
+    return true;
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Append a formatted string
+-----------------------------------------------------------------------------*/
+bool lio_strbuf_appendf(LioStrBuf* const pBuf, const char* const fmt, ...)
+{
+    va_list args;
+    va_list argsCopy;
+
+    if (!fmt || !lio_strbuf_reserve(pBuf, pBuf->length))
+    {
+        return false;
+    }
+
+    // Try formatting into the spare capacity first
+    va_start(args, fmt);
+    va_copy(argsCopy, args);
+    const size_t numAvailable = pBuf->capacity - pBuf->length;
+    const int numChars = vsnprintf(pBuf->pData + pBuf->length, numAvailable, fmt, args);
+    va_end(args);
+
+    bool ret = numChars >= 0;
+
+    if (ret && (size_t)numChars >= numAvailable)
+    {
+        ret = lio_strbuf_reserve(pBuf, pBuf->length + (size_t)numChars)
+            && vsnprintf(pBuf->pData + pBuf->length, (size_t)numChars + 1, fmt, argsCopy) == numChars;
+    }
+    va_end(argsCopy);
+
+    if (ret)
+    {
+        pBuf->length += (size_t)numChars;
+    }
+    else
+    {
+        lio_error_report(LIO_ERROR_INVALID_ARGUMENT, 0, "Unable to append a formatted string", NULL, NULL);
+    }
+
+    pBuf->pData[pBuf->length] = '\0';
+
+    return ret;
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Truncate a string buffer
+-----------------------------------------------------------------------------*/
+void lio_strbuf_truncate(LioStrBuf* const pBuf, const size_t length)
+{
+    if (length < pBuf->length)
+    {
+        pBuf->length = length;
+        pBuf->pData[length] = '\0';
+    }
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Take ownership of a string
+-----------------------------------------------------------------------------*/
+char* lio_strbuf_detach(LioStrBuf* const pBuf)
+{
+    char* pStr = pBuf->pData;
+
+    if (!pStr)
+    {
+        pStr = (char*)lio_alloc_calloc(1, sizeof(char));
+    }
+
+    lio_strbuf_init(pBuf);
+
+    return pStr;
+}
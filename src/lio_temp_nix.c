@@ -0,0 +1,443 @@
+
+// expose O_TMPFILE and linkat()
+#ifndef _GNU_SOURCE
+    #define _GNU_SOURCE
+#endif
+
+#include <errno.h>
+#include <pthread.h>
+#include <fcntl.h> // open(), linkat()
+#include <unistd.h> // getpid(), unlink(), lseek()
+#include <sys/file.h> // flock()
+#include <sys/stat.h> // mkdir()
+
+#include <stdatomic.h>
+#include <stdlib.h> // getenv(), atexit()
+#include <stdio.h>
+#include <string.h>
+
+#include "light_io/lio_error.h"
+#include "light_io/lio_utils.h"
+#include "light_io/lio_paths.h"
+#include "light_io/lio_files.h"
+#include "light_io/lio_stats.h"
+#include "light_io/lio_statcache.h"
+#include "light_io/lio_temp.h"
+
+
+
+/*-----------------------------------------------------------------------------
+ * Scratch root state
+-----------------------------------------------------------------------------*/
+enum
+{
+    LIO_TEMP_ATTEMPTS = 16 // Names tried before giving up
+};
+
+#define LIO_TEMP_ROOT_PREFIX "lio-"
+#define LIO_TEMP_LOCK_NAME ".lock"
+#define LIO_TEMP_NEW_LOCK_NAME ".lock-new"
+
+static pthread_mutex_t _lioTempLock = PTHREAD_MUTEX_INITIALIZER;
+static char* _lioTempRoot = NULL;
+static int _lioTempLockFd = -1;
+static pid_t _lioTempOwner = 0; // Children created with fork() must not remove the root
+static bool _lioTempAtExit = false;
+static atomic_uint _lioTempCounter = 0;
+
+
+
+/*-------------------------------------
+ * Folder which holds every scratch root
+------------------------------------*/
+static const char* _lio_temp_base(const char* const pBaseDir)
+{
+    if (pBaseDir)
+    {
+        return pBaseDir;
+    }
+
+    const char* const pEnv = getenv("TMPDIR");
+    return (pEnv && *pEnv) ? pEnv : "/tmp";
+}
+
+
+
+static void _lio_temp_at_exit(void)
+{
+    lio_temp_cleanup();
+}
+
+
+
+/*-------------------------------------
+ * Create and lock a new scratch root. "_lioTempLock" must be held.
+------------------------------------*/
+static bool _lio_temp_create_root(void)
+{
+    const char* const pBase = _lio_temp_base(NULL);
+
+    for (unsigned attempt = 0; attempt < LIO_TEMP_ATTEMPTS; ++attempt)
+    {
+        const unsigned id = atomic_fetch_add_explicit(&_lioTempCounter, 1, memory_order_relaxed);
+        char* const pRoot = lio_utils_str_fmt("%s/" LIO_TEMP_ROOT_PREFIX "%ld-%u", pBase, (long)getpid(), id);
+
+        if (!pRoot)
+        {
+            lio_error_report(LIO_ERROR_OUT_OF_MEMORY, 0, "Unable to name a scratch folder", pBase, NULL);
+            return false;
+        }
+
+        LIO_STATS_ADD(LIO_STATS_SYSCALLS, 1);
+        if (mkdir(pRoot, 0700) != 0)
+        {
+            const int err = errno;
+            lio_utils_str_destroy(pRoot);
+
+            if (err == EEXIST)
+            {
+                continue;
+            }
+
+            lio_error_report_errno(err, "Unable to create a scratch folder", pBase, NULL);
+            return false;
+        }
+
+        // The lock is released by the kernel however the process ends. It
+        // is taken before the lock file gets the name "lio_temp_recover()"
+        // looks for, so the root is never seen unlocked.
+        char* const pNewLock = lio_utils_str_fmt("%s/" LIO_TEMP_NEW_LOCK_NAME, pRoot);
+        char* const pLock = lio_utils_str_fmt("%s/" LIO_TEMP_LOCK_NAME, pRoot);
+        const int fd = (pNewLock && pLock) ? open(pNewLock, O_RDONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0600) : -1;
+        const bool locked = fd >= 0 && flock(fd, LOCK_EX | LOCK_NB) == 0 && rename(pNewLock, pLock) == 0;
+        LIO_STATS_ADD(LIO_STATS_SYSCALLS, 3);
+
+        lio_utils_str_destroy(pNewLock);
+
+        if (!locked)
+        {
+            lio_error_report_errno(errno, "Unable to lock a scratch folder", pRoot, NULL);
+            if (fd >= 0)
+            {
+                close(fd);
+            }
+            lio_path_remove(pRoot, true, false);
+            lio_utils_str_destroy(pLock);
+            lio_utils_str_destroy(pRoot);
+            return false;
+        }
+
+        lio_utils_str_destroy(pLock);
+        _lioTempRoot = pRoot;
+        _lioTempLockFd = fd;
+        _lioTempOwner = getpid();
+
+        if (!_lioTempAtExit)
+        {
+            _lioTempAtExit = atexit(&_lio_temp_at_exit) == 0;
+        }
+
+        return true;
+    }
+
+    lio_error_report(LIO_ERROR_ALREADY_EXISTS, EEXIST, "Unable to find a free name for a scratch folder", pBase, NULL);
+    return false;
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Scratch root
+-----------------------------------------------------------------------------*/
+const char* lio_temp_root(void)
+{
+    pthread_mutex_lock(&_lioTempLock);
+
+    const char* const pRoot = (_lioTempRoot || _lio_temp_create_root()) ? _lioTempRoot : NULL;
+
+    pthread_mutex_unlock(&_lioTempLock);
+
+    return pRoot;
+}
+
+
+
+bool lio_temp_cleanup(void)
+{
+    bool ret = true;
+
+    pthread_mutex_lock(&_lioTempLock);
+
+    if (_lioTempRoot)
+    {
+        // A forked child only forgets the root, which its parent still uses
+        if (_lioTempOwner == getpid())
+        {
+            ret = lio_path_remove(_lioTempRoot, true, false);
+        }
+
+        close(_lioTempLockFd);
+        lio_utils_str_destroy(_lioTempRoot);
+        _lioTempLockFd = -1;
+        _lioTempRoot = NULL;
+    }
+
+    pthread_mutex_unlock(&_lioTempLock);
+
+    return ret;
+}
+
+
+
+/*-------------------------------------
+ * Only scratch roots are considered during recovery
+------------------------------------*/
+static bool _lio_temp_is_root(const char* const pPath)
+{
+    const char* const pSep = strrchr(pPath, '/');
+    const char* const pName = pSep ? pSep + 1 : pPath;
+
+    return strncmp(pName, LIO_TEMP_ROOT_PREFIX, sizeof(LIO_TEMP_ROOT_PREFIX) - 1) == 0;
+}
+
+
+
+int lio_temp_recover(const char* const pBaseDir)
+{
+    const char* const pBase = _lio_temp_base(pBaseDir);
+    unsigned numEntries = 0;
+    char** const ppEntries = lio_path_list(pBase, false, &_lio_temp_is_root, &numEntries);
+    int numRemoved = 0;
+
+    if (!ppEntries)
+    {
+        return numEntries ? -1 : 0;
+    }
+
+    for (unsigned i = 0; i < numEntries; ++i)
+    {
+        char* const pLock = lio_utils_str_fmt("%s/" LIO_TEMP_LOCK_NAME, ppEntries[i]);
+
+        // A root without a lock is either not ours or still being created
+        const int fd = pLock ? open(pLock, O_RDONLY | O_CLOEXEC) : -1;
+        LIO_STATS_ADD(LIO_STATS_SYSCALLS, 1);
+
+        // flock() locks belong to an open file, so a root which this process
+        // still holds cannot be locked a second time either.
+        if (fd >= 0 && flock(fd, LOCK_EX | LOCK_NB) == 0)
+        {
+            numRemoved += lio_path_remove(ppEntries[i], true, false) ? 1 : 0;
+        }
+
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+
+        lio_utils_str_destroy(pLock);
+    }
+
+    lio_paths_destroy(ppEntries, numEntries);
+
+    return numRemoved;
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Scratch files
+-----------------------------------------------------------------------------*/
+bool lio_temp_file(LioFile* const pFile, const char* const pDir)
+{
+    if (!pFile)
+    {
+        lio_error_report(LIO_ERROR_INVALID_ARGUMENT, 0, "Unable to create a scratch file without a handle", pDir, NULL);
+        return false;
+    }
+
+    *pFile = lio_file_wrap(-1);
+
+    const char* const pParent = pDir ? pDir : lio_temp_root();
+    if (!pParent)
+    {
+        return false;
+    }
+
+    int fd = -1;
+
+    #if defined(O_TMPFILE)
+        do
+        {
+            fd = open(pParent, O_TMPFILE | O_RDWR | O_CLOEXEC, 0600);
+            LIO_STATS_ADD(LIO_STATS_SYSCALLS, 1);
+        }
+        while (fd < 0 && errno == EINTR);
+
+        // Only fall back if the filesystem lacks support, not if the folder
+        // is unusable.
+        if (fd < 0 && errno != EOPNOTSUPP && errno != EISDIR && errno != EINVAL)
+        {
+            lio_error_report_errno(errno, "Unable to create a scratch file", pParent, NULL);
+            return false;
+        }
+    #endif
+
+    // Without O_TMPFILE, a name is used only long enough to open the file
+    for (unsigned attempt = 0; fd < 0 && attempt < LIO_TEMP_ATTEMPTS; ++attempt)
+    {
+        const unsigned id = atomic_fetch_add_explicit(&_lioTempCounter, 1, memory_order_relaxed);
+        char* const pPath = lio_utils_str_fmt("%s/.scratch-%ld-%u", pParent, (long)getpid(), id);
+
+        if (!pPath)
+        {
+            lio_error_report(LIO_ERROR_OUT_OF_MEMORY, 0, "Unable to name a scratch file", pParent, NULL);
+            return false;
+        }
+
+        do
+        {
+            fd = open(pPath, O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+            LIO_STATS_ADD(LIO_STATS_SYSCALLS, 1);
+        }
+        while (fd < 0 && errno == EINTR);
+
+        const int err = errno;
+        if (fd >= 0)
+        {
+            unlink(pPath);
+            LIO_STATS_ADD(LIO_STATS_SYSCALLS, 1);
+        }
+
+        lio_utils_str_destroy(pPath);
+
+        if (fd < 0 && err != EEXIST)
+        {
+            lio_error_report_errno(err, "Unable to create a scratch file", pParent, NULL);
+            return false;
+        }
+    }
+
+    if (fd < 0)
+    {
+        lio_error_report(LIO_ERROR_ALREADY_EXISTS, EEXIST, "Unable to find a free name for a scratch file", pParent, NULL);
+        return false;
+    }
+
+    pFile->fd = fd;
+    pFile->owned = true;
+
+    return true;
+}
+
+
+
+/*-------------------------------------
+ * Copy a scratch file which cannot be linked
+------------------------------------*/
+static bool _lio_temp_copy(const LioFile* const pFile, const char* const pPath)
+{
+    const off_t position = lseek(pFile->fd, 0, SEEK_CUR);
+    LioFile src = lio_file_wrap(pFile->fd);
+    LioFile dst;
+
+    if (position < 0 || lseek(pFile->fd, 0, SEEK_SET) != 0)
+    {
+        lio_error_report_errno(errno, "Unable to rewind a scratch file", pPath, NULL);
+        return false;
+    }
+
+    bool ret = lio_file_open(&dst, pPath, LIO_FILE_OPEN_WRITE | LIO_FILE_OPEN_EXCLUSIVE);
+    if (ret)
+    {
+        ret = lio_file_copy_fd(&src, &dst, LIO_FILE_COPY_DEFAULT, NULL);
+        ret = lio_file_close(&dst) && ret;
+
+        if (!ret)
+        {
+            lio_path_remove(pPath, false, false);
+        }
+    }
+
+    lseek(pFile->fd, position, SEEK_SET);
+    LIO_STATS_ADD(LIO_STATS_SYSCALLS, 3);
+
+    return ret;
+}
+
+
+
+bool lio_temp_keep(const LioFile* const pFile, const char* const pPath)
+{
+    if (!pFile || pFile->fd < 0 || !pPath)
+    {
+        lio_error_report(LIO_ERROR_INVALID_ARGUMENT, 0, "Unable to keep a scratch file without a path", pPath, NULL);
+        return false;
+    }
+
+    char procPath[32];
+    snprintf(procPath, sizeof(procPath), "/proc/self/fd/%d", pFile->fd);
+
+    LIO_STATS_ADD(LIO_STATS_SYSCALLS, 1);
+    if (linkat(AT_FDCWD, procPath, AT_FDCWD, pPath, AT_SYMLINK_FOLLOW) == 0)
+    {
+        lio_statcache_invalidate(pPath, false);
+        return true;
+    }
+
+    // Files from the fallback path were unlinked, and no file can be linked
+    // across filesystems.
+    if (errno != ENOENT && errno != EXDEV)
+    {
+        lio_error_report_errno(errno, "Unable to keep a scratch file", pPath, NULL);
+        return false;
+    }
+
+    const bool ret = _lio_temp_copy(pFile, pPath);
+    lio_statcache_invalidate(pPath, false);
+
+    return ret;
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Scratch folders
+-----------------------------------------------------------------------------*/
+char* lio_temp_dir(void)
+{
+    const char* const pRoot = lio_temp_root();
+    if (!pRoot)
+    {
+        return NULL;
+    }
+
+    for (unsigned attempt = 0; attempt < LIO_TEMP_ATTEMPTS; ++attempt)
+    {
+        const unsigned id = atomic_fetch_add_explicit(&_lioTempCounter, 1, memory_order_relaxed);
+        char* const pPath = lio_utils_str_fmt("%s/d%u", pRoot, id);
+
+        if (!pPath)
+        {
+            lio_error_report(LIO_ERROR_OUT_OF_MEMORY, 0, "Unable to name a scratch folder", pRoot, NULL);
+            return NULL;
+        }
+
+        LIO_STATS_ADD(LIO_STATS_SYSCALLS, 1);
+        if (mkdir(pPath, 0700) == 0)
+        {
+            return pPath;
+        }
+
+        const int err = errno;
+        lio_utils_str_destroy(pPath);
+
+        if (err != EEXIST)
+        {
+            lio_error_report_errno(err, "Unable to create a scratch folder", pRoot, NULL);
+            return NULL;
+        }
+    }
+
+    lio_error_report(LIO_ERROR_ALREADY_EXISTS, EEXIST, "Unable to find a free name for a scratch folder", pRoot, NULL);
+    return NULL;
+}
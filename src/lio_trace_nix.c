@@ -0,0 +1,360 @@
+
+#include <errno.h>
+#include <pthread.h>
+#include <unistd.h> // getpid()
+
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h> // calloc()
+#include <string.h> // memcpy()
+
+#include "light_io/lio_error.h"
+#include "light_io/lio_stats.h"
+#include "light_io/lio_trace.h"
+
+
+
+/*-----------------------------------------------------------------------------
+ * Per-thread rings
+ *
+ * Only the owning thread writes to a ring. Each slot carries a sequence
+ * number which is cleared while the slot is being written, so a reader can
+ * detect (and skip) a span which was overwritten while it was being copied.
+-----------------------------------------------------------------------------*/
+typedef struct LioTraceEvent
+{
+    atomic_uint_fast64_t seq; // Index of the span + 1, or 0 while writing
+    uint64_t startNs;
+    uint64_t durationNs;
+    uint64_t bytesRead;
+    uint64_t bytesWritten;
+    unsigned threadId;
+    int op;
+    char path[LIO_TRACE_MAX_PATH];
+} LioTraceEvent;
+
+
+
+typedef struct LioTraceRing
+{
+    atomic_uint_fast64_t head; // Total spans written
+    atomic_uint_fast64_t tail; // First span kept after the last clear
+    uint64_t mask;
+    unsigned threadId;
+    bool inUse;
+    struct LioTraceRing* pNext;
+    LioTraceEvent events[];
+} LioTraceRing;
+
+
+
+static atomic_bool _lioTraceEnabled = false;
+static atomic_uint _lioTraceNumEvents = LIO_TRACE_DEFAULT_NUM_EVENTS;
+
+static pthread_mutex_t _lioTraceLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t _lioTraceKeyOnce = PTHREAD_ONCE_INIT;
+static pthread_key_t _lioTraceKey;
+static LioTraceRing* _pLioTraceRings = NULL;
+static unsigned _lioTraceNumThreads = 0;
+
+static _Thread_local LioTraceRing* _pLioTraceRing = NULL;
+
+
+
+/*-------------------------------------
+ * Release a thread's ring when it exits
+-------------------------------------*/
+static void _lio_trace_release_ring(void* pData)
+{
+    LioTraceRing* const pRing = (LioTraceRing*)pData;
+
+    pthread_mutex_lock(&_lioTraceLock);
+    pRing->inUse = false;
+    pthread_mutex_unlock(&_lioTraceLock);
+}
+
+
+
+static void _lio_trace_create_key(void)
+{
+    pthread_key_create(&_lioTraceKey, &_lio_trace_release_ring);
+}
+
+
+
+/*-------------------------------------
+ * Find or create the calling thread's ring. A ring left behind by an exited
+ * thread is reused, but its thread gets a new ID so the spans of both threads
+ * stay apart in a trace viewer.
+-------------------------------------*/
+static LioTraceRing* _lio_trace_ring(void)
+{
+    LioTraceRing* pRing = _pLioTraceRing;
+
+    if (pRing)
+    {
+        return pRing;
+    }
+
+    const unsigned numEvents = atomic_load_explicit(&_lioTraceNumEvents, memory_order_relaxed);
+
+    pthread_once(&_lioTraceKeyOnce, &_lio_trace_create_key);
+    pthread_mutex_lock(&_lioTraceLock);
+
+    for (pRing = _pLioTraceRings; pRing && (pRing->inUse || pRing->mask+1 < numEvents); pRing = pRing->pNext)
+    {
+    }
+
+    if (!pRing)
+    {
+        // Rings use the system allocator since lio_alloc calls are counted
+        pRing = (LioTraceRing*)calloc(1, sizeof(LioTraceRing) + sizeof(LioTraceEvent) * numEvents);
+        if (pRing)
+        {
+            pRing->mask = numEvents - 1;
+            pRing->pNext = _pLioTraceRings;
+            _pLioTraceRings = pRing;
+        }
+    }
+
+    if (pRing)
+    {
+        pRing->inUse = true;
+        pRing->threadId = ++_lioTraceNumThreads;
+    }
+
+    pthread_mutex_unlock(&_lioTraceLock);
+
+    if (pRing)
+    {
+        pthread_setspecific(_lioTraceKey, pRing);
+        _pLioTraceRing = pRing;
+    }
+
+    return pRing;
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Recording
+-----------------------------------------------------------------------------*/
+void lio_trace_record(
+    const int op,
+    const char* const pPath,
+    const uint64_t startNs,
+    const uint64_t endNs,
+    const uint64_t bytesRead,
+    const uint64_t bytesWritten)
+{
+    LioTraceRing* const pRing = _lio_trace_ring();
+    if (!pRing)
+    {
+        return;
+    }
+
+    const uint64_t index = atomic_load_explicit(&pRing->head, memory_order_relaxed);
+    LioTraceEvent* const pEvent = pRing->events + (index & pRing->mask);
+    size_t pathLength = 0;
+
+    atomic_store_explicit(&pEvent->seq, 0, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    if (pPath)
+    {
+        while (pathLength < LIO_TRACE_MAX_PATH-1 && pPath[pathLength])
+        {
+            ++pathLength;
+        }
+        memcpy(pEvent->path, pPath, pathLength);
+    }
+
+    pEvent->path[pathLength] = '\0';
+    pEvent->startNs = startNs;
+    pEvent->durationNs = endNs - startNs;
+    pEvent->bytesRead = bytesRead;
+    pEvent->bytesWritten = bytesWritten;
+    pEvent->threadId = pRing->threadId;
+    pEvent->op = op;
+
+    atomic_store_explicit(&pEvent->seq, index+1, memory_order_release);
+    atomic_store_explicit(&pRing->head, index+1, memory_order_release);
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Control
+-----------------------------------------------------------------------------*/
+bool lio_trace_start(const unsigned numEventsPerThread)
+{
+    #if defined(LIGHT_IO_ENABLE_STATS)
+        unsigned numEvents = 1;
+        const unsigned requested = numEventsPerThread ? numEventsPerThread : LIO_TRACE_DEFAULT_NUM_EVENTS;
+
+        while (numEvents < requested && numEvents < (1u << 30))
+        {
+            numEvents <<= 1;
+        }
+
+        atomic_store(&_lioTraceNumEvents, numEvents);
+        atomic_store(&_lioTraceEnabled, true);
+        return true;
+    #else
+        (void)numEventsPerThread;
+        return false;
+    #endif
+}
+
+
+
+void lio_trace_stop(void)
+{
+    atomic_store(&_lioTraceEnabled, false);
+}
+
+
+
+bool lio_trace_is_enabled(void)
+{
+    return atomic_load_explicit(&_lioTraceEnabled, memory_order_relaxed);
+}
+
+
+
+void lio_trace_clear(void)
+{
+    pthread_mutex_lock(&_lioTraceLock);
+
+    for (LioTraceRing* pRing = _pLioTraceRings; pRing; pRing = pRing->pNext)
+    {
+        atomic_store(&pRing->tail, atomic_load(&pRing->head));
+    }
+
+    pthread_mutex_unlock(&_lioTraceLock);
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Chrome trace output
+-----------------------------------------------------------------------------*/
+/*-------------------------------------
+ * Write a string as a JSON string literal
+-------------------------------------*/
+static void _lio_trace_write_string(FILE* const pFile, const char* pStr)
+{
+    fputc('"', pFile);
+
+    for (; *pStr; ++pStr)
+    {
+        const unsigned char c = (unsigned char)*pStr;
+
+        if (c == '"' || c == '\\')
+        {
+            fputc('\\', pFile);
+            fputc(c, pFile);
+        }
+        else if (c < 0x20)
+        {
+            fprintf(pFile, "\\u%04x", c);
+        }
+        else
+        {
+            fputc(c, pFile);
+        }
+    }
+
+    fputc('"', pFile);
+}
+
+
+
+long long lio_trace_write(const char* const pPath)
+{
+    if (!pPath)
+    {
+        lio_error_report(LIO_ERROR_INVALID_ARGUMENT, 0, "Unable to write a trace without a path", NULL, NULL);
+        return -1;
+    }
+
+    FILE* const pFile = fopen(pPath, "w");
+    if (!pFile)
+    {
+        lio_error_report_errno(errno, "Unable to open a trace file", pPath, NULL);
+        return -1;
+    }
+
+    const long pid = (long)getpid();
+    long long numWritten = 0;
+
+    fputs("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[", pFile);
+
+    pthread_mutex_lock(&_lioTraceLock);
+
+    for (LioTraceRing* pRing = _pLioTraceRings; pRing; pRing = pRing->pNext)
+    {
+        const uint64_t head = atomic_load_explicit(&pRing->head, memory_order_acquire);
+        const uint64_t tail = atomic_load_explicit(&pRing->tail, memory_order_relaxed);
+        const uint64_t numEvents = pRing->mask + 1;
+        uint64_t index = (head - tail > numEvents) ? (head - numEvents) : tail;
+
+        for (; index < head; ++index)
+        {
+            LioTraceEvent* const pEvent = pRing->events + (index & pRing->mask);
+            LioTraceEvent event;
+
+            if (atomic_load_explicit(&pEvent->seq, memory_order_acquire) != index+1)
+            {
+                continue;
+            }
+
+            event.startNs = pEvent->startNs;
+            event.durationNs = pEvent->durationNs;
+            event.bytesRead = pEvent->bytesRead;
+            event.bytesWritten = pEvent->bytesWritten;
+            event.threadId = pEvent->threadId;
+            event.op = pEvent->op;
+            memcpy(event.path, pEvent->path, sizeof(event.path));
+            event.path[LIO_TRACE_MAX_PATH-1] = '\0';
+
+            // Skip spans which the owning thread overwrote during the copy
+            atomic_thread_fence(memory_order_acquire);
+            if (atomic_load_explicit(&pEvent->seq, memory_order_relaxed) != index+1)
+            {
+                continue;
+            }
+
+            fprintf(
+                pFile,
+                "%s\n{\"name\":\"%s\",\"cat\":\"light_io\",\"ph\":\"X\",\"ts\":%llu.%03u,\"dur\":%llu.%03u,\"pid\":%ld,\"tid\":%u,\"args\":{\"path\":",
+                numWritten ? "," : "",
+                lio_stats_op_name((enum LioStatsOp)event.op),
+                (unsigned long long)(event.startNs / 1000u), (unsigned)(event.startNs % 1000u),
+                (unsigned long long)(event.durationNs / 1000u), (unsigned)(event.durationNs % 1000u),
+                pid,
+                event.threadId);
+
+            _lio_trace_write_string(pFile, event.path);
+            fprintf(
+                pFile,
+                ",\"bytes_read\":%llu,\"bytes_written\":%llu}}",
+                (unsigned long long)event.bytesRead,
+                (unsigned long long)event.bytesWritten);
+            ++numWritten;
+        }
+    }
+
+    pthread_mutex_unlock(&_lioTraceLock);
+
+    fputs("\n]}\n", pFile);
+
+    const bool failed = ferror(pFile) != 0;
+    if (fclose(pFile) != 0 || failed)
+    {
+        lio_error_report(LIO_ERROR_IO, 0, "Unable to write a trace file", pPath, NULL);
+        return -1;
+    }
+
+    return numWritten;
+}
@@ -0,0 +1,828 @@
+
+// expose O_DIRECTORY, O_NOFOLLOW, fdopendir(), and syscall()
+#ifndef _GNU_SOURCE
+    #define _GNU_SOURCE
+#endif
+
+#include <errno.h>
+#include <pthread.h>
+#include <dirent.h> // fdopendir(), readdir(), closedir()
+#include <fcntl.h> // open(), unlinkat(), fstatat()
+#include <unistd.h> // rmdir(), unlink(), access(), syscall()
+#include <sys/resource.h> // setpriority()
+#include <sys/stat.h> // stat(), mkdir()
+#if defined(__linux__)
+    #include <sys/syscall.h> // SYS_gettid, SYS_ioprio_set
+#endif
+
+#include <stdatomic.h>
+#include <stdint.h> // uint64_t
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "light_io/lio_alloc.h"
+#include "light_io/lio_error.h"
+#include "light_io/lio_utils.h"
+#include "light_io/lio_paths.h"
+#include "light_io/lio_stats.h"
+#include "light_io/lio_statcache.h"
+#include "light_io/lio_trash.h"
+
+
+
+/*-----------------------------------------------------------------------------
+ * Trash structures
+-----------------------------------------------------------------------------*/
+enum
+{
+    LIO_TRASH_ATTEMPTS = 16,   // Names tried before giving up
+    LIO_TRASH_MAX_FOLDERS = 16 // Filesystems whose trash folder is remembered
+};
+
+#define LIO_TRASH_FOLDER_NAME ".lio-trash"
+
+struct LioTrashJob
+{
+    char* pPath;
+    LioTrashCallback callback;
+    void* pUserData;
+    atomic_int error; // First error seen by any worker
+
+    pthread_mutex_t lock;
+    pthread_cond_t done;
+    bool isDone;
+    bool isDetached; // Released by the workers rather than lio_trash_wait()
+};
+
+
+
+/*-------------------------------------
+ * A path being deleted. A folder is only removed once it has been scanned
+ * and each of its subfolders has been removed.
+------------------------------------*/
+typedef struct LioTrashNode
+{
+    char* pPath;
+    struct LioTrashNode* pParent;
+    struct LioTrashNode* pNext;
+    LioTrashJob* pJob;
+    atomic_uint numPending;
+    bool isFolder;
+} LioTrashNode;
+
+
+
+typedef struct LioTrashFolder
+{
+    uint64_t device;
+    char* pPath;
+} LioTrashFolder;
+
+
+
+static pthread_mutex_t _lioTrashLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t _lioTrashWork = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t _lioTrashIdle = PTHREAD_COND_INITIALIZER;
+static LioTrashNode* _lioTrashHead = NULL;
+static LioTrashNode* _lioTrashTail = NULL;
+static unsigned _lioTrashNumJobs = 0;
+static unsigned _lioTrashNumThreads = 0;
+static LioTrashFolder _lioTrashFolders[LIO_TRASH_MAX_FOLDERS];
+static unsigned _lioTrashNumFolders = 0;
+static atomic_uint _lioTrashCounter = 0;
+
+
+
+/*-----------------------------------------------------------------------------
+ * Jobs
+-----------------------------------------------------------------------------*/
+static void _lio_trash_job_destroy(LioTrashJob* const pJob)
+{
+    pthread_cond_destroy(&pJob->done);
+    pthread_mutex_destroy(&pJob->lock);
+    lio_utils_str_destroy(pJob->pPath);
+    lio_alloc_free(pJob);
+}
+
+
+
+static void _lio_trash_fail(LioTrashJob* const pJob, const int err)
+{
+    int expected = 0;
+    atomic_compare_exchange_strong(&pJob->error, &expected, err);
+}
+
+
+
+static void _lio_trash_finish(LioTrashJob* const pJob)
+{
+    if (pJob->callback)
+    {
+        pJob->callback(pJob->pPath, atomic_load(&pJob->error) == 0, pJob->pUserData);
+    }
+
+    pthread_mutex_lock(&pJob->lock);
+    const bool isDetached = pJob->isDetached;
+    pJob->isDone = true;
+    pthread_cond_broadcast(&pJob->done);
+    pthread_mutex_unlock(&pJob->lock);
+
+    // A waiting thread owns the job from here on
+    if (isDetached)
+    {
+        _lio_trash_job_destroy(pJob);
+    }
+
+    pthread_mutex_lock(&_lioTrashLock);
+    if (--_lioTrashNumJobs == 0)
+    {
+        pthread_cond_broadcast(&_lioTrashIdle);
+    }
+    pthread_mutex_unlock(&_lioTrashLock);
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Workers
+-----------------------------------------------------------------------------*/
+static LioTrashNode* _lio_trash_node_create(char* const pPath, LioTrashNode* const pParent, LioTrashJob* const pJob)
+{
+    LioTrashNode* const pNode = pPath ? (LioTrashNode*)lio_alloc_malloc(sizeof(LioTrashNode)) : NULL;
+
+    if (!pNode)
+    {
+        lio_utils_str_destroy(pPath);
+        return NULL;
+    }
+
+    pNode->pPath = pPath;
+    pNode->pParent = pParent;
+    pNode->pNext = NULL;
+    pNode->pJob = pJob;
+    pNode->isFolder = false;
+    atomic_init(&pNode->numPending, 1);
+
+    return pNode;
+}
+
+
+
+/*-------------------------------------
+ * Queue a list of nodes, linked through "pNext"
+------------------------------------*/
+static void _lio_trash_push(LioTrashNode* const pFirst, LioTrashNode* const pLast)
+{
+    pthread_mutex_lock(&_lioTrashLock);
+
+    if (_lioTrashTail)
+    {
+        _lioTrashTail->pNext = pFirst;
+    }
+    else
+    {
+        _lioTrashHead = pFirst;
+    }
+
+    _lioTrashTail = pLast;
+    pthread_cond_broadcast(&_lioTrashWork);
+    pthread_mutex_unlock(&_lioTrashLock);
+}
+
+
+
+/*-------------------------------------
+ * Finish a node, then any parents which were only waiting on it
+------------------------------------*/
+static void _lio_trash_release(LioTrashNode* pNode)
+{
+    while (pNode && atomic_fetch_sub(&pNode->numPending, 1) == 1)
+    {
+        LioTrashNode* const pParent = pNode->pParent;
+
+        LIO_STATS_ADD(LIO_STATS_SYSCALLS, 1);
+        if (pNode->isFolder && rmdir(pNode->pPath) != 0 && errno != ENOENT)
+        {
+            _lio_trash_fail(pNode->pJob, errno);
+        }
+
+        if (!pParent)
+        {
+            _lio_trash_finish(pNode->pJob);
+        }
+
+        lio_utils_str_destroy(pNode->pPath);
+        lio_alloc_free(pNode);
+        pNode = pParent;
+    }
+}
+
+
+
+/*-------------------------------------
+ * Delete the files in a folder and queue its subfolders
+------------------------------------*/
+static void _lio_trash_scan(LioTrashNode* const pNode)
+{
+    LioTrashJob* const pJob = pNode->pJob;
+    int fd = -1;
+
+    do
+    {
+        fd = open(pNode->pPath, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+        LIO_STATS_ADD(LIO_STATS_SYSCALLS, 1);
+    }
+    while (fd < 0 && errno == EINTR);
+
+    // Files and symbolic links fail to open as folders
+    if (fd < 0)
+    {
+        if ((errno == ENOTDIR || errno == ELOOP) && unlink(pNode->pPath) != 0 && errno != ENOENT)
+        {
+            _lio_trash_fail(pJob, errno);
+        }
+        else if (errno != ENOTDIR && errno != ELOOP && errno != ENOENT)
+        {
+            _lio_trash_fail(pJob, errno);
+        }
+
+        _lio_trash_release(pNode);
+        return;
+    }
+
+    DIR* const pDir = fdopendir(fd);
+    if (!pDir)
+    {
+        _lio_trash_fail(pJob, errno);
+        close(fd);
+        _lio_trash_release(pNode);
+        return;
+    }
+
+    pNode->isFolder = true;
+
+    LioTrashNode* pFirst = NULL;
+    LioTrashNode* pLast = NULL;
+    const struct dirent* pEntry = NULL;
+
+    while ((pEntry = readdir(pDir)) != NULL)
+    {
+        const char* const pName = pEntry->d_name;
+
+        if (pName[0] == '.' && (pName[1] == '\0' || (pName[1] == '.' && pName[2] == '\0')))
+        {
+            continue;
+        }
+
+        LIO_STATS_ADD(LIO_STATS_ENTRIES_SCANNED, 1);
+
+        bool isFolder = pEntry->d_type == DT_DIR;
+        if (pEntry->d_type == DT_UNKNOWN)
+        {
+            struct stat info;
+            isFolder = fstatat(fd, pName, &info, AT_SYMLINK_NOFOLLOW) == 0 && S_ISDIR(info.st_mode);
+            LIO_STATS_ADD(LIO_STATS_SYSCALLS, 1);
+        }
+
+        if (!isFolder)
+        {
+            LIO_STATS_ADD(LIO_STATS_SYSCALLS, 1);
+            if (unlinkat(fd, pName, 0) != 0 && errno != ENOENT)
+            {
+                _lio_trash_fail(pJob, errno);
+            }
+            continue;
+        }
+
+        LioTrashNode* const pChild = _lio_trash_node_create(lio_utils_str_fmt("%s/%s", pNode->pPath, pName), pNode, pJob);
+        if (!pChild)
+        {
+            _lio_trash_fail(pJob, ENOMEM);
+            continue;
+        }
+
+        atomic_fetch_add(&pNode->numPending, 1);
+
+        if (pLast)
+        {
+            pLast->pNext = pChild;
+        }
+        else
+        {
+            pFirst = pChild;
+        }
+        pLast = pChild;
+    }
+
+    closedir(pDir);
+
+    // Subfolders are shared with the other workers
+    if (pFirst)
+    {
+        _lio_trash_push(pFirst, pLast);
+    }
+
+    _lio_trash_release(pNode);
+}
+
+
+
+static void* _lio_trash_worker(void* pData)
+{
+    (void)pData;
+
+    #if defined(__linux__)
+        // Each thread has its own nice value and I/O priority on Linux. The
+        // lowest best-effort I/O level is used rather than the idle class,
+        // which can starve removals on a busy disk.
+        const pid_t tid = (pid_t)syscall(SYS_gettid);
+        setpriority(PRIO_PROCESS, (id_t)tid, LIO_TRASH_NICE);
+        syscall(SYS_ioprio_set, 1, tid, (2 << 13) | 7);
+    #endif
+
+    pthread_mutex_lock(&_lioTrashLock);
+
+    for (;;)
+    {
+        while (!_lioTrashHead)
+        {
+            pthread_cond_wait(&_lioTrashWork, &_lioTrashLock);
+        }
+
+        LioTrashNode* const pNode = _lioTrashHead;
+        _lioTrashHead = pNode->pNext;
+        _lioTrashTail = _lioTrashHead ? _lioTrashTail : NULL;
+        pNode->pNext = NULL;
+
+        pthread_mutex_unlock(&_lioTrashLock);
+        _lio_trash_scan(pNode);
+        pthread_mutex_lock(&_lioTrashLock);
+    }
+
+    return NULL;
+}
+
+
+
+/*-------------------------------------
+ * Start the workers, and count a new job, if they are running
+------------------------------------*/
+static bool _lio_trash_begin_job(void)
+{
+    pthread_mutex_lock(&_lioTrashLock);
+
+    int err = 0;
+    while (_lioTrashNumThreads < LIO_TRASH_NUM_THREADS)
+    {
+        pthread_t thread;
+        err = pthread_create(&thread, NULL, &_lio_trash_worker, NULL);
+        if (err != 0)
+        {
+            break;
+        }
+
+        // Workers live until the process exits, unfinished removals are
+        // left for lio_trash_recover().
+        pthread_detach(thread);
+        ++_lioTrashNumThreads;
+    }
+
+    const bool ret = _lioTrashNumThreads > 0;
+    _lioTrashNumJobs += ret ? 1 : 0;
+
+    pthread_mutex_unlock(&_lioTrashLock);
+
+    if (!ret)
+    {
+        lio_error_report_errno(err, "Unable to start deleting the trash", NULL, NULL);
+    }
+
+    return ret;
+}
+
+
+
+/*-------------------------------------
+ * Hand a path in the trash to the workers
+------------------------------------*/
+static void _lio_trash_queue(
+    char* const pTrashPath,
+    char* const pPath,
+    LioTrashCallback callback,
+    void* const pUserData,
+    LioTrashJob** const ppOutJob)
+{
+    LioTrashJob* const pJob = (LioTrashJob*)lio_alloc_calloc(1, sizeof(LioTrashJob));
+    LioTrashNode* const pNode = pJob ? _lio_trash_node_create(pTrashPath, NULL, pJob) : NULL;
+
+    // The path is already gone, so the deletion itself cannot be reported
+    // as a failure. It is left for lio_trash_recover() instead.
+    if (!pNode)
+    {
+        if (!pJob)
+        {
+            lio_utils_str_destroy(pTrashPath);
+        }
+        lio_alloc_free(pJob);
+        lio_utils_str_destroy(pPath);
+
+        pthread_mutex_lock(&_lioTrashLock);
+        if (--_lioTrashNumJobs == 0)
+        {
+            pthread_cond_broadcast(&_lioTrashIdle);
+        }
+        pthread_mutex_unlock(&_lioTrashLock);
+
+        if (ppOutJob)
+        {
+            *ppOutJob = NULL;
+        }
+        return;
+    }
+
+    pJob->pPath = pPath;
+    pJob->callback = callback;
+    pJob->pUserData = pUserData;
+    pJob->isDetached = ppOutJob == NULL;
+    atomic_init(&pJob->error, 0);
+    pthread_mutex_init(&pJob->lock, NULL);
+    pthread_cond_init(&pJob->done, NULL);
+
+    if (ppOutJob)
+    {
+        *ppOutJob = pJob;
+    }
+
+    _lio_trash_push(pNode, pNode);
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Trash folders
+-----------------------------------------------------------------------------*/
+/*-------------------------------------
+ * Create a trash folder inside another folder
+------------------------------------*/
+static char* _lio_trash_folder_in(const char* const pParent)
+{
+    char* const pTrash = lio_utils_str_fmt("%s%s" LIO_TRASH_FOLDER_NAME, pParent, strcmp(pParent, "/") == 0 ? "" : "/");
+
+    LIO_STATS_ADD(LIO_STATS_SYSCALLS, 1);
+    if (pTrash && mkdir(pTrash, 0700) != 0 && errno != EEXIST)
+    {
+        lio_error_report_errno(errno, "Unable to create a trash folder", pTrash, NULL);
+        lio_utils_str_destroy(pTrash);
+        return NULL;
+    }
+
+    return pTrash;
+}
+
+
+
+/*-------------------------------------
+ * Find the trash folder of the filesystem holding an absolute folder path
+------------------------------------*/
+static char* _lio_trash_folder(const char* const pFolder)
+{
+    struct stat info;
+
+    LIO_STATS_ADD(LIO_STATS_SYSCALLS, 1);
+    if (stat(pFolder, &info) != 0)
+    {
+        lio_error_report_errno(errno, "Unable to find the filesystem of a path", pFolder, NULL);
+        return NULL;
+    }
+
+    const uint64_t device = (uint64_t)info.st_dev;
+
+    pthread_mutex_lock(&_lioTrashLock);
+    for (unsigned i = 0; i < _lioTrashNumFolders; ++i)
+    {
+        if (_lioTrashFolders[i].device == device)
+        {
+            char* const pTrash = lio_utils_str_fmt("%s", _lioTrashFolders[i].pPath);
+            pthread_mutex_unlock(&_lioTrashLock);
+            return pTrash;
+        }
+    }
+    pthread_mutex_unlock(&_lioTrashLock);
+
+    // Climb to the highest writable folder on the same filesystem, so every
+    // removal on it shares one trash folder.
+    char* const pCurrent = lio_utils_str_fmt("%s", pFolder);
+    char* pBest = lio_utils_str_fmt("%s", pFolder);
+
+    while (pCurrent && pBest)
+    {
+        char* const pSep = strrchr(pCurrent, '/');
+        if (!pSep || (pSep == pCurrent && pCurrent[1] == '\0'))
+        {
+            break;
+        }
+
+        pSep[pSep == pCurrent ? 1 : 0] = '\0';
+
+        LIO_STATS_ADD(LIO_STATS_SYSCALLS, 2);
+        if (stat(pCurrent, &info) != 0 || (uint64_t)info.st_dev != device)
+        {
+            break;
+        }
+
+        if (access(pCurrent, W_OK | X_OK) == 0)
+        {
+            lio_utils_str_destroy(pBest);
+            pBest = lio_utils_str_fmt("%s", pCurrent);
+        }
+    }
+
+    char* const pTrash = pBest ? _lio_trash_folder_in(pBest) : NULL;
+
+    lio_utils_str_destroy(pBest);
+    lio_utils_str_destroy(pCurrent);
+
+    if (!pTrash)
+    {
+        return NULL;
+    }
+
+    pthread_mutex_lock(&_lioTrashLock);
+    if (_lioTrashNumFolders < LIO_TRASH_MAX_FOLDERS)
+    {
+        char* const pCached = lio_utils_str_fmt("%s", pTrash);
+        if (pCached)
+        {
+            _lioTrashFolders[_lioTrashNumFolders].device = device;
+            _lioTrashFolders[_lioTrashNumFolders].pPath = pCached;
+            ++_lioTrashNumFolders;
+        }
+    }
+    pthread_mutex_unlock(&_lioTrashLock);
+
+    return pTrash;
+}
+
+
+
+/*-------------------------------------
+ * Forget a remembered trash folder which can no longer be used
+------------------------------------*/
+static void _lio_trash_forget(const char* const pTrash)
+{
+    pthread_mutex_lock(&_lioTrashLock);
+
+    for (unsigned i = 0; i < _lioTrashNumFolders; ++i)
+    {
+        if (strcmp(_lioTrashFolders[i].pPath, pTrash) == 0)
+        {
+            lio_utils_str_destroy(_lioTrashFolders[i].pPath);
+            _lioTrashFolders[i] = _lioTrashFolders[--_lioTrashNumFolders];
+            break;
+        }
+    }
+
+    pthread_mutex_unlock(&_lioTrashLock);
+}
+
+
+
+/*-------------------------------------
+ * Move a path into a trash folder
+------------------------------------*/
+static char* _lio_trash_move(const char* const pPath, const char* const pTrash, int* const pOutError)
+{
+    for (unsigned attempt = 0; attempt < LIO_TRASH_ATTEMPTS; ++attempt)
+    {
+        const unsigned id = atomic_fetch_add_explicit(&_lioTrashCounter, 1, memory_order_relaxed);
+        char* const pEntry = lio_utils_str_fmt("%s/%ld-%u", pTrash, (long)getpid(), id);
+
+        if (!pEntry)
+        {
+            *pOutError = ENOMEM;
+            return NULL;
+        }
+
+        // An old entry left by a process with the same ID may be replaced,
+        // as it was trash anyway.
+        LIO_STATS_ADD(LIO_STATS_SYSCALLS, 1);
+        if (rename(pPath, pEntry) == 0)
+        {
+            return pEntry;
+        }
+
+        *pOutError = errno;
+        lio_utils_str_destroy(pEntry);
+
+        if (*pOutError != EEXIST && *pOutError != ENOTEMPTY && *pOutError != EISDIR && *pOutError != ENOTDIR)
+        {
+            return NULL;
+        }
+    }
+
+    return NULL;
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Asynchronous removal
+-----------------------------------------------------------------------------*/
+static bool _lio_trash_remove(
+    const char* const restrict pPath,
+    LioTrashCallback callback,
+    void* const pUserData,
+    LioTrashJob** const ppOutJob)
+{
+    if (ppOutJob)
+    {
+        *ppOutJob = NULL;
+    }
+
+    if (!pPath || !*pPath)
+    {
+        lio_error_report(LIO_ERROR_INVALID_ARGUMENT, 0, "Unable to remove a path which is empty", NULL, NULL);
+        return false;
+    }
+
+    if (!lio_path_does_exist(pPath, LIO_PATH_TYPE_ANY))
+    {
+        lio_error_report(LIO_ERROR_NOT_FOUND, ENOENT, "Cannot remove a path which does not exist", pPath, NULL);
+        return false;
+    }
+
+    // The folder holding the path is resolved, the path itself may be a link
+    char* const pDirName = lio_path_dirname(pPath);
+    char* const pParent = pDirName ? lio_path_resolve(*pDirName ? pDirName : ".") : NULL;
+    char* pTrash = pParent ? _lio_trash_folder(pParent) : NULL;
+    char* pEntry = NULL;
+    int err = 0;
+
+    if (pTrash && _lio_trash_begin_job())
+    {
+        pEntry = _lio_trash_move(pPath, pTrash, &err);
+
+        // A bind mount can put the path and its filesystem's trash folder in
+        // different mounts, which rename() cannot cross. A remembered trash
+        // folder may also have been deleted since, or be inside the path.
+        if (!pEntry && (err == EXDEV || err == ENOENT || err == EINVAL))
+        {
+            if (err != EXDEV)
+            {
+                _lio_trash_forget(pTrash);
+            }
+
+            lio_utils_str_destroy(pTrash);
+            pTrash = _lio_trash_folder_in(pParent);
+            pEntry = pTrash ? _lio_trash_move(pPath, pTrash, &err) : NULL;
+        }
+
+        if (!pEntry)
+        {
+            lio_error_report_errno(err, "Unable to move a path to the trash", pPath, pTrash);
+
+            pthread_mutex_lock(&_lioTrashLock);
+            if (--_lioTrashNumJobs == 0)
+            {
+                pthread_cond_broadcast(&_lioTrashIdle);
+            }
+            pthread_mutex_unlock(&_lioTrashLock);
+        }
+    }
+
+    lio_utils_str_destroy(pTrash);
+    lio_path_destroy(pParent);
+    lio_path_destroy(pDirName);
+
+    if (!pEntry)
+    {
+        return false;
+    }
+
+    lio_statcache_invalidate(pPath, true);
+    _lio_trash_queue(pEntry, lio_utils_str_fmt("%s", pPath), callback, pUserData, ppOutJob);
+
+    return true;
+}
+
+
+
+bool lio_trash_remove(
+    const char* const restrict pPath,
+    LioTrashCallback callback,
+    void* const pUserData,
+    LioTrashJob** const ppOutJob)
+{
+    LIO_STATS_BEGIN(timer, LIO_STATS_OP_PATH_REMOVE, pPath);
+    const bool ret = _lio_trash_remove(pPath, callback, pUserData, ppOutJob);
+    LIO_STATS_END_CALL(timer, NULL, 1, 0, 1, ret);
+
+    return ret;
+}
+
+
+
+bool lio_trash_wait(LioTrashJob* const pJob)
+{
+    if (!pJob)
+    {
+        lio_error_report(LIO_ERROR_INVALID_ARGUMENT, 0, "Unable to wait for a removal which does not exist", NULL, NULL);
+        return false;
+    }
+
+    pthread_mutex_lock(&pJob->lock);
+    while (!pJob->isDone)
+    {
+        pthread_cond_wait(&pJob->done, &pJob->lock);
+    }
+    pthread_mutex_unlock(&pJob->lock);
+
+    const int err = atomic_load(&pJob->error);
+    if (err)
+    {
+        lio_error_report_errno(err, "Unable to delete a path from the trash", pJob->pPath, NULL);
+    }
+
+    _lio_trash_job_destroy(pJob);
+
+    return err == 0;
+}
+
+
+
+void lio_trash_wait_all(void)
+{
+    pthread_mutex_lock(&_lioTrashLock);
+    while (_lioTrashNumJobs)
+    {
+        pthread_cond_wait(&_lioTrashIdle, &_lioTrashLock);
+    }
+    pthread_mutex_unlock(&_lioTrashLock);
+}
+
+
+
+/*-------------------------------------
+ * Queue every entry of a trash folder
+------------------------------------*/
+static int _lio_trash_recover_folder(const char* const pTrash, LioTrashCallback callback, void* const pUserData)
+{
+    unsigned numEntries = 0;
+    char** const ppEntries = lio_path_list(pTrash, true, NULL, &numEntries);
+    int numQueued = 0;
+
+    if (!ppEntries)
+    {
+        return numEntries ? -1 : 0;
+    }
+
+    for (unsigned i = 0; i < numEntries; ++i)
+    {
+        if (!_lio_trash_begin_job())
+        {
+            numQueued = numQueued ? numQueued : -1;
+            break;
+        }
+
+        _lio_trash_queue(lio_utils_str_fmt("%s", ppEntries[i]), lio_utils_str_fmt("%s", ppEntries[i]), callback, pUserData, NULL);
+        ++numQueued;
+    }
+
+    lio_paths_destroy(ppEntries, numEntries);
+
+    return numQueued;
+}
+
+
+
+int lio_trash_recover(const char* const pPath, LioTrashCallback callback, void* const pUserData)
+{
+    char* const pResolved = pPath ? lio_path_resolve(pPath) : NULL;
+    if (!pResolved)
+    {
+        lio_error_report(LIO_ERROR_NOT_FOUND, ENOENT, "Unable to find the trash of a path which does not exist", pPath, NULL);
+        return -1;
+    }
+
+    // Files are looked up through the folder holding them
+    char* const pFolder = lio_path_does_exist(pResolved, LIO_PATH_TYPE_FOLDER) ? NULL : lio_path_dirname(pResolved);
+    char* const pTrash = _lio_trash_folder(pFolder ? pFolder : pResolved);
+    int ret = pTrash ? _lio_trash_recover_folder(pTrash, callback, pUserData) : -1;
+
+    // The fallback trash used beside bind mounts is only found from inside
+    // the folder it was created in.
+    char* const pLocal = lio_utils_str_fmt("%s/" LIO_TRASH_FOLDER_NAME, pFolder ? pFolder : pResolved);
+    if (ret >= 0 && pLocal && strcmp(pLocal, pTrash) != 0 && lio_path_does_exist(pLocal, LIO_PATH_TYPE_FOLDER))
+    {
+        const int numLocal = _lio_trash_recover_folder(pLocal, callback, pUserData);
+        ret = numLocal < 0 ? numLocal : ret + numLocal;
+    }
+
+    lio_utils_str_destroy(pLocal);
+    lio_utils_str_destroy(pTrash);
+    lio_path_destroy(pFolder);
+    lio_path_destroy(pResolved);
+
+    return ret;
+}
@@ -4,43 +4,69 @@
 #include <stdio.h> // vsnprintf(...)
 #include <string.h> // strlen(...)
 
+#include "light_io/lio_alloc.h"
+#include "light_io/lio_error.h"
 #include "light_io/lio_utils.h"
 
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    #define LIO_UTILS_BSWAP_X86
+    #include <immintrin.h> // _mm_shuffle_epi8(...), _mm256_shuffle_epi8(...)
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    #define LIO_UTILS_BSWAP_NEON
+    #include <arm_neon.h> // vrev16q_u8(...), vrev32q_u8(...), vrev64q_u8(...)
+#endif
+
+#if defined(_MSC_VER)
+    #define LIO_UTILS_BSWAP16( x ) _byteswap_ushort( x )
+    #define LIO_UTILS_BSWAP32( x ) _byteswap_ulong( x )
+    #define LIO_UTILS_BSWAP64( x ) _byteswap_uint64( x )
+#else
+    #define LIO_UTILS_BSWAP16( x ) __builtin_bswap16( x )
+    #define LIO_UTILS_BSWAP32( x ) __builtin_bswap32( x )
+    #define LIO_UTILS_BSWAP64( x ) __builtin_bswap64( x )
+#endif
+
 
 
 char* lio_utils_str_fmt(const char* fmt, ...)
 {
     va_list args;
     char *pStr = NULL;
-    
-    // vsnprintf(...) automatically includes a byte for NULL-termination.
+    char stackBuffer[256];
+
+    // Short strings are formatted once onto the stack, then copied. Only
+    // longer strings need a second pass to format into the heap.
     va_start(args, fmt);
-    const int iNumBytes = vsnprintf(NULL, 0, fmt, args);
+    const int iNumBytes = vsnprintf(stackBuffer, sizeof(stackBuffer), fmt, args);
     va_end(args);
-    
+
     if (iNumBytes <= 0)
     {
         return NULL;
     }
-    
+
+    // vsnprintf(...) automatically includes a byte for NULL-termination.
     const size_t numBytes = (size_t) iNumBytes+1;
-    pStr = (char*) malloc(numBytes);
+    pStr = (char*) lio_alloc_malloc(numBytes);
 
-    if (pStr != NULL)
+    if (pStr != NULL && numBytes <= sizeof(stackBuffer))
+    {
+        memcpy(pStr, stackBuffer, numBytes);
+    }
+    else if (pStr != NULL)
     {
         va_start(args, fmt);
         const long long bytesWritten = vsnprintf(pStr, numBytes, fmt, args) + 1;
         va_end(args);
-    
+
         if ((size_t) bytesWritten != numBytes)
         {
-            static const char err[] = "ERROR: Unable to create a formatted string (wrote %lld/%zu bytes).\n";
-            fprintf(stderr, err, bytesWritten, numBytes);
-            free(pStr);
+            lio_error_report(LIO_ERROR_INVALID_ARGUMENT, 0, "Unable to create a formatted string", NULL, NULL);
+            lio_alloc_free(pStr);
             pStr = NULL;
         }
     }
-    
+
     return pStr;
 }
 
@@ -56,7 +82,7 @@ char* lio_utils_str_copy(const char* str, const size_t maxChars)
     // unsafe warning: maxChars can be bigger than strlen(str)
     const size_t numChars = (maxChars > 0) ? maxChars : strlen(str);
     const size_t numBytes = sizeof(char) * (1 + numChars);
-    char* const pNewStr = (char*)calloc(numChars+1, sizeof(char));
+    char* const pNewStr = (char*)lio_alloc_calloc(numChars+1, sizeof(char));
     
     if (!pNewStr)
     {
@@ -78,7 +104,7 @@ char* lio_utils_str_concat(const char* const str1, const char* const str2)
     const size_t str1Size = strlen(str1);
     const size_t str2Size = strlen(str2);
     const size_t numChars = str1Size + str2Size + 1;
-    char* const pNewStr = (char*)calloc(numChars, sizeof(char));
+    char* const pNewStr = (char*)lio_alloc_calloc(numChars, sizeof(char));
     
     if (!pNewStr)
     {
@@ -99,5 +125,318 @@ char* lio_utils_str_concat(const char* const str1, const char* const str2)
 
 void lio_utils_str_destroy(char* const pStr)
 {
-    free(pStr);
+    lio_alloc_free(pStr);
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Scalar byte-swapping
+ *
+ * Values are copied through memcpy(...) so these functions can operate on
+ * unaligned data and on floating-point arrays without aliasing issues.
+-----------------------------------------------------------------------------*/
+static void _lio_utils_bswap16_scalar(unsigned char* pDst, const unsigned char* pSrc, const size_t count)
+{
+    uint16_t n;
+
+    for (size_t i = 0; i < count; ++i, pDst += sizeof(n), pSrc += sizeof(n))
+    {
+        memcpy(&n, pSrc, sizeof(n));
+        n = LIO_UTILS_BSWAP16(n);
+        memcpy(pDst, &n, sizeof(n));
+    }
+}
+
+
+
+static void _lio_utils_bswap32_scalar(unsigned char* pDst, const unsigned char* pSrc, const size_t count)
+{
+    uint32_t n;
+
+    for (size_t i = 0; i < count; ++i, pDst += sizeof(n), pSrc += sizeof(n))
+    {
+        memcpy(&n, pSrc, sizeof(n));
+        n = LIO_UTILS_BSWAP32(n);
+        memcpy(pDst, &n, sizeof(n));
+    }
+}
+
+
+
+static void _lio_utils_bswap64_scalar(unsigned char* pDst, const unsigned char* pSrc, const size_t count)
+{
+    uint64_t n;
+
+    for (size_t i = 0; i < count; ++i, pDst += sizeof(n), pSrc += sizeof(n))
+    {
+        memcpy(&n, pSrc, sizeof(n));
+        n = LIO_UTILS_BSWAP64(n);
+        memcpy(pDst, &n, sizeof(n));
+    }
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * SIMD byte-swapping
+ *
+ * Each kernel swaps as many whole vectors as possible and returns the number
+ * of bytes processed. The remainder is left to the scalar functions. Every
+ * vector is loaded before it is stored, so in-place swaps are safe.
+-----------------------------------------------------------------------------*/
+#if defined(LIO_UTILS_BSWAP_X86)
+
+// Shuffle masks which reverse each 2, 4, or 8-byte element of a 16-byte lane
+static const unsigned char _LIO_UTILS_BSWAP_MASKS[3][16] = {
+    {1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14},
+    {3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12},
+    {7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8}
+};
+
+
+
+__attribute__((target("ssse3")))
+static size_t _lio_utils_bswap_ssse3(
+    unsigned char* pDst,
+    const unsigned char* pSrc,
+    const size_t numBytes,
+    const unsigned char* pMask)
+{
+    const __m128i mask = _mm_loadu_si128((const __m128i*)pMask);
+    size_t i = 0;
+
+    for (; i + 16 <= numBytes; i += 16)
+    {
+        const __m128i v = _mm_loadu_si128((const __m128i*)(pSrc + i));
+        _mm_storeu_si128((__m128i*)(pDst + i), _mm_shuffle_epi8(v, mask));
+    }
+
+    return i;
+}
+
+
+
+__attribute__((target("avx2")))
+static size_t _lio_utils_bswap_avx2(
+    unsigned char* pDst,
+    const unsigned char* pSrc,
+    const size_t numBytes,
+    const unsigned char* pMask)
+{
+    const __m256i mask = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)pMask));
+    size_t i = 0;
+
+    // Two independent vectors per iteration keep both shuffle ports busy
+    for (; i + 64 <= numBytes; i += 64)
+    {
+        const __m256i a = _mm256_loadu_si256((const __m256i*)(pSrc + i));
+        const __m256i b = _mm256_loadu_si256((const __m256i*)(pSrc + i + 32));
+        _mm256_storeu_si256((__m256i*)(pDst + i), _mm256_shuffle_epi8(a, mask));
+        _mm256_storeu_si256((__m256i*)(pDst + i + 32), _mm256_shuffle_epi8(b, mask));
+    }
+
+    for (; i + 32 <= numBytes; i += 32)
+    {
+        const __m256i v = _mm256_loadu_si256((const __m256i*)(pSrc + i));
+        _mm256_storeu_si256((__m256i*)(pDst + i), _mm256_shuffle_epi8(v, mask));
+    }
+
+    return i;
+}
+
+
+
+typedef size_t (*_LioUtilsBswapKernel)(unsigned char*, const unsigned char*, const size_t, const unsigned char*);
+
+static size_t _lio_utils_bswap_none(
+    unsigned char* pDst,
+    const unsigned char* pSrc,
+    const size_t numBytes,
+    const unsigned char* pMask)
+{
+    (void)pDst;
+    (void)pSrc;
+    (void)numBytes;
+    (void)pMask;
+    return 0;
+}
+
+
+
+/*-------------------------------------
+ * Pick the widest kernel the CPU supports, once. Threads which race here all
+ * store the same pointer.
+------------------------------------*/
+static _LioUtilsBswapKernel _lio_utils_bswap_kernel(void)
+{
+    static _LioUtilsBswapKernel kernel = NULL;
+    _LioUtilsBswapKernel pKernel = __atomic_load_n(&kernel, __ATOMIC_RELAXED);
+
+    if (!pKernel)
+    {
+        __builtin_cpu_init();
+
+        pKernel = __builtin_cpu_supports("avx2")
+            ? &_lio_utils_bswap_avx2
+            : (__builtin_cpu_supports("ssse3") ? &_lio_utils_bswap_ssse3 : &_lio_utils_bswap_none);
+
+        __atomic_store_n(&kernel, pKernel, __ATOMIC_RELAXED);
+    }
+
+    return pKernel;
+}
+
+#endif /* LIO_UTILS_BSWAP_X86 */
+
+
+
+static size_t _lio_utils_bswap_simd(
+    unsigned char* pDst,
+    const unsigned char* pSrc,
+    const size_t numBytes,
+    const size_t elementSize)
+{
+    #if defined(LIO_UTILS_BSWAP_X86)
+        // Arrays shorter than one vector are left to the scalar functions
+        if (numBytes < 16)
+        {
+            return 0;
+        }
+
+        const unsigned char* const pMask = _LIO_UTILS_BSWAP_MASKS[elementSize == 2 ? 0 : (elementSize == 4 ? 1 : 2)];
+        return _lio_utils_bswap_kernel()(pDst, pSrc, numBytes, pMask);
+
+    #elif defined(LIO_UTILS_BSWAP_NEON)
+        size_t i = 0;
+
+        for (; i + 16 <= numBytes; i += 16)
+        {
+            const uint8x16_t v = vld1q_u8(pSrc + i);
+            vst1q_u8(pDst + i, (elementSize == 2) ? vrev16q_u8(v) : ((elementSize == 4) ? vrev32q_u8(v) : vrev64q_u8(v)));
+        }
+
+        return i;
+
+    #else
+        (void)pDst;
+        (void)pSrc;
+        (void)numBytes;
+        (void)elementSize;
+        return 0;
+    #endif
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Array byte-swapping
+-----------------------------------------------------------------------------*/
+void lio_utils_btol_u16_array(uint16_t* pDst, const uint16_t* pSrc, size_t count)
+{
+    if (!pDst || !pSrc)
+    {
+        return;
+    }
+
+    const size_t numSwapped = _lio_utils_bswap_simd((unsigned char*)pDst, (const unsigned char*)pSrc, count*sizeof(uint16_t), sizeof(uint16_t)) / sizeof(uint16_t);
+    _lio_utils_bswap16_scalar((unsigned char*)(pDst+numSwapped), (const unsigned char*)(pSrc+numSwapped), count-numSwapped);
+}
+
+
+
+void lio_utils_btol_u32_array(uint32_t* pDst, const uint32_t* pSrc, size_t count)
+{
+    if (!pDst || !pSrc)
+    {
+        return;
+    }
+
+    const size_t numSwapped = _lio_utils_bswap_simd((unsigned char*)pDst, (const unsigned char*)pSrc, count*sizeof(uint32_t), sizeof(uint32_t)) / sizeof(uint32_t);
+    _lio_utils_bswap32_scalar((unsigned char*)(pDst+numSwapped), (const unsigned char*)(pSrc+numSwapped), count-numSwapped);
+}
+
+
+
+void lio_utils_btol_u64_array(uint64_t* pDst, const uint64_t* pSrc, size_t count)
+{
+    if (!pDst || !pSrc)
+    {
+        return;
+    }
+
+    const size_t numSwapped = _lio_utils_bswap_simd((unsigned char*)pDst, (const unsigned char*)pSrc, count*sizeof(uint64_t), sizeof(uint64_t)) / sizeof(uint64_t);
+    _lio_utils_bswap64_scalar((unsigned char*)(pDst+numSwapped), (const unsigned char*)(pSrc+numSwapped), count-numSwapped);
+}
+
+
+
+void lio_utils_btol_f_array(float* pDst, const float* pSrc, size_t count)
+{
+    if (!pDst || !pSrc)
+    {
+        return;
+    }
+
+    const size_t numSwapped = _lio_utils_bswap_simd((unsigned char*)pDst, (const unsigned char*)pSrc, count*sizeof(float), sizeof(float)) / sizeof(float);
+    _lio_utils_bswap32_scalar((unsigned char*)(pDst+numSwapped), (const unsigned char*)(pSrc+numSwapped), count-numSwapped);
+}
+
+
+
+void lio_utils_btol_d_array(double* pDst, const double* pSrc, size_t count)
+{
+    if (!pDst || !pSrc)
+    {
+        return;
+    }
+
+    const size_t numSwapped = _lio_utils_bswap_simd((unsigned char*)pDst, (const unsigned char*)pSrc, count*sizeof(double), sizeof(double)) / sizeof(double);
+    _lio_utils_bswap64_scalar((unsigned char*)(pDst+numSwapped), (const unsigned char*)(pSrc+numSwapped), count-numSwapped);
+}
+
+
+
+void lio_utils_btol_array(void* pDst, const void* pSrc, size_t count, size_t elementSize)
+{
+    unsigned char* const pOut = (unsigned char*)pDst;
+    const unsigned char* const pIn = (const unsigned char*)pSrc;
+
+    if (!pOut || !pIn)
+    {
+        return;
+    }
+
+    const size_t numBytes = count * elementSize;
+    const size_t numSwapped = (elementSize == 2 || elementSize == 4 || elementSize == 8)
+        ? _lio_utils_bswap_simd(pOut, pIn, numBytes, elementSize)
+        : 0;
+
+    switch (elementSize)
+    {
+        case 2: _lio_utils_bswap16_scalar(pOut+numSwapped, pIn+numSwapped, (numBytes-numSwapped) / 2); break;
+        case 4: _lio_utils_bswap32_scalar(pOut+numSwapped, pIn+numSwapped, (numBytes-numSwapped) / 4); break;
+        case 8: _lio_utils_bswap64_scalar(pOut+numSwapped, pIn+numSwapped, (numBytes-numSwapped) / 8); break;
+        case 1:
+            if (pOut != pIn)
+            {
+                memmove(pOut, pIn, numBytes);
+            }
+            break;
+        default:
+            // Odd sizes are reversed one element at a time, which also works
+            // in-place
+            for (size_t i = 0; elementSize && i < numBytes; i += elementSize)
+            {
+                for (size_t lo = 0; lo < (elementSize+1) / 2; ++lo)
+                {
+                    const size_t hi = elementSize-1-lo;
+                    const unsigned char a = pIn[i+lo];
+                    const unsigned char b = pIn[i+hi];
+                    pOut[i+lo] = b;
+                    pOut[i+hi] = a;
+                }
+            }
+            break;
+    }
 }
@@ -0,0 +1,1054 @@
+
+// expose inotify_init1(), lstat(), and st_mtim
+#ifndef _GNU_SOURCE
+    #define _GNU_SOURCE
+#endif
+
+#if defined(__linux__)
+    #include <errno.h> // errno, EINTR
+    #include <poll.h> // poll()
+    #include <sys/inotify.h> // inotify_init1(), inotify_add_watch(), inotify_rm_watch()
+    #include <sys/stat.h> // lstat()
+    #include <unistd.h> // read(), close()
+#elif defined(_WIN32)
+    #ifndef WIN32_LEAN_AND_MEAN
+        #define WIN32_LEAN_AND_MEAN
+    #endif
+    #include <windows.h> // Sleep()
+#else
+    #include <poll.h> // poll()
+#endif
+
+#include <stdio.h>
+#include <string.h> // memcmp(), memcpy(), memset(), strcmp(), strlen()
+
+#include "light_io/lio_alloc.h"
+#include "light_io/lio_arena.h"
+#include "light_io/lio_error.h"
+#include "light_io/lio_paths.h"
+#include "light_io/lio_strbuf.h"
+#include "light_io/lio_watch.h"
+
+
+
+/*-----------------------------------------------------------------------------
+ * Internal Structures
+ *
+ * Each folder owns the listing read by "lio_dircache_read_folder()". Folders
+ * are found by path when listing and when walking the tree, and by watch
+ * descriptor when reading events. Both tables use linear probing and are
+ * kept at most half full.
+ *
+ * Folders which are removed during a batch are retired rather than freed, as
+ * the batch may still refer to them.
+-----------------------------------------------------------------------------*/
+#ifdef __linux__
+    #define LIO_WATCH_MASK (IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_MODIFY | IN_CLOSE_WRITE | IN_ATTRIB | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR | IN_DONT_FOLLOW | IN_EXCL_UNLINK)
+    #define LIO_WATCH_NSEC(ts) ((int64_t)(ts).tv_sec * 1000000000 + (int64_t)(ts).tv_nsec)
+#endif
+
+enum LioWatchInternalLimits
+{
+    LIO_WATCH_MIN_SLOTS = 64,
+    LIO_WATCH_MIN_ITEMS = 32,
+    LIO_WATCH_EVENT_BUFFER_SIZE = 16384
+};
+
+typedef struct LioWatchFolder
+{
+    char* pPath;
+    size_t pathLength;
+    int wd;
+    bool isDirty;
+    bool isRemoved;
+    LioDirCacheFolder state;
+    LioDirListing listing;
+} LioWatchFolder;
+
+typedef struct LioWatchUpdate
+{
+    LioWatchFolder* pFolder;
+    const char* pName;
+    size_t nameLength;
+} LioWatchUpdate;
+
+
+
+/*-----------------------------------------------------------------------------
+ * Arrays
+-----------------------------------------------------------------------------*/
+/*-------------------------------------
+ * Double the size of an array. Returns NULL and leaves the array untouched if
+ * it could not be resized.
+-------------------------------------*/
+static void* _lio_watch_grow(void* const pItems, size_t* const pCapacity, const size_t itemSize)
+{
+    const size_t capacity = *pCapacity ? *pCapacity * 2 : (size_t)LIO_WATCH_MIN_ITEMS;
+    void* const pNewItems = lio_alloc_realloc(pItems, *pCapacity * itemSize, capacity * itemSize);
+
+    if (pNewItems)
+    {
+        *pCapacity = capacity;
+    }
+
+    return pNewItems;
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Folder Lookups
+-----------------------------------------------------------------------------*/
+static inline size_t _lio_watch_hash_path(const char* const pPath, const size_t length)
+{
+    uint64_t hash = 0xCBF29CE484222325ull;
+
+    for (size_t i = 0; i < length; ++i)
+    {
+        hash = (hash ^ (unsigned char)pPath[i]) * 0x100000001B3ull;
+    }
+
+    return (size_t)(hash ^ (hash >> 32));
+}
+
+
+
+static inline size_t _lio_watch_hash_wd(const int wd)
+{
+    return (size_t)((uint32_t)wd * 0x9E3779B1u);
+}
+
+
+
+static inline size_t _lio_watch_hash_folder(const LioWatchFolder* const pFolder, const bool byWatch)
+{
+    return byWatch ? _lio_watch_hash_wd(pFolder->wd) : _lio_watch_hash_path(pFolder->pPath, pFolder->pathLength);
+}
+
+
+
+/*-------------------------------------
+ * Find the slot of a path, or the empty slot where it belongs
+-------------------------------------*/
+static size_t _lio_watch_path_slot(const LioWatch* const pWatch, const char* const pPath, const size_t length)
+{
+    const size_t mask = pWatch->slotCapacity - 1;
+    size_t slot = _lio_watch_hash_path(pPath, length) & mask;
+
+    while (pWatch->ppPathSlots[slot])
+    {
+        const LioWatchFolder* const pFolder = pWatch->ppPathSlots[slot];
+        if (pFolder->pathLength == length && memcmp(pFolder->pPath, pPath, length) == 0)
+        {
+            break;
+        }
+        slot = (slot + 1) & mask;
+    }
+
+    return slot;
+}
+
+
+
+/*-------------------------------------
+ * Find the slot of a watch descriptor, or the empty slot where it belongs
+-------------------------------------*/
+static size_t _lio_watch_wd_slot(const LioWatch* const pWatch, const int wd)
+{
+    const size_t mask = pWatch->slotCapacity - 1;
+    size_t slot = _lio_watch_hash_wd(wd) & mask;
+
+    while (pWatch->ppWatchSlots[slot] && pWatch->ppWatchSlots[slot]->wd != wd)
+    {
+        slot = (slot + 1) & mask;
+    }
+
+    return slot;
+}
+
+
+
+static inline LioWatchFolder* _lio_watch_find(const LioWatch* const pWatch, const char* const pPath, const size_t length)
+{
+    return pWatch->slotCapacity ? pWatch->ppPathSlots[_lio_watch_path_slot(pWatch, pPath, length)] : NULL;
+}
+
+
+
+/*-------------------------------------
+ * Empty a slot, shifting back any entries which probed past it
+-------------------------------------*/
+static void _lio_watch_erase_slot(LioWatchFolder** const ppSlots, const size_t capacity, size_t slot, const bool byWatch)
+{
+    const size_t mask = capacity - 1;
+    size_t next = slot;
+
+    ppSlots[slot] = NULL;
+
+    for (next = (next + 1) & mask; ppSlots[next]; next = (next + 1) & mask)
+    {
+        const size_t home = _lio_watch_hash_folder(ppSlots[next], byWatch) & mask;
+
+        if (((next - home) & mask) >= ((next - slot) & mask))
+        {
+            ppSlots[slot] = ppSlots[next];
+            ppSlots[next] = NULL;
+            slot = next;
+        }
+    }
+}
+
+
+
+/*-------------------------------------
+ * Make room for one more folder
+-------------------------------------*/
+static bool _lio_watch_reserve_folder(LioWatch* const pWatch)
+{
+    const size_t oldCapacity = pWatch->slotCapacity;
+    LioWatchFolder** const ppOldPaths = pWatch->ppPathSlots;
+    LioWatchFolder** const ppOldWatches = pWatch->ppWatchSlots;
+
+    if ((pWatch->numFolders + 1) * 2 <= oldCapacity)
+    {
+        return true;
+    }
+
+    const size_t capacity = oldCapacity ? oldCapacity * 2 : (size_t)LIO_WATCH_MIN_SLOTS;
+    LioWatchFolder** const ppPaths = (LioWatchFolder**)lio_alloc_calloc(capacity, sizeof(LioWatchFolder*));
+    LioWatchFolder** const ppWatches = (LioWatchFolder**)lio_alloc_calloc(capacity, sizeof(LioWatchFolder*));
+
+    if (!ppPaths || !ppWatches)
+    {
+        lio_alloc_free(ppPaths);
+        lio_alloc_free(ppWatches);
+        return false;
+    }
+
+    pWatch->ppPathSlots = ppPaths;
+    pWatch->ppWatchSlots = ppWatches;
+    pWatch->slotCapacity = capacity;
+
+    for (size_t i = 0; i < oldCapacity; ++i)
+    {
+        if (ppOldPaths[i])
+        {
+            ppPaths[_lio_watch_path_slot(pWatch, ppOldPaths[i]->pPath, ppOldPaths[i]->pathLength)] = ppOldPaths[i];
+        }
+
+        if (ppOldWatches[i])
+        {
+            ppWatches[_lio_watch_wd_slot(pWatch, ppOldWatches[i]->wd)] = ppOldWatches[i];
+        }
+    }
+
+    lio_alloc_free(ppOldPaths);
+    lio_alloc_free(ppOldWatches);
+
+    return true;
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Batches
+-----------------------------------------------------------------------------*/
+/*-------------------------------------
+ * Build the path of an entry in a folder
+-------------------------------------*/
+static const char* _lio_watch_join(LioWatch* const pWatch, const LioWatchFolder* const pFolder, const char* const pName, const size_t nameLength)
+{
+    LioStrBuf* const pPath = &pWatch->path;
+
+    lio_strbuf_truncate(pPath, 0);
+
+    if (!lio_strbuf_append_n(pPath, pFolder->pPath, pFolder->pathLength)
+    || (pFolder->pPath[pFolder->pathLength-1] != LIO_PATH_SEP && !lio_strbuf_append_char(pPath, LIO_PATH_SEP))
+    || !lio_strbuf_append_n(pPath, pName, nameLength))
+    {
+        return NULL;
+    }
+
+    return lio_strbuf_cstr(pPath);
+}
+
+
+
+/*-------------------------------------
+ * Add a change to the current batch
+-------------------------------------*/
+static bool _lio_watch_report(LioWatch* const pWatch, const char* const pPath, const unsigned flags, const uint32_t type)
+{
+    if (pWatch->numChanges == pWatch->changeCapacity)
+    {
+        LioWatchChange* const pChanges = (LioWatchChange*)_lio_watch_grow(pWatch->pChanges, &pWatch->changeCapacity, sizeof(LioWatchChange));
+        if (!pChanges)
+        {
+            return false;
+        }
+        pWatch->pChanges = pChanges;
+    }
+
+    LioWatchChange* const pChange = pWatch->pChanges + pWatch->numChanges;
+    pChange->pPath = lio_arena_str_copy(&pWatch->batch, pPath, 0);
+    pChange->flags = flags;
+    pChange->type = type;
+
+    if (!pChange->pPath)
+    {
+        return false;
+    }
+
+    ++pWatch->numChanges;
+    return true;
+}
+
+
+
+/*-------------------------------------
+ * Queue a folder to be rescanned
+-------------------------------------*/
+static bool _lio_watch_mark(LioWatch* const pWatch, LioWatchFolder* const pFolder)
+{
+    if (pFolder->isDirty)
+    {
+        return true;
+    }
+
+    if (pWatch->numDirty == pWatch->dirtyCapacity)
+    {
+        LioWatchFolder** const ppDirty = (LioWatchFolder**)_lio_watch_grow(pWatch->ppDirty, &pWatch->dirtyCapacity, sizeof(LioWatchFolder*));
+        if (!ppDirty)
+        {
+            return false;
+        }
+        pWatch->ppDirty = ppDirty;
+    }
+
+    pWatch->ppDirty[pWatch->numDirty++] = pFolder;
+    pFolder->isDirty = true;
+
+    return true;
+}
+
+
+
+/*-------------------------------------
+ * Free a folder which is no longer in either table
+-------------------------------------*/
+static void _lio_watch_free_folder(LioWatchFolder* const pFolder)
+{
+    lio_dirlisting_free(&pFolder->listing);
+    lio_alloc_free(pFolder->pPath);
+    lio_alloc_free(pFolder);
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Tree Maintenance
+-----------------------------------------------------------------------------*/
+/*-------------------------------------
+ * Stop tracking a folder and everything beneath it
+-------------------------------------*/
+static void _lio_watch_drop_folder(LioWatch* const pWatch, LioWatchFolder* const pFolder)
+{
+    const LioDirListing* const pListing = &pFolder->listing;
+
+    for (size_t i = 0; i < pListing->numEntries; ++i)
+    {
+        if (pListing->pEntries[i].type != LIO_PATH_TYPE_FOLDER)
+        {
+            continue;
+        }
+
+        const char* const pChildPath = _lio_watch_join(pWatch, pFolder, lio_dirlisting_name(pListing, i), pListing->pEntries[i].nameLength);
+        LioWatchFolder* const pChild = pChildPath ? _lio_watch_find(pWatch, pChildPath, pWatch->path.length) : NULL;
+
+        if (pChild)
+        {
+            _lio_watch_drop_folder(pWatch, pChild);
+        }
+    }
+
+    const size_t slot = _lio_watch_path_slot(pWatch, pFolder->pPath, pFolder->pathLength);
+    if (pWatch->ppPathSlots[slot] == pFolder)
+    {
+        _lio_watch_erase_slot(pWatch->ppPathSlots, pWatch->slotCapacity, slot, false);
+    }
+
+    if (pFolder->wd >= 0)
+    {
+        const size_t watchSlot = _lio_watch_wd_slot(pWatch, pFolder->wd);
+        if (pWatch->ppWatchSlots[watchSlot] == pFolder)
+        {
+            _lio_watch_erase_slot(pWatch->ppWatchSlots, pWatch->slotCapacity, watchSlot, true);
+        }
+
+        #ifdef __linux__
+            inotify_rm_watch(pWatch->fd, pFolder->wd);
+        #endif
+    }
+    else
+    {
+        --pWatch->numUnwatched;
+    }
+
+    --pWatch->numFolders;
+    pFolder->isRemoved = true;
+
+    if (pWatch->numRetired == pWatch->retiredCapacity)
+    {
+        LioWatchFolder** const ppRetired = (LioWatchFolder**)_lio_watch_grow(pWatch->ppRetired, &pWatch->retiredCapacity, sizeof(LioWatchFolder*));
+        if (ppRetired)
+        {
+            pWatch->ppRetired = ppRetired;
+        }
+    }
+
+    if (pWatch->numRetired < pWatch->retiredCapacity)
+    {
+        pWatch->ppRetired[pWatch->numRetired++] = pFolder;
+        return;
+    }
+
+    // Without room to retire the folder, clear every reference to it first
+    for (size_t i = 0; i < pWatch->numDirty; ++i)
+    {
+        if (pWatch->ppDirty[i] == pFolder)
+        {
+            pWatch->ppDirty[i] = NULL;
+        }
+    }
+
+    for (size_t i = 0; i < pWatch->numUpdates; ++i)
+    {
+        if (pWatch->pUpdates[i].pFolder == pFolder)
+        {
+            pWatch->pUpdates[i].pFolder = NULL;
+        }
+    }
+
+    _lio_watch_free_folder(pFolder);
+}
+
+
+
+/*-------------------------------------
+ * Watch and scan a folder and everything beneath it. Every entry is reported
+ * as added if "report" is set.
+-------------------------------------*/
+static LioWatchFolder* _lio_watch_add_folder(LioWatch* const pWatch, const char* const pPath, const size_t length, const bool report)
+{
+    LioWatchFolder* pFolder;
+    LioWatchFolder* pStale;
+
+    if (!_lio_watch_reserve_folder(pWatch))
+    {
+        return NULL;
+    }
+
+    pFolder = (LioWatchFolder*)lio_alloc_calloc(1, sizeof(LioWatchFolder));
+    if (!pFolder)
+    {
+        return NULL;
+    }
+
+    pFolder->pPath = (char*)lio_alloc_malloc(length + 1);
+    if (!pFolder->pPath)
+    {
+        lio_alloc_free(pFolder);
+        return NULL;
+    }
+
+    memcpy(pFolder->pPath, pPath, length);
+    pFolder->pPath[length] = '\0';
+    pFolder->pathLength = length;
+    pFolder->wd = -1;
+
+    pStale = _lio_watch_find(pWatch, pFolder->pPath, length);
+    if (pStale)
+    {
+        _lio_watch_drop_folder(pWatch, pStale);
+    }
+
+    // The watch is added first so nothing is missed while the folder is read
+    #ifdef __linux__
+        if (pWatch->fd >= 0)
+        {
+            pFolder->wd = inotify_add_watch(pWatch->fd, pFolder->pPath, LIO_WATCH_MASK);
+        }
+    #endif
+
+    if (!lio_dircache_read_folder(pFolder->pPath, &pFolder->state, &pFolder->listing))
+    {
+        #ifdef __linux__
+            if (pFolder->wd >= 0 && !(pWatch->ppWatchSlots[_lio_watch_wd_slot(pWatch, pFolder->wd)]))
+            {
+                inotify_rm_watch(pWatch->fd, pFolder->wd);
+            }
+        #endif
+
+        _lio_watch_free_folder(pFolder);
+        return NULL;
+    }
+
+    pWatch->ppPathSlots[_lio_watch_path_slot(pWatch, pFolder->pPath, length)] = pFolder;
+    ++pWatch->numFolders;
+
+    if (pFolder->wd < 0)
+    {
+        ++pWatch->numUnwatched;
+    }
+    else
+    {
+        // A folder moved within the tree keeps its watch descriptor, which may
+        // still belong to the record at its old path
+        const size_t slot = _lio_watch_wd_slot(pWatch, pFolder->wd);
+        if (pWatch->ppWatchSlots[slot])
+        {
+            pWatch->ppWatchSlots[slot]->wd = -1;
+            ++pWatch->numUnwatched;
+        }
+
+        pWatch->ppWatchSlots[slot] = pFolder;
+    }
+
+    for (size_t i = 0; i < pFolder->listing.numEntries; ++i)
+    {
+        const LioDirCacheEntry* const pEntry = pFolder->listing.pEntries + i;
+        const char* const pChildPath = _lio_watch_join(pWatch, pFolder, lio_dirlisting_name(&pFolder->listing, i), pEntry->nameLength);
+
+        if (!pChildPath || (report && !_lio_watch_report(pWatch, pChildPath, LIO_WATCH_ADDED, pEntry->type)))
+        {
+            break;
+        }
+
+        // Folders may vanish while they are being scanned
+        if (pEntry->type == LIO_PATH_TYPE_FOLDER)
+        {
+            _lio_watch_add_folder(pWatch, pChildPath, pWatch->path.length, report);
+        }
+    }
+
+    return pFolder;
+}
+
+
+
+/*-------------------------------------
+ * Reread a folder and report how it differs from its cached listing
+-------------------------------------*/
+static void _lio_watch_rescan(LioWatch* const pWatch, LioWatchFolder* const pFolder)
+{
+    LioDirCacheFolder state;
+    LioDirListing oldListing;
+    LioDirListing newListing;
+    size_t i = 0;
+    size_t j = 0;
+
+    // Folders which vanished are reported by their parent
+    if (!lio_dircache_read_folder(pFolder->pPath, &state, &newListing))
+    {
+        return;
+    }
+
+    oldListing = pFolder->listing;
+
+    while (i < oldListing.numEntries || j < newListing.numEntries)
+    {
+        const LioDirCacheEntry* const pOld = (i < oldListing.numEntries) ? oldListing.pEntries + i : NULL;
+        const LioDirCacheEntry* const pNew = (j < newListing.numEntries) ? newListing.pEntries + j : NULL;
+        const int cmp = !pOld ? 1 : !pNew ? -1 : strcmp(lio_dirlisting_name(&oldListing, i), lio_dirlisting_name(&newListing, j));
+        const char* const pName = (cmp < 0) ? lio_dirlisting_name(&oldListing, i) : lio_dirlisting_name(&newListing, j);
+        const uint32_t nameLength = (cmp < 0) ? pOld->nameLength : pNew->nameLength;
+        const char* pPath;
+        unsigned flags = 0;
+
+        i += (cmp <= 0);
+        j += (cmp >= 0);
+
+        if (cmp < 0)
+        {
+            flags = LIO_WATCH_REMOVED;
+        }
+        else if (cmp > 0)
+        {
+            flags = LIO_WATCH_ADDED;
+        }
+        else if (pOld->type != pNew->type || (pOld->inode != pNew->inode && pNew->type == LIO_PATH_TYPE_FOLDER))
+        {
+            flags = LIO_WATCH_REMOVED | LIO_WATCH_ADDED;
+        }
+        else if (pNew->type != LIO_PATH_TYPE_FOLDER
+        && (pOld->size != pNew->size || pOld->modifiedTime != pNew->modifiedTime || pOld->inode != pNew->inode))
+        {
+            flags = LIO_WATCH_MODIFIED;
+        }
+
+        if (!flags || (pPath = _lio_watch_join(pWatch, pFolder, pName, nameLength)) == NULL)
+        {
+            continue;
+        }
+
+        _lio_watch_report(pWatch, pPath, flags, (cmp < 0) ? pOld->type : pNew->type);
+
+        if ((flags & LIO_WATCH_REMOVED) && pOld->type == LIO_PATH_TYPE_FOLDER)
+        {
+            LioWatchFolder* const pChild = _lio_watch_find(pWatch, pPath, pWatch->path.length);
+            if (pChild)
+            {
+                _lio_watch_drop_folder(pWatch, pChild);
+            }
+
+            pPath = _lio_watch_join(pWatch, pFolder, pName, nameLength);
+        }
+
+        if ((flags & LIO_WATCH_ADDED) && pNew->type == LIO_PATH_TYPE_FOLDER && pPath)
+        {
+            _lio_watch_add_folder(pWatch, pPath, pWatch->path.length, true);
+        }
+    }
+
+    lio_dirlisting_free(&pFolder->listing);
+    pFolder->listing = newListing;
+    pFolder->state = state;
+}
+
+
+
+#ifdef __linux__
+/*-----------------------------------------------------------------------------
+ * Events
+-----------------------------------------------------------------------------*/
+static inline uint32_t _lio_watch_type(const mode_t mode)
+{
+    if (S_ISREG(mode))
+    {
+        return LIO_PATH_TYPE_REGULAR;
+    }
+    else if (S_ISDIR(mode))
+    {
+        return LIO_PATH_TYPE_FOLDER;
+    }
+    else if (S_ISLNK(mode))
+    {
+        return LIO_PATH_TYPE_LINK;
+    }
+
+    return LIO_PATH_TYPE_FILE;
+}
+
+
+
+/*-------------------------------------
+ * Binary search a listing. Returns "numEntries" if not found.
+-------------------------------------*/
+static size_t _lio_watch_find_entry(const LioDirListing* const pListing, const char* const pName)
+{
+    size_t lo = 0;
+    size_t hi = pListing->numEntries;
+
+    while (lo < hi)
+    {
+        const size_t mid = lo + (hi - lo) / 2;
+        const int cmp = strcmp(lio_dirlisting_name(pListing, mid), pName);
+
+        if (cmp == 0)
+        {
+            return mid;
+        }
+
+        if (cmp < 0)
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+
+    return pListing->numEntries;
+}
+
+
+
+/*-------------------------------------
+ * Stop watching a folder through inotify. It will be polled instead.
+-------------------------------------*/
+static void _lio_watch_unwatch(LioWatch* const pWatch, LioWatchFolder* const pFolder)
+{
+    const size_t slot = _lio_watch_wd_slot(pWatch, pFolder->wd);
+
+    if (pWatch->ppWatchSlots[slot] == pFolder)
+    {
+        _lio_watch_erase_slot(pWatch->ppWatchSlots, pWatch->slotCapacity, slot, true);
+    }
+
+    pFolder->wd = -1;
+    ++pWatch->numUnwatched;
+}
+
+
+
+/*-------------------------------------
+ * Read every pending event. Changes to a folder's entries mark it for a
+ * rescan, while writes to a file only queue that file to be stat'ed.
+-------------------------------------*/
+static void _lio_watch_read_events(LioWatch* const pWatch, bool* const pOverflow)
+{
+    _Alignas(struct inotify_event) char buffer[LIO_WATCH_EVENT_BUFFER_SIZE];
+    const uint32_t structureMask = IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF;
+    const uint32_t contentMask = IN_MODIFY | IN_CLOSE_WRITE | IN_ATTRIB;
+
+    for (;;)
+    {
+        const ssize_t numBytes = read(pWatch->fd, buffer, sizeof(buffer));
+
+        if (numBytes < 0 && errno == EINTR)
+        {
+            continue;
+        }
+
+        if (numBytes <= 0)
+        {
+            return;
+        }
+
+        for (const char* pIter = buffer; pIter < buffer + numBytes;)
+        {
+            const struct inotify_event* const pEvent = (const struct inotify_event*)pIter;
+            LioWatchFolder* pFolder;
+            bool ret = true;
+
+            pIter += sizeof(struct inotify_event) + pEvent->len;
+
+            if (pEvent->mask & IN_Q_OVERFLOW)
+            {
+                *pOverflow = true;
+                continue;
+            }
+
+            pFolder = pWatch->ppWatchSlots[_lio_watch_wd_slot(pWatch, pEvent->wd)];
+            if (!pFolder)
+            {
+                continue;
+            }
+
+            if (pEvent->mask & IN_IGNORED)
+            {
+                _lio_watch_unwatch(pWatch, pFolder);
+                ret = _lio_watch_mark(pWatch, pFolder);
+            }
+            else if (pEvent->mask & structureMask)
+            {
+                ret = _lio_watch_mark(pWatch, pFolder);
+            }
+            else if ((pEvent->mask & contentMask) && pEvent->len && !pFolder->isDirty)
+            {
+                if (pWatch->numUpdates == pWatch->updateCapacity)
+                {
+                    LioWatchUpdate* const pUpdates = (LioWatchUpdate*)_lio_watch_grow(pWatch->pUpdates, &pWatch->updateCapacity, sizeof(LioWatchUpdate));
+                    pWatch->pUpdates = pUpdates ? pUpdates : pWatch->pUpdates;
+                    ret = pUpdates != NULL;
+                }
+
+                if (ret)
+                {
+                    LioWatchUpdate* const pUpdate = pWatch->pUpdates + pWatch->numUpdates;
+                    pUpdate->pFolder = pFolder;
+                    pUpdate->nameLength = strlen(pEvent->name);
+                    pUpdate->pName = lio_arena_str_copy(&pWatch->batch, pEvent->name, pUpdate->nameLength);
+                    ret = pUpdate->pName != NULL;
+                    pWatch->numUpdates += ret;
+                }
+            }
+
+            // Without memory to track an event, fall back to checking everything
+            if (!ret)
+            {
+                *pOverflow = true;
+            }
+        }
+    }
+}
+
+
+
+/*-------------------------------------
+ * Stat files which were written to. Anything unexpected rescans the folder.
+-------------------------------------*/
+static void _lio_watch_apply_updates(LioWatch* const pWatch)
+{
+    for (size_t i = 0; i < pWatch->numUpdates; ++i)
+    {
+        const LioWatchUpdate* const pUpdate = pWatch->pUpdates + i;
+        LioWatchFolder* const pFolder = pUpdate->pFolder;
+        const char* pPath;
+        struct stat info;
+        size_t index;
+
+        if (!pFolder || pFolder->isRemoved || pFolder->isDirty)
+        {
+            continue;
+        }
+
+        pPath = _lio_watch_join(pWatch, pFolder, pUpdate->pName, pUpdate->nameLength);
+        index = _lio_watch_find_entry(&pFolder->listing, pUpdate->pName);
+
+        if (!pPath
+        || index == pFolder->listing.numEntries
+        || lstat(pPath, &info) != 0
+        || _lio_watch_type(info.st_mode) != pFolder->listing.pEntries[index].type)
+        {
+            _lio_watch_mark(pWatch, pFolder);
+            continue;
+        }
+
+        LioDirCacheEntry* const pEntry = (LioDirCacheEntry*)pFolder->listing.pEntries + index;
+        if (pEntry->type == LIO_PATH_TYPE_FOLDER
+        || (pEntry->size == (uint64_t)info.st_size && pEntry->modifiedTime == LIO_WATCH_NSEC(info.st_mtim) && pEntry->inode == (uint64_t)info.st_ino))
+        {
+            continue;
+        }
+
+        pEntry->size = (uint64_t)info.st_size;
+        pEntry->inode = (uint64_t)info.st_ino;
+        pEntry->modifiedTime = LIO_WATCH_NSEC(info.st_mtim);
+        _lio_watch_report(pWatch, pPath, LIO_WATCH_MODIFIED, pEntry->type);
+    }
+
+    pWatch->numUpdates = 0;
+}
+#endif /* __linux__ */
+
+
+
+/*-----------------------------------------------------------------------------
+ * Polling
+-----------------------------------------------------------------------------*/
+/*-------------------------------------
+ * Gather and apply every pending change
+-------------------------------------*/
+static void _lio_watch_collect(LioWatch* const pWatch)
+{
+    bool overflow = false;
+
+    #ifdef __linux__
+        if (pWatch->fd >= 0)
+        {
+            _lio_watch_read_events(pWatch, &overflow);
+            _lio_watch_apply_updates(pWatch);
+        }
+    #endif
+
+    // Folders without a watch, or all of them if events were lost, are
+    // compared against the disk
+    if (overflow || pWatch->numUnwatched)
+    {
+        for (size_t i = 0; i < pWatch->slotCapacity; ++i)
+        {
+            LioWatchFolder* const pFolder = pWatch->ppPathSlots[i];
+
+            if (pFolder && (overflow || pFolder->wd < 0) && !lio_dircache_is_current(pFolder->pPath, &pFolder->state))
+            {
+                _lio_watch_mark(pWatch, pFolder);
+            }
+        }
+    }
+
+    for (size_t i = 0; i < pWatch->numDirty; ++i)
+    {
+        LioWatchFolder* const pFolder = pWatch->ppDirty[i];
+
+        if (pFolder)
+        {
+            pFolder->isDirty = false;
+            if (!pFolder->isRemoved)
+            {
+                _lio_watch_rescan(pWatch, pFolder);
+            }
+        }
+    }
+
+    for (size_t i = 0; i < pWatch->numRetired; ++i)
+    {
+        _lio_watch_free_folder(pWatch->ppRetired[i]);
+    }
+
+    pWatch->numDirty = 0;
+    pWatch->numRetired = 0;
+}
+
+
+
+/*-------------------------------------
+ * Wait for events, or until polled folders should be checked again
+-------------------------------------*/
+static void _lio_watch_wait(const LioWatch* const pWatch, int timeoutMs)
+{
+    if (pWatch->numUnwatched && (timeoutMs < 0 || timeoutMs > LIO_WATCH_POLL_MS))
+    {
+        timeoutMs = LIO_WATCH_POLL_MS;
+    }
+
+    #if defined(__linux__)
+        struct pollfd pfd;
+        pfd.fd = pWatch->fd;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+        poll(&pfd, pWatch->fd >= 0 ? 1 : 0, timeoutMs);
+    #elif defined(_WIN32)
+        Sleep((DWORD)timeoutMs);
+    #else
+        poll(NULL, 0, timeoutMs);
+    #endif
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Watch Management
+-----------------------------------------------------------------------------*/
+/*-------------------------------------
+ * Initialization
+-------------------------------------*/
+bool lio_watch_init(LioWatch* const pWatch, const char* const rootDir)
+{
+    char* pRoot;
+    size_t length;
+
+    memset(pWatch, 0, sizeof(LioWatch));
+    pWatch->fd = -1;
+    lio_arena_init(&pWatch->batch, 0);
+    lio_strbuf_init(&pWatch->path);
+    lio_strbuf_init(&pWatch->root);
+
+    pRoot = lio_path_resolve(rootDir);
+    length = pRoot ? strlen(pRoot) : 0;
+    while (length > 1 && pRoot[length-1] == LIO_PATH_SEP)
+    {
+        --length;
+    }
+
+    if (!pRoot || !lio_strbuf_append_n(&pWatch->root, pRoot, length))
+    {
+        lio_path_destroy(pRoot);
+        lio_watch_terminate(pWatch);
+        return false;
+    }
+
+    lio_path_destroy(pRoot);
+
+    // Every folder is polled if inotify is unavailable
+    #ifdef __linux__
+        pWatch->fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    #endif
+
+    if (!_lio_watch_add_folder(pWatch, lio_strbuf_cstr(&pWatch->root), pWatch->root.length, false))
+    {
+        lio_error_report(LIO_ERROR_IO, 0, "Unable to scan a folder", rootDir, NULL);
+        lio_watch_terminate(pWatch);
+        return false;
+    }
+
+    return true;
+}
+
+
+
+/*-------------------------------------
+ * Termination
+-------------------------------------*/
+void lio_watch_terminate(LioWatch* const pWatch)
+{
+    for (size_t i = 0; i < pWatch->slotCapacity; ++i)
+    {
+        if (pWatch->ppPathSlots[i])
+        {
+            _lio_watch_free_folder(pWatch->ppPathSlots[i]);
+        }
+    }
+
+    #ifdef __linux__
+        if (pWatch->fd >= 0)
+        {
+            close(pWatch->fd);
+        }
+    #endif
+
+    lio_alloc_free(pWatch->ppPathSlots);
+    lio_alloc_free(pWatch->ppWatchSlots);
+    lio_alloc_free(pWatch->ppDirty);
+    lio_alloc_free(pWatch->ppRetired);
+    lio_alloc_free(pWatch->pUpdates);
+    lio_alloc_free(pWatch->pChanges);
+    lio_arena_terminate(&pWatch->batch);
+    lio_strbuf_terminate(&pWatch->path);
+    lio_strbuf_terminate(&pWatch->root);
+
+    memset(pWatch, 0, sizeof(LioWatch));
+    pWatch->fd = -1;
+}
+
+
+
+/*-------------------------------------
+ * Event descriptor
+-------------------------------------*/
+int lio_watch_fd(const LioWatch* const pWatch)
+{
+    return pWatch->fd;
+}
+
+
+
+/*-------------------------------------
+ * Process changes
+-------------------------------------*/
+size_t lio_watch_poll(LioWatch* const pWatch, const int timeoutMs, LioWatchCallback callback, void* const pUserData)
+{
+    lio_arena_reset(&pWatch->batch);
+    pWatch->numChanges = 0;
+
+    _lio_watch_collect(pWatch);
+
+    if (!pWatch->numChanges && timeoutMs)
+    {
+        _lio_watch_wait(pWatch, timeoutMs);
+        _lio_watch_collect(pWatch);
+    }
+
+    if (pWatch->numChanges && callback)
+    {
+        callback(pWatch->pChanges, pWatch->numChanges, pUserData);
+    }
+
+    return pWatch->numChanges;
+}
+
+
+
+/*-------------------------------------
+ * In-memory listing
+-------------------------------------*/
+bool lio_watch_list(const LioWatch* const pWatch, const char* const dirPath, LioDirListing* const pOutListing)
+{
+    size_t length = strlen(dirPath);
+    const LioWatchFolder* pFolder;
+
+    while (length > 1 && dirPath[length-1] == LIO_PATH_SEP)
+    {
+        --length;
+    }
+
+    pFolder = _lio_watch_find(pWatch, dirPath, length);
+    if (!pFolder)
+    {
+        return false;
+    }
+
+    *pOutListing = pFolder->listing;
+    return true;
+}
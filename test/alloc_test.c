@@ -0,0 +1,292 @@
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "light_io/lio_alloc.h"
+#include "light_io/lio_error.h"
+#include "light_io/lio_utils.h"
+#include "light_io/lio_strbuf.h"
+#include "light_io/lio_arena.h"
+#include "light_io/lio_paths.h"
+#include "light_io/lio_files.h"
+#include "light_io/lio_binio.h"
+#include "light_io/lio_bufpool.h"
+
+
+
+/*-----------------------------------------------------------------------------
+ * Counting allocator
+ *
+ * Each allocation is prefixed with a header which records its size, so that
+ * frees of memory which did not come from these hooks, and incorrect sizes
+ * passed to "reallocate()", can be detected.
+-----------------------------------------------------------------------------*/
+#define ALLOC_TEST_MAGIC 0x4C494F41u
+#define ALLOC_TEST_HEADER_SIZE 16u
+
+typedef struct AllocStats
+{
+    unsigned long numAllocs;
+    unsigned long numReallocs;
+    unsigned long numFrees;
+    unsigned long numErrors;
+    unsigned long failAfter; // Allocations which succeed before the rest fail, or 0
+    long long numOutstanding;
+} AllocStats;
+
+
+
+static void* count_allocate(void* pUserData, size_t numBytes)
+{
+    AllocStats* const pStats = (AllocStats*)pUserData;
+
+    if (pStats->failAfter && pStats->numAllocs >= pStats->failAfter)
+    {
+        return NULL;
+    }
+
+    unsigned char* const pMem = (unsigned char*)malloc(ALLOC_TEST_HEADER_SIZE + numBytes);
+
+    if (!pMem)
+    {
+        return NULL;
+    }
+
+    const uint32_t magic = ALLOC_TEST_MAGIC;
+    const uint64_t size = numBytes;
+    memcpy(pMem, &magic, sizeof(magic));
+    memcpy(pMem + 8, &size, sizeof(size));
+
+    ++pStats->numAllocs;
+    ++pStats->numOutstanding;
+
+    return pMem + ALLOC_TEST_HEADER_SIZE;
+}
+
+
+
+static unsigned char* count_check(AllocStats* const pStats, void* const pMem, uint64_t* const pOutSize)
+{
+    unsigned char* const pBase = (unsigned char*)pMem - ALLOC_TEST_HEADER_SIZE;
+    uint32_t magic;
+
+    memcpy(&magic, pBase, sizeof(magic));
+    memcpy(pOutSize, pBase + 8, sizeof(*pOutSize));
+
+    if (magic != ALLOC_TEST_MAGIC)
+    {
+        ++pStats->numErrors;
+        return NULL;
+    }
+
+    return pBase;
+}
+
+
+
+static void* count_reallocate(void* pUserData, void* pMem, size_t oldSize, size_t newSize)
+{
+    AllocStats* const pStats = (AllocStats*)pUserData;
+    uint64_t size = 0;
+    unsigned char* const pBase = count_check(pStats, pMem, &size);
+
+    if (!pBase || size != oldSize)
+    {
+        ++pStats->numErrors;
+        return NULL;
+    }
+
+    unsigned char* const pNewMem = (unsigned char*)realloc(pBase, ALLOC_TEST_HEADER_SIZE + newSize);
+    if (!pNewMem)
+    {
+        return NULL;
+    }
+
+    size = newSize;
+    memcpy(pNewMem + 8, &size, sizeof(size));
+    ++pStats->numReallocs;
+
+    return pNewMem + ALLOC_TEST_HEADER_SIZE;
+}
+
+
+
+static void count_deallocate(void* pUserData, void* pMem)
+{
+    AllocStats* const pStats = (AllocStats*)pUserData;
+    uint64_t size = 0;
+    unsigned char* const pBase = count_check(pStats, pMem, &size);
+
+    if (pBase)
+    {
+        memset(pBase, 0, sizeof(uint32_t));
+        free(pBase);
+        ++pStats->numFrees;
+        --pStats->numOutstanding;
+    }
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Exercise the allocating functions of the library
+-----------------------------------------------------------------------------*/
+static int exercise_library(const char* const argv0)
+{
+    int ret = 1;
+    unsigned numPaths = 0u;
+    unsigned numParts = 0u;
+    size_t numBytes = 0;
+    char* pCwd = lio_path_dirname(argv0);
+    char* pResolved = lio_path_resolve(pCwd);
+    char* pBase = lio_path_basename(argv0);
+    char* pSrc = lio_path_join(pResolved, "alloc_test.src");
+    char* pCopy = lio_utils_str_fmt("%s.%s", pSrc, "copy");
+    char** pPaths = lio_path_list(pResolved, false, NULL, &numPaths);
+    char** pParts = NULL;
+    char* pData = NULL;
+    LioFile file = lio_file_wrap(-1);
+    LioStrBuf buf;
+    LioArena arena;
+    LioBinWriter writer;
+    LioBinReader reader;
+
+    lio_strbuf_init(&buf);
+    lio_arena_init(&arena, 0);
+
+    ret = ret && pCwd && pResolved && pBase && pSrc && pCopy && pPaths;
+    ret = ret && lio_strbuf_appendf(&buf, "%s/%u", pResolved, numPaths);
+    ret = ret && lio_path_list_arena(pResolved, false, NULL, &arena, &numPaths) != NULL;
+
+    // File I/O, binary writing, and reading
+    ret = ret && lio_file_open(&file, pSrc, LIO_FILE_OPEN_WRITE|LIO_FILE_OPEN_CREATE|LIO_FILE_OPEN_TRUNCATE);
+    ret = ret && lio_binwriter_init_file(&writer, &file, 16, LIO_BYTE_ORDER_BIG);
+    for (unsigned i = 0u; ret && i < 1000u; ++i)
+    {
+        ret = lio_binwriter_reserve(&writer, 4);
+        lio_binwriter_put_u32(&writer, i | 0x0A000000u);
+    }
+    ret = lio_binwriter_terminate(&writer) && ret;
+    lio_file_close(&file);
+
+    ret = ret && lio_file_copy(pSrc, pCopy, true);
+    ret = ret && lio_file_open(&file, pCopy, LIO_FILE_OPEN_READ);
+    ret = ret && (pData = lio_file_read_all(&file, &numBytes)) != NULL && numBytes == 4000;
+    ret = ret && lio_binreader_init_file(&reader, &file, 8, LIO_BYTE_ORDER_BIG);
+    ret = ret && lio_binreader_skip(&reader, 16) && !lio_binreader_require(&reader, 4096);
+    lio_binreader_terminate(&reader);
+    lio_file_close(&file);
+
+    ret = ret && (pParts = lio_file_split(pSrc, pSrc, LIO_FILE_SPLIT_COUNT, 3, LIO_FILE_SPLIT_NO_DELIMITER, &numParts)) != NULL;
+    ret = ret && lio_file_concat_many((const char* const*)pParts, numParts, pCopy, true);
+
+    for (unsigned i = 0u; pParts && i < numParts; ++i)
+    {
+        lio_path_remove(pParts[i], false, false);
+    }
+
+    if (pSrc)
+    {
+        lio_path_remove(pSrc, false, false);
+    }
+
+    if (pCopy)
+    {
+        lio_path_remove(pCopy, false, false);
+    }
+
+    lio_paths_destroy(pParts, numParts);
+    lio_utils_str_destroy(pData);
+    lio_arena_terminate(&arena);
+    lio_strbuf_terminate(&buf);
+    lio_paths_destroy(pPaths, numPaths);
+    lio_utils_str_destroy(pCopy);
+    lio_path_destroy(pSrc);
+    lio_path_destroy(pBase);
+    lio_path_destroy(pResolved);
+    lio_path_destroy(pCwd);
+
+    return ret;
+}
+
+
+
+int main(int argc, char* argv[])
+{
+    int ret = 0;
+    int testId = 0;
+    AllocStats stats;
+    LioAllocator allocator;
+
+    (void)argc;
+    memset(&stats, 0, sizeof(stats));
+
+    // The process-wide buffer pool lives until exit, so it is created before
+    // any allocations are counted.
+    #ifndef _WIN32
+        (void)lio_bufpool_shared();
+    #endif
+
+    allocator.allocate = &count_allocate;
+    allocator.reallocate = &count_reallocate;
+    allocator.deallocate = &count_deallocate;
+    allocator.pUserData = &stats;
+    lio_alloc_set_allocator(&allocator);
+
+    // Test that the library can run entirely on custom allocation hooks
+    ++testId;
+    if (!exercise_library(argv[0]))
+    {
+        fprintf(stderr, "Unable to exercise the library with custom allocation hooks.\n");
+        ret = testId;
+        goto end;
+    }
+    printf("Successfully used custom allocation hooks:\n\t%lu allocations, %lu reallocations, %lu frees\n", stats.numAllocs, stats.numReallocs, stats.numFrees);
+
+    // Test that running out of memory part-way through a listing fails it,
+    // rather than returning the entries which were copied so far
+    ++testId;
+    {
+        char* const pCwd = lio_path_dirname(argv[0]);
+        char* const pResolved = pCwd ? lio_path_resolve(pCwd) : NULL;
+        const unsigned numEntries = pResolved ? lio_path_count_entries(pResolved, false, NULL) : 0u;
+        unsigned numPaths = 0u;
+
+        lio_error_clear();
+        stats.failAfter = stats.numAllocs + 8u;
+        char** const pPaths = (numEntries > 16u) ? lio_path_list(pResolved, false, NULL, &numPaths) : NULL;
+        stats.failAfter = 0u;
+
+        const LioError* const pError = lio_error_last();
+        const int listRet = numEntries > 16u && !pPaths && pError && pError->code == LIO_ERROR_OUT_OF_MEMORY;
+
+        lio_paths_destroy(pPaths, numPaths);
+        lio_path_destroy(pResolved);
+        lio_path_destroy(pCwd);
+
+        if (!listRet)
+        {
+            fprintf(stderr, "A directory listing did not fail when memory ran out.\n");
+            ret = testId;
+            goto end;
+        }
+        printf("Successfully failed a directory listing which ran out of memory.\n");
+    }
+
+    // Test that every allocation went through, and was returned to, the hooks
+    ++testId;
+    if (!stats.numAllocs || !stats.numReallocs || stats.numOutstanding != 0 || stats.numErrors != 0)
+    {
+        fprintf(stderr, "Allocation hooks were bypassed: %lld outstanding, %lu errors.\n", stats.numOutstanding, stats.numErrors);
+        ret = testId;
+        goto end;
+    }
+    printf("Successfully balanced all allocations.\n");
+
+    end:
+    lio_alloc_set_allocator(NULL);
+
+    return ret;
+}
@@ -0,0 +1,232 @@
+
+#define _XOPEN_SOURCE 700 // nanosleep()
+
+#include <pthread.h>
+#include <time.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "light_io/lio_files.h"
+#include "light_io/lio_paths.h"
+#include "light_io/lio_utils.h"
+#include "light_io/lio_appender.h"
+
+
+
+enum
+{
+    APPENDER_TEST_NUM_THREADS = 4,
+    APPENDER_TEST_NUM_RECORDS = 2000,
+    APPENDER_TEST_RECORD_SIZE = 16,
+    APPENDER_TEST_SYNC_EVERY  = 100
+};
+
+
+
+typedef struct AppenderTestThread
+{
+    LioAppender* pAppender;
+    unsigned id;
+    bool valid;
+} AppenderTestThread;
+
+
+
+/*-----------------------------------------------------------------------------
+ * Append fixed-size records, syncing every so often
+-----------------------------------------------------------------------------*/
+static void* appender_test_thread(void* pData)
+{
+    AppenderTestThread* const pThread = (AppenderTestThread*)pData;
+    char record[APPENDER_TEST_RECORD_SIZE+1];
+
+    pThread->valid = true;
+
+    for (unsigned i = 0; pThread->valid && i < APPENDER_TEST_NUM_RECORDS; ++i)
+    {
+        snprintf(record, sizeof(record), "t%02u r%010u\n", pThread->id, i);
+
+        const int64_t offset = lio_appender_append(pThread->pAppender, record, APPENDER_TEST_RECORD_SIZE);
+        pThread->valid = offset >= 0 && offset % APPENDER_TEST_RECORD_SIZE == 0;
+
+        if (pThread->valid && i % APPENDER_TEST_SYNC_EVERY == 0)
+        {
+            pThread->valid = lio_appender_sync(pThread->pAppender);
+        }
+    }
+
+    return NULL;
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Wait for a background flush
+-----------------------------------------------------------------------------*/
+static bool appender_test_wait_for_sync(const LioAppender* const pAppender, const uint64_t numSyncs)
+{
+    const struct timespec delay = {0, 1000000};
+
+    for (unsigned i = 0; i < 5000; ++i)
+    {
+        if (lio_appender_num_syncs(pAppender) > numSyncs)
+        {
+            return true;
+        }
+
+        nanosleep(&delay, NULL);
+    }
+
+    return false;
+}
+
+
+
+int main(int argc, char* argv[])
+{
+    int ret = 0;
+    int testId = 0;
+    char* pExeDir = lio_path_dirname(argv[0]);
+    char* pCwd = lio_path_resolve(pExeDir);
+    char* pLog = NULL;
+    char* pData = NULL;
+    size_t numBytes = 0;
+    LioAppender* pAppender = NULL;
+    LioFile file = lio_file_wrap(-1);
+
+    (void)argc;
+
+    ++testId;
+    pLog = lio_utils_str_fmt("%s%cappender_test.log", pCwd, LIO_PATH_SEP);
+    pAppender = pLog ? lio_appender_create(pLog, 4096, 0, 0, LIO_APPENDER_TRUNCATE) : NULL;
+    if (!pAppender || lio_appender_size(pAppender) != 0)
+    {
+        fprintf(stderr, "Unable to create an appender.\n");
+        ret = testId;
+        goto end;
+    }
+    printf("Created an appender:\n\t%s\n", pLog);
+
+    // Test that records from several threads are never interleaved
+    ++testId;
+    {
+        pthread_t threads[APPENDER_TEST_NUM_THREADS];
+        AppenderTestThread params[APPENDER_TEST_NUM_THREADS];
+        unsigned numPerThread[APPENDER_TEST_NUM_THREADS] = {0};
+        unsigned numStarted = 0;
+        bool valid = true;
+
+        for (; numStarted < APPENDER_TEST_NUM_THREADS; ++numStarted)
+        {
+            params[numStarted].pAppender = pAppender;
+            params[numStarted].id = numStarted;
+
+            if (pthread_create(threads+numStarted, NULL, &appender_test_thread, params+numStarted) != 0)
+            {
+                break;
+            }
+        }
+
+        for (unsigned i = 0; i < numStarted; ++i)
+        {
+            pthread_join(threads[i], NULL);
+            valid = valid && params[i].valid;
+        }
+
+        const uint64_t numSyncs = lio_appender_num_syncs(pAppender);
+        valid = valid
+            && numStarted == APPENDER_TEST_NUM_THREADS
+            && numSyncs > 0
+            && numSyncs <= APPENDER_TEST_NUM_THREADS * (APPENDER_TEST_NUM_RECORDS / APPENDER_TEST_SYNC_EVERY)
+            && lio_appender_destroy(pAppender);
+        pAppender = NULL;
+
+        // Preallocation must not be visible in the size of the file
+        pData = valid && lio_file_open(&file, pLog, LIO_FILE_OPEN_READ) ? lio_file_read_all(&file, &numBytes) : NULL;
+        lio_file_close(&file);
+        valid = pData && numBytes == APPENDER_TEST_NUM_THREADS * APPENDER_TEST_NUM_RECORDS * APPENDER_TEST_RECORD_SIZE;
+
+        for (size_t offset = 0; valid && offset < numBytes; offset += APPENDER_TEST_RECORD_SIZE)
+        {
+            unsigned threadId = 0;
+            unsigned recordId = 0;
+
+            valid = sscanf(pData + offset, "t%02u r%010u\n", &threadId, &recordId) == 2
+                && pData[offset + APPENDER_TEST_RECORD_SIZE - 1] == '\n'
+                && threadId < APPENDER_TEST_NUM_THREADS
+                && recordId == numPerThread[threadId]++;
+        }
+
+        if (!valid)
+        {
+            fprintf(stderr, "Records from %u threads were lost or interleaved.\n", APPENDER_TEST_NUM_THREADS);
+            ret = testId;
+            goto end;
+        }
+        printf("Successfully appended %u records from %u threads with %llu flushes.\n",
+            APPENDER_TEST_NUM_THREADS * APPENDER_TEST_NUM_RECORDS,
+            APPENDER_TEST_NUM_THREADS,
+            (unsigned long long)numSyncs);
+    }
+
+    // Test that an existing file is appended to
+    ++testId;
+    pAppender = lio_appender_create(pLog, 0, 0, 0, LIO_APPENDER_DEFAULT);
+    if (!pAppender
+    || lio_appender_size(pAppender) != numBytes
+    || lio_appender_append(pAppender, "end\n", 4) != (int64_t)numBytes
+    || lio_appender_append(pAppender, NULL, 0) != (int64_t)numBytes + 4)
+    {
+        fprintf(stderr, "Unable to continue an existing file.\n");
+        ret = testId;
+        goto end;
+    }
+    lio_appender_destroy(pAppender);
+    pAppender = NULL;
+    printf("Successfully continued an existing file.\n");
+
+    // Test that data is flushed once enough bytes were appended
+    ++testId;
+    pAppender = lio_appender_create(pLog, 0, 64, 0, LIO_APPENDER_TRUNCATE);
+    if (!pAppender
+    || lio_appender_append(pAppender, pData, 32) != 0
+    || lio_appender_num_syncs(pAppender) != 0
+    || lio_appender_append(pAppender, pData, 32) != 32
+    || !appender_test_wait_for_sync(pAppender, 0))
+    {
+        fprintf(stderr, "An appender was not flushed by size.\n");
+        ret = testId;
+        goto end;
+    }
+    lio_appender_destroy(pAppender);
+    pAppender = NULL;
+    printf("Successfully flushed by size.\n");
+
+    // Test that data is flushed after an interval
+    ++testId;
+    pAppender = lio_appender_create(pLog, 0, 0, 10, LIO_APPENDER_TRUNCATE);
+    if (!pAppender
+    || lio_appender_append(pAppender, pData, 32) != 0
+    || !appender_test_wait_for_sync(pAppender, 0))
+    {
+        fprintf(stderr, "An appender was not flushed by time.\n");
+        ret = testId;
+        goto end;
+    }
+    printf("Successfully flushed by time.\n");
+
+    end:
+    lio_appender_destroy(pAppender);
+    if (pLog)
+    {
+        lio_path_remove(pLog, false, false);
+    }
+    lio_utils_str_destroy(pData);
+    lio_utils_str_destroy(pLog);
+    lio_path_destroy(pCwd);
+    lio_path_destroy(pExeDir);
+
+    return ret;
+}
@@ -0,0 +1,205 @@
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "light_io/lio_utils.h"
+#include "light_io/lio_paths.h"
+#include "light_io/lio_files.h"
+#include "light_io/lio_binio.h"
+
+
+
+#define BINIO_TEST_COUNT 1001u
+
+
+
+/*-----------------------------------------------------------------------------
+ * Read back a record written by main()
+-----------------------------------------------------------------------------*/
+static int read_records(LioBinReader* const pReader, const uint32_t* const pExpected)
+{
+    uint32_t* const pValues = (uint32_t*)malloc(BINIO_TEST_COUNT * sizeof(uint32_t));
+    double values[3];
+    int ret = pValues != NULL;
+
+    // One bounds check covers the whole header
+    ret = ret && lio_binreader_require(pReader, 1+2+4+8+4);
+    ret = ret && lio_binreader_get_u8(pReader) == 0xA5u;
+    ret = ret && lio_binreader_get_s16(pReader) == -1234;
+    ret = ret && lio_binreader_get_u32(pReader) == 0xDEADBEEFu;
+    ret = ret && lio_binreader_get_u64(pReader) == 0x0123456789ABCDEFull;
+    ret = ret && lio_binreader_get_f(pReader) == 0.5f;
+
+    ret = ret && lio_binreader_read_u32_array(pReader, pValues, BINIO_TEST_COUNT);
+    ret = ret && memcmp(pValues, pExpected, BINIO_TEST_COUNT * sizeof(uint32_t)) == 0;
+
+    ret = ret && lio_binreader_read_d_array(pReader, values, 3);
+    ret = ret && values[0] == -1.0 && values[1] == 3.25 && values[2] == 1e100;
+
+    // Reading past the end must fail
+    ret = ret && lio_binreader_tell(pReader) == 1+2+4+8+4 + BINIO_TEST_COUNT*4 + 3*8;
+    ret = ret && !lio_binreader_require(pReader, 1) && lio_binreader_failed(pReader);
+
+    free(pValues);
+    return ret;
+}
+
+
+
+int main(int argc, char* argv[])
+{
+    int ret = 0;
+    int testId = 0;
+    unsigned i = 0u;
+    char* pCwd = lio_path_dirname(argv[0]);
+    char* pPath = lio_path_join(pCwd, "binio_test.bin");
+    uint32_t* pValues = (uint32_t*)malloc(BINIO_TEST_COUNT * sizeof(uint32_t));
+    const double doubles[3] = {-1.0, 3.25, 1e100};
+    LioFile file = lio_file_wrap(-1);
+    LioBinWriter writer;
+    LioBinReader reader;
+
+    (void)argc;
+
+    // Test that big-endian data can be written through a small buffer
+    ++testId;
+    if (!pPath || !pValues || !lio_file_open(&file, pPath, LIO_FILE_OPEN_WRITE|LIO_FILE_OPEN_CREATE|LIO_FILE_OPEN_TRUNCATE))
+    {
+        fprintf(stderr, "Unable to create a test file.\n");
+        ret = testId;
+        goto end;
+    }
+
+    for (i = 0u; i < BINIO_TEST_COUNT; ++i)
+    {
+        pValues[i] = i * 0x01020304u;
+    }
+
+    if (!lio_binwriter_init_file(&writer, &file, 64, LIO_BYTE_ORDER_BIG)
+    || !lio_binwriter_reserve(&writer, 1+2+4+8+4))
+    {
+        fprintf(stderr, "Unable to initialize a binary writer.\n");
+        ret = testId;
+        goto end;
+    }
+
+    lio_binwriter_put_u8(&writer, 0xA5u);
+    lio_binwriter_put_s16(&writer, -1234);
+    lio_binwriter_put_u32(&writer, 0xDEADBEEFu);
+    lio_binwriter_put_u64(&writer, 0x0123456789ABCDEFull);
+    lio_binwriter_put_f(&writer, 0.5f);
+    lio_binwriter_write_u32_array(&writer, pValues, BINIO_TEST_COUNT);
+    lio_binwriter_write_d_array(&writer, doubles, 3);
+
+    if (!lio_binwriter_terminate(&writer) || !lio_file_close(&file))
+    {
+        fprintf(stderr, "Unable to write binary data to \"%s.\"\n", pPath);
+        ret = testId;
+        goto end;
+    }
+    printf("Successfully wrote big-endian binary data:\n\t%s\n", pPath);
+
+    // Test that the data is stored big-endian
+    ++testId;
+    {
+        size_t numBytes = 0;
+        char* pData = NULL;
+
+        if (lio_file_open(&file, pPath, LIO_FILE_OPEN_READ))
+        {
+            pData = lio_file_read_all(&file, &numBytes);
+            lio_file_close(&file);
+        }
+
+        const int isBigEndian = pData && numBytes > 7 && memcmp(pData+3, "\xDE\xAD\xBE\xEF", 4) == 0;
+        lio_utils_str_destroy(pData);
+
+        if (!isBigEndian)
+        {
+            fprintf(stderr, "Binary data was not written in big-endian order.\n");
+            ret = testId;
+            goto end;
+        }
+    }
+    printf("Successfully verified the written byte order.\n");
+
+    // Test that the data can be read from a mapped file
+    ++testId;
+    if (!lio_file_open(&file, pPath, LIO_FILE_OPEN_READ)
+    || !lio_binreader_init_map(&reader, &file, LIO_BYTE_ORDER_BIG))
+    {
+        fprintf(stderr, "Unable to map \"%s.\"\n", pPath);
+        ret = testId;
+        goto end;
+    }
+
+    lio_file_close(&file);
+    if (!read_records(&reader, pValues))
+    {
+        fprintf(stderr, "Mapped binary data does not match.\n");
+        lio_binreader_terminate(&reader);
+        ret = testId;
+        goto end;
+    }
+    lio_binreader_terminate(&reader);
+    printf("Successfully read binary data from a mapped file.\n");
+
+    // Test that the data can be read through a buffer smaller than a record
+    ++testId;
+    if (!lio_file_open(&file, pPath, LIO_FILE_OPEN_READ)
+    || !lio_binreader_init_file(&reader, &file, 8, LIO_BYTE_ORDER_BIG))
+    {
+        fprintf(stderr, "Unable to open \"%s.\"\n", pPath);
+        ret = testId;
+        goto end;
+    }
+
+    if (!read_records(&reader, pValues))
+    {
+        fprintf(stderr, "Buffered binary data does not match.\n");
+        lio_binreader_terminate(&reader);
+        ret = testId;
+        goto end;
+    }
+    lio_binreader_terminate(&reader);
+    lio_file_close(&file);
+    printf("Successfully read binary data through a small buffer.\n");
+
+    // Test that native-endian memory writes are plain copies
+    ++testId;
+    {
+        size_t numBytes = 0;
+        const void* pData = NULL;
+        int memRet = lio_binwriter_init_memory(&writer, 16, LIO_BYTE_ORDER_NATIVE)
+            && lio_binwriter_write_u32_array(&writer, pValues, BINIO_TEST_COUNT);
+
+        pData = lio_binwriter_data(&writer, &numBytes);
+        memRet = memRet
+            && numBytes == BINIO_TEST_COUNT * sizeof(uint32_t)
+            && memcmp(pData, pValues, numBytes) == 0;
+
+        memRet = lio_binwriter_terminate(&writer) && memRet;
+        if (!memRet)
+        {
+            fprintf(stderr, "Native-endian memory writes do not match.\n");
+            ret = testId;
+            goto end;
+        }
+    }
+    printf("Successfully wrote native-endian data to memory.\n");
+
+    end:
+    lio_file_close(&file);
+
+    if (pPath && lio_path_does_exist(pPath, LIO_PATH_TYPE_FILE))
+    {
+        lio_path_remove(pPath, false, false);
+    }
+
+    free(pValues);
+    lio_path_destroy(pPath);
+    lio_path_destroy(pCwd);
+
+    return ret;
+}
@@ -0,0 +1,277 @@
+
+#ifndef _WIN32
+    #define _XOPEN_SOURCE 700 // nanosleep()
+    #include <time.h>
+#else
+    #include <windows.h>
+#endif
+
+#include <stdint.h> // uintptr_t
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "light_io/lio_files.h"
+#include "light_io/lio_paths.h"
+#include "light_io/lio_utils.h"
+#include "light_io/lio_dircache.h"
+
+
+
+enum
+{
+    DIRCACHE_TEST_NUM_FILES = 50
+};
+
+
+
+/*-----------------------------------------------------------------------------
+ * Wait for folder timestamps to settle past LIO_DIRCACHE_RACY_NSEC
+-----------------------------------------------------------------------------*/
+static void dircache_sleep_past_racy_window(void)
+{
+    #ifdef _WIN32
+        Sleep(150);
+    #else
+        const struct timespec delay = {0, 150000000};
+        nanosleep(&delay, NULL);
+    #endif
+}
+
+
+
+static bool dircache_write_file(const char* pPath, size_t numBytes)
+{
+    static const char data[DIRCACHE_TEST_NUM_FILES] = {0};
+    LioFile file;
+
+    if (!lio_file_open(&file, pPath, LIO_FILE_OPEN_WRITE | LIO_FILE_OPEN_CREATE | LIO_FILE_OPEN_TRUNCATE))
+    {
+        return false;
+    }
+
+    const bool ret = lio_file_write(&file, data, numBytes);
+    return lio_file_close(&file) && ret;
+}
+
+
+
+static bool dircache_is_mapped(const LioDirCache* pCache, const LioDirListing* pListing)
+{
+    const uintptr_t begin = (uintptr_t)pCache->pMapping;
+    const uintptr_t end = begin + pCache->mappingSize;
+
+    return (uintptr_t)pListing->pEntries >= begin && (uintptr_t)pListing->pEntries < end;
+}
+
+
+
+int main(int argc, char* argv[])
+{
+    int ret = 0;
+    int testId = 0;
+    unsigned i = 0u;
+    char* pExeDir = lio_path_dirname(argv[0]);
+    char* pCwd = lio_path_resolve(pExeDir);
+    char* pRoot = NULL;
+    char* pFolderA = NULL;
+    char* pFolderB = NULL;
+    char* pFolderC = NULL;
+    char* pFolderD = NULL;
+    char* pPath = NULL;
+    char* pSnapshot = NULL;
+    char* pSnapshot2 = NULL;
+    LioDirCache cache;
+    LioDirListing listing;
+    LioDirCacheEntry entry;
+
+    (void)argc;
+    memset(&cache, 0, sizeof(cache));
+
+    // Create a small tree to cache
+    ++testId;
+    pRoot = lio_utils_str_fmt("%s%cdircache_tree", pCwd, LIO_PATH_SEP);
+    pFolderA = lio_utils_str_fmt("%s%ca", pRoot, LIO_PATH_SEP);
+    pFolderB = lio_utils_str_fmt("%s%ca%cb", pRoot, LIO_PATH_SEP, LIO_PATH_SEP);
+    pFolderC = lio_utils_str_fmt("%s%cc", pRoot, LIO_PATH_SEP);
+    pFolderD = lio_utils_str_fmt("%s%cd", pRoot, LIO_PATH_SEP);
+    pSnapshot = lio_utils_str_fmt("%s%cdircache.bin", pCwd, LIO_PATH_SEP);
+    pSnapshot2 = lio_utils_str_fmt("%s%cdircache2.bin", pCwd, LIO_PATH_SEP);
+    if (!pRoot || !pFolderA || !pFolderB || !pFolderC || !pFolderD || !pSnapshot || !pSnapshot2)
+    {
+        fprintf(stderr, "Unable to create test paths.\n");
+        ret = testId;
+        goto end;
+    }
+
+    lio_path_remove(pRoot, true, false);
+    if (!lio_path_mkdirs(pFolderB) || !lio_path_mkdirs(pFolderC))
+    {
+        fprintf(stderr, "Unable to create the test tree \"%s.\"\n", pRoot);
+        ret = testId;
+        goto end;
+    }
+
+    for (i = 0u; i < DIRCACHE_TEST_NUM_FILES; ++i)
+    {
+        lio_utils_str_destroy(pPath);
+        pPath = lio_utils_str_fmt("%s%cf%u", pFolderA, LIO_PATH_SEP, i);
+        if (!pPath || !dircache_write_file(pPath, i))
+        {
+            fprintf(stderr, "Unable to create the file \"%s.\"\n", pPath);
+            ret = testId;
+            goto end;
+        }
+    }
+
+    dircache_sleep_past_racy_window();
+    printf("Successfully created a test tree in \"%s.\"\n", pRoot);
+
+    // Test that a scanned tree matches the file system
+    ++testId;
+    if (!lio_dircache_build(&cache, pRoot)
+    || !lio_dircache_list(&cache, pRoot, &listing)
+    || listing.numEntries != 2
+    || strcmp(lio_dirlisting_name(&listing, 0), "a") != 0
+    || strcmp(lio_dirlisting_name(&listing, 1), "c") != 0
+    || listing.pEntries[0].type != LIO_PATH_TYPE_FOLDER)
+    {
+        fprintf(stderr, "Unable to list the root of a directory cache.\n");
+        ret = testId;
+        goto end;
+    }
+
+    if (!lio_dircache_list(&cache, pFolderA, &listing)
+    || listing.numEntries != lio_path_count_entries(pFolderA, true, NULL)
+    || !lio_dircache_stat(&cache, pPath, &entry)
+    || entry.size != DIRCACHE_TEST_NUM_FILES - 1
+    || entry.type != LIO_PATH_TYPE_REGULAR)
+    {
+        fprintf(stderr, "A directory cache does not match \"%s.\"\n", pFolderA);
+        ret = testId;
+        goto end;
+    }
+
+    for (i = 1u; i < listing.numEntries; ++i)
+    {
+        if (strcmp(lio_dirlisting_name(&listing, i-1), lio_dirlisting_name(&listing, i)) >= 0)
+        {
+            fprintf(stderr, "Cached entries are not sorted: \"%s.\"\n", lio_dirlisting_name(&listing, i));
+            ret = testId;
+            goto end;
+        }
+    }
+    printf("Successfully cached %zu entries in \"%s.\"\n", listing.numEntries, pFolderA);
+
+    // Test that unchanged folders are served from a mapped snapshot
+    ++testId;
+    if (!lio_dircache_save(&cache, pSnapshot))
+    {
+        fprintf(stderr, "Unable to save a directory snapshot.\n");
+        ret = testId;
+        goto end;
+    }
+
+    lio_dircache_close(&cache);
+    if (!lio_dircache_open(&cache, pSnapshot)
+    || !lio_dircache_list(&cache, pFolderA, &listing)
+    || !dircache_is_mapped(&cache, &listing)
+    || listing.numEntries != DIRCACHE_TEST_NUM_FILES + 1
+    || !lio_dircache_stat(&cache, pPath, &entry)
+    || entry.size != DIRCACHE_TEST_NUM_FILES - 1
+    || !lio_dircache_stat(&cache, pFolderB, &entry)
+    || entry.type != LIO_PATH_TYPE_FOLDER)
+    {
+        fprintf(stderr, "Unable to list \"%s\" from a mapped snapshot.\n", pFolderA);
+        ret = testId;
+        goto end;
+    }
+    printf("Successfully listed %zu entries from a mapped snapshot.\n", listing.numEntries);
+
+    // Test that changed folders are rescanned
+    ++testId;
+    lio_dircache_close(&cache);
+    lio_utils_str_destroy(pPath);
+    pPath = lio_utils_str_fmt("%s%cnew", pFolderC, LIO_PATH_SEP);
+    if (!pPath || !dircache_write_file(pPath, 3) || !lio_path_mkdirs(pFolderD) || !lio_path_remove(pFolderB, true, false))
+    {
+        fprintf(stderr, "Unable to modify the test tree.\n");
+        ret = testId;
+        goto end;
+    }
+
+    if (!lio_dircache_open(&cache, pSnapshot)
+    || !lio_dircache_list(&cache, pFolderC, &listing)
+    || dircache_is_mapped(&cache, &listing)
+    || listing.numEntries != 1
+    || !lio_dircache_stat(&cache, pPath, &entry)
+    || entry.size != 3)
+    {
+        fprintf(stderr, "A changed folder was not rescanned: \"%s.\"\n", pFolderC);
+        ret = testId;
+        goto end;
+    }
+
+    if (!lio_dircache_list(&cache, pFolderD, &listing)
+    || listing.numEntries != 0
+    || lio_dircache_list(&cache, pFolderB, &listing)
+    || !lio_dircache_list(&cache, pRoot, &listing)
+    || listing.numEntries != 3
+    || lio_dircache_list(&cache, pCwd, &listing))
+    {
+        fprintf(stderr, "Added or removed folders were not detected.\n");
+        ret = testId;
+        goto end;
+    }
+    printf("Successfully rescanned changed folders.\n");
+
+    // Test that a refreshed cache can be saved again
+    ++testId;
+    if (!lio_dircache_save(&cache, pSnapshot2))
+    {
+        fprintf(stderr, "Unable to save a refreshed directory snapshot.\n");
+        ret = testId;
+        goto end;
+    }
+
+    lio_dircache_close(&cache);
+    if (!lio_dircache_open(&cache, pSnapshot2)
+    || cache.numFolders != 4
+    || !lio_dircache_stat(&cache, pPath, &entry)
+    || entry.size != 3
+    || !lio_dircache_list(&cache, pFolderA, &listing)
+    || listing.numEntries != DIRCACHE_TEST_NUM_FILES)
+    {
+        fprintf(stderr, "A refreshed snapshot has the wrong contents.\n");
+        ret = testId;
+        goto end;
+    }
+    printf("Successfully saved a refreshed snapshot with %zu folders.\n", cache.numFolders);
+
+    end:
+    lio_dircache_close(&cache);
+    if (pRoot)
+    {
+        lio_path_remove(pRoot, true, false);
+    }
+    if (pSnapshot)
+    {
+        lio_path_remove(pSnapshot, false, false);
+    }
+    if (pSnapshot2)
+    {
+        lio_path_remove(pSnapshot2, false, false);
+    }
+    lio_utils_str_destroy(pSnapshot2);
+    lio_utils_str_destroy(pSnapshot);
+    lio_utils_str_destroy(pPath);
+    lio_utils_str_destroy(pFolderD);
+    lio_utils_str_destroy(pFolderC);
+    lio_utils_str_destroy(pFolderB);
+    lio_utils_str_destroy(pFolderA);
+    lio_utils_str_destroy(pRoot);
+    lio_path_destroy(pCwd);
+    lio_path_destroy(pExeDir);
+
+    return ret;
+}
@@ -0,0 +1,190 @@
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+    #include <pthread.h>
+#endif
+
+#include "light_io/lio_error.h"
+#include "light_io/lio_files.h"
+#include "light_io/lio_paths.h"
+#include "light_io/lio_utils.h"
+
+
+
+/*-----------------------------------------------------------------------------
+ * Count the errors passed to a sink
+-----------------------------------------------------------------------------*/
+static void error_test_sink(const LioError* const pError, void* const pUserData)
+{
+    unsigned* const pNumErrors = (unsigned*)pUserData;
+
+    if (pError == lio_error_last())
+    {
+        ++(*pNumErrors);
+    }
+}
+
+
+
+#ifndef _WIN32
+static void* error_test_thread(void* pData)
+{
+    LioFile file;
+
+    lio_error_clear();
+    if (lio_file_open(&file, (const char*)pData, LIO_FILE_OPEN_READ))
+    {
+        lio_file_close(&file);
+        return NULL;
+    }
+
+    return lio_error_last()->code == LIO_ERROR_NOT_FOUND ? pData : NULL;
+}
+#endif
+
+
+
+int main(int argc, char* argv[])
+{
+    int ret = 0;
+    int testId = 0;
+    unsigned numErrors = 0;
+    char* pExeDir = lio_path_dirname(argv[0]);
+    char* pCwd = lio_path_resolve(pExeDir);
+    char* pMissing = NULL;
+    char* pOther = NULL;
+    char* pLong = NULL;
+    const LioError* pError = lio_error_last();
+    LioFile file;
+
+    (void)argc;
+
+    ++testId;
+    pMissing = lio_utils_str_fmt("%s%cerror_test_missing", pCwd, LIO_PATH_SEP);
+    pOther = lio_utils_str_fmt("%s%cerror_test_other", pCwd, LIO_PATH_SEP);
+    if (!pMissing || !pOther || pError->code != LIO_ERROR_NONE)
+    {
+        fprintf(stderr, "Unable to create test paths.\n");
+        ret = testId;
+        goto end;
+    }
+
+    // Test that failures are recorded without a sink
+    ++testId;
+    if (lio_file_open(&file, pMissing, LIO_FILE_OPEN_READ)
+    || pError->code != LIO_ERROR_NOT_FOUND
+    || pError->sysError != ENOENT
+    || strcmp(pError->path, pMissing) != 0
+    || pError->otherPath[0] != '\0')
+    {
+        fprintf(stderr, "Opening a missing file recorded %s for \"%s\".\n", lio_error_name(pError->code), pError->path);
+        ret = testId;
+        goto end;
+    }
+    printf("Successfully recorded an error: ");
+    lio_error_print(pError, stdout);
+
+    // Test that probing for a missing path is not an error
+    ++testId;
+    lio_error_clear();
+    if (lio_path_does_exist(pMissing, LIO_PATH_TYPE_ANY) || pError->code != LIO_ERROR_NONE)
+    {
+        fprintf(stderr, "Probing for a missing path recorded an error.\n");
+        ret = testId;
+        goto end;
+    }
+    printf("Successfully probed for a missing path without an error.\n");
+
+    // Test that an installed sink sees both paths of a failure
+    ++testId;
+    lio_error_set_sink(&error_test_sink, &numErrors);
+    if (lio_path_move(pMissing, pOther, false) == 0
+    || numErrors != 1
+    || pError->code != LIO_ERROR_NOT_FOUND
+    || strcmp(pError->path, pMissing) != 0
+    || strcmp(pError->otherPath, pOther) != 0)
+    {
+        fprintf(stderr, "A sink saw %u errors while moving a missing path.\n", numErrors);
+        lio_error_set_sink(NULL, NULL);
+        ret = testId;
+        goto end;
+    }
+
+    lio_error_set_sink(NULL, NULL);
+    if (lio_file_open(&file, pMissing, LIO_FILE_OPEN_READ) || numErrors != 1)
+    {
+        fprintf(stderr, "A removed sink was still called.\n");
+        ret = testId;
+        goto end;
+    }
+    printf("Successfully passed an error to a sink.\n");
+
+    // Test that long paths are truncated rather than overflowing the record
+    ++testId;
+    pLong = (char*)malloc(LIO_ERROR_MAX_PATH * 2);
+    if (!pLong)
+    {
+        fprintf(stderr, "Unable to allocate a long path.\n");
+        ret = testId;
+        goto end;
+    }
+
+    memset(pLong, 'a', LIO_ERROR_MAX_PATH * 2 - 1);
+    pLong[LIO_ERROR_MAX_PATH * 2 - 1] = '\0';
+    lio_error_report(LIO_ERROR_LIMIT_EXCEEDED, 0, "A long path", pLong, NULL);
+    if (strlen(pError->path) != LIO_ERROR_MAX_PATH-1 || strncmp(pError->path, pLong, LIO_ERROR_MAX_PATH-1) != 0)
+    {
+        fprintf(stderr, "A long path was not truncated.\n");
+        ret = testId;
+        goto end;
+    }
+    printf("Successfully truncated a long path.\n");
+
+    // Test the conversion of system errors
+    ++testId;
+    if (lio_error_from_errno(0) != LIO_ERROR_NONE
+    || lio_error_from_errno(EACCES) != LIO_ERROR_PERMISSION_DENIED
+    || lio_error_from_errno(ENOTEMPTY) != LIO_ERROR_FOLDER_NOT_EMPTY
+    || lio_error_from_errno(EIO) != LIO_ERROR_IO
+    || strcmp(lio_error_name(LIO_ERROR_CORRUPT), "LIO_ERROR_CORRUPT") != 0)
+    {
+        fprintf(stderr, "System errors were converted incorrectly.\n");
+        ret = testId;
+        goto end;
+    }
+    printf("Successfully converted system errors.\n");
+
+    #ifndef _WIN32
+    // Test that each thread has its own record
+    ++testId;
+    {
+        pthread_t thread;
+        void* pResult = NULL;
+
+        lio_error_clear();
+        if (pthread_create(&thread, NULL, &error_test_thread, pOther) != 0
+        || pthread_join(thread, &pResult) != 0
+        || pResult != pOther
+        || pError->code != LIO_ERROR_NONE)
+        {
+            fprintf(stderr, "An error on another thread was not kept separate.\n");
+            ret = testId;
+            goto end;
+        }
+        printf("Successfully kept errors separate between threads.\n");
+    }
+    #endif
+
+    end:
+    free(pLong);
+    lio_utils_str_destroy(pOther);
+    lio_utils_str_destroy(pMissing);
+    lio_path_destroy(pCwd);
+    lio_path_destroy(pExeDir);
+
+    return ret;
+}
@@ -0,0 +1,612 @@
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+    #include <sys/stat.h> // chmod()
+#endif
+
+#include "light_io/lio_utils.h"
+#include "light_io/lio_paths.h"
+#include "light_io/lio_files.h"
+
+
+
+static int files_are_equal(const char* const pathA, const char* const pathB)
+{
+    FILE* const pA = fopen(pathA, "rb");
+    FILE* const pB = fopen(pathB, "rb");
+    int ret = pA && pB;
+
+    while (ret)
+    {
+        const int a = fgetc(pA);
+        const int b = fgetc(pB);
+
+        if (a != b)
+        {
+            ret = 0;
+        }
+
+        if (a == EOF || b == EOF)
+        {
+            break;
+        }
+    }
+
+    if (pA)
+    {
+        fclose(pA);
+    }
+
+    if (pB)
+    {
+        fclose(pB);
+    }
+
+    return ret;
+}
+
+
+
+static int write_pattern_file(const char* const path, const size_t numBytes)
+{
+    FILE* const pFile = fopen(path, "wb");
+    int ret = pFile != NULL;
+
+    for (size_t i = 0; ret && i < numBytes; ++i)
+    {
+        ret = fputc((int)((i * 2654435761u) >> 24) & 0xFF, pFile) != EOF;
+    }
+
+    if (pFile)
+    {
+        ret = fclose(pFile) == 0 && ret;
+    }
+
+    return ret;
+}
+
+
+
+static int file_ends_with(const char* const path, const char c)
+{
+    FILE* const pFile = fopen(path, "rb");
+    int ret = 0;
+
+    if (pFile)
+    {
+        ret = fseek(pFile, -1, SEEK_END) == 0 && fgetc(pFile) == c;
+        fclose(pFile);
+    }
+
+    return ret;
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Check a file holds "pPrefix" followed by the contents of other files
+-----------------------------------------------------------------------------*/
+static int file_is_appended(const char* const path, const char* const pPrefix, const char* const* pPaths, const unsigned numPaths)
+{
+    FILE* const pFile = fopen(path, "rb");
+    int ret = pFile != NULL;
+
+    for (size_t i = 0; ret && pPrefix[i]; ++i)
+    {
+        ret = fgetc(pFile) == (unsigned char)pPrefix[i];
+    }
+
+    for (unsigned i = 0; ret && i < numPaths; ++i)
+    {
+        FILE* const pPart = fopen(pPaths[i], "rb");
+        int c = 0;
+
+        ret = pPart != NULL;
+        while (ret && (c = fgetc(pPart)) != EOF)
+        {
+            ret = fgetc(pFile) == c;
+        }
+
+        if (pPart)
+        {
+            fclose(pPart);
+        }
+    }
+
+    if (pFile)
+    {
+        ret = ret && fgetc(pFile) == EOF;
+        fclose(pFile);
+    }
+
+    return ret;
+}
+
+
+
+int main(int argc, char* argv[])
+{
+    int ret = 0;
+    int testId = 0;
+    char* pCwd = NULL;
+    char* pSrc = NULL;
+    char* pCopy = NULL;
+    char* pJoined = NULL;
+    char* pPrefix = NULL;
+    char* pBig = NULL;
+    char** pParts = NULL;
+    unsigned numParts = 0u;
+    unsigned i = 0u;
+    FILE* pFile = NULL;
+
+    (void)argc;
+
+    // Generate a file of newline-delimited records with varying lengths
+    ++testId;
+    pCwd = lio_path_dirname(argv[0]);
+    pSrc = lio_path_join(pCwd, "file_test.src");
+    pCopy = lio_path_join(pCwd, "file_test.copy");
+    pJoined = lio_path_join(pCwd, "file_test.joined");
+    pPrefix = lio_path_join(pCwd, "file_test.part");
+    pBig = lio_path_join(pCwd, "file_test.big");
+    pFile = pSrc ? fopen(pSrc, "wb") : NULL;
+    if (!pCopy || !pJoined || !pPrefix || !pBig || !pFile)
+    {
+        fprintf(stderr, "Unable to create a test file.\n");
+        ret = testId;
+        goto end;
+    }
+
+    for (i = 0u; i < 5000u; ++i)
+    {
+        fprintf(pFile, "record %u:%.*s\n", i, (int)((i * 7u) % 61u), "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789");
+    }
+    fclose(pFile);
+    printf("Created a test file:\n\t%s\n", pSrc);
+
+    // Test that files can be copied
+    ++testId;
+    if (!lio_file_copy(pSrc, pCopy, true) || !files_are_equal(pSrc, pCopy))
+    {
+        fprintf(stderr, "Unable to copy \"%s\" to \"%s.\"\n", pSrc, pCopy);
+        ret = testId;
+        goto end;
+    }
+    else
+    {
+        printf("Successfully copied a file:\n\t%s\n", pCopy);
+    }
+
+    // Test that background copies are complete on either side of each
+    // writeback window
+    ++testId;
+    {
+        static const size_t sizes[] = {
+            0,
+            LIO_FILE_BACKGROUND_WINDOW_SIZE - 1,
+            LIO_FILE_BACKGROUND_WINDOW_SIZE + 1,
+            LIO_FILE_BACKGROUND_WINDOW_SIZE*2 + 12345
+        };
+
+        for (i = 0u; i < sizeof(sizes)/sizeof(sizes[0]); ++i)
+        {
+            if (!write_pattern_file(pBig, sizes[i])
+            || !lio_file_copy_ex(pBig, pCopy, LIO_FILE_COPY_OVERWRITE | LIO_FILE_COPY_BACKGROUND)
+            || !files_are_equal(pBig, pCopy))
+            {
+                fprintf(stderr, "Unable to copy %zu bytes in the background.\n", sizes[i]);
+                ret = testId;
+                goto end;
+            }
+        }
+
+        printf("Successfully copied files in the background.\n");
+    }
+
+    // Test that direct copies handle sizes which are not a multiple of the
+    // O_DIRECT alignment, whether or not the filesystem accepts O_DIRECT
+    ++testId;
+    {
+        static const size_t sizes[] = {0, 1, 4095, 4097, 5*1024*1024 + 7};
+
+        // tmpfs rejects O_DIRECT, which exercises the buffered fallback
+        const char* const pShmCopy = lio_path_does_exist("/dev/shm", LIO_PATH_TYPE_FOLDER) ? "/dev/shm/lio_file_test.copy" : NULL;
+        int directRet = 1;
+
+        for (i = 0u; directRet && i < sizeof(sizes)/sizeof(sizes[0]); ++i)
+        {
+            directRet = write_pattern_file(pBig, sizes[i])
+                && lio_file_copy_ex(pBig, pCopy, LIO_FILE_COPY_OVERWRITE | LIO_FILE_COPY_DIRECT)
+                && files_are_equal(pBig, pCopy);
+
+            directRet = directRet && (!pShmCopy
+                || (lio_file_copy_ex(pBig, pShmCopy, LIO_FILE_COPY_OVERWRITE | LIO_FILE_COPY_DIRECT)
+                && files_are_equal(pBig, pShmCopy)));
+        }
+
+        if (pShmCopy)
+        {
+            lio_path_remove(pShmCopy, false, false);
+        }
+
+        if (!directRet)
+        {
+            fprintf(stderr, "Unable to copy %zu bytes with direct I/O.\n", sizes[i-1]);
+            ret = testId;
+            goto end;
+        }
+
+        printf("Successfully copied files with direct I/O.\n");
+    }
+
+    // Test that open handles can be mapped, read, and copied
+    ++testId;
+    {
+        LioFile src;
+        LioFile dst;
+        LioFileStat info;
+        size_t numMapped = 0;
+        size_t numRead = 0;
+        const void* pMapped = NULL;
+        char* pData = NULL;
+        int handleRet = lio_file_open(&src, pSrc, LIO_FILE_OPEN_READ) && lio_file_stat(&src, &info);
+
+        if (handleRet)
+        {
+            pMapped = lio_file_map(&src, &numMapped);
+            pData = lio_file_read_all(&src, &numRead);
+            handleRet = pMapped && pData
+                && numMapped == info.size
+                && numRead == info.size
+                && memcmp(pMapped, pData, numRead) == 0;
+        }
+
+        if (handleRet && lio_file_open(&dst, pCopy, LIO_FILE_OPEN_WRITE|LIO_FILE_OPEN_CREATE|LIO_FILE_OPEN_TRUNCATE))
+        {
+            handleRet = lio_file_copy_fd(&src, &dst, LIO_FILE_COPY_DEFAULT, NULL);
+            handleRet = lio_file_close(&dst) && handleRet && files_are_equal(pSrc, pCopy);
+        }
+        else
+        {
+            handleRet = 0;
+        }
+
+        lio_file_unmap(pMapped, numMapped);
+        lio_utils_str_destroy(pData);
+        lio_file_close(&src);
+
+        if (!handleRet)
+        {
+            fprintf(stderr, "Unable to map, read, or copy an open file handle.\n");
+            ret = testId;
+            goto end;
+        }
+
+        printf("Successfully mapped, read, and copied an open file handle.\n");
+    }
+
+    // Test that copying into a handle opened for appending keeps its contents
+    ++testId;
+    {
+        LioFile src;
+        LioFile dst;
+        int appendRet = 0;
+
+        pFile = fopen(pCopy, "wb");
+        if (pFile)
+        {
+            appendRet = fputs("existing\n", pFile) >= 0;
+            appendRet = fclose(pFile) == 0 && appendRet;
+            pFile = NULL;
+        }
+
+        if (appendRet && lio_file_open(&src, pSrc, LIO_FILE_OPEN_READ))
+        {
+            if (lio_file_open(&dst, pCopy, LIO_FILE_OPEN_APPEND))
+            {
+                appendRet = lio_file_copy_fd(&src, &dst, LIO_FILE_COPY_DEFAULT, NULL);
+                appendRet = lio_file_close(&dst) && appendRet;
+            }
+            else
+            {
+                appendRet = 0;
+            }
+
+            lio_file_close(&src);
+        }
+        else
+        {
+            appendRet = 0;
+        }
+
+        if (!appendRet || !file_is_appended(pCopy, "existing\n", (const char* const*)&pSrc, 1u))
+        {
+            fprintf(stderr, "Unable to copy into a file opened for appending.\n");
+            ret = testId;
+            goto end;
+        }
+
+        printf("Successfully copied into a file opened for appending.\n");
+    }
+
+    // Test that files can be split on record boundaries
+    ++testId;
+    pParts = lio_file_split(pSrc, pPrefix, LIO_FILE_SPLIT_COUNT, 7, '\n', &numParts);
+    if (!pParts || numParts != 7u)
+    {
+        fprintf(stderr, "Unable to split \"%s\" into 7 parts.\n", pSrc);
+        ret = testId;
+        goto end;
+    }
+
+    for (i = 0u; i < numParts; ++i)
+    {
+        if (!file_ends_with(pParts[i], '\n'))
+        {
+            fprintf(stderr, "File part \"%s\" does not end with a complete record.\n", pParts[i]);
+            ret = testId;
+            goto end;
+        }
+    }
+    printf("Successfully split a file into %u record-aligned parts.\n", numParts);
+
+    // Test that concatenating split files reproduces the original
+    ++testId;
+    if (!lio_file_concat_many((const char* const*)pParts, numParts, pJoined, true) || !files_are_equal(pSrc, pJoined))
+    {
+        fprintf(stderr, "Concatenated file parts do not match \"%s.\"\n", pSrc);
+        ret = testId;
+        goto end;
+    }
+    else
+    {
+        printf("Successfully rejoined file parts:\n\t%s\n", pJoined);
+    }
+
+    for (i = 0u; i < numParts; ++i)
+    {
+        lio_path_remove(pParts[i], false, false);
+    }
+    lio_paths_destroy(pParts, numParts);
+
+    // Test that files can be split into fixed-size parts
+    ++testId;
+    pParts = lio_file_split(pSrc, pPrefix, LIO_FILE_SPLIT_SIZE, 4096, LIO_FILE_SPLIT_NO_DELIMITER, &numParts);
+    if (!pParts
+    || !lio_file_concat_many((const char* const*)pParts, numParts, pJoined, true)
+    || !files_are_equal(pSrc, pJoined))
+    {
+        fprintf(stderr, "Unable to split and rejoin \"%s\" in 4096-byte parts.\n", pSrc);
+        ret = testId;
+        goto end;
+    }
+    else
+    {
+        printf("Successfully split and rejoined %u fixed-size parts.\n", numParts);
+    }
+
+    // Test that two files can be concatenated
+    ++testId;
+    if (!lio_file_concat(pParts[0], pParts[1], pJoined, true)
+    || !lio_file_concat_many((const char* const*)pParts, 2, pCopy, true)
+    || !files_are_equal(pJoined, pCopy))
+    {
+        fprintf(stderr, "Unable to concatenate \"%s\" and \"%s.\"\n", pParts[0], pParts[1]);
+        ret = testId;
+        goto end;
+    }
+    else
+    {
+        printf("Successfully concatenated two files:\n\t%s\n", pJoined);
+    }
+
+    // Test that concatenating into a handle opened for appending keeps its
+    // contents, as when rolling logs up into an archive
+    ++testId;
+    {
+        LioFile inFiles[3];
+        LioFile outFile;
+        unsigned numOpened = 0u;
+        int appendRet = 0;
+
+        pFile = fopen(pJoined, "wb");
+        if (pFile)
+        {
+            appendRet = fputs("archive\n", pFile) >= 0;
+            appendRet = fclose(pFile) == 0 && appendRet;
+            pFile = NULL;
+        }
+
+        while (appendRet && numOpened < 3u && lio_file_open(&inFiles[numOpened], pParts[numOpened], LIO_FILE_OPEN_READ))
+        {
+            ++numOpened;
+        }
+
+        if (numOpened == 3u && lio_file_open(&outFile, pJoined, LIO_FILE_OPEN_APPEND))
+        {
+            appendRet = lio_file_concat_fd(inFiles, 3u, &outFile);
+            appendRet = lio_file_close(&outFile) && appendRet;
+        }
+        else
+        {
+            appendRet = 0;
+        }
+
+        while (numOpened --> 0u)
+        {
+            lio_file_close(&inFiles[numOpened]);
+        }
+
+        if (!appendRet || !file_is_appended(pJoined, "archive\n", (const char* const*)pParts, 3u))
+        {
+            fprintf(stderr, "Unable to concatenate into a file opened for appending.\n");
+            ret = testId;
+            goto end;
+        }
+
+        printf("Successfully concatenated into a file opened for appending.\n");
+    }
+
+    // Test that copies and concatenations can replace their output atomically
+    ++testId;
+    if (!lio_file_copy_ex(pSrc, pCopy, LIO_FILE_COPY_OVERWRITE | LIO_FILE_COPY_ATOMIC)
+    || !files_are_equal(pSrc, pCopy)
+    || !lio_file_concat_ex((const char* const*)pParts, numParts, pJoined, LIO_FILE_COPY_OVERWRITE | LIO_FILE_COPY_ATOMIC)
+    || !files_are_equal(pSrc, pJoined)
+    || lio_file_copy_ex(pParts[0], pCopy, LIO_FILE_COPY_ATOMIC)
+    || !files_are_equal(pSrc, pCopy))
+    {
+        fprintf(stderr, "Unable to atomically copy and concatenate \"%s.\"\n", pSrc);
+        ret = testId;
+        goto end;
+    }
+    else
+    {
+        printf("Successfully copied and concatenated files atomically.\n");
+    }
+
+    // Test that buffers are written atomically, alone or in a batch
+    ++testId;
+    {
+        static const char data[] = "atomic";
+        LioFileBatch batch;
+        LioFile file;
+        size_t numRead = 0;
+        char* pData = NULL;
+        int atomicRet = 1;
+
+        lio_file_batch_init(&batch);
+
+        // A batched file is not visible until the batch is committed
+        atomicRet = lio_file_write_atomic(pCopy, data, sizeof(data), LIO_FILE_COPY_OVERWRITE, &batch)
+            && lio_file_write_atomic(pJoined, data, sizeof(data), LIO_FILE_COPY_OVERWRITE, &batch)
+            && batch.numEntries == 2
+            && files_are_equal(pSrc, pCopy)
+            && lio_file_batch_commit(&batch)
+            && batch.numEntries == 0
+            && files_are_equal(pCopy, pJoined);
+
+        atomicRet = atomicRet
+            && lio_file_open(&file, pCopy, LIO_FILE_OPEN_READ)
+            && (pData = lio_file_read_all(&file, &numRead)) != NULL
+            && numRead == sizeof(data)
+            && memcmp(pData, data, sizeof(data)) == 0;
+        lio_file_close(&file);
+        lio_utils_str_destroy(pData);
+
+        // Existing files are kept unless overwriting, and discarded batches
+        // leave nothing behind
+        atomicRet = atomicRet
+            && !lio_file_write_atomic(pCopy, "x", 1, LIO_FILE_COPY_DEFAULT, NULL)
+            && files_are_equal(pCopy, pJoined)
+            && lio_file_write_atomic(pSrc, pSrc, strlen(pSrc), LIO_FILE_COPY_OVERWRITE, NULL)
+            && !files_are_equal(pSrc, pCopy)
+            && lio_path_remove(pJoined, false, false)
+            && lio_file_write_atomic(pJoined, data, sizeof(data), LIO_FILE_COPY_DEFAULT, &batch);
+        lio_file_batch_terminate(&batch);
+
+        if (!atomicRet || lio_path_does_exist(pJoined, LIO_PATH_TYPE_ANY))
+        {
+            fprintf(stderr, "Unable to write files atomically.\n");
+            ret = testId;
+            goto end;
+        }
+
+        printf("Successfully wrote files atomically.\n");
+    }
+
+    #ifndef _WIN32
+    // Test that atomic replacements keep the permissions of the old file
+    ++testId;
+    {
+        LioFile file = lio_file_wrap(-1);
+        LioFileStat info;
+        int modeRet = chmod(pCopy, 0600) == 0
+            && lio_file_copy_ex(pSrc, pCopy, LIO_FILE_COPY_OVERWRITE | LIO_FILE_COPY_ATOMIC)
+            && files_are_equal(pSrc, pCopy)
+            && lio_file_open(&file, pCopy, LIO_FILE_OPEN_READ);
+
+        modeRet = modeRet && lio_file_stat(&file, &info) && info.permissions == 0600;
+        lio_file_close(&file);
+
+        if (!modeRet)
+        {
+            fprintf(stderr, "Atomic replacement did not keep the permissions of \"%s.\"\n", pCopy);
+            ret = testId;
+            goto end;
+        }
+
+        printf("Successfully kept permissions through an atomic replacement.\n");
+    }
+    #endif
+
+    // Test that asking for more parts than there are bytes writes no empty
+    // parts
+    ++testId;
+    {
+        char* const pTinyPrefix = lio_utils_str_fmt("%s.part", pBig);
+        unsigned numTinyParts = 0u;
+        char** const pTinyParts = pTinyPrefix && write_pattern_file(pBig, 5)
+            ? lio_file_split(pBig, pTinyPrefix, LIO_FILE_SPLIT_COUNT, 16, LIO_FILE_SPLIT_NO_DELIMITER, &numTinyParts)
+            : NULL;
+        const int tinyRet = pTinyParts
+            && numTinyParts == 5u
+            && lio_file_concat_many((const char* const*)pTinyParts, numTinyParts, pJoined, true)
+            && files_are_equal(pBig, pJoined);
+
+        for (i = 0u; pTinyParts && i < numTinyParts; ++i)
+        {
+            lio_path_remove(pTinyParts[i], false, false);
+        }
+        lio_paths_destroy(pTinyParts, numTinyParts);
+        lio_utils_str_destroy(pTinyPrefix);
+
+        if (!tinyRet)
+        {
+            fprintf(stderr, "Unable to split a 5-byte file into single-byte parts.\n");
+            ret = testId;
+            goto end;
+        }
+
+        printf("Successfully split a file into more parts than it has bytes.\n");
+    }
+
+    end:
+    for (i = 0u; pParts && i < numParts; ++i)
+    {
+        lio_path_remove(pParts[i], false, false);
+    }
+
+    if (pSrc && lio_path_does_exist(pSrc, LIO_PATH_TYPE_FILE))
+    {
+        lio_path_remove(pSrc, false, false);
+    }
+
+    if (pCopy && lio_path_does_exist(pCopy, LIO_PATH_TYPE_FILE))
+    {
+        lio_path_remove(pCopy, false, false);
+    }
+
+    if (pJoined && lio_path_does_exist(pJoined, LIO_PATH_TYPE_FILE))
+    {
+        lio_path_remove(pJoined, false, false);
+    }
+
+    if (pBig && lio_path_does_exist(pBig, LIO_PATH_TYPE_FILE))
+    {
+        lio_path_remove(pBig, false, false);
+    }
+
+    lio_paths_destroy(pParts, numParts);
+    lio_path_destroy(pBig);
+    lio_path_destroy(pPrefix);
+    lio_path_destroy(pJoined);
+    lio_path_destroy(pCopy);
+    lio_path_destroy(pSrc);
+    lio_path_destroy(pCwd);
+
+    return ret;
+}
@@ -0,0 +1,171 @@
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "light_io/lio_alloc.h"
+#include "light_io/lio_paths.h"
+#include "light_io/lio_pathbuf.h"
+
+
+
+/*-----------------------------------------------------------------------------
+ * Allocation counter, used to verify that short paths stay on the stack
+-----------------------------------------------------------------------------*/
+static unsigned long gNumAllocs = 0;
+
+static void* count_allocate(void* pUserData, size_t numBytes)
+{
+    (void)pUserData;
+    ++gNumAllocs;
+    return malloc(numBytes);
+}
+
+static void* count_reallocate(void* pUserData, void* pMem, size_t oldSize, size_t newSize)
+{
+    (void)pUserData;
+    (void)oldSize;
+    ++gNumAllocs;
+    return realloc(pMem, newSize);
+}
+
+static void count_deallocate(void* pUserData, void* pMem)
+{
+    (void)pUserData;
+    free(pMem);
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Compare a path buffer against a path written with forward slashes
+-----------------------------------------------------------------------------*/
+static int pathbuf_equals(const LioPathBuf* const pBuf, const char* const pExpected)
+{
+    const char* pPath = lio_pathbuf_cstr(pBuf);
+
+    if (strlen(pPath) != lio_pathbuf_length(pBuf) || strlen(pExpected) != lio_pathbuf_length(pBuf))
+    {
+        return 0;
+    }
+
+    for (size_t i = 0; pExpected[i]; ++i)
+    {
+        const char c = (pExpected[i] == '/') ? LIO_PATH_SEP : pExpected[i];
+        if (pPath[i] != c)
+        {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+
+
+int main(int argc, char* argv[])
+{
+    int ret = 0;
+    int testId = 0;
+    unsigned i = 0u;
+    char* pCopy = NULL;
+    LioPathBuf buf;
+    const LioAllocator allocator = {&count_allocate, &count_reallocate, &count_deallocate, NULL};
+
+    (void)argc;
+    (void)argv;
+    lio_alloc_set_allocator(&allocator);
+    lio_pathbuf_init(&buf);
+
+    // Test that components are joined with single separators
+    ++testId;
+    if (!lio_pathbuf_set(&buf, "/usr/")
+    || !LIO_PATHBUF_JOIN(&buf, "/local", "share", "light_io.txt")
+    || !pathbuf_equals(&buf, "/usr/local/share/light_io.txt"))
+    {
+        fprintf(stderr, "Unable to join path components: %s\n", lio_pathbuf_cstr(&buf));
+        ret = testId;
+        goto end;
+    }
+    printf("Successfully joined a path: %s\n", lio_pathbuf_cstr(&buf));
+
+    // Test replacing and retrieving the last component in-place
+    ++testId;
+    if (strcmp(lio_pathbuf_basename(&buf), "light_io.txt") != 0
+    || !lio_pathbuf_set_basename(&buf, "light_io.bin")
+    || !pathbuf_equals(&buf, "/usr/local/share/light_io.bin"))
+    {
+        fprintf(stderr, "Unable to replace a path's basename: %s\n", lio_pathbuf_cstr(&buf));
+        ret = testId;
+        goto end;
+    }
+    printf("Successfully replaced a basename: %s\n", lio_pathbuf_cstr(&buf));
+
+    // Test that popping stops at the root directory
+    ++testId;
+    for (i = 0u; lio_pathbuf_pop(&buf); ++i)
+    {
+    }
+
+    if (i != 4u || !pathbuf_equals(&buf, "/"))
+    {
+        fprintf(stderr, "Unable to pop %u path components: %s\n", i, lio_pathbuf_cstr(&buf));
+        ret = testId;
+        goto end;
+    }
+
+    lio_pathbuf_set(&buf, "relative//dir//");
+    if (!lio_pathbuf_pop(&buf) || !pathbuf_equals(&buf, "relative") || !lio_pathbuf_pop(&buf) || !pathbuf_equals(&buf, "") || lio_pathbuf_pop(&buf))
+    {
+        fprintf(stderr, "Unable to pop a relative path: %s\n", lio_pathbuf_cstr(&buf));
+        ret = testId;
+        goto end;
+    }
+    printf("Successfully popped path components.\n");
+
+    // None of the above should have touched the heap
+    ++testId;
+    if (gNumAllocs != 0 || lio_pathbuf_is_spilled(&buf))
+    {
+        fprintf(stderr, "Short paths made %lu allocations.\n", gNumAllocs);
+        ret = testId;
+        goto end;
+    }
+    printf("Successfully built short paths without allocating.\n");
+
+    // Test that long paths spill to the heap and remain intact
+    ++testId;
+    lio_pathbuf_set(&buf, "/root");
+    for (i = 0u; i < 1000u; ++i)
+    {
+        if (!lio_pathbuf_push(&buf, "abcdefgh"))
+        {
+            fprintf(stderr, "Unable to grow a path buffer.\n");
+            ret = testId;
+            goto end;
+        }
+    }
+
+    if (!lio_pathbuf_is_spilled(&buf) || lio_pathbuf_length(&buf) != 5u + 9000u || lio_pathbuf_cstr(&buf)[5] != LIO_PATH_SEP)
+    {
+        fprintf(stderr, "Long path was not spilled correctly (%zu characters).\n", lio_pathbuf_length(&buf));
+        ret = testId;
+        goto end;
+    }
+
+    pCopy = lio_pathbuf_copy(&buf);
+    if (!pCopy || strcmp(pCopy, lio_pathbuf_cstr(&buf)) != 0 || !lio_pathbuf_set_basename(&buf, "z") || strcmp(lio_pathbuf_basename(&buf), "z") != 0)
+    {
+        fprintf(stderr, "Unable to copy a spilled path buffer.\n");
+        ret = testId;
+        goto end;
+    }
+    printf("Successfully spilled a %zu-character path.\n", lio_pathbuf_length(&buf));
+
+    end:
+    lio_path_destroy(pCopy);
+    lio_pathbuf_terminate(&buf);
+    lio_alloc_set_allocator(NULL);
+
+    return ret;
+}
@@ -0,0 +1,398 @@
+
+#ifndef _WIN32
+    #define _XOPEN_SOURCE 700 // symlink(), nanosleep()
+    #include <time.h>
+    #include <unistd.h>
+#else
+    #include <windows.h>
+#endif
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "light_io/lio_files.h"
+#include "light_io/lio_paths.h"
+#include "light_io/lio_strbuf.h"
+#include "light_io/lio_utils.h"
+#include "light_io/lio_pathindex.h"
+
+
+
+enum
+{
+    PATHINDEX_TEST_NUM_FILES = 100,
+    PATHINDEX_TEST_NUM_MISSING = 10000
+};
+
+
+
+/*-----------------------------------------------------------------------------
+ * Wait for folder timestamps to settle past LIO_PATHINDEX_RACY_NSEC
+-----------------------------------------------------------------------------*/
+static void pathindex_sleep_past_racy_window(void)
+{
+    #ifdef _WIN32
+        Sleep(150);
+    #else
+        const struct timespec delay = {0, 150000000};
+        nanosleep(&delay, NULL);
+    #endif
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Build "<root>/<fmt>" into a reusable buffer
+-----------------------------------------------------------------------------*/
+static const char* pathindex_path(LioStrBuf* pBuf, const char* pRoot, const char* pFormat, ...)
+{
+    char name[256];
+    va_list args;
+
+    va_start(args, pFormat);
+    vsnprintf(name, sizeof(name), pFormat, args);
+    va_end(args);
+
+    lio_strbuf_truncate(pBuf, 0);
+    lio_strbuf_append(pBuf, pRoot);
+    lio_strbuf_append_char(pBuf, LIO_PATH_SEP);
+    lio_strbuf_append(pBuf, name);
+    return lio_strbuf_cstr(pBuf);
+}
+
+
+
+static bool pathindex_touch(const char* pPath)
+{
+    LioFile file;
+    return lio_file_open(&file, pPath, LIO_FILE_OPEN_WRITE | LIO_FILE_OPEN_CREATE) && lio_file_close(&file);
+}
+
+
+
+int main(int argc, char* argv[])
+{
+    int ret = 0;
+    int testId = 0;
+    unsigned i = 0u;
+    unsigned numAbsent = 0u;
+    char* pExeDir = lio_path_dirname(argv[0]);
+    char* pCwd = lio_path_resolve(pExeDir);
+    char* pRoot = NULL;
+    char* pIndexFile = NULL;
+    LioStrBuf path;
+    LioPathIndex index;
+    LioPathIndex loaded;
+    LioPathIndex exact;
+
+    (void)argc;
+    lio_strbuf_init(&path);
+    memset(&index, 0, sizeof(index));
+    memset(&loaded, 0, sizeof(loaded));
+    memset(&exact, 0, sizeof(exact));
+
+    // Create a small tree to index
+    ++testId;
+    pRoot = lio_utils_str_fmt("%s%cpathindex_tree", pCwd, LIO_PATH_SEP);
+    pIndexFile = lio_utils_str_fmt("%s%cpathindex.bin", pCwd, LIO_PATH_SEP);
+    if (!pRoot || !pIndexFile)
+    {
+        fprintf(stderr, "Unable to create test paths.\n");
+        ret = testId;
+        goto end;
+    }
+
+    lio_path_remove(pRoot, true, false);
+    if (!lio_path_mkdirs(pathindex_path(&path, pRoot, "a%cb", LIO_PATH_SEP)) || !lio_path_mkdirs(pathindex_path(&path, pRoot, "c")))
+    {
+        fprintf(stderr, "Unable to create the folder \"%s.\"\n", lio_strbuf_cstr(&path));
+        ret = testId;
+        goto end;
+    }
+
+    for (i = 0u; i < PATHINDEX_TEST_NUM_FILES; ++i)
+    {
+        if (!pathindex_touch(pathindex_path(&path, pRoot, "a%cf%u", LIO_PATH_SEP, i)))
+        {
+            fprintf(stderr, "Unable to create the file \"%s.\"\n", lio_strbuf_cstr(&path));
+            ret = testId;
+            goto end;
+        }
+    }
+
+    #ifndef _WIN32
+    {
+        char* const pTarget = lio_utils_str_fmt("%s%ca", pRoot, LIO_PATH_SEP);
+        const int linked = pTarget ? symlink(pTarget, pathindex_path(&path, pRoot, "link")) : -1;
+
+        lio_utils_str_destroy(pTarget);
+        if (linked != 0)
+        {
+            fprintf(stderr, "Unable to create a symbolic link.\n");
+            ret = testId;
+            goto end;
+        }
+    }
+    #endif
+
+    pathindex_sleep_past_racy_window();
+    printf("Successfully created a test tree in \"%s.\"\n", pRoot);
+
+    // Test that every indexed path may exist and most missing paths are absent
+    ++testId;
+    if (!lio_pathindex_build(&index, pRoot, LIO_PATHINDEX_DEFAULT))
+    {
+        fprintf(stderr, "Unable to build an index of \"%s.\"\n", pRoot);
+        ret = testId;
+        goto end;
+    }
+
+    for (i = 0u; i < PATHINDEX_TEST_NUM_FILES; ++i)
+    {
+        if (lio_pathindex_query(&index, pathindex_path(&path, pRoot, "a%cf%u", LIO_PATH_SEP, i)) != LIO_PATHINDEX_MAYBE)
+        {
+            fprintf(stderr, "The indexed path \"%s\" was reported as absent.\n", lio_strbuf_cstr(&path));
+            ret = testId;
+            goto end;
+        }
+    }
+
+    for (i = 0u; i < PATHINDEX_TEST_NUM_MISSING; ++i)
+    {
+        if (lio_pathindex_query(&index, pathindex_path(&path, pRoot, "a%cmissing%u", LIO_PATH_SEP, i)) == LIO_PATHINDEX_ABSENT)
+        {
+            ++numAbsent;
+        }
+        else if (lio_pathindex_does_exist(&index, lio_strbuf_cstr(&path), LIO_PATH_TYPE_ANY))
+        {
+            fprintf(stderr, "The missing path \"%s\" was found.\n", lio_strbuf_cstr(&path));
+            ret = testId;
+            goto end;
+        }
+    }
+
+    if (numAbsent < PATHINDEX_TEST_NUM_MISSING * 97u / 100u || lio_pathindex_query(&index, pRoot) != LIO_PATHINDEX_MAYBE)
+    {
+        fprintf(stderr, "Only %u of %u missing paths were reported as absent.\n", numAbsent, PATHINDEX_TEST_NUM_MISSING);
+        ret = testId;
+        goto end;
+    }
+    printf("Successfully rejected %u of %u missing paths without touching the file system.\n", numAbsent, PATHINDEX_TEST_NUM_MISSING);
+
+    // Test that paths are canonicalized and uncovered paths are left to the caller
+    ++testId;
+    if (lio_pathindex_query(&index, pathindex_path(&path, pRoot, "a%c%c%cb%c", LIO_PATH_SEP, LIO_PATH_SEP, LIO_PATH_SEP, LIO_PATH_SEP)) != LIO_PATHINDEX_MAYBE
+    || lio_pathindex_query(&index, pathindex_path(&path, pRoot, "a%c..", LIO_PATH_SEP)) != LIO_PATHINDEX_UNKNOWN
+    || lio_pathindex_query(&index, pCwd) != LIO_PATHINDEX_UNKNOWN
+    || lio_pathindex_query(&index, "pathindex_tree") != LIO_PATHINDEX_UNKNOWN)
+    {
+        fprintf(stderr, "Paths were not canonicalized correctly: \"%s.\"\n", lio_strbuf_cstr(&path));
+        ret = testId;
+        goto end;
+    }
+
+    lio_strbuf_truncate(&path, 0);
+    lio_strbuf_append(&path, pRoot);
+    lio_strbuf_append(&path, "_sibling");
+    if (lio_pathindex_query(&index, lio_strbuf_cstr(&path)) != LIO_PATHINDEX_UNKNOWN)
+    {
+        fprintf(stderr, "The path \"%s\" is outside of the index's root.\n", lio_strbuf_cstr(&path));
+        ret = testId;
+        goto end;
+    }
+
+    #ifndef _WIN32
+        if (lio_pathindex_query(&index, pathindex_path(&path, pRoot, "link")) != LIO_PATHINDEX_MAYBE
+        || lio_pathindex_query(&index, pathindex_path(&path, pRoot, "link%cf%u", LIO_PATH_SEP, 0u)) != LIO_PATHINDEX_UNKNOWN)
+        {
+            fprintf(stderr, "Paths beneath a symbolic link must not be answered: \"%s.\"\n", lio_strbuf_cstr(&path));
+            ret = testId;
+            goto end;
+        }
+    #endif
+    printf("Successfully canonicalized paths.\n");
+
+    // Test that an index can be saved and loaded
+    ++testId;
+    if (!lio_pathindex_save(&index, pIndexFile) || !lio_pathindex_load(&loaded, pIndexFile))
+    {
+        fprintf(stderr, "Unable to save and load a path index.\n");
+        ret = testId;
+        goto end;
+    }
+
+    for (i = 0u; i < PATHINDEX_TEST_NUM_FILES; ++i)
+    {
+        const char* const pFile = pathindex_path(&path, pRoot, (i & 1u) ? "a%cf%u" : "a%cmissing%u", LIO_PATH_SEP, i);
+        if (lio_pathindex_query(&index, pFile) != lio_pathindex_query(&loaded, pFile))
+        {
+            fprintf(stderr, "A loaded index gave a different answer for \"%s.\"\n", pFile);
+            ret = testId;
+            goto end;
+        }
+    }
+
+    if (loaded.numFolders != index.numFolders || lio_pathindex_is_stale(&loaded))
+    {
+        fprintf(stderr, "A loaded index lost its folder records.\n");
+        ret = testId;
+        goto end;
+    }
+    printf("Successfully saved and loaded a path index with %zu folders.\n", loaded.numFolders);
+
+    // Test that changes are detected and picked up by a refresh
+    ++testId;
+    if (lio_pathindex_is_stale(&index))
+    {
+        fprintf(stderr, "A freshly built index was reported as stale.\n");
+        ret = testId;
+        goto end;
+    }
+
+    if (!pathindex_touch(pathindex_path(&path, pRoot, "c%cnew", LIO_PATH_SEP))
+    || !lio_path_mkdirs(pathindex_path(&path, pRoot, "d%cnested", LIO_PATH_SEP)))
+    {
+        fprintf(stderr, "Unable to modify the test tree.\n");
+        ret = testId;
+        goto end;
+    }
+
+    if (!lio_pathindex_is_stale(&index)
+    || lio_pathindex_query(&index, pathindex_path(&path, pRoot, "c%cnew", LIO_PATH_SEP)) != LIO_PATHINDEX_ABSENT)
+    {
+        fprintf(stderr, "Changes to the test tree were not detected.\n");
+        ret = testId;
+        goto end;
+    }
+
+    if (!lio_pathindex_refresh(&index)
+    || lio_pathindex_query(&index, pathindex_path(&path, pRoot, "c%cnew", LIO_PATH_SEP)) != LIO_PATHINDEX_MAYBE
+    || lio_pathindex_query(&index, pathindex_path(&path, pRoot, "d%cnested", LIO_PATH_SEP)) != LIO_PATHINDEX_MAYBE)
+    {
+        fprintf(stderr, "A refreshed index is missing \"%s.\"\n", lio_strbuf_cstr(&path));
+        ret = testId;
+        goto end;
+    }
+
+    // Folders which were rescanned within the racy window are rescanned again later
+    pathindex_sleep_past_racy_window();
+    if (!lio_pathindex_refresh(&index) || lio_pathindex_is_stale(&index))
+    {
+        fprintf(stderr, "A refreshed index is still stale.\n");
+        ret = testId;
+        goto end;
+    }
+    printf("Successfully refreshed a stale index.\n");
+
+    // Test that an exact index supports removal and grows its filter
+    ++testId;
+    if (!lio_pathindex_build(&exact, pRoot, LIO_PATHINDEX_EXACT)
+    || !lio_pathindex_remove(&exact, pathindex_path(&path, pRoot, "a%cf%u", LIO_PATH_SEP, 5u))
+    || lio_pathindex_query(&exact, lio_strbuf_cstr(&path)) != LIO_PATHINDEX_ABSENT
+    || !lio_pathindex_add(&exact, lio_strbuf_cstr(&path))
+    || lio_pathindex_query(&exact, lio_strbuf_cstr(&path)) != LIO_PATHINDEX_MAYBE)
+    {
+        fprintf(stderr, "Unable to remove \"%s\" from an exact index.\n", lio_strbuf_cstr(&path));
+        ret = testId;
+        goto end;
+    }
+
+    for (i = 0u; i < PATHINDEX_TEST_NUM_MISSING; ++i)
+    {
+        if (!lio_pathindex_add(&exact, pathindex_path(&path, pRoot, "virtual%c%u", LIO_PATH_SEP, i)))
+        {
+            fprintf(stderr, "Unable to add \"%s\" to an exact index.\n", lio_strbuf_cstr(&path));
+            ret = testId;
+            goto end;
+        }
+    }
+
+    for (i = 0u; i < PATHINDEX_TEST_NUM_MISSING; ++i)
+    {
+        if (lio_pathindex_query(&exact, pathindex_path(&path, pRoot, "virtual%c%u", LIO_PATH_SEP, i)) != LIO_PATHINDEX_MAYBE
+        || lio_pathindex_query(&exact, pathindex_path(&path, pRoot, "virtual%cx%u", LIO_PATH_SEP, i)) != LIO_PATHINDEX_ABSENT)
+        {
+            fprintf(stderr, "An exact index gave the wrong answer for \"%s.\"\n", lio_strbuf_cstr(&path));
+            ret = testId;
+            goto end;
+        }
+    }
+
+    if (exact.expectedPaths < exact.numPaths)
+    {
+        fprintf(stderr, "An exact index did not grow its filter.\n");
+        ret = testId;
+        goto end;
+    }
+    printf("Successfully grew an exact index to %zu paths.\n", exact.numPaths);
+
+    // Test that an index whose exact table disagrees with its header is
+    // rejected rather than loaded
+    ++testId;
+    if (!lio_pathindex_save(&exact, pIndexFile) || !exact.exact.capacity)
+    {
+        fprintf(stderr, "Unable to save an exact index.\n");
+        ret = testId;
+        goto end;
+    }
+
+    {
+        LioFile file;
+        LioPathIndex corrupt;
+        size_t numBytes = 0;
+        char* pData = NULL;
+
+        // The keys follow the header, the root, the folder paths, the filter,
+        // and the table's capacity and size
+        const size_t keysOffset = 4*sizeof(uint32_t) + 4*sizeof(uint64_t)
+            + exact.root.length
+            + exact.folderPaths.length
+            + exact.numBlocks * 64u
+            + 2*sizeof(uint64_t);
+
+        if (lio_file_open(&file, pIndexFile, LIO_FILE_OPEN_READ))
+        {
+            pData = lio_file_read_all(&file, &numBytes);
+            lio_file_close(&file);
+        }
+
+        int corruptRet = pData && numBytes >= keysOffset + exact.exact.capacity*sizeof(uint64_t);
+        if (corruptRet)
+        {
+            memset(pData + keysOffset, 0x5A, exact.exact.capacity*sizeof(uint64_t));
+            corruptRet = lio_file_write_atomic(pIndexFile, pData, numBytes, LIO_FILE_COPY_OVERWRITE, NULL)
+                && !lio_pathindex_load(&corrupt, pIndexFile);
+        }
+        lio_utils_str_destroy(pData);
+
+        if (!corruptRet)
+        {
+            fprintf(stderr, "A path index with a corrupt table was loaded.\n");
+            ret = testId;
+            goto end;
+        }
+        printf("Successfully rejected a path index with a corrupt table.\n");
+    }
+
+    end:
+    lio_pathindex_terminate(&exact);
+    lio_pathindex_terminate(&loaded);
+    lio_pathindex_terminate(&index);
+    if (pRoot)
+    {
+        lio_path_remove(pRoot, true, false);
+    }
+    if (pIndexFile)
+    {
+        lio_path_remove(pIndexFile, false, false);
+    }
+    lio_utils_str_destroy(pIndexFile);
+    lio_utils_str_destroy(pRoot);
+    lio_strbuf_terminate(&path);
+    lio_path_destroy(pCwd);
+    lio_path_destroy(pExeDir);
+
+    return ret;
+}
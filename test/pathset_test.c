@@ -0,0 +1,297 @@
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "light_io/lio_paths.h"
+#include "light_io/lio_pathset.h"
+
+
+
+/*-----------------------------------------------------------------------------
+ * Convert forward slashes to native separators
+-----------------------------------------------------------------------------*/
+static const char* pathset_native(const char* pPath)
+{
+    static char buffer[256];
+    size_t i = 0;
+
+    for (; pPath[i] && i < sizeof(buffer)-1; ++i)
+    {
+        buffer[i] = (pPath[i] == '/') ? LIO_PATH_SEP : pPath[i];
+    }
+
+    buffer[i] = '\0';
+    return buffer;
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Collect visited paths into a single comma-separated string
+-----------------------------------------------------------------------------*/
+typedef struct PathSetResults
+{
+    char text[1024];
+    size_t length;
+    unsigned count;
+    unsigned limit;
+} PathSetResults;
+
+
+
+static bool pathset_collect(const char* pPath, size_t length, void* pUserData)
+{
+    PathSetResults* const pResults = (PathSetResults*)pUserData;
+
+    if (pResults->length + length + 2 > sizeof(pResults->text))
+    {
+        return false;
+    }
+
+    for (size_t i = 0; i < length; ++i)
+    {
+        pResults->text[pResults->length++] = (pPath[i] == LIO_PATH_SEP) ? '/' : pPath[i];
+    }
+
+    pResults->text[pResults->length++] = ',';
+    pResults->text[pResults->length] = '\0';
+
+    return ++pResults->count != pResults->limit;
+}
+
+
+
+static bool pathset_count(const char* pPath, size_t length, void* pUserData)
+{
+    (void)pPath;
+    (void)length;
+    ++*(unsigned long*)pUserData;
+    return true;
+}
+
+
+
+static const char* pathset_list(const LioPathSet* pSet, const char* pPrefix, unsigned limit)
+{
+    static PathSetResults results;
+
+    memset(&results, 0, sizeof(results));
+    results.limit = limit;
+
+    lio_pathset_iterate(pSet, pPrefix ? pathset_native(pPrefix) : NULL, true, &pathset_collect, &results);
+    return results.text;
+}
+
+
+
+int main(int argc, char* argv[])
+{
+    int ret = 0;
+    int testId = 0;
+    unsigned i = 0u;
+    LioPathSet set;
+    unsigned long numVisited = 0;
+    char path[128];
+
+    static const char* const paths[] = {
+        "/usr/local/lib/libfoo.so",
+        "/usr/local/lib/libbar.so",
+        "/usr/local/bin/tool",
+        "/usr/lib/x.so",
+        "/usr",
+        "/",
+        "usr/relative",
+        "/usr/local//lib/libfoo.so/",
+        "/etc/hosts",
+    };
+
+    static const char* const missing[] = {
+        "/usr/local",
+        "/usr/local/lib",
+        "/usr/loc",
+        "usr",
+        "/usr/relative",
+        "/etc/hosts/x",
+        "",
+    };
+
+    (void)argc;
+    (void)argv;
+    lio_pathset_init(&set);
+
+    // Test insertion and membership, including duplicate paths
+    ++testId;
+    for (i = 0u; i < sizeof(paths)/sizeof(paths[0]); ++i)
+    {
+        if (!lio_pathset_insert(&set, pathset_native(paths[i])))
+        {
+            fprintf(stderr, "Unable to insert \"%s\" into a path set.\n", paths[i]);
+            ret = testId;
+            goto end;
+        }
+    }
+
+    if (lio_pathset_size(&set) != 8u)
+    {
+        fprintf(stderr, "Path set contains %zu paths, expected 8.\n", lio_pathset_size(&set));
+        ret = testId;
+        goto end;
+    }
+
+    for (i = 0u; i < sizeof(paths)/sizeof(paths[0]); ++i)
+    {
+        if (!lio_pathset_contains(&set, pathset_native(paths[i])))
+        {
+            fprintf(stderr, "Path set does not contain \"%s\".\n", paths[i]);
+            ret = testId;
+            goto end;
+        }
+    }
+
+    for (i = 0u; i < sizeof(missing)/sizeof(missing[0]); ++i)
+    {
+        if (lio_pathset_contains(&set, pathset_native(missing[i])))
+        {
+            fprintf(stderr, "Path set unexpectedly contains \"%s\".\n", missing[i]);
+            ret = testId;
+            goto end;
+        }
+    }
+    printf("Successfully inserted %zu paths into a path set.\n", lio_pathset_size(&set));
+
+    // Test sorted iteration over the whole set and over prefixes
+    ++testId;
+    {
+        static const char* const expectedAll = "/,/etc/hosts,/usr,/usr/lib/x.so,/usr/local/bin/tool,/usr/local/lib/libbar.so,/usr/local/lib/libfoo.so,usr/relative,";
+        static const char* const expectedUsr = "/usr,/usr/lib/x.so,/usr/local/bin/tool,/usr/local/lib/libbar.so,/usr/local/lib/libfoo.so,";
+        static const char* const expectedLocal = "/usr/local/lib/libbar.so,/usr/local/lib/libfoo.so,";
+
+        if (strcmp(pathset_list(&set, NULL, 0), expectedAll) != 0)
+        {
+            fprintf(stderr, "Sorted path set iteration is incorrect: %s\n", pathset_list(&set, NULL, 0));
+            ret = testId;
+            goto end;
+        }
+
+        // "/etc" ends partway through the merged node "etc/hosts"
+        if (strcmp(pathset_list(&set, "/usr/local/lib", 0), expectedLocal) != 0
+        || strcmp(pathset_list(&set, "/usr/", 0), expectedUsr) != 0
+        || strcmp(pathset_list(&set, "/etc", 0), "/etc/hosts,") != 0
+        || strcmp(pathset_list(&set, "/usr/lo", 0), "") != 0
+        || strcmp(pathset_list(&set, NULL, 2), "/,/etc/hosts,") != 0)
+        {
+            fprintf(stderr, "Prefix path set iteration is incorrect.\n");
+            ret = testId;
+            goto end;
+        }
+    }
+    printf("Successfully iterated over a path set.\n");
+
+    // Test a larger set, checking unsorted iteration visits every path once
+    ++testId;
+    lio_pathset_terminate(&set);
+    for (i = 0u; i < 20000u; ++i)
+    {
+        snprintf(path, sizeof(path), "/home/user/project%u/src/module%u/file%u.c", i % 7u, (i * 31u) % 97u, i);
+
+        if (!lio_pathset_insert(&set, pathset_native(path)))
+        {
+            fprintf(stderr, "Unable to insert \"%s\" into a path set.\n", path);
+            ret = testId;
+            goto end;
+        }
+    }
+
+    for (i = 0u; i < 20000u; ++i)
+    {
+        snprintf(path, sizeof(path), "/home/user/project%u/src/module%u/file%u.c", i % 7u, (i * 31u) % 97u, i);
+
+        if (!lio_pathset_contains(&set, pathset_native(path)))
+        {
+            fprintf(stderr, "Large path set does not contain \"%s\".\n", path);
+            ret = testId;
+            goto end;
+        }
+    }
+
+    numVisited = 0;
+    if (!lio_pathset_iterate(&set, NULL, false, &pathset_count, &numVisited) || numVisited != 20000u || lio_pathset_size(&set) != 20000u)
+    {
+        fprintf(stderr, "Large path set visited %lu of 20000 paths.\n", numVisited);
+        ret = testId;
+        goto end;
+    }
+    printf("Successfully stored 20000 paths in %zu bytes.\n", lio_pathset_memory_usage(&set));
+
+    // Test splitting labels too long to be kept in their slots, with
+    // components ending on and across word boundaries
+    ++testId;
+    lio_pathset_terminate(&set);
+    {
+        static const char* const longPaths[] = {
+            "/aaaaaaaa/bbbbbbbbbbbbbbbb/cccccccccccccccccccccc/d",
+            "/aaaaaaaa/bbbbbbbbbbbbbbbb/x",
+            "/aaaaaaaa/bbbbbbbbbbbbbbbb/cccccccccccccccccccccc/e",
+            "/aaaaaaaa/bbbbbbbbbbbbbbbbb",
+        };
+
+        for (i = 0u; i < sizeof(longPaths)/sizeof(longPaths[0]); ++i)
+        {
+            if (!lio_pathset_insert(&set, pathset_native(longPaths[i])))
+            {
+                fprintf(stderr, "Unable to insert \"%s\" into a path set.\n", longPaths[i]);
+                ret = testId;
+                goto end;
+            }
+        }
+
+        for (i = 0u; i < sizeof(longPaths)/sizeof(longPaths[0]); ++i)
+        {
+            if (!lio_pathset_contains(&set, pathset_native(longPaths[i])))
+            {
+                fprintf(stderr, "Path set does not contain \"%s\".\n", longPaths[i]);
+                ret = testId;
+                goto end;
+            }
+        }
+
+        if (lio_pathset_size(&set) != 4u
+        || lio_pathset_contains(&set, pathset_native("/aaaaaaaa/bbbbbbbbbbbbbbbb"))
+        || lio_pathset_contains(&set, pathset_native("/aaaaaaaa/bbbbbbbbbbbbbbbb/cccccccccccccccccccccc")))
+        {
+            fprintf(stderr, "Path set with long labels is incorrect.\n");
+            ret = testId;
+            goto end;
+        }
+    }
+
+    // Components longer than a label can hold are rejected
+    {
+        char* const pHuge = (char*)malloc(20002u);
+        bool inserted = true;
+
+        if (pHuge)
+        {
+            pHuge[0] = LIO_PATH_SEP;
+            memset(pHuge + 1, 'z', 20000u);
+            pHuge[20001] = '\0';
+            inserted = lio_pathset_insert(&set, pHuge);
+        }
+
+        free(pHuge);
+
+        if (!pHuge || inserted || lio_pathset_size(&set) != 4u)
+        {
+            fprintf(stderr, "Path set accepted a component which is too long.\n");
+            ret = testId;
+            goto end;
+        }
+    }
+    printf("Successfully split long path set labels.\n");
+
+    end:
+    lio_pathset_terminate(&set);
+
+    return ret;
+}
@@ -0,0 +1,134 @@
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "light_io/lio_paths.h"
+#include "light_io/lio_pathview.h"
+
+
+
+/*-----------------------------------------------------------------------------
+ * Convert forward slashes to native separators
+-----------------------------------------------------------------------------*/
+static void pathview_to_native(char* pPath)
+{
+    for (; *pPath; ++pPath)
+    {
+        *pPath = (*pPath == '/') ? LIO_PATH_SEP : *pPath;
+    }
+}
+
+
+
+int main(int argc, char* argv[])
+{
+    int ret = 0;
+    int testId = 0;
+    unsigned i = 0u;
+    LioPathView view;
+    LioPathView component;
+    LioPathIter iter;
+    char path[] = "//usr/local//share/light_io.tar.gz";
+    char hidden[] = "home/.profile";
+    char longPath[300];
+
+    (void)argc;
+    (void)argv;
+    pathview_to_native(path);
+    pathview_to_native(hidden);
+
+    // Test basename, dirname, and extension views
+    ++testId;
+    view = lio_pathview_make(path);
+    if (!lio_pathview_equals(lio_pathview_basename(view), "light_io.tar.gz")
+    || lio_pathview_dirname(view).length != strlen(path) - 16
+    || !lio_pathview_equals(lio_pathview_extension(view), ".gz")
+    || lio_pathview_extension(lio_pathview_make(hidden)).length != 0
+    || lio_pathview_dirname(lio_pathview_make("file")).length != 0)
+    {
+        fprintf(stderr, "Path views are incorrect for \"%s\".\n", path);
+        ret = testId;
+        goto end;
+    }
+    printf("Successfully viewed the components of \"%s\".\n", path);
+
+    // Test iterating from the front and back
+    ++testId;
+    {
+        static const char* const components[] = {"usr", "local", "share", "light_io.tar.gz"};
+
+        lio_pathiter_init(&iter, view);
+        for (i = 0u; lio_pathiter_next(&iter, &component); ++i)
+        {
+            if (i >= 4u || !lio_pathview_equals(component, components[i]))
+            {
+                break;
+            }
+        }
+
+        if (i != 4u)
+        {
+            fprintf(stderr, "Forward path iteration stopped at component %u.\n", i);
+            ret = testId;
+            goto end;
+        }
+
+        lio_pathiter_init(&iter, view);
+        for (i = 4u; lio_pathiter_prev(&iter, &component); --i)
+        {
+            if (i == 0u || !lio_pathview_equals(component, components[i-1]))
+            {
+                break;
+            }
+        }
+
+        // Both ends of an iterator meet in the middle
+        lio_pathiter_init(&iter, view);
+        if (i != 0u
+        || !lio_pathiter_next(&iter, &component) || !lio_pathview_equals(component, "usr")
+        || !lio_pathiter_prev(&iter, &component) || !lio_pathview_equals(component, "light_io.tar.gz")
+        || !lio_pathiter_next(&iter, &component) || !lio_pathview_equals(component, "local")
+        || !lio_pathiter_prev(&iter, &component) || !lio_pathview_equals(component, "share")
+        || lio_pathiter_next(&iter, &component) || lio_pathiter_prev(&iter, &component))
+        {
+            fprintf(stderr, "Reverse path iteration is incorrect.\n");
+            ret = testId;
+            goto end;
+        }
+    }
+    printf("Successfully iterated over path components.\n");
+
+    // Test separator scanning at every position of a long path, so each
+    // vectorized and scalar code path is exercised
+    ++testId;
+    for (i = 0u; i < sizeof(longPath); ++i)
+    {
+        memset(longPath, 'a', sizeof(longPath));
+        longPath[i] = LIO_PATH_SEP;
+
+        for (size_t length = 0; length <= sizeof(longPath); length += 7)
+        {
+            const size_t expected = (i < length) ? i : length;
+
+            if (lio_pathview_find_sep(longPath, length) != expected || lio_pathview_rfind_sep(longPath, length) != expected)
+            {
+                fprintf(stderr, "Separator scan failed at %u of %zu characters.\n", i, length);
+                ret = testId;
+                goto end;
+            }
+        }
+    }
+
+    memset(longPath, LIO_PATH_SEP, sizeof(longPath));
+    if (lio_pathview_find_sep(longPath, sizeof(longPath)) != 0 || lio_pathview_rfind_sep(longPath, sizeof(longPath)) != sizeof(longPath)-1)
+    {
+        fprintf(stderr, "Separator scan did not find the outermost separators.\n");
+        ret = testId;
+        goto end;
+    }
+    printf("Successfully scanned for separators.\n");
+
+    end:
+    return ret;
+}
@@ -0,0 +1,307 @@
+
+#include <pthread.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "light_io/lio_error.h"
+#include "light_io/lio_files.h"
+#include "light_io/lio_paths.h"
+#include "light_io/lio_record.h"
+#include "light_io/lio_utils.h"
+
+
+
+enum
+{
+    RECORD_TEST_NUM_CALLS = 9,
+    RECORD_TEST_NUM_THREADS = 3,
+    RECORD_TEST_NUM_LOOKUPS = 20
+};
+
+
+
+static void* record_test_thread(void* pData)
+{
+    const char* const pPath = (const char*)pData;
+
+    for (unsigned i = 0; i < RECORD_TEST_NUM_LOOKUPS; ++i)
+    {
+        lio_path_does_exist(pPath, LIO_PATH_TYPE_FOLDER);
+    }
+
+    return NULL;
+}
+
+
+
+int main(int argc, char* argv[])
+{
+    int ret = 0;
+    int testId = 0;
+    char* pExeDir = lio_path_dirname(argv[0]);
+    char* pCwd = lio_path_resolve(pExeDir);
+    char* pRoot = NULL;
+    char* pFile = NULL;
+    char* pCopy = NULL;
+    char* pMoved = NULL;
+    char* pJoined = NULL;
+    char* pRecording = NULL;
+    char** ppEntries = NULL;
+    unsigned numEntries = 0;
+    const char data[100] = {0};
+    long long numRecorded = 0;
+    LioFile file;
+    LioRecordReader reader;
+    LioRecordEntry entry;
+
+    (void)argc;
+    memset(&reader, 0, sizeof(reader));
+
+    ++testId;
+    pRoot = lio_utils_str_fmt("%s%crecord_test_root", pCwd, LIO_PATH_SEP);
+    pFile = lio_utils_str_fmt("%s%cfile", pRoot, LIO_PATH_SEP);
+    pCopy = lio_utils_str_fmt("%s%ccopy", pRoot, LIO_PATH_SEP);
+    pMoved = lio_utils_str_fmt("%s%cmoved", pRoot, LIO_PATH_SEP);
+    pJoined = lio_utils_str_fmt("%s%cjoined", pRoot, LIO_PATH_SEP);
+    pRecording = lio_utils_str_fmt("%s%crecord_test.bin", pCwd, LIO_PATH_SEP);
+    if (!pRoot || !pFile || !pCopy || !pMoved || !pJoined || !pRecording)
+    {
+        fprintf(stderr, "Unable to create test paths.\n");
+        ret = testId;
+        goto end;
+    }
+
+    lio_path_remove(pRoot, true, false);
+
+    if (!lio_record_start(pRecording))
+    {
+        printf("Recording was compiled out, skipping.\n");
+        goto end;
+    }
+
+    // Test that each call made by the application is recorded once
+    ++testId;
+    if (lio_record_start(pRecording)
+    || !lio_path_mkdirs(pRoot)
+    || !lio_file_open(&file, pFile, LIO_FILE_OPEN_WRITE | LIO_FILE_OPEN_CREATE | LIO_FILE_OPEN_TRUNCATE)
+    || !lio_file_write(&file, data, sizeof(data))
+    || !lio_file_close(&file)
+    || !lio_file_copy(pFile, pCopy, true)
+    || !lio_path_does_exist(pCopy, LIO_PATH_TYPE_FILE)
+    || (ppEntries = lio_path_list(pRoot, false, NULL, &numEntries)) == NULL
+    || lio_path_move(pCopy, pMoved, false) != 0
+    || !lio_file_concat(pFile, pMoved, pJoined, true))
+    {
+        fprintf(stderr, "Unable to make the recorded calls.\n");
+        ret = testId;
+        goto end;
+    }
+
+    numRecorded = lio_record_stop();
+    lio_path_does_exist(pRoot, LIO_PATH_TYPE_FOLDER);
+
+    if (numRecorded != RECORD_TEST_NUM_CALLS || lio_record_is_enabled() || lio_record_stop() != -1)
+    {
+        fprintf(stderr, "%lld calls were recorded.\n", numRecorded);
+        ret = testId;
+        goto end;
+    }
+    printf("Successfully recorded %lld calls.\n", numRecorded);
+
+    // Test that the calls can be read back with their arguments
+    ++testId;
+    {
+        static const enum LioStatsOp expected[RECORD_TEST_NUM_CALLS] = {
+            LIO_STATS_OP_PATH_MKDIRS,
+            LIO_STATS_OP_FILE_OPEN,
+            LIO_STATS_OP_FILE_WRITE,
+            LIO_STATS_OP_FILE_CLOSE,
+            LIO_STATS_OP_FILE_COPY,
+            LIO_STATS_OP_PATH_EXISTS,
+            LIO_STATS_OP_PATH_LIST,
+            LIO_STATS_OP_PATH_MOVE,
+            LIO_STATS_OP_FILE_CONCAT
+        };
+        int64_t fd = -1;
+        uint64_t lastStart = 0;
+        unsigned numRead = 0;
+        bool valid = lio_record_reader_open(&reader, pRecording);
+
+        lio_error_clear();
+        for (; valid && lio_record_reader_next(&reader, &entry); ++numRead)
+        {
+            valid = numRead < RECORD_TEST_NUM_CALLS
+                && entry.op == expected[numRead]
+                && entry.startNs >= lastStart
+                && entry.threadId == 1;
+            lastStart = entry.startNs;
+
+            switch (valid ? entry.op : LIO_STATS_OP_OTHER)
+            {
+                case LIO_STATS_OP_FILE_OPEN:
+                    fd = entry.result;
+                    valid = fd >= 0 && strcmp(entry.pPath, pFile) == 0;
+                    break;
+
+                case LIO_STATS_OP_FILE_WRITE:
+                    valid = (int64_t)entry.args[0] == fd
+                        && entry.args[1] == sizeof(data)
+                        && entry.bytesWritten == sizeof(data)
+                        && entry.result == 1;
+                    break;
+
+                case LIO_STATS_OP_FILE_COPY:
+                    valid = strcmp(entry.pPath, pFile) == 0
+                        && strcmp(entry.pOtherPath, pCopy) == 0
+                        && entry.bytesRead == sizeof(data);
+                    break;
+
+                case LIO_STATS_OP_PATH_LIST:
+                    valid = entry.result == (int64_t)numEntries;
+                    break;
+
+                case LIO_STATS_OP_PATH_MOVE:
+                    valid = entry.result == 0 && strcmp(entry.pOtherPath, pMoved) == 0;
+                    break;
+
+                case LIO_STATS_OP_FILE_CONCAT:
+                    valid = strcmp(entry.pPath, pJoined) == 0
+                        && strncmp(entry.pOtherPath, pFile, strlen(pFile)) == 0
+                        && strcmp(strchr(entry.pOtherPath, '\n') + 1, pMoved) == 0;
+                    break;
+
+                default:
+                    break;
+            }
+        }
+
+        lio_record_reader_close(&reader);
+
+        if (!valid || numRead != RECORD_TEST_NUM_CALLS || lio_error_last()->code != LIO_ERROR_NONE)
+        {
+            fprintf(stderr, "Recorded call %u did not match.\n", numRead);
+            ret = testId;
+            goto end;
+        }
+        printf("Successfully read back %u calls.\n", numRead);
+    }
+
+    // Test that calls from several threads are told apart
+    ++testId;
+    {
+        pthread_t threads[RECORD_TEST_NUM_THREADS];
+        unsigned numStarted = 0;
+        unsigned numPerThread[RECORD_TEST_NUM_THREADS+2] = {0};
+        bool valid = lio_record_start(pRecording);
+
+        for (; valid && numStarted < RECORD_TEST_NUM_THREADS; ++numStarted)
+        {
+            if (pthread_create(threads+numStarted, NULL, &record_test_thread, pRoot) != 0)
+            {
+                break;
+            }
+        }
+
+        for (unsigned i = 0; i < numStarted; ++i)
+        {
+            pthread_join(threads[i], NULL);
+        }
+
+        numRecorded = lio_record_stop();
+        valid = valid && lio_record_reader_open(&reader, pRecording);
+
+        while (valid && lio_record_reader_next(&reader, &entry))
+        {
+            valid = entry.op == LIO_STATS_OP_PATH_EXISTS && entry.result == 1 && entry.threadId < RECORD_TEST_NUM_THREADS+2;
+            numPerThread[valid ? entry.threadId : 0] += 1;
+        }
+
+        lio_record_reader_close(&reader);
+
+        // Thread IDs continue from the previous recording
+        for (unsigned i = 0; valid && i < RECORD_TEST_NUM_THREADS; ++i)
+        {
+            valid = numPerThread[i+2] == RECORD_TEST_NUM_LOOKUPS;
+        }
+
+        if (!valid || numStarted != RECORD_TEST_NUM_THREADS || numRecorded != RECORD_TEST_NUM_THREADS * RECORD_TEST_NUM_LOOKUPS)
+        {
+            fprintf(stderr, "Threads recorded %lld calls.\n", numRecorded);
+            ret = testId;
+            goto end;
+        }
+        printf("Successfully recorded %u threads.\n", numStarted);
+    }
+
+    // Test that a truncated recording is reported as corrupt
+    ++testId;
+    {
+        size_t numBytes = 0;
+        char* pData = NULL;
+        bool valid = lio_file_open(&file, pRecording, LIO_FILE_OPEN_READ);
+
+        pData = valid ? lio_file_read_all(&file, &numBytes) : NULL;
+        lio_file_close(&file);
+
+        valid = pData
+            && lio_file_open(&file, pRecording, LIO_FILE_OPEN_WRITE | LIO_FILE_OPEN_TRUNCATE)
+            && lio_file_write(&file, pData, numBytes - 1);
+        lio_file_close(&file);
+        lio_utils_str_destroy(pData);
+
+        unsigned numRead = 0;
+        valid = valid && lio_record_reader_open(&reader, pRecording);
+        lio_error_clear();
+        while (valid && lio_record_reader_next(&reader, &entry))
+        {
+            ++numRead;
+        }
+        lio_record_reader_close(&reader);
+
+        if (!valid || numRead != RECORD_TEST_NUM_THREADS * RECORD_TEST_NUM_LOOKUPS - 1 || lio_error_last()->code != LIO_ERROR_CORRUPT)
+        {
+            fprintf(stderr, "A truncated recording returned %u calls.\n", numRead);
+            ret = testId;
+            goto end;
+        }
+
+        valid = lio_file_open(&file, pRecording, LIO_FILE_OPEN_WRITE | LIO_FILE_OPEN_TRUNCATE)
+            && lio_file_write(&file, "LIOTRACE", 8);
+        lio_file_close(&file);
+
+        if (!valid || lio_record_reader_open(&reader, pRecording) || lio_error_last()->code != LIO_ERROR_CORRUPT)
+        {
+            fprintf(stderr, "A file with the wrong header was accepted.\n");
+            ret = testId;
+            goto end;
+        }
+        printf("Successfully rejected corrupt recordings.\n");
+    }
+
+    end:
+    lio_record_stop();
+    if (ppEntries)
+    {
+        lio_paths_destroy(ppEntries, numEntries);
+    }
+    if (pRoot)
+    {
+        lio_path_remove(pRoot, true, false);
+    }
+    if (pRecording)
+    {
+        lio_path_remove(pRecording, false, false);
+    }
+    lio_utils_str_destroy(pRecording);
+    lio_utils_str_destroy(pJoined);
+    lio_utils_str_destroy(pMoved);
+    lio_utils_str_destroy(pCopy);
+    lio_utils_str_destroy(pFile);
+    lio_utils_str_destroy(pRoot);
+    lio_path_destroy(pCwd);
+    lio_path_destroy(pExeDir);
+
+    return ret;
+}
@@ -0,0 +1,297 @@
+
+#define _XOPEN_SOURCE 700 // nanosleep()
+
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h> // chdir()
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "light_io/lio_files.h"
+#include "light_io/lio_paths.h"
+#include "light_io/lio_utils.h"
+#include "light_io/lio_statcache.h"
+
+
+
+enum
+{
+    STATCACHE_TEST_NUM_THREADS = 4,
+    STATCACHE_TEST_NUM_LOOKUPS = 10000
+};
+
+
+
+/*-----------------------------------------------------------------------------
+ * Create a file without going through light_io, so the cache is not told
+-----------------------------------------------------------------------------*/
+static bool statcache_create_behind(const char* pPath)
+{
+    FILE* const pFile = fopen(pPath, "w");
+    return pFile && fclose(pFile) == 0;
+}
+
+
+
+static void* statcache_thread(void* pData)
+{
+    const char* const pPath = (const char*)pData;
+    unsigned numFound = 0;
+
+    for (unsigned i = 0; i < STATCACHE_TEST_NUM_LOOKUPS; ++i)
+    {
+        numFound += lio_path_does_exist(pPath, LIO_PATH_TYPE_FILE);
+    }
+
+    return numFound == STATCACHE_TEST_NUM_LOOKUPS ? pData : NULL;
+}
+
+
+
+int main(int argc, char* argv[])
+{
+    int ret = 0;
+    int testId = 0;
+    char* pExeDir = lio_path_dirname(argv[0]);
+    char* pCwd = lio_path_resolve(pExeDir);
+    char* pRoot = NULL;
+    char* pFile = NULL;
+    char* pFolder = NULL;
+    char* pMoved = NULL;
+    char* pChild = NULL;
+    char* pAlias = NULL;
+    char* pStartDir = lio_path_resolve(".");
+    LioStatCacheStats stats;
+    LioFile file;
+
+    (void)argc;
+
+    ++testId;
+    pRoot = lio_utils_str_fmt("%s%cstatcache_tree", pCwd, LIO_PATH_SEP);
+    pFile = lio_utils_str_fmt("%s%cfile", pRoot, LIO_PATH_SEP);
+    pFolder = lio_utils_str_fmt("%s%cfolder", pRoot, LIO_PATH_SEP);
+    pMoved = lio_utils_str_fmt("%s%cmoved", pRoot, LIO_PATH_SEP);
+    pChild = lio_utils_str_fmt("%s%cfolder%cchild", pRoot, LIO_PATH_SEP, LIO_PATH_SEP);
+    pAlias = lio_utils_str_fmt("%s%c.%c%cfile", pRoot, LIO_PATH_SEP, LIO_PATH_SEP, LIO_PATH_SEP);
+    if (!pRoot || !pFile || !pFolder || !pMoved || !pChild || !pAlias || !pStartDir)
+    {
+        fprintf(stderr, "Unable to create test paths.\n");
+        ret = testId;
+        goto end;
+    }
+
+    lio_path_remove(pRoot, true, false);
+    if (!lio_path_mkdirs(pRoot) || !lio_statcache_enable(0, 0))
+    {
+        fprintf(stderr, "Unable to enable the metadata cache.\n");
+        ret = testId;
+        goto end;
+    }
+    printf("Successfully enabled the metadata cache.\n");
+
+    // Test that repeated lookups are served from the cache
+    ++testId;
+    if (lio_path_does_exist(pFile, LIO_PATH_TYPE_FILE)
+    || !lio_file_open(&file, pFile, LIO_FILE_OPEN_WRITE | LIO_FILE_OPEN_CREATE)
+    || !lio_file_close(&file)
+    || !lio_path_does_exist(pFile, LIO_PATH_TYPE_FILE)
+    || !lio_path_does_exist(pFile, LIO_PATH_TYPE_REGULAR)
+    || lio_path_does_exist(pFile, LIO_PATH_TYPE_FOLDER))
+    {
+        fprintf(stderr, "A created file was not seen through the metadata cache.\n");
+        ret = testId;
+        goto end;
+    }
+
+    lio_statcache_stats(&stats);
+    if (stats.hits != 2 || stats.misses != 2)
+    {
+        fprintf(stderr, "Unexpected cache counters: %llu hits, %llu misses.\n", (unsigned long long)stats.hits, (unsigned long long)stats.misses);
+        ret = testId;
+        goto end;
+    }
+    printf("Successfully cached a file: %.0f%% hit rate.\n", lio_statcache_hit_rate(&stats) * 100.0);
+
+    // Test that outside changes are only seen after bumping the generation
+    ++testId;
+    if (lio_path_does_exist(pFolder, LIO_PATH_TYPE_ANY)
+    || !statcache_create_behind(pFolder)
+    || lio_path_does_exist(pFolder, LIO_PATH_TYPE_ANY)
+    || lio_statcache_bump() != stats.generation + 1
+    || !lio_path_does_exist(pFolder, LIO_PATH_TYPE_FILE)
+    || remove(pFolder) != 0)
+    {
+        fprintf(stderr, "A cached missing path was not refreshed by a new generation.\n");
+        ret = testId;
+        goto end;
+    }
+    lio_statcache_bump();
+    printf("Successfully refreshed the cache by bumping its generation.\n");
+
+    // Test that the library's own changes invalidate the cache
+    ++testId;
+    if (lio_path_does_exist(pFolder, LIO_PATH_TYPE_FOLDER)
+    || lio_path_does_exist(pChild, LIO_PATH_TYPE_FOLDER)
+    || !lio_path_mkdirs(pChild)
+    || !lio_path_does_exist(pFolder, LIO_PATH_TYPE_FOLDER)
+    || !lio_path_does_exist(pChild, LIO_PATH_TYPE_FOLDER)
+    || lio_path_move(pFolder, pMoved, false) != 0
+    || lio_path_does_exist(pChild, LIO_PATH_TYPE_FOLDER)
+    || !lio_path_does_exist(pMoved, LIO_PATH_TYPE_FOLDER)
+    || !lio_path_remove(pFile, false, false)
+    || lio_path_does_exist(pFile, LIO_PATH_TYPE_FILE))
+    {
+        fprintf(stderr, "Changes made through light_io left stale cache entries.\n");
+        ret = testId;
+        goto end;
+    }
+
+    lio_statcache_stats(&stats);
+    printf("Successfully invalidated %llu entries.\n", (unsigned long long)stats.invalidations);
+
+    // Test that every spelling of a path shares one entry
+    ++testId;
+    if (lio_path_does_exist(pAlias, LIO_PATH_TYPE_FILE)
+    || !lio_file_open(&file, pAlias, LIO_FILE_OPEN_WRITE | LIO_FILE_OPEN_CREATE)
+    || !lio_file_close(&file)
+    || !lio_path_does_exist(pFile, LIO_PATH_TYPE_FILE)
+    || !lio_path_remove(pFile, false, false)
+    || lio_path_does_exist(pAlias, LIO_PATH_TYPE_FILE))
+    {
+        fprintf(stderr, "A change made through one spelling of a path left another stale.\n");
+        ret = testId;
+        goto end;
+    }
+    printf("Successfully shared an entry between two spellings of a path.\n");
+
+    // Test that relative paths are never cached, and that changing them
+    // invalidates the absolute path
+    ++testId;
+    lio_statcache_stats(&stats);
+    if (chdir(pRoot) != 0
+    || lio_path_does_exist("file", LIO_PATH_TYPE_FILE)
+    || lio_path_does_exist("file", LIO_PATH_TYPE_FILE)
+    || !lio_file_open(&file, "file", LIO_FILE_OPEN_WRITE | LIO_FILE_OPEN_CREATE)
+    || !lio_file_close(&file)
+    || !lio_path_does_exist(pFile, LIO_PATH_TYPE_FILE)
+    || chdir(pStartDir) != 0)
+    {
+        fprintf(stderr, "Unable to use a relative path with the metadata cache.\n");
+        ret = testId;
+        goto end;
+    }
+
+    {
+        LioStatCacheStats relStats;
+        lio_statcache_stats(&relStats);
+        if (relStats.hits != stats.hits || relStats.misses != stats.misses + 1)
+        {
+            fprintf(stderr, "Relative paths were served from the cache.\n");
+            ret = testId;
+            goto end;
+        }
+    }
+    printf("Successfully skipped the cache for relative paths.\n");
+
+    // Test that a path invalidated while it was being stat'ed is not stored
+    ++testId;
+    {
+        LioStatCacheEntry entry;
+        uint64_t epoch;
+        const LioStatCacheEntry stale = {false, 0u};
+
+        lio_statcache_bump();
+        if (lio_statcache_lookup(pFile, &entry, &epoch) || !epoch)
+        {
+            fprintf(stderr, "A path was cached without being stat'ed.\n");
+            ret = testId;
+            goto end;
+        }
+
+        lio_statcache_invalidate(pFile, false);
+        lio_statcache_store(pFile, &stale, epoch);
+        if (lio_statcache_lookup(pFile, &entry, &epoch)
+        || !lio_path_does_exist(pFile, LIO_PATH_TYPE_FILE)
+        || !lio_path_remove(pFile, false, false))
+        {
+            fprintf(stderr, "A result from before an invalidation was cached.\n");
+            ret = testId;
+            goto end;
+        }
+    }
+    printf("Successfully dropped a result from before an invalidation.\n");
+
+    // Test that entries expire
+    ++testId;
+    if (!lio_statcache_enable(64, 20000000)
+    || lio_path_does_exist(pFile, LIO_PATH_TYPE_FILE)
+    || !statcache_create_behind(pFile))
+    {
+        fprintf(stderr, "Unable to enable a metadata cache with a TTL.\n");
+        ret = testId;
+        goto end;
+    }
+
+    {
+        const struct timespec delay = {0, 50000000};
+        nanosleep(&delay, NULL);
+    }
+
+    if (!lio_path_does_exist(pFile, LIO_PATH_TYPE_FILE))
+    {
+        fprintf(stderr, "A cached entry did not expire.\n");
+        ret = testId;
+        goto end;
+    }
+    printf("Successfully expired a cached entry.\n");
+
+    // Test concurrent lookups
+    ++testId;
+    {
+        pthread_t threads[STATCACHE_TEST_NUM_THREADS];
+        void* pResult = NULL;
+        bool allFound = true;
+
+        lio_statcache_enable(0, 0);
+
+        for (unsigned i = 0; i < STATCACHE_TEST_NUM_THREADS; ++i)
+        {
+            pthread_create(threads + i, NULL, &statcache_thread, pFile);
+        }
+
+        for (unsigned i = 0; i < STATCACHE_TEST_NUM_THREADS; ++i)
+        {
+            pthread_join(threads[i], &pResult);
+            allFound = allFound && pResult != NULL;
+        }
+
+        lio_statcache_stats(&stats);
+        if (!allFound || stats.hits + stats.misses != STATCACHE_TEST_NUM_THREADS * STATCACHE_TEST_NUM_LOOKUPS)
+        {
+            fprintf(stderr, "Concurrent lookups failed: %llu hits, %llu misses.\n", (unsigned long long)stats.hits, (unsigned long long)stats.misses);
+            ret = testId;
+            goto end;
+        }
+        printf("Successfully shared the cache between %u threads: %llu hits.\n", STATCACHE_TEST_NUM_THREADS, (unsigned long long)stats.hits);
+    }
+
+    end:
+    lio_statcache_disable();
+    if (pRoot)
+    {
+        lio_path_remove(pRoot, true, false);
+    }
+    lio_utils_str_destroy(pAlias);
+    lio_utils_str_destroy(pChild);
+    lio_utils_str_destroy(pMoved);
+    lio_utils_str_destroy(pFolder);
+    lio_utils_str_destroy(pFile);
+    lio_utils_str_destroy(pRoot);
+    lio_path_destroy(pStartDir);
+    lio_path_destroy(pCwd);
+    lio_path_destroy(pExeDir);
+
+    return ret;
+}
@@ -0,0 +1,279 @@
+
+#include <pthread.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "light_io/lio_files.h"
+#include "light_io/lio_paths.h"
+#include "light_io/lio_utils.h"
+#include "light_io/lio_stats.h"
+
+
+
+enum
+{
+    STATS_TEST_NUM_THREADS = 4,
+    STATS_TEST_NUM_WRITES = 100,
+    STATS_TEST_NUM_ENTRIES = 8
+};
+
+
+
+/*-----------------------------------------------------------------------------
+ * Add up a histogram
+-----------------------------------------------------------------------------*/
+static uint64_t stats_test_histogram_sum(const LioStatsOpStats* const pStats)
+{
+    uint64_t sum = 0;
+
+    for (unsigned i = 0; i < LIO_STATS_NUM_BUCKETS; ++i)
+    {
+        sum += pStats->buckets[i];
+    }
+
+    return sum;
+}
+
+
+
+static void* stats_test_thread(void* pData)
+{
+    const char* const pPath = (const char*)pData;
+    unsigned numFound = 0;
+
+    for (unsigned i = 0; i < STATS_TEST_NUM_WRITES; ++i)
+    {
+        numFound += lio_path_does_exist(pPath, LIO_PATH_TYPE_FOLDER);
+    }
+
+    return numFound == STATS_TEST_NUM_WRITES ? pData : NULL;
+}
+
+
+
+int main(int argc, char* argv[])
+{
+    int ret = 0;
+    int testId = 0;
+    char* pExeDir = lio_path_dirname(argv[0]);
+    char* pCwd = lio_path_resolve(pExeDir);
+    char* pRoot = NULL;
+    char* pFile = NULL;
+    char** ppEntries = NULL;
+    unsigned numEntries = 0;
+    LioStatsSnapshot* pSnapshot = (LioStatsSnapshot*)malloc(sizeof(LioStatsSnapshot));
+    const LioStatsOpStats* pOp = NULL;
+    const char data[64] = {0};
+    LioFile file;
+
+    (void)argc;
+
+    ++testId;
+    pRoot = lio_utils_str_fmt("%s%cstats_test_root", pCwd, LIO_PATH_SEP);
+    pFile = lio_utils_str_fmt("%s%cfile", pRoot, LIO_PATH_SEP);
+    if (!pRoot || !pFile || !pSnapshot)
+    {
+        fprintf(stderr, "Unable to create test paths.\n");
+        ret = testId;
+        goto end;
+    }
+
+    lio_path_remove(pRoot, true, false);
+    if (!lio_path_mkdirs(pRoot))
+    {
+        fprintf(stderr, "Unable to create a test folder.\n");
+        ret = testId;
+        goto end;
+    }
+
+    if (!lio_stats_enable(true))
+    {
+        printf("Statistics were compiled out, skipping.\n");
+        goto end;
+    }
+
+    // Test that writes are counted against the write operation
+    ++testId;
+    lio_stats_reset();
+    if (!lio_file_open(&file, pFile, LIO_FILE_OPEN_WRITE | LIO_FILE_OPEN_CREATE | LIO_FILE_OPEN_TRUNCATE))
+    {
+        fprintf(stderr, "Unable to open a test file.\n");
+        ret = testId;
+        goto end;
+    }
+
+    for (unsigned i = 0; i < STATS_TEST_NUM_WRITES; ++i)
+    {
+        lio_file_write(&file, data, sizeof(data));
+    }
+    lio_file_close(&file);
+
+    lio_stats_snapshot(pSnapshot);
+    pOp = pSnapshot->ops + LIO_STATS_OP_FILE_WRITE;
+    if (pOp->counters[LIO_STATS_CALLS] != STATS_TEST_NUM_WRITES
+    || pOp->counters[LIO_STATS_BYTES_WRITTEN] != STATS_TEST_NUM_WRITES * sizeof(data)
+    || pOp->counters[LIO_STATS_SYSCALLS] < STATS_TEST_NUM_WRITES
+    || stats_test_histogram_sum(pOp) != STATS_TEST_NUM_WRITES
+    || pSnapshot->ops[LIO_STATS_OP_FILE_OPEN].counters[LIO_STATS_CALLS] != 1
+    || pSnapshot->ops[LIO_STATS_OP_FILE_CLOSE].counters[LIO_STATS_CALLS] != 1)
+    {
+        fprintf(stderr, "Writes were counted incorrectly: %llu calls, %llu bytes.\n",
+            (unsigned long long)pOp->counters[LIO_STATS_CALLS],
+            (unsigned long long)pOp->counters[LIO_STATS_BYTES_WRITTEN]);
+        ret = testId;
+        goto end;
+    }
+
+    printf(
+        "Successfully counted %llu writes, p50 %llu ns, p99 %llu ns.\n",
+        (unsigned long long)pOp->counters[LIO_STATS_CALLS],
+        (unsigned long long)lio_stats_percentile(pOp, 0.5),
+        (unsigned long long)lio_stats_percentile(pOp, 0.99));
+
+    // Test that reads are counted
+    ++testId;
+    {
+        size_t numBytes = 0;
+        char* pData = NULL;
+        bool didRead = false;
+
+        if (!lio_file_open(&file, pFile, LIO_FILE_OPEN_READ))
+        {
+            fprintf(stderr, "Unable to reopen a test file.\n");
+            ret = testId;
+            goto end;
+        }
+
+        pData = lio_file_read_all(&file, &numBytes);
+        didRead = pData != NULL;
+        lio_file_close(&file);
+        lio_utils_str_destroy(pData);
+
+        lio_stats_snapshot(pSnapshot);
+        pOp = pSnapshot->ops + LIO_STATS_OP_FILE_READ;
+        if (!didRead
+        || pOp->counters[LIO_STATS_CALLS] != 1
+        || pOp->counters[LIO_STATS_BYTES_READ] != numBytes
+        || pOp->counters[LIO_STATS_ALLOCATIONS] != 1)
+        {
+            fprintf(stderr, "Reads were counted incorrectly.\n");
+            ret = testId;
+            goto end;
+        }
+        printf("Successfully counted a read of %llu bytes.\n", (unsigned long long)numBytes);
+    }
+
+    // Test that listings count every entry they scan
+    ++testId;
+    for (unsigned i = 0; i < STATS_TEST_NUM_ENTRIES; ++i)
+    {
+        char* const pEntry = lio_utils_str_fmt("%s%centry_%u", pRoot, LIO_PATH_SEP, i);
+        lio_path_mkdirs(pEntry);
+        lio_utils_str_destroy(pEntry);
+    }
+
+    lio_stats_reset();
+    ppEntries = lio_path_list(pRoot, false, NULL, &numEntries);
+    lio_stats_snapshot(pSnapshot);
+    pOp = pSnapshot->ops + LIO_STATS_OP_PATH_LIST;
+
+    // "." and ".." are scanned but not returned
+    if (!ppEntries
+    || numEntries != STATS_TEST_NUM_ENTRIES+1
+    || pOp->counters[LIO_STATS_CALLS] != 1
+    || pOp->counters[LIO_STATS_ENTRIES_SCANNED] != numEntries+2
+    || pOp->counters[LIO_STATS_ALLOCATIONS] < numEntries
+    || pSnapshot->ops[LIO_STATS_OP_PATH_MKDIRS].counters[LIO_STATS_CALLS] != 0)
+    {
+        fprintf(stderr, "A listing of %u entries was counted incorrectly.\n", numEntries);
+        ret = testId;
+        goto end;
+    }
+    printf("Successfully counted %u entries in a listing.\n", numEntries);
+
+    // Test that every thread's shard is merged
+    ++testId;
+    {
+        pthread_t threads[STATS_TEST_NUM_THREADS];
+        unsigned numStarted = 0;
+        unsigned numPassed = 0;
+
+        lio_stats_reset();
+        for (; numStarted < STATS_TEST_NUM_THREADS; ++numStarted)
+        {
+            if (pthread_create(threads+numStarted, NULL, &stats_test_thread, pRoot) != 0)
+            {
+                break;
+            }
+        }
+
+        for (unsigned i = 0; i < numStarted; ++i)
+        {
+            void* pResult = NULL;
+            pthread_join(threads[i], &pResult);
+            numPassed += pResult == pRoot;
+        }
+
+        lio_stats_snapshot(pSnapshot);
+        pOp = pSnapshot->ops + LIO_STATS_OP_PATH_EXISTS;
+        if (numPassed != STATS_TEST_NUM_THREADS
+        || pOp->counters[LIO_STATS_CALLS] != STATS_TEST_NUM_THREADS * STATS_TEST_NUM_WRITES
+        || stats_test_histogram_sum(pOp) != pOp->counters[LIO_STATS_CALLS])
+        {
+            fprintf(stderr, "Threads recorded %llu lookups.\n", (unsigned long long)pOp->counters[LIO_STATS_CALLS]);
+            ret = testId;
+            goto end;
+        }
+        printf("Successfully merged the statistics of %u threads.\n", numStarted);
+    }
+
+    // Test that disabling statistics stops collection
+    ++testId;
+    lio_stats_reset();
+    lio_stats_enable(false);
+    lio_path_does_exist(pRoot, LIO_PATH_TYPE_FOLDER);
+    lio_stats_snapshot(pSnapshot);
+    if (lio_stats_is_enabled() || pSnapshot->ops[LIO_STATS_OP_PATH_EXISTS].counters[LIO_STATS_CALLS] != 0)
+    {
+        fprintf(stderr, "Statistics were collected while disabled.\n");
+        ret = testId;
+        goto end;
+    }
+    printf("Successfully disabled statistics.\n");
+
+    // Test the histogram layout and names
+    ++testId;
+    if (lio_stats_bucket_lower_bound(0) != 0
+    || lio_stats_bucket_lower_bound(4) != 4
+    || lio_stats_bucket_lower_bound(8) != 8
+    || lio_stats_bucket_lower_bound(9) != 10
+    || lio_stats_bucket_lower_bound(LIO_STATS_NUM_BUCKETS-4) != (1ull << LIO_STATS_MAX_EXPONENT)
+    || strcmp(lio_stats_op_name(LIO_STATS_OP_PATH_MOVE), "path_move") != 0
+    || strcmp(lio_stats_counter_name(LIO_STATS_ERRORS), "errors") != 0)
+    {
+        fprintf(stderr, "The histogram layout or names were incorrect.\n");
+        ret = testId;
+        goto end;
+    }
+    printf("Successfully checked the histogram layout.\n");
+
+    end:
+    lio_stats_enable(false);
+    if (ppEntries)
+    {
+        lio_paths_destroy(ppEntries, numEntries);
+    }
+    if (pRoot)
+    {
+        lio_path_remove(pRoot, true, false);
+    }
+    free(pSnapshot);
+    lio_utils_str_destroy(pFile);
+    lio_utils_str_destroy(pRoot);
+    lio_path_destroy(pCwd);
+    lio_path_destroy(pExeDir);
+
+    return ret;
+}
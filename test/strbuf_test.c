@@ -0,0 +1,136 @@
+
+#include <stdint.h> // uintptr_t
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "light_io/lio_utils.h"
+#include "light_io/lio_strbuf.h"
+#include "light_io/lio_arena.h"
+#include "light_io/lio_paths.h"
+
+
+
+int main(int argc, char* argv[])
+{
+    int ret = 0;
+    int testId = 0;
+    unsigned i = 0u;
+    unsigned numPaths = 0u;
+    unsigned numArenaPaths = 0u;
+    char* pStr = NULL;
+    char* pCwd = lio_path_dirname(argv[0]);
+    char** pPaths = NULL;
+    char** pArenaPaths = NULL;
+    LioStrBuf buf;
+    LioArena arena;
+
+    (void)argc;
+    lio_strbuf_init(&buf);
+    lio_arena_init(&arena, 256);
+
+    // Test that formatted appends can grow a buffer
+    ++testId;
+    for (i = 0u; i < 100u; ++i)
+    {
+        if (!lio_strbuf_appendf(&buf, "%u,", i))
+        {
+            fprintf(stderr, "Unable to append a formatted string.\n");
+            ret = testId;
+            goto end;
+        }
+    }
+
+    if (buf.length != strlen(lio_strbuf_cstr(&buf)) || strncmp(lio_strbuf_cstr(&buf), "0,1,2,", 6) != 0 || strcmp(lio_strbuf_cstr(&buf) + buf.length - 3, "99,") != 0)
+    {
+        fprintf(stderr, "Formatted string buffer contents are incorrect: %s\n", lio_strbuf_cstr(&buf));
+        ret = testId;
+        goto end;
+    }
+    printf("Successfully built a %zu-character string.\n", buf.length);
+
+    // Test that a buffer can be reused for strings with a common prefix
+    ++testId;
+    lio_strbuf_truncate(&buf, 0);
+    if (!lio_strbuf_append(&buf, "prefix") || !lio_strbuf_append_char(&buf, LIO_PATH_SEP))
+    {
+        fprintf(stderr, "Unable to append to a string buffer.\n");
+        ret = testId;
+        goto end;
+    }
+
+    {
+        const size_t prefixLength = buf.length;
+        lio_strbuf_append(&buf, "first");
+        lio_strbuf_truncate(&buf, prefixLength);
+        lio_strbuf_append_n(&buf, "second-and-ignored", 6);
+    }
+
+    pStr = lio_strbuf_detach(&buf);
+    if (!pStr || strcmp(pStr + 7, "second") != 0 || buf.pData != NULL)
+    {
+        fprintf(stderr, "Unable to reuse a string buffer.\n");
+        ret = testId;
+        goto end;
+    }
+    printf("Successfully reused a string buffer: %s\n", pStr);
+
+    // Test that arena allocations are aligned and survive block changes
+    ++testId;
+    {
+        char* const pFirst = lio_arena_str_copy(&arena, "arena", 0);
+        char* const pLarge = (char*)lio_arena_alloc(&arena, 4096);
+
+        for (i = 0u; i < 64u; ++i)
+        {
+            void* const pMem = lio_arena_alloc(&arena, 1 + i);
+            if (!pMem || ((uintptr_t)pMem % LIO_ARENA_ALIGNMENT) != 0)
+            {
+                fprintf(stderr, "Arena allocation %u is misaligned.\n", i);
+                ret = testId;
+                goto end;
+            }
+            memset(pMem, 0xFF, 1 + i);
+        }
+
+        if (!pFirst || !pLarge || strcmp(pFirst, "arena") != 0)
+        {
+            fprintf(stderr, "Arena allocations were overwritten.\n");
+            ret = testId;
+            goto end;
+        }
+    }
+    lio_arena_reset(&arena);
+    printf("Successfully allocated from an arena.\n");
+
+    // Test that directory listings can be allocated from an arena
+    ++testId;
+    pPaths = lio_path_list(pCwd, false, NULL, &numPaths);
+    pArenaPaths = lio_path_list_arena(pCwd, false, NULL, &arena, &numArenaPaths);
+    if (!pPaths || !pArenaPaths || numPaths != numArenaPaths || numPaths != lio_path_count_entries(pCwd, false, NULL))
+    {
+        fprintf(stderr, "Arena directory listing does not match \"%s.\"\n", pCwd);
+        ret = testId;
+        goto end;
+    }
+
+    for (i = 0u; i < numPaths; ++i)
+    {
+        if (strcmp(pPaths[i], pArenaPaths[i]) != 0)
+        {
+            fprintf(stderr, "Arena directory listing differs at \"%s.\"\n", pPaths[i]);
+            ret = testId;
+            goto end;
+        }
+    }
+    printf("Successfully listed %u paths into an arena.\n", numArenaPaths);
+
+    end:
+    lio_paths_destroy(pPaths, numPaths);
+    lio_utils_str_destroy(pStr);
+    lio_arena_terminate(&arena);
+    lio_strbuf_terminate(&buf);
+    lio_path_destroy(pCwd);
+
+    return ret;
+}
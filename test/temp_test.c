@@ -0,0 +1,235 @@
+
+#define _XOPEN_SOURCE 700 // setenv()
+
+#include <sys/wait.h> // waitpid()
+#include <unistd.h> // fork()
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "light_io/lio_files.h"
+#include "light_io/lio_paths.h"
+#include "light_io/lio_utils.h"
+#include "light_io/lio_temp.h"
+
+
+
+/*-----------------------------------------------------------------------------
+ * Compare the contents of a file with a string
+-----------------------------------------------------------------------------*/
+static bool temp_test_file_equals(const char* const pPath, const char* const pExpected)
+{
+    LioFile file;
+    size_t numBytes = 0;
+    char* pData = NULL;
+
+    if (lio_file_open(&file, pPath, LIO_FILE_OPEN_READ))
+    {
+        pData = lio_file_read_all(&file, &numBytes);
+        lio_file_close(&file);
+    }
+
+    const bool ret = pData && numBytes == strlen(pExpected) && memcmp(pData, pExpected, numBytes) == 0;
+    lio_utils_str_destroy(pData);
+
+    return ret;
+}
+
+
+
+int main(int argc, char* argv[])
+{
+    int ret = 0;
+    int testId = 0;
+    char* pExeDir = lio_path_dirname(argv[0]);
+    char* pCwd = lio_path_resolve(pExeDir);
+    char* pBase = NULL;
+    char* pKept = NULL;
+    char* pStale = NULL;
+    char* pUnlocked = NULL;
+    char* pDirA = NULL;
+    char* pDirB = NULL;
+    const char* pRoot = NULL;
+    LioFile file = lio_file_wrap(-1);
+
+    (void)argc;
+
+    // Scratch roots are kept beside the test so recovery only sees its own
+    ++testId;
+    pBase = lio_utils_str_fmt("%s%ctemp_test_base", pCwd, LIO_PATH_SEP);
+    pKept = lio_utils_str_fmt("%s%ctemp_test.kept", pCwd, LIO_PATH_SEP);
+    pStale = lio_utils_str_fmt("%s%clio-stale", pBase, LIO_PATH_SEP);
+    pUnlocked = lio_utils_str_fmt("%s%clio-unlocked", pBase, LIO_PATH_SEP);
+    if (!pBase || !pKept || !pStale || !pUnlocked)
+    {
+        fprintf(stderr, "Unable to create test paths.\n");
+        ret = testId;
+        goto end;
+    }
+
+    lio_path_remove(pBase, true, false);
+    lio_path_remove(pKept, false, false);
+    setenv("TMPDIR", pBase, 1);
+
+    pRoot = lio_path_mkdirs(pBase) ? lio_temp_root() : NULL;
+    if (!pRoot
+    || strncmp(pRoot, pBase, strlen(pBase)) != 0
+    || !lio_path_does_exist(pRoot, LIO_PATH_TYPE_FOLDER)
+    || lio_temp_root() != pRoot)
+    {
+        fprintf(stderr, "Unable to create a scratch root.\n");
+        ret = testId;
+        goto end;
+    }
+    printf("Created a scratch root:\n\t%s\n", pRoot);
+
+    // Test that scratch files leave nothing behind unless they are kept
+    ++testId;
+    {
+        unsigned numEntries = 0;
+        bool valid = lio_temp_file(&file, NULL)
+            && lio_file_write(&file, "scratch", 7)
+            && lio_temp_keep(&file, pKept)
+            && !lio_temp_keep(&file, pKept)
+            && lio_file_write(&file, " data", 5);
+
+        // Keeping a file does not close it, later writes reach the same data
+        // unless it had to be copied.
+        valid = lio_file_close(&file) && valid
+            && (temp_test_file_equals(pKept, "scratch data") || temp_test_file_equals(pKept, "scratch"));
+
+        char** const ppEntries = lio_path_list(pRoot, true, NULL, &numEntries);
+        lio_paths_destroy(ppEntries, numEntries);
+
+        // Only the lock remains in the root
+        if (!valid || numEntries != 1)
+        {
+            fprintf(stderr, "Unable to create and keep a scratch file.\n");
+            ret = testId;
+            goto end;
+        }
+        printf("Successfully kept a scratch file:\n\t%s\n", pKept);
+    }
+
+    // Test that scratch files can be created beside their final location
+    ++testId;
+    lio_path_remove(pKept, false, false);
+    if (!lio_temp_file(&file, pCwd)
+    || !lio_file_write(&file, "copied", 6)
+    || !lio_temp_keep(&file, pKept)
+    || !lio_file_close(&file)
+    || !temp_test_file_equals(pKept, "copied"))
+    {
+        fprintf(stderr, "Unable to keep a scratch file beside its final location.\n");
+        ret = testId;
+        goto end;
+    }
+    printf("Successfully kept a scratch file beside its final location.\n");
+
+    // Test that scratch folders are unique and live in the root
+    ++testId;
+    pDirA = lio_temp_dir();
+    pDirB = lio_temp_dir();
+    if (!pDirA || !pDirB
+    || strcmp(pDirA, pDirB) == 0
+    || strncmp(pDirA, pRoot, strlen(pRoot)) != 0
+    || !lio_path_does_exist(pDirB, LIO_PATH_TYPE_FOLDER))
+    {
+        fprintf(stderr, "Unable to create scratch folders.\n");
+        ret = testId;
+        goto end;
+    }
+    printf("Successfully created scratch folders:\n\t%s\n\t%s\n", pDirA, pDirB);
+
+    // Test that a forked child shares the root without removing it on exit
+    ++testId;
+    {
+        int status = -1;
+        pid_t child;
+
+        fflush(stdout);
+        child = fork();
+        if (child == 0)
+        {
+            exit(lio_temp_root() == pRoot ? 0 : 1);
+        }
+
+        if (child < 0
+        || waitpid(child, &status, 0) != child
+        || !WIFEXITED(status)
+        || WEXITSTATUS(status) != 0
+        || !lio_path_does_exist(pDirA, LIO_PATH_TYPE_FOLDER))
+        {
+            fprintf(stderr, "A forked child removed its parent's scratch root.\n");
+            ret = testId;
+            goto end;
+        }
+        printf("Successfully kept a scratch root after a forked child exited.\n");
+    }
+
+    // Test that only the roots of processes which are gone are recovered
+    ++testId;
+    {
+        char* const pStaleLock = lio_utils_str_fmt("%s%c.lock", pStale, LIO_PATH_SEP);
+        char* const pStaleFolder = lio_utils_str_fmt("%s%cd0", pStale, LIO_PATH_SEP);
+        bool valid = pStaleLock && pStaleFolder
+            && lio_path_mkdirs(pStaleFolder)
+            && lio_path_mkdirs(pUnlocked)
+            && lio_file_open(&file, pStaleLock, LIO_FILE_OPEN_WRITE | LIO_FILE_OPEN_CREATE)
+            && lio_file_close(&file);
+
+        valid = valid
+            && lio_temp_recover(pBase) == 1
+            && !lio_path_does_exist(pStale, LIO_PATH_TYPE_ANY)
+            && lio_path_does_exist(pUnlocked, LIO_PATH_TYPE_FOLDER)
+            && lio_path_does_exist(pDirA, LIO_PATH_TYPE_FOLDER);
+
+        lio_utils_str_destroy(pStaleFolder);
+        lio_utils_str_destroy(pStaleLock);
+
+        if (!valid)
+        {
+            fprintf(stderr, "Unable to recover stale scratch roots.\n");
+            ret = testId;
+            goto end;
+        }
+        printf("Successfully recovered a stale scratch root.\n");
+    }
+
+    // Test that the root is removed and recreated on demand
+    ++testId;
+    if (!lio_temp_cleanup()
+    || lio_path_does_exist(pDirA, LIO_PATH_TYPE_ANY)
+    || !lio_temp_cleanup()
+    || (pRoot = lio_temp_root()) == NULL
+    || !lio_path_does_exist(pRoot, LIO_PATH_TYPE_FOLDER))
+    {
+        fprintf(stderr, "Unable to clean up a scratch root.\n");
+        ret = testId;
+        goto end;
+    }
+    printf("Successfully cleaned up a scratch root.\n");
+
+    end:
+    lio_file_close(&file);
+    lio_temp_cleanup();
+    if (pBase)
+    {
+        lio_path_remove(pBase, true, false);
+    }
+    if (pKept)
+    {
+        lio_path_remove(pKept, false, false);
+    }
+    lio_path_destroy(pDirB);
+    lio_path_destroy(pDirA);
+    lio_utils_str_destroy(pUnlocked);
+    lio_utils_str_destroy(pStale);
+    lio_utils_str_destroy(pKept);
+    lio_utils_str_destroy(pBase);
+    lio_path_destroy(pCwd);
+    lio_path_destroy(pExeDir);
+
+    return ret;
+}
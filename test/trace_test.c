@@ -0,0 +1,212 @@
+
+#define _XOPEN_SOURCE 700 // pthread_barrier_t
+
+#include <pthread.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "light_io/lio_files.h"
+#include "light_io/lio_paths.h"
+#include "light_io/lio_utils.h"
+#include "light_io/lio_trace.h"
+
+
+
+enum
+{
+    TRACE_TEST_NUM_THREADS = 3,
+    TRACE_TEST_NUM_LOOKUPS = 50,
+    TRACE_TEST_RING_SIZE = 16
+};
+
+
+
+/*-----------------------------------------------------------------------------
+ * Count the occurrences of a string within a file
+-----------------------------------------------------------------------------*/
+static unsigned trace_test_count(const char* const pPath, const char* const pNeedle)
+{
+    LioFile file;
+    size_t numBytes = 0;
+    unsigned count = 0;
+
+    if (!lio_file_open(&file, pPath, LIO_FILE_OPEN_READ))
+    {
+        return 0;
+    }
+
+    char* const pData = lio_file_read_all(&file, &numBytes);
+    lio_file_close(&file);
+
+    for (const char* pIter = pData; pIter && (pIter = strstr(pIter, pNeedle)) != NULL; ++pIter)
+    {
+        ++count;
+    }
+
+    lio_utils_str_destroy(pData);
+
+    return count;
+}
+
+
+
+static pthread_barrier_t traceTestBarrier;
+
+
+
+static void* trace_test_thread(void* pData)
+{
+    const char* const pPath = (const char*)pData;
+
+    for (unsigned i = 0; i < TRACE_TEST_NUM_LOOKUPS; ++i)
+    {
+        lio_path_does_exist(pPath, LIO_PATH_TYPE_FOLDER);
+    }
+
+    // Exited threads hand their rings to new ones, so every thread stays
+    // alive until all of them have recorded.
+    pthread_barrier_wait(&traceTestBarrier);
+
+    return NULL;
+}
+
+
+
+int main(int argc, char* argv[])
+{
+    int ret = 0;
+    int testId = 0;
+    char* pExeDir = lio_path_dirname(argv[0]);
+    char* pCwd = lio_path_resolve(pExeDir);
+    char* pRoot = NULL;
+    char* pSrc = NULL;
+    char* pDst = NULL;
+    char* pTrace = NULL;
+    const char data[1000] = {0};
+    long long numSpans = 0;
+    LioFile file;
+
+    (void)argc;
+
+    ++testId;
+    pRoot = lio_utils_str_fmt("%s%ctrace_test_root%cnested", pCwd, LIO_PATH_SEP, LIO_PATH_SEP);
+    pSrc = lio_utils_str_fmt("%s%c\"quoted\"", pRoot, LIO_PATH_SEP);
+    pDst = lio_utils_str_fmt("%s%ccopy", pRoot, LIO_PATH_SEP);
+    pTrace = lio_utils_str_fmt("%s%ctrace_test.json", pCwd, LIO_PATH_SEP);
+    if (!pRoot || !pSrc || !pDst || !pTrace)
+    {
+        fprintf(stderr, "Unable to create test paths.\n");
+        ret = testId;
+        goto end;
+    }
+
+    if (!lio_trace_start(0))
+    {
+        printf("Tracing was compiled out, skipping.\n");
+        goto end;
+    }
+
+    // Test that spans carry their path and byte count
+    ++testId;
+    lio_trace_clear();
+    if (!lio_path_mkdirs(pRoot)
+    || !lio_file_open(&file, pSrc, LIO_FILE_OPEN_WRITE | LIO_FILE_OPEN_CREATE | LIO_FILE_OPEN_TRUNCATE)
+    || !lio_file_write(&file, data, sizeof(data))
+    || !lio_file_close(&file)
+    || !lio_file_copy(pSrc, pDst, true))
+    {
+        fprintf(stderr, "Unable to create test files.\n");
+        ret = testId;
+        goto end;
+    }
+
+    lio_trace_stop();
+    numSpans = lio_trace_write(pTrace);
+    if (numSpans <= 0
+    || trace_test_count(pTrace, "\"traceEvents\"") != 1
+    || trace_test_count(pTrace, "\"ph\":\"X\"") != (unsigned)numSpans
+    || trace_test_count(pTrace, "{\"name\":\"path_mkdirs\"") != 1
+    || trace_test_count(pTrace, "{\"name\":\"file_copy\"") != 1
+    || trace_test_count(pTrace, "\\\"quoted\\\"\",\"bytes_read\":1000,\"bytes_written\":1000}") != 1
+    || trace_test_count(pTrace, "\"bytes_read\":0,\"bytes_written\":1000}") != 1)
+    {
+        fprintf(stderr, "A trace of %lld spans was missing information.\n", numSpans);
+        ret = testId;
+        goto end;
+    }
+    printf("Successfully traced %lld spans.\n", numSpans);
+
+    // Test that nothing is recorded once tracing stops
+    ++testId;
+    lio_path_does_exist(pRoot, LIO_PATH_TYPE_FOLDER);
+    if (lio_trace_write(pTrace) != numSpans)
+    {
+        fprintf(stderr, "Spans were recorded after tracing stopped.\n");
+        ret = testId;
+        goto end;
+    }
+    printf("Successfully stopped tracing.\n");
+
+    // Test that each thread keeps only its latest spans
+    ++testId;
+    {
+        pthread_t threads[TRACE_TEST_NUM_THREADS];
+        unsigned numStarted = 0;
+
+        lio_trace_clear();
+        lio_trace_start(TRACE_TEST_RING_SIZE);
+        pthread_barrier_init(&traceTestBarrier, NULL, TRACE_TEST_NUM_THREADS);
+
+        for (; numStarted < TRACE_TEST_NUM_THREADS; ++numStarted)
+        {
+            if (pthread_create(threads+numStarted, NULL, &trace_test_thread, pRoot) != 0)
+            {
+                break;
+            }
+        }
+
+        for (unsigned i = 0; i < numStarted; ++i)
+        {
+            pthread_join(threads[i], NULL);
+        }
+
+        pthread_barrier_destroy(&traceTestBarrier);
+
+        lio_trace_stop();
+        numSpans = lio_trace_write(pTrace);
+
+        // The main thread's ring predates the smaller size
+        if (numStarted != TRACE_TEST_NUM_THREADS
+        || numSpans != TRACE_TEST_NUM_THREADS * TRACE_TEST_RING_SIZE
+        || trace_test_count(pTrace, "{\"name\":\"path_exists\"") != (unsigned)numSpans)
+        {
+            fprintf(stderr, "Threads kept %lld spans.\n", numSpans);
+            ret = testId;
+            goto end;
+        }
+        printf("Successfully kept the latest spans of %u threads.\n", numStarted);
+    }
+
+    end:
+    lio_trace_stop();
+    if (pCwd)
+    {
+        char* const pTop = lio_utils_str_fmt("%s%ctrace_test_root", pCwd, LIO_PATH_SEP);
+        lio_path_remove(pTop, true, false);
+        lio_utils_str_destroy(pTop);
+    }
+    if (pTrace)
+    {
+        lio_path_remove(pTrace, false, false);
+    }
+    lio_utils_str_destroy(pTrace);
+    lio_utils_str_destroy(pDst);
+    lio_utils_str_destroy(pSrc);
+    lio_utils_str_destroy(pRoot);
+    lio_path_destroy(pCwd);
+    lio_path_destroy(pExeDir);
+
+    return ret;
+}
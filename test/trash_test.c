@@ -0,0 +1,219 @@
+
+#define _XOPEN_SOURCE 700 // symlink()
+
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "light_io/lio_files.h"
+#include "light_io/lio_paths.h"
+#include "light_io/lio_utils.h"
+#include "light_io/lio_trash.h"
+
+
+
+/*-----------------------------------------------------------------------------
+ * Count finished removals
+-----------------------------------------------------------------------------*/
+static atomic_uint trashTestNumRemoved = 0;
+static atomic_uint trashTestNumFailed = 0;
+
+static void trash_test_callback(const char* const pPath, const bool removed, void* const pUserData)
+{
+    (void)pPath;
+    (void)pUserData;
+    atomic_fetch_add(removed ? &trashTestNumRemoved : &trashTestNumFailed, 1);
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Create a folder tree with a few files at each level
+-----------------------------------------------------------------------------*/
+static bool trash_test_make_tree(const char* const pRoot, const unsigned depth)
+{
+    if (!lio_path_mkdirs(pRoot))
+    {
+        return false;
+    }
+
+    bool ret = true;
+
+    for (unsigned i = 0; ret && i < 3; ++i)
+    {
+        char* const pFile = lio_utils_str_fmt("%s%cf%u", pRoot, LIO_PATH_SEP, i);
+        LioFile file;
+
+        ret = pFile
+            && lio_file_open(&file, pFile, LIO_FILE_OPEN_WRITE | LIO_FILE_OPEN_CREATE)
+            && lio_file_write(&file, "trash", 5)
+            && lio_file_close(&file);
+
+        lio_utils_str_destroy(pFile);
+
+        if (ret && depth)
+        {
+            char* const pChild = lio_utils_str_fmt("%s%cd%u", pRoot, LIO_PATH_SEP, i);
+            ret = pChild && trash_test_make_tree(pChild, depth - 1);
+            lio_utils_str_destroy(pChild);
+        }
+    }
+
+    return ret;
+}
+
+
+
+int main(int argc, char* argv[])
+{
+    int ret = 0;
+    int testId = 0;
+    char* pExeDir = lio_path_dirname(argv[0]);
+    char* pCwd = lio_path_resolve(pExeDir);
+    char* pBase = NULL;
+    char* pTree = NULL;
+    char* pKept = NULL;
+    char* pStale = NULL;
+    LioTrashJob* pJob = NULL;
+
+    (void)argc;
+
+    ++testId;
+    pBase = lio_utils_str_fmt("%s%ctrash_test_base", pCwd, LIO_PATH_SEP);
+    pTree = lio_utils_str_fmt("%s%ctree", pBase, LIO_PATH_SEP);
+    pKept = lio_utils_str_fmt("%s%ckept", pBase, LIO_PATH_SEP);
+    pStale = lio_utils_str_fmt("%s%c.lio-trash%cstale", pBase, LIO_PATH_SEP, LIO_PATH_SEP);
+    if (!pBase || !pTree || !pKept || !pStale)
+    {
+        fprintf(stderr, "Unable to create test paths.\n");
+        ret = testId;
+        goto end;
+    }
+
+    lio_path_remove(pBase, true, false);
+    if (!trash_test_make_tree(pTree, 3) || !trash_test_make_tree(pKept, 0))
+    {
+        fprintf(stderr, "Unable to create a folder tree.\n");
+        ret = testId;
+        goto end;
+    }
+
+    // Test that a tree is gone as soon as it is moved to the trash
+    ++testId;
+    {
+        char* const pLink = lio_utils_str_fmt("%s%cd0%clink", pTree, LIO_PATH_SEP, LIO_PATH_SEP);
+        const bool valid = pLink
+            && symlink(pKept, pLink) == 0
+            && lio_trash_remove(pTree, &trash_test_callback, NULL, &pJob)
+            && !lio_path_does_exist(pTree, LIO_PATH_TYPE_ANY)
+            && lio_trash_wait(pJob);
+
+        pJob = NULL;
+        lio_utils_str_destroy(pLink);
+
+        // Links are removed without touching their targets
+        if (!valid
+        || atomic_load(&trashTestNumRemoved) != 1
+        || atomic_load(&trashTestNumFailed) != 0
+        || !lio_path_does_exist(pKept, LIO_PATH_TYPE_FOLDER))
+        {
+            fprintf(stderr, "Unable to remove a folder tree through the trash.\n");
+            ret = testId;
+            goto end;
+        }
+        printf("Successfully removed a folder tree through the trash.\n");
+    }
+
+    // Test that removals can be left to finish on their own
+    ++testId;
+    {
+        char* const pKeptFile = lio_utils_str_fmt("%s%cf1", pKept, LIO_PATH_SEP);
+        const bool valid = pKeptFile
+            && lio_trash_remove(pKeptFile, &trash_test_callback, NULL, NULL)
+            && !lio_path_does_exist(pKeptFile, LIO_PATH_TYPE_ANY)
+            && !lio_trash_remove(pKeptFile, NULL, NULL, NULL);
+
+        lio_trash_wait_all();
+        lio_utils_str_destroy(pKeptFile);
+
+        if (!valid || atomic_load(&trashTestNumRemoved) != 2)
+        {
+            fprintf(stderr, "Unable to remove a file through the trash.\n");
+            ret = testId;
+            goto end;
+        }
+        printf("Successfully removed a file through the trash.\n");
+    }
+
+    // Test that entries left in a trash folder are deleted on recovery
+    ++testId;
+    {
+        const int numQueued = trash_test_make_tree(pStale, 2) ? lio_trash_recover(pBase, &trash_test_callback, NULL) : -1;
+        lio_trash_wait_all();
+
+        if (numQueued < 1
+        || lio_path_does_exist(pStale, LIO_PATH_TYPE_ANY)
+        || atomic_load(&trashTestNumRemoved) != 2 + (unsigned)numQueued
+        || atomic_load(&trashTestNumFailed) != 0)
+        {
+            fprintf(stderr, "Unable to recover a trash folder.\n");
+            ret = testId;
+            goto end;
+        }
+        printf("Successfully recovered %d trash entries.\n", numQueued);
+    }
+
+    // Test that a remembered trash folder which was deleted is replaced. The
+    // trash of a tmpfs is kept at its mount point, which the test can delete.
+    ++testId;
+    if (lio_path_does_exist("/dev/shm", LIO_PATH_TYPE_FOLDER) && access("/dev/shm", W_OK | X_OK) == 0)
+    {
+        char* const pShmTree = lio_utils_str_fmt("/dev/shm/lio_trash_test.%ld", (long)getpid());
+        bool valid = pShmTree
+            && trash_test_make_tree(pShmTree, 0)
+            && lio_trash_remove(pShmTree, NULL, NULL, NULL);
+
+        lio_trash_wait_all();
+        lio_path_remove("/dev/shm/.lio-trash", true, false);
+
+        valid = valid
+            && trash_test_make_tree(pShmTree, 0)
+            && lio_trash_remove(pShmTree, NULL, NULL, NULL)
+            && !lio_path_does_exist(pShmTree, LIO_PATH_TYPE_ANY);
+
+        lio_trash_wait_all();
+        if (pShmTree)
+        {
+            lio_path_remove(pShmTree, true, false);
+        }
+        lio_utils_str_destroy(pShmTree);
+
+        if (!valid)
+        {
+            fprintf(stderr, "Unable to replace a trash folder which was deleted.\n");
+            ret = testId;
+            goto end;
+        }
+        printf("Successfully replaced a trash folder which was deleted.\n");
+    }
+
+    end:
+    if (pJob)
+    {
+        lio_trash_wait(pJob);
+    }
+    lio_trash_wait_all();
+    if (pBase)
+    {
+        lio_path_remove(pBase, true, false);
+    }
+    lio_utils_str_destroy(pStale);
+    lio_utils_str_destroy(pKept);
+    lio_utils_str_destroy(pTree);
+    lio_utils_str_destroy(pBase);
+    lio_path_destroy(pCwd);
+    lio_path_destroy(pExeDir);
+
+    return ret;
+}
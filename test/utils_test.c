@@ -0,0 +1,160 @@
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "light_io/lio_utils.h"
+
+
+
+// Odd element counts exercise both the SIMD and scalar code paths
+#define UTILS_TEST_COUNT 1027u
+
+
+
+int main(void)
+{
+    int ret = 0;
+    int testId = 0;
+    unsigned i = 0u;
+    uint16_t* p16 = (uint16_t*)malloc(UTILS_TEST_COUNT * sizeof(uint16_t));
+    uint32_t* p32 = (uint32_t*)malloc(UTILS_TEST_COUNT * sizeof(uint32_t));
+    uint64_t* p64 = (uint64_t*)malloc(UTILS_TEST_COUNT * sizeof(uint64_t));
+    double* pD = (double*)malloc(UTILS_TEST_COUNT * sizeof(double));
+    double* pSwappedD = (double*)malloc(UTILS_TEST_COUNT * sizeof(double));
+
+    // Test that doubles are byte-swapped as 8-byte values
+    ++testId;
+    {
+        const double d = 1234.5678;
+        const double swapped = lio_utils_btol_d(d);
+        const unsigned char* const pIn = (const unsigned char*)&d;
+        const unsigned char* const pOut = (const unsigned char*)&swapped;
+
+        for (i = 0u; i < sizeof(double); ++i)
+        {
+            if (pIn[i] != pOut[sizeof(double)-i-1u])
+            {
+                fprintf(stderr, "Double-precision byte swap is incorrect.\n");
+                ret = testId;
+                goto end;
+            }
+        }
+
+        if (lio_utils_btol_d(swapped) != d)
+        {
+            fprintf(stderr, "Double-precision byte swap does not round-trip.\n");
+            ret = testId;
+            goto end;
+        }
+
+        printf("Successfully byte-swapped a double.\n");
+    }
+
+    // Test that arrays can be byte-swapped in-place
+    ++testId;
+    if (!p16 || !p32 || !p64 || !pD || !pSwappedD)
+    {
+        fprintf(stderr, "Unable to allocate test arrays.\n");
+        ret = testId;
+        goto end;
+    }
+
+    for (i = 0u; i < UTILS_TEST_COUNT; ++i)
+    {
+        p16[i] = (uint16_t)(i * 0x0101u + 0x1234u);
+        p32[i] = i * 0x01010101u + 0x12345678u;
+        p64[i] = (uint64_t)i * 0x0101010101010101ull + 0x123456789ABCDEF0ull;
+        pD[i] = (double)i * 0.125 - 64.0;
+    }
+
+    lio_utils_btol_u16_array(p16, p16, UTILS_TEST_COUNT);
+    lio_utils_btol_u32_array(p32, p32, UTILS_TEST_COUNT);
+    lio_utils_btol_u64_array(p64, p64, UTILS_TEST_COUNT);
+
+    for (i = 0u; i < UTILS_TEST_COUNT; ++i)
+    {
+        if (p16[i] != lio_utils_btol_u16((uint16_t)(i * 0x0101u + 0x1234u))
+        || p32[i] != lio_utils_btol_u32(i * 0x01010101u + 0x12345678u)
+        || p64[i] != lio_utils_btol_u64((uint64_t)i * 0x0101010101010101ull + 0x123456789ABCDEF0ull))
+        {
+            fprintf(stderr, "In-place array byte swap is incorrect at index %u.\n", i);
+            ret = testId;
+            goto end;
+        }
+    }
+    printf("Successfully byte-swapped integer arrays in-place.\n");
+
+    // Test that floating-point arrays can be swapped into a separate buffer
+    ++testId;
+    lio_utils_btol_d_array(pSwappedD, pD, UTILS_TEST_COUNT);
+    for (i = 0u; i < UTILS_TEST_COUNT; ++i)
+    {
+        const double swapped = lio_utils_btol_d(pD[i]);
+        if (memcmp(&swapped, pSwappedD+i, sizeof(double)) != 0)
+        {
+            fprintf(stderr, "Double-precision array byte swap is incorrect at index %u.\n", i);
+            ret = testId;
+            goto end;
+        }
+    }
+
+    lio_utils_btol_d_array(pSwappedD, pSwappedD, UTILS_TEST_COUNT);
+    if (memcmp(pD, pSwappedD, UTILS_TEST_COUNT * sizeof(double)) != 0)
+    {
+        fprintf(stderr, "Double-precision array byte swap does not round-trip.\n");
+        ret = testId;
+        goto end;
+    }
+    printf("Successfully byte-swapped a double-precision array.\n");
+
+    // Test that elements of other sizes are reversed one at a time
+    ++testId;
+    {
+        unsigned char src[3*7 + 12*5];
+        unsigned char dst[sizeof(src)];
+
+        for (i = 0u; i < sizeof(src); ++i)
+        {
+            src[i] = (unsigned char)(i * 37u + 11u);
+        }
+
+        lio_utils_btol_array(dst, src, 7, 3);
+        lio_utils_btol_array(dst + 3*7, src + 3*7, 5, 12);
+
+        for (i = 0u; i < sizeof(src); ++i)
+        {
+            const unsigned size = (i < 3*7) ? 3u : 12u;
+            const unsigned base = (i < 3*7) ? 0u : 3*7;
+            const unsigned offset = (i - base) % size;
+
+            if (dst[i] != src[i - offset + (size - 1u - offset)])
+            {
+                fprintf(stderr, "Byte swap of %u-byte elements is incorrect at byte %u.\n", size, i);
+                ret = testId;
+                goto end;
+            }
+        }
+
+        // Swapping in-place twice restores the original
+        lio_utils_btol_array(dst, dst, 7, 3);
+        lio_utils_btol_array(dst + 3*7, dst + 3*7, 5, 12);
+        if (memcmp(dst, src, sizeof(src)) != 0)
+        {
+            fprintf(stderr, "In-place byte swap of odd-sized elements does not round-trip.\n");
+            ret = testId;
+            goto end;
+        }
+
+        printf("Successfully byte-swapped 3 and 12-byte elements.\n");
+    }
+
+    end:
+    free(pSwappedD);
+    free(pD);
+    free(p64);
+    free(p32);
+    free(p16);
+
+    return ret;
+}
@@ -0,0 +1,230 @@
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "light_io/lio_files.h"
+#include "light_io/lio_paths.h"
+#include "light_io/lio_utils.h"
+#include "light_io/lio_watch.h"
+
+
+
+enum
+{
+    WATCH_TEST_NUM_FILES = 20,
+    WATCH_TEST_TIMEOUT_MS = 2000
+};
+
+
+
+typedef struct WatchTestResult
+{
+    unsigned numBatches;
+    unsigned numAdded;
+    unsigned numRemoved;
+    unsigned numModified;
+} WatchTestResult;
+
+
+
+static void watch_test_callback(const LioWatchChange* pChanges, size_t numChanges, void* pUserData)
+{
+    WatchTestResult* const pResult = (WatchTestResult*)pUserData;
+
+    ++pResult->numBatches;
+
+    for (size_t i = 0; i < numChanges; ++i)
+    {
+        pResult->numAdded += (pChanges[i].flags & LIO_WATCH_ADDED) != 0;
+        pResult->numRemoved += (pChanges[i].flags & LIO_WATCH_REMOVED) != 0;
+        pResult->numModified += (pChanges[i].flags & LIO_WATCH_MODIFIED) != 0;
+    }
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * Poll until at least the expected number of changes arrive, as events for a
+ * single operation may be split across batches.
+-----------------------------------------------------------------------------*/
+static size_t watch_test_poll(LioWatch* pWatch, WatchTestResult* pResult, size_t numExpected)
+{
+    size_t total = 0;
+    unsigned numWaits = 0;
+
+    memset(pResult, 0, sizeof(WatchTestResult));
+
+    while (total < numExpected && numWaits++ < WATCH_TEST_TIMEOUT_MS / LIO_WATCH_POLL_MS)
+    {
+        total += lio_watch_poll(pWatch, LIO_WATCH_POLL_MS, &watch_test_callback, pResult);
+    }
+
+    // Anything extra would be a duplicate
+    total += lio_watch_poll(pWatch, 0, &watch_test_callback, pResult);
+
+    return total;
+}
+
+
+
+static bool watch_write_file(const char* pPath, size_t numBytes)
+{
+    static const char data[WATCH_TEST_NUM_FILES] = {0};
+    LioFile file;
+
+    if (!lio_file_open(&file, pPath, LIO_FILE_OPEN_WRITE | LIO_FILE_OPEN_CREATE | LIO_FILE_OPEN_TRUNCATE))
+    {
+        return false;
+    }
+
+    const bool ret = lio_file_write(&file, data, numBytes);
+    return lio_file_close(&file) && ret;
+}
+
+
+
+int main(int argc, char* argv[])
+{
+    int ret = 0;
+    int testId = 0;
+    unsigned i = 0u;
+    char* pExeDir = lio_path_dirname(argv[0]);
+    char* pCwd = lio_path_resolve(pExeDir);
+    char* pRoot = NULL;
+    char* pFolderA = NULL;
+    char* pFolderB = NULL;
+    char* pPath = NULL;
+    LioWatch watch;
+    LioDirListing listing;
+    WatchTestResult result;
+
+    (void)argc;
+    memset(&watch, 0, sizeof(watch));
+    watch.fd = -1;
+
+    // Create a small tree to watch
+    ++testId;
+    pRoot = lio_utils_str_fmt("%s%cwatch_tree", pCwd, LIO_PATH_SEP);
+    pFolderA = lio_utils_str_fmt("%s%ca", pRoot, LIO_PATH_SEP);
+    pFolderB = lio_utils_str_fmt("%s%ca%cb", pRoot, LIO_PATH_SEP, LIO_PATH_SEP);
+    if (!pRoot || !pFolderA || !pFolderB)
+    {
+        fprintf(stderr, "Unable to create test paths.\n");
+        ret = testId;
+        goto end;
+    }
+
+    lio_path_remove(pRoot, true, false);
+    if (!lio_path_mkdirs(pFolderA))
+    {
+        fprintf(stderr, "Unable to create the test tree \"%s.\"\n", pRoot);
+        ret = testId;
+        goto end;
+    }
+
+    if (!lio_watch_init(&watch, pRoot)
+    || !lio_watch_list(&watch, pRoot, &listing)
+    || listing.numEntries != 1
+    || strcmp(lio_dirlisting_name(&listing, 0), "a") != 0
+    || lio_watch_poll(&watch, 0, &watch_test_callback, &result) != 0)
+    {
+        fprintf(stderr, "Unable to watch the test tree \"%s.\"\n", pRoot);
+        ret = testId;
+        goto end;
+    }
+    printf("Successfully watching \"%s\" (descriptor %d).\n", pRoot, lio_watch_fd(&watch));
+
+    // Test that new files and folders are reported once and listed from memory
+    ++testId;
+    for (i = 0u; i < WATCH_TEST_NUM_FILES; ++i)
+    {
+        lio_utils_str_destroy(pPath);
+        pPath = lio_utils_str_fmt("%s%cf%u", pFolderA, LIO_PATH_SEP, i);
+        if (!pPath || !watch_write_file(pPath, i))
+        {
+            fprintf(stderr, "Unable to create the file \"%s.\"\n", pPath);
+            ret = testId;
+            goto end;
+        }
+    }
+
+    if (!lio_path_mkdirs(pFolderB)
+    || watch_test_poll(&watch, &result, WATCH_TEST_NUM_FILES + 1) != WATCH_TEST_NUM_FILES + 1
+    || result.numAdded != WATCH_TEST_NUM_FILES + 1
+    || result.numRemoved != 0
+    || !lio_watch_list(&watch, pFolderA, &listing)
+    || listing.numEntries != WATCH_TEST_NUM_FILES + 1
+    || !lio_watch_list(&watch, pFolderB, &listing)
+    || listing.numEntries != 0)
+    {
+        fprintf(stderr, "New files were not reported: %u added, %u removed.\n", result.numAdded, result.numRemoved);
+        ret = testId;
+        goto end;
+    }
+    printf("Successfully reported %u new entries in %u batches.\n", result.numAdded, result.numBatches);
+
+    // Test that files in a new folder are picked up
+    ++testId;
+    lio_utils_str_destroy(pPath);
+    pPath = lio_utils_str_fmt("%s%cnew", pFolderB, LIO_PATH_SEP);
+    if (!pPath
+    || !watch_write_file(pPath, 3)
+    || watch_test_poll(&watch, &result, 1) != 1
+    || result.numAdded != 1
+    || !lio_watch_list(&watch, pFolderB, &listing)
+    || listing.numEntries != 1
+    || listing.pEntries[0].size != 3)
+    {
+        fprintf(stderr, "A file in a new folder was not reported.\n");
+        ret = testId;
+        goto end;
+    }
+    printf("Successfully reported a file in a new folder.\n");
+
+    // Test that writes to a file are coalesced into one change
+    ++testId;
+    if (!watch_write_file(pPath, 5)
+    || !watch_write_file(pPath, 7)
+    || watch_test_poll(&watch, &result, 1) != 1
+    || result.numModified != 1
+    || !lio_watch_list(&watch, pFolderB, &listing)
+    || listing.pEntries[0].size != 7)
+    {
+        fprintf(stderr, "Writes to \"%s\" were not coalesced: %u modifications.\n", pPath, result.numModified);
+        ret = testId;
+        goto end;
+    }
+    printf("Successfully coalesced writes into %u change.\n", result.numModified);
+
+    // Test that removing a folder drops everything beneath it
+    ++testId;
+    if (!lio_path_remove(pFolderA, true, false)
+    || watch_test_poll(&watch, &result, 1) != 1
+    || result.numRemoved != 1
+    || !lio_watch_list(&watch, pRoot, &listing)
+    || listing.numEntries != 0
+    || lio_watch_list(&watch, pFolderA, &listing)
+    || lio_watch_list(&watch, pFolderB, &listing))
+    {
+        fprintf(stderr, "A removed folder was not dropped: %u removed.\n", result.numRemoved);
+        ret = testId;
+        goto end;
+    }
+    printf("Successfully dropped a removed folder.\n");
+
+    end:
+    lio_watch_terminate(&watch);
+    if (pRoot)
+    {
+        lio_path_remove(pRoot, true, false);
+    }
+    lio_utils_str_destroy(pPath);
+    lio_utils_str_destroy(pFolderB);
+    lio_utils_str_destroy(pFolderA);
+    lio_utils_str_destroy(pRoot);
+    lio_path_destroy(pCwd);
+    lio_path_destroy(pExeDir);
+
+    return ret;
+}